@@ -0,0 +1,118 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include <CppUnitTest.h>
+// code under test headers
+#include "AdaptiveSampling.h"
+// c++ headers
+#include <memory>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace FirewallEventMonitor;
+
+namespace FirewallEventMonitorUnitTest
+{
+    TEST_CLASS(AdaptiveSamplingTests)
+    {
+    public:
+
+        TEST_METHOD_INITIALIZE(MethodInit)
+        {
+            m_Adaptive = std::make_shared<AdaptiveSampling>(LagBudget, CpuBudget, 1, MaxSampleRate);
+        }
+
+        TEST_METHOD(DoublesRateWhenOverBudget)
+        {
+            Logger::WriteMessage(L"DoublesRateWhenOverBudget");
+
+            Assert::AreEqual(2ul, m_Adaptive->Update(Pressure(LagBudget * 1.5, 0.0, 0.0)));
+            Assert::AreEqual(1.5, m_Adaptive->GetLoad(), 0.001);
+            Assert::AreEqual(4ul, m_Adaptive->Update(Pressure(0.0, CpuBudget * 2, 0.0)));
+            Assert::AreEqual(8ul, m_Adaptive->Update(Pressure(0.0, 0.0, 0.9)));
+        }
+
+        TEST_METHOD(QuadruplesRateWhenEventsLost)
+        {
+            Logger::WriteMessage(L"QuadruplesRateWhenEventsLost");
+
+            PipelinePressure pressure;
+            pressure.eventsLost = true;
+            Assert::AreEqual(4ul, m_Adaptive->Update(pressure));
+            Assert::AreEqual(16ul, m_Adaptive->Update(pressure));
+        }
+
+        TEST_METHOD(HoldsRateWithinHysteresisBand)
+        {
+            Logger::WriteMessage(L"HoldsRateWithinHysteresisBand");
+
+            m_Adaptive->Update(Pressure(LagBudget * 2, 0.0, 0.0));
+            for (int i = 0; i < 20; ++i)
+            {
+                // Between RecoverBelowLoad and the budget: neither backs off nor recovers.
+                Assert::AreEqual(2ul, m_Adaptive->Update(Pressure(LagBudget * 0.8, CpuBudget * 0.6, 0.3)));
+            }
+        }
+
+        TEST_METHOD(RecoversOnlyAfterCalmIntervals)
+        {
+            Logger::WriteMessage(L"RecoversOnlyAfterCalmIntervals");
+
+            m_Adaptive->Update(Pressure(LagBudget * 2, 0.0, 0.0));
+            m_Adaptive->Update(Pressure(LagBudget * 2, 0.0, 0.0));
+            Assert::AreEqual(4ul, m_Adaptive->GetSampleRate());
+
+            const unsigned long calmIntervals = AdaptiveSampling::IntervalsBeforeRecovery;
+            for (unsigned long i = 1; i < calmIntervals; ++i)
+            {
+                Assert::AreEqual(4ul, m_Adaptive->Update(Pressure(0.0, 0.0, 0.0)));
+            }
+            Assert::AreEqual(2ul, m_Adaptive->Update(Pressure(0.0, 0.0, 0.0)));
+
+            // A busy interval restarts the count.
+            for (unsigned long i = 1; i < calmIntervals; ++i)
+            {
+                m_Adaptive->Update(Pressure(0.0, 0.0, 0.0));
+            }
+            m_Adaptive->Update(Pressure(LagBudget * 0.7, 0.0, 0.0));
+            Assert::AreEqual(2ul, m_Adaptive->Update(Pressure(0.0, 0.0, 0.0)));
+        }
+
+        TEST_METHOD(StaysWithinMinimumAndMaximumRates)
+        {
+            Logger::WriteMessage(L"StaysWithinMinimumAndMaximumRates");
+
+            AdaptiveSampling bounded(LagBudget, CpuBudget, 8, MaxSampleRate);
+            Assert::AreEqual(8ul, bounded.GetSampleRate());
+
+            PipelinePressure lost;
+            lost.eventsLost = true;
+            for (int i = 0; i < 10; ++i)
+            {
+                bounded.Update(lost);
+            }
+            Assert::AreEqual(MaxSampleRate, bounded.GetSampleRate());
+
+            for (int i = 0; i < 100; ++i)
+            {
+                bounded.Update(Pressure(0.0, 0.0, 0.0));
+            }
+            Assert::AreEqual(8ul, bounded.GetSampleRate());
+        }
+
+    private:
+        std::shared_ptr<AdaptiveSampling> m_Adaptive;
+
+        const double LagBudget = 1000.0;
+        const double CpuBudget = 10.0;
+        const unsigned long MaxSampleRate = 64;
+
+        static PipelinePressure Pressure(double lag, double cpu, double queueUsage)
+        {
+            PipelinePressure pressure;
+            pressure.lagInMilliseconds = lag;
+            pressure.cpuPercent = cpu;
+            pressure.queueUsage = queueUsage;
+            return pressure;
+        }
+    };
+}
@@ -0,0 +1,297 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include <CppUnitTest.h>
+// code under test headers
+#include "BatchFilter.h"
+// c++ headers
+#include <chrono>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace FirewallEventMonitor;
+
+namespace FirewallEventMonitorUnitTest
+{
+    namespace
+    {
+        // Kernels this CPU can run, scalar first.
+        std::vector<FilterKernel> SupportedKernels()
+        {
+            std::vector<FilterKernel> kernels{ FilterKernel::Scalar };
+            if (BatchFilter::BestKernel() != FilterKernel::Scalar)
+            {
+                kernels.push_back(FilterKernel::Sse41);
+            }
+            if (BatchFilter::BestKernel() == FilterKernel::Avx2)
+            {
+                kernels.push_back(FilterKernel::Avx2);
+            }
+            return kernels;
+        }
+
+        CompactEventRecord MakeRecord(const wchar_t* source, const wchar_t* destination, const wchar_t* ruleId)
+        {
+            CompactEventRecord record;
+            bool isIpv6 = false;
+            ParseAddress(source, &record.source, &isIpv6);
+            ParseAddress(destination, &record.destination, &isIpv6);
+            ParseGuid(ruleId, &record.ruleId);
+            return record;
+        }
+
+        // Events from the addresses 10.0.0.<0..99> to 10.1.0.<0..99>, with one of 100 rules; a filter
+        // on the first `share` source addresses and rules passes about share% * share% of them.
+        std::vector<CompactEventRecord> MakeRecords(size_t count, unsigned seed)
+        {
+            std::mt19937 generator(seed);
+            std::vector<CompactEventRecord> records;
+            records.reserve(count);
+            for (size_t i = 0; i < count; ++i)
+            {
+                unsigned host = generator() % 100;
+                unsigned rule = generator() % 100;
+                wchar_t source[32];
+                wchar_t destination[32];
+                wchar_t ruleId[64];
+                swprintf_s(source, L"10.0.0.%u", host);
+                swprintf_s(destination, L"10.1.0.%u", generator() % 100);
+                swprintf_s(ruleId, L"29959cda-8d97-48ea-92ce-4c0164aa%04x", rule);
+                records.push_back(MakeRecord(source, destination, ruleId));
+            }
+            return records;
+        }
+
+        std::vector<std::wstring> AddressFilters(size_t share)
+        {
+            std::vector<std::wstring> filters;
+            for (size_t host = 0; host < share; ++host)
+            {
+                filters.push_back(L"10.0.0." + std::to_wstring(host));
+            }
+            return filters;
+        }
+
+        std::vector<std::wstring> RuleFilters(size_t share)
+        {
+            std::vector<std::wstring> filters;
+            for (size_t rule = 0; rule < share; ++rule)
+            {
+                wchar_t ruleId[64];
+                swprintf_s(ruleId, L"29959cda-8d97-48ea-92ce-4c0164aa%04zx", rule);
+                filters.push_back(ruleId);
+            }
+            return filters;
+        }
+
+        bool IsSelected(const uint64_t* selection, size_t row)
+        {
+            return ((selection[row / 64] >> (row % 64)) & 1) != 0;
+        }
+    }
+
+    TEST_CLASS(BatchFilterTests)
+    {
+    public:
+
+        TEST_METHOD(EmptyFilterSelectsEveryRow)
+        {
+            Logger::WriteMessage(L"EmptyFilterSelectsEveryRow");
+
+            auto batch = std::make_unique<EventBatch>();
+            for (const auto& record : MakeRecords(70, 1))
+            {
+                batch->Add(record);
+            }
+
+            BatchFilter filter;
+            uint64_t selection[EventBatch::SelectionWords];
+            Assert::AreEqual(static_cast<size_t>(70), filter.Evaluate(*batch, selection));
+            Assert::AreEqual(~0ull, selection[0]);
+            Assert::AreEqual(0x3Full, selection[1]);
+            Assert::AreEqual(0ull, selection[2]);
+        }
+
+        TEST_METHOD(EventWithoutAddressPassesOnThatSide)
+        {
+            Logger::WriteMessage(L"EventWithoutAddressPassesOnThatSide");
+
+            const wchar_t* ruleId = L"29959cda-8d97-48ea-92ce-4c0164aac7f4";
+            for (FilterKernel kernel : SupportedKernels())
+            {
+                BatchFilter filter({ L"2001:db8::1" }, {}, kernel);
+                auto batch = std::make_unique<EventBatch>();
+                // Destination matches, in another spelling; neither matches; source absent.
+                batch->Add(MakeRecord(L"10.0.0.1", L"2001:0db8:0000::0001", ruleId));
+                batch->Add(MakeRecord(L"10.0.0.1", L"10.0.0.2", ruleId));
+                batch->Add(MakeRecord(L"", L"10.0.0.2", ruleId));
+
+                uint64_t selection[EventBatch::SelectionWords];
+                Assert::AreEqual(static_cast<size_t>(2), filter.Evaluate(*batch, selection), BatchFilter::KernelName(kernel));
+                Assert::AreEqual(0x5ull, selection[0], BatchFilter::KernelName(kernel));
+            }
+        }
+
+        TEST_METHOD(KernelsAgreeWithMatchForEveryBatchLength)
+        {
+            Logger::WriteMessage(L"KernelsAgreeWithMatchForEveryBatchLength");
+
+            auto records = MakeRecords(EventBatch::Capacity, 98);
+            std::vector<std::pair<size_t, size_t>> shares{ { 0, 10 }, { 30, 0 }, { 50, 50 }, { 100, 3 } };
+            // Whole and partial vectors and selection words.
+            std::vector<size_t> lengths{ 0, 1, 5, 63, 64, 65, 200, 255, 256 };
+            for (const auto& share : shares)
+            {
+                for (FilterKernel kernel : SupportedKernels())
+                {
+                    BatchFilter filter(AddressFilters(share.first), RuleFilters(share.second), kernel);
+                    auto batch = std::make_unique<EventBatch>();
+                    for (size_t length : lengths)
+                    {
+                        batch->Clear();
+                        size_t expected = 0;
+                        for (size_t row = 0; row < length; ++row)
+                        {
+                            batch->Add(records[row]);
+                            expected += filter.Match(records[row]) ? 1 : 0;
+                        }
+
+                        uint64_t selection[EventBatch::SelectionWords];
+                        Assert::AreEqual(expected, filter.Evaluate(*batch, selection), BatchFilter::KernelName(kernel));
+                        for (size_t row = 0; row < EventBatch::Capacity; ++row)
+                        {
+                            Assert::AreEqual(row < length && filter.Match(records[row]), IsSelected(selection, row));
+                        }
+                    }
+                }
+            }
+        }
+
+        TEST_METHOD(FullBatchRejectsAdd)
+        {
+            Logger::WriteMessage(L"FullBatchRejectsAdd");
+
+            auto batch = std::make_unique<EventBatch>();
+            auto records = MakeRecords(EventBatch::Capacity + 1, 2);
+            for (size_t row = 0; row < EventBatch::Capacity; ++row)
+            {
+                Assert::IsTrue(batch->Add(records[row]));
+            }
+            Assert::IsFalse(batch->Add(records.back()));
+
+            batch->Clear();
+            Assert::AreEqual(static_cast<size_t>(0), batch->count);
+            Assert::AreEqual(0u, batch->source[3][EventBatch::Capacity - 1]);
+        }
+    };
+
+    // Events per second through each kernel against the per-event scalar match;
+    // run with /TestCaseFilter:TestCategory=Benchmark.
+    TEST_CLASS(BatchFilterBenchmarks)
+    {
+    public:
+
+        BEGIN_TEST_METHOD_ATTRIBUTE(FilterThroughputBySelectivity)
+            TEST_METHOD_ATTRIBUTE(L"TestCategory", L"Benchmark")
+        END_TEST_METHOD_ATTRIBUTE()
+
+        TEST_METHOD(FilterThroughputBySelectivity)
+        {
+            Logger::WriteMessage(L"FilterThroughputBySelectivity");
+
+            const size_t eventCount = 1024 * 1024;
+            // A few of each filter, as typically given with -Ip and -Rule.
+            const size_t filterCount = 4;
+            const auto addresses = AddressFilters(filterCount);
+            const auto ruleIds = RuleFilters(filterCount);
+
+            std::vector<unsigned> selectedPercents{ 1, 10, 50, 100 };
+            for (unsigned selectedPercent : selectedPercents)
+            {
+                auto records = MakeSelectiveRecords(eventCount, selectedPercent, filterCount);
+                // The batches are built once: this measures the predicates, not the copies.
+                std::vector<std::unique_ptr<EventBatch>> batches;
+                for (const auto& record : records)
+                {
+                    if (batches.empty() || !batches.back()->Add(record))
+                    {
+                        batches.push_back(std::make_unique<EventBatch>());
+                        batches.back()->Add(record);
+                    }
+                }
+
+                BatchFilter scalar(addresses, ruleIds, FilterKernel::Scalar);
+                size_t matched = 0;
+                double matchRate = EventsPerSecond(eventCount, [&]()
+                {
+                    for (const auto& record : records)
+                    {
+                        matched += scalar.Match(record) ? 1 : 0;
+                    }
+                });
+
+                wchar_t message[256];
+                int length = swprintf_s(message, L"%5.1f%% selected: Match %.0fM/s",
+                    100.0 * static_cast<double>(matched) / static_cast<double>(eventCount),
+                    matchRate / 1e6);
+
+                for (FilterKernel kernel : SupportedKernels())
+                {
+                    BatchFilter filter(addresses, ruleIds, kernel);
+                    size_t selected = 0;
+                    double rate = EventsPerSecond(eventCount, [&]()
+                    {
+                        uint64_t selection[EventBatch::SelectionWords];
+                        for (const auto& batch : batches)
+                        {
+                            selected += filter.Evaluate(*batch, selection);
+                        }
+                    });
+                    Assert::AreEqual(matched, selected);
+                    length += swprintf_s(message + length, ARRAYSIZE(message) - length, L", %ls %.0fM/s",
+                        BatchFilter::KernelName(kernel),
+                        rate / 1e6);
+                }
+                Logger::WriteMessage(message);
+            }
+        }
+
+    private:
+        // Events whose source and rule are among the first filterCount of MakeRecords' hosts and
+        // rules with the given probability, and whose source is not otherwise.
+        static std::vector<CompactEventRecord> MakeSelectiveRecords(
+            size_t count,
+            unsigned selectedPercent,
+            size_t filterCount)
+        {
+            auto records = MakeRecords(count, selectedPercent);
+            std::mt19937 generator(selectedPercent);
+            const unsigned hosts = static_cast<unsigned>(filterCount);
+            for (auto& record : records)
+            {
+                bool selected = generator() % 100 < selectedPercent;
+                unsigned host = selected ? generator() % hosts : hosts + generator() % (100 - hosts);
+                record.source.u.Byte[15] = static_cast<unsigned char>(host);
+                if (selected)
+                {
+                    // The rule number is the last byte of the id.
+                    record.ruleId.Data4[7] = static_cast<unsigned char>(generator() % hosts);
+                }
+            }
+            return records;
+        }
+
+        template <typename Function>
+        static double EventsPerSecond(size_t events, Function function)
+        {
+            auto start = std::chrono::steady_clock::now();
+            function();
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            double seconds = std::chrono::duration_cast<std::chrono::duration<double>>(elapsed).count();
+            return static_cast<double>(events) / seconds;
+        }
+    };
+}
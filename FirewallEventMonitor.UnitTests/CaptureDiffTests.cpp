@@ -0,0 +1,305 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include <CppUnitTest.h>
+// code under test headers
+#include "CaptureDiff.h"
+#include "EventArchive.h"
+#include "FirewallEtwTraceCallback.h"
+// c++ headers
+#include <cstdio>
+#include <memory>
+#include <utility>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace FirewallEventMonitor;
+
+namespace FirewallEventMonitorUnitTest
+{
+    TEST_CLASS(CaptureDiffTests)
+    {
+    public:
+
+        TEST_METHOD_INITIALIZE(MethodInit)
+        {
+            // Tiny in-memory limits so every test exercises the sorted runs.
+            m_Before = std::make_shared<CaptureAggregate>(2);
+            m_After = std::make_shared<CaptureAggregate>(2);
+        }
+
+        TEST_METHOD(SpilledRunsMergeToSortedTotals)
+        {
+            Logger::WriteMessage(L"SpilledRunsMergeToSortedTotals");
+
+            for (int i = 0; i < 100; ++i)
+            {
+                m_Before->Add(MakeRecord(1 + (i * 7) % 10, RuleAction::Allow, 1, 2));
+            }
+            m_Before->Finish();
+            Assert::IsTrue(m_Before->Rules().GetRunCount() > 1);
+
+            std::pair<GUID, RuleHits> entry;
+            unsigned long expected = 1;
+            while (m_Before->Rules().Next(&entry))
+            {
+                Assert::AreEqual(expected, static_cast<unsigned long>(entry.first.Data1));
+                Assert::AreEqual(10ull, entry.second.allowHits);
+                expected++;
+            }
+            Assert::AreEqual(11ul, expected);
+        }
+
+        TEST_METHOD(FlippedFlowsAreReported)
+        {
+            Logger::WriteMessage(L"FlippedFlowsAreReported");
+
+            m_Before->Add(MakeRecord(1, RuleAction::Allow, 1, 2));
+            m_Before->Add(MakeRecord(1, RuleAction::Allow, 1, 3));
+            m_Before->Add(MakeRecord(1, RuleAction::Allow, 1, 4));
+            m_After->Add(MakeRecord(2, RuleAction::Deny, 1, 2));
+            // Same flow, reply direction: still one flow.
+            CompactEventRecord reply = MakeRecord(2, RuleAction::Deny, 2, 1);
+            std::swap(reply.sourcePort, reply.destinationPort);
+            m_After->Add(reply);
+            m_After->Add(MakeRecord(1, RuleAction::Allow, 1, 3));
+            m_After->Add(MakeRecord(1, RuleAction::Allow, 1, 4));
+
+            CaptureDiff diff(2);
+            CaptureDiffReport report = diff.Compare(*m_Before, *m_After);
+
+            Assert::AreEqual(3ull, report.flowsBefore);
+            Assert::AreEqual(3ull, report.flowsAfter);
+            Assert::AreEqual(1ull, report.flowsFlipped);
+            Assert::AreEqual(static_cast<size_t>(1), report.flippedFlows.size());
+            Assert::IsTrue(RuleAction::Allow == report.flippedFlows[0].before.Outcome());
+            Assert::IsTrue(RuleAction::Deny == report.flippedFlows[0].after.Outcome());
+            Assert::AreEqual(2ul, static_cast<unsigned long>(report.flippedFlows[0].after.denyRuleId.Data1));
+        }
+
+        TEST_METHOD(RuleChangesAreSortedByDelta)
+        {
+            Logger::WriteMessage(L"RuleChangesAreSortedByDelta");
+
+            // Rule 1: 5 -> 1, rule 2: unchanged, rule 3: gone, rule 4: new with 10 hits.
+            for (int i = 0; i < 5; ++i)
+            {
+                m_Before->Add(MakeRecord(1, RuleAction::Allow, 1, 2));
+            }
+            m_After->Add(MakeRecord(1, RuleAction::Allow, 1, 2));
+            m_Before->Add(MakeRecord(2, RuleAction::Deny, 3, 4));
+            m_After->Add(MakeRecord(2, RuleAction::Deny, 3, 4));
+            m_Before->Add(MakeRecord(3, RuleAction::Deny, 5, 6));
+            for (int i = 0; i < 10; ++i)
+            {
+                m_After->Add(MakeRecord(4, RuleAction::Allow, 7, 8));
+            }
+
+            CaptureDiff diff(2, 2);
+            CaptureDiffReport report = diff.Compare(*m_Before, *m_After);
+
+            Assert::AreEqual(3ull, report.rulesChanged);
+            Assert::AreEqual(1ull, report.rulesAdded);
+            Assert::AreEqual(1ull, report.rulesRemoved);
+            // Limited to the two largest changes.
+            Assert::AreEqual(static_cast<size_t>(2), report.ruleChanges.size());
+            Assert::AreEqual(4ul, static_cast<unsigned long>(report.ruleChanges[0].ruleId.Data1));
+            Assert::AreEqual(1ul, static_cast<unsigned long>(report.ruleChanges[1].ruleId.Data1));
+        }
+
+        TEST_METHOD(NewSourcesAreReported)
+        {
+            Logger::WriteMessage(L"NewSourcesAreReported");
+
+            m_Before->Add(MakeRecord(1, RuleAction::Allow, 1, 2));
+            m_After->Add(MakeRecord(1, RuleAction::Allow, 1, 2));
+            m_After->Add(MakeRecord(1, RuleAction::Allow, 9, 2));
+            m_After->Add(MakeRecord(1, RuleAction::Allow, 9, 2));
+
+            CaptureDiff diff(2);
+            CaptureDiffReport report = diff.Compare(*m_Before, *m_After);
+
+            Assert::AreEqual(1ull, report.sourcesAdded);
+            Assert::AreEqual(static_cast<size_t>(1), report.newSources.size());
+            Assert::AreEqual(2ull, report.newSources[0].hits);
+            Assert::AreEqual(static_cast<unsigned char>(9), report.newSources[0].address.u.Byte[15]);
+        }
+
+        TEST_METHOD(RawLogParserRebuildsEvents)
+        {
+            Logger::WriteMessage(L"RawLogParserRebuildsEvents");
+
+            RawLogParser parser;
+            CompactEventRecord record;
+            Assert::IsFalse(parser.ParseLine(L"[20170907 224228] Inbound Deny rule status = 0x0 ", &record));
+            Assert::IsFalse(parser.ParseLine(L"  port {id = 4, portName = 07312833-61E0-4D4E-BB4C-BFC46E86D345, portFriendlyName = NULL} ", &record));
+            Assert::IsFalse(parser.ParseLine(L"  flow {src = 192.168.100.21, dst = 192.168.100.22, protocol = TCP, srcPort = 50000, dstPort = 443, isTcpSyn = 1} ", &record));
+            Assert::IsTrue(parser.ParseLine(L"  rule {id = 43cff06e-a520-4ad3-9fd9-1894f4a3489b, layer = FW_CONTROLLER_LAYER_ID, group = FW_GROUP_IPv4_IN_ID, gftFlags = 0} ", &record));
+
+            Assert::IsTrue(RuleAction::Deny == record.action);
+            Assert::IsTrue(TrafficDirection::Inbound == record.direction);
+            Assert::AreEqual(static_cast<unsigned short>(6), record.protocol);
+            Assert::AreEqual(static_cast<unsigned short>(50000), record.sourcePort);
+            Assert::AreEqual(static_cast<unsigned short>(443), record.destinationPort);
+            Assert::IsTrue(record.isTcpSyn);
+            Assert::AreEqual(static_cast<unsigned char>(21), record.source.u.Byte[15]);
+            Assert::AreEqual(0x43cff06eul, static_cast<unsigned long>(record.ruleId.Data1));
+
+            // A rule line without its header is not an event.
+            Assert::IsFalse(parser.ParseLine(L"  rule {id = 43cff06e-a520-4ad3-9fd9-1894f4a3489b} ", &record));
+            Assert::AreEqual(1ul, record.sampleRate);
+        }
+
+        TEST_METHOD(SampledEventsAreScaledUp)
+        {
+            Logger::WriteMessage(L"SampledEventsAreScaledUp");
+
+            RawLogParser parser;
+            CompactEventRecord record;
+            Assert::IsFalse(parser.ParseLine(L"[20170907 224228] Inbound Allow rule status = 0x0 ", &record));
+            Assert::IsFalse(parser.ParseLine(L"  flow {src = 192.168.100.21, dst = 192.168.100.22, protocol = TCP, srcPort = 50000, dstPort = 443, sampleRate = 1/16} ", &record));
+            Assert::IsTrue(parser.ParseLine(L"  rule {id = 43cff06e-a520-4ad3-9fd9-1894f4a3489b} ", &record));
+            Assert::AreEqual(16ul, record.sampleRate);
+
+            m_Before->Add(record);
+            m_Before->Finish();
+            Assert::AreEqual(16ull, m_Before->GetEventCount());
+
+            std::pair<GUID, RuleHits> entry;
+            Assert::IsTrue(m_Before->Rules().Next(&entry));
+            Assert::AreEqual(16ull, entry.second.allowHits);
+        }
+
+        TEST_METHOD(ArchivesAreReadByTheirColumns)
+        {
+            Logger::WriteMessage(L"ArchivesAreReadByTheirColumns");
+
+            // Not the archive extension: the archive is found by its magic.
+            std::wstring path = WriteArchive(5);
+            CaptureDiff::ReadCapture(path, m_Before.get());
+            _wremove(path.c_str());
+            m_Before->Finish();
+            Assert::AreEqual(5ull, m_Before->GetEventCount());
+
+            std::pair<GUID, RuleHits> entry;
+            Assert::IsTrue(m_Before->Rules().Next(&entry));
+            Assert::AreEqual(1ul, static_cast<unsigned long>(entry.first.Data1));
+            Assert::AreEqual(3ull, entry.second.denyHits);
+            Assert::IsTrue(m_Before->Rules().Next(&entry));
+            Assert::AreEqual(2ull, entry.second.denyHits);
+            Assert::IsFalse(m_Before->Rules().Next(&entry));
+        }
+
+        TEST_METHOD(FilteredCapturesKeepMatchingEvents)
+        {
+            Logger::WriteMessage(L"FilteredCapturesKeepMatchingEvents");
+
+            // More than one filter batch, the last one partly filled.
+            const size_t events = 2 * EventBatch::Capacity + 3;
+            std::wstring path = WriteArchive(events);
+            BatchFilter filter(std::vector<std::wstring>(), { L"00000002-0000-0000-0000-000000000000" });
+            CaptureDiff::ReadCapture(path, m_Before.get(), filter);
+            _wremove(path.c_str());
+            m_Before->Finish();
+            Assert::AreEqual(static_cast<unsigned long long>(events / 2), m_Before->GetEventCount());
+
+            std::pair<GUID, RuleHits> entry;
+            Assert::IsTrue(m_Before->Rules().Next(&entry));
+            Assert::AreEqual(2ul, static_cast<unsigned long>(entry.first.Data1));
+            Assert::IsFalse(m_Before->Rules().Next(&entry));
+        }
+
+        TEST_METHOD(JsonLogsAreDiffed)
+        {
+            Logger::WriteMessage(L"JsonLogsAreDiffed");
+
+            std::wstring beforePath = WriteJsonLog(L"Before", L"Allow", L"00000001-0000-0000-0000-000000000000", 1);
+            std::wstring afterPath = WriteJsonLog(L"After", L"Deny", L"00000002-0000-0000-0000-000000000000", 4);
+            CaptureDiffReport report = CaptureDiff(2).Compare(beforePath, afterPath);
+            _wremove(beforePath.c_str());
+            _wremove(afterPath.c_str());
+
+            Assert::AreEqual(1ull, report.eventsBefore);
+            Assert::AreEqual(4ull, report.eventsAfter);
+            Assert::AreEqual(1ull, report.flowsFlipped);
+            Assert::AreEqual(1ull, report.rulesAdded);
+            Assert::AreEqual(1ull, report.rulesRemoved);
+            Assert::AreEqual(static_cast<size_t>(1), report.flippedFlows.size());
+            Assert::AreEqual(1ul, static_cast<unsigned long>(report.flippedFlows[0].before.allowRuleId.Data1));
+            Assert::AreEqual(2ul, static_cast<unsigned long>(report.flippedFlows[0].after.denyRuleId.Data1));
+        }
+
+    private:
+        std::shared_ptr<CaptureAggregate> m_Before;
+        std::shared_ptr<CaptureAggregate> m_After;
+
+        static CompactEventRecord MakeRecord(unsigned long rule, RuleAction action, unsigned char source, unsigned char destination)
+        {
+            CompactEventRecord record;
+            record.ruleId.Data1 = rule;
+            record.action = action;
+            record.direction = TrafficDirection::Inbound;
+            record.protocol = 6;
+            record.sourcePort = 50000;
+            record.destinationPort = 443;
+            record.source.u.Byte[10] = 0xff;
+            record.source.u.Byte[11] = 0xff;
+            record.source.u.Byte[15] = source;
+            record.destination.u.Byte[10] = 0xff;
+            record.destination.u.Byte[11] = 0xff;
+            record.destination.u.Byte[15] = destination;
+            return record;
+        }
+
+        // Rules 1 and 2 in turn, from a different source each time.
+        static std::wstring WriteArchive(size_t events)
+        {
+            wchar_t directory[MAX_PATH];
+            ::GetTempPathW(MAX_PATH, directory);
+            std::wstring path = std::wstring(directory) + L"CaptureDiffTests.log";
+
+            // Room to queue every batch, so none is dropped however far the writer's thread falls behind.
+            EventArchiveWriter writer(path, 2, events);
+            for (size_t i = 0; i < events; ++i)
+            {
+                VfpEventData eventData;
+                eventData.compact = MakeRecord(static_cast<unsigned long>(1 + i % 2), RuleAction::Deny, static_cast<unsigned char>(i), 2);
+                writer.Append(eventData);
+            }
+            writer.Close();
+            return path;
+        }
+
+        // One event of a flow from 192.168.100.21, as -LogFormat Json writes it.
+        static std::wstring WriteJsonLog(LPCWSTR name, LPCWSTR ruleType, LPCWSTR ruleId, unsigned long sampleRate)
+        {
+            wchar_t directory[MAX_PATH];
+            ::GetTempPathW(MAX_PATH, directory);
+            std::wstring path = std::wstring(directory) + L"CaptureDiffTests" + name + L".log";
+
+            VfpEventData eventData;
+            eventData.compact.sampleRate = sampleRate;
+            eventData.date = L"20170907";
+            eventData.time = L"224228";
+            eventData.direction = L"Inbound";
+            eventData.ruleType = ruleType;
+            eventData.status = L"0x0";
+            eventData.portFriendlyName = L"\"vNIC\" \\ 1";
+            eventData.source = L"192.168.100.21";
+            eventData.destination = L"192.168.100.22";
+            eventData.protocol = L"TCP";
+            eventData.sourcePort = L"50000";
+            eventData.destinationPort = L"443";
+            eventData.ruleId = ruleId;
+            std::wstring text;
+            FirewallEtwTraceCallback::FormatEventJson(eventData, &text);
+
+            FILE* logFile = NULL;
+            _wfopen_s(&logFile, path.c_str(), L"w");
+            Assert::IsNotNull(logFile);
+            fputws(text.c_str(), logFile);
+            fclose(logFile);
+            return path;
+        }
+    };
+}
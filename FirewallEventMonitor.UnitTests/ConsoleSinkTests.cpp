@@ -0,0 +1,104 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include <CppUnitTest.h>
+// code under test headers
+#include "ConsoleSink.h"
+// c++ headers
+#include <cstdio>
+#include <memory>
+#include <string>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace FirewallEventMonitor;
+
+namespace FirewallEventMonitorUnitTest
+{
+    TEST_CLASS(ConsoleSinkTests)
+    {
+    public:
+
+        TEST_METHOD_INITIALIZE(MethodInit)
+        {
+            m_Stream = nullptr;
+            Assert::AreEqual(0, tmpfile_s(&m_Stream));
+            m_Sink = std::make_shared<ConsoleSink>(m_Stream, MaxPendingCharacters);
+        }
+
+        TEST_METHOD_CLEANUP(MethodCleanup)
+        {
+            m_Sink.reset();
+            fclose(m_Stream);
+        }
+
+        TEST_METHOD(FlushWritesEventsInOrder)
+        {
+            Logger::WriteMessage(L"FlushWritesEventsInOrder");
+
+            Assert::IsTrue(m_Sink->Write(L"first\n"));
+            Assert::IsTrue(m_Sink->Write(L"second\n"));
+            Assert::AreEqual(std::wstring(), ReadStream());
+
+            m_Sink->Flush();
+            Assert::AreEqual(std::wstring(L"first\nsecond\n"), ReadStream());
+            Assert::AreEqual(2ull, m_Sink->GetEventsWritten());
+        }
+
+        TEST_METHOD(FullBufferDropsWithMarker)
+        {
+            Logger::WriteMessage(L"FullBufferDropsWithMarker");
+
+            std::wstring event(MaxPendingCharacters / 4, L'x');
+            for (int i = 0; i < 4; ++i)
+            {
+                Assert::IsTrue(m_Sink->Write(event));
+            }
+            Assert::IsFalse(m_Sink->Write(L"y"));
+            Assert::IsFalse(m_Sink->Write(event));
+            Assert::AreEqual(2ull, m_Sink->GetEventsDropped());
+
+            m_Sink->Flush();
+            std::wstring written = ReadStream();
+            Assert::AreEqual(MaxPendingCharacters, written.find(L"  ... 2 events not shown"));
+
+            // The marker is only written once, and the buffer has room again.
+            Assert::IsTrue(m_Sink->Write(L"after\n"));
+            m_Sink->Flush();
+            written = ReadStream();
+            size_t marker = written.find(L"not shown");
+            Assert::IsTrue(written.find(L"not shown", marker + 1) == std::wstring::npos);
+            Assert::AreEqual(written.size() - 6, written.find(L"after\n"));
+        }
+
+        TEST_METHOD(StopWritesPendingEvents)
+        {
+            Logger::WriteMessage(L"StopWritesPendingEvents");
+
+            // A refresh interval far longer than the test: only Stop() can write the event.
+            ConsoleSink sink(m_Stream, MaxPendingCharacters, 60000);
+            sink.Start();
+            Assert::IsTrue(sink.Write(L"pending\n"));
+            sink.Stop();
+
+            Assert::AreEqual(std::wstring(L"pending\n"), ReadStream());
+        }
+
+    private:
+        FILE* m_Stream;
+        std::shared_ptr<ConsoleSink> m_Sink;
+
+        const size_t MaxPendingCharacters = 64;
+
+        std::wstring ReadStream()
+        {
+            std::wstring text;
+            rewind(m_Stream);
+            wint_t c;
+            while ((c = fgetwc(m_Stream)) != WEOF)
+            {
+                text.push_back(static_cast<wchar_t>(c));
+            }
+            return text;
+        }
+    };
+}
@@ -0,0 +1,197 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include <CppUnitTest.h>
+// code under test headers
+#include "Dashboard.h"
+// c++ headers
+#include <memory>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace FirewallEventMonitor;
+
+namespace FirewallEventMonitorUnitTest
+{
+    TEST_CLASS(DashboardTests)
+    {
+    public:
+
+        TEST_METHOD_INITIALIZE(MethodInit)
+        {
+            m_Dashboard = std::make_shared<Dashboard>(TopCount, MaxKeysPerInterval);
+        }
+
+        TEST_METHOD(CountsScaleBySampleRate)
+        {
+            Logger::WriteMessage(L"CountsScaleBySampleRate");
+
+            m_Dashboard->RecordEvent(MakeRecord(L"10.0.0.1", 443, 6, RuleAction::Allow, 1), Now);
+            m_Dashboard->RecordEvent(MakeRecord(L"10.0.0.2", 53, 17, RuleAction::Deny, 16), Now);
+            m_Dashboard->RecordEvent(MakeRecord(L"10.0.0.3", 0, 1, RuleAction::Deny, 1), Now);
+
+            DashboardSnapshot snapshot = m_Dashboard->TakeSnapshot(2.0);
+            Assert::AreEqual(18ull, snapshot.events);
+            Assert::AreEqual(1ull, snapshot.allowEvents);
+            Assert::AreEqual(17ull, snapshot.denyEvents);
+            Assert::AreEqual(1ull, snapshot.tcpEvents);
+            Assert::AreEqual(16ull, snapshot.udpEvents);
+            Assert::AreEqual(1ull, snapshot.icmpEvents);
+            Assert::AreEqual(0ull, snapshot.otherEvents);
+            Assert::AreEqual(5.0, snapshot.lagMaxInMilliseconds, 0.001);
+            Assert::AreEqual(static_cast<size_t>(1), snapshot.rateHistory.size());
+            Assert::AreEqual(9.0, snapshot.rateHistory[0]);
+        }
+
+        TEST_METHOD(TopListsRankBusiestFirst)
+        {
+            Logger::WriteMessage(L"TopListsRankBusiestFirst");
+
+            Dashboard dashboard(TopCount, 100);
+
+            for (int i = 0; i < 5; ++i)
+            {
+                dashboard.RecordEvent(MakeRecord(L"10.0.0.1", 443, 6, RuleAction::Allow, 1), Now);
+            }
+            for (int i = 0; i < 9; ++i)
+            {
+                dashboard.RecordEvent(MakeRecord(L"10.0.0.2", 53, 17, RuleAction::Allow, 1), Now);
+            }
+            for (unsigned short port = 1; port <= 10; ++port)
+            {
+                dashboard.RecordEvent(MakeRecord(L"10.0.0.3", port, 6, RuleAction::Deny, 1), Now);
+            }
+
+            DashboardSnapshot snapshot = dashboard.TakeSnapshot(1.0);
+            Assert::AreEqual(TopCount, snapshot.topSources.size());
+            Assert::AreEqual(std::wstring(L"10.0.0.3"), snapshot.topSources[0].name);
+            Assert::AreEqual(10ull, snapshot.topSources[0].events);
+            Assert::AreEqual(std::wstring(L"10.0.0.2"), snapshot.topSources[1].name);
+            Assert::AreEqual(std::wstring(L"10.0.0.1"), snapshot.topSources[2].name);
+
+            Assert::AreEqual(std::wstring(L"53/UDP"), snapshot.topPorts[0].name);
+            Assert::AreEqual(std::wstring(L"443/TCP"), snapshot.topPorts[1].name);
+        }
+
+        TEST_METHOD(FullTablesLeaveNewKeysUnranked)
+        {
+            Logger::WriteMessage(L"FullTablesLeaveNewKeysUnranked");
+
+            m_Dashboard->RecordEvent(MakeRecord(L"10.0.0.1", 80, 6, RuleAction::Allow, 1), Now);
+            m_Dashboard->RecordEvent(MakeRecord(L"10.0.0.2", 80, 6, RuleAction::Allow, 1), Now);
+            // The source table already holds MaxKeysPerInterval addresses.
+            m_Dashboard->RecordEvent(MakeRecord(L"10.0.0.3", 80, 6, RuleAction::Allow, 1), Now);
+            m_Dashboard->RecordEvent(MakeRecord(L"10.0.0.1", 80, 6, RuleAction::Allow, 1), Now);
+
+            DashboardSnapshot snapshot = m_Dashboard->TakeSnapshot(1.0);
+            Assert::AreEqual(4ull, snapshot.events);
+            Assert::AreEqual(1ull, snapshot.eventsNotRanked);
+            Assert::AreEqual(2ull, snapshot.topSources[0].events);
+
+            // The next interval starts empty, with room for new keys again.
+            m_Dashboard->RecordEvent(MakeRecord(L"10.0.0.3", 80, 6, RuleAction::Allow, 1), Now);
+            snapshot = m_Dashboard->TakeSnapshot(1.0);
+            Assert::AreEqual(1ull, snapshot.events);
+            Assert::AreEqual(0ull, snapshot.eventsNotRanked);
+            Assert::AreEqual(std::wstring(L"10.0.0.3"), snapshot.topSources[0].name);
+        }
+
+        TEST_METHOD(RateHistoryIsBounded)
+        {
+            Logger::WriteMessage(L"RateHistoryIsBounded");
+
+            const size_t historyLength = Dashboard::RateHistoryLength;
+            DashboardSnapshot snapshot;
+            for (size_t i = 0; i < historyLength + 5; ++i)
+            {
+                m_Dashboard->RecordEvent(MakeRecord(L"10.0.0.1", 80, 6, RuleAction::Allow, 1), Now);
+                snapshot = m_Dashboard->TakeSnapshot(1.0);
+            }
+            Assert::AreEqual(historyLength, snapshot.rateHistory.size());
+        }
+
+        TEST_METHOD(SparklineScalesToPeak)
+        {
+            Logger::WriteMessage(L"SparklineScalesToPeak");
+
+            Assert::AreEqual(std::wstring(L" .@"), Dashboard::Sparkline({ 0.0, 0.01, 100.0 }));
+            Assert::AreEqual(std::wstring(L"   "), Dashboard::Sparkline({ 0.0, 0.0, 0.0 }));
+            Assert::AreEqual(std::wstring(), Dashboard::Sparkline({}));
+        }
+
+        TEST_METHOD(RenderShowsTopEntries)
+        {
+            Logger::WriteMessage(L"RenderShowsTopEntries");
+
+            m_Dashboard->RecordEvent(MakeRecord(L"10.0.0.1", 443, 6, RuleAction::Allow, 1), Now);
+            std::wstring screen = Dashboard::Render(m_Dashboard->TakeSnapshot(1.0));
+
+            Assert::AreEqual(static_cast<size_t>(0), screen.find(L"\x1b[H"));
+            Assert::IsTrue(screen.find(L"10.0.0.1") != std::wstring::npos);
+            Assert::IsTrue(screen.find(L"443/TCP") != std::wstring::npos);
+        }
+
+        TEST_METHOD(RenderShowsThrottledSecondsOnceThrottled)
+        {
+            Logger::WriteMessage(L"RenderShowsThrottledSecondsOnceThrottled");
+
+            DashboardSnapshot snapshot = m_Dashboard->TakeSnapshot(1.0);
+            snapshot.eventLimitPerEpoc = 5000;
+            Assert::IsTrue(Dashboard::Render(snapshot).find(L"Throttled") == std::wstring::npos);
+
+            snapshot.epocsThrottled = 3;
+            std::wstring screen = Dashboard::Render(snapshot);
+            Assert::IsTrue(screen.find(L"Throttled limit of 5000 events/s reached in 3 s") != std::wstring::npos);
+        }
+
+        TEST_METHOD(RecentAlertsKeepTheLatestLines)
+        {
+            Logger::WriteMessage(L"RecentAlertsKeepTheLatestLines");
+
+            const size_t alertLines = Dashboard::RecentAlertLines;
+            for (size_t i = 0; i < alertLines + 2; ++i)
+            {
+                m_Dashboard->RecordAlert(L"Alert " + std::to_wstring(i) + L" \n");
+            }
+            m_Dashboard->RecordAlert(L"Asymmetric flow \n  inbound {Allow} outbound {Deny} \n");
+
+            DashboardSnapshot snapshot = m_Dashboard->TakeSnapshot(1.0);
+            Assert::AreEqual(alertLines, snapshot.recentAlerts.size());
+            Assert::AreEqual(std::wstring(L"Alert 4 "), snapshot.recentAlerts.front());
+            Assert::AreEqual(std::wstring(L"  inbound {Allow} outbound {Deny} "), snapshot.recentAlerts.back());
+
+            // Alerts stay on screen across refreshes.
+            std::wstring screen = Dashboard::Render(m_Dashboard->TakeSnapshot(1.0));
+            Assert::IsTrue(screen.find(L"Recent alerts") != std::wstring::npos);
+            Assert::IsTrue(screen.find(L"Asymmetric flow") != std::wstring::npos);
+        }
+
+    private:
+        std::shared_ptr<Dashboard> m_Dashboard;
+
+        const size_t TopCount = 3;
+        const size_t MaxKeysPerInterval = 2;
+        // Processing time 5ms after the events' timestamp.
+        const LONGLONG EventTime = 131500000000000000LL;
+        const LONGLONG Now = EventTime + 50000;
+
+        CompactEventRecord MakeRecord(
+            const wchar_t* source,
+            unsigned short destinationPort,
+            unsigned short protocol,
+            RuleAction action,
+            unsigned long sampleRate) const
+        {
+            CompactEventRecord record;
+            bool isIpv6 = false;
+            ParseAddress(source, &record.source, &isIpv6);
+            ParseAddress(L"10.1.1.1", &record.destination, &isIpv6);
+            record.isIpv6 = isIpv6;
+            record.destinationPort = destinationPort;
+            record.protocol = protocol;
+            record.action = action;
+            record.sampleRate = sampleRate;
+            record.timeStamp = EventTime;
+            return record;
+        }
+    };
+}
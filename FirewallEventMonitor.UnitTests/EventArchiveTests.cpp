@@ -0,0 +1,232 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include <CppUnitTest.h>
+// code under test headers
+#include "EventArchive.h"
+// c++ headers
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace FirewallEventMonitor;
+
+namespace FirewallEventMonitorUnitTest
+{
+    TEST_CLASS(EventArchiveTests)
+    {
+    public:
+
+        TEST_METHOD_INITIALIZE(MethodInit)
+        {
+            WCHAR directory[MAX_PATH] = L"";
+            ::GetTempPathW(MAX_PATH, directory);
+            m_Path = std::wstring(directory) + L"EventArchiveTests.fea";
+            _wremove(m_Path.c_str());
+        }
+
+        TEST_METHOD_CLEANUP(MethodCleanup)
+        {
+            _wremove(m_Path.c_str());
+        }
+
+        TEST_METHOD(EventsRoundTripAcrossBatches)
+        {
+            Logger::WriteMessage(L"EventsRoundTripAcrossBatches");
+
+            {
+                EventArchiveWriter writer(m_Path, 2);
+                for (int i = 0; i < 5; ++i)
+                {
+                    writer.Append(MakeEvent(i));
+                }
+                writer.Close();
+                Assert::AreEqual(5ull, writer.GetRowsWritten());
+                Assert::AreEqual(3ull, writer.GetBatchesWritten());
+            }
+
+            EventArchiveReader reader(m_Path);
+            Assert::AreEqual(static_cast<size_t>(ArchiveColumn::Count), reader.GetColumns().size());
+            Assert::AreEqual(static_cast<size_t>(3), reader.GetBatchCount());
+
+            int i = 0;
+            std::string portNames;
+            std::vector<CompactEventRecord> events;
+            for (size_t batch = 0; batch < reader.GetBatchCount(); ++batch)
+            {
+                reader.ReadEvents(batch, &events);
+                reader.ReadColumn(batch, ArchiveColumn::PortName, &portNames);
+                for (size_t row = 0; row < events.size(); ++row, ++i)
+                {
+                    VfpEventData expected = MakeEvent(i);
+                    AssertSameEvent(expected.compact, events[row]);
+
+                    uint32_t id = EventArchiveReader::ValueAt<uint32_t>(portNames, row);
+                    std::string portName = reader.GetString(ArchiveColumn::PortName, id);
+                    Assert::AreEqual(std::string(expected.portName.begin(), expected.portName.end()), portName);
+                }
+            }
+            Assert::AreEqual(5, i);
+        }
+
+        TEST_METHOD(RepeatedValuesAreStoredOnceInTheDictionary)
+        {
+            Logger::WriteMessage(L"RepeatedValuesAreStoredOnceInTheDictionary");
+
+            const size_t rows = 1000;
+            {
+                EventArchiveWriter writer(m_Path);
+                for (size_t i = 0; i < rows; ++i)
+                {
+                    writer.Append(MakeEvent(static_cast<int>(i % 2)));
+                }
+                writer.Close();
+                // Two values in each of the 8 dictionary columns but status, which has one.
+                Assert::AreEqual(static_cast<size_t>(15), writer.GetDictionaryEntries());
+            }
+
+            EventArchiveReader reader(m_Path);
+            std::string ruleIds;
+            Assert::AreEqual(rows, reader.ReadColumn(0, ArchiveColumn::RuleId, &ruleIds));
+            Assert::AreEqual(rows * sizeof(uint32_t), ruleIds.size());
+            Assert::IsTrue(EventArchiveReader::ValueAt<uint32_t>(ruleIds, rows - 1) == 1);
+            Assert::IsTrue(MakeEvent(1).compact.ruleId == reader.GetGuid(ArchiveColumn::RuleId, 1));
+        }
+
+        TEST_METHOD(TimeStampsAreStoredAsVarintDeltas)
+        {
+            Logger::WriteMessage(L"TimeStampsAreStoredAsVarintDeltas");
+
+            // Out of order by a little, as ETW buffers from different processors can be.
+            const LONGLONG timeStamps[] = { 131492977481230000LL, 131492977481230010LL, 131492977481230005LL, 131492977481230050LL };
+            {
+                EventArchiveWriter writer(m_Path);
+                for (LONGLONG timeStamp : timeStamps)
+                {
+                    VfpEventData eventData = MakeEvent(0);
+                    eventData.compact.timeStamp = timeStamp;
+                    writer.Append(eventData);
+                }
+            }
+
+            EventArchiveReader reader(m_Path);
+            std::string data;
+            size_t rowCount = reader.ReadColumn(0, ArchiveColumn::TimeStamp, &data);
+            // The first value takes 9 bytes; each difference after it takes 1.
+            Assert::AreEqual(static_cast<size_t>(9 + 3), data.size());
+
+            std::vector<LONGLONG> decoded;
+            EventArchiveReader::DecodeTimeStamps(data, rowCount, &decoded);
+            Assert::AreEqual(_countof(timeStamps), decoded.size());
+            for (size_t i = 0; i < decoded.size(); ++i)
+            {
+                Assert::AreEqual(timeStamps[i], decoded[i]);
+            }
+        }
+
+        TEST_METHOD(UnclosedArchiveIsReadUpToItsLastCompleteBatch)
+        {
+            Logger::WriteMessage(L"UnclosedArchiveIsReadUpToItsLastCompleteBatch");
+
+            unsigned long long firstBatchEnd = 0;
+            {
+                EventArchiveWriter writer(m_Path, 2);
+                writer.Append(MakeEvent(0));
+                writer.Append(MakeEvent(1));
+                // The full batch is written on the writer's thread.
+                writer.Flush();
+                firstBatchEnd = writer.GetBytesWritten();
+                writer.Append(MakeEvent(2));
+                writer.Append(MakeEvent(3));
+            }
+
+            // Cut the file partway into the second batch, as a crash could.
+            std::string bytes = ReadFile();
+            bytes.resize(static_cast<size_t>(firstBatchEnd) + 40);
+            WriteFile(bytes);
+
+            EventArchiveReader reader(m_Path);
+            Assert::AreEqual(static_cast<size_t>(1), reader.GetBatchCount());
+            std::vector<CompactEventRecord> events;
+            reader.ReadEvents(0, &events);
+            Assert::AreEqual(static_cast<size_t>(2), events.size());
+        }
+
+        TEST_METHOD(ReaderRejectsOtherFiles)
+        {
+            Logger::WriteMessage(L"ReaderRejectsOtherFiles");
+
+            WriteFile("[20170907 224228] Inbound Allow rule status = 0x0\n");
+            Assert::ExpectException<std::exception>([&]() { EventArchiveReader reader(m_Path); });
+        }
+
+    private:
+        std::wstring m_Path;
+
+        static VfpEventData MakeEvent(int i)
+        {
+            VfpEventData eventData;
+            eventData.compact.timeStamp = 131492977481230000LL + i * 1000;
+            ParseGuid(i % 2 ? L"43cff06e-a520-4ad3-9fd9-1894f4a3489b" : L"391e5f07-0039-42dc-9734-abb5d633aadd", &eventData.compact.ruleId);
+            ParseAddress(L"192.168.100." + std::to_wstring(i), &eventData.compact.source, &eventData.compact.isIpv6);
+            ParseAddress(L"fe80::" + std::to_wstring(i + 1), &eventData.compact.destination, &eventData.compact.isIpv6);
+            eventData.compact.sourcePort = static_cast<unsigned short>(50000 + i);
+            eventData.compact.destinationPort = 443;
+            eventData.compact.protocol = 6;
+            eventData.compact.action = i % 2 ? RuleAction::Deny : RuleAction::Allow;
+            eventData.compact.direction = TrafficDirection::Inbound;
+            eventData.compact.isTcpSyn = i % 2 == 0;
+            eventData.compact.sampleRate = 1;
+            eventData.status = L"STATUS_SUCCESS";
+            eventData.portId = std::to_wstring(4 + i % 2);
+            eventData.portName = i % 2 ? L"07312833-61E0-4D4E-BB4C-BFC46E86D345" : L"5A7D2A6B-9E0B-4E63-A2A5-2F0E0E5C1D11";
+            eventData.portFriendlyName = i % 2 ? L"NULL" : L"web01";
+            eventData.layerId = i % 2 ? L"FW_CONTROLLER_LAYER_ID" : L"FW_ADMIN_LAYER_ID";
+            eventData.groupId = i % 2 ? L"FW_GROUP_IPv4_IN_ID" : L"FW_GROUP_IPv6_IN_ID";
+            eventData.gftFlags = std::to_wstring(i % 2);
+            return eventData;
+        }
+
+        static void AssertSameEvent(const CompactEventRecord& expected, const CompactEventRecord& actual)
+        {
+            Assert::AreEqual(expected.timeStamp, actual.timeStamp);
+            Assert::IsTrue(expected.ruleId == actual.ruleId);
+            Assert::IsTrue(AddressEqual()(expected.source, actual.source));
+            Assert::IsTrue(AddressEqual()(expected.destination, actual.destination));
+            Assert::AreEqual(expected.sourcePort, actual.sourcePort);
+            Assert::AreEqual(expected.destinationPort, actual.destinationPort);
+            Assert::AreEqual(expected.protocol, actual.protocol);
+            Assert::IsTrue(expected.action == actual.action);
+            Assert::IsTrue(expected.direction == actual.direction);
+            Assert::IsTrue(expected.icmpType == actual.icmpType);
+            Assert::AreEqual(expected.isIpv6, actual.isIpv6);
+            Assert::AreEqual(expected.isTcpSyn, actual.isTcpSyn);
+            Assert::AreEqual(expected.sampleRate, actual.sampleRate);
+        }
+
+        std::string ReadFile() const
+        {
+            FILE* file = NULL;
+            Assert::AreEqual(0, _wfopen_s(&file, m_Path.c_str(), L"rb"));
+            std::string bytes;
+            char buffer[4096];
+            size_t read = 0;
+            while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+            {
+                bytes.append(buffer, read);
+            }
+            fclose(file);
+            return bytes;
+        }
+
+        void WriteFile(const std::string& bytes) const
+        {
+            FILE* file = NULL;
+            Assert::AreEqual(0, _wfopen_s(&file, m_Path.c_str(), L"wb"));
+            fwrite(bytes.data(), 1, bytes.size(), file);
+            fclose(file);
+        }
+    };
+}
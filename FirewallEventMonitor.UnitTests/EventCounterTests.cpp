@@ -0,0 +1,57 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include <CppUnitTest.h>
+// code under test headers
+#include "EventCounter.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace FirewallEventMonitor;
+
+namespace FirewallEventMonitorUnitTest
+{
+    TEST_CLASS(EventCounterTests)
+    {
+    public:
+
+        TEST_METHOD(SmallLimitIsReachedExactly)
+        {
+            Logger::WriteMessage(L"SmallLimitIsReachedExactly");
+
+            EventCounter counter(10);
+            for (size_t processor = 0; processor < 10; ++processor)
+            {
+                Assert::IsFalse(counter.EpocEventCountLimitReached());
+                counter.IncrementEventCount(processor);
+            }
+            Assert::IsTrue(counter.EpocEventCountLimitReached());
+            Assert::AreEqual(10ul, counter.GetEventCountThisEpoc());
+        }
+
+        TEST_METHOD(LimitIsPassedByLessThanOneQuantumPerShard)
+        {
+            Logger::WriteMessage(L"LimitIsPassedByLessThanOneQuantumPerShard");
+
+            const unsigned long limit = 100000;
+            EventCounter counter(limit);
+            unsigned long counted = 0;
+            // Spread over processors, as ETW delivers them.
+            while (!counter.EpocEventCountLimitReached())
+            {
+                counter.IncrementEventCount(counted % 7);
+                ++counted;
+            }
+            Assert::IsTrue(counted >= limit);
+            Assert::IsTrue(counted - limit < limit / 16);
+            Assert::AreEqual(counted, counter.GetEventCountThisEpoc());
+            Assert::AreEqual(counted, counter.GetEventCountTotal());
+
+            counter.ResetEpocEventCount();
+            Assert::IsFalse(counter.EpocEventCountLimitReached());
+            Assert::AreEqual(0ul, counter.GetEventCountThisEpoc());
+            counter.IncrementEventCount();
+            Assert::AreEqual(1ul, counter.GetEventCountThisEpoc());
+            Assert::AreEqual(counted + 1, counter.GetEventCountTotal());
+        }
+    };
+}
@@ -0,0 +1,145 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include <CppUnitTest.h>
+// code under test headers
+#include "EventSink.h"
+// c++ headers
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace FirewallEventMonitor;
+
+namespace FirewallEventMonitorUnitTest
+{
+    // Keeps the events of each batch it is given.
+    class CollectingSink : public QueuedEventSink
+    {
+    public:
+        CollectingSink(size_t maxQueuedEvents)
+            : QueuedEventSink(maxQueuedEvents)
+        {
+        }
+
+        ~CollectingSink() override
+        {
+            Stop();
+        }
+
+        LPCWSTR GetName() const override
+        {
+            return L"Collecting";
+        }
+
+        EventFormat GetFormat() const override
+        {
+            return EventFormat::Text;
+        }
+
+        // Only read once the sink is stopped.
+        std::vector<EncodedEvent> written;
+
+    protected:
+        void WriteBatch(const std::vector<EncodedEvent>& events) override
+        {
+            written.insert(written.end(), events.begin(), events.end());
+        }
+    };
+
+    TEST_CLASS(EventSinkTests)
+    {
+    public:
+
+        TEST_METHOD_INITIALIZE(MethodInit)
+        {
+            m_Sink = std::make_shared<CollectingSink>(MaxQueuedEvents);
+        }
+
+        TEST_METHOD(StopWritesEventsInOrder)
+        {
+            Logger::WriteMessage(L"StopWritesEventsInOrder");
+
+            m_Sink->Start();
+            for (int i = 0; i < 3; ++i)
+            {
+                Assert::IsTrue(m_Sink->Write(std::make_shared<std::wstring>(std::to_wstring(i))));
+            }
+            m_Sink->Stop();
+
+            Assert::AreEqual(static_cast<size_t>(3), m_Sink->written.size());
+            Assert::AreEqual(std::wstring(L"0"), *m_Sink->written[0]);
+            Assert::AreEqual(std::wstring(L"2"), *m_Sink->written[2]);
+            Assert::AreEqual(3ull, m_Sink->GetEventsWritten());
+            Assert::AreEqual(0.0, m_Sink->GetQueueUsage());
+        }
+
+        TEST_METHOD(FullQueueDropsEvents)
+        {
+            Logger::WriteMessage(L"FullQueueDropsEvents");
+
+            // Not started, so nothing leaves the queue until Stop().
+            for (int i = 0; i < 6; ++i)
+            {
+                m_Sink->Write(std::make_shared<std::wstring>(std::to_wstring(i)));
+            }
+            Assert::AreEqual(1.0, m_Sink->GetQueueUsage());
+            Assert::AreEqual(2ull, m_Sink->GetEventsDropped());
+
+            m_Sink->Stop();
+            Assert::AreEqual(4ull, m_Sink->GetEventsWritten());
+            Assert::AreEqual(std::wstring(L"3"), *m_Sink->written.back());
+        }
+
+        TEST_METHOD(EventsAreSharedNotCopied)
+        {
+            Logger::WriteMessage(L"EventsAreSharedNotCopied");
+
+            EncodedEvent event = std::make_shared<std::wstring>(L"event");
+            m_Sink->Start();
+            m_Sink->Write(event);
+            m_Sink->Stop();
+
+            Assert::IsTrue(m_Sink->written[0] == event);
+        }
+
+        TEST_METHOD(StopByWritesQueuedEventsBeforeDeadline)
+        {
+            Logger::WriteMessage(L"StopByWritesQueuedEventsBeforeDeadline");
+
+            for (int i = 0; i < 3; ++i)
+            {
+                m_Sink->Write(std::make_shared<std::wstring>(std::to_wstring(i)));
+            }
+            m_Sink->StopBy(::GetTickCount64() + 60000);
+
+            Assert::AreEqual(3ull, m_Sink->GetEventsWritten());
+            Assert::AreEqual(0ull, m_Sink->GetEventsAbandoned());
+        }
+
+        TEST_METHOD(StopByAbandonsQueuedEventsPastDeadline)
+        {
+            Logger::WriteMessage(L"StopByAbandonsQueuedEventsPastDeadline");
+
+            for (int i = 0; i < 3; ++i)
+            {
+                m_Sink->Write(std::make_shared<std::wstring>(std::to_wstring(i)));
+            }
+            m_Sink->StopBy(0);
+
+            Assert::AreEqual(0ull, m_Sink->GetEventsWritten());
+            Assert::AreEqual(3ull, m_Sink->GetEventsAbandoned());
+            Assert::AreEqual(0.0, m_Sink->GetQueueUsage());
+
+            // Nothing is left for the destructor's Stop() to write.
+            m_Sink->Stop();
+            Assert::AreEqual(0ull, m_Sink->GetEventsWritten());
+        }
+
+    private:
+        std::shared_ptr<CollectingSink> m_Sink;
+
+        const size_t MaxQueuedEvents = 4;
+    };
+}
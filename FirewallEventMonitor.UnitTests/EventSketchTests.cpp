@@ -0,0 +1,314 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include <CppUnitTest.h>
+// code under test headers
+#include "EventSketch.h"
+// c++ headers
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace FirewallEventMonitor;
+
+namespace FirewallEventMonitorUnitTest
+{
+    namespace
+    {
+        const LONGLONG SketchStartTime = 131492977480000000ll; // 20170907 224228 UTC
+        const LONGLONG HundredNsPerSecond = 10000000ll;
+
+        // Event from 10.0.<source / 256>.<source % 256> to 10.1.0.<destination>, 100 ms before SketchStartTime.
+        CompactEventRecord MakeRecord(unsigned long source, unsigned char destination, unsigned short port, RuleAction action)
+        {
+            CompactEventRecord record;
+            record.timeStamp = SketchStartTime - 1000000ll;
+            record.source.u.Byte[10] = 0xff;
+            record.source.u.Byte[11] = 0xff;
+            record.source.u.Byte[12] = 10;
+            record.source.u.Byte[13] = 0;
+            record.source.u.Byte[14] = static_cast<unsigned char>(source / 256);
+            record.source.u.Byte[15] = static_cast<unsigned char>(source % 256);
+            record.destination = record.source;
+            record.destination.u.Byte[13] = 1;
+            record.destination.u.Byte[14] = 0;
+            record.destination.u.Byte[15] = destination;
+            record.sourcePort = static_cast<unsigned short>(50000 + source % 1000);
+            record.destinationPort = port;
+            record.protocol = 6;
+            record.action = action;
+            record.ruleId.Data1 = action == RuleAction::Allow ? 1 : 2;
+            return record;
+        }
+
+        // 901 sources sending to 4 destinations; source 0 sends a tenth of the events.
+        EventSketch MakeSketch(const std::wstring& host)
+        {
+            EventSketch sketch;
+            for (unsigned long i = 0; i < 10000; ++i)
+            {
+                unsigned long source = i % 10 == 0 ? 0 : i % 1000;
+                sketch.RecordEvent(
+                    MakeRecord(source, static_cast<unsigned char>(i % 4), static_cast<unsigned short>(i % 2 == 0 ? 443 : 80), i % 5 == 0 ? RuleAction::Deny : RuleAction::Allow),
+                    SketchStartTime);
+            }
+            sketch.SetSnapshot(host, SketchStartTime, SketchStartTime + 300 * HundredNsPerSecond);
+            return sketch;
+        }
+
+        void AssertSameSketch(const EventSketch& expected, const EventSketch& actual)
+        {
+            Assert::IsTrue(expected.GetHosts() == actual.GetHosts());
+            Assert::AreEqual(expected.GetStartTime(), actual.GetStartTime());
+            Assert::AreEqual(expected.GetEndTime(), actual.GetEndTime());
+            Assert::AreEqual(expected.GetEventCount(), actual.GetEventCount());
+            Assert::AreEqual(expected.GetAllowEventCount(), actual.GetAllowEventCount());
+            Assert::AreEqual(expected.GetDenyEventCount(), actual.GetDenyEventCount());
+            Assert::AreEqual(expected.GetSnapshotCount(), actual.GetSnapshotCount());
+            for (unsigned long i = 0; i < static_cast<unsigned long>(SketchCardinality::Count); ++i)
+            {
+                Assert::AreEqual(
+                    expected.EstimateDistinct(static_cast<SketchCardinality>(i)),
+                    actual.EstimateDistinct(static_cast<SketchCardinality>(i)));
+            }
+            for (unsigned long i = 0; i < static_cast<unsigned long>(SketchTopKeys::Count); ++i)
+            {
+                // Keys of equal counts may come out in any order.
+                std::map<std::wstring, std::pair<unsigned long long, unsigned long long>> expectedTop, actualTop;
+                for (const auto& entry : expected.GetTop(static_cast<SketchTopKeys>(i), EventSketch::DefaultTopCapacity))
+                {
+                    expectedTop[entry.name] = std::make_pair(entry.events, entry.error);
+                }
+                for (const auto& entry : actual.GetTop(static_cast<SketchTopKeys>(i), EventSketch::DefaultTopCapacity))
+                {
+                    actualTop[entry.name] = std::make_pair(entry.events, entry.error);
+                }
+                Assert::IsTrue(expectedTop == actualTop);
+                Assert::AreEqual(expected.GetTopList(static_cast<SketchTopKeys>(i)).total(), actual.GetTopList(static_cast<SketchTopKeys>(i)).total());
+            }
+            const ntl::TDigest& expectedLag = expected.GetQuantiles(SketchQuantiles::LagInMilliseconds);
+            const ntl::TDigest& actualLag = actual.GetQuantiles(SketchQuantiles::LagInMilliseconds);
+            Assert::AreEqual(expectedLag.count(), actualLag.count());
+            Assert::AreEqual(expectedLag.quantile(0.5), actualLag.quantile(0.5), 0.001);
+            Assert::AreEqual(expectedLag.maximum(), actualLag.maximum());
+        }
+
+        template <typename T>
+        void WriteValueAt(size_t offset, T value, _Inout_ std::string* data)
+        {
+            memcpy(&(*data)[offset], &value, sizeof(value));
+        }
+    }
+
+    TEST_CLASS(EventSketchTests)
+    {
+    public:
+
+        TEST_METHOD_INITIALIZE(MethodInit)
+        {
+            WCHAR directory[MAX_PATH] = L"";
+            ::GetTempPathW(MAX_PATH, directory);
+            m_Directory = directory;
+            // The recorder adds its own separator.
+            m_Directory.pop_back();
+        }
+
+        TEST_METHOD_CLEANUP(MethodCleanup)
+        {
+            for (const auto& path : m_Paths)
+            {
+                _wremove(path.c_str());
+            }
+        }
+
+        TEST_METHOD(SketchSummarizesEvents)
+        {
+            Logger::WriteMessage(L"SketchSummarizesEvents");
+
+            EventSketch sketch = MakeSketch(L"web01");
+            Assert::AreEqual(static_cast<size_t>(1), sketch.GetHosts().size());
+            Assert::AreEqual(std::string("web01"), sketch.GetHosts()[0]);
+            Assert::AreEqual(10000ull, sketch.GetEventCount());
+            Assert::AreEqual(8000ull, sketch.GetAllowEventCount());
+            Assert::AreEqual(2000ull, sketch.GetDenyEventCount());
+            Assert::AreEqual(901.0, sketch.EstimateDistinct(SketchCardinality::Sources), 30.0);
+            Assert::AreEqual(4.0, sketch.EstimateDistinct(SketchCardinality::Destinations), 0.5);
+
+            // Source 0 sends every tenth event.
+            auto sources = sketch.GetTop(SketchTopKeys::Sources, 1);
+            Assert::AreEqual(std::wstring(L"10.0.0.0"), sources[0].name);
+            Assert::IsTrue(sources[0].events - sources[0].error <= 1000ull);
+            Assert::IsTrue(sources[0].events >= 1000ull);
+
+            auto ports = sketch.GetTop(SketchTopKeys::DestinationPorts, 2);
+            Assert::AreEqual(static_cast<size_t>(2), ports.size());
+            Assert::AreEqual(5000ull, ports[0].events);
+            Assert::AreEqual(0ull, ports[0].error);
+
+            Assert::AreEqual(100.0, sketch.GetQuantiles(SketchQuantiles::LagInMilliseconds).quantile(0.5), 0.001);
+        }
+
+        TEST_METHOD(SampledEventsCountAtTheirRate)
+        {
+            Logger::WriteMessage(L"SampledEventsCountAtTheirRate");
+
+            EventSketch sketch;
+            CompactEventRecord record = MakeRecord(1, 1, 443, RuleAction::Deny);
+            record.sampleRate = 16;
+            sketch.RecordEvent(record, SketchStartTime);
+            sketch.RecordEvent(record, SketchStartTime);
+
+            Assert::AreEqual(32ull, sketch.GetEventCount());
+            Assert::AreEqual(32ull, sketch.GetDenyEventCount());
+            Assert::AreEqual(32ull, sketch.GetTop(SketchTopKeys::Rules, 1)[0].events);
+            // Distinct counts are of the events kept.
+            Assert::AreEqual(1.0, sketch.EstimateDistinct(SketchCardinality::Flows), 0.5);
+        }
+
+        TEST_METHOD(SerializedSketchRoundTrips)
+        {
+            Logger::WriteMessage(L"SerializedSketchRoundTrips");
+
+            EventSketch sketch = MakeSketch(L"web01");
+            std::string data = sketch.Serialize();
+            Assert::AreEqual(std::string("FEMSKCH1"), data.substr(0, 8));
+            Assert::AreEqual(static_cast<size_t>(0), data.size() % 8);
+            AssertSameSketch(sketch, EventSketch::Deserialize(data));
+
+            // An empty sketch round trips too.
+            EventSketch empty;
+            AssertSameSketch(empty, EventSketch::Deserialize(empty.Serialize()));
+        }
+
+        TEST_METHOD(MergeCombinesHostsAndCounts)
+        {
+            Logger::WriteMessage(L"MergeCombinesHostsAndCounts");
+
+            EventSketch merged = MakeSketch(L"web02");
+            EventSketch later = MakeSketch(L"web01");
+            later.SetSnapshot(L"web01", SketchStartTime + 300 * HundredNsPerSecond, SketchStartTime + 600 * HundredNsPerSecond);
+            merged.Merge(later);
+            merged.Merge(MakeSketch(L"web01"));
+
+            Assert::AreEqual(static_cast<size_t>(2), merged.GetHosts().size());
+            Assert::AreEqual(std::string("web01"), merged.GetHosts()[0]);
+            Assert::AreEqual(3ull, merged.GetSnapshotCount());
+            Assert::AreEqual(SketchStartTime, merged.GetStartTime());
+            Assert::AreEqual(SketchStartTime + 600 * HundredNsPerSecond, merged.GetEndTime());
+            Assert::AreEqual(30000ull, merged.GetEventCount());
+            Assert::AreEqual(6000ull, merged.GetDenyEventCount());
+            // The same sources on every host are counted once.
+            Assert::AreEqual(901.0, merged.EstimateDistinct(SketchCardinality::Sources), 30.0);
+            Assert::AreEqual(15000ull, merged.GetTop(SketchTopKeys::DestinationPorts, 1)[0].events);
+
+            // Merging into an empty sketch copies it.
+            EventSketch copy;
+            copy.Merge(merged);
+            AssertSameSketch(merged, copy);
+        }
+
+        TEST_METHOD(UnknownSectionsAreSkipped)
+        {
+            Logger::WriteMessage(L"UnknownSectionsAreSkipped");
+
+            EventSketch sketch = MakeSketch(L"web01");
+            std::string data = sketch.Serialize();
+
+            // A section of a kind added later, and a top list of a key added later.
+            uint32_t sectionCount = 0;
+            memcpy(&sectionCount, &data[12], sizeof(sectionCount));
+            WriteValueAt<uint32_t>(12, sectionCount + 2, &data);
+            std::string section(16 + 8, '\x7f');
+            WriteValueAt<uint32_t>(0, 99, &section);
+            WriteValueAt<uint32_t>(4, 0, &section);
+            WriteValueAt<uint64_t>(8, 8, &section);
+            data += section;
+            WriteValueAt<uint32_t>(0, static_cast<uint32_t>(SketchSectionKind::TopKeys), &section);
+            WriteValueAt<uint32_t>(4, 99, &section);
+            data += section;
+
+            AssertSameSketch(sketch, EventSketch::Deserialize(data));
+        }
+
+        TEST_METHOD(DamagedOrLaterSketchesAreRejected)
+        {
+            Logger::WriteMessage(L"DamagedOrLaterSketchesAreRejected");
+
+            std::string data = MakeSketch(L"web01").Serialize();
+
+            std::string badMagic(data);
+            badMagic[0] = 'X';
+            Assert::ExpectException<std::exception>([&]() { EventSketch::Deserialize(badMagic); });
+
+            std::string laterVersion(data);
+            WriteValueAt<uint32_t>(8, 2, &laterVersion);
+            Assert::ExpectException<std::exception>([&]() { EventSketch::Deserialize(laterVersion); });
+
+            for (size_t length : { static_cast<size_t>(0), static_cast<size_t>(12), data.size() / 2, data.size() - 8 })
+            {
+                Assert::ExpectException<std::exception>([&]() { EventSketch::Deserialize(data.substr(0, length)); });
+            }
+
+            // A section longer than the file.
+            std::string overlong(data);
+            WriteValueAt<uint64_t>(16 + 8, 1ull << 40, &overlong);
+            Assert::ExpectException<std::exception>([&]() { EventSketch::Deserialize(overlong); });
+        }
+
+        TEST_METHOD(RecorderWritesASketchEachInterval)
+        {
+            Logger::WriteMessage(L"RecorderWritesASketchEachInterval");
+
+            SketchRecorder recorder(m_Directory, L"web01", 60, SketchStartTime);
+            for (unsigned long i = 0; i < 100; ++i)
+            {
+                recorder.RecordEvent(MakeRecord(i, 1, 443, RuleAction::Allow), SketchStartTime);
+            }
+
+            Assert::IsFalse(recorder.WriteIfDue(SketchStartTime + 59 * HundredNsPerSecond));
+            Assert::IsTrue(recorder.WriteIfDue(SketchStartTime + 60 * HundredNsPerSecond));
+            std::wstring first = m_Directory + L"\\" + SketchRecorder::FileName(L"web01", SketchStartTime);
+            m_Paths.push_back(first);
+            Assert::AreEqual(std::wstring(L"web01.20170907-224228.000.sketch"), SketchRecorder::FileName(L"web01", SketchStartTime));
+
+            // The next interval starts empty, and is cut short when the session closes.
+            recorder.RecordEvent(MakeRecord(1, 1, 443, RuleAction::Deny), SketchStartTime);
+            std::wstring second = recorder.Write(SketchStartTime + 90 * HundredNsPerSecond);
+            m_Paths.push_back(second);
+            Assert::AreEqual(m_Directory + L"\\" + SketchRecorder::FileName(L"web01", SketchStartTime + 60 * HundredNsPerSecond), second);
+            Assert::AreEqual(2ull, recorder.GetSnapshotsWritten());
+            Assert::AreEqual(0ull, recorder.GetWriteFailures());
+
+            EventSketch sketch = EventSketch::ReadFile(first);
+            Assert::AreEqual(100ull, sketch.GetEventCount());
+            Assert::AreEqual(SketchStartTime, sketch.GetStartTime());
+            Assert::AreEqual(SketchStartTime + 60 * HundredNsPerSecond, sketch.GetEndTime());
+            Assert::AreEqual(std::string("web01"), sketch.GetHosts()[0]);
+
+            sketch.Merge(EventSketch::ReadFile(second));
+            Assert::AreEqual(101ull, sketch.GetEventCount());
+            Assert::AreEqual(1ull, sketch.GetDenyEventCount());
+            Assert::AreEqual(2ull, sketch.GetSnapshotCount());
+            Assert::IsTrue(recorder.GetBytesWritten() > 0);
+        }
+
+        TEST_METHOD(RecorderCountsFailedWrites)
+        {
+            Logger::WriteMessage(L"RecorderCountsFailedWrites");
+
+            SketchRecorder recorder(m_Directory + L"\\EventSketchTestsMissing\\Directory", L"web01", 60, SketchStartTime);
+            Assert::AreEqual(std::wstring(), recorder.Write(SketchStartTime + 60 * HundredNsPerSecond));
+            Assert::AreEqual(1ull, recorder.GetWriteFailures());
+            Assert::AreEqual(0ull, recorder.GetSnapshotsWritten());
+        }
+
+    private:
+        std::wstring m_Directory;
+        std::vector<std::wstring> m_Paths;
+    };
+}
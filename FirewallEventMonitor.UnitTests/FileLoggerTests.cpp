@@ -1,61 +1,266 @@
-// Copyright (c) Microsoft Corporation. All rights reserved.
-// Licensed under the MIT License. See License.txt in the project root for license information.
-
-#include <CppUnitTest.h>
-// code under test headers
-#include "FirewallCaptureSession.h"
-// c++ headers
-#include <memory>
-#include <fstream>
-
-using namespace Microsoft::VisualStudio::CppUnitTestFramework;
-using namespace FirewallEventMonitor;
-
-namespace FirewallEventMonitorUnitTest
-{
-    TEST_CLASS(FileLoggerTests)
-    {
-    public:
-
-        TEST_METHOD_INITIALIZE(MethodInit)
-        {
-            m_FileLogger = std::make_shared<FileLogger>(L"");
-        }
-
-        TEST_METHOD(LogDirectoryContainsTestDirectory)
-        {
-            Logger::WriteMessage(L"LogDirectoryContainsTestDirectory");
-
-            std::wstring logFilePath = m_FileLogger->GetLogDirectory();
-            Logger::WriteMessage(logFilePath.c_str());
-
-            // Does dir match expected?
-            std::wstring expectedDirectory = L"FirewallEventMonitor.UnitTests";
-            std::size_t found = logFilePath.find(expectedDirectory);
-            if (found == std::string::npos)
-            {
-                Logger::WriteMessage(L"Expected directory missing.");
-                Assert::IsTrue(false);
-            }
-        }
-
-        TEST_METHOD(LogFileCreateSuccess)
-        {
-            Logger::WriteMessage(L"LogFileOpenCloseSuccess");
-
-            m_FileLogger->CreateLogFile();
-            m_FileLogger->CloseLogFile();
-
-            bool foundLogFile = false;
-            std::ifstream my_file(m_FileLogger->GetLogFilePath());
-            if (my_file.good())
-            {
-                foundLogFile = true;
-            }
-            Assert::IsTrue(foundLogFile);
-        }
-
-    private:
-        std::shared_ptr<FileLogger> m_FileLogger;
-    };
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include <CppUnitTest.h>
+// code under test headers
+#include "FirewallCaptureSession.h"
+// c++ headers
+#include <memory>
+#include <fstream>
+#include <string>
+// ntl headers
+#include "ntlCrc32.hpp"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace FirewallEventMonitor;
+
+namespace FirewallEventMonitorUnitTest
+{
+    TEST_CLASS(FileLoggerTests)
+    {
+    public:
+
+        TEST_METHOD_INITIALIZE(MethodInit)
+        {
+            m_FileLogger = std::make_shared<FileLogger>(L"");
+        }
+
+        TEST_METHOD(LogDirectoryContainsTestDirectory)
+        {
+            Logger::WriteMessage(L"LogDirectoryContainsTestDirectory");
+
+            std::wstring logFilePath = m_FileLogger->GetLogDirectory();
+            Logger::WriteMessage(logFilePath.c_str());
+
+            // Does dir match expected?
+            std::wstring expectedDirectory = L"FirewallEventMonitor.UnitTests";
+            std::size_t found = logFilePath.find(expectedDirectory);
+            if (found == std::string::npos)
+            {
+                Logger::WriteMessage(L"Expected directory missing.");
+                Assert::IsTrue(false);
+            }
+        }
+
+        TEST_METHOD(LogFileCreateSuccess)
+        {
+            Logger::WriteMessage(L"LogFileOpenCloseSuccess");
+
+            m_FileLogger->CreateLogFile();
+            m_FileLogger->CloseLogFile();
+
+            bool foundLogFile = false;
+            std::ifstream my_file(m_FileLogger->GetLogFilePath());
+            if (my_file.good())
+            {
+                foundLogFile = true;
+            }
+            Assert::IsTrue(foundLogFile);
+        }
+
+        TEST_METHOD(Crc32MatchesStandardCheckValue)
+        {
+            Logger::WriteMessage(L"Crc32MatchesStandardCheckValue");
+
+            Assert::AreEqual(0xCBF43926ul, ntl::Crc32::update(0, "123456789", 9));
+            // Continuing a CRC gives the same value as one pass.
+            Assert::AreEqual(0xCBF43926ul, ntl::Crc32::update(ntl::Crc32::update(0, "1234", 4), "56789", 5));
+        }
+
+        TEST_METHOD(DurableLogEndsEachGroupWithCommitRecord)
+        {
+            Logger::WriteMessage(L"DurableLogEndsEachGroupWithCommitRecord");
+
+            FileLogger fileLogger(TempDirectory());
+            fileLogger.EnableDurableWrites(60000, FileLogger::DefaultCommitBytes);
+            fileLogger.CreateLogFile();
+            fileLogger.Write(L"a\nb\n");
+            fileLogger.Commit();
+            fileLogger.Write(L"c\n");
+            fileLogger.CloseLogFile();
+
+            Assert::AreEqual(
+                std::string("a\r\nb\r\n#commit 0 6 fb6fd194\r\nc\r\n#commit 1 3 e0ab3b38\r\n"),
+                ReadFile(fileLogger.GetLogFilePath()));
+            DurabilityReport report = fileLogger.GetDurabilityReport();
+            Assert::AreEqual(2ull, report.commits);
+            Assert::AreEqual(9ull, report.bytesCommitted);
+            _wremove(fileLogger.GetLogFilePath().c_str());
+        }
+
+        TEST_METHOD(DurableLogCommitsOnceGroupReachesByteLimit)
+        {
+            Logger::WriteMessage(L"DurableLogCommitsOnceGroupReachesByteLimit");
+
+            FileLogger fileLogger(TempDirectory());
+            fileLogger.EnableDurableWrites(60000, 10);
+            fileLogger.CreateLogFile();
+            fileLogger.Write(L"12345\n");
+            Assert::AreEqual(0ull, fileLogger.GetDurabilityReport().commits);
+            fileLogger.Write(L"12345\n");
+            fileLogger.Write(L"12345\n");
+
+            DurabilityReport report = fileLogger.GetDurabilityReport();
+            Assert::AreEqual(1ull, report.commits);
+            Assert::AreEqual(static_cast<size_t>(7), report.pendingBytes);
+            fileLogger.CloseLogFile();
+            _wremove(fileLogger.GetLogFilePath().c_str());
+        }
+
+        TEST_METHOD(RecoveryRemovesTailAfterLastCommit)
+        {
+            Logger::WriteMessage(L"RecoveryRemovesTailAfterLastCommit");
+
+            std::wstring path = WriteDurableLog();
+            std::string committed = ReadFile(path);
+            AppendFile(path, "[20170907 224228] Inbound Allow rule st");
+
+            Assert::AreEqual(39ull, FileLogger::RecoverLogFile(path));
+            Assert::AreEqual(committed, ReadFile(path));
+            // A recovered log is left as it is.
+            Assert::AreEqual(0ull, FileLogger::RecoverLogFile(path));
+            _wremove(path.c_str());
+        }
+
+        TEST_METHOD(RecoveryStopsAtGroupThatFailsItsCheck)
+        {
+            Logger::WriteMessage(L"RecoveryStopsAtGroupThatFailsItsCheck");
+
+            std::wstring path = WriteDurableLog();
+            std::string contents = ReadFile(path);
+            size_t firstCommitEnd = contents.find("\r\n", contents.find("#commit 0")) + 2;
+            // Damage the second group.
+            contents[firstCommitEnd] = 'X';
+            WriteFile(path, contents);
+
+            FileLogger::RecoverLogFile(path);
+            Assert::AreEqual(contents.substr(0, firstCommitEnd), ReadFile(path));
+            _wremove(path.c_str());
+        }
+
+        TEST_METHOD(RecoveryLeavesLogsWithoutCommitRecordsAlone)
+        {
+            Logger::WriteMessage(L"RecoveryLeavesLogsWithoutCommitRecordsAlone");
+
+            FileLogger fileLogger(TempDirectory());
+            fileLogger.CreateLogFile();
+            fileLogger.Write(L"[20170907 224228] Inbound Allow rule status = 0x0\n");
+            fileLogger.CloseLogFile();
+
+            Assert::AreEqual(0ull, FileLogger::RecoverLogFile(fileLogger.GetLogFilePath()));
+            _wremove(fileLogger.GetLogFilePath().c_str());
+        }
+
+        TEST_METHOD(MappedLogHoldsWritesAsUtf8AndIsTrimmedOnClose)
+        {
+            Logger::WriteMessage(L"MappedLogHoldsWritesAsUtf8AndIsTrimmedOnClose");
+
+            FileLogger fileLogger(TempDirectory());
+            fileLogger.EnableMappedWrites(MappedLogFile::DefaultSegmentBytes);
+            fileLogger.CreateLogFile();
+            Assert::IsTrue(fileLogger.IsLogFileOpen());
+            Assert::IsTrue(fileLogger.GetLogFile() == NULL);
+            fileLogger.Write(L"a\nb\n");
+            fileLogger.Write(L"caf\u00e9\n");
+            fileLogger.CloseLogFile();
+
+            Assert::IsFalse(fileLogger.IsLogFileOpen());
+            Assert::AreEqual(std::string("a\r\nb\r\ncaf\xc3\xa9\r\n"), ReadFile(fileLogger.GetLogFilePath()));
+            _wremove(fileLogger.GetLogFilePath().c_str());
+        }
+
+        TEST_METHOD(MappedWritesCannotBeCombinedWithDurableWrites)
+        {
+            Logger::WriteMessage(L"MappedWritesCannotBeCombinedWithDurableWrites");
+
+            FileLogger fileLogger(TempDirectory());
+            fileLogger.EnableMappedWrites(MappedLogFile::DefaultSegmentBytes);
+            Assert::ExpectException<std::exception>([&]() {
+                fileLogger.EnableDurableWrites(FileLogger::DefaultCommitIntervalInMilliseconds, FileLogger::DefaultCommitBytes);
+            });
+        }
+
+        TEST_METHOD(OverlappedLogWritesPartBufferOnCommitIfDue)
+        {
+            Logger::WriteMessage(L"OverlappedLogWritesPartBufferOnCommitIfDue");
+
+            FileLogger fileLogger(TempDirectory());
+            fileLogger.EnableOverlappedWrites(OverlappedLogFile::DefaultBufferBytes, OverlappedLogFile::DefaultBufferCount);
+            Assert::ExpectException<std::exception>([&]() {
+                fileLogger.EnableMappedWrites(MappedLogFile::DefaultSegmentBytes);
+            });
+            fileLogger.CreateLogFile();
+            Assert::IsTrue(fileLogger.IsOverlapped());
+            Assert::IsTrue(fileLogger.GetLogFile() == NULL);
+            fileLogger.Write(L"a\nb\n");
+            fileLogger.Write(L"caf\u00e9\n");
+            fileLogger.CommitIfDue();
+            Assert::AreEqual(1ull, fileLogger.GetOverlappedWriteReport().writesIssued);
+            fileLogger.Write(L"next\n");
+            fileLogger.CloseLogFile();
+
+            // Totals outlive the file.
+            OverlappedWriteReport report = fileLogger.GetOverlappedWriteReport();
+            Assert::AreEqual(2ull, report.writesIssued);
+            Assert::AreEqual(19ull, report.bytesCompleted);
+            Assert::AreEqual(0ull, report.writeErrors);
+            Assert::AreEqual(std::string("a\r\nb\r\ncaf\xc3\xa9\r\nnext\r\n"), ReadFile(fileLogger.GetLogFilePath()));
+            _wremove(fileLogger.GetLogFilePath().c_str());
+        }
+
+    private:
+        std::shared_ptr<FileLogger> m_FileLogger;
+
+        static std::wstring TempDirectory()
+        {
+            WCHAR directory[MAX_PATH] = L"";
+            DWORD length = ::GetTempPathW(MAX_PATH, directory);
+            // The logger adds the separator.
+            return std::wstring(directory, length > 0 ? length - 1 : 0);
+        }
+
+        // A closed durable log of two groups.
+        static std::wstring WriteDurableLog()
+        {
+            FileLogger fileLogger(TempDirectory());
+            fileLogger.EnableDurableWrites(60000, FileLogger::DefaultCommitBytes);
+            fileLogger.CreateLogFile();
+            fileLogger.Write(L"[20170907 224228] Inbound Allow rule status = 0x0\n");
+            fileLogger.Commit();
+            fileLogger.Write(L"[20170907 224229] Inbound Deny rule status = 0x0\n");
+            fileLogger.CloseLogFile();
+            return fileLogger.GetLogFilePath();
+        }
+
+        static std::string ReadFile(const std::wstring& path)
+        {
+            FILE* file = NULL;
+            Assert::AreEqual(0, _wfopen_s(&file, path.c_str(), L"rb"));
+            std::string contents;
+            char buffer[4096];
+            size_t read = 0;
+            while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+            {
+                contents.append(buffer, read);
+            }
+            fclose(file);
+            return contents;
+        }
+
+        static void WriteFile(const std::wstring& path, const std::string& contents)
+        {
+            FILE* file = NULL;
+            Assert::AreEqual(0, _wfopen_s(&file, path.c_str(), L"wb"));
+            fwrite(contents.data(), 1, contents.size(), file);
+            fclose(file);
+        }
+
+        static void AppendFile(const std::wstring& path, const std::string& contents)
+        {
+            FILE* file = NULL;
+            Assert::AreEqual(0, _wfopen_s(&file, path.c_str(), L"ab"));
+            fwrite(contents.data(), 1, contents.size(), file);
+            fclose(file);
+        }
+    };
 }
\ No newline at end of file
@@ -1,103 +1,132 @@
-// Copyright (c) Microsoft Corporation. All rights reserved.
-// Licensed under the MIT License. See License.txt in the project root for license information.
-
-#include <CppUnitTest.h>
-// code under test headers
-#include "FirewallCaptureSession.h"
-// c++ headers
-#include <memory>
-
-using namespace Microsoft::VisualStudio::CppUnitTestFramework;
-using namespace FirewallEventMonitor;
-
-namespace FirewallEventMonitorUnitTest
-{
-    TEST_CLASS(FirewallCaptureSessionTests)
-    {
-    public:
-
-        TEST_METHOD_INITIALIZE(MethodInit)
-        {
-            m_Params.outputToConsole = false;
-        }
-
-        TEST_METHOD(EmptyFilterListMatchesAnyAddress)
-        {
-            Logger::WriteMessage(L"EmptyFilterListMatchesAnyAddress");
-
-            m_Params.ipAddressFilters.clear();
-            FirewallCaptureSession reader(m_Params);
-            bool result = reader.MatchIpAddressFilter(correctAddress);
-
-            Assert::IsTrue(result);
-        }
-
-        TEST_METHOD(FilterMatchesCorrectAddress)
-        {
-            Logger::WriteMessage(L"FilterMatchesCorrectAddress");
-
-            m_Params.ipAddressFilters.clear();
-            m_Params.ipAddressFilters.push_back(correctAddress);
-            FirewallCaptureSession reader(m_Params);
-            bool result = reader.MatchIpAddressFilter(correctAddress);
-
-            Assert::IsTrue(result);
-        }
-
-        TEST_METHOD(FilterDropsIncorrectAddress)
-        {
-            Logger::WriteMessage(L"FilterDropsIncorrectAddress");
-
-            m_Params.ipAddressFilters.clear();
-            m_Params.ipAddressFilters.push_back(correctAddress);
-            FirewallCaptureSession reader(m_Params);
-            bool result = reader.MatchIpAddressFilter(incorrectAddress);
-
-            Assert::IsFalse(result);
-        }
-
-        TEST_METHOD(EmptyFilterListMatchesAnyRule)
-        {
-            Logger::WriteMessage(L"EmptyFilterListMatchesAnyRule");
-
-            m_Params.ruleIdFilters.clear();
-            FirewallCaptureSession reader(m_Params);
-            bool result = reader.MatchRuleIdFilter(correctRuleId);
-
-            Assert::IsTrue(result);
-        }
-
-        TEST_METHOD(FilterMatchesCorrectRule)
-        {
-            Logger::WriteMessage(L"FilterMatchesCorrectRule");
-
-            m_Params.ruleIdFilters.clear();
-            m_Params.ruleIdFilters.push_back(correctRuleId);
-            FirewallCaptureSession reader(m_Params);
-            bool result = reader.MatchRuleIdFilter(correctRuleId);
-
-            Assert::IsTrue(result);
-        }
-
-        TEST_METHOD(FilterDropsIncorrectRule)
-        {
-            Logger::WriteMessage(L"FilterDropsIncorrectRule");
-
-            m_Params.ruleIdFilters.clear();
-            m_Params.ruleIdFilters.push_back(correctRuleId);
-            FirewallCaptureSession reader(m_Params);
-            bool result = reader.MatchRuleIdFilter(incorrectRuleId);
-
-            Assert::IsFalse(result);
-        }
-
-    private:
-        Parameters m_Params;
-
-        std::wstring correctAddress = L"100.100.100.100";
-        std::wstring incorrectAddress = L"200.200.200.200";
-
-        std::wstring correctRuleId = L"29959cda-8d97-48ea-92ce-4c0164aac7f4";
-        std::wstring incorrectRuleId = L"1bd92312-2f5d-447b-b2b3-90edc728b374";
-    };
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include <CppUnitTest.h>
+// code under test headers
+#include "FirewallCaptureSession.h"
+// c++ headers
+#include <memory>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace FirewallEventMonitor;
+
+namespace FirewallEventMonitorUnitTest
+{
+    TEST_CLASS(FirewallCaptureSessionTests)
+    {
+    public:
+
+        TEST_METHOD_INITIALIZE(MethodInit)
+        {
+            m_Params.outputToConsole = false;
+        }
+
+        TEST_METHOD(EmptyFilterListMatchesAnyAddress)
+        {
+            Logger::WriteMessage(L"EmptyFilterListMatchesAnyAddress");
+
+            m_Params.ipAddressFilters.clear();
+            FirewallCaptureSession reader(m_Params);
+            bool result = reader.MatchFilters(MakeRecord(incorrectAddress, correctRuleId));
+
+            Assert::IsTrue(result);
+        }
+
+        TEST_METHOD(FilterMatchesCorrectAddress)
+        {
+            Logger::WriteMessage(L"FilterMatchesCorrectAddress");
+
+            m_Params.ipAddressFilters.clear();
+            m_Params.ipAddressFilters.push_back(correctAddress);
+            FirewallCaptureSession reader(m_Params);
+            bool result = reader.MatchFilters(MakeRecord(correctAddress, correctRuleId));
+
+            Assert::IsTrue(result);
+        }
+
+        TEST_METHOD(FilterDropsIncorrectAddress)
+        {
+            Logger::WriteMessage(L"FilterDropsIncorrectAddress");
+
+            m_Params.ipAddressFilters.clear();
+            m_Params.ipAddressFilters.push_back(correctAddress);
+            FirewallCaptureSession reader(m_Params);
+            bool result = reader.MatchFilters(MakeRecord(incorrectAddress, correctRuleId));
+
+            Assert::IsFalse(result);
+        }
+
+        TEST_METHOD(EmptyFilterListMatchesAnyRule)
+        {
+            Logger::WriteMessage(L"EmptyFilterListMatchesAnyRule");
+
+            m_Params.ruleIdFilters.clear();
+            FirewallCaptureSession reader(m_Params);
+            bool result = reader.MatchFilters(MakeRecord(correctAddress, incorrectRuleId));
+
+            Assert::IsTrue(result);
+        }
+
+        TEST_METHOD(FilterMatchesCorrectRule)
+        {
+            Logger::WriteMessage(L"FilterMatchesCorrectRule");
+
+            m_Params.ruleIdFilters.clear();
+            m_Params.ruleIdFilters.push_back(correctRuleId);
+            FirewallCaptureSession reader(m_Params);
+            bool result = reader.MatchFilters(MakeRecord(correctAddress, correctRuleId));
+
+            Assert::IsTrue(result);
+        }
+
+        TEST_METHOD(FilterDropsIncorrectRule)
+        {
+            Logger::WriteMessage(L"FilterDropsIncorrectRule");
+
+            m_Params.ruleIdFilters.clear();
+            m_Params.ruleIdFilters.push_back(correctRuleId);
+            FirewallCaptureSession reader(m_Params);
+            bool result = reader.MatchFilters(MakeRecord(correctAddress, incorrectRuleId));
+
+            Assert::IsFalse(result);
+        }
+
+        TEST_METHOD(FiltersCompareBinaryAddressesAndRules)
+        {
+            Logger::WriteMessage(L"FiltersCompareBinaryAddressesAndRules");
+
+            m_Params.ipAddressFilters.push_back(L"2001:db8::1");
+            m_Params.ruleIdFilters.push_back(correctRuleId);
+            FirewallCaptureSession reader(m_Params);
+
+            CompactEventRecord record;
+            bool isIpv6 = false;
+            ParseAddress(incorrectAddress, &record.source, &isIpv6);
+            ParseAddress(L"2001:0DB8:0:0::0001", &record.destination, &isIpv6);
+            ParseGuid(L"29959CDA-8D97-48EA-92CE-4C0164AAC7F4", &record.ruleId);
+            Assert::IsTrue(reader.MatchFilters(record));
+
+            ParseGuid(incorrectRuleId, &record.ruleId);
+            Assert::IsFalse(reader.MatchFilters(record));
+        }
+
+    private:
+        Parameters m_Params;
+
+        std::wstring correctAddress = L"100.100.100.100";
+        std::wstring incorrectAddress = L"200.200.200.200";
+
+        std::wstring correctRuleId = L"29959cda-8d97-48ea-92ce-4c0164aac7f4";
+        std::wstring incorrectRuleId = L"1bd92312-2f5d-447b-b2b3-90edc728b374";
+
+        // Both ends at the address: an event without an address would pass on that side.
+        static CompactEventRecord MakeRecord(const std::wstring& address, const std::wstring& ruleId)
+        {
+            CompactEventRecord record;
+            ParseAddress(address, &record.source, &record.isIpv6);
+            ParseAddress(address, &record.destination, &record.isIpv6);
+            ParseGuid(ruleId, &record.ruleId);
+            return record;
+        }
+    };
 }
\ No newline at end of file
@@ -1,157 +1,254 @@
-// Copyright (c) Microsoft Corporation. All rights reserved.
-// Licensed under the MIT License. See License.txt in the project root for license information.
-
-#include <CppUnitTest.h>
-// code under test headers
-#include "FirewallCaptureSession.h"
-// c++ headers
-#include <memory>
-#include <fstream>
-
-using namespace Microsoft::VisualStudio::CppUnitTestFramework;
-using namespace FirewallEventMonitor;
-
-namespace FirewallEventMonitorUnitTest
-{
-    TEST_CLASS(FirewallEtwTraceCallbackTests)
-    {
-    public:
-
-        TEST_METHOD_INITIALIZE(MethodInit)
-        {
-            Logger::WriteMessage(L"MethodInit");
-
-            m_Params.outputToFile = true;
-            m_Params.outputToConsole = false;
-
-            m_EventCounter = std::make_shared<EventCounter>(10000);
-            m_Timer = std::make_shared<Timer>(-1);
-            m_FileLogger = std::make_shared<FileLogger>(L"");
-            m_Reader = std::make_shared<FirewallCaptureSession>(m_Params);
-            m_Callback = std::make_shared<FirewallEtwTraceCallback>(
-                std::weak_ptr<FirewallCaptureSession>(m_Reader),
-                m_Params,
-                m_FileLogger,
-                m_Timer,
-                m_EventCounter);
-
-            // Read EtwRecord from test file.
-            std::wstring file = L"..\\..\\..\\TestTraceSession.etl";
-            queryEvents.OpenSavedSession(file.c_str());
-            queryEvents.WaitForSession();
-
-            // Query for desired allow/block events.
-            ntl::EtwRecordQuery query;
-            query.matchProviderId(VFP_PROVIDER_GUID);
-            query.matchEventId(400);
-            query.matchEventId(401);
-            query.matchEventId(402);
-
-            if (!queryEvents.FindFirstEvent(query, m_testRecord))
-            {
-                Logger::WriteMessage(L"Unable to find any event in test ETL file.");
-                Assert::IsTrue(false);
-            }
-        }
-
-        TEST_METHOD(LogFileContainsDate)
-        {
-            Logger::WriteMessage(L"LogFileContainsDate");
-
-            std::wstring wdate = L"977db5ea6528";
-            std::string date = std::string(wdate.begin(), wdate.end());
-            
-            VfpEventData eventData;
-            eventData.date = wdate;
-
-            std::ofstream out;
-            out.open("test.txt");
-
-            m_FileLogger->CreateLogFile();
-            m_Callback->OutputToFile(eventData);
-            m_FileLogger->CloseLogFile();
-            
-            // Search file for code
-            bool outputContainsVal = false;
-            std::wstring filePath = m_FileLogger->GetLogFilePath();
-            std::ifstream fileInput;
-            fileInput.open(filePath.c_str(), std::ios::in);
-            while (fileInput)
-            {
-                std::string line;
-                fileInput >> line;
-
-                std::size_t found = line.find(date);
-
-                if (found != std::string::npos)
-                {
-                    std::string write = "Found: " + line;
-                    Logger::WriteMessage(write.c_str());
-
-                    outputContainsVal = true;
-                }
-            }
-
-            Assert::IsTrue(outputContainsVal);
-        }
-
-        TEST_METHOD(CollectEventDataReturnsDate)
-        {
-            Logger::WriteMessage(L"CollectEventDataReturnsDate");
-
-            VfpEventData eventData = m_Callback->CollectEventData(m_testRecord);
-
-            // Does date match expected?
-            std::wstring expectedDate = L"20170914";
-            std::size_t found = eventData.date.find(expectedDate);
-            if (found == std::string::npos)
-            {
-                Assert::IsTrue(false);
-            }
-        }
-
-        TEST_METHOD(ProcessEventRecordReturnsTrue)
-        {
-            Logger::WriteMessage(L"ProcessEventRecordReturnsTrue");
-
-            bool result = m_Callback->ProcessEventRecord(m_testRecord);
-            Assert::IsTrue(result);
-        }
-
-        TEST_METHOD(ProcessEventRecordFiltersEventId)
-        {
-            Logger::WriteMessage(L"ProcessEventRecordFiltersEventId");
-
-            // Query for wrong event.
-            ntl::EtwRecordQuery query;
-            query.matchProviderId(VFP_PROVIDER_GUID);
-            query.matchEventId(110);
-
-            ntl::EtwRecord wrongRecord;
-            if (!queryEvents.FindFirstEvent(query, wrongRecord))
-            {
-                Logger::WriteMessage(L"Unable to find any event in test ETL file.");
-                Assert::IsTrue(false);
-            }
-
-            bool result = m_Callback->ProcessEventRecord(wrongRecord);
-            Assert::IsFalse(result);
-        }
-
-    private:
-        Parameters m_Params;
-        std::shared_ptr<Timer> m_Timer;
-        std::shared_ptr<EventCounter> m_EventCounter;
-        std::shared_ptr<FileLogger> m_FileLogger;
-        std::shared_ptr<FirewallCaptureSession> m_Reader;
-        std::shared_ptr<FirewallEtwTraceCallback> m_Callback;
-        
-        ntl::EtwReader<> queryEvents;
-        GUID VFP_PROVIDER_GUID = {
-            0x9F2660EA,
-            0xCFE7,
-            0x428F,
-            { 0x98, 0x50, 0xAE, 0xCA, 0x61, 0x26, 0x19, 0xB0 } };
-        ntl::EtwRecord m_testRecord;
-    };
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include <CppUnitTest.h>
+// code under test headers
+#include "FirewallCaptureSession.h"
+// c++ headers
+#include <memory>
+#include <fstream>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace FirewallEventMonitor;
+
+namespace FirewallEventMonitorUnitTest
+{
+    TEST_CLASS(FirewallEtwTraceCallbackTests)
+    {
+    public:
+
+        TEST_METHOD_INITIALIZE(MethodInit)
+        {
+            Logger::WriteMessage(L"MethodInit");
+
+            m_Params.outputToFile = true;
+            m_Params.outputToConsole = false;
+
+            m_EventCounter = std::make_shared<EventCounter>(10000);
+            m_Timer = std::make_shared<Timer>(-1);
+            m_FileLogger = std::make_shared<FileLogger>(L"");
+            m_Reader = std::make_shared<FirewallCaptureSession>(m_Params);
+            m_Callback = std::make_shared<FirewallEtwTraceCallback>(
+                std::weak_ptr<FirewallCaptureSession>(m_Reader),
+                m_Params,
+                m_FileLogger,
+                m_Timer,
+                m_EventCounter);
+
+            // Read EtwRecord from test file.
+            std::wstring file = L"..\\..\\..\\TestTraceSession.etl";
+            queryEvents.OpenSavedSession(file.c_str());
+            queryEvents.WaitForSession();
+
+            // Query for desired allow/block events.
+            ntl::EtwRecordQuery query;
+            query.matchProviderId(VFP_PROVIDER_GUID);
+            query.matchEventId(400);
+            query.matchEventId(401);
+            query.matchEventId(402);
+
+            if (!queryEvents.FindFirstEvent(query, m_testRecord))
+            {
+                Logger::WriteMessage(L"Unable to find any event in test ETL file.");
+                Assert::IsTrue(false);
+            }
+        }
+
+        TEST_METHOD(LogFileContainsDate)
+        {
+            Logger::WriteMessage(L"LogFileContainsDate");
+
+            std::wstring wdate = L"977db5ea6528";
+            std::string date = std::string(wdate.begin(), wdate.end());
+            
+            VfpEventData eventData;
+            eventData.date = wdate;
+
+            std::ofstream out;
+            out.open("test.txt");
+
+            m_FileLogger->CreateLogFile();
+            m_Callback->OutputToFile(eventData);
+            m_FileLogger->CloseLogFile();
+            
+            // Search file for code
+            bool outputContainsVal = false;
+            std::wstring filePath = m_FileLogger->GetLogFilePath();
+            std::ifstream fileInput;
+            fileInput.open(filePath.c_str(), std::ios::in);
+            while (fileInput)
+            {
+                std::string line;
+                fileInput >> line;
+
+                std::size_t found = line.find(date);
+
+                if (found != std::string::npos)
+                {
+                    std::string write = "Found: " + line;
+                    Logger::WriteMessage(write.c_str());
+
+                    outputContainsVal = true;
+                }
+            }
+
+            Assert::IsTrue(outputContainsVal);
+        }
+
+        TEST_METHOD(FormatEventWritesLogLayout)
+        {
+            Logger::WriteMessage(L"FormatEventWritesLogLayout");
+
+            VfpEventData eventData;
+            eventData.date = L"20170907";
+            eventData.time = L"224228";
+            eventData.direction = L"Inbound";
+            eventData.ruleType = L"Allow";
+            eventData.status = L"0x0";
+            eventData.portId = L"4";
+            eventData.portName = L"07312833-61E0-4D4E-BB4C-BFC46E86D345";
+            eventData.portFriendlyName = L"NULL";
+            eventData.source = L"192.168.100.21";
+            eventData.destination = L"192.168.100.22";
+            eventData.protocol = L"TCP";
+            eventData.sourcePort = L"50000";
+            eventData.destinationPort = L"443";
+            eventData.compact.sampleRate = 16;
+            eventData.ruleId = L"43cff06e-a520-4ad3-9fd9-1894f4a3489b";
+            eventData.layerId = L"FW_CONTROLLER_LAYER_ID";
+            eventData.groupId = L"FW_GROUP_IPv4_IN_ID";
+            eventData.gftFlags = L"0";
+
+            std::wstring text = L"previous ";
+            FirewallEtwTraceCallback::FormatEvent(eventData, &text);
+
+            Assert::AreEqual(
+                std::wstring(
+                    L"previous [20170907 224228] Inbound Allow rule status = 0x0 \n"
+                    L"  port {id = 4, portName = 07312833-61E0-4D4E-BB4C-BFC46E86D345, portFriendlyName = NULL} \n"
+                    L"  flow {src = 192.168.100.21, dst = 192.168.100.22, protocol = TCP, srcPort = 50000, dstPort = 443, sampleRate = 1/16} \n"
+                    L"  rule {id = 43cff06e-a520-4ad3-9fd9-1894f4a3489b, layer = FW_CONTROLLER_LAYER_ID, group = FW_GROUP_IPv4_IN_ID, gftFlags = 0} \n\n"),
+                text);
+        }
+
+        TEST_METHOD(FormatEventJsonWritesOneEscapedLine)
+        {
+            Logger::WriteMessage(L"FormatEventJsonWritesOneEscapedLine");
+
+            VfpEventData eventData;
+            eventData.date = L"20170907";
+            eventData.time = L"224228";
+            eventData.direction = L"Inbound";
+            eventData.ruleType = L"Deny";
+            eventData.status = L"STATUS_SUCCESS";
+            eventData.portId = L"4";
+            eventData.portName = L"vm\\nic";
+            eventData.portFriendlyName = L"say \"hi\"\t";
+            eventData.source = L"192.168.100.21";
+            eventData.destination = L"192.168.100.22";
+            eventData.protocol = L"ICMPv4";
+            eventData.icmpType = L"V4EchoRequest";
+            eventData.ruleId = L"43cff06e-a520-4ad3-9fd9-1894f4a3489b";
+            eventData.layerId = L"FW_CONTROLLER_LAYER_ID";
+            eventData.groupId = L"FW_GROUP_IPv4_IN_ID";
+            eventData.gftFlags = L"0";
+
+            std::wstring text;
+            FirewallEtwTraceCallback::FormatEventJson(eventData, &text);
+
+            Assert::AreEqual(
+                std::wstring(
+                    L"{\"date\":\"20170907\",\"time\":\"224228\",\"direction\":\"Inbound\",\"ruleType\":\"Deny\",\"status\":\"STATUS_SUCCESS\","
+                    L"\"portId\":\"4\",\"portName\":\"vm\\\\nic\",\"portFriendlyName\":\"say \\\"hi\\\"\\t\","
+                    L"\"src\":\"192.168.100.21\",\"dst\":\"192.168.100.22\",\"protocol\":\"ICMPv4\",\"icmpType\":\"V4EchoRequest\","
+                    L"\"ruleId\":\"43cff06e-a520-4ad3-9fd9-1894f4a3489b\",\"layerId\":\"FW_CONTROLLER_LAYER_ID\",\"groupId\":\"FW_GROUP_IPv4_IN_ID\",\"gftFlags\":\"0\"}\n"),
+                text);
+        }
+
+        TEST_METHOD(FormatEventSyslogWritesRfc5424Message)
+        {
+            Logger::WriteMessage(L"FormatEventSyslogWritesRfc5424Message");
+
+            VfpEventData eventData;
+            eventData.compact.action = RuleAction::Deny;
+            eventData.compact.timeStamp = 131492977481230000LL; // 2017-09-07T22:42:28.123Z
+            eventData.direction = L"Inbound";
+            eventData.ruleType = L"Deny";
+            eventData.portFriendlyName = L"vm [1] \"web\"";
+            eventData.source = L"192.168.100.21";
+            eventData.destination = L"192.168.100.22";
+            eventData.protocol = L"TCP";
+            eventData.destinationPort = L"443";
+
+            std::wstring text;
+            FirewallEtwTraceCallback::FormatEventSyslog(eventData, &text);
+
+            // Facility local0, severity Warning.
+            Assert::AreEqual(static_cast<size_t>(0), text.find(L"<132>1 2017-09-07T22:42:28.123Z "));
+            Assert::IsTrue(text.find(L" FirewallEventMonitor ") != std::wstring::npos);
+            Assert::IsTrue(text.find(
+                L" Deny [vfp@32473 direction=\"Inbound\" ruleType=\"Deny\" portFriendlyName=\"vm [1\\] \\\"web\\\"\" "
+                L"src=\"192.168.100.21\" dst=\"192.168.100.22\" protocol=\"TCP\" dstPort=\"443\"] "
+                L"Inbound Deny TCP 192.168.100.21 -> 192.168.100.22:443") != std::wstring::npos);
+        }
+
+        TEST_METHOD(CollectEventDataReturnsDate)
+        {
+            Logger::WriteMessage(L"CollectEventDataReturnsDate");
+
+            VfpEventData eventData = m_Callback->CollectEventData(m_testRecord);
+
+            // Does date match expected?
+            std::wstring expectedDate = L"20170914";
+            std::size_t found = eventData.date.find(expectedDate);
+            if (found == std::string::npos)
+            {
+                Assert::IsTrue(false);
+            }
+        }
+
+        TEST_METHOD(ProcessEventRecordReturnsTrue)
+        {
+            Logger::WriteMessage(L"ProcessEventRecordReturnsTrue");
+
+            bool result = m_Callback->ProcessEventRecord(m_testRecord);
+            Assert::IsTrue(result);
+        }
+
+        TEST_METHOD(ProcessEventRecordFiltersEventId)
+        {
+            Logger::WriteMessage(L"ProcessEventRecordFiltersEventId");
+
+            // Query for wrong event.
+            ntl::EtwRecordQuery query;
+            query.matchProviderId(VFP_PROVIDER_GUID);
+            query.matchEventId(110);
+
+            ntl::EtwRecord wrongRecord;
+            if (!queryEvents.FindFirstEvent(query, wrongRecord))
+            {
+                Logger::WriteMessage(L"Unable to find any event in test ETL file.");
+                Assert::IsTrue(false);
+            }
+
+            bool result = m_Callback->ProcessEventRecord(wrongRecord);
+            Assert::IsFalse(result);
+        }
+
+    private:
+        Parameters m_Params;
+        std::shared_ptr<Timer> m_Timer;
+        std::shared_ptr<EventCounter> m_EventCounter;
+        std::shared_ptr<FileLogger> m_FileLogger;
+        std::shared_ptr<FirewallCaptureSession> m_Reader;
+        std::shared_ptr<FirewallEtwTraceCallback> m_Callback;
+        
+        ntl::EtwReader<> queryEvents;
+        GUID VFP_PROVIDER_GUID = {
+            0x9F2660EA,
+            0xCFE7,
+            0x428F,
+            { 0x98, 0x50, 0xAE, 0xCA, 0x61, 0x26, 0x19, 0xB0 } };
+        ntl::EtwRecord m_testRecord;
+    };
 }
\ No newline at end of file
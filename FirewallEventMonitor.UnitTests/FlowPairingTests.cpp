@@ -0,0 +1,138 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include <CppUnitTest.h>
+// code under test headers
+#include "FlowPairing.h"
+// c++ headers
+#include <memory>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace FirewallEventMonitor;
+
+namespace FirewallEventMonitorUnitTest
+{
+    TEST_CLASS(FlowPairingTests)
+    {
+    public:
+
+        TEST_METHOD_INITIALIZE(MethodInit)
+        {
+            m_Pairing = std::make_shared<FlowPairing>(PairingWindowInSeconds, 4);
+        }
+
+        TEST_METHOD(ReplyKeyMatchesRequestKey)
+        {
+            Logger::WriteMessage(L"ReplyKeyMatchesRequestKey");
+
+            CompactEventRecord request = MakeRecord(TrafficDirection::Inbound, RuleAction::Allow, 1, 0);
+            CompactEventRecord reply = MakeReply(request, RuleAction::Allow, 2, 0);
+
+            Assert::IsTrue(FlowKey::FromRecord(request) == FlowKey::FromRecord(reply));
+            Assert::AreEqual(FlowKeyHash()(FlowKey::FromRecord(request)), FlowKeyHash()(FlowKey::FromRecord(reply)));
+        }
+
+        TEST_METHOD(InboundAllowOutboundDenyIsReported)
+        {
+            Logger::WriteMessage(L"InboundAllowOutboundDenyIsReported");
+
+            CompactEventRecord request = MakeRecord(TrafficDirection::Inbound, RuleAction::Allow, 1, 0);
+            m_Pairing->RecordEvent(request);
+            m_Pairing->RecordEvent(MakeReply(request, RuleAction::Deny, 2, 1));
+            // Further events for the same flow are not reported again.
+            m_Pairing->RecordEvent(MakeReply(request, RuleAction::Deny, 2, 2));
+
+            auto alerts = m_Pairing->TakeAlerts();
+            Assert::AreEqual(static_cast<size_t>(1), alerts.size());
+            Assert::AreEqual(1ul, static_cast<unsigned long>(alerts[0].inbound.ruleId.Data1));
+            Assert::AreEqual(2ul, static_cast<unsigned long>(alerts[0].outbound.ruleId.Data1));
+            Assert::IsTrue(alerts[0].inbound.action == RuleAction::Allow);
+            Assert::IsTrue(alerts[0].outbound.action == RuleAction::Deny);
+        }
+
+        TEST_METHOD(SymmetricFlowIsNotReported)
+        {
+            Logger::WriteMessage(L"SymmetricFlowIsNotReported");
+
+            CompactEventRecord request = MakeRecord(TrafficDirection::Outbound, RuleAction::Allow, 1, 0);
+            m_Pairing->RecordEvent(request);
+            m_Pairing->RecordEvent(MakeReply(request, RuleAction::Allow, 2, 1));
+
+            Assert::AreEqual(static_cast<size_t>(0), m_Pairing->TakeAlerts().size());
+        }
+
+        TEST_METHOD(ReplyOutsideWindowIsNotPaired)
+        {
+            Logger::WriteMessage(L"ReplyOutsideWindowIsNotPaired");
+
+            CompactEventRecord request = MakeRecord(TrafficDirection::Inbound, RuleAction::Allow, 1, 0);
+            m_Pairing->RecordEvent(request);
+            m_Pairing->RecordEvent(MakeReply(request, RuleAction::Deny, 2, PairingWindowInSeconds + 1));
+
+            Assert::AreEqual(static_cast<size_t>(0), m_Pairing->TakeAlerts().size());
+            // The expired flow was replaced by the reply.
+            Assert::AreEqual(static_cast<size_t>(1), m_Pairing->GetFlowCount());
+        }
+
+        TEST_METHOD(FlowTableIsBounded)
+        {
+            Logger::WriteMessage(L"FlowTableIsBounded");
+
+            for (unsigned short port = 1; port <= 6; ++port)
+            {
+                CompactEventRecord record = MakeRecord(TrafficDirection::Inbound, RuleAction::Allow, 1, 0);
+                record.sourcePort = port;
+                m_Pairing->RecordEvent(record);
+            }
+            Assert::AreEqual(static_cast<size_t>(4), m_Pairing->GetFlowCount());
+            Assert::AreEqual(2ull, m_Pairing->GetFlowsRejected());
+
+            // Expiry frees the table.
+            CompactEventRecord later = MakeRecord(TrafficDirection::Inbound, RuleAction::Allow, 1, PairingWindowInSeconds * 3);
+            m_Pairing->RecordEvent(later);
+            Assert::AreEqual(static_cast<size_t>(1), m_Pairing->GetFlowCount());
+        }
+
+    private:
+        std::shared_ptr<FlowPairing> m_Pairing;
+
+        const unsigned long PairingWindowInSeconds = 30;
+
+        static CompactEventRecord MakeRecord(
+            TrafficDirection direction,
+            RuleAction action,
+            unsigned long rule,
+            LONGLONG second)
+        {
+            CompactEventRecord record;
+            record.timeStamp = (13200000000LL + second) * 10000000LL;
+            record.ruleId.Data1 = rule;
+            record.direction = direction;
+            record.action = action;
+            record.protocol = 6;
+            record.source.u.Byte[15] = 1;
+            record.destination.u.Byte[15] = 2;
+            record.sourcePort = 50000;
+            record.destinationPort = 443;
+            return record;
+        }
+
+        static CompactEventRecord MakeReply(
+            const CompactEventRecord& request,
+            RuleAction action,
+            unsigned long rule,
+            LONGLONG second)
+        {
+            CompactEventRecord reply = MakeRecord(
+                request.direction == TrafficDirection::Inbound ? TrafficDirection::Outbound : TrafficDirection::Inbound,
+                action,
+                rule,
+                second);
+            reply.source = request.destination;
+            reply.destination = request.source;
+            reply.sourcePort = request.destinationPort;
+            reply.destinationPort = request.sourcePort;
+            return reply;
+        }
+    };
+}
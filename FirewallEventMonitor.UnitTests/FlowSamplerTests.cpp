@@ -0,0 +1,182 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include <CppUnitTest.h>
+// code under test headers
+#include "FlowSampler.h"
+// c++ headers
+#include <memory>
+#include <random>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace FirewallEventMonitor;
+
+namespace FirewallEventMonitorUnitTest
+{
+    TEST_CLASS(FlowSamplerTests)
+    {
+    public:
+
+        TEST_METHOD_INITIALIZE(MethodInit)
+        {
+            m_Sampler = std::make_shared<FlowSampler>(SampleRate);
+        }
+
+        TEST_METHOD(ReplyHashMatchesRequestHash)
+        {
+            Logger::WriteMessage(L"ReplyHashMatchesRequestHash");
+
+            std::mt19937 generator(1234);
+            for (int i = 0; i < 1000; ++i)
+            {
+                CompactEventRecord request = MakeRecord(generator);
+                CompactEventRecord reply = request;
+                reply.source = request.destination;
+                reply.destination = request.source;
+                reply.sourcePort = request.destinationPort;
+                reply.destinationPort = request.sourcePort;
+                reply.direction = TrafficDirection::Outbound;
+
+                Assert::AreEqual(FlowSampler::FlowHash(request), FlowSampler::FlowHash(reply));
+                Assert::AreEqual(m_Sampler->Sample(&request), m_Sampler->Sample(&reply));
+            }
+        }
+
+        TEST_METHOD(HashIsStableAcrossRuns)
+        {
+            Logger::WriteMessage(L"HashIsStableAcrossRuns");
+
+            // Hosts and restarts must agree, so the hash of a known flow never changes.
+            CompactEventRecord record;
+            record.source.u.Byte[10] = 0xff;
+            record.source.u.Byte[11] = 0xff;
+            record.source.u.Byte[12] = 192;
+            record.source.u.Byte[13] = 168;
+            record.source.u.Byte[14] = 100;
+            record.source.u.Byte[15] = 21;
+            record.destination = record.source;
+            record.destination.u.Byte[15] = 22;
+            record.sourcePort = 50000;
+            record.destinationPort = 443;
+            record.protocol = 6;
+
+            Assert::AreEqual(ExpectedFlowHash, FlowSampler::FlowHash(record));
+
+            // Fields outside the 5-tuple do not move a flow in or out of the sample.
+            record.ruleId.Data1 = 1;
+            record.timeStamp = 2;
+            record.action = RuleAction::Deny;
+            Assert::AreEqual(ExpectedFlowHash, FlowSampler::FlowHash(record));
+        }
+
+        TEST_METHOD(KeepsOneInSampleRateFlows)
+        {
+            Logger::WriteMessage(L"KeepsOneInSampleRateFlows");
+
+            std::mt19937 generator(5678);
+            const unsigned long flows = 160000;
+            for (unsigned long i = 0; i < flows; ++i)
+            {
+                CompactEventRecord record = MakeRecord(generator);
+                if (m_Sampler->Sample(&record))
+                {
+                    Assert::AreEqual(SampleRate, record.sampleRate);
+                }
+                else
+                {
+                    Assert::AreEqual(1ul, record.sampleRate);
+                }
+            }
+
+            double expected = static_cast<double>(flows) / SampleRate;
+            Assert::AreEqual(expected, static_cast<double>(m_Sampler->GetEventsKept()), expected * 0.05);
+            Assert::AreEqual(static_cast<unsigned long long>(flows), m_Sampler->GetEventsKept() + m_Sampler->GetEventsSkipped());
+        }
+
+        TEST_METHOD(SampleAtLowerRateContainsSampleAtHigherRate)
+        {
+            Logger::WriteMessage(L"SampleAtLowerRateContainsSampleAtHigherRate");
+
+            FlowSampler everyFlow(1);
+            FlowSampler halfOfFlows(2);
+            std::mt19937 generator(91011);
+            for (int i = 0; i < 10000; ++i)
+            {
+                CompactEventRecord record = MakeRecord(generator);
+                Assert::IsTrue(everyFlow.Sample(&record));
+                if (m_Sampler->Sample(&record))
+                {
+                    Assert::IsTrue(halfOfFlows.Sample(&record));
+                }
+            }
+        }
+
+        TEST_METHOD(SetSampleRateKeepsNestedFlows)
+        {
+            Logger::WriteMessage(L"SetSampleRateKeepsNestedFlows");
+
+            // Flows kept at 1/64 stay kept when the rate drops back to 1/16, so they stay complete.
+            FlowSampler adjusted(SampleRate);
+            adjusted.SetSampleRate(64);
+            Assert::AreEqual(64ul, adjusted.GetSampleRate());
+
+            std::mt19937 generator(121314);
+            for (int i = 0; i < 10000; ++i)
+            {
+                CompactEventRecord record = MakeRecord(generator);
+                if (adjusted.Sample(&record))
+                {
+                    Assert::AreEqual(64ul, record.sampleRate);
+                    Assert::IsTrue(m_Sampler->Sample(&record));
+                }
+            }
+
+            adjusted.SetSampleRate(0);
+            Assert::AreEqual(1ul, adjusted.GetSampleRate());
+        }
+
+        TEST_METHOD(ParseSampleRateAcceptsFractionAndDenominator)
+        {
+            Logger::WriteMessage(L"ParseSampleRateAcceptsFractionAndDenominator");
+
+            unsigned long rate = 0;
+            Assert::IsTrue(FlowSampler::ParseSampleRate(L"1/16", &rate));
+            Assert::AreEqual(16ul, rate);
+            Assert::IsTrue(FlowSampler::ParseSampleRate(L"100", &rate));
+            Assert::AreEqual(100ul, rate);
+            Assert::IsTrue(FlowSampler::ParseSampleRate(L"1/1", &rate));
+            Assert::AreEqual(1ul, rate);
+
+            Assert::IsFalse(FlowSampler::ParseSampleRate(L"1/0", &rate));
+            Assert::IsFalse(FlowSampler::ParseSampleRate(L"2/16", &rate));
+            Assert::IsFalse(FlowSampler::ParseSampleRate(L"1/", &rate));
+            Assert::IsFalse(FlowSampler::ParseSampleRate(L"", &rate));
+            Assert::IsFalse(FlowSampler::ParseSampleRate(L"0.5", &rate));
+            Assert::IsFalse(FlowSampler::ParseSampleRate(L"1/99999999999999999999", &rate));
+        }
+
+    private:
+        std::shared_ptr<FlowSampler> m_Sampler;
+
+        const unsigned long SampleRate = 16;
+        const unsigned long long ExpectedFlowHash = 0x2a30dbeb82935ecfull;
+
+        static CompactEventRecord MakeRecord(std::mt19937& generator)
+        {
+            CompactEventRecord record;
+            for (auto& byte : record.source.u.Byte)
+            {
+                byte = static_cast<unsigned char>(generator());
+            }
+            for (auto& byte : record.destination.u.Byte)
+            {
+                byte = static_cast<unsigned char>(generator());
+            }
+            record.sourcePort = static_cast<unsigned short>(generator());
+            record.destinationPort = static_cast<unsigned short>(generator());
+            record.protocol = generator() % 2 == 0 ? 6 : 17;
+            record.direction = TrafficDirection::Inbound;
+            return record;
+        }
+    };
+}
@@ -0,0 +1,137 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include <CppUnitTest.h>
+// code under test headers
+#include "LoadShedder.h"
+// c++ headers
+#include <memory>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace FirewallEventMonitor;
+
+namespace FirewallEventMonitorUnitTest
+{
+    TEST_CLASS(LoadShedderTests)
+    {
+    public:
+
+        TEST_METHOD_INITIALIZE(MethodInit)
+        {
+            m_Shedder = std::make_shared<LoadShedder>(EventsPerSecond, LoadShedder::DefaultPolicy());
+        }
+
+        TEST_METHOD(AllowFloodDoesNotStarveDenies)
+        {
+            Logger::WriteMessage(L"AllowFloodDoesNotStarveDenies");
+
+            // 10x the budget in allows, with a trickle of denies arriving last.
+            for (int i = 0; i < 1000; ++i)
+            {
+                m_Shedder->Admit(MakeRecord(RuleAction::Allow, 17, false, 0));
+            }
+            for (int i = 0; i < 20; ++i)
+            {
+                Assert::IsTrue(m_Shedder->Admit(MakeRecord(RuleAction::Deny, 17, false, 0)));
+            }
+
+            // Allows get everything but the reserves (25 + 10 + 15 of 100).
+            Assert::AreEqual(50ull, m_Shedder->GetCounters(EventClass::Allow).kept);
+            Assert::AreEqual(950ull, m_Shedder->GetCounters(EventClass::Allow).dropped);
+            Assert::AreEqual(20ull, m_Shedder->GetCounters(EventClass::Deny).kept);
+            Assert::AreEqual(0ull, m_Shedder->GetCounters(EventClass::Deny).dropped);
+        }
+
+        TEST_METHOD(ReserveOverflowsIntoSharedPool)
+        {
+            Logger::WriteMessage(L"ReserveOverflowsIntoSharedPool");
+
+            // Denies use their reserve of 25, then the shared pool of 50.
+            for (int i = 0; i < 100; ++i)
+            {
+                m_Shedder->Admit(MakeRecord(RuleAction::Deny, 6, false, 0));
+            }
+            Assert::AreEqual(75ull, m_Shedder->GetCounters(EventClass::Deny).kept);
+            Assert::AreEqual(25ull, m_Shedder->GetCounters(EventClass::Deny).dropped);
+
+            // The other reserves are untouched.
+            for (int i = 0; i < 15; ++i)
+            {
+                Assert::IsTrue(m_Shedder->Admit(MakeRecord(RuleAction::Allow, 6, true, 0)));
+            }
+            Assert::IsFalse(m_Shedder->Admit(MakeRecord(RuleAction::Allow, 6, true, 0)));
+        }
+
+        TEST_METHOD(BudgetRefillsEachSecondOfEventTime)
+        {
+            Logger::WriteMessage(L"BudgetRefillsEachSecondOfEventTime");
+
+            for (int i = 0; i < 100; ++i)
+            {
+                m_Shedder->Admit(MakeRecord(RuleAction::Allow, 17, false, 0));
+            }
+            Assert::IsFalse(m_Shedder->Admit(MakeRecord(RuleAction::Allow, 17, false, 0)));
+
+            // A late event from the previous second is charged to the current one.
+            Assert::IsFalse(m_Shedder->Admit(MakeRecord(RuleAction::Allow, 17, false, -1)));
+
+            Assert::IsTrue(m_Shedder->Admit(MakeRecord(RuleAction::Allow, 17, false, 1)));
+        }
+
+        TEST_METHOD(ClassIsFirstMatchInPriorityOrder)
+        {
+            Logger::WriteMessage(L"ClassIsFirstMatchInPriorityOrder");
+
+            CompactEventRecord deniedPing = MakeRecord(RuleAction::Deny, 1, false, 0);
+            CompactEventRecord allowedSyn = MakeRecord(RuleAction::Allow, 6, true, 0);
+            Assert::IsTrue(EventClass::Deny == m_Shedder->Classify(deniedPing));
+            Assert::IsTrue(EventClass::TcpSyn == m_Shedder->Classify(allowedSyn));
+            Assert::IsTrue(EventClass::Icmp == m_Shedder->Classify(MakeRecord(RuleAction::Allow, 58, false, 0)));
+            Assert::IsTrue(EventClass::Allow == m_Shedder->Classify(MakeRecord(RuleAction::Unknown, 17, false, 0)));
+
+            std::vector<ShedClassPolicy> policy;
+            Assert::IsTrue(LoadShedder::ParsePolicy(L"Icmp:10,Deny:20", &policy));
+            LoadShedder icmpFirst(EventsPerSecond, policy);
+            Assert::IsTrue(EventClass::Icmp == icmpFirst.Classify(deniedPing));
+
+            // Classes left out of the policy are appended with no reserve.
+            Assert::AreEqual(static_cast<size_t>(4), icmpFirst.GetPolicy().size());
+            Assert::IsTrue(EventClass::TcpSyn == icmpFirst.GetPolicy()[2].eventClass);
+            Assert::AreEqual(0ul, icmpFirst.GetPolicy()[3].reservedPercent);
+        }
+
+        TEST_METHOD(ParsePolicyRejectsMalformedText)
+        {
+            Logger::WriteMessage(L"ParsePolicyRejectsMalformedText");
+
+            std::vector<ShedClassPolicy> policy;
+            Assert::IsTrue(LoadShedder::ParsePolicy(L"default", &policy));
+            Assert::AreEqual(static_cast<size_t>(4), policy.size());
+            Assert::IsTrue(LoadShedder::ParsePolicy(L"deny:60,tcpsyn:40,allow", &policy));
+            Assert::AreEqual(40ul, policy[1].reservedPercent);
+
+            Assert::IsFalse(LoadShedder::ParsePolicy(L"", &policy));
+            Assert::IsFalse(LoadShedder::ParsePolicy(L"Deny:60,Icmp:41", &policy));
+            Assert::IsFalse(LoadShedder::ParsePolicy(L"Deny,Deny", &policy));
+            Assert::IsFalse(LoadShedder::ParsePolicy(L"Udp:10", &policy));
+            Assert::IsFalse(LoadShedder::ParsePolicy(L"Deny:", &policy));
+            Assert::IsFalse(LoadShedder::ParsePolicy(L"Deny:-5", &policy));
+        }
+
+    private:
+        std::shared_ptr<LoadShedder> m_Shedder;
+
+        const unsigned long EventsPerSecond = 100;
+
+        static CompactEventRecord MakeRecord(RuleAction action, unsigned short protocol, bool isTcpSyn, LONGLONG second)
+        {
+            const LONGLONG start = 131492000000000000LL; // A FILETIME on a second boundary.
+            CompactEventRecord record;
+            record.timeStamp = start + second * 10000000LL;
+            record.action = action;
+            record.protocol = protocol;
+            record.isTcpSyn = isTcpSyn;
+            return record;
+        }
+    };
+}
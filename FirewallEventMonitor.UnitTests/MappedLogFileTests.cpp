@@ -0,0 +1,148 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include <CppUnitTest.h>
+// code under test headers
+#include "MappedLogFile.h"
+// c++ headers
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace FirewallEventMonitor;
+
+namespace FirewallEventMonitorUnitTest
+{
+    TEST_CLASS(MappedLogFileTests)
+    {
+    public:
+
+        TEST_METHOD_INITIALIZE(MethodInit)
+        {
+            WCHAR directory[MAX_PATH] = L"";
+            ::GetTempPathW(MAX_PATH, directory);
+            m_Path = std::wstring(directory) + L"MappedLogFileTests.log";
+            _wremove(m_Path.c_str());
+        }
+
+        TEST_METHOD_CLEANUP(MethodCleanup)
+        {
+            _wremove(m_Path.c_str());
+        }
+
+        TEST_METHOD(FileIsPreallocatedAndTrimmedOnClose)
+        {
+            Logger::WriteMessage(L"FileIsPreallocatedAndTrimmedOnClose");
+
+            MappedLogFile file(m_Path, SmallSegmentBytes);
+            Assert::IsTrue(file.Append("first\r\n", 7));
+            Assert::IsTrue(file.Append("second\r\n", 8));
+            Assert::AreEqual(15ull, file.GetLength());
+            // The whole segment is in the file before anything is written past it.
+            Assert::AreEqual(file.GetSegmentBytes(), ReadFile().size());
+
+            file.Close();
+            Assert::AreEqual(std::string("first\r\nsecond\r\n"), ReadFile());
+        }
+
+        TEST_METHOD(RecordsContinueAcrossSegmentsWithoutGaps)
+        {
+            Logger::WriteMessage(L"RecordsContinueAcrossSegmentsWithoutGaps");
+
+            std::string expected;
+            {
+                MappedLogFile file(m_Path, SmallSegmentBytes);
+                // Records that do not divide the segment evenly, so segments end part way into one.
+                for (int i = 0; i < 1000; ++i)
+                {
+                    std::string record = "record " + std::to_string(i) + " " + std::string(900, 'x') + "\r\n";
+                    Assert::IsTrue(file.Append(record.data(), record.size()));
+                    expected += record;
+                }
+                Assert::IsTrue(file.GetSegmentsMapped() > 1ull);
+            }
+
+            Assert::AreEqual(expected, ReadFile());
+        }
+
+        TEST_METHOD(ConcurrentWritersKeepEveryRecordWhole)
+        {
+            Logger::WriteMessage(L"ConcurrentWritersKeepEveryRecordWhole");
+
+            const int threadCount = 4;
+            const int recordsPerThread = 20000;
+            {
+                MappedLogFile file(m_Path, SmallSegmentBytes);
+                std::vector<std::thread> writers;
+                for (int writer = 0; writer < threadCount; ++writer)
+                {
+                    writers.emplace_back([&file, writer, recordsPerThread]()
+                    {
+                        char record[32];
+                        for (int i = 0; i < recordsPerThread; ++i)
+                        {
+                            int length = sprintf_s(record, "%d %08d\r\n", writer, i);
+                            file.Append(record, static_cast<size_t>(length));
+                        }
+                    });
+                }
+                for (auto& writer : writers)
+                {
+                    writer.join();
+                }
+            }
+
+            // Each writer's records are whole and in its own order.
+            std::string contents = ReadFile();
+            const size_t recordBytes = 12;
+            Assert::AreEqual(static_cast<size_t>(threadCount * recordsPerThread) * recordBytes, contents.size());
+            std::vector<int> next(threadCount, 0);
+            for (size_t offset = 0; offset < contents.size(); offset += recordBytes)
+            {
+                int writer = -1;
+                int i = -1;
+                Assert::AreEqual(2, sscanf_s(contents.c_str() + offset, "%d %08d", &writer, &i));
+                Assert::IsTrue(writer >= 0 && writer < threadCount);
+                Assert::AreEqual(next[writer], i);
+                Assert::AreEqual('\n', contents[offset + recordBytes - 1]);
+                ++next[writer];
+            }
+        }
+
+        TEST_METHOD(RecordLargerThanMaxAppendIsRejected)
+        {
+            Logger::WriteMessage(L"RecordLargerThanMaxAppendIsRejected");
+
+            MappedLogFile file(m_Path, SmallSegmentBytes);
+            std::string record(file.GetMaxAppendBytes() + 1, 'x');
+            Assert::IsFalse(file.Append(record.data(), record.size()));
+            Assert::IsTrue(file.Append(record.data(), record.size() - 1));
+            file.Close();
+            Assert::AreEqual(static_cast<size_t>(file.GetMaxAppendBytes()), ReadFile().size());
+            Assert::IsFalse(file.Append("late\r\n", 6));
+        }
+
+    private:
+        std::wstring m_Path;
+
+        // Two allocation granularity units, the smallest segment.
+        static const size_t SmallSegmentBytes = 128 * 1024;
+
+        std::string ReadFile() const
+        {
+            FILE* file = NULL;
+            Assert::AreEqual(0, _wfopen_s(&file, m_Path.c_str(), L"rb"));
+            std::string contents;
+            char buffer[4096];
+            size_t read = 0;
+            while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+            {
+                contents.append(buffer, read);
+            }
+            fclose(file);
+            return contents;
+        }
+    };
+}
@@ -0,0 +1,139 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include <CppUnitTest.h>
+// code under test headers
+#include "ntlHeavyHitters.hpp"
+// c++ headers
+#include <map>
+#include <random>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace FirewallEventMonitorUnitTest
+{
+    namespace
+    {
+        typedef ntl::HeavyHitters<unsigned long> HeavyHitters;
+
+        // Asserts every entry's bounds hold the key's true weight, and no key left out is above absent_bound().
+        void AssertBoundsHold(const HeavyHitters& summary, const std::map<unsigned long, unsigned long long>& weights)
+        {
+            std::map<unsigned long, bool> listed;
+            for (const auto& entry : summary.entry_values())
+            {
+                auto weight = weights.find(entry.key);
+                unsigned long long actual = weight != weights.end() ? weight->second : 0;
+                Assert::IsTrue(entry.count >= actual);
+                Assert::IsTrue(entry.count - entry.error <= actual);
+                listed[entry.key] = true;
+            }
+            for (const auto& weight : weights)
+            {
+                if (listed.find(weight.first) == listed.end())
+                {
+                    Assert::IsTrue(weight.second <= summary.absent_bound());
+                }
+            }
+        }
+    }
+
+    TEST_CLASS(NtlHeavyHittersTests)
+    {
+    public:
+
+        TEST_METHOD(ExactUnderCapacity)
+        {
+            Logger::WriteMessage(L"ExactUnderCapacity");
+
+            HeavyHitters summary(8);
+            for (unsigned long key = 1; key <= 5; ++key)
+            {
+                summary.add(key, key * 10);
+                summary.add(key);
+            }
+
+            auto top = summary.top(3);
+            Assert::AreEqual(static_cast<size_t>(3), top.size());
+            Assert::AreEqual(5ul, top[0].key);
+            Assert::AreEqual(51ull, top[0].count);
+            Assert::AreEqual(0ull, top[0].error);
+            Assert::AreEqual(4ul, top[1].key);
+            Assert::AreEqual(3ul, top[2].key);
+            Assert::AreEqual(155ull, summary.total());
+            Assert::AreEqual(0ull, summary.absent_bound());
+        }
+
+        TEST_METHOD(HeavyKeysKeptWithBounds)
+        {
+            Logger::WriteMessage(L"HeavyKeysKeptWithBounds");
+
+            // Zipf-like: a few keys carry most of the weight, among many light ones.
+            std::mt19937 generator(1234);
+            std::geometric_distribution<unsigned long> distribution(0.05);
+            std::map<unsigned long, unsigned long long> weights;
+            HeavyHitters summary(64);
+            for (int i = 0; i < 200000; ++i)
+            {
+                unsigned long key = distribution(generator);
+                summary.add(key);
+                ++weights[key];
+            }
+
+            Assert::AreEqual(static_cast<size_t>(64), summary.size());
+            Assert::AreEqual(200000ull, summary.total());
+            Assert::IsTrue(summary.absent_bound() <= summary.total() / summary.capacity());
+            AssertBoundsHold(summary, weights);
+
+            // The heaviest keys come out in order.
+            auto top = summary.top(3);
+            Assert::AreEqual(0ul, top[0].key);
+            Assert::AreEqual(1ul, top[1].key);
+            Assert::AreEqual(2ul, top[2].key);
+        }
+
+        TEST_METHOD(MergeKeepsBounds)
+        {
+            Logger::WriteMessage(L"MergeKeepsBounds");
+
+            // Two streams with different heavy keys, each overflowing its summary.
+            std::mt19937 generator(42);
+            std::geometric_distribution<unsigned long> distribution(0.02);
+            std::map<unsigned long, unsigned long long> weights;
+            HeavyHitters left(32), right(32);
+            for (int i = 0; i < 50000; ++i)
+            {
+                unsigned long leftKey = distribution(generator);
+                left.add(leftKey, 2);
+                weights[leftKey] += 2;
+
+                unsigned long rightKey = distribution(generator) + 20;
+                right.add(rightKey);
+                ++weights[rightKey];
+            }
+
+            left.merge(right);
+            Assert::AreEqual(static_cast<size_t>(32), left.size());
+            Assert::AreEqual(150000ull, left.total());
+            AssertBoundsHold(left, weights);
+        }
+
+        TEST_METHOD(LoadRejectsDuplicateKeys)
+        {
+            Logger::WriteMessage(L"LoadRejectsDuplicateKeys");
+
+            HeavyHitters summary(4);
+            std::vector<HeavyHitters::entry> entries{ { 1, 10, 0 }, { 2, 30, 5 }, { 3, 20, 0 }, { 4, 5, 0 }, { 5, 1, 0 } };
+            summary.load(entries, 100);
+            // The largest capacity() entries are kept.
+            Assert::AreEqual(static_cast<size_t>(4), summary.size());
+            Assert::AreEqual(5ull, summary.absent_bound());
+            Assert::AreEqual(2ul, summary.top(1)[0].key);
+
+            entries.push_back({ 2, 1, 0 });
+            Assert::ExpectException<ntl::Exception>([&]() { HeavyHitters(8).load(entries, 100); });
+            Assert::ExpectException<ntl::Exception>([]() { HeavyHitters empty(0); });
+        }
+    };
+}
@@ -0,0 +1,110 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include <CppUnitTest.h>
+// code under test headers
+#include "ntlHyperLogLog.hpp"
+// c++ headers
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace FirewallEventMonitorUnitTest
+{
+    namespace
+    {
+        // SplitMix64: a well mixed hash of each value, as HyperLogLog expects.
+        unsigned long long MixHash(unsigned long long value)
+        {
+            value += 0x9E3779B97F4A7C15ull;
+            value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+            value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+            return value ^ (value >> 31);
+        }
+    }
+
+    TEST_CLASS(NtlHyperLogLogTests)
+    {
+    public:
+
+        TEST_METHOD(EstimatesWithinExpectedError)
+        {
+            Logger::WriteMessage(L"EstimatesWithinExpectedError");
+
+            // Small counts are linear counted; large ones use the harmonic mean.
+            for (unsigned long long distinct : { 10ull, 1000ull, 100000ull, 1000000ull })
+            {
+                ntl::HyperLogLog counter(14);
+                for (unsigned long long i = 0; i < distinct; ++i)
+                {
+                    // Repeats are counted once.
+                    counter.add(MixHash(i));
+                    counter.add(MixHash(i));
+                }
+                double expected = static_cast<double>(distinct);
+                Assert::AreEqual(expected, counter.estimate(), expected * 0.03 + 1.0);
+            }
+
+            ntl::HyperLogLog empty;
+            Assert::AreEqual(0.0, empty.estimate());
+        }
+
+        TEST_METHOD(MergeCountsOverlappingValuesOnce)
+        {
+            Logger::WriteMessage(L"MergeCountsOverlappingValuesOnce");
+
+            // 0-59,999 and 40,000-99,999: 100,000 distinct values.
+            ntl::HyperLogLog lower(12), upper(12), all(12);
+            for (unsigned long long i = 0; i < 100000; ++i)
+            {
+                if (i < 60000)
+                {
+                    lower.add(MixHash(i));
+                }
+                if (i >= 40000)
+                {
+                    upper.add(MixHash(i));
+                }
+                all.add(MixHash(i));
+            }
+            lower.merge(upper);
+
+            Assert::AreEqual(100000.0, lower.estimate(), 100000.0 * 0.05);
+            // The registers are exactly those of one counter given every value.
+            Assert::IsTrue(all.register_values() == lower.register_values());
+        }
+
+        TEST_METHOD(LoadedRegistersMatchAndInvalidAreRejected)
+        {
+            Logger::WriteMessage(L"LoadedRegistersMatchAndInvalidAreRejected");
+
+            ntl::HyperLogLog counter(10);
+            for (unsigned long long i = 0; i < 5000; ++i)
+            {
+                counter.add(MixHash(i));
+            }
+
+            ntl::HyperLogLog loaded(10);
+            const auto& registers = counter.register_values();
+            loaded.load_registers(registers.data(), registers.size());
+            Assert::AreEqual(counter.estimate(), loaded.estimate());
+
+            // Wrong number of registers, and a rank no 64 bit hash can have.
+            Assert::ExpectException<ntl::Exception>([&]() { loaded.load_registers(registers.data(), registers.size() / 2); });
+            std::vector<unsigned char> corrupt(registers);
+            corrupt[0] = 64;
+            Assert::ExpectException<ntl::Exception>([&]() { loaded.load_registers(corrupt.data(), corrupt.size()); });
+        }
+
+        TEST_METHOD(PrecisionOutOfRangeOrMismatchedThrows)
+        {
+            Logger::WriteMessage(L"PrecisionOutOfRangeOrMismatchedThrows");
+
+            Assert::ExpectException<ntl::Exception>([]() { ntl::HyperLogLog counter(3); });
+            Assert::ExpectException<ntl::Exception>([]() { ntl::HyperLogLog counter(19); });
+
+            ntl::HyperLogLog coarse(10), fine(14);
+            Assert::ExpectException<ntl::Exception>([&]() { coarse.merge(fine); });
+        }
+    };
+}
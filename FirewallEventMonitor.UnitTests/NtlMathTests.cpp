@@ -0,0 +1,196 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include <CppUnitTest.h>
+// code under test headers
+#include "ntlMath.hpp"
+// c++ headers
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace FirewallEventMonitorUnitTest
+{
+    TEST_CLASS(NtlMathTests)
+    {
+    public:
+
+        TEST_METHOD(RunningStatisticsMatchesSampledStandardDeviation)
+        {
+            Logger::WriteMessage(L"RunningStatisticsMatchesSampledStandardDeviation");
+
+            std::vector<double> values{ 2.0, 4.0, 4.0, 4.0, 5.0, 5.0, 7.0, 9.0 };
+            ntl::RunningStatistics running;
+            for (const auto& value : values)
+            {
+                running.add(value);
+            }
+
+            auto expected = ntl::SampledStandardDeviation(values.begin(), values.end());
+            auto actual = running.standard_deviation_range();
+            Assert::AreEqual(std::get<0>(expected), std::get<0>(actual), 1e-9);
+            Assert::AreEqual(std::get<1>(expected), std::get<1>(actual), 1e-9);
+            Assert::AreEqual(std::get<2>(expected), std::get<2>(actual), 1e-9);
+        }
+
+        TEST_METHOD(RunningStatisticsMergeMatchesSingleStream)
+        {
+            Logger::WriteMessage(L"RunningStatisticsMergeMatchesSingleStream");
+
+            ntl::RunningStatistics all, even, odd;
+            for (int i = 0; i < 1000; ++i)
+            {
+                double value = (i * 37) % 101;
+                all.add(value);
+                (i % 2 == 0 ? even : odd).add(value);
+            }
+            even.merge(odd);
+
+            Assert::AreEqual(static_cast<double>(all.count()), static_cast<double>(even.count()));
+            Assert::AreEqual(all.mean(), even.mean(), 1e-9);
+            Assert::AreEqual(all.variance(), even.variance(), 1e-6);
+            Assert::AreEqual(all.maximum(), even.maximum());
+            Assert::AreEqual(all.minimum(), even.minimum());
+        }
+
+        TEST_METHOD(ExponentialMovingAverageConverges)
+        {
+            Logger::WriteMessage(L"ExponentialMovingAverageConverges");
+
+            ntl::ExponentialMovingAverage average(0.2);
+            Assert::IsFalse(average.has_value());
+            for (int i = 0; i < 200; ++i)
+            {
+                average.add(50.0);
+            }
+            Assert::AreEqual(50.0, average.mean(), 1e-9);
+            Assert::AreEqual(0.0, average.variance(), 1e-9);
+
+            average.add(100.0);
+            Assert::AreEqual(60.0, average.mean(), 1e-9);
+        }
+
+        TEST_METHOD(TDigestQuantilesWithinTolerance)
+        {
+            Logger::WriteMessage(L"TDigestQuantilesWithinTolerance");
+
+            std::mt19937 generator(1234);
+            std::exponential_distribution<double> distribution(1.0);
+            std::vector<double> values;
+            ntl::TDigest digest;
+            for (int i = 0; i < 100000; ++i)
+            {
+                double value = distribution(generator);
+                values.push_back(value);
+                digest.add(value);
+            }
+            std::sort(values.begin(), values.end());
+
+            for (double q : { 0.25, 0.5, 0.75, 0.9, 0.99 })
+            {
+                double exact = values[static_cast<size_t>(q * values.size())];
+                Assert::AreEqual(exact, digest.quantile(q), exact * 0.02);
+            }
+            Assert::AreEqual(values.front(), digest.quantile(0.0));
+            Assert::AreEqual(values.back(), digest.quantile(1.0));
+
+            // bounded memory regardless of the number of samples
+            Assert::IsTrue(digest.centroid_count() <= 200);
+        }
+
+        TEST_METHOD(TDigestMergeMatchesSingleDigest)
+        {
+            Logger::WriteMessage(L"TDigestMergeMatchesSingleDigest");
+
+            ntl::TDigest all, lower, upper;
+            for (int i = 0; i < 10000; ++i)
+            {
+                all.add(i);
+                (i < 5000 ? lower : upper).add(i);
+            }
+            lower.merge(upper);
+
+            Assert::AreEqual(all.count(), lower.count());
+            Assert::AreEqual(all.quantile(0.5), lower.quantile(0.5), 50.0);
+            Assert::AreEqual(all.quantile(0.99), lower.quantile(0.99), 50.0);
+            Assert::AreEqual(9999.0, lower.maximum());
+        }
+
+        TEST_METHOD(TDigestSelfMergeDoublesTheWeight)
+        {
+            Logger::WriteMessage(L"TDigestSelfMergeDoublesTheWeight");
+
+            // As if every sample had been added twice.
+            ntl::TDigest digest(20), twice(20);
+            for (int i = 1; i <= 10000; ++i)
+            {
+                digest.add(i);
+                twice.add(i);
+                twice.add(i);
+            }
+            digest.merge(digest);
+
+            Assert::AreEqual(twice.count(), digest.count());
+            Assert::AreEqual(1.0, digest.minimum());
+            Assert::AreEqual(10000.0, digest.maximum());
+            Assert::AreEqual(twice.quantile(0.5), digest.quantile(0.5), 100.0);
+            Assert::AreEqual(twice.quantile(0.99), digest.quantile(0.99), 100.0);
+        }
+
+        TEST_METHOD(TDigestCentroidsRebuildTheDigest)
+        {
+            Logger::WriteMessage(L"TDigestCentroidsRebuildTheDigest");
+
+            ntl::TDigest digest(50);
+            for (int i = 1; i <= 10000; ++i)
+            {
+                digest.add(i);
+            }
+
+            // As a sketch file would carry it: the centroids and the range.
+            ntl::TDigest rebuilt(digest.compression_factor());
+            rebuilt.merge_centroids(digest.centroid_values(), digest.minimum(), digest.maximum());
+            Assert::AreEqual(digest.count(), rebuilt.count());
+            Assert::AreEqual(1.0, rebuilt.minimum());
+            Assert::AreEqual(10000.0, rebuilt.maximum());
+            Assert::AreEqual(digest.quantile(0.5), rebuilt.quantile(0.5), 1.0);
+            Assert::AreEqual(digest.quantile(0.99), rebuilt.quantile(0.99), 1.0);
+
+            // No centroids leave the range alone.
+            ntl::TDigest empty;
+            empty.merge_centroids({}, 5.0, 6.0);
+            Assert::AreEqual(0.0, empty.count());
+            Assert::AreEqual(0.0, empty.maximum());
+        }
+
+        TEST_METHOD(TDigestInterquartileRangeMatchesSortedRange)
+        {
+            Logger::WriteMessage(L"TDigestInterquartileRangeMatchesSortedRange");
+
+            std::vector<double> values;
+            ntl::TDigest digest;
+            for (int i = 1; i <= 1001; ++i)
+            {
+                values.push_back(i);
+                digest.add(i);
+            }
+
+            auto expected = ntl::InterquartileRange(values.begin(), values.end());
+            auto actual = digest.interquartile_range();
+            Assert::AreEqual(std::get<0>(expected), std::get<0>(actual), 5.0);
+            Assert::AreEqual(std::get<1>(expected), std::get<1>(actual), 5.0);
+            Assert::AreEqual(std::get<2>(expected), std::get<2>(actual), 5.0);
+        }
+
+        TEST_METHOD(EmptyDigestReturnsZero)
+        {
+            Logger::WriteMessage(L"EmptyDigestReturnsZero");
+
+            ntl::TDigest digest;
+            Assert::AreEqual(0.0, digest.quantile(0.5));
+            Assert::AreEqual(0.0, digest.count());
+        }
+    };
+}
\ No newline at end of file
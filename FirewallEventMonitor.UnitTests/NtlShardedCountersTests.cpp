@@ -0,0 +1,158 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include <CppUnitTest.h>
+// code under test headers
+#include "ntlShardedCounters.hpp"
+// c++ headers
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace FirewallEventMonitorUnitTest
+{
+    TEST_CLASS(NtlShardedCountersTests)
+    {
+    public:
+
+        TEST_METHOD(ShardsAreCacheLineAlignedAndRoundedToPowerOfTwo)
+        {
+            Logger::WriteMessage(L"ShardsAreCacheLineAlignedAndRoundedToPowerOfTwo");
+
+            ntl::ShardedCounters<3> counters(5);
+            Assert::AreEqual(static_cast<size_t>(8), counters.shards());
+            Assert::IsTrue(ntl::ShardedCounters<3>::default_shards() >= static_cast<size_t>(1));
+
+            // Shards past the count wrap around to an existing one.
+            for (size_t shard = 0; shard < 20; ++shard)
+            {
+                Assert::AreEqual(static_cast<unsigned long long>(shard / 8 + 1), counters.add(shard, 2));
+            }
+            Assert::AreEqual(20ull, counters.sum(2));
+            Assert::AreEqual(0ull, counters.sum(0));
+            Assert::AreEqual(0ull, counters.sum(1));
+        }
+
+        TEST_METHOD(TakeResetsCounters)
+        {
+            Logger::WriteMessage(L"TakeResetsCounters");
+
+            ntl::ShardedCounters<2> counters(4);
+            counters.add(0, 0, 5);
+            counters.add(1, 0, 7);
+            counters.add(1, 1, 3);
+            counters.add_current(1);
+
+            Assert::AreEqual(7ull, counters.take(1, 0));
+            Assert::AreEqual(5ull, counters.sum(0));
+            Assert::AreEqual(5ull, counters.take_all(0));
+            Assert::AreEqual(0ull, counters.sum(0));
+            Assert::AreEqual(4ull, counters.sum(1));
+        }
+
+        TEST_METHOD(ConcurrentAddsAreAllCounted)
+        {
+            Logger::WriteMessage(L"ConcurrentAddsAreAllCounted");
+
+            // Fewer shards than threads, so threads share shards.
+            ntl::ShardedCounters<2> counters(2);
+            const size_t threadCount = 8;
+            const size_t addsPerThread = 100000;
+            std::vector<std::thread> threads;
+            for (size_t thread = 0; thread < threadCount; ++thread)
+            {
+                threads.emplace_back([&counters, thread, addsPerThread]()
+                {
+                    for (size_t i = 0; i < addsPerThread; ++i)
+                    {
+                        counters.add(thread + i, i & 1);
+                    }
+                });
+            }
+            for (auto& thread : threads)
+            {
+                thread.join();
+            }
+
+            Assert::AreEqual(static_cast<unsigned long long>(threadCount * addsPerThread / 2), counters.sum(0));
+            Assert::AreEqual(static_cast<unsigned long long>(threadCount * addsPerThread / 2), counters.sum(1));
+        }
+    };
+
+    // Counting from every processor into one shared counter and into sharded counters;
+    // run with /TestCaseFilter:TestCategory=Benchmark.
+    TEST_CLASS(NtlShardedCountersBenchmarks)
+    {
+    public:
+
+        BEGIN_TEST_METHOD_ATTRIBUTE(ContendedIncrementThroughput)
+            TEST_METHOD_ATTRIBUTE(L"TestCategory", L"Benchmark")
+        END_TEST_METHOD_ATTRIBUTE()
+
+        TEST_METHOD(ContendedIncrementThroughput)
+        {
+            Logger::WriteMessage(L"ContendedIncrementThroughput");
+
+            const size_t threadCount = ntl::ShardedCounters<1>::default_shards();
+            const size_t addsPerThread = 10000000;
+
+            std::atomic<unsigned long long> shared{ 0 };
+            double sharedRate = IncrementsPerSecond(threadCount, addsPerThread, [&](size_t)
+            {
+                shared.fetch_add(1, std::memory_order_relaxed);
+            });
+
+            ntl::ShardedCounters<1> sharded;
+            double shardedRate = IncrementsPerSecond(threadCount, addsPerThread, [&](size_t thread)
+            {
+                sharded.add(thread, 0);
+            });
+
+            ntl::ShardedCounters<1> current;
+            double currentRate = IncrementsPerSecond(threadCount, addsPerThread, [&](size_t)
+            {
+                current.add_current(0);
+            });
+
+            wchar_t report[256];
+            swprintf_s(report, L"M increments/s on %zu threads: shared atomic %.0f, sharded by thread %.0f, sharded by current processor %.0f",
+                threadCount,
+                sharedRate / 1e6,
+                shardedRate / 1e6,
+                currentRate / 1e6);
+            Logger::WriteMessage(report);
+            Assert::AreEqual(static_cast<unsigned long long>(threadCount * addsPerThread), shared.load());
+            Assert::AreEqual(static_cast<unsigned long long>(threadCount * addsPerThread), sharded.sum(0));
+            Assert::AreEqual(static_cast<unsigned long long>(threadCount * addsPerThread), current.sum(0));
+        }
+
+    private:
+        template <typename Function>
+        static double IncrementsPerSecond(size_t threadCount, size_t addsPerThread, Function function)
+        {
+            auto start = std::chrono::steady_clock::now();
+            std::vector<std::thread> threads;
+            for (size_t thread = 0; thread < threadCount; ++thread)
+            {
+                threads.emplace_back([&function, thread, addsPerThread]()
+                {
+                    for (size_t i = 0; i < addsPerThread; ++i)
+                    {
+                        function(thread);
+                    }
+                });
+            }
+            for (auto& thread : threads)
+            {
+                thread.join();
+            }
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            double seconds = std::chrono::duration_cast<std::chrono::duration<double>>(elapsed).count();
+            return static_cast<double>(threadCount * addsPerThread) / seconds;
+        }
+    };
+}
@@ -0,0 +1,321 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include <CppUnitTest.h>
+// code under test headers
+#include "ntlSockaddr.hpp"
+// c++ headers
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace FirewallEventMonitorUnitTest
+{
+    namespace
+    {
+        // Addresses with zero runs and short groups, so compression and digit trimming are exercised.
+        IN6_ADDR RandomIpv6Address(std::mt19937& generator)
+        {
+            std::uniform_int_distribution<unsigned> shape(0, 3);
+            std::uniform_int_distribution<unsigned> value(0, 0xffff);
+            for (;;)
+            {
+                unsigned short words[8];
+                for (auto& word : words)
+                {
+                    switch (shape(generator))
+                    {
+                    case 0: word = 0; break;
+                    case 1: word = static_cast<unsigned short>(value(generator) & 0xff); break;
+                    default: word = static_cast<unsigned short>(value(generator)); break;
+                    }
+                }
+
+                // Skip the embedded IPv4 forms the system formatter may use besides v4-mapped
+                // (v4-compatible, ISATAP and v4-translated); RFC 5952 does not call for them.
+                bool firstFiveZero = words[0] == 0 && words[1] == 0 && words[2] == 0 && words[3] == 0 && words[4] == 0;
+                if ((firstFiveZero && words[5] == 0) ||
+                    ((words[4] & 0xfdff) == 0 && words[5] == 0x5efe) ||
+                    (words[0] == 0 && words[1] == 0 && words[2] == 0 && words[3] == 0 && words[4] == 0xffff && words[5] == 0))
+                {
+                    continue;
+                }
+
+                IN6_ADDR address;
+                for (unsigned index = 0; index < 8; ++index)
+                {
+                    address.u.Byte[index * 2] = static_cast<unsigned char>(words[index] >> 8);
+                    address.u.Byte[index * 2 + 1] = static_cast<unsigned char>(words[index] & 0xff);
+                }
+                return address;
+            }
+        }
+
+        // System parsers differ on IPv4 octets with leading zeros (some read them as octal).
+        bool HasLeadingZeroOctet(const std::wstring& text)
+        {
+            for (size_t index = 0; index + 1 < text.size(); ++index)
+            {
+                bool octetStart = index == 0 || text[index - 1] == L'.' || text[index - 1] == L':';
+                if (octetStart && text[index] == L'0' && text[index + 1] >= L'0' && text[index + 1] <= L'9' &&
+                    text.find(L'.', index) != std::wstring::npos)
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        std::wstring Ipv6Text(const IN6_ADDR& address)
+        {
+            WCHAR text[ntl::IPV6_STRING_MAX_LENGTH];
+            size_t length = ntl::format_ipv6(address, text, ntl::IPV6_STRING_MAX_LENGTH);
+            return std::wstring(text, length);
+        }
+    }
+
+    TEST_CLASS(NtlSockaddrTests)
+    {
+    public:
+
+        TEST_METHOD(FormatIpv4MatchesInetNtop)
+        {
+            Logger::WriteMessage(L"FormatIpv4MatchesInetNtop");
+
+            std::mt19937 generator(1234);
+            std::uniform_int_distribution<unsigned> octet(0, 255);
+            for (int i = 0; i < 100000; ++i)
+            {
+                IN_ADDR address;
+                unsigned char* bytes = reinterpret_cast<unsigned char*>(&address);
+                for (unsigned index = 0; index < sizeof(IN_ADDR); ++index)
+                {
+                    bytes[index] = static_cast<unsigned char>(i < 256 ? i : octet(generator));
+                }
+
+                WCHAR expected[INET_ADDRSTRLEN] = {};
+                InetNtopW(AF_INET, &address, expected, INET_ADDRSTRLEN);
+                WCHAR actual[ntl::IPV4_STRING_MAX_LENGTH];
+                size_t length = ntl::format_ipv4(address, actual, ntl::IPV4_STRING_MAX_LENGTH);
+
+                Assert::AreEqual(std::wstring(expected), std::wstring(actual));
+                Assert::AreEqual(wcslen(expected), length);
+            }
+        }
+
+        TEST_METHOD(FormatIpv6MatchesInetNtop)
+        {
+            Logger::WriteMessage(L"FormatIpv6MatchesInetNtop");
+
+            std::mt19937 generator(1234);
+            for (int i = 0; i < 100000; ++i)
+            {
+                IN6_ADDR address = RandomIpv6Address(generator);
+
+                WCHAR expected[INET6_ADDRSTRLEN] = {};
+                InetNtopW(AF_INET6, &address, expected, INET6_ADDRSTRLEN);
+                Assert::AreEqual(std::wstring(expected), Ipv6Text(address));
+            }
+        }
+
+        TEST_METHOD(FormatIpv6IsCanonical)
+        {
+            Logger::WriteMessage(L"FormatIpv6IsCanonical");
+
+            // RFC 5952 section 4 and 5 forms.
+            const wchar_t* canonical[] = {
+                L"::",
+                L"::1",
+                L"2001:db8::1",
+                L"2001:db8:0:1:1:1:1:1", // a single zero group is not compressed
+                L"2001:db8::1:0:0:1", // the first of two equal runs is compressed
+                L"2001:0:0:1::1", // the longest run is compressed
+                L"fe80::",
+                L"::ffff:192.0.2.1",
+            };
+            for (const auto& text : canonical)
+            {
+                IN6_ADDR address;
+                Assert::IsTrue(ntl::parse_ipv6(text, wcslen(text), &address));
+                Assert::AreEqual(std::wstring(text), Ipv6Text(address));
+            }
+
+            IN6_ADDR address;
+            const wchar_t upper[] = L"2001:0DB8:0000:0000:0000:0000:0000:0001";
+            Assert::IsTrue(ntl::parse_ipv6(upper, wcslen(upper), &address));
+            Assert::AreEqual(std::wstring(L"2001:db8::1"), Ipv6Text(address));
+        }
+
+        TEST_METHOD(FormatFailsWhenBufferTooSmall)
+        {
+            Logger::WriteMessage(L"FormatFailsWhenBufferTooSmall");
+
+            IN_ADDR address;
+            const char text[] = "192.168.100.21";
+            Assert::IsTrue(ntl::parse_ipv4(text, sizeof(text) - 1, &address));
+
+            char exact[sizeof(text)];
+            Assert::AreEqual(sizeof(text) - 1, ntl::format_ipv4(address, exact, sizeof(exact)));
+            Assert::AreEqual(std::string(text), std::string(exact));
+
+            char small[sizeof(text) - 1];
+            Assert::AreEqual(static_cast<size_t>(0), ntl::format_ipv4(address, small, sizeof(small)));
+        }
+
+        TEST_METHOD(ParseMatchesInetPton)
+        {
+            Logger::WriteMessage(L"ParseMatchesInetPton");
+
+            // Well-formed text with random edits, so both accepted and rejected input is compared.
+            static const wchar_t alphabet[] = L"0123456789abcdefABCDEFg:.%";
+            std::mt19937 generator(1234);
+            std::uniform_int_distribution<unsigned> edit(0, 3);
+            std::uniform_int_distribution<size_t> character(0, _countof(alphabet) - 2);
+            std::uniform_int_distribution<unsigned> octet(0, 255);
+
+            for (int i = 0; i < 100000; ++i)
+            {
+                std::wstring text;
+                if (i % 2 == 0)
+                {
+                    text = Ipv6Text(RandomIpv6Address(generator));
+                }
+                else
+                {
+                    IN_ADDR v4;
+                    unsigned char* bytes = reinterpret_cast<unsigned char*>(&v4);
+                    for (unsigned index = 0; index < sizeof(IN_ADDR); ++index)
+                    {
+                        bytes[index] = static_cast<unsigned char>(octet(generator));
+                    }
+                    WCHAR v4Text[ntl::IPV4_STRING_MAX_LENGTH];
+                    text.assign(v4Text, ntl::format_ipv4(v4, v4Text, ntl::IPV4_STRING_MAX_LENGTH));
+                }
+
+                unsigned edits = edit(generator);
+                for (unsigned e = 0; e < edits && !text.empty(); ++e)
+                {
+                    size_t position = std::uniform_int_distribution<size_t>(0, text.size() - 1)(generator);
+                    switch (edit(generator))
+                    {
+                    case 0: text.erase(position, 1); break;
+                    case 1: text.insert(position, 1, alphabet[character(generator)]); break;
+                    default: text[position] = alphabet[character(generator)]; break;
+                    }
+                }
+                if (HasLeadingZeroOctet(text))
+                {
+                    continue;
+                }
+
+                IN_ADDR expected4 = {}, actual4 = {};
+                bool expectedIpv4 = InetPtonW(AF_INET, text.c_str(), &expected4) == 1;
+                bool actualIpv4 = ntl::parse_ipv4(text.c_str(), text.size(), &actual4);
+                Assert::AreEqual(expectedIpv4, actualIpv4, text.c_str());
+                if (expectedIpv4)
+                {
+                    Assert::IsTrue(memcmp(&expected4, &actual4, sizeof(IN_ADDR)) == 0, text.c_str());
+                }
+
+                IN6_ADDR expected6 = {}, actual6 = {};
+                bool expectedIpv6 = InetPtonW(AF_INET6, text.c_str(), &expected6) == 1;
+                bool actualIpv6 = ntl::parse_ipv6(text.c_str(), text.size(), &actual6);
+                Assert::AreEqual(expectedIpv6, actualIpv6, text.c_str());
+                if (expectedIpv6)
+                {
+                    Assert::IsTrue(memcmp(&expected6, &actual6, sizeof(IN6_ADDR)) == 0, text.c_str());
+                }
+            }
+        }
+
+        TEST_METHOD(ParseRejectsMalformedText)
+        {
+            Logger::WriteMessage(L"ParseRejectsMalformedText");
+
+            const wchar_t* ipv4[] = { L"", L"1.2.3", L"1.2.3.4.5", L"256.1.1.1", L"1..2.3", L"1.2.3.4 ", L"a.b.c.d", L"1.2.3.-4" };
+            for (const auto& text : ipv4)
+            {
+                IN_ADDR address;
+                Assert::IsFalse(ntl::parse_ipv4(text, wcslen(text), &address), text);
+            }
+
+            const wchar_t* ipv6[] = { L"", L":", L":::", L"1::2::3", L"12345::", L"1:2:3:4:5:6:7", L"1:2:3:4:5:6:7:8:9",
+                L"1:2:3:4:5:6:7:8::", L"1:", L":1::", L"::1.2.3", L"1:2:3:4:5:6:7:1.2.3.4", L"fe80::1%1", L"g::" };
+            for (const auto& text : ipv6)
+            {
+                IN6_ADDR address;
+                Assert::IsFalse(ntl::parse_ipv6(text, wcslen(text), &address), text);
+            }
+        }
+    };
+
+    // Timings for the text conversions against the system functions; run with /TestCaseFilter:TestCategory=Benchmark.
+    TEST_CLASS(NtlSockaddrBenchmarks)
+    {
+    public:
+
+        BEGIN_TEST_METHOD_ATTRIBUTE(FormatAndParseThroughput)
+            TEST_METHOD_ATTRIBUTE(L"TestCategory", L"Benchmark")
+        END_TEST_METHOD_ATTRIBUTE()
+
+        TEST_METHOD(FormatAndParseThroughput)
+        {
+            Logger::WriteMessage(L"FormatAndParseThroughput");
+
+            const int iterations = 1000000;
+            std::mt19937 generator(1234);
+            std::vector<IN6_ADDR> addresses;
+            std::vector<std::wstring> texts;
+            for (int i = 0; i < 1024; ++i)
+            {
+                addresses.push_back(RandomIpv6Address(generator));
+                texts.push_back(Ipv6Text(addresses.back()));
+            }
+
+            size_t checksum = 0;
+            WCHAR buffer[INET6_ADDRSTRLEN];
+            IN6_ADDR parsed;
+
+            double systemFormat = NanosecondsPerCall(iterations, [&](int i)
+            {
+                InetNtopW(AF_INET6, &addresses[i & 1023], buffer, INET6_ADDRSTRLEN);
+                checksum += buffer[0];
+            });
+            double fastFormat = NanosecondsPerCall(iterations, [&](int i)
+            {
+                checksum += ntl::format_ipv6(addresses[i & 1023], buffer, INET6_ADDRSTRLEN);
+            });
+            double systemParse = NanosecondsPerCall(iterations, [&](int i)
+            {
+                checksum += InetPtonW(AF_INET6, texts[i & 1023].c_str(), &parsed);
+            });
+            double fastParse = NanosecondsPerCall(iterations, [&](int i)
+            {
+                const std::wstring& text = texts[i & 1023];
+                checksum += ntl::parse_ipv6(text.c_str(), text.size(), &parsed);
+            });
+
+            wchar_t report[256];
+            swprintf_s(report, L"IPv6 ns/call: InetNtopW %.1f, format_ipv6 %.1f, InetPtonW %.1f, parse_ipv6 %.1f",
+                systemFormat, fastFormat, systemParse, fastParse);
+            Logger::WriteMessage(report);
+            Assert::IsTrue(checksum > 0);
+        }
+
+    private:
+        template <typename Function>
+        static double NanosecondsPerCall(int iterations, Function function)
+        {
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < iterations; ++i)
+            {
+                function(i);
+            }
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) / iterations;
+        }
+    };
+}
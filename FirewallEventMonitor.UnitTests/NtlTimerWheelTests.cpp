@@ -0,0 +1,207 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include <CppUnitTest.h>
+// code under test headers
+#include "ntlTimerWheel.hpp"
+// c++ headers
+#include <map>
+#include <random>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace FirewallEventMonitorUnitTest
+{
+    TEST_CLASS(NtlTimerWheelTests)
+    {
+    public:
+
+        TEST_METHOD(TimersExpireOnTheirTickAtEveryLevel)
+        {
+            Logger::WriteMessage(L"TimersExpireOnTheirTickAtEveryLevel");
+
+            ntl::TimerWheel<long long> wheel;
+            wheel.advance(1000, [](long long) {});
+            // Ahead by less than one slot of each level, and past the last level.
+            std::vector<long long> ticks{ 1001, 1063, 1064, 1100, 5095, 5096, 300000, 17000000, 40000000 };
+            for (const auto& tick : ticks)
+            {
+                wheel.schedule(tick, tick);
+            }
+            Assert::AreEqual(ticks.size(), wheel.size());
+
+            for (const auto& tick : ticks)
+            {
+                std::vector<long long> expired;
+                wheel.advance(tick - 1, [&](long long value) { expired.push_back(value); });
+                Assert::IsTrue(expired.empty());
+                wheel.advance(tick, [&](long long value) { expired.push_back(value); });
+                Assert::AreEqual(static_cast<size_t>(1), expired.size());
+                Assert::AreEqual(tick, expired[0]);
+            }
+            Assert::AreEqual(static_cast<size_t>(0), wheel.size());
+        }
+
+        TEST_METHOD(CancelAndRescheduleKeepTimersConsistent)
+        {
+            Logger::WriteMessage(L"CancelAndRescheduleKeepTimersConsistent");
+
+            ntl::TimerWheel<int> wheel;
+            wheel.advance(0, [](int) {});
+            auto cancelled = wheel.schedule(10, 1);
+            auto moved = wheel.schedule(10, 2);
+            wheel.schedule(10, 3);
+
+            Assert::IsTrue(wheel.cancel(cancelled));
+            Assert::IsFalse(wheel.cancel(cancelled));
+            Assert::IsTrue(wheel.reschedule(moved, 5000));
+
+            std::vector<int> expired;
+            wheel.advance(10, [&](int value) { expired.push_back(value); });
+            Assert::AreEqual(static_cast<size_t>(1), expired.size());
+            Assert::AreEqual(3, expired[0]);
+
+            wheel.advance(4999, [&](int value) { expired.push_back(value); });
+            Assert::AreEqual(static_cast<size_t>(1), expired.size());
+            wheel.advance(5000, [&](int value) { expired.push_back(value); });
+            Assert::AreEqual(static_cast<size_t>(2), expired.size());
+            Assert::AreEqual(2, expired[1]);
+
+            // Ids of expired timers are stale, even once their node is reused.
+            auto reused = wheel.schedule(6000, 4);
+            Assert::IsFalse(wheel.cancel(moved));
+            Assert::IsFalse(wheel.reschedule(moved, 7000));
+            Assert::IsTrue(wheel.cancel(reused));
+            Assert::AreEqual(static_cast<size_t>(0), wheel.size());
+        }
+
+        TEST_METHOD(ClearLeavesOldIdsStale)
+        {
+            Logger::WriteMessage(L"ClearLeavesOldIdsStale");
+
+            ntl::TimerWheel<int> wheel;
+            wheel.advance(0, [](int) {});
+            auto cleared = wheel.schedule(10, 1);
+            auto expired = wheel.schedule(5, 2);
+            wheel.advance(5, [](int) {});
+            wheel.clear();
+            Assert::AreEqual(static_cast<size_t>(0), wheel.size());
+
+            // The new timers reuse the cleared nodes, under new generations.
+            auto first = wheel.schedule(20, 3);
+            auto second = wheel.schedule(20, 4);
+            Assert::IsFalse(wheel.cancel(cleared));
+            Assert::IsFalse(wheel.cancel(expired));
+            Assert::IsFalse(wheel.reschedule(cleared, 30));
+            Assert::AreEqual(static_cast<size_t>(2), wheel.size());
+
+            std::vector<int> values;
+            wheel.advance(20, [&](int value) { values.push_back(value); });
+            Assert::AreEqual(static_cast<size_t>(2), values.size());
+            Assert::IsFalse(wheel.cancel(first));
+            Assert::IsFalse(wheel.cancel(second));
+        }
+
+        TEST_METHOD(BudgetSpreadsExpiryOverCalls)
+        {
+            Logger::WriteMessage(L"BudgetSpreadsExpiryOverCalls");
+
+            ntl::TimerWheel<int> wheel;
+            wheel.advance(0, [](int) {});
+            for (int i = 0; i < 1000; ++i)
+            {
+                wheel.schedule(100, i);
+            }
+
+            size_t expired = wheel.advance(100, [](int) {}, 64);
+            Assert::IsTrue(expired < static_cast<size_t>(64));
+            Assert::IsTrue(wheel.lag() >= 0);
+
+            size_t calls = 1;
+            while (wheel.size() > 0)
+            {
+                Assert::IsTrue(wheel.advance(100, [](int) {}, 64) <= static_cast<size_t>(64));
+                ++calls;
+            }
+            Assert::IsTrue(calls >= static_cast<size_t>(1000 / 64));
+            Assert::AreEqual(0ll, wheel.lag());
+            Assert::AreEqual(100ll, wheel.current());
+        }
+
+        TEST_METHOD(LongGapIsSkippedCheaply)
+        {
+            Logger::WriteMessage(L"LongGapIsSkippedCheaply");
+
+            ntl::TimerWheel<int> wheel;
+            wheel.advance(0, [](int) {});
+            wheel.schedule(1000000000000ll, 1);
+
+            // A budget far smaller than the gap still reaches the timer, a level at a time.
+            std::vector<int> expired;
+            for (int call = 0; call < 100 && expired.empty(); ++call)
+            {
+                wheel.advance(1000000000000ll, [&](int value) { expired.push_back(value); }, 64);
+            }
+            Assert::AreEqual(static_cast<size_t>(1), expired.size());
+            Assert::AreEqual(1000000000000ll, wheel.current());
+        }
+
+        TEST_METHOD(RandomScheduleMatchesModel)
+        {
+            Logger::WriteMessage(L"RandomScheduleMatchesModel");
+
+            std::mt19937_64 generator(97);
+            ntl::TimerWheel<int> wheel;
+            std::map<int, std::pair<long long, ntl::TimerWheel<int>::timer_id>> live;
+            long long now = 0;
+            wheel.advance(now, [](int) {});
+            int next = 0;
+
+            for (int operation = 0; operation < 20000; ++operation)
+            {
+                long long ahead = static_cast<long long>(generator() % (operation % 7 == 0 ? 100000 : 200));
+                int choice = static_cast<int>(generator() % 10);
+                if (choice < 4)
+                {
+                    live[next] = { now + ahead, wheel.schedule(now + ahead, next) };
+                    ++next;
+                }
+                else if (choice < 6 && !live.empty())
+                {
+                    auto timer = live.lower_bound(static_cast<int>(generator() % next));
+                    if (timer != live.end())
+                    {
+                        Assert::IsTrue(wheel.reschedule(timer->second.second, now + ahead));
+                        timer->second.first = now + ahead;
+                    }
+                }
+                else if (choice < 7 && !live.empty())
+                {
+                    auto timer = live.lower_bound(static_cast<int>(generator() % next));
+                    if (timer != live.end())
+                    {
+                        Assert::IsTrue(wheel.cancel(timer->second.second));
+                        live.erase(timer);
+                    }
+                }
+                else
+                {
+                    now += static_cast<long long>(generator() % 50);
+                    wheel.advance(now, [&](int value)
+                    {
+                        auto timer = live.find(value);
+                        Assert::IsTrue(timer != live.end());
+                        Assert::IsTrue(timer->second.first <= now);
+                        live.erase(timer);
+                    });
+                    for (const auto& timer : live)
+                    {
+                        Assert::IsTrue(timer.second.first > now);
+                    }
+                }
+                Assert::AreEqual(live.size(), wheel.size());
+            }
+        }
+    };
+}
@@ -0,0 +1,225 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include <CppUnitTest.h>
+// code under test headers
+#include "ntlUuid.hpp"
+// os headers
+#include <Objbase.h>
+// c++ headers
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace FirewallEventMonitorUnitTest
+{
+    namespace
+    {
+        UUID RandomUuid(std::mt19937& generator)
+        {
+            UUID uuid;
+            unsigned char* bytes = reinterpret_cast<unsigned char*>(&uuid);
+            std::uniform_int_distribution<unsigned> byte(0, 255);
+            for (size_t index = 0; index < sizeof(UUID); ++index)
+            {
+                bytes[index] = static_cast<unsigned char>(byte(generator));
+            }
+            return uuid;
+        }
+
+        std::wstring SystemUuidToString(UUID uuid)
+        {
+            RPC_WSTR text = nullptr;
+            Assert::IsTrue(UuidToStringW(&uuid, &text) == RPC_S_OK);
+            std::wstring result(reinterpret_cast<wchar_t*>(text));
+            RpcStringFreeW(&text);
+            return result;
+        }
+    }
+
+    TEST_CLASS(NtlUuidTests)
+    {
+    public:
+
+        TEST_METHOD(FormatMatchesUuidToString)
+        {
+            Logger::WriteMessage(L"FormatMatchesUuidToString");
+
+            std::mt19937 generator(1234);
+            for (int i = 0; i < 10000; ++i)
+            {
+                UUID uuid = RandomUuid(generator);
+                wchar_t text[ntl::Uuid::UUID_STRING_LENGTH + 1];
+                Assert::AreEqual(ntl::Uuid::UUID_STRING_LENGTH, ntl::Uuid::format_uuid(uuid, text, _countof(text)));
+                Assert::AreEqual(SystemUuidToString(uuid), std::wstring(text));
+            }
+        }
+
+        TEST_METHOD(ParseAcceptsBracedAndUnbraced)
+        {
+            Logger::WriteMessage(L"ParseAcceptsBracedAndUnbraced");
+
+            std::mt19937 generator(1234);
+            for (int i = 0; i < 10000; ++i)
+            {
+                UUID expected = RandomUuid(generator);
+                std::wstring text = SystemUuidToString(expected);
+                if (i % 2 == 0)
+                {
+                    for (auto& character : text)
+                    {
+                        character = static_cast<wchar_t>(towupper(character));
+                    }
+                }
+
+                UUID unbraced;
+                Assert::IsTrue(ntl::Uuid::parse_uuid(text.c_str(), text.size(), &unbraced));
+                Assert::IsTrue(expected == unbraced);
+
+                std::wstring bracedText = L"{" + text + L"}";
+                UUID braced;
+                Assert::IsTrue(ntl::Uuid::parse_uuid(bracedText.c_str(), bracedText.size(), &braced));
+                Assert::IsTrue(expected == braced);
+
+                CLSID clsid;
+                Assert::IsTrue(SUCCEEDED(CLSIDFromString(bracedText.c_str(), &clsid)));
+                Assert::IsTrue(clsid == braced);
+            }
+        }
+
+        TEST_METHOD(ParseMatchesUuidFromString)
+        {
+            Logger::WriteMessage(L"ParseMatchesUuidFromString");
+
+            // Valid text with one character replaced, so both outcomes are compared.
+            static const wchar_t alphabet[] = L"0123456789abcdefABCDEFgG-{} x";
+            std::mt19937 generator(1234);
+            std::uniform_int_distribution<size_t> position(0, ntl::Uuid::UUID_STRING_LENGTH - 1);
+            std::uniform_int_distribution<size_t> character(0, _countof(alphabet) - 2);
+            for (int i = 0; i < 100000; ++i)
+            {
+                std::wstring text = SystemUuidToString(RandomUuid(generator));
+                text[position(generator)] = alphabet[character(generator)];
+
+                UUID expected, actual;
+                bool systemResult = UuidFromStringW(reinterpret_cast<RPC_WSTR>(&text[0]), &expected) == RPC_S_OK;
+                bool result = ntl::Uuid::parse_uuid(text.c_str(), text.size(), &actual);
+                Assert::AreEqual(systemResult, result, text.c_str());
+                if (result)
+                {
+                    Assert::IsTrue(expected == actual, text.c_str());
+                }
+            }
+        }
+
+        TEST_METHOD(ParseRejectsMalformedText)
+        {
+            Logger::WriteMessage(L"ParseRejectsMalformedText");
+
+            const wchar_t* malformed[] = {
+                L"",
+                L"8a4bdc650eb5",
+                L"51b87f66-e400-424a-a649-8a4bdc650eb",
+                L"51b87f66-e400-424a-a649-8a4bdc650eb5a",
+                L"{51b87f66-e400-424a-a649-8a4bdc650eb5",
+                L"51b87f66-e400-424a-a649-8a4bdc650eb5}",
+                L"(51b87f66-e400-424a-a649-8a4bdc650eb5)",
+                L"51b87f66e400-424a-a649-8a4bdc650eb5-",
+                L"51b87f66-e400-424a-a649-8a4bdc650eg5",
+                L"51b87f66-e400-424a-a649-8a4bdc650e\u00e95",
+            };
+            for (const auto& text : malformed)
+            {
+                UUID uuid;
+                Assert::IsFalse(ntl::Uuid::parse_uuid(text, wcslen(text), &uuid), text);
+            }
+        }
+
+        TEST_METHOD(FormatFailsWhenBufferTooSmall)
+        {
+            Logger::WriteMessage(L"FormatFailsWhenBufferTooSmall");
+
+            UUID uuid = {};
+            char text[ntl::Uuid::UUID_STRING_LENGTH];
+            Assert::AreEqual(static_cast<size_t>(0), ntl::Uuid::format_uuid(uuid, text, _countof(text)));
+        }
+    };
+
+    // Timings for the codec against the Win32 functions; run with /TestCaseFilter:TestCategory=Benchmark.
+    TEST_CLASS(NtlUuidBenchmarks)
+    {
+    public:
+
+        BEGIN_TEST_METHOD_ATTRIBUTE(FormatAndParseThroughput)
+            TEST_METHOD_ATTRIBUTE(L"TestCategory", L"Benchmark")
+        END_TEST_METHOD_ATTRIBUTE()
+
+        TEST_METHOD(FormatAndParseThroughput)
+        {
+            Logger::WriteMessage(L"FormatAndParseThroughput");
+
+            const int iterations = 1000000;
+            std::mt19937 generator(1234);
+            std::vector<UUID> uuids;
+            std::vector<std::wstring> texts;
+            std::vector<std::wstring> bracedTexts;
+            for (int i = 0; i < 1024; ++i)
+            {
+                uuids.push_back(RandomUuid(generator));
+                texts.push_back(SystemUuidToString(uuids.back()));
+                bracedTexts.push_back(L"{" + texts.back() + L"}");
+            }
+
+            size_t checksum = 0;
+            UUID parsed;
+
+            double systemFormat = NanosecondsPerCall(iterations, [&](int i)
+            {
+                RPC_WSTR text = nullptr;
+                UuidToStringW(&uuids[i & 1023], &text);
+                checksum += text[0];
+                RpcStringFreeW(&text);
+            });
+            double fastFormat = NanosecondsPerCall(iterations, [&](int i)
+            {
+                wchar_t text[ntl::Uuid::UUID_STRING_LENGTH + 1];
+                checksum += ntl::Uuid::format_uuid(uuids[i & 1023], text, _countof(text));
+            });
+            double systemParse = NanosecondsPerCall(iterations, [&](int i)
+            {
+                checksum += UuidFromStringW(reinterpret_cast<RPC_WSTR>(&texts[i & 1023][0]), &parsed) == RPC_S_OK;
+            });
+            double clsidParse = NanosecondsPerCall(iterations, [&](int i)
+            {
+                checksum += SUCCEEDED(CLSIDFromString(bracedTexts[i & 1023].c_str(), &parsed));
+            });
+            double fastParse = NanosecondsPerCall(iterations, [&](int i)
+            {
+                const std::wstring& text = texts[i & 1023];
+                checksum += ntl::Uuid::parse_uuid(text.c_str(), text.size(), &parsed);
+            });
+
+            wchar_t report[256];
+            swprintf_s(report, L"UUID ns/call: UuidToStringW %.1f, format_uuid %.1f, UuidFromStringW %.1f, CLSIDFromString %.1f, parse_uuid %.1f",
+                systemFormat, fastFormat, systemParse, clsidParse, fastParse);
+            Logger::WriteMessage(report);
+            Assert::IsTrue(checksum > 0);
+        }
+
+    private:
+        template <typename Function>
+        static double NanosecondsPerCall(int iterations, Function function)
+        {
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < iterations; ++i)
+            {
+                function(i);
+            }
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) / iterations;
+        }
+    };
+}
@@ -0,0 +1,222 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include <CppUnitTest.h>
+// code under test headers
+#include "OverlappedLogFile.h"
+// c++ headers
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace FirewallEventMonitor;
+
+namespace FirewallEventMonitorUnitTest
+{
+    namespace
+    {
+        std::wstring TempLogPath(const wchar_t* name)
+        {
+            WCHAR directory[MAX_PATH] = L"";
+            ::GetTempPathW(MAX_PATH, directory);
+            return std::wstring(directory) + name;
+        }
+
+        std::string ReadWholeFile(const std::wstring& path)
+        {
+            FILE* file = NULL;
+            Assert::AreEqual(0, _wfopen_s(&file, path.c_str(), L"rb"));
+            std::string contents;
+            char buffer[4096];
+            size_t read = 0;
+            while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+            {
+                contents.append(buffer, read);
+            }
+            fclose(file);
+            return contents;
+        }
+    }
+
+    TEST_CLASS(OverlappedLogFileTests)
+    {
+    public:
+
+        TEST_METHOD_INITIALIZE(MethodInit)
+        {
+            m_Path = TempLogPath(L"OverlappedLogFileTests.log");
+            _wremove(m_Path.c_str());
+        }
+
+        TEST_METHOD_CLEANUP(MethodCleanup)
+        {
+            _wremove(m_Path.c_str());
+        }
+
+        TEST_METHOD(RecordsContinueAcrossBuffersInOrder)
+        {
+            Logger::WriteMessage(L"RecordsContinueAcrossBuffersInOrder");
+
+            std::string expected;
+            OverlappedWriteReport report;
+            {
+                OverlappedLogFile file(m_Path, SmallBufferBytes, 2);
+                // Records that do not divide the buffer evenly, so buffers end part way into one,
+                // and more buffers than the pool holds, so buffers are reused.
+                for (int i = 0; i < 1000; ++i)
+                {
+                    std::string record = "record " + std::to_string(i) + " " + std::string(900, 'x') + "\r\n";
+                    Assert::IsTrue(file.Append(record.data(), record.size()));
+                    expected += record;
+                }
+                Assert::AreEqual(static_cast<unsigned long long>(expected.size()), file.GetLength());
+                file.Close();
+                report = file.GetReport();
+            }
+
+            Assert::AreEqual(expected, ReadWholeFile(m_Path));
+            Assert::AreEqual((expected.size() + SmallBufferBytes - 1) / SmallBufferBytes, static_cast<size_t>(report.writesIssued));
+            Assert::AreEqual(static_cast<unsigned long long>(expected.size()), report.bytesCompleted);
+            Assert::AreEqual(0ull, report.writeErrors);
+            Assert::AreEqual(static_cast<size_t>(0), report.writesInFlight);
+        }
+
+        TEST_METHOD(FlushWritesPartlyFilledBuffer)
+        {
+            Logger::WriteMessage(L"FlushWritesPartlyFilledBuffer");
+
+            OverlappedLogFile file(m_Path, SmallBufferBytes, 2);
+            Assert::IsTrue(file.Append("first\r\n", 7));
+            file.Flush();
+            Assert::IsTrue(file.Append("second\r\n", 8));
+            file.Flush();
+            // Nothing to submit.
+            file.Flush();
+            Assert::AreEqual(2ull, file.GetReport().writesIssued);
+
+            file.Close();
+            Assert::AreEqual(std::string("first\r\nsecond\r\n"), ReadWholeFile(m_Path));
+            Assert::IsFalse(file.Append("late\r\n", 6));
+        }
+
+        TEST_METHOD(ConcurrentWritersKeepEveryRecordWhole)
+        {
+            Logger::WriteMessage(L"ConcurrentWritersKeepEveryRecordWhole");
+
+            const int threadCount = 4;
+            const int recordsPerThread = 20000;
+            {
+                OverlappedLogFile file(m_Path, SmallBufferBytes, 3);
+                std::vector<std::thread> writers;
+                for (int writer = 0; writer < threadCount; ++writer)
+                {
+                    writers.emplace_back([&file, writer, recordsPerThread]()
+                    {
+                        char record[32];
+                        for (int i = 0; i < recordsPerThread; ++i)
+                        {
+                            int length = sprintf_s(record, "%d %08d\r\n", writer, i);
+                            file.Append(record, static_cast<size_t>(length));
+                        }
+                    });
+                }
+                for (auto& writer : writers)
+                {
+                    writer.join();
+                }
+            }
+
+            // Each writer's records are whole and in its own order, though 12 bytes do not
+            // divide the buffer and records are split across writes.
+            std::string contents = ReadWholeFile(m_Path);
+            const size_t recordBytes = 12;
+            Assert::AreEqual(static_cast<size_t>(threadCount * recordsPerThread) * recordBytes, contents.size());
+            std::vector<int> next(threadCount, 0);
+            for (size_t offset = 0; offset < contents.size(); offset += recordBytes)
+            {
+                int writer = -1;
+                int i = -1;
+                Assert::AreEqual(2, sscanf_s(contents.c_str() + offset, "%d %08d", &writer, &i));
+                Assert::IsTrue(writer >= 0 && writer < threadCount);
+                Assert::AreEqual(next[writer], i);
+                Assert::AreEqual('\n', contents[offset + recordBytes - 1]);
+                ++next[writer];
+            }
+        }
+
+    private:
+        std::wstring m_Path;
+
+        static const size_t SmallBufferBytes = 64 * 1024;
+    };
+
+    // Sustained write rates against a FILE; run with /TestCaseFilter:TestCategory=Benchmark.
+    TEST_CLASS(OverlappedLogFileBenchmarks)
+    {
+    public:
+
+        BEGIN_TEST_METHOD_ATTRIBUTE(SustainedWriteThroughput)
+            TEST_METHOD_ATTRIBUTE(L"TestCategory", L"Benchmark")
+        END_TEST_METHOD_ATTRIBUTE()
+
+        TEST_METHOD(SustainedWriteThroughput)
+        {
+            Logger::WriteMessage(L"SustainedWriteThroughput");
+
+            // Log records of a typical length, 1 GB of them.
+            const std::string record = std::string(180, 'x') + "\r\n";
+            const size_t totalBytes = 1024ull * 1024 * 1024;
+            const size_t records = totalBytes / record.size();
+            const std::wstring path = TempLogPath(L"OverlappedLogFileBenchmarks.log");
+
+            double fileRate = GigabytesPerSecond(records * record.size(), [&]()
+            {
+                FILE* file = NULL;
+                Assert::AreEqual(0, _wfopen_s(&file, path.c_str(), L"wb"));
+                // As FileLogger buffers its FILE.
+                setvbuf(file, NULL, _IOFBF, 64 * 1024);
+                for (size_t i = 0; i < records; ++i)
+                {
+                    fwrite(record.data(), 1, record.size(), file);
+                }
+                fclose(file);
+            });
+
+            OverlappedWriteReport report;
+            double overlappedRate = GigabytesPerSecond(records * record.size(), [&]()
+            {
+                OverlappedLogFile file(path);
+                for (size_t i = 0; i < records; ++i)
+                {
+                    file.Append(record.data(), record.size());
+                }
+                file.Close();
+                report = file.GetReport();
+            });
+            _wremove(path.c_str());
+
+            wchar_t message[256];
+            swprintf_s(message, L"GB/s: FILE %.2f, OverlappedLogFile %.2f (%llu writes, %llu buffer waits)",
+                fileRate,
+                overlappedRate,
+                report.writesIssued,
+                report.bufferWaits);
+            Logger::WriteMessage(message);
+            Assert::AreEqual(static_cast<unsigned long long>(records * record.size()), report.bytesCompleted);
+        }
+
+    private:
+        template <typename Function>
+        static double GigabytesPerSecond(size_t bytes, Function function)
+        {
+            auto start = std::chrono::steady_clock::now();
+            function();
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            double seconds = std::chrono::duration_cast<std::chrono::duration<double>>(elapsed).count();
+            return static_cast<double>(bytes) / (1024.0 * 1024.0 * 1024.0) / seconds;
+        }
+    };
+}
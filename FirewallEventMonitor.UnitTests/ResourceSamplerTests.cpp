@@ -0,0 +1,67 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include <CppUnitTest.h>
+// code under test headers
+#include "ResourceSampler.h"
+// os headers
+#include <Windows.h>
+// c++ headers
+#include <memory>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace FirewallEventMonitor;
+
+namespace FirewallEventMonitorUnitTest
+{
+    TEST_CLASS(ResourceSamplerTests)
+    {
+    public:
+
+        TEST_METHOD_INITIALIZE(MethodInit)
+        {
+            m_Sampler = std::make_shared<ResourceSampler>();
+        }
+
+        TEST_METHOD(SampleReportsProcessCounters)
+        {
+            Logger::WriteMessage(L"SampleReportsProcessCounters");
+
+            ResourceUsage usage = m_Sampler->Sample();
+
+            Assert::IsTrue(usage.residentBytes > 0);
+            Assert::IsTrue(usage.handleCount > 0);
+            Assert::IsTrue(usage.threadCount > 0);
+        }
+
+        TEST_METHOD(CpuPercentWithinBounds)
+        {
+            Logger::WriteMessage(L"CpuPercentWithinBounds");
+
+            // Spin for a short while so there is CPU time to measure.
+            ULONGLONG start = GetTickCount64();
+            volatile unsigned long long spin = 0;
+            while (GetTickCount64() - start < 200)
+            {
+                spin++;
+            }
+
+            ResourceUsage usage = m_Sampler->Sample();
+            Assert::IsTrue(usage.cpuPercent > 0.0);
+            Assert::IsTrue(usage.cpuPercent <= 100.0);
+            Assert::IsTrue(usage.averageCpuPercent <= 100.0);
+        }
+
+        TEST_METHOD(LastSampleMatchesSample)
+        {
+            Logger::WriteMessage(L"LastSampleMatchesSample");
+
+            ResourceUsage usage = m_Sampler->Sample();
+            Assert::AreEqual(usage.threadCount, m_Sampler->GetLastSample().threadCount);
+            Assert::AreEqual(usage.handleCount, m_Sampler->GetLastSample().handleCount);
+        }
+
+    private:
+        std::shared_ptr<ResourceSampler> m_Sampler;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,152 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include <CppUnitTest.h>
+// code under test headers
+#include "RuleAnomalyDetector.h"
+// c++ headers
+#include <memory>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace FirewallEventMonitor;
+
+namespace FirewallEventMonitorUnitTest
+{
+    TEST_CLASS(RuleAnomalyDetectorTests)
+    {
+    public:
+
+        TEST_METHOD_INITIALIZE(MethodInit)
+        {
+            m_Detector = std::make_shared<RuleAnomalyDetector>(
+                ZScoreThreshold,
+                RatioThreshold,
+                16);
+        }
+
+        TEST_METHOD(SteadyRateRaisesNoAlerts)
+        {
+            Logger::WriteMessage(L"SteadyRateRaisesNoAlerts");
+
+            RecordSeconds(MakeRecord(1, RuleAction::Deny), 0, 600, 5);
+
+            Assert::AreEqual(static_cast<size_t>(0), m_Detector->TakeAlerts().size());
+        }
+
+        TEST_METHOD(SpikeRaisesOneAlertPerSecond)
+        {
+            Logger::WriteMessage(L"SpikeRaisesOneAlertPerSecond");
+
+            CompactEventRecord record = MakeRecord(1, RuleAction::Deny);
+            RecordSeconds(record, 0, 600, 5);
+            // 50x the normal rate.
+            RecordSeconds(record, 600, 2, 250);
+
+            auto alerts = m_Detector->TakeAlerts();
+            Assert::AreEqual(static_cast<size_t>(2), alerts.size());
+            Assert::IsTrue(alerts[0].ruleId == record.ruleId);
+            Assert::IsTrue(alerts[0].action == RuleAction::Deny);
+            // Raised as soon as the count crosses the threshold, not at the end of the second.
+            Assert::IsTrue(alerts[0].zScore >= ZScoreThreshold);
+            Assert::IsTrue(alerts[0].count < 250ul);
+            Assert::AreEqual(5.0, alerts[0].baseline, 0.5);
+
+            // Alerts are only reported once.
+            Assert::AreEqual(static_cast<size_t>(0), m_Detector->TakeAlerts().size());
+        }
+
+        TEST_METHOD(NoAlertsDuringWarmup)
+        {
+            Logger::WriteMessage(L"NoAlertsDuringWarmup");
+
+            CompactEventRecord record = MakeRecord(1, RuleAction::Deny);
+            RecordSeconds(record, 0, 10, 1);
+            RecordSeconds(record, 10, 1, 1000);
+
+            Assert::AreEqual(static_cast<size_t>(0), m_Detector->TakeAlerts().size());
+        }
+
+        TEST_METHOD(RulesAreTrackedIndependently)
+        {
+            Logger::WriteMessage(L"RulesAreTrackedIndependently");
+
+            CompactEventRecord busy = MakeRecord(1, RuleAction::Allow);
+            CompactEventRecord quiet = MakeRecord(2, RuleAction::Deny);
+            for (LONGLONG second = 0; second < 600; ++second)
+            {
+                RecordSeconds(busy, second, 1, 500);
+                RecordSeconds(quiet, second, 1, 1);
+            }
+            RecordSeconds(busy, 600, 1, 500);
+            RecordSeconds(quiet, 600, 1, 100);
+
+            auto alerts = m_Detector->TakeAlerts();
+            Assert::AreEqual(static_cast<size_t>(1), alerts.size());
+            Assert::IsTrue(alerts[0].ruleId == quiet.ruleId);
+            Assert::AreEqual(static_cast<size_t>(2), m_Detector->GetRuleCount());
+        }
+
+        TEST_METHOD(RuleTableIsBounded)
+        {
+            Logger::WriteMessage(L"RuleTableIsBounded");
+
+            for (unsigned long i = 0; i < 20; ++i)
+            {
+                m_Detector->RecordEvent(MakeRecord(i, RuleAction::Allow));
+            }
+
+            Assert::AreEqual(static_cast<size_t>(16), m_Detector->GetRuleCount());
+            Assert::AreEqual(4ull, m_Detector->GetRulesRejected());
+        }
+
+        TEST_METHOD(IdleRulesExpireWithEventTime)
+        {
+            Logger::WriteMessage(L"IdleRulesExpireWithEventTime");
+
+            CompactEventRecord stale = MakeRecord(1, RuleAction::Allow);
+            CompactEventRecord active = MakeRecord(2, RuleAction::Allow);
+            RecordSeconds(stale, 0, 1, 1);
+            RecordSeconds(active, 0, 1, 1);
+            // A hit a second later moves the active rule's expiry.
+            RecordSeconds(active, 1, 1, 1);
+
+            RecordSeconds(active, RuleAnomalyDetector::IdleRuleExpirySeconds, 1, 1);
+            Assert::AreEqual(static_cast<size_t>(2), m_Detector->GetRuleCount());
+            RecordSeconds(active, RuleAnomalyDetector::IdleRuleExpirySeconds + 1, 1, 1);
+            Assert::AreEqual(static_cast<size_t>(1), m_Detector->GetRuleCount());
+        }
+
+    private:
+        std::shared_ptr<RuleAnomalyDetector> m_Detector;
+
+        const double ZScoreThreshold = 6.0;
+        const double RatioThreshold = 10.0;
+
+        // Arbitrary fixed start time (FILETIME, 100ns units).
+        const LONGLONG StartTime = 132000000000000000LL;
+
+        static CompactEventRecord MakeRecord(unsigned long rule, RuleAction action)
+        {
+            CompactEventRecord record;
+            record.ruleId.Data1 = rule;
+            record.action = action;
+            return record;
+        }
+
+        void RecordSeconds(
+            CompactEventRecord record,
+            LONGLONG firstSecond,
+            LONGLONG seconds,
+            unsigned long hitsPerSecond)
+        {
+            for (LONGLONG second = firstSecond; second < firstSecond + seconds; ++second)
+            {
+                for (unsigned long hit = 0; hit < hitsPerSecond; ++hit)
+                {
+                    record.timeStamp = StartTime + second * 10000000LL + hit;
+                    m_Detector->RecordEvent(record);
+                }
+            }
+        }
+    };
+}
@@ -0,0 +1,138 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include <CppUnitTest.h>
+// code under test headers
+#include "RuleUsageTracker.h"
+// c++ headers
+#include <memory>
+#include <sstream>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace FirewallEventMonitor;
+
+namespace FirewallEventMonitorUnitTest
+{
+    TEST_CLASS(RuleUsageTrackerTests)
+    {
+    public:
+
+        TEST_METHOD_INITIALIZE(MethodInit)
+        {
+            m_Tracker = std::make_shared<RuleUsageTracker>(8);
+        }
+
+        TEST_METHOD(HitsAreSplitByActionAndDirection)
+        {
+            Logger::WriteMessage(L"HitsAreSplitByActionAndDirection");
+
+            m_Tracker->RecordEvent(MakeRecord(1, RuleAction::Allow, TrafficDirection::Inbound, 3));
+            m_Tracker->RecordEvent(MakeRecord(1, RuleAction::Allow, TrafficDirection::Outbound, 1));
+            m_Tracker->RecordEvent(MakeRecord(1, RuleAction::Deny, TrafficDirection::Inbound, 2));
+            m_Tracker->RecordEvent(MakeRecord(1, RuleAction::Deny, TrafficDirection::Inbound, 5));
+
+            auto report = m_Tracker->GetReport();
+            Assert::AreEqual(static_cast<size_t>(1), report.size());
+            const RuleUsage& usage = report[0].usage;
+            Assert::AreEqual(1ull, usage.allowInbound);
+            Assert::AreEqual(1ull, usage.allowOutbound);
+            Assert::AreEqual(2ull, usage.denyInbound);
+            Assert::AreEqual(0ull, usage.denyOutbound);
+            Assert::AreEqual(4ull, usage.TotalHits());
+            Assert::AreEqual(MakeRecord(1, RuleAction::Allow, TrafficDirection::Inbound, 1).timeStamp, usage.firstHit);
+            Assert::AreEqual(MakeRecord(1, RuleAction::Allow, TrafficDirection::Inbound, 5).timeStamp, usage.lastHit);
+        }
+
+        TEST_METHOD(ReportIsSortedByHits)
+        {
+            Logger::WriteMessage(L"ReportIsSortedByHits");
+
+            m_Tracker->RecordEvent(MakeRecord(1, RuleAction::Allow, TrafficDirection::Inbound, 1));
+            for (int i = 0; i < 3; ++i)
+            {
+                m_Tracker->RecordEvent(MakeRecord(2, RuleAction::Deny, TrafficDirection::Inbound, 1));
+            }
+
+            auto report = m_Tracker->GetReport();
+            Assert::AreEqual(static_cast<size_t>(2), report.size());
+            Assert::AreEqual(2ul, static_cast<unsigned long>(report[0].ruleId.Data1));
+            Assert::AreEqual(1ul, static_cast<unsigned long>(report[1].ruleId.Data1));
+        }
+
+        TEST_METHOD(CatalogRulesWithoutHitsAreNeverHit)
+        {
+            Logger::WriteMessage(L"CatalogRulesWithoutHitsAreNeverHit");
+
+            std::wistringstream catalog(
+                L"# policy export\n"
+                L"00000001-0000-0000-0000-000000000000,web allow\n"
+                L"\n"
+                L"{00000002-0000-0000-0000-000000000000}\n"
+                L"  00000003-0000-0000-0000-000000000000  \n"
+                L"not-a-guid\n");
+            Assert::AreEqual(static_cast<size_t>(3), m_Tracker->LoadCatalog(catalog));
+
+            m_Tracker->RecordEvent(MakeRecord(1, RuleAction::Allow, TrafficDirection::Inbound, 1));
+            m_Tracker->RecordEvent(MakeRecord(4, RuleAction::Allow, TrafficDirection::Inbound, 1));
+
+            Assert::AreEqual(static_cast<size_t>(4), m_Tracker->GetRuleCount());
+            Assert::AreEqual(static_cast<size_t>(2), m_Tracker->GetNeverHitCount());
+            Assert::AreEqual(static_cast<size_t>(1), m_Tracker->GetNotInCatalogCount());
+        }
+
+        TEST_METHOD(RuleTableIsBounded)
+        {
+            Logger::WriteMessage(L"RuleTableIsBounded");
+
+            for (unsigned long rule = 0; rule < 10; ++rule)
+            {
+                m_Tracker->RecordEvent(MakeRecord(rule, RuleAction::Allow, TrafficDirection::Inbound, 1));
+            }
+            Assert::AreEqual(static_cast<size_t>(8), m_Tracker->GetRuleCount());
+            Assert::AreEqual(2ull, m_Tracker->GetRulesRejected());
+        }
+
+        TEST_METHOD(CsvHasHeaderAndOneRowPerRule)
+        {
+            Logger::WriteMessage(L"CsvHasHeaderAndOneRowPerRule");
+
+            m_Tracker->RecordEvent(MakeRecord(1, RuleAction::Deny, TrafficDirection::Outbound, 1));
+            std::wstring csv = RuleUsageTracker::FormatCsv(m_Tracker->GetReport());
+
+            Assert::AreEqual(0u, static_cast<unsigned>(csv.find(L"ruleId,inCatalog,totalHits,")));
+            Assert::AreEqual(2, static_cast<int>(std::count(csv.begin(), csv.end(), L'\n')));
+            Assert::IsTrue(csv.find(L"00000001-0000-0000-0000-000000000000,false,1,0,0,0,1,") != std::wstring::npos);
+        }
+
+        TEST_METHOD(JsonListsNeverHitRulesWithNullTimes)
+        {
+            Logger::WriteMessage(L"JsonListsNeverHitRulesWithNullTimes");
+
+            std::wistringstream catalog(L"00000001-0000-0000-0000-000000000000\n");
+            m_Tracker->LoadCatalog(catalog);
+            std::wstring json = RuleUsageTracker::FormatJson(m_Tracker->GetReport());
+
+            Assert::IsTrue(json.find(L"\"ruleId\": \"00000001-0000-0000-0000-000000000000\"") != std::wstring::npos);
+            Assert::IsTrue(json.find(L"\"inCatalog\": true") != std::wstring::npos);
+            Assert::IsTrue(json.find(L"\"firstHit\": null") != std::wstring::npos);
+            Assert::AreEqual(L"{\n  \"rules\": []\n}\n", RuleUsageTracker::FormatJson({}).c_str());
+        }
+
+    private:
+        std::shared_ptr<RuleUsageTracker> m_Tracker;
+
+        static CompactEventRecord MakeRecord(
+            unsigned long rule,
+            RuleAction action,
+            TrafficDirection direction,
+            LONGLONG second)
+        {
+            CompactEventRecord record;
+            record.timeStamp = (13200000000LL + second) * 10000000LL;
+            record.ruleId.Data1 = rule;
+            record.action = action;
+            record.direction = direction;
+            return record;
+        }
+    };
+}
@@ -0,0 +1,151 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include <CppUnitTest.h>
+// code under test headers
+#include "SchemaRegistry.h"
+#include "CompactEventRecord.h"
+// c++ headers
+#include <sstream>
+#include <string>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace FirewallEventMonitor;
+
+namespace FirewallEventMonitorUnitTest
+{
+    TEST_CLASS(SchemaRegistryTests)
+    {
+    public:
+
+        TEST_METHOD(VfpEventsAreRegisteredForEveryVersion)
+        {
+            Logger::WriteMessage(L"VfpEventsAreRegisteredForEveryVersion");
+
+            const SchemaRegistry& vfp = SchemaRegistry::Vfp();
+            Assert::AreEqual(static_cast<size_t>(3), vfp.GetSchemaCount());
+            Assert::AreEqual(static_cast<size_t>(1), vfp.GetProviders().size());
+            Assert::IsTrue(memcmp(&VfpProvider, &vfp.GetProviders()[0], sizeof(GUID)) == 0);
+
+            const EventSchema* ipv6 = vfp.Find(VfpProvider, 401, 7);
+            Assert::IsNotNull(ipv6);
+            Assert::AreEqual(std::wstring(L"VfpIpv6RuleMatch"), ipv6->name);
+            Assert::AreEqual(std::wstring(L"SrcIpv6Addr"), ipv6->fields[0].property);
+            Assert::IsNotNull(vfp.Find(VfpProvider, 400, 0));
+            Assert::IsNotNull(vfp.Find(VfpProvider, 402, 0));
+            Assert::IsNull(vfp.Find(VfpProvider, 110, 0));
+            Assert::IsNull(vfp.Find(OtherProvider, 400, 0));
+        }
+
+        TEST_METHOD(EveryRegisteredKeyIsFoundInItsOwnSlot)
+        {
+            Logger::WriteMessage(L"EveryRegisteredKeyIsFoundInItsOwnSlot");
+
+            SchemaRegistry registry;
+            for (USHORT eventId = 1; eventId <= 300; ++eventId)
+            {
+                registry.Register(MakeSchema(OtherProvider, eventId, static_cast<USHORT>(eventId % 3)));
+            }
+            Assert::AreEqual(static_cast<size_t>(300), registry.GetSchemaCount());
+            Assert::IsTrue(registry.GetTableSize() >= static_cast<size_t>(600));
+
+            for (USHORT eventId = 1; eventId <= 300; ++eventId)
+            {
+                const EventSchema* schema = registry.Find(OtherProvider, eventId, static_cast<UCHAR>(eventId % 3));
+                Assert::IsNotNull(schema);
+                Assert::AreEqual(static_cast<int>(eventId), static_cast<int>(schema->eventId));
+                // Same id, another version, and no AnyVersion entry.
+                Assert::IsNull(registry.Find(OtherProvider, eventId, static_cast<UCHAR>(eventId % 3 + 1)));
+            }
+            Assert::IsNull(registry.Find(OtherProvider, 301, 0));
+            Assert::IsNull(registry.Find(VfpProvider, 1, 1));
+        }
+
+        TEST_METHOD(ExactVersionIsPreferredOverAnyVersion)
+        {
+            Logger::WriteMessage(L"ExactVersionIsPreferredOverAnyVersion");
+
+            SchemaRegistry registry;
+            EventSchema any = MakeSchema(OtherProvider, 5152, SchemaRegistry::AnyVersion);
+            any.name = L"Any";
+            EventSchema exact = MakeSchema(OtherProvider, 5152, 1);
+            exact.name = L"Exact";
+            registry.Register(any);
+            registry.Register(exact);
+
+            Assert::AreEqual(std::wstring(L"Exact"), registry.Find(OtherProvider, 5152, 1)->name);
+            Assert::AreEqual(std::wstring(L"Any"), registry.Find(OtherProvider, 5152, 0)->name);
+        }
+
+        TEST_METHOD(RegisterRejectsDuplicatesAndEmptySchemas)
+        {
+            Logger::WriteMessage(L"RegisterRejectsDuplicatesAndEmptySchemas");
+
+            SchemaRegistry registry;
+            registry.Register(MakeSchema(OtherProvider, 1, 0));
+            Assert::ExpectException<std::exception>([&registry, this]() { registry.Register(MakeSchema(OtherProvider, 1, 0)); });
+
+            EventSchema empty = MakeSchema(OtherProvider, 2, 0);
+            empty.fields.clear();
+            Assert::ExpectException<std::exception>([&registry, &empty]() { registry.Register(empty); });
+            Assert::AreEqual(static_cast<size_t>(1), registry.GetSchemaCount());
+        }
+
+        TEST_METHOD(LoadSchemasSkipsMalformedLines)
+        {
+            Logger::WriteMessage(L"LoadSchemasSkipsMalformedLines");
+
+            std::wistringstream schemas(
+                L"# provider id version name fields\n"
+                L"\n"
+                L"{0C478C91-0000-4E6A-9D4C-2D5C9F1A0001} 5152 * Drop SourceAddress=Source,DestAddress=Destination,Protocol=Protocol\n"
+                L"0C478C91-0000-4E6A-9D4C-2D5C9F1A0001 5157 2 Block SourceAddress=Source\n"
+                L"not-a-guid 1 0 Bad SourceAddress=Source\n"
+                L"0C478C91-0000-4E6A-9D4C-2D5C9F1A0001 70000 0 Bad SourceAddress=Source\n"
+                L"0C478C91-0000-4E6A-9D4C-2D5C9F1A0001 1 300 Bad SourceAddress=Source\n"
+                L"0C478C91-0000-4E6A-9D4C-2D5C9F1A0001 1 0 Bad SourceAddress=NoSuchField\n"
+                L"0C478C91-0000-4E6A-9D4C-2D5C9F1A0001 1 0 Bad\n"
+                L"0C478C91-0000-4E6A-9D4C-2D5C9F1A0001 5152 * Repeated SourceAddress=Source\n");
+
+            SchemaRegistry registry;
+            registry.RegisterVfp();
+            Assert::AreEqual(static_cast<size_t>(2), registry.LoadSchemas(schemas));
+            Assert::AreEqual(static_cast<size_t>(5), registry.GetSchemaCount());
+            Assert::AreEqual(static_cast<size_t>(2), registry.GetProviders().size());
+
+            GUID provider;
+            Assert::IsTrue(ParseGuid(L"0C478C91-0000-4E6A-9D4C-2D5C9F1A0001", &provider));
+            const EventSchema* drop = registry.Find(provider, 5152, 3);
+            Assert::IsNotNull(drop);
+            Assert::AreEqual(std::wstring(L"Drop"), drop->name);
+            Assert::AreEqual(static_cast<size_t>(3), drop->fields.size());
+            Assert::AreEqual(std::wstring(L"DestAddress"), drop->fields[1].property);
+            Assert::IsTrue(drop->fields[2].field == EventField::Protocol);
+            Assert::IsNotNull(registry.Find(provider, 5157, 2));
+            Assert::IsNull(registry.Find(provider, 5157, 1));
+        }
+
+    private:
+        const GUID VfpProvider = {
+            0x9F2660EA,
+            0xCFE7,
+            0x428F,
+            { 0x98, 0x50, 0xAE, 0xCA, 0x61, 0x26, 0x19, 0xB0 } };
+        const GUID OtherProvider = {
+            0x12345678,
+            0x1234,
+            0x5678,
+            { 0x9A, 0xBC, 0xDE, 0xF0, 0x12, 0x34, 0x56, 0x78 } };
+
+        EventSchema MakeSchema(const GUID& provider, USHORT eventId, USHORT version) const
+        {
+            EventSchema schema;
+            schema.provider = provider;
+            schema.eventId = eventId;
+            schema.version = version;
+            schema.name = L"Event" + std::to_wstring(eventId);
+            schema.fields.push_back({ L"SourceAddress", EventField::Source });
+            return schema;
+        }
+    };
+}
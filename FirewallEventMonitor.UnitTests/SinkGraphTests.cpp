@@ -0,0 +1,114 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include <CppUnitTest.h>
+// code under test headers
+#include "SinkGraph.h"
+// c++ headers
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace FirewallEventMonitor;
+
+namespace FirewallEventMonitorUnitTest
+{
+    // Keeps every event it is given, in one format.
+    class RecordingSink : public QueuedEventSink
+    {
+    public:
+        RecordingSink(EventFormat format, size_t maxQueuedEvents)
+            : QueuedEventSink(maxQueuedEvents),
+            m_Format(format)
+        {
+        }
+
+        ~RecordingSink() override
+        {
+            Stop();
+        }
+
+        LPCWSTR GetName() const override
+        {
+            return L"Recording";
+        }
+
+        EventFormat GetFormat() const override
+        {
+            return m_Format;
+        }
+
+        // Only read once the sink is stopped.
+        std::vector<EncodedEvent> written;
+
+    protected:
+        void WriteBatch(const std::vector<EncodedEvent>& events) override
+        {
+            written.insert(written.end(), events.begin(), events.end());
+        }
+
+    private:
+        const EventFormat m_Format;
+    };
+
+    TEST_CLASS(SinkGraphTests)
+    {
+    public:
+
+        TEST_METHOD_INITIALIZE(MethodInit)
+        {
+            m_Graph = std::make_shared<SinkGraph>();
+            m_Console = std::make_shared<RecordingSink>(EventFormat::Text, 16);
+            m_File = std::make_shared<RecordingSink>(EventFormat::Text, 16);
+            m_Json = std::make_shared<RecordingSink>(EventFormat::Json, 2);
+            m_Graph->AddSink(m_Console);
+            m_Graph->AddSink(m_Json);
+            m_Graph->AddSink(m_File);
+        }
+
+        TEST_METHOD(FormatsInUseFollowSinks)
+        {
+            Logger::WriteMessage(L"FormatsInUseFollowSinks");
+
+            const std::vector<EventFormat>& formats = m_Graph->GetFormatsInUse();
+            Assert::AreEqual(static_cast<size_t>(2), formats.size());
+            Assert::IsTrue(formats[0] == EventFormat::Text);
+            Assert::IsTrue(formats[1] == EventFormat::Json);
+            Assert::AreEqual(static_cast<size_t>(3), m_Graph->GetSinks().size());
+        }
+
+        TEST_METHOD(PublishSharesOneEncodingPerFormat)
+        {
+            Logger::WriteMessage(L"PublishSharesOneEncodingPerFormat");
+
+            EncodedEvent text = std::make_shared<std::wstring>(L"text\n");
+            EncodedEvent json = std::make_shared<std::wstring>(L"{}\n");
+            m_Graph->Start();
+            m_Graph->Publish(EventFormat::Text, text);
+            m_Graph->Publish(EventFormat::Json, json);
+            m_Graph->Stop();
+
+            Assert::AreEqual(static_cast<size_t>(1), m_Console->written.size());
+            Assert::IsTrue(m_Console->written[0] == text);
+            Assert::IsTrue(m_File->written[0] == text);
+            Assert::AreEqual(static_cast<size_t>(1), m_Json->written.size());
+            Assert::IsTrue(m_Json->written[0] == json);
+        }
+
+        TEST_METHOD(QueueUsageIsTheFullestSink)
+        {
+            Logger::WriteMessage(L"QueueUsageIsTheFullestSink");
+
+            // Not started, so events stay queued.
+            m_Graph->Publish(EventFormat::Json, std::make_shared<std::wstring>(L"{}\n"));
+            Assert::AreEqual(0.5, m_Graph->GetQueueUsage());
+        }
+
+    private:
+        std::shared_ptr<SinkGraph> m_Graph;
+        std::shared_ptr<RecordingSink> m_Console;
+        std::shared_ptr<RecordingSink> m_File;
+        std::shared_ptr<RecordingSink> m_Json;
+    };
+}
@@ -0,0 +1,277 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include <CppUnitTest.h>
+// code under test headers
+#include "SketchMerge.h"
+// c++ headers
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace FirewallEventMonitor;
+
+namespace FirewallEventMonitorUnitTest
+{
+    namespace
+    {
+        const LONGLONG SketchStartTime = 131492977480000000ll; // 20170907 224228 UTC
+        const LONGLONG SketchInterval = 300ll * 10000000ll;
+
+        // Host's sketch of one interval: 100 events from sources 10.0.<host>.0-99 to a port of its own.
+        EventSketch MakeSketch(unsigned long host, unsigned long interval)
+        {
+            EventSketch sketch;
+            for (unsigned long i = 0; i < 100; ++i)
+            {
+                CompactEventRecord record;
+                record.timeStamp = SketchStartTime;
+                record.source.u.Byte[10] = 0xff;
+                record.source.u.Byte[11] = 0xff;
+                record.source.u.Byte[12] = 10;
+                record.source.u.Byte[14] = static_cast<unsigned char>(host);
+                record.source.u.Byte[15] = static_cast<unsigned char>(i);
+                record.destination = record.source;
+                record.destination.u.Byte[12] = 192;
+                record.sourcePort = 50000;
+                record.destinationPort = static_cast<unsigned short>(8000 + host);
+                record.protocol = 17;
+                record.action = i < 10 ? RuleAction::Deny : RuleAction::Allow;
+                sketch.RecordEvent(record, SketchStartTime + i * 10000ll);
+            }
+            LONGLONG startTime = SketchStartTime + interval * SketchInterval;
+            sketch.SetSnapshot(L"host" + std::to_wstring(host), startTime, startTime + SketchInterval);
+            return sketch;
+        }
+    }
+
+    TEST_CLASS(SketchMergeTests)
+    {
+    public:
+
+        TEST_METHOD_INITIALIZE(MethodInit)
+        {
+            WCHAR directory[MAX_PATH] = L"";
+            ::GetTempPathW(MAX_PATH, directory);
+            m_Directory = std::wstring(directory) + L"SketchMergeTests";
+            ::CreateDirectoryW(m_Directory.c_str(), nullptr);
+        }
+
+        TEST_METHOD_CLEANUP(MethodCleanup)
+        {
+            for (const auto& path : m_Paths)
+            {
+                _wremove(path.c_str());
+            }
+            ::RemoveDirectoryW(m_Directory.c_str());
+        }
+
+        TEST_METHOD(FindsSketchFilesByDirectoryPatternOrName)
+        {
+            Logger::WriteMessage(L"FindsSketchFilesByDirectoryPatternOrName");
+
+            std::wstring web = WriteSketch(L"web01.sketch", MakeSketch(1, 0));
+            std::wstring db = WriteSketch(L"db01.sketch", MakeSketch(2, 0));
+            WriteSketch(L"notes.txt", MakeSketch(3, 0));
+
+            std::vector<std::wstring> found = SketchMerge::FindSketchFiles(m_Directory);
+            Assert::AreEqual(static_cast<size_t>(2), found.size());
+            Assert::AreEqual(db, found[0]);
+            Assert::AreEqual(web, found[1]);
+
+            found = SketchMerge::FindSketchFiles(m_Directory + L"\\web*.sketch");
+            Assert::AreEqual(static_cast<size_t>(1), found.size());
+            Assert::AreEqual(web, found[0]);
+
+            found = SketchMerge::FindSketchFiles(db);
+            Assert::AreEqual(static_cast<size_t>(1), found.size());
+            Assert::AreEqual(db, found[0]);
+
+            Assert::IsTrue(SketchMerge::FindSketchFiles(m_Directory + L"\\none*.sketch").empty());
+        }
+
+        TEST_METHOD(ParallelMergeMatchesSerialMerge)
+        {
+            Logger::WriteMessage(L"ParallelMergeMatchesSerialMerge");
+
+            // 10 hosts, 4 intervals each.
+            std::vector<std::wstring> paths;
+            EventSketch expected;
+            for (unsigned long host = 0; host < 10; ++host)
+            {
+                for (unsigned long interval = 0; interval < 4; ++interval)
+                {
+                    EventSketch sketch = MakeSketch(host, interval);
+                    expected.Merge(sketch);
+                    paths.push_back(WriteSketch(
+                        L"host" + std::to_wstring(host) + L"." + std::to_wstring(interval) + SketchRecorder::FileExtension,
+                        sketch));
+                }
+            }
+
+            for (size_t threadCount : { static_cast<size_t>(1), static_cast<size_t>(4), static_cast<size_t>(64) })
+            {
+                SketchMergeResult result;
+                EventSketch merged = SketchMerge(threadCount).Merge(paths, &result);
+
+                Assert::AreEqual(static_cast<size_t>(40), result.filesMerged);
+                Assert::AreEqual(static_cast<size_t>(0), result.filesSkipped);
+                Assert::IsTrue(expected.GetHosts() == merged.GetHosts());
+                Assert::AreEqual(40ull, merged.GetSnapshotCount());
+                Assert::AreEqual(SketchStartTime, merged.GetStartTime());
+                Assert::AreEqual(SketchStartTime + 4 * SketchInterval, merged.GetEndTime());
+                Assert::AreEqual(4000ull, merged.GetEventCount());
+                Assert::AreEqual(400ull, merged.GetDenyEventCount());
+                // Distinct counts do not depend on the order of the merge.
+                Assert::AreEqual(expected.EstimateDistinct(SketchCardinality::Sources), merged.EstimateDistinct(SketchCardinality::Sources));
+                Assert::AreEqual(1000.0, merged.EstimateDistinct(SketchCardinality::Sources), 30.0);
+
+                // Under capacity, the top lists are exact.
+                auto ports = merged.GetTop(SketchTopKeys::DestinationPorts, 20);
+                Assert::AreEqual(static_cast<size_t>(10), ports.size());
+                for (const auto& port : ports)
+                {
+                    Assert::AreEqual(400ull, port.events);
+                    Assert::AreEqual(0ull, port.error);
+                }
+                const ntl::TDigest& lag = merged.GetQuantiles(SketchQuantiles::LagInMilliseconds);
+                Assert::AreEqual(4000.0, lag.count());
+                Assert::AreEqual(99.0, lag.maximum());
+            }
+        }
+
+        TEST_METHOD(DamagedSketchesAreSkipped)
+        {
+            Logger::WriteMessage(L"DamagedSketchesAreSkipped");
+
+            std::vector<std::wstring> paths;
+            paths.push_back(WriteSketch(L"good1.sketch", MakeSketch(1, 0)));
+            paths.push_back(WriteSketch(L"good2.sketch", MakeSketch(2, 0)));
+
+            std::string truncated = MakeSketch(3, 0).Serialize();
+            truncated.resize(truncated.size() / 2);
+            std::wstring damaged = m_Directory + L"\\damaged.sketch";
+            FILE* file = nullptr;
+            Assert::AreEqual(0, _wfopen_s(&file, damaged.c_str(), L"wb"));
+            fwrite(truncated.data(), 1, truncated.size(), file);
+            fclose(file);
+            m_Paths.push_back(damaged);
+            paths.push_back(damaged);
+            paths.push_back(m_Directory + L"\\missing.sketch");
+
+            SketchMergeResult result;
+            EventSketch merged = SketchMerge(2).Merge(paths, &result);
+            Assert::AreEqual(static_cast<size_t>(2), result.filesMerged);
+            Assert::AreEqual(static_cast<size_t>(2), result.filesSkipped);
+            Assert::AreEqual(200ull, merged.GetEventCount());
+            Assert::AreEqual(static_cast<size_t>(2), merged.GetHosts().size());
+        }
+
+        TEST_METHOD(ReportListsTheFleet)
+        {
+            Logger::WriteMessage(L"ReportListsTheFleet");
+
+            EventSketch merged = MakeSketch(1, 0);
+            merged.Merge(MakeSketch(2, 1));
+            SketchMergeResult result;
+            result.filesMerged = 2;
+
+            std::wstring path = m_Directory + L"\\report.txt";
+            m_Paths.push_back(path);
+            FILE* file = nullptr;
+            Assert::AreEqual(0, _wfopen_s(&file, path.c_str(), L"w+"));
+            SketchMerge::PrintReport(merged, result, 5, file);
+            rewind(file);
+            std::wstring report;
+            wchar_t line[512];
+            while (fgetws(line, ARRAYSIZE(line), file) != nullptr)
+            {
+                report += line;
+            }
+            fclose(file);
+            Logger::WriteMessage(report.c_str());
+
+            Assert::IsTrue(report.find(L"Sketch merge {files = 2, skipped = 0, hosts = 2, snapshots = 2}") != std::wstring::npos);
+            Assert::IsTrue(report.find(L"start = 20170907T224228Z") != std::wstring::npos);
+            Assert::IsTrue(report.find(L"events {total = 200, allow = 180, deny = 20}") != std::wstring::npos);
+            Assert::IsTrue(report.find(L"8001/UDP: events = 100 {overcountAtMost = 0}") != std::wstring::npos);
+        }
+
+    private:
+        std::wstring m_Directory;
+        std::vector<std::wstring> m_Paths;
+
+        std::wstring WriteSketch(const std::wstring& name, const EventSketch& sketch)
+        {
+            std::wstring path = m_Directory + L"\\" + name;
+            sketch.WriteFile(path);
+            m_Paths.push_back(path);
+            return path;
+        }
+    };
+
+    // Merging a fleet's day of sketches (1,024 files) on one thread and on every processor;
+    // run with /TestCaseFilter:TestCategory=Benchmark.
+    TEST_CLASS(SketchMergeBenchmarks)
+    {
+    public:
+
+        BEGIN_TEST_METHOD_ATTRIBUTE(MergeThroughput)
+            TEST_METHOD_ATTRIBUTE(L"TestCategory", L"Benchmark")
+        END_TEST_METHOD_ATTRIBUTE()
+
+        TEST_METHOD(MergeThroughput)
+        {
+            Logger::WriteMessage(L"MergeThroughput");
+
+            WCHAR directory[MAX_PATH] = L"";
+            ::GetTempPathW(MAX_PATH, directory);
+            std::wstring sketchDirectory = std::wstring(directory) + L"SketchMergeBenchmarks";
+            ::CreateDirectoryW(sketchDirectory.c_str(), nullptr);
+
+            const unsigned long hostCount = 256;
+            const unsigned long intervalCount = 4;
+            std::vector<std::wstring> paths;
+            for (unsigned long host = 0; host < hostCount; ++host)
+            {
+                for (unsigned long interval = 0; interval < intervalCount; ++interval)
+                {
+                    std::wstring path = sketchDirectory + L"\\" + SketchRecorder::FileName(L"host" + std::to_wstring(host), SketchStartTime + interval * SketchInterval);
+                    MakeSketch(host, interval).WriteFile(path);
+                    paths.push_back(path);
+                }
+            }
+
+            double serialSeconds = MergeSeconds(SketchMerge(1), paths);
+            SketchMerge parallel;
+            double parallelSeconds = MergeSeconds(parallel, paths);
+
+            for (const auto& path : paths)
+            {
+                _wremove(path.c_str());
+            }
+            ::RemoveDirectoryW(sketchDirectory.c_str());
+
+            wchar_t report[256];
+            swprintf_s(report, L"Sketches merged per second (%zu files): one thread %.0f, one per processor %.0f",
+                paths.size(),
+                paths.size() / serialSeconds,
+                paths.size() / parallelSeconds);
+            Logger::WriteMessage(report);
+        }
+
+    private:
+        static double MergeSeconds(const SketchMerge& sketchMerge, const std::vector<std::wstring>& paths)
+        {
+            auto start = std::chrono::steady_clock::now();
+            SketchMergeResult result;
+            EventSketch merged = sketchMerge.Merge(paths, &result);
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            Assert::AreEqual(paths.size(), result.filesMerged);
+            Assert::AreEqual(static_cast<unsigned long long>(paths.size()), merged.GetSnapshotCount());
+            return elapsed.count();
+        }
+    };
+}
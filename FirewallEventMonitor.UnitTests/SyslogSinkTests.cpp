@@ -0,0 +1,263 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include <CppUnitTest.h>
+// code under test headers
+#include "SyslogSink.h"
+// os headers
+#include <ws2tcpip.h>
+// c++ headers
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace FirewallEventMonitor;
+
+namespace FirewallEventMonitorUnitTest
+{
+    TEST_CLASS(SyslogSinkTests)
+    {
+    public:
+
+        TEST_METHOD_INITIALIZE(MethodInit)
+        {
+            WSADATA wsaData;
+            Assert::AreEqual(0, ::WSAStartup(MAKEWORD(2, 2), &wsaData));
+
+            WCHAR directory[MAX_PATH] = L"";
+            ::GetTempPathW(MAX_PATH, directory);
+            m_SpillPath = std::wstring(directory) + L"SyslogSinkTests.spill";
+            _wremove(m_SpillPath.c_str());
+        }
+
+        TEST_METHOD_CLEANUP(MethodCleanup)
+        {
+            _wremove(m_SpillPath.c_str());
+            ::WSACleanup();
+        }
+
+        TEST_METHOD(AppendFrameCountsUtf8Bytes)
+        {
+            Logger::WriteMessage(L"AppendFrameCountsUtf8Bytes");
+
+            std::string buffer;
+            SyslogSink::AppendFrame(L"<134>1 -", &buffer);
+            SyslogSink::AppendFrame(L"caf\u00e9", &buffer);
+
+            Assert::AreEqual(std::string("8 <134>1 -5 caf\xc3\xa9"), buffer);
+        }
+
+        TEST_METHOD(UdpSendsOneMessagePerDatagram)
+        {
+            Logger::WriteMessage(L"UdpSendsOneMessagePerDatagram");
+
+            unsigned short port = 0;
+            SOCKET receiver = Listen(SOCK_DGRAM, &port);
+            {
+                SyslogSink sink(L"127.0.0.1", port, SyslogTransport::Udp, m_SpillPath);
+                sink.Start();
+                sink.Write(std::make_shared<std::wstring>(L"<134>1 first"));
+                sink.Write(std::make_shared<std::wstring>(L"<132>1 second"));
+                sink.Stop();
+                Assert::AreEqual(0ull, sink.GetEventsSpilled());
+            }
+
+            char datagram[256];
+            int received = ::recv(receiver, datagram, sizeof(datagram), 0);
+            Assert::AreEqual(std::string("<134>1 first"), std::string(datagram, received));
+            received = ::recv(receiver, datagram, sizeof(datagram), 0);
+            Assert::AreEqual(std::string("<132>1 second"), std::string(datagram, received));
+            ::closesocket(receiver);
+        }
+
+        TEST_METHOD(UdpCutsLongMessagesAtACharacterBoundary)
+        {
+            Logger::WriteMessage(L"UdpCutsLongMessagesAtACharacterBoundary");
+
+            unsigned short port = 0;
+            SOCKET receiver = Listen(SOCK_DGRAM, &port);
+            {
+                // 7 bytes, then 2 bytes a character: the limit falls inside a character.
+                SyslogSink sink(L"127.0.0.1", port, SyslogTransport::Udp, m_SpillPath);
+                sink.Start();
+                sink.Write(std::make_shared<std::wstring>(L"<134>1 " + std::wstring(SyslogSink::MaxUdpMessageBytes, L'\u00e9')));
+                sink.Stop();
+            }
+
+            char datagram[2 * SyslogSink::MaxUdpMessageBytes];
+            int received = ::recv(receiver, datagram, sizeof(datagram), 0);
+            Assert::AreEqual(static_cast<int>(SyslogSink::MaxUdpMessageBytes - 1), received);
+            Assert::AreEqual(std::string("\xc3\xa9"), std::string(datagram + received - 2, 2));
+            ::closesocket(receiver);
+        }
+
+        TEST_METHOD(TcpSendsOctetCountedFrames)
+        {
+            Logger::WriteMessage(L"TcpSendsOctetCountedFrames");
+
+            unsigned short port = 0;
+            SOCKET listener = Listen(SOCK_STREAM, &port);
+            {
+                SyslogSink sink(L"127.0.0.1", port, SyslogTransport::Tcp, m_SpillPath);
+                sink.Start();
+                sink.Write(std::make_shared<std::wstring>(L"<134>1 first"));
+                sink.Write(std::make_shared<std::wstring>(L"<132>1 second"));
+                sink.Stop();
+            }
+
+            // The connection waits in the backlog; the sink closed it when it stopped.
+            Assert::AreEqual(std::string("12 <134>1 first13 <132>1 second"), ReceiveAll(listener));
+            ::closesocket(listener);
+        }
+
+        TEST_METHOD(UnreachableCollectorSpillsThenReplaysInOrder)
+        {
+            Logger::WriteMessage(L"UnreachableCollectorSpillsThenReplaysInOrder");
+
+            // A port nothing listens on.
+            unsigned short port = 0;
+            ::closesocket(Listen(SOCK_STREAM, &port));
+            {
+                SyslogSink sink(L"127.0.0.1", port, SyslogTransport::Tcp, m_SpillPath);
+                sink.Start();
+                sink.Write(std::make_shared<std::wstring>(L"one"));
+                sink.Write(std::make_shared<std::wstring>(L"two"));
+                sink.Stop();
+                Assert::AreEqual(2ull, sink.GetEventsSpilled());
+                Assert::AreEqual(1ull, sink.GetConnectFailures());
+                Assert::AreEqual(10ull, sink.GetSpillBytes());
+            }
+
+            // A later run, with the collector back, sends the spilled events first.
+            SOCKET listener = Listen(SOCK_STREAM, &port);
+            {
+                SyslogSink sink(L"127.0.0.1", port, SyslogTransport::Tcp, m_SpillPath);
+                sink.Start();
+                sink.Write(std::make_shared<std::wstring>(L"three"));
+                sink.Stop();
+                Assert::AreEqual(0ull, sink.GetSpillBytes());
+            }
+
+            Assert::AreEqual(std::string("3 one3 two5 three"), ReceiveAll(listener));
+            Assert::IsTrue(::GetFileAttributesW(m_SpillPath.c_str()) == INVALID_FILE_ATTRIBUTES);
+            ::closesocket(listener);
+        }
+
+        TEST_METHOD(FullSpillFileLosesNewestEvents)
+        {
+            Logger::WriteMessage(L"FullSpillFileLosesNewestEvents");
+
+            unsigned short port = 0;
+            ::closesocket(Listen(SOCK_STREAM, &port));
+
+            // Room for two of the 8 byte frames.
+            SyslogSink sink(L"127.0.0.1", port, SyslogTransport::Tcp, m_SpillPath, 20);
+            sink.Write(std::make_shared<std::wstring>(L"event1"));
+            sink.Write(std::make_shared<std::wstring>(L"event2"));
+            sink.Write(std::make_shared<std::wstring>(L"event3"));
+            sink.Stop();
+
+            Assert::AreEqual(2ull, sink.GetEventsSpilled());
+            Assert::AreEqual(1ull, sink.GetEventsDropped());
+            Assert::AreEqual(16ull, sink.GetSpillBytes());
+        }
+
+        TEST_METHOD(TcpLoopbackThroughput)
+        {
+            Logger::WriteMessage(L"TcpLoopbackThroughput");
+
+            const size_t eventCount = 200000;
+            // About the size of an encoded rule match event.
+            EncodedEvent event = std::make_shared<std::wstring>(
+                L"<134>1 2017-09-07T22:42:28.123Z host FirewallEventMonitor 1234 Allow [vfp@32473 direction=\"Inbound\" "
+                L"ruleType=\"Allow\" status=\"STATUS_SUCCESS\" portId=\"4\" portName=\"07312833-61E0-4D4E-BB4C-BFC46E86D345\" "
+                L"src=\"192.168.100.21\" dst=\"192.168.100.22\" protocol=\"TCP\" srcPort=\"50000\" dstPort=\"443\" "
+                L"ruleId=\"43cff06e-a520-4ad3-9fd9-1894f4a3489b\" layerId=\"FW_CONTROLLER_LAYER_ID\" groupId=\"FW_GROUP_IPv4_IN_ID\" "
+                L"gftFlags=\"0\"] Inbound Allow TCP 192.168.100.21:50000 -> 192.168.100.22:443");
+
+            unsigned short port = 0;
+            SOCKET listener = Listen(SOCK_STREAM, &port);
+            unsigned long long bytesReceived = 0;
+            std::thread receiver([&]()
+            {
+                SOCKET connection = ::accept(listener, NULL, NULL);
+                char buffer[64 * 1024];
+                int received = 0;
+                while ((received = ::recv(connection, buffer, sizeof(buffer), 0)) > 0)
+                {
+                    bytesReceived += received;
+                }
+                ::closesocket(connection);
+            });
+
+            SyslogSink sink(L"127.0.0.1", port, SyslogTransport::Tcp, m_SpillPath, SyslogSink::DefaultMaxSpillBytes, eventCount);
+            auto start = std::chrono::steady_clock::now();
+            sink.Start();
+            for (size_t i = 0; i < eventCount; ++i)
+            {
+                sink.Write(event);
+            }
+            sink.Stop();
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            receiver.join();
+            ::closesocket(listener);
+
+            std::wstring report = L"Syslog over TCP loopback: " +
+                std::to_wstring(static_cast<unsigned long long>(static_cast<double>(eventCount) / seconds)) + L" events/s, " +
+                std::to_wstring(static_cast<unsigned long long>(static_cast<double>(sink.GetBytesSent()) / seconds / (1024 * 1024))) + L" MB/s";
+            Logger::WriteMessage(report.c_str());
+
+            Assert::AreEqual(0ull, sink.GetEventsDropped());
+            Assert::AreEqual(0ull, sink.GetEventsSpilled());
+            Assert::AreEqual(sink.GetBytesSent(), bytesReceived);
+        }
+
+    private:
+        std::wstring m_SpillPath;
+
+        // A socket bound to an ephemeral loopback port; TCP sockets are listening.
+        SOCKET Listen(int type, _Out_ unsigned short* port) const
+        {
+            SOCKET listener = ::socket(AF_INET, type, type == SOCK_STREAM ? IPPROTO_TCP : IPPROTO_UDP);
+            Assert::IsTrue(listener != INVALID_SOCKET);
+
+            sockaddr_in address = {};
+            address.sin_family = AF_INET;
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            Assert::AreEqual(0, ::bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)));
+            int length = sizeof(address);
+            ::getsockname(listener, reinterpret_cast<sockaddr*>(&address), &length);
+            *port = ntohs(address.sin_port);
+
+            if (type == SOCK_STREAM)
+            {
+                Assert::AreEqual(0, ::listen(listener, SOMAXCONN));
+            }
+            else
+            {
+                DWORD timeout = 2000;
+                ::setsockopt(listener, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&timeout), sizeof(timeout));
+            }
+            return listener;
+        }
+
+        // Accepts one connection and reads it until the sender closes it.
+        std::string ReceiveAll(SOCKET listener) const
+        {
+            SOCKET connection = ::accept(listener, NULL, NULL);
+            Assert::IsTrue(connection != INVALID_SOCKET);
+
+            std::string data;
+            char buffer[4096];
+            int received = 0;
+            while ((received = ::recv(connection, buffer, sizeof(buffer), 0)) > 0)
+            {
+                data.append(buffer, received);
+            }
+            ::closesocket(connection);
+            return data;
+        }
+    };
+}
@@ -0,0 +1,66 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include "AdaptiveSampling.h"
+
+// c++ headers
+#include <algorithm>
+
+namespace FirewallEventMonitor
+{
+    AdaptiveSampling::AdaptiveSampling(
+        double lagBudgetInMilliseconds,
+        double cpuBudgetPercent,
+        unsigned long minSampleRate,
+        unsigned long maxSampleRate)
+        : m_LagBudgetInMilliseconds(lagBudgetInMilliseconds),
+        m_CpuBudgetPercent(cpuBudgetPercent),
+        m_MinSampleRate(minSampleRate == 0 ? 1 : minSampleRate),
+        m_MaxSampleRate((std::max)(maxSampleRate, minSampleRate == 0 ? 1 : minSampleRate)),
+        m_SampleRate(m_MinSampleRate)
+    {
+    }
+
+    unsigned long AdaptiveSampling::Update(const PipelinePressure& pressure)
+    {
+        m_Load = (std::max)(
+            (std::max)(
+                pressure.lagInMilliseconds / m_LagBudgetInMilliseconds,
+                pressure.cpuPercent / m_CpuBudgetPercent),
+            pressure.queueUsage / QueueUsageBudget);
+
+        if (pressure.eventsLost || m_Load > 1.0)
+        {
+            // Back off at once: every second over budget adds to the backlog.
+            unsigned long factor = pressure.eventsLost ? 4 : 2;
+            m_SampleRate = m_SampleRate > m_MaxSampleRate / factor ? m_MaxSampleRate : m_SampleRate * factor;
+            m_CalmIntervals = 0;
+        }
+        else if (m_Load < RecoverBelowLoad)
+        {
+            m_CalmIntervals++;
+            if (m_CalmIntervals >= IntervalsBeforeRecovery)
+            {
+                m_SampleRate = (std::max)(m_SampleRate / 2, m_MinSampleRate);
+                m_CalmIntervals = 0;
+            }
+        }
+        else
+        {
+            // Within the hysteresis band: hold the rate.
+            m_CalmIntervals = 0;
+        }
+
+        return m_SampleRate;
+    }
+
+    unsigned long AdaptiveSampling::GetSampleRate() const
+    {
+        return m_SampleRate;
+    }
+
+    double AdaptiveSampling::GetLoad() const
+    {
+        return m_Load;
+    }
+}
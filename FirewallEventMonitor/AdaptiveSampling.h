@@ -0,0 +1,64 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#pragma once
+
+namespace FirewallEventMonitor
+{
+    // Pipeline measurements over one control interval.
+    struct PipelinePressure
+    {
+    public:
+        // Worst delivery lag (ETW timestamp to processing) of the interval's events.
+        double lagInMilliseconds = 0.0;
+        // Fullest queue between ETW and the outputs, from 0 (empty) to 1 (full).
+        // The ETW session's buffers holding undelivered events, or the fullest sink queue.
+        double queueUsage = 0.0;
+        // The monitor's share of all processors.
+        double cpuPercent = 0.0;
+        // ETW discarded events or buffers during the interval.
+        bool eventsLost = false;
+    };
+
+    // Chooses the flow sample rate (1 in N flows kept) that keeps the monitor within its
+    // lag and CPU budgets, and its queues from filling.
+    // Each interval the load is the largest of lag, queue usage and CPU as a multiple of
+    // its budget. Over budget the rate doubles at once (quadruples if ETW lost events);
+    // the rate only halves again after the load has stayed below RecoverBelowLoad for
+    // IntervalsBeforeRecovery intervals in a row, so it does not oscillate around the budget.
+    // Rates stay between the minimum (the -SampleRate given) and maxSampleRate.
+    class AdaptiveSampling
+    {
+    public:
+        AdaptiveSampling(
+            double lagBudgetInMilliseconds,
+            double cpuBudgetPercent,
+            unsigned long minSampleRate = 1,
+            unsigned long maxSampleRate = DefaultMaxSampleRate);
+
+        // Returns the sample rate to use for the next interval.
+        unsigned long Update(const PipelinePressure& pressure);
+
+        unsigned long GetSampleRate() const;
+
+        // Load computed by the last Update(); 1.0 is at budget.
+        double GetLoad() const;
+
+        // Constants
+        static const unsigned long DefaultMaxSampleRate = 1024;
+        static constexpr double QueueUsageBudget = 0.5; // Leaves half the buffers for bursts.
+        static constexpr double RecoverBelowLoad = 0.5;
+        static const unsigned long IntervalsBeforeRecovery = 5;
+
+        AdaptiveSampling(AdaptiveSampling const&) = delete;
+        AdaptiveSampling& operator=(AdaptiveSampling const&) = delete;
+    private:
+        double m_LagBudgetInMilliseconds;
+        double m_CpuBudgetPercent;
+        unsigned long m_MinSampleRate;
+        unsigned long m_MaxSampleRate;
+        unsigned long m_SampleRate;
+        unsigned long m_CalmIntervals = 0;
+        double m_Load = 0.0;
+    };
+}
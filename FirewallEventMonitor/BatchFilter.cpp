@@ -0,0 +1,430 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include "BatchFilter.h"
+// os headers
+#include <intrin.h>
+#include <immintrin.h>
+// c++ headers
+#include <algorithm>
+#include <bitset>
+
+namespace FirewallEventMonitor
+{
+    namespace
+    {
+        typedef uint32_t AddressColumns[4][EventBatch::Capacity];
+
+        void SplitAddress(const IN6_ADDR& address, _Out_writes_(4) uint32_t* words)
+        {
+            memcpy(words, &address, sizeof(IN6_ADDR));
+        }
+
+        unsigned long LowestBit(uint64_t bits)
+        {
+            unsigned long index = 0;
+#if defined(_M_X64)
+            _BitScanForward64(&index, bits);
+#else
+            if (!_BitScanForward(&index, static_cast<unsigned long>(bits)))
+            {
+                _BitScanForward(&index, static_cast<unsigned long>(bits >> 32));
+                index += 32;
+            }
+#endif
+            return index;
+        }
+
+        // Rows covered by each vector.
+        const size_t Sse41Rows = 4;
+        const size_t Avx2Rows = 8;
+
+        // Lanes set where the address is absent (all zero) or equal to one of the filters.
+        __m128i AddressHits128(
+            const AddressColumns& columns,
+            size_t row,
+            _In_reads_(filterCount) const uint32_t (*filters)[4],
+            size_t filterCount)
+        {
+            __m128i w0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&columns[0][row]));
+            __m128i w1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&columns[1][row]));
+            __m128i w2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&columns[2][row]));
+            __m128i w3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&columns[3][row]));
+
+            __m128i any = _mm_or_si128(_mm_or_si128(w0, w1), _mm_or_si128(w2, w3));
+            __m128i hits = _mm_cmpeq_epi32(any, _mm_setzero_si128());
+            for (size_t filter = 0; filter < filterCount; ++filter)
+            {
+                __m128i equal = _mm_and_si128(
+                    _mm_and_si128(
+                        _mm_cmpeq_epi32(w0, _mm_set1_epi32(static_cast<int>(filters[filter][0]))),
+                        _mm_cmpeq_epi32(w1, _mm_set1_epi32(static_cast<int>(filters[filter][1])))),
+                    _mm_and_si128(
+                        _mm_cmpeq_epi32(w2, _mm_set1_epi32(static_cast<int>(filters[filter][2]))),
+                        _mm_cmpeq_epi32(w3, _mm_set1_epi32(static_cast<int>(filters[filter][3])))));
+                hits = _mm_or_si128(hits, equal);
+            }
+            return hits;
+        }
+
+        __m256i AddressHits256(
+            const AddressColumns& columns,
+            size_t row,
+            _In_reads_(filterCount) const uint32_t (*filters)[4],
+            size_t filterCount)
+        {
+            __m256i w0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&columns[0][row]));
+            __m256i w1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&columns[1][row]));
+            __m256i w2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&columns[2][row]));
+            __m256i w3 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&columns[3][row]));
+
+            __m256i any = _mm256_or_si256(_mm256_or_si256(w0, w1), _mm256_or_si256(w2, w3));
+            __m256i hits = _mm256_cmpeq_epi32(any, _mm256_setzero_si256());
+            for (size_t filter = 0; filter < filterCount; ++filter)
+            {
+                __m256i equal = _mm256_and_si256(
+                    _mm256_and_si256(
+                        _mm256_cmpeq_epi32(w0, _mm256_set1_epi32(static_cast<int>(filters[filter][0]))),
+                        _mm256_cmpeq_epi32(w1, _mm256_set1_epi32(static_cast<int>(filters[filter][1])))),
+                    _mm256_and_si256(
+                        _mm256_cmpeq_epi32(w2, _mm256_set1_epi32(static_cast<int>(filters[filter][2]))),
+                        _mm256_cmpeq_epi32(w3, _mm256_set1_epi32(static_cast<int>(filters[filter][3])))));
+                hits = _mm256_or_si256(hits, equal);
+            }
+            return hits;
+        }
+    }
+
+    bool EventBatch::Add(const CompactEventRecord& record)
+    {
+        if (count == Capacity)
+        {
+            return false;
+        }
+
+        uint32_t words[4];
+        SplitAddress(record.source, words);
+        for (size_t word = 0; word < 4; ++word)
+        {
+            source[word][count] = words[word];
+        }
+        SplitAddress(record.destination, words);
+        for (size_t word = 0; word < 4; ++word)
+        {
+            destination[word][count] = words[word];
+        }
+        ruleHash[count] = BatchFilter::RuleHash(record.ruleId);
+        ruleId[count] = record.ruleId;
+        ++count;
+        return true;
+    }
+
+    void EventBatch::Clear()
+    {
+        // Only the rows used need zeroing: the rest are still zero.
+        for (size_t word = 0; word < 4; ++word)
+        {
+            memset(source[word], 0, count * sizeof(uint32_t));
+            memset(destination[word], 0, count * sizeof(uint32_t));
+        }
+        memset(ruleHash, 0, count * sizeof(uint64_t));
+        memset(ruleId, 0, count * sizeof(GUID));
+        count = 0;
+    }
+
+    BatchFilter::BatchFilter()
+    {
+    }
+
+    BatchFilter::BatchFilter(
+        const std::vector<std::wstring>& addresses,
+        const std::vector<std::wstring>& ruleIds,
+        FilterKernel kernel)
+        : m_Kernel(kernel),
+          m_FilterAddresses(!addresses.empty()),
+          m_FilterRules(!ruleIds.empty())
+    {
+        for (const auto& text : addresses)
+        {
+            IN6_ADDR address;
+            bool isIpv6 = false;
+            if (ParseAddress(text, &address, &isIpv6))
+            {
+                AddressWords filter;
+                SplitAddress(address, filter.words);
+                m_Addresses.push_back(filter);
+            }
+        }
+
+        for (const auto& text : ruleIds)
+        {
+            GUID ruleId;
+            if (ParseGuid(text, &ruleId))
+            {
+                m_RuleIds.push_back(ruleId);
+                m_RuleHashes.push_back(RuleHash(ruleId));
+            }
+        }
+    }
+
+    bool BatchFilter::IsEmpty() const
+    {
+        return !m_FilterAddresses && !m_FilterRules;
+    }
+
+    bool BatchFilter::Match(const CompactEventRecord& record) const
+    {
+        if (m_FilterAddresses)
+        {
+            uint32_t source[4];
+            uint32_t destination[4];
+            SplitAddress(record.source, source);
+            SplitAddress(record.destination, destination);
+            if (!MatchAddress(source) && !MatchAddress(destination))
+            {
+                return false;
+            }
+        }
+
+        return !m_FilterRules || MatchRule(record.ruleId);
+    }
+
+    size_t BatchFilter::Evaluate(
+        const EventBatch& batch,
+        uint64_t* selection) const
+    {
+        for (size_t word = 0; word < EventBatch::SelectionWords; ++word)
+        {
+            selection[word] = 0;
+        }
+        if (IsEmpty())
+        {
+            for (size_t row = 0; row < batch.count; ++row)
+            {
+                selection[row / 64] |= 1ull << (row % 64);
+            }
+            return batch.count;
+        }
+
+        switch (m_Kernel)
+        {
+        case FilterKernel::Avx2:
+            EvaluateAvx2(batch, selection);
+            break;
+        case FilterKernel::Sse41:
+            EvaluateSse41(batch, selection);
+            break;
+        default:
+            EvaluateScalar(batch, selection);
+            break;
+        }
+
+        // Kernels work in whole vectors; drop the rows past the end.
+        for (size_t word = 0; word < EventBatch::SelectionWords; ++word)
+        {
+            size_t firstRow = word * 64;
+            if (batch.count <= firstRow)
+            {
+                selection[word] = 0;
+            }
+            else if (batch.count < firstRow + 64)
+            {
+                selection[word] &= (1ull << (batch.count - firstRow)) - 1;
+            }
+        }
+
+        size_t selected = 0;
+        for (size_t word = 0; word < EventBatch::SelectionWords; ++word)
+        {
+            uint64_t candidates = selection[word];
+            if (m_FilterRules)
+            {
+                // Rows whose rule hash matched: confirm the full id.
+                uint64_t remaining = candidates;
+                while (remaining != 0)
+                {
+                    unsigned long bit = LowestBit(remaining);
+                    remaining &= remaining - 1;
+                    if (!MatchRule(batch.ruleId[word * 64 + bit]))
+                    {
+                        candidates &= ~(1ull << bit);
+                    }
+                }
+                selection[word] = candidates;
+            }
+            selected += std::bitset<64>(candidates).count();
+        }
+        return selected;
+    }
+
+    FilterKernel BatchFilter::GetKernel() const
+    {
+        return m_Kernel;
+    }
+
+    FilterKernel BatchFilter::BestKernel()
+    {
+        static const FilterKernel best = []()
+        {
+            int registers[4] = {};
+            __cpuid(registers, 0);
+            int maxLeaf = registers[0];
+
+            __cpuid(registers, 1);
+            const bool sse41 = (registers[2] & (1 << 19)) != 0;
+            const bool osSavesAvx =
+                (registers[2] & (1 << 27)) != 0 && // OSXSAVE
+                (registers[2] & (1 << 28)) != 0 && // AVX
+                (_xgetbv(0) & 0x6) == 0x6; // XMM and YMM state
+            bool avx2 = false;
+            if (osSavesAvx && maxLeaf >= 7)
+            {
+                __cpuidex(registers, 7, 0);
+                avx2 = (registers[1] & (1 << 5)) != 0;
+            }
+
+            return avx2 ? FilterKernel::Avx2 : (sse41 ? FilterKernel::Sse41 : FilterKernel::Scalar);
+        }();
+        return best;
+    }
+
+    LPCWSTR BatchFilter::KernelName(FilterKernel kernel)
+    {
+        switch (kernel)
+        {
+        case FilterKernel::Avx2: return L"AVX2";
+        case FilterKernel::Sse41: return L"SSE4.1";
+        default: return L"Scalar";
+        }
+    }
+
+    uint64_t BatchFilter::RuleHash(const GUID& ruleId)
+    {
+        uint64_t low = 0, high = 0;
+        memcpy(&low, &ruleId, sizeof(low));
+        memcpy(&high, reinterpret_cast<const unsigned char*>(&ruleId) + sizeof(low), sizeof(high));
+        return low ^ (high * 0x9E3779B97F4A7C15ull);
+    }
+
+    bool BatchFilter::MatchAddress(const uint32_t* words) const
+    {
+        if ((words[0] | words[1] | words[2] | words[3]) == 0)
+        {
+            // No address on this side.
+            return true;
+        }
+
+        for (const auto& filter : m_Addresses)
+        {
+            if (memcmp(filter.words, words, sizeof(filter.words)) == 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool BatchFilter::MatchRule(const GUID& ruleId) const
+    {
+        for (const auto& filter : m_RuleIds)
+        {
+            if (IsEqualGUID(filter, ruleId))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void BatchFilter::EvaluateScalar(
+        const EventBatch& batch,
+        uint64_t* selection) const
+    {
+        for (size_t row = 0; row < batch.count; ++row)
+        {
+            bool pass = true;
+            if (m_FilterAddresses)
+            {
+                uint32_t source[4] = { batch.source[0][row], batch.source[1][row], batch.source[2][row], batch.source[3][row] };
+                uint32_t destination[4] = { batch.destination[0][row], batch.destination[1][row], batch.destination[2][row], batch.destination[3][row] };
+                pass = MatchAddress(source) || MatchAddress(destination);
+            }
+            if (pass && m_FilterRules)
+            {
+                pass = std::find(m_RuleHashes.begin(), m_RuleHashes.end(), batch.ruleHash[row]) != m_RuleHashes.end();
+            }
+            if (pass)
+            {
+                selection[row / 64] |= 1ull << (row % 64);
+            }
+        }
+    }
+
+    void BatchFilter::EvaluateSse41(
+        const EventBatch& batch,
+        uint64_t* selection) const
+    {
+        const uint32_t (*filters)[4] = m_Addresses.empty() ? nullptr : &m_Addresses[0].words;
+        for (size_t row = 0; row < batch.count; row += Sse41Rows)
+        {
+            unsigned pass = 0xF;
+            if (m_FilterAddresses)
+            {
+                __m128i hits = _mm_or_si128(
+                    AddressHits128(batch.source, row, filters, m_Addresses.size()),
+                    AddressHits128(batch.destination, row, filters, m_Addresses.size()));
+                pass = static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(hits)));
+            }
+            if (pass != 0 && m_FilterRules)
+            {
+                __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&batch.ruleHash[row]));
+                __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&batch.ruleHash[row + 2]));
+                __m128i lowHits = _mm_setzero_si128();
+                __m128i highHits = _mm_setzero_si128();
+                for (const auto& hash : m_RuleHashes)
+                {
+                    __m128i filter = _mm_set1_epi64x(static_cast<long long>(hash));
+                    lowHits = _mm_or_si128(lowHits, _mm_cmpeq_epi64(low, filter));
+                    highHits = _mm_or_si128(highHits, _mm_cmpeq_epi64(high, filter));
+                }
+                pass &= static_cast<unsigned>(_mm_movemask_pd(_mm_castsi128_pd(lowHits))) |
+                    (static_cast<unsigned>(_mm_movemask_pd(_mm_castsi128_pd(highHits))) << 2);
+            }
+            selection[row / 64] |= static_cast<uint64_t>(pass) << (row % 64);
+        }
+    }
+
+    void BatchFilter::EvaluateAvx2(
+        const EventBatch& batch,
+        uint64_t* selection) const
+    {
+        const uint32_t (*filters)[4] = m_Addresses.empty() ? nullptr : &m_Addresses[0].words;
+        for (size_t row = 0; row < batch.count; row += Avx2Rows)
+        {
+            unsigned pass = 0xFF;
+            if (m_FilterAddresses)
+            {
+                __m256i hits = _mm256_or_si256(
+                    AddressHits256(batch.source, row, filters, m_Addresses.size()),
+                    AddressHits256(batch.destination, row, filters, m_Addresses.size()));
+                pass = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(hits)));
+            }
+            if (pass != 0 && m_FilterRules)
+            {
+                __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&batch.ruleHash[row]));
+                __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&batch.ruleHash[row + 4]));
+                __m256i lowHits = _mm256_setzero_si256();
+                __m256i highHits = _mm256_setzero_si256();
+                for (const auto& hash : m_RuleHashes)
+                {
+                    __m256i filter = _mm256_set1_epi64x(static_cast<long long>(hash));
+                    lowHits = _mm256_or_si256(lowHits, _mm256_cmpeq_epi64(low, filter));
+                    highHits = _mm256_or_si256(highHits, _mm256_cmpeq_epi64(high, filter));
+                }
+                pass &= static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(lowHits))) |
+                    (static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(highHits))) << 4);
+            }
+            selection[row / 64] |= static_cast<uint64_t>(pass) << (row % 64);
+        }
+    }
+}
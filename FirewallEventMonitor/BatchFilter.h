@@ -0,0 +1,106 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#pragma once
+
+// os headers
+#include <winsock2.h>
+// c++ headers
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "CompactEventRecord.h"
+
+namespace FirewallEventMonitor
+{
+    // Columns of up to Capacity events, laid out for the filter kernels: each address is four
+    // 32 bit word columns, so one vector compare covers 8 (AVX2) or 4 (SSE) rows.
+    // Rows past count are zero, so the kernels can always read whole vectors.
+    struct EventBatch
+    {
+    public:
+        // Adds the event's filter columns; returns false once the batch is full.
+        bool Add(const CompactEventRecord& record);
+
+        void Clear();
+
+        // Constants
+        static const size_t Capacity = 256;
+        static const size_t SelectionWords = Capacity / 64;
+
+        size_t count = 0;
+        uint32_t source[4][Capacity] = {};
+        uint32_t destination[4][Capacity] = {};
+        uint64_t ruleHash[Capacity] = {};
+        GUID ruleId[Capacity] = {}; // Confirms a hash match.
+    };
+
+    enum class FilterKernel { Scalar, Sse41, Avx2 };
+
+    // The -Ip and -Rule filters, parsed once into binary addresses and rule ids.
+    //
+    // An event passes if its source or its destination matches an address filter (an event
+    // without an address passes on that side), and if its rule matches a rule filter. Either
+    // filter list may be empty, in which case it passes everything.
+    //
+    // Match() tests one event. Evaluate() tests a batch with the best kernel the CPU supports
+    // and sets one bit per passing row; rule ids are compared by hash, and the rare rows whose
+    // hash matches are confirmed against the full id.
+    class BatchFilter
+    {
+    public:
+        // Passes every event.
+        BatchFilter();
+
+        // Filters that are not an address or a rule id match nothing.
+        BatchFilter(
+            const std::vector<std::wstring>& addresses,
+            const std::vector<std::wstring>& ruleIds,
+            FilterKernel kernel = BestKernel());
+
+        bool IsEmpty() const;
+
+        bool Match(const CompactEventRecord& record) const;
+
+        // Sets bit (row % 64) of selection[row / 64] for each passing row and clears the rest;
+        // returns the number of rows passing.
+        size_t Evaluate(
+            const EventBatch& batch,
+            _Out_writes_(EventBatch::SelectionWords) uint64_t* selection) const;
+
+        FilterKernel GetKernel() const;
+
+        // The fastest kernel this CPU (and OS) supports.
+        static FilterKernel BestKernel();
+
+        static LPCWSTR KernelName(FilterKernel kernel);
+
+        static uint64_t RuleHash(const GUID& ruleId);
+
+    private:
+        struct AddressWords
+        {
+            uint32_t words[4];
+        };
+
+        FilterKernel m_Kernel = FilterKernel::Scalar;
+        bool m_FilterAddresses = false;
+        bool m_FilterRules = false;
+        std::vector<AddressWords> m_Addresses;
+        std::vector<GUID> m_RuleIds;
+        std::vector<uint64_t> m_RuleHashes;
+
+        bool MatchAddress(const uint32_t* words) const;
+
+        bool MatchRule(const GUID& ruleId) const;
+
+        // Each kernel fills the selection words from whole vectors of rows; Evaluate() then
+        // clears the rows past the end of the batch and confirms rule hash matches.
+        void EvaluateScalar(const EventBatch& batch, _Out_ uint64_t* selection) const;
+
+        void EvaluateSse41(const EventBatch& batch, _Out_ uint64_t* selection) const;
+
+        void EvaluateAvx2(const EventBatch& batch, _Out_ uint64_t* selection) const;
+    };
+}
@@ -0,0 +1,883 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include "CaptureDiff.h"
+
+// c++ headers
+#include <cstdint>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <sstream>
+// ntl headers
+#include "ntlEtwReader.hpp"
+#include "ntlEtwRecord.hpp"
+#include "ntlString.hpp"
+
+#include "EventArchive.h"
+#include "FirewallEtwTraceCallback.h"
+#include "FlowSampler.h"
+
+namespace FirewallEventMonitor
+{
+    namespace
+    {
+        // Keeps the limit highest scoring entries seen, in a min-heap on score.
+        template <typename T, typename Score>
+        class TopEntries
+        {
+        public:
+            TopEntries(size_t limit, Score score)
+                : m_Limit(limit),
+                m_Greater(score)
+            {
+            }
+
+            void Offer(const T& entry)
+            {
+                if (m_Limit == 0)
+                {
+                    return;
+                }
+                if (m_Entries.size() < m_Limit)
+                {
+                    m_Entries.push_back(entry);
+                    std::push_heap(m_Entries.begin(), m_Entries.end(), m_Greater);
+                }
+                else if (m_Greater(entry, m_Entries.front()))
+                {
+                    std::pop_heap(m_Entries.begin(), m_Entries.end(), m_Greater);
+                    m_Entries.back() = entry;
+                    std::push_heap(m_Entries.begin(), m_Entries.end(), m_Greater);
+                }
+            }
+
+            // Highest score first.
+            std::vector<T> Take()
+            {
+                std::sort_heap(m_Entries.begin(), m_Entries.end(), m_Greater);
+                return std::move(m_Entries);
+            }
+
+        private:
+            struct Greater
+            {
+                Score score;
+
+                Greater(Score _score) : score(_score)
+                {
+                }
+
+                bool operator()(const T& lhs, const T& rhs) const
+                {
+                    return score(lhs) > score(rhs);
+                }
+            };
+
+            size_t m_Limit;
+            Greater m_Greater;
+            std::vector<T> m_Entries;
+        };
+
+        template <typename T, typename Score>
+        TopEntries<T, Score> MakeTopEntries(size_t limit, Score score)
+        {
+            return TopEntries<T, Score>(limit, score);
+        }
+
+        // Walks two aggregates in key order, calling fn(before, after) once per key;
+        // the side that did not see the key is passed as nullptr.
+        template <typename Aggregator, typename Less, typename Function>
+        void MergeJoin(Aggregator& before, Aggregator& after, Less less, Function fn)
+        {
+            typename Aggregator::Entry beforeEntry;
+            typename Aggregator::Entry afterEntry;
+            bool hasBefore = before.Next(&beforeEntry);
+            bool hasAfter = after.Next(&afterEntry);
+            while (hasBefore || hasAfter)
+            {
+                if (hasBefore && (!hasAfter || less(beforeEntry.first, afterEntry.first)))
+                {
+                    fn(&beforeEntry, nullptr);
+                    hasBefore = before.Next(&beforeEntry);
+                }
+                else if (hasAfter && (!hasBefore || less(afterEntry.first, beforeEntry.first)))
+                {
+                    fn(nullptr, &afterEntry);
+                    hasAfter = after.Next(&afterEntry);
+                }
+                else
+                {
+                    fn(&beforeEntry, &afterEntry);
+                    hasBefore = before.Next(&beforeEntry);
+                    hasAfter = after.Next(&afterEntry);
+                }
+            }
+        }
+
+        bool IsV4Mapped(const IN6_ADDR& address)
+        {
+            static const unsigned char prefix[12] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff };
+            return memcmp(address.u.Byte, prefix, sizeof(prefix)) == 0;
+        }
+
+        std::wstring FormatMappedAddress(const IN6_ADDR& address)
+        {
+            return FormatAddress(address, !IsV4Mapped(address));
+        }
+
+        bool ParsePort(const std::wstring& text, _Out_ unsigned short* port)
+        {
+            *port = 0;
+            if (text.empty() ||
+                text.size() > 5 ||
+                text.find_first_not_of(L"0123456789") != std::wstring::npos)
+            {
+                return false;
+            }
+            unsigned long value = std::stoul(text);
+            if (value > USHRT_MAX)
+            {
+                return false;
+            }
+            *port = static_cast<unsigned short>(value);
+            return true;
+        }
+
+        // Splits "name = value, name = value" as written by OutputToStream.
+        std::vector<std::pair<std::wstring, std::wstring>> ParseFields(const std::wstring& text)
+        {
+            static const std::wstring fieldSeparator = L", ";
+            static const std::wstring valueSeparator = L" = ";
+
+            std::vector<std::pair<std::wstring, std::wstring>> fields;
+            size_t start = 0;
+            while (start <= text.size())
+            {
+                size_t end = text.find(fieldSeparator, start);
+                if (end == std::wstring::npos)
+                {
+                    end = text.size();
+                }
+                std::wstring field = text.substr(start, end - start);
+                size_t equals = field.find(valueSeparator);
+                if (equals != std::wstring::npos)
+                {
+                    fields.emplace_back(field.substr(0, equals), field.substr(equals + valueSeparator.size()));
+                }
+                start = end + fieldSeparator.size();
+            }
+            return fields;
+        }
+
+        // Returns the text between "<name> {" and the last '}' of the line, if the line is that block.
+        bool BlockContents(const std::wstring& line, const std::wstring& name, _Out_ std::wstring* contents)
+        {
+            if (line.compare(0, name.size(), name) != 0)
+            {
+                return false;
+            }
+            size_t close = line.rfind(L'}');
+            if (close == std::wstring::npos || close < name.size())
+            {
+                return false;
+            }
+            *contents = line.substr(name.size(), close - name.size());
+            return true;
+        }
+
+        // Reads the JSON string starting at the quote at *position, undoing the escapes written by
+        // FormatEventJson, and moves *position past its closing quote.
+        bool ReadJsonString(const std::wstring& text, _Inout_ size_t* position, _Out_ std::wstring* value)
+        {
+            value->clear();
+            for (size_t next = *position + 1; next < text.size(); ++next)
+            {
+                wchar_t ch = text[next];
+                if (ch == L'"')
+                {
+                    *position = next + 1;
+                    return true;
+                }
+                if (ch != L'\\')
+                {
+                    value->push_back(ch);
+                    continue;
+                }
+
+                if (++next == text.size())
+                {
+                    return false;
+                }
+                switch (text[next])
+                {
+                case L'n': value->push_back(L'\n'); break;
+                case L'r': value->push_back(L'\r'); break;
+                case L't': value->push_back(L'\t'); break;
+                case L'b': value->push_back(L'\b'); break;
+                case L'f': value->push_back(L'\f'); break;
+                case L'u':
+                    if (next + 4 >= text.size() ||
+                        text.substr(next + 1, 4).find_first_not_of(L"0123456789abcdefABCDEF") != std::wstring::npos)
+                    {
+                        return false;
+                    }
+                    value->push_back(static_cast<wchar_t>(std::stoul(text.substr(next + 1, 4), nullptr, 16)));
+                    next += 4;
+                    break;
+                default: value->push_back(text[next]); break;
+                }
+            }
+            return false;
+        }
+
+        // Splits a one-line object written by -LogFormat Json into its "name":"value" and
+        // "name":number fields.
+        std::vector<std::pair<std::wstring, std::wstring>> ParseJsonFields(const std::wstring& text)
+        {
+            std::vector<std::pair<std::wstring, std::wstring>> fields;
+            size_t position = text.find(L'"');
+            while (position != std::wstring::npos)
+            {
+                std::wstring name;
+                std::wstring value;
+                if (!ReadJsonString(text, &position, &name))
+                {
+                    break;
+                }
+                position = text.find_first_not_of(L" :", position);
+                if (position == std::wstring::npos)
+                {
+                    break;
+                }
+                if (text[position] == L'"')
+                {
+                    if (!ReadJsonString(text, &position, &value))
+                    {
+                        break;
+                    }
+                }
+                else
+                {
+                    size_t end = text.find_first_of(L", }", position);
+                    value = text.substr(position, end == std::wstring::npos ? std::wstring::npos : end - position);
+                    position = end;
+                }
+                fields.emplace_back(std::move(name), std::move(value));
+
+                if (position != std::wstring::npos)
+                {
+                    position = text.find(L'"', position);
+                }
+            }
+            return fields;
+        }
+
+        // Direction and action, from a word of the text header or a JSON field.
+        void ParseHeaderWord(const std::wstring& word, _Inout_ CompactEventRecord* record)
+        {
+            if (word == L"Inbound") record->direction = TrafficDirection::Inbound;
+            else if (word == L"Outbound") record->direction = TrafficDirection::Outbound;
+            else if (word == L"Allow") record->action = RuleAction::Allow;
+            else if (word == L"Deny") record->action = RuleAction::Deny;
+        }
+
+        // A field of the text flow block, or the JSON field of the same name.
+        void ParseFlowField(const std::wstring& name, const std::wstring& value, _Inout_ CompactEventRecord* record)
+        {
+            bool isIpv6 = false;
+            if (name == L"src")
+            {
+                ParseAddress(value, &record->source, &isIpv6);
+                record->isIpv6 = record->isIpv6 || isIpv6;
+            }
+            else if (name == L"dst")
+            {
+                ParseAddress(value, &record->destination, &isIpv6);
+                record->isIpv6 = record->isIpv6 || isIpv6;
+            }
+            else if (name == L"protocol")
+            {
+                ParseProtocolName(value, &record->protocol);
+            }
+            else if (name == L"srcPort")
+            {
+                ParsePort(value, &record->sourcePort);
+            }
+            else if (name == L"dstPort")
+            {
+                ParsePort(value, &record->destinationPort);
+            }
+            else if (name == L"isTcpSyn")
+            {
+                record->isTcpSyn =
+                    !value.empty() &&
+                    value != L"0" &&
+                    !ntl::String::iordinal_equals(value, L"false");
+            }
+            else if (name == L"sampleRate")
+            {
+                FlowSampler::ParseSampleRate(value, &record->sampleRate);
+            }
+        }
+
+        // Adds the events that pass the -IP and -Rule filters to an aggregate. With filters, events
+        // are tested a batch at a time by the filter's vector kernel; Flush() after the last one.
+        class FilteredCapture
+        {
+        public:
+            FilteredCapture(const BatchFilter& filter, CaptureAggregate* aggregate)
+                : m_Filter(&filter),
+                m_Aggregate(aggregate)
+            {
+                if (!filter.IsEmpty())
+                {
+                    m_Batch = std::make_unique<EventBatch>();
+                    m_Records.reserve(EventBatch::Capacity);
+                }
+            }
+
+            void Add(const CompactEventRecord& record)
+            {
+                if (!m_Batch)
+                {
+                    m_Aggregate->Add(record);
+                    return;
+                }
+
+                m_Batch->Add(record);
+                m_Records.push_back(record);
+                if (m_Batch->count == EventBatch::Capacity)
+                {
+                    Flush();
+                }
+            }
+
+            void Flush()
+            {
+                if (!m_Batch ||
+                    m_Batch->count == 0)
+                {
+                    return;
+                }
+
+                uint64_t selection[EventBatch::SelectionWords];
+                if (m_Filter->Evaluate(*m_Batch, selection) > 0)
+                {
+                    for (size_t row = 0; row < m_Records.size(); ++row)
+                    {
+                        if ((selection[row / 64] >> (row % 64)) & 1)
+                        {
+                            m_Aggregate->Add(m_Records[row]);
+                        }
+                    }
+                }
+                m_Batch->Clear();
+                m_Records.clear();
+            }
+
+        private:
+            const BatchFilter* m_Filter;
+            CaptureAggregate* m_Aggregate;
+            std::unique_ptr<EventBatch> m_Batch; // Null when nothing is filtered out.
+            std::vector<CompactEventRecord> m_Records; // The batch's rows in full.
+        };
+
+        // Feeds the rule match events of a saved ETW session to a capture.
+        // Always returns false: nothing is queued in the reader.
+        struct CaptureEtwFilter
+        {
+            FilteredCapture* capture;
+
+            bool operator()(const PEVENT_RECORD pEventRecord)
+            {
+                ntl::EtwRecord record(pEventRecord);
+                if (FirewallEtwTraceCallback::IsRuleMatchEvent(record))
+                {
+                    capture->Add(FirewallEtwTraceCallback::CollectEventData(record).compact);
+                }
+                return false;
+            }
+        };
+
+        void ReadEtl(const std::wstring& path, FilteredCapture* capture)
+        {
+            ntl::EtwReader<CaptureEtwFilter> reader(CaptureEtwFilter{ capture });
+            reader.OpenSavedSession(path.c_str());
+            reader.WaitForSession();
+        }
+
+        // Reads an archive written by -Archive a batch at a time, straight into records.
+        void ReadArchive(const std::wstring& path, FilteredCapture* capture)
+        {
+            EventArchiveReader reader(path);
+            std::vector<CompactEventRecord> events;
+            for (size_t batch = 0; batch < reader.GetBatchCount(); ++batch)
+            {
+                reader.ReadEvents(batch, &events);
+                for (const auto& record : events)
+                {
+                    capture->Add(record);
+                }
+            }
+        }
+
+        void ReadRawLog(const std::wstring& path, FilteredCapture* capture)
+        {
+            std::wifstream logFile(path);
+            if (!logFile.is_open())
+            {
+                throw std::exception("Unable to open capture file.");
+            }
+
+            RawLogParser parser;
+            CompactEventRecord record;
+            std::wstring line;
+            while (std::getline(logFile, line))
+            {
+                if (parser.ParseLine(line, &record))
+                {
+                    capture->Add(record);
+                }
+            }
+        }
+    }
+
+    void FlowOutcome::Merge(const FlowOutcome& other)
+    {
+        if (allowHits == 0)
+        {
+            allowRuleId = other.allowRuleId;
+        }
+        if (denyHits == 0)
+        {
+            denyRuleId = other.denyRuleId;
+        }
+        allowHits += other.allowHits;
+        denyHits += other.denyHits;
+    }
+
+    RuleAction FlowOutcome::Outcome() const
+    {
+        if (denyHits == 0 && allowHits > 0)
+        {
+            return RuleAction::Allow;
+        }
+        if (allowHits == 0 && denyHits > 0)
+        {
+            return RuleAction::Deny;
+        }
+        return RuleAction::Unknown;
+    }
+
+    void RuleHits::Merge(const RuleHits& other)
+    {
+        allowHits += other.allowHits;
+        denyHits += other.denyHits;
+    }
+
+    unsigned long long RuleHits::TotalHits() const
+    {
+        return allowHits + denyHits;
+    }
+
+    void SourceHits::Merge(const SourceHits& other)
+    {
+        hits += other.hits;
+    }
+
+    bool FlowKeyLess::operator()(const FlowKey& lhs, const FlowKey& rhs) const
+    {
+        int order = memcmp(&lhs.lowAddress, &rhs.lowAddress, sizeof(IN6_ADDR));
+        if (order != 0)
+        {
+            return order < 0;
+        }
+        order = memcmp(&lhs.highAddress, &rhs.highAddress, sizeof(IN6_ADDR));
+        if (order != 0)
+        {
+            return order < 0;
+        }
+        if (lhs.lowPort != rhs.lowPort)
+        {
+            return lhs.lowPort < rhs.lowPort;
+        }
+        if (lhs.highPort != rhs.highPort)
+        {
+            return lhs.highPort < rhs.highPort;
+        }
+        return lhs.protocol < rhs.protocol;
+    }
+
+    bool GuidLess::operator()(const GUID& lhs, const GUID& rhs) const
+    {
+        return memcmp(&lhs, &rhs, sizeof(GUID)) < 0;
+    }
+
+    bool AddressLess::operator()(const IN6_ADDR& lhs, const IN6_ADDR& rhs) const
+    {
+        return memcmp(&lhs, &rhs, sizeof(IN6_ADDR)) < 0;
+    }
+
+    CaptureAggregate::CaptureAggregate(size_t maxEntriesInMemory)
+        : m_Flows(maxEntriesInMemory),
+        m_Rules(maxEntriesInMemory),
+        m_Sources(maxEntriesInMemory)
+    {
+    }
+
+    void CaptureAggregate::Add(const CompactEventRecord& record)
+    {
+        // A sampled event stands for sampleRate events, so captures taken at
+        // different sample rates compare on the same scale.
+        unsigned long long hits = record.sampleRate;
+        m_EventCount += hits;
+
+        FlowOutcome outcome;
+        RuleHits ruleHits;
+        if (record.action == RuleAction::Allow)
+        {
+            outcome.allowHits = hits;
+            outcome.allowRuleId = record.ruleId;
+            ruleHits.allowHits = hits;
+        }
+        else if (record.action == RuleAction::Deny)
+        {
+            outcome.denyHits = hits;
+            outcome.denyRuleId = record.ruleId;
+            ruleHits.denyHits = hits;
+        }
+
+        m_Flows.Add(FlowKey::FromRecord(record), outcome);
+        m_Rules.Add(record.ruleId, ruleHits);
+
+        SourceHits sourceHits;
+        sourceHits.hits = hits;
+        m_Sources.Add(record.source, sourceHits);
+    }
+
+    void CaptureAggregate::Finish()
+    {
+        m_Flows.Finish();
+        m_Rules.Finish();
+        m_Sources.Finish();
+    }
+
+    unsigned long long CaptureAggregate::GetEventCount() const
+    {
+        return m_EventCount;
+    }
+
+    SortedRunAggregator<FlowKey, FlowOutcome, FlowKeyHash, FlowKeyLess>& CaptureAggregate::Flows()
+    {
+        return m_Flows;
+    }
+
+    SortedRunAggregator<GUID, RuleHits, GuidHash, GuidLess>& CaptureAggregate::Rules()
+    {
+        return m_Rules;
+    }
+
+    SortedRunAggregator<IN6_ADDR, SourceHits, AddressHash, AddressLess, AddressEqual>& CaptureAggregate::Sources()
+    {
+        return m_Sources;
+    }
+
+    bool RawLogParser::ParseLine(const std::wstring& line, _Out_ CompactEventRecord* record)
+    {
+        size_t start = line.find_first_not_of(L' ');
+        if (start == std::wstring::npos)
+        {
+            return false;
+        }
+        std::wstring trimmed = line.substr(start);
+        std::wstring contents;
+
+        if (trimmed[0] == L'{')
+        {
+            // -LogFormat Json: the whole event on one line.
+            m_HasHeader = false;
+            CompactEventRecord parsed;
+            bool hasRule = false;
+            for (const auto& field : ParseJsonFields(trimmed))
+            {
+                if (field.first == L"direction" ||
+                    field.first == L"ruleType")
+                {
+                    ParseHeaderWord(field.second, &parsed);
+                }
+                else if (field.first == L"ruleId")
+                {
+                    hasRule = ParseGuid(field.second, &parsed.ruleId);
+                }
+                else
+                {
+                    ParseFlowField(field.first, field.second, &parsed);
+                }
+            }
+            if (hasRule)
+            {
+                *record = parsed;
+            }
+            return hasRule;
+        }
+
+        if (trimmed[0] == L'[')
+        {
+            // [date time] direction ruleType rule status = ...
+            size_t close = trimmed.find(L']');
+            if (close == std::wstring::npos)
+            {
+                return false;
+            }
+
+            m_Pending = CompactEventRecord{};
+            std::wistringstream words(trimmed.substr(close + 1));
+            std::wstring word;
+            while (words >> word && word != L"rule")
+            {
+                ParseHeaderWord(word, &m_Pending);
+            }
+            m_HasHeader = (word == L"rule");
+            return false;
+        }
+
+        if (m_HasHeader && BlockContents(trimmed, L"flow {", &contents))
+        {
+            for (const auto& field : ParseFields(contents))
+            {
+                ParseFlowField(field.first, field.second, &m_Pending);
+            }
+            return false;
+        }
+
+        if (m_HasHeader && BlockContents(trimmed, L"rule {", &contents))
+        {
+            for (const auto& field : ParseFields(contents))
+            {
+                if (field.first == L"id")
+                {
+                    ParseGuid(field.second, &m_Pending.ruleId);
+                }
+            }
+            *record = m_Pending;
+            m_HasHeader = false;
+            return true;
+        }
+
+        return false;
+    }
+
+    CaptureDiff::CaptureDiff(
+        size_t maxEntriesInMemory,
+        size_t reportLimit,
+        const BatchFilter& filter)
+        : m_MaxEntriesInMemory(maxEntriesInMemory),
+        m_ReportLimit(reportLimit),
+        m_Filter(filter)
+    {
+    }
+
+    void CaptureDiff::ReadCapture(
+        const std::wstring& path,
+        CaptureAggregate* aggregate,
+        const BatchFilter& filter)
+    {
+        FilteredCapture capture(filter, aggregate);
+        if (ntl::String::iends_with(path, L".etl"))
+        {
+            ReadEtl(path, &capture);
+        }
+        else if (EventArchiveReader::IsArchive(path))
+        {
+            ReadArchive(path, &capture);
+        }
+        else
+        {
+            ReadRawLog(path, &capture);
+        }
+        capture.Flush();
+    }
+
+    CaptureDiffReport CaptureDiff::Compare(const std::wstring& beforePath, const std::wstring& afterPath) const
+    {
+        CaptureAggregate before(m_MaxEntriesInMemory);
+        CaptureAggregate after(m_MaxEntriesInMemory);
+
+        // The two sides are independent until the merge: read them in parallel.
+        auto beforeRead = std::async(std::launch::async, [&]()
+        {
+            ReadCapture(beforePath, &before, m_Filter);
+            before.Finish();
+        });
+        auto afterRead = std::async(std::launch::async, [&]()
+        {
+            ReadCapture(afterPath, &after, m_Filter);
+            after.Finish();
+        });
+        // Wait for both before rethrowing, so neither thread outlives its aggregate.
+        beforeRead.wait();
+        afterRead.wait();
+        beforeRead.get();
+        afterRead.get();
+
+        return Diff(before, after);
+    }
+
+    CaptureDiffReport CaptureDiff::Compare(CaptureAggregate& before, CaptureAggregate& after) const
+    {
+        before.Finish();
+        after.Finish();
+        return Diff(before, after);
+    }
+
+    CaptureDiffReport CaptureDiff::Diff(CaptureAggregate& before, CaptureAggregate& after) const
+    {
+        CaptureDiffReport report;
+        report.eventsBefore = before.GetEventCount();
+        report.eventsAfter = after.GetEventCount();
+
+        {
+            auto flipped = MakeTopEntries<FlippedFlow>(m_ReportLimit, [](const FlippedFlow& flow)
+            {
+                return flow.after.allowHits + flow.after.denyHits;
+            });
+            typedef SortedRunAggregator<FlowKey, FlowOutcome, FlowKeyHash, FlowKeyLess>::Entry FlowEntry;
+            MergeJoin(before.Flows(), after.Flows(), FlowKeyLess(), [&](const FlowEntry* beforeFlow, const FlowEntry* afterFlow)
+            {
+                if (beforeFlow != nullptr)
+                {
+                    report.flowsBefore++;
+                }
+                if (afterFlow != nullptr)
+                {
+                    report.flowsAfter++;
+                }
+                if (beforeFlow != nullptr &&
+                    afterFlow != nullptr &&
+                    beforeFlow->second.Outcome() != afterFlow->second.Outcome())
+                {
+                    report.flowsFlipped++;
+                    flipped.Offer(FlippedFlow{ beforeFlow->first, beforeFlow->second, afterFlow->second });
+                }
+            });
+            report.flippedFlows = flipped.Take();
+        }
+
+        {
+            auto changes = MakeTopEntries<RuleHitChange>(m_ReportLimit, [](const RuleHitChange& change)
+            {
+                unsigned long long beforeHits = change.before.TotalHits();
+                unsigned long long afterHits = change.after.TotalHits();
+                return beforeHits > afterHits ? beforeHits - afterHits : afterHits - beforeHits;
+            });
+            typedef SortedRunAggregator<GUID, RuleHits, GuidHash, GuidLess>::Entry RuleEntry;
+            MergeJoin(before.Rules(), after.Rules(), GuidLess(), [&](const RuleEntry* beforeRule, const RuleEntry* afterRule)
+            {
+                RuleHitChange change;
+                change.ruleId = beforeRule != nullptr ? beforeRule->first : afterRule->first;
+                if (beforeRule != nullptr)
+                {
+                    change.before = beforeRule->second;
+                }
+                if (afterRule != nullptr)
+                {
+                    change.after = afterRule->second;
+                }
+
+                if (beforeRule == nullptr)
+                {
+                    report.rulesAdded++;
+                }
+                else if (afterRule == nullptr)
+                {
+                    report.rulesRemoved++;
+                }
+                else if (change.before.allowHits == change.after.allowHits &&
+                    change.before.denyHits == change.after.denyHits)
+                {
+                    return;
+                }
+                report.rulesChanged++;
+                changes.Offer(change);
+            });
+            report.ruleChanges = changes.Take();
+        }
+
+        {
+            auto sources = MakeTopEntries<NewSource>(m_ReportLimit, [](const NewSource& source)
+            {
+                return source.hits;
+            });
+            typedef SortedRunAggregator<IN6_ADDR, SourceHits, AddressHash, AddressLess, AddressEqual>::Entry SourceEntry;
+            MergeJoin(before.Sources(), after.Sources(), AddressLess(), [&](const SourceEntry* beforeSource, const SourceEntry* afterSource)
+            {
+                if (beforeSource == nullptr)
+                {
+                    report.sourcesAdded++;
+                    sources.Offer(NewSource{ afterSource->first, afterSource->second.hits });
+                }
+            });
+            report.newSources = sources.Take();
+        }
+
+        return report;
+    }
+
+    void CaptureDiff::PrintReport(const CaptureDiffReport& report, _In_ FILE* stream)
+    {
+        fwprintf(stream, L"Capture diff {before = %llu events, after = %llu events} \n",
+            report.eventsBefore,
+            report.eventsAfter);
+
+        fwprintf(stream, L"  flows {before = %llu, after = %llu, flipped = %llu} \n",
+            report.flowsBefore,
+            report.flowsAfter,
+            report.flowsFlipped);
+        for (const auto& flow : report.flippedFlows)
+        {
+            LPCWSTR protocolName = ProtocolName(flow.key.protocol);
+            std::wstring protocol = protocolName != NULL ? protocolName : std::to_wstring(flow.key.protocol);
+            fwprintf(stream, L"    %ls:%hu <-> %ls:%hu %ls: %ls -> %ls {hits = %llu -> %llu, rule = %ls -> %ls} \n",
+                FormatMappedAddress(flow.key.lowAddress).c_str(),
+                flow.key.lowPort,
+                FormatMappedAddress(flow.key.highAddress).c_str(),
+                flow.key.highPort,
+                protocol.c_str(),
+                flow.before.Outcome() == RuleAction::Unknown ? L"Mixed" : RuleActionName(flow.before.Outcome()),
+                flow.after.Outcome() == RuleAction::Unknown ? L"Mixed" : RuleActionName(flow.after.Outcome()),
+                flow.before.allowHits + flow.before.denyHits,
+                flow.after.allowHits + flow.after.denyHits,
+                FormatGuid(flow.before.denyHits > 0 ? flow.before.denyRuleId : flow.before.allowRuleId).c_str(),
+                FormatGuid(flow.after.denyHits > 0 ? flow.after.denyRuleId : flow.after.allowRuleId).c_str());
+        }
+
+        fwprintf(stream, L"  rules {changed = %llu, new = %llu, gone = %llu} \n",
+            report.rulesChanged,
+            report.rulesAdded,
+            report.rulesRemoved);
+        for (const auto& change : report.ruleChanges)
+        {
+            long long delta =
+                static_cast<long long>(change.after.TotalHits()) -
+                static_cast<long long>(change.before.TotalHits());
+            fwprintf(stream, L"    %ls: hits = %llu -> %llu (%+lld) {allow = %llu -> %llu, deny = %llu -> %llu} \n",
+                FormatGuid(change.ruleId).c_str(),
+                change.before.TotalHits(),
+                change.after.TotalHits(),
+                delta,
+                change.before.allowHits,
+                change.after.allowHits,
+                change.before.denyHits,
+                change.after.denyHits);
+        }
+
+        fwprintf(stream, L"  sources {new = %llu} \n", report.sourcesAdded);
+        for (const auto& source : report.newSources)
+        {
+            fwprintf(stream, L"    %ls: hits = %llu \n",
+                FormatMappedAddress(source.address).c_str(),
+                source.hits);
+        }
+    }
+}
@@ -0,0 +1,191 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#pragma once
+
+// OS Headers
+#include <Windows.h>
+// c++ headers
+#include <string>
+#include <vector>
+
+#include "BatchFilter.h"
+#include "CompactEventRecord.h"
+#include "FlowPairing.h"
+#include "SortedRunAggregator.h"
+
+namespace FirewallEventMonitor
+{
+    // Outcomes of one flow (either direction) within a capture.
+    struct FlowOutcome
+    {
+    public:
+        unsigned long long allowHits = 0;
+        unsigned long long denyHits = 0;
+        GUID allowRuleId = {}; // A rule that allowed the flow.
+        GUID denyRuleId = {}; // A rule that denied the flow.
+
+        void Merge(const FlowOutcome& other);
+
+        // Allow or Deny if every hit agreed, otherwise Unknown.
+        RuleAction Outcome() const;
+    };
+
+    struct RuleHits
+    {
+    public:
+        unsigned long long allowHits = 0;
+        unsigned long long denyHits = 0;
+
+        void Merge(const RuleHits& other);
+
+        unsigned long long TotalHits() const;
+    };
+
+    struct SourceHits
+    {
+    public:
+        unsigned long long hits = 0;
+
+        void Merge(const SourceHits& other);
+    };
+
+    struct FlowKeyLess
+    {
+        bool operator()(const FlowKey& lhs, const FlowKey& rhs) const;
+    };
+
+    struct GuidLess
+    {
+        bool operator()(const GUID& lhs, const GUID& rhs) const;
+    };
+
+    struct AddressLess
+    {
+        bool operator()(const IN6_ADDR& lhs, const IN6_ADDR& rhs) const;
+    };
+
+    // Flow, rule and source aggregates for one capture, in bounded memory.
+    class CaptureAggregate
+    {
+    public:
+        CaptureAggregate(size_t maxEntriesInMemory);
+
+        void Add(const CompactEventRecord& record);
+
+        // Call once after the last Add() and before reading the aggregates.
+        void Finish();
+
+        // Events added, each scaled up by its sample rate.
+        unsigned long long GetEventCount() const;
+
+        SortedRunAggregator<FlowKey, FlowOutcome, FlowKeyHash, FlowKeyLess>& Flows();
+
+        SortedRunAggregator<GUID, RuleHits, GuidHash, GuidLess>& Rules();
+
+        SortedRunAggregator<IN6_ADDR, SourceHits, AddressHash, AddressLess, AddressEqual>& Sources();
+
+        CaptureAggregate(CaptureAggregate const&) = delete;
+        CaptureAggregate& operator=(CaptureAggregate const&) = delete;
+    private:
+        SortedRunAggregator<FlowKey, FlowOutcome, FlowKeyHash, FlowKeyLess> m_Flows;
+        SortedRunAggregator<GUID, RuleHits, GuidHash, GuidLess> m_Rules;
+        SortedRunAggregator<IN6_ADDR, SourceHits, AddressHash, AddressLess, AddressEqual> m_Sources;
+        unsigned long long m_EventCount = 0;
+    };
+
+    // Rebuilds events from the text written by -Output Console/File, one line at a time,
+    // in either -LogFormat.
+    class RawLogParser
+    {
+    public:
+        // Returns true when the line completes an event (the rule line).
+        bool ParseLine(const std::wstring& line, _Out_ CompactEventRecord* record);
+
+    private:
+        CompactEventRecord m_Pending;
+        bool m_HasHeader = false;
+    };
+
+    struct FlippedFlow
+    {
+    public:
+        FlowKey key;
+        FlowOutcome before;
+        FlowOutcome after;
+    };
+
+    struct RuleHitChange
+    {
+    public:
+        GUID ruleId = {};
+        RuleHits before;
+        RuleHits after;
+    };
+
+    struct NewSource
+    {
+    public:
+        IN6_ADDR address = {};
+        unsigned long long hits = 0;
+    };
+
+    struct CaptureDiffReport
+    {
+    public:
+        unsigned long long eventsBefore = 0;
+        unsigned long long eventsAfter = 0;
+        // Totals across every key.
+        unsigned long long flowsBefore = 0;
+        unsigned long long flowsAfter = 0;
+        unsigned long long flowsFlipped = 0;
+        unsigned long long rulesChanged = 0;
+        unsigned long long rulesAdded = 0; // Hit only after.
+        unsigned long long rulesRemoved = 0; // Hit only before.
+        unsigned long long sourcesAdded = 0;
+        // The largest changes, sorted.
+        std::vector<FlippedFlow> flippedFlows; // Most hits after first.
+        std::vector<RuleHitChange> ruleChanges; // Largest change in hits first.
+        std::vector<NewSource> newSources; // Most hits first.
+    };
+
+    // Compares rule and flow outcomes between two captures, e.g. before and after a policy push.
+    // Each capture is read and aggregated on its own thread; the sorted aggregates are then
+    // merge-joined, so memory stays bounded however many events each side holds.
+    // Only the events that pass the filter (-IP and -Rule) are compared.
+    class CaptureDiff
+    {
+    public:
+        CaptureDiff(
+            size_t maxEntriesInMemory = DefaultMaxEntriesInMemory,
+            size_t reportLimit = DefaultReportLimit,
+            const BatchFilter& filter = BatchFilter());
+
+        CaptureDiffReport Compare(const std::wstring& beforePath, const std::wstring& afterPath) const;
+
+        // Finishes both aggregates and compares them.
+        CaptureDiffReport Compare(CaptureAggregate& before, CaptureAggregate& after) const;
+
+        // Reads an ETL file (.etl), an archive written by -Archive (any extension, found by its
+        // magic) or a text log written by this tool (anything else), keeping the events that
+        // pass the filter.
+        static void ReadCapture(
+            const std::wstring& path,
+            CaptureAggregate* aggregate,
+            const BatchFilter& filter = BatchFilter());
+
+        static void PrintReport(const CaptureDiffReport& report, _In_ FILE* stream);
+
+        // Constants
+        static const size_t DefaultMaxEntriesInMemory = 4 * 1024 * 1024; // Per aggregate, per capture.
+        static const size_t DefaultReportLimit = 50; // Entries printed per section.
+
+    private:
+        const size_t m_MaxEntriesInMemory;
+        const size_t m_ReportLimit;
+        const BatchFilter m_Filter;
+
+        // Merge-joins two finished aggregates.
+        CaptureDiffReport Diff(CaptureAggregate& before, CaptureAggregate& after) const;
+    };
+}
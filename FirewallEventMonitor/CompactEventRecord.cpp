@@ -0,0 +1,172 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include "CompactEventRecord.h"
+
+// c++ headers
+#include <algorithm>
+// ntl headers
+#include "ntlSockaddr.hpp"
+#include "ntlUuid.hpp"
+
+namespace FirewallEventMonitor
+{
+    namespace
+    {
+        struct ProtocolNameEntry
+        {
+            unsigned short protocol;
+            LPCWSTR name;
+        };
+
+        const ProtocolNameEntry PROTOCOL_NAMES[] = {
+            { 0, L"HOPOPT" },
+            { 1, L"ICMPv4" },
+            { 2, L"IGMP" },
+            { 6, L"TCP" },
+            { 17, L"UDP" },
+            { 41, L"IPv6" },
+            { 43, L"IPv6Route" },
+            { 44, L"IPv6Frag" },
+            { 47, L"GRE" },
+            { 58, L"ICMPv6" },
+            { 59, L"IPv6NoNxt" },
+            { 60, L"IPv6Opts" },
+            { 256, L"ANY" },
+        };
+    }
+
+    bool ParseGuid(const std::wstring& text, _Out_ GUID* guid)
+    {
+        *guid = GUID{};
+        return ntl::Uuid::parse_uuid(text.c_str(), text.size(), guid);
+    }
+
+    bool ParseAddress(const std::wstring& text, _Out_ IN6_ADDR* address, _Out_ bool* isIpv6)
+    {
+        *address = IN6_ADDR{};
+        *isIpv6 = false;
+
+        IN_ADDR v4;
+        if (ntl::parse_ipv4(text.c_str(), text.size(), &v4))
+        {
+            address->u.Byte[10] = 0xff;
+            address->u.Byte[11] = 0xff;
+            memcpy(&address->u.Byte[12], &v4, sizeof(v4));
+            return true;
+        }
+
+        if (ntl::parse_ipv6(text.c_str(), text.size(), address))
+        {
+            *isIpv6 = true;
+            return true;
+        }
+
+        return false;
+    }
+
+    std::wstring FormatAddress(const IN6_ADDR& address, bool isIpv6)
+    {
+        WCHAR buffer[ntl::IPV6_STRING_MAX_LENGTH];
+        size_t length = 0;
+        if (isIpv6)
+        {
+            length = ntl::format_ipv6(address, buffer, ntl::IPV6_STRING_MAX_LENGTH);
+        }
+        else
+        {
+            IN_ADDR v4;
+            memcpy(&v4, &address.u.Byte[12], sizeof(v4));
+            length = ntl::format_ipv4(v4, buffer, ntl::IPV4_STRING_MAX_LENGTH);
+        }
+        return std::wstring(buffer, length);
+    }
+
+    std::wstring FormatGuid(const GUID& guid)
+    {
+        return ntl::Uuid::uuid_to_string(guid);
+    }
+
+    void AppendUtf8(const std::wstring& text, _Inout_ std::string* buffer)
+    {
+        // Event text is almost always ASCII, which is copied directly.
+        bool ascii = std::all_of(text.begin(), text.end(), [](wchar_t ch) { return ch < 0x80; });
+        if (ascii)
+        {
+            for (wchar_t ch : text)
+            {
+                buffer->push_back(static_cast<char>(ch));
+            }
+            return;
+        }
+
+        int length = ::WideCharToMultiByte(CP_UTF8, 0, text.c_str(), static_cast<int>(text.size()), NULL, 0, NULL, NULL);
+        if (length <= 0)
+        {
+            return;
+        }
+
+        size_t offset = buffer->size();
+        buffer->resize(offset + length);
+        ::WideCharToMultiByte(CP_UTF8, 0, text.c_str(), static_cast<int>(text.size()), &(*buffer)[offset], length, NULL, NULL);
+    }
+
+    LPCWSTR RuleActionName(RuleAction action)
+    {
+        switch (action)
+        {
+        case RuleAction::Allow: return L"Allow";
+        case RuleAction::Deny: return L"Deny";
+        default: return L"Unknown";
+        }
+    }
+
+    LPCWSTR TrafficDirectionName(TrafficDirection direction)
+    {
+        switch (direction)
+        {
+        case TrafficDirection::Outbound: return L"Outbound";
+        case TrafficDirection::Inbound: return L"Inbound";
+        default: return L"Unknown";
+        }
+    }
+
+    LPCWSTR ProtocolName(unsigned short protocol)
+    {
+        for (const auto& entry : PROTOCOL_NAMES)
+        {
+            if (entry.protocol == protocol)
+            {
+                return entry.name;
+            }
+        }
+        return NULL;
+    }
+
+    bool ParseProtocolName(const std::wstring& name, _Out_ unsigned short* protocol)
+    {
+        for (const auto& entry : PROTOCOL_NAMES)
+        {
+            if (name.compare(entry.name) == 0)
+            {
+                *protocol = entry.protocol;
+                return true;
+            }
+        }
+
+        *protocol = 0;
+        if (name.empty() ||
+            name.find_first_not_of(L"0123456789") != std::wstring::npos ||
+            name.size() > 5)
+        {
+            return false;
+        }
+        unsigned long value = std::stoul(name);
+        if (value > USHRT_MAX)
+        {
+            return false;
+        }
+        *protocol = static_cast<unsigned short>(value);
+        return true;
+    }
+}
@@ -0,0 +1,102 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#pragma once
+
+// os headers
+#include <winsock2.h>
+#include <ws2tcpip.h>
+// c++ headers
+#include <string>
+
+namespace FirewallEventMonitor
+{
+    // VFP RuleType values.
+    enum class RuleAction : unsigned char { Unknown = 0, Allow = 1, Deny = 2 };
+
+    // VFP Direction values.
+    enum class TrafficDirection : unsigned char { Outbound = 0, Inbound = 1, Unknown = 2 };
+
+    // Fixed-size binary form of a rule match event, used by the stateful analysis stages
+    // so they can hash and compare events without touching the formatted strings.
+    struct CompactEventRecord
+    {
+    public:
+        LONGLONG timeStamp = 0; // ETW event timestamp (FILETIME).
+        GUID ruleId = {};
+        // IPv4 addresses are stored v4-mapped (::ffff:a.b.c.d) so both families share one layout.
+        IN6_ADDR source = {};
+        IN6_ADDR destination = {};
+        unsigned short sourcePort = 0;
+        unsigned short destinationPort = 0;
+        unsigned short protocol = 0; // IANA protocol number; 256 = ANY.
+        RuleAction action = RuleAction::Unknown;
+        TrafficDirection direction = TrafficDirection::Unknown;
+        unsigned char icmpType = 0;
+        bool isIpv6 = false;
+        bool isTcpSyn = false;
+        unsigned char processor = 0; // Processor that logged the event (ETW buffer context); picks the counter shard.
+        unsigned long sampleRate = 1; // Recorded 1 in sampleRate flows (-SampleRate); 1 when every event is kept.
+    };
+
+    // Hash for GUID keys in the analysis tables.
+    struct GuidHash
+    {
+        size_t operator()(const GUID& guid) const
+        {
+            // GUIDs are already well distributed: fold the 128 bits and mix once.
+            unsigned long long low = 0, high = 0;
+            memcpy(&low, &guid, sizeof(low));
+            memcpy(&high, reinterpret_cast<const unsigned char*>(&guid) + sizeof(low), sizeof(high));
+            unsigned long long folded = (low ^ (high * 0x9E3779B97F4A7C15ull));
+            folded ^= folded >> 32;
+            return static_cast<size_t>(folded);
+        }
+    };
+
+    // Hash and equality for address keys in the analysis tables (IN6_ADDR has no operator==).
+    struct AddressHash
+    {
+        size_t operator()(const IN6_ADDR& address) const
+        {
+            unsigned long long low = 0, high = 0;
+            memcpy(&low, &address, sizeof(low));
+            memcpy(&high, reinterpret_cast<const unsigned char*>(&address) + sizeof(low), sizeof(high));
+            unsigned long long folded = (low ^ (high * 0x9E3779B97F4A7C15ull));
+            folded ^= folded >> 32;
+            return static_cast<size_t>(folded);
+        }
+    };
+
+    struct AddressEqual
+    {
+        bool operator()(const IN6_ADDR& left, const IN6_ADDR& right) const
+        {
+            return memcmp(&left, &right, sizeof(IN6_ADDR)) == 0;
+        }
+    };
+
+    // Parses "XXXXXXXX-XXXX-XXXX-XXXX-XXXXXXXXXXXX", with or without braces.
+    bool ParseGuid(const std::wstring& text, _Out_ GUID* guid);
+
+    // Parses an IPv4 or IPv6 address, storing IPv4 v4-mapped.
+    bool ParseAddress(const std::wstring& text, _Out_ IN6_ADDR* address, _Out_ bool* isIpv6);
+
+    // Converts a v4-mapped or IPv6 address back to text.
+    std::wstring FormatAddress(const IN6_ADDR& address, bool isIpv6);
+
+    std::wstring FormatGuid(const GUID& guid);
+
+    // Appends text as UTF-8, the encoding of syslog messages and archive strings.
+    void AppendUtf8(const std::wstring& text, _Inout_ std::string* buffer);
+
+    LPCWSTR RuleActionName(RuleAction action);
+
+    LPCWSTR TrafficDirectionName(TrafficDirection direction);
+
+    // Name of an IANA protocol number as printed in the log, or NULL if it has none.
+    LPCWSTR ProtocolName(unsigned short protocol);
+
+    // Inverse of ProtocolName; also accepts a decimal protocol number.
+    bool ParseProtocolName(const std::wstring& name, _Out_ unsigned short* protocol);
+}
@@ -0,0 +1,155 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include "ConsoleSink.h"
+
+// ntl headers
+#include "ntlLocks.hpp"
+
+namespace FirewallEventMonitor
+{
+    ConsoleSink::ConsoleSink(
+        FILE* stream,
+        size_t maxPendingCharacters,
+        DWORD refreshIntervalInMilliseconds)
+        : m_Stream(stream),
+        m_MaxPendingCharacters(maxPendingCharacters),
+        m_RefreshIntervalInMilliseconds(refreshIntervalInMilliseconds)
+    {
+        ::InitializeCriticalSectionEx(&m_CriticalSection, 4000, 0);
+
+        // Manual reset: once stopped, every later wait returns at once.
+        m_StopEvent = ::CreateEventW(NULL, TRUE, FALSE, NULL);
+        if (m_StopEvent == NULL)
+        {
+            ::DeleteCriticalSection(&m_CriticalSection);
+            throw std::exception("Unable to create the console writer stop event.");
+        }
+    }
+
+    ConsoleSink::~ConsoleSink()
+    {
+        Stop();
+        ::CloseHandle(m_StopEvent);
+        ::DeleteCriticalSection(&m_CriticalSection);
+    }
+
+    LPCWSTR ConsoleSink::GetName() const
+    {
+        return L"Console";
+    }
+
+    EventFormat ConsoleSink::GetFormat() const
+    {
+        return EventFormat::Text;
+    }
+
+    void ConsoleSink::Start()
+    {
+        if (m_Writer.joinable())
+        {
+            return;
+        }
+
+        ::ResetEvent(m_StopEvent);
+        m_Writer = std::thread(&ConsoleSink::WriterThread, this);
+    }
+
+    void ConsoleSink::Stop()
+    {
+        if (m_Writer.joinable())
+        {
+            ::SetEvent(m_StopEvent);
+            m_Writer.join();
+        }
+
+        Flush();
+    }
+
+    void ConsoleSink::StopBy(ULONGLONG deadline)
+    {
+        UNREFERENCED_PARAMETER(deadline);
+        Stop();
+    }
+
+    bool ConsoleSink::Write(const EncodedEvent& event)
+    {
+        return Write(*event);
+    }
+
+    bool ConsoleSink::Write(const std::wstring& text)
+    {
+        {
+            ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+
+            if (m_Pending.size() + text.size() > m_MaxPendingCharacters)
+            {
+                m_NotShownSinceFlush++;
+                m_EventsNotShown.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+
+            m_Pending.append(text);
+            m_PendingCharacters.store(m_Pending.size(), std::memory_order_relaxed);
+        }
+
+        m_EventsShown.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    void ConsoleSink::Flush()
+    {
+        unsigned long notShown = 0;
+        {
+            ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+            m_Pending.swap(m_Writing);
+            m_PendingCharacters.store(0, std::memory_order_relaxed);
+            notShown = m_NotShownSinceFlush;
+            m_NotShownSinceFlush = 0;
+        }
+
+        // Events are only dropped once the buffer is full, so they all came after its text.
+        if (notShown > 0)
+        {
+            m_Writing.append(L"  ... ");
+            m_Writing.append(std::to_wstring(notShown));
+            m_Writing.append(L" events not shown (console output is falling behind) ... \n\n");
+        }
+
+        if (!m_Writing.empty())
+        {
+            fputws(m_Writing.c_str(), m_Stream);
+            fflush(m_Stream);
+            m_Writing.clear();
+        }
+    }
+
+    double ConsoleSink::GetQueueUsage() const
+    {
+        return static_cast<double>(m_PendingCharacters.load(std::memory_order_relaxed)) / m_MaxPendingCharacters;
+    }
+
+    unsigned long long ConsoleSink::GetEventsWritten() const
+    {
+        return m_EventsShown.load(std::memory_order_relaxed);
+    }
+
+    unsigned long long ConsoleSink::GetEventsDropped() const
+    {
+        return m_EventsNotShown.load(std::memory_order_relaxed);
+    }
+
+    unsigned long long ConsoleSink::GetEventsAbandoned() const
+    {
+        return 0;
+    }
+
+    void ConsoleSink::WriterThread()
+    {
+        // A slow terminal only delays the next write; Write() never waits on it.
+        while (::WaitForSingleObject(m_StopEvent, m_RefreshIntervalInMilliseconds) == WAIT_TIMEOUT)
+        {
+            Flush();
+        }
+    }
+}
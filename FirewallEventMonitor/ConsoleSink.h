@@ -0,0 +1,91 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#pragma once
+
+// os headers
+#include <Windows.h>
+// c++ headers
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+#include "EventSink.h"
+
+namespace FirewallEventMonitor
+{
+    // Writes event text to the console without letting a slow terminal hold up ETW.
+    // Write() only appends to a pending buffer; a writer thread takes the whole buffer
+    // every refresh interval and writes it with one call. When the terminal falls so far
+    // behind that the buffer is full, events are dropped and the next write carries a
+    // "N events not shown" line in their place.
+    class ConsoleSink : public EventSink
+    {
+    public:
+        ConsoleSink(
+            _In_ FILE* stream,
+            size_t maxPendingCharacters = DefaultMaxPendingCharacters,
+            DWORD refreshIntervalInMilliseconds = DefaultRefreshIntervalInMilliseconds);
+
+        // Stops the writer thread, writing what is still pending.
+        ~ConsoleSink() override;
+
+        LPCWSTR GetName() const override;
+
+        // The console shows the text layout.
+        EventFormat GetFormat() const override;
+
+        // Starts the writer thread. Until then, pending text is only written by Flush().
+        void Start() override;
+
+        // Stops the writer thread and writes what is still pending.
+        void Stop() override;
+
+        // The pending text is a single write, so it is written whatever the deadline.
+        void StopBy(ULONGLONG deadline) override;
+
+        bool Write(const EncodedEvent& event) override;
+
+        // Queues the text of one event. Returns false if it was dropped because the buffer is full.
+        bool Write(const std::wstring& text);
+
+        // Writes the pending text and the not-shown marker on the calling thread.
+        // Called by the writer thread; only call it directly while the thread is stopped.
+        void Flush();
+
+        // How full the pending buffer is, from 0 to 1.
+        double GetQueueUsage() const override;
+
+        // Events queued, and events dropped, since the sink was created.
+        unsigned long long GetEventsWritten() const override;
+
+        unsigned long long GetEventsDropped() const override;
+
+        // Always 0; see StopBy().
+        unsigned long long GetEventsAbandoned() const override;
+
+        // Constants
+        static const size_t DefaultMaxPendingCharacters = 1024 * 1024; // 2 MB of text.
+        static const DWORD DefaultRefreshIntervalInMilliseconds = 100; // 10 writes per second.
+
+        ConsoleSink(ConsoleSink const&) = delete;
+        ConsoleSink& operator=(ConsoleSink const&) = delete;
+    private:
+        FILE* m_Stream;
+        const size_t m_MaxPendingCharacters;
+        const DWORD m_RefreshIntervalInMilliseconds;
+        CRITICAL_SECTION m_CriticalSection; // Guards m_Pending and m_NotShownSinceFlush.
+        std::wstring m_Pending;
+        unsigned long m_NotShownSinceFlush = 0;
+        // Only touched by the flushing thread. Swapped with m_Pending so neither buffer reallocates.
+        std::wstring m_Writing;
+        std::atomic<size_t> m_PendingCharacters{ 0 };
+        std::atomic<unsigned long long> m_EventsShown{ 0 };
+        std::atomic<unsigned long long> m_EventsNotShown{ 0 };
+        HANDLE m_StopEvent = NULL;
+        std::thread m_Writer;
+
+        void WriterThread();
+    };
+}
@@ -0,0 +1,406 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include "Dashboard.h"
+
+// c++ headers
+#include <algorithm>
+#include <cstdarg>
+// ntl headers
+#include "ntlLocks.hpp"
+#include "ntlString.hpp"
+
+namespace FirewallEventMonitor
+{
+    const double HUNDRED_NS_PER_MILLISECOND = 10000.0;
+
+    // Darkest to brightest; a space is an interval without events.
+    const wchar_t SPARKLINE_LEVELS[] = L" .:-=+*#%@";
+
+    namespace
+    {
+        const unsigned short ICMPV4_PROTOCOL = 1;
+        const unsigned short TCP_PROTOCOL = 6;
+        const unsigned short UDP_PROTOCOL = 17;
+        const unsigned short ICMPV6_PROTOCOL = 58;
+
+        // Returns the count for key, or null if the key is new and the table is full.
+        template <typename Map, typename Key>
+        auto FindOrInsert(Map& map, const Key& key, size_t maxKeys) -> decltype(map.find(key))
+        {
+            auto found = map.find(key);
+            if (found == nullptr &&
+                map.size() < maxKeys)
+            {
+                found = map.try_emplace(key).first;
+            }
+            return found;
+        }
+
+        double PerSecond(unsigned long long events, double seconds)
+        {
+            return static_cast<double>(events) / seconds;
+        }
+
+        void AppendLine(std::wstring* screen, _Printf_format_string_ LPCWSTR format, ...)
+        {
+            va_list args;
+            va_start(args, format);
+            screen->append(ntl::String::format_string_va(format, args));
+            va_end(args);
+            // Clear what the previous screen left to the right, then end the line.
+            screen->append(L"\x1b[K\n");
+        }
+
+        void AppendTop(
+            std::wstring* screen,
+            const wchar_t* title,
+            const std::vector<DashboardEntry>& entries,
+            double intervalInSeconds)
+        {
+            AppendLine(screen, L"%-46ls %12ls", title, L"events/s");
+            for (const auto& entry : entries)
+            {
+                AppendLine(screen, L"  %-44ls %12.1f",
+                    entry.name.c_str(),
+                    PerSecond(entry.events, intervalInSeconds));
+            }
+            AppendLine(screen, L"");
+        }
+    }
+
+    Dashboard::Dashboard(
+        size_t topCount,
+        size_t maxKeysPerInterval)
+        : m_TopCount(topCount),
+        m_MaxKeysPerInterval(maxKeysPerInterval)
+    {
+        ::InitializeCriticalSectionEx(&m_CriticalSection, 4000, 0);
+    }
+
+    Dashboard::~Dashboard()
+    {
+        ::DeleteCriticalSection(&m_CriticalSection);
+    }
+
+    void Dashboard::RecordEvent(const CompactEventRecord& record, LONGLONG now)
+    {
+        ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+
+        // Sampled events stand for sampleRate events, as in the other reports.
+        unsigned long events = record.sampleRate;
+        m_Interval.events += events;
+
+        if (record.action == RuleAction::Allow)
+        {
+            m_Interval.allowEvents += events;
+        }
+        else if (record.action == RuleAction::Deny)
+        {
+            m_Interval.denyEvents += events;
+        }
+
+        switch (record.protocol)
+        {
+        case TCP_PROTOCOL:
+            m_Interval.tcpEvents += events;
+            break;
+        case UDP_PROTOCOL:
+            m_Interval.udpEvents += events;
+            break;
+        case ICMPV4_PROTOCOL:
+        case ICMPV6_PROTOCOL:
+            m_Interval.icmpEvents += events;
+            break;
+        default:
+            m_Interval.otherEvents += events;
+            break;
+        }
+
+        // Clock adjustments can make an event appear to come from the future.
+        m_Lag.add(now > record.timeStamp ?
+            static_cast<double>(now - record.timeStamp) / HUNDRED_NS_PER_MILLISECOND :
+            0.0);
+
+        bool ranked = true;
+        AddressCount* source = FindOrInsert(m_Sources, record.source, m_MaxKeysPerInterval);
+        if (source)
+        {
+            source->events += events;
+            source->isIpv6 = record.isIpv6;
+        }
+        ranked = ranked && source;
+
+        AddressCount* destination = FindOrInsert(m_Destinations, record.destination, m_MaxKeysPerInterval);
+        if (destination)
+        {
+            destination->events += events;
+            destination->isIpv6 = record.isIpv6;
+        }
+        ranked = ranked && destination;
+
+        unsigned long port = (static_cast<unsigned long>(record.protocol) << 16) | record.destinationPort;
+        unsigned long long* portEvents = FindOrInsert(m_Ports, port, m_MaxKeysPerInterval);
+        if (portEvents)
+        {
+            *portEvents += events;
+        }
+        ranked = ranked && portEvents;
+
+        unsigned long long* ruleEvents = FindOrInsert(m_Rules, record.ruleId, m_MaxKeysPerInterval);
+        if (ruleEvents)
+        {
+            *ruleEvents += events;
+        }
+        ranked = ranked && ruleEvents;
+
+        if (!ranked)
+        {
+            m_Interval.eventsNotRanked += events;
+        }
+    }
+
+    void Dashboard::RecordAlert(const std::wstring& text)
+    {
+        ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+
+        size_t start = 0;
+        while (start < text.size())
+        {
+            size_t end = text.find(L'\n', start);
+            if (end == std::wstring::npos)
+            {
+                end = text.size();
+            }
+            if (end > start)
+            {
+                m_RecentAlerts.push_back(text.substr(start, end - start));
+            }
+            start = end + 1;
+        }
+        while (m_RecentAlerts.size() > RecentAlertLines)
+        {
+            m_RecentAlerts.pop_front();
+        }
+    }
+
+    DashboardSnapshot Dashboard::TakeSnapshot(double intervalInSeconds)
+    {
+        DashboardSnapshot snapshot;
+        AddressTable sources;
+        AddressTable destinations;
+        PortTable ports;
+        RuleTable rules;
+        {
+            ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+
+            snapshot = m_Interval;
+            if (m_Lag.count() > 0.0)
+            {
+                snapshot.lagMedianInMilliseconds = m_Lag.quantile(0.5);
+                snapshot.lagP99InMilliseconds = m_Lag.quantile(0.99);
+                snapshot.lagMaxInMilliseconds = m_Lag.maximum();
+            }
+
+            // Take the tables and rank them after the lock is released, so events are
+            // only held up for the swap. The new tables start at the last interval's size.
+            std::swap(sources, m_Sources);
+            std::swap(destinations, m_Destinations);
+            std::swap(ports, m_Ports);
+            std::swap(rules, m_Rules);
+            m_Sources.reserve(sources.size());
+            m_Destinations.reserve(destinations.size());
+            m_Ports.reserve(ports.size());
+            m_Rules.reserve(rules.size());
+
+            m_Interval = DashboardSnapshot();
+            m_Lag.reset();
+
+            snapshot.recentAlerts.assign(m_RecentAlerts.begin(), m_RecentAlerts.end());
+        }
+
+        snapshot.intervalInSeconds = intervalInSeconds > 0.0 ? intervalInSeconds : 1.0;
+        snapshot.topSources = TopAddresses(sources);
+        snapshot.topDestinations = TopAddresses(destinations);
+        snapshot.topPorts = TopPorts(ports);
+        snapshot.topRules = TopRules(rules);
+
+        m_RateHistory.push_back(PerSecond(snapshot.events, snapshot.intervalInSeconds));
+        if (m_RateHistory.size() > RateHistoryLength)
+        {
+            m_RateHistory.pop_front();
+        }
+        snapshot.rateHistory.assign(m_RateHistory.begin(), m_RateHistory.end());
+
+        return snapshot;
+    }
+
+    std::vector<DashboardEntry> Dashboard::TopAddresses(const AddressTable& addresses) const
+    {
+        // Rank on the raw keys and only format the addresses that are shown.
+        std::vector<std::pair<const IN6_ADDR*, const AddressCount*>> ranked;
+        ranked.reserve(addresses.size());
+        addresses.for_each([&](const IN6_ADDR& address, const AddressCount& count)
+        {
+            ranked.emplace_back(&address, &count);
+        });
+
+        size_t kept = (std::min)(m_TopCount, ranked.size());
+        std::partial_sort(ranked.begin(), ranked.begin() + kept, ranked.end(),
+            [](const std::pair<const IN6_ADDR*, const AddressCount*>& left, const std::pair<const IN6_ADDR*, const AddressCount*>& right)
+            {
+                return left.second->events > right.second->events;
+            });
+
+        std::vector<DashboardEntry> top(kept);
+        for (size_t i = 0; i < kept; ++i)
+        {
+            top[i].name = FormatAddress(*ranked[i].first, ranked[i].second->isIpv6);
+            top[i].events = ranked[i].second->events;
+        }
+        return top;
+    }
+
+    std::vector<DashboardEntry> Dashboard::TopPorts(const PortTable& ports) const
+    {
+        std::vector<std::pair<unsigned long long, unsigned long>> ranked;
+        ranked.reserve(ports.size());
+        ports.for_each([&](unsigned long port, unsigned long long events)
+        {
+            ranked.emplace_back(events, port);
+        });
+
+        size_t kept = (std::min)(m_TopCount, ranked.size());
+        std::partial_sort(ranked.begin(), ranked.begin() + kept, ranked.end(),
+            [](const std::pair<unsigned long long, unsigned long>& left, const std::pair<unsigned long long, unsigned long>& right)
+            {
+                return left.first > right.first;
+            });
+
+        std::vector<DashboardEntry> top(kept);
+        for (size_t i = 0; i < kept; ++i)
+        {
+            unsigned short protocol = static_cast<unsigned short>(ranked[i].second >> 16);
+            LPCWSTR protocolName = ProtocolName(protocol);
+            top[i].name = std::to_wstring(ranked[i].second & 0xffff) + L"/" +
+                (protocolName != NULL ? std::wstring(protocolName) : std::to_wstring(protocol));
+            top[i].events = ranked[i].first;
+        }
+        return top;
+    }
+
+    std::vector<DashboardEntry> Dashboard::TopRules(const RuleTable& rules) const
+    {
+        std::vector<std::pair<unsigned long long, GUID>> ranked;
+        ranked.reserve(rules.size());
+        rules.for_each([&](const GUID& ruleId, unsigned long long events)
+        {
+            ranked.emplace_back(events, ruleId);
+        });
+
+        size_t kept = (std::min)(m_TopCount, ranked.size());
+        std::partial_sort(ranked.begin(), ranked.begin() + kept, ranked.end(),
+            [](const std::pair<unsigned long long, GUID>& left, const std::pair<unsigned long long, GUID>& right)
+            {
+                return left.first > right.first;
+            });
+
+        std::vector<DashboardEntry> top(kept);
+        for (size_t i = 0; i < kept; ++i)
+        {
+            top[i].name = FormatGuid(ranked[i].second);
+            top[i].events = ranked[i].first;
+        }
+        return top;
+    }
+
+    std::wstring Dashboard::Render(const DashboardSnapshot& snapshot)
+    {
+        double seconds = snapshot.intervalInSeconds > 0.0 ? snapshot.intervalInSeconds : 1.0;
+
+        // Home the cursor and overwrite in place rather than clearing, so the screen does not flicker.
+        std::wstring screen = L"\x1b[H";
+        AppendLine(&screen, L"FirewallEventMonitor - refreshed every %.0f s - Ctrl-C to stop", seconds);
+        AppendLine(&screen, L"");
+        AppendLine(&screen, L"Events/s  %12.1f   allow %10.1f   deny %10.1f",
+            PerSecond(snapshot.events, seconds),
+            PerSecond(snapshot.allowEvents, seconds),
+            PerSecond(snapshot.denyEvents, seconds));
+        AppendLine(&screen, L"Protocol  tcp %10.1f   udp %10.1f   icmp %10.1f   other %10.1f",
+            PerSecond(snapshot.tcpEvents, seconds),
+            PerSecond(snapshot.udpEvents, seconds),
+            PerSecond(snapshot.icmpEvents, seconds),
+            PerSecond(snapshot.otherEvents, seconds));
+        AppendLine(&screen, L"Lag       median %.1f ms   p99 %.1f ms   max %.1f ms",
+            snapshot.lagMedianInMilliseconds,
+            snapshot.lagP99InMilliseconds,
+            snapshot.lagMaxInMilliseconds);
+        AppendLine(&screen, L"Dropped   sampled out %llu (rate 1/%lu)   shed %llu   ETW lost %llu   (since start)",
+            snapshot.eventsSampledOut,
+            snapshot.sampleRate,
+            snapshot.eventsShed,
+            snapshot.etwEventsLost);
+        if (snapshot.epocsThrottled > 0)
+        {
+            AppendLine(&screen, L"Throttled limit of %lu events/s reached in %llu s   (since start)",
+                snapshot.eventLimitPerEpoc,
+                snapshot.epocsThrottled);
+        }
+
+        double peak = 0.0;
+        for (double rate : snapshot.rateHistory)
+        {
+            peak = (std::max)(peak, rate);
+        }
+        AppendLine(&screen, L"");
+        AppendLine(&screen, L"Events/s over the last %zu refreshes (peak %.1f)", snapshot.rateHistory.size(), peak);
+        AppendLine(&screen, L"  [%ls]", Sparkline(snapshot.rateHistory).c_str());
+        AppendLine(&screen, L"");
+
+        if (snapshot.eventsNotRanked > 0)
+        {
+            AppendLine(&screen, L"%.1f events/s not ranked: too many distinct keys this refresh",
+                PerSecond(snapshot.eventsNotRanked, seconds));
+            AppendLine(&screen, L"");
+        }
+        AppendTop(&screen, L"Top sources", snapshot.topSources, seconds);
+        AppendTop(&screen, L"Top destinations", snapshot.topDestinations, seconds);
+        AppendTop(&screen, L"Top destination ports", snapshot.topPorts, seconds);
+        AppendTop(&screen, L"Top rules", snapshot.topRules, seconds);
+
+        AppendLine(&screen, L"Recent alerts");
+        for (const auto& line : snapshot.recentAlerts)
+        {
+            AppendLine(&screen, L"  %ls", line.c_str());
+        }
+
+        // Clear whatever a longer previous screen left below.
+        screen.append(L"\x1b[J");
+        return screen;
+    }
+
+    std::wstring Dashboard::Sparkline(const std::vector<double>& values)
+    {
+        const size_t levels = _countof(SPARKLINE_LEVELS) - 1;
+        double peak = 0.0;
+        for (double value : values)
+        {
+            peak = (std::max)(peak, value);
+        }
+
+        std::wstring line;
+        line.reserve(values.size());
+        for (double value : values)
+        {
+            size_t level = 0;
+            if (peak > 0.0 &&
+                value > 0.0)
+            {
+                // Any events at all show as at least the first visible level.
+                level = 1 + static_cast<size_t>((value / peak) * (levels - 2) + 0.5);
+            }
+            line.push_back(SPARKLINE_LEVELS[(std::min)(level, levels - 1)]);
+        }
+        return line;
+    }
+}
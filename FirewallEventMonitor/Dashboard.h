@@ -0,0 +1,135 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#pragma once
+
+// OS Headers
+#include <Windows.h>
+// c++ headers
+#include <deque>
+#include <string>
+#include <vector>
+// ntl headers
+#include "ntlFlatHashMap.hpp"
+#include "ntlMath.hpp"
+
+#include "CompactEventRecord.h"
+
+namespace FirewallEventMonitor
+{
+    // One row of a dashboard top list.
+    struct DashboardEntry
+    {
+    public:
+        std::wstring name;
+        unsigned long long events = 0;
+    };
+
+    // Everything the dashboard shows for one refresh interval.
+    // Event counts are scaled up by each event's sample rate, like the other reports.
+    struct DashboardSnapshot
+    {
+    public:
+        double intervalInSeconds = 0.0;
+        unsigned long long events = 0;
+        unsigned long long allowEvents = 0;
+        unsigned long long denyEvents = 0;
+        unsigned long long tcpEvents = 0;
+        unsigned long long udpEvents = 0;
+        unsigned long long icmpEvents = 0;
+        unsigned long long otherEvents = 0;
+        // Delivery lag of the interval's events.
+        double lagMedianInMilliseconds = 0.0;
+        double lagP99InMilliseconds = 0.0;
+        double lagMaxInMilliseconds = 0.0;
+        // Busiest keys of the interval, most events first.
+        std::vector<DashboardEntry> topSources;
+        std::vector<DashboardEntry> topDestinations;
+        std::vector<DashboardEntry> topPorts;
+        std::vector<DashboardEntry> topRules;
+        // Events whose key arrived after a table was full; left out of the top lists.
+        unsigned long long eventsNotRanked = 0;
+        // Events per second of recent intervals, oldest first.
+        std::vector<double> rateHistory;
+        // Filled in by the session from the stages that drop events.
+        unsigned long sampleRate = 1;
+        unsigned long long eventsSampledOut = 0;
+        unsigned long long eventsShed = 0;
+        unsigned long long etwEventsLost = 0;
+        // Epocs (seconds) in which the -EventThrottle limit was reached and the rest of the epoc's events dropped.
+        unsigned long eventLimitPerEpoc = 0;
+        unsigned long long epocsThrottled = 0;
+        // Lines of the latest alerts and status reports, oldest first; kept across refreshes.
+        std::vector<std::wstring> recentAlerts;
+    };
+
+    // Full-screen, top-style view of the capture (-Output Dashboard).
+    // Events only update fixed-size counters and bounded per-interval tables; each
+    // refresh ranks at most MaxKeysPerInterval keys per table, so the cost of a refresh
+    // does not grow with the event rate.
+    class Dashboard
+    {
+    public:
+        Dashboard(
+            size_t topCount = DefaultTopCount,
+            size_t maxKeysPerInterval = DefaultMaxKeysPerInterval);
+
+        ~Dashboard();
+
+        // now is the FILETIME at which the event was processed, for its delivery lag.
+        void RecordEvent(const CompactEventRecord& record, LONGLONG now);
+
+        // Adds the lines of an alert to the recent alerts pane, so the session does not print it
+        // over the screen. Only the latest RecentAlertLines lines are kept.
+        void RecordAlert(const std::wstring& text);
+
+        // Summarizes the events since the previous call and starts a new interval.
+        DashboardSnapshot TakeSnapshot(double intervalInSeconds);
+
+        // The screen for a snapshot, starting with the sequence that clears the console.
+        static std::wstring Render(const DashboardSnapshot& snapshot);
+
+        // One character per value, scaled to the largest.
+        // ASCII, so it survives consoles without a Unicode font or code page.
+        static std::wstring Sparkline(const std::vector<double>& values);
+
+        // Constants
+        static const size_t DefaultTopCount = 8;
+        static const size_t DefaultMaxKeysPerInterval = 4096;
+        static const size_t RateHistoryLength = 60;
+        static const size_t RecentAlertLines = 8;
+        static const DWORD RefreshIntervalInMilliseconds = 1000; // 1 second.
+
+        Dashboard(Dashboard const&) = delete;
+        Dashboard& operator=(Dashboard const&) = delete;
+    private:
+        struct AddressCount
+        {
+            unsigned long long events = 0;
+            bool isIpv6 = false;
+        };
+
+        typedef ntl::FlatHashMap<IN6_ADDR, AddressCount, AddressHash, AddressEqual> AddressTable;
+        typedef ntl::FlatHashMap<unsigned long, unsigned long long> PortTable; // protocol << 16 | port.
+        typedef ntl::FlatHashMap<GUID, unsigned long long, GuidHash> RuleTable;
+
+        CRITICAL_SECTION m_CriticalSection; // Guards the interval counters and tables, and the recent alerts.
+        const size_t m_TopCount;
+        const size_t m_MaxKeysPerInterval;
+        DashboardSnapshot m_Interval; // Counters only; the top lists are built by TakeSnapshot().
+        AddressTable m_Sources;
+        AddressTable m_Destinations;
+        PortTable m_Ports;
+        RuleTable m_Rules;
+        ntl::TDigest m_Lag;
+        std::deque<std::wstring> m_RecentAlerts;
+        // Only touched by TakeSnapshot().
+        std::deque<double> m_RateHistory;
+
+        std::vector<DashboardEntry> TopAddresses(const AddressTable& addresses) const;
+
+        std::vector<DashboardEntry> TopPorts(const PortTable& ports) const;
+
+        std::vector<DashboardEntry> TopRules(const RuleTable& rules) const;
+    };
+}
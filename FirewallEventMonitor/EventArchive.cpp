@@ -0,0 +1,908 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include "EventArchive.h"
+
+// c++ headers
+#include <algorithm>
+#include <cstdint>
+// ntl headers
+#include "ntlLocks.hpp"
+
+namespace FirewallEventMonitor
+{
+    namespace
+    {
+        const char ARCHIVE_MAGIC[8] = { 'F', 'E', 'M', 'A', 'R', 'C', 'H', '1' };
+        const unsigned long ARCHIVE_VERSION = 1;
+        const size_t ARCHIVE_ALIGNMENT = 8;
+        const size_t BLOCK_HEADER_BYTES = 16;
+        const size_t DICTIONARY_HEADER_BYTES = 16;
+
+        struct ArchiveColumnEntry
+        {
+            const char* name;
+            ArchiveColumnType type;
+        };
+
+        // Indexed by ArchiveColumn.
+        const ArchiveColumnEntry ARCHIVE_COLUMNS[] = {
+            { "timeStamp", ArchiveColumnType::TimeStamp },
+            { "direction", ArchiveColumnType::UInt8 },
+            { "action", ArchiveColumnType::UInt8 },
+            { "status", ArchiveColumnType::StringDictionary },
+            { "portId", ArchiveColumnType::StringDictionary },
+            { "portName", ArchiveColumnType::StringDictionary },
+            { "portFriendlyName", ArchiveColumnType::StringDictionary },
+            { "src", ArchiveColumnType::Address },
+            { "dst", ArchiveColumnType::Address },
+            { "protocol", ArchiveColumnType::UInt16 },
+            { "srcPort", ArchiveColumnType::UInt16 },
+            { "dstPort", ArchiveColumnType::UInt16 },
+            { "icmpType", ArchiveColumnType::UInt8 },
+            { "flags", ArchiveColumnType::UInt8 },
+            { "sampleRate", ArchiveColumnType::UInt32 },
+            { "ruleId", ArchiveColumnType::GuidDictionary },
+            { "layerId", ArchiveColumnType::StringDictionary },
+            { "groupId", ArchiveColumnType::StringDictionary },
+            { "gftFlags", ArchiveColumnType::StringDictionary },
+        };
+        static_assert(_countof(ARCHIVE_COLUMNS) == static_cast<size_t>(ArchiveColumn::Count), "one entry per ArchiveColumn");
+
+        template <typename T>
+        void AppendValue(T value, _Inout_ std::string* buffer)
+        {
+            buffer->append(reinterpret_cast<const char*>(&value), sizeof(value));
+        }
+
+        void AppendPadding(_Inout_ std::string* buffer)
+        {
+            buffer->append((ARCHIVE_ALIGNMENT - buffer->size() % ARCHIVE_ALIGNMENT) % ARCHIVE_ALIGNMENT, '\0');
+        }
+
+        void AppendVarint(unsigned long long value, _Inout_ std::string* buffer)
+        {
+            while (value >= 0x80)
+            {
+                buffer->push_back(static_cast<char>((value & 0x7F) | 0x80));
+                value >>= 7;
+            }
+            buffer->push_back(static_cast<char>(value));
+        }
+
+        // Maps small differences of either sign to small unsigned values: 0, -1, 1, -2, ...
+        unsigned long long ZigZag(LONGLONG value)
+        {
+            return (static_cast<unsigned long long>(value) << 1) ^ static_cast<unsigned long long>(value >> 63);
+        }
+
+        LONGLONG UnZigZag(unsigned long long value)
+        {
+            return static_cast<LONGLONG>(value >> 1) ^ -static_cast<LONGLONG>(value & 1);
+        }
+
+        template <typename T>
+        T ReadValue(const std::string& data, size_t offset)
+        {
+            if (offset + sizeof(T) > data.size())
+            {
+                throw std::exception("Archive block is truncated.");
+            }
+            T value;
+            memcpy(&value, data.data() + offset, sizeof(T));
+            return value;
+        }
+    }
+
+    ArchiveColumnInfo GetArchiveColumnInfo(ArchiveColumn column)
+    {
+        const ArchiveColumnEntry& entry = ARCHIVE_COLUMNS[static_cast<size_t>(column)];
+        return ArchiveColumnInfo{ entry.name, entry.type };
+    }
+
+    //
+    // EventArchiveWriter
+    //
+
+    EventArchiveWriter::EventArchiveWriter(
+        const std::wstring& path,
+        size_t rowsPerBatch,
+        size_t maxQueuedBatches)
+        : m_Path(path),
+        m_RowsPerBatch((std::max)(rowsPerBatch, static_cast<size_t>(1))),
+        m_MaxQueuedBatches((std::max)(maxQueuedBatches, static_cast<size_t>(1))),
+        m_StringDictionaries(static_cast<size_t>(ArchiveColumn::Count))
+    {
+        errno_t result = _wfopen_s(&m_File, m_Path.c_str(), L"wb");
+        if (result != 0 ||
+            m_File == NULL)
+        {
+            m_File = NULL;
+            throw std::exception("Unable to create archive file.");
+        }
+        setvbuf(m_File, NULL, _IOFBF, WriteBufferSizeInBytes);
+
+        WriteHeader();
+
+        ::InitializeCriticalSectionEx(&m_CriticalSection, 4000, 0);
+        ::InitializeConditionVariable(&m_BatchQueued);
+        ::InitializeConditionVariable(&m_BatchWritten);
+        m_Writer = std::thread(&EventArchiveWriter::WriterThread, this);
+    }
+
+    EventArchiveWriter::~EventArchiveWriter()
+    {
+        Close();
+        ::DeleteCriticalSection(&m_CriticalSection);
+    }
+
+    void EventArchiveWriter::Append(const VfpEventData& eventData)
+    {
+        if (m_File == NULL)
+        {
+            return;
+        }
+
+        const CompactEventRecord& record = eventData.compact;
+        AppendVarint(ZigZag(record.timeStamp - m_PreviousTimeStamp), &m_Columns[static_cast<size_t>(ArchiveColumn::TimeStamp)]);
+        m_PreviousTimeStamp = record.timeStamp;
+
+        AppendValue(static_cast<unsigned char>(record.direction), &m_Columns[static_cast<size_t>(ArchiveColumn::Direction)]);
+        AppendValue(static_cast<unsigned char>(record.action), &m_Columns[static_cast<size_t>(ArchiveColumn::Action)]);
+        AppendString(ArchiveColumn::Status, eventData.status);
+        AppendString(ArchiveColumn::PortId, eventData.portId);
+        AppendString(ArchiveColumn::PortName, eventData.portName);
+        AppendString(ArchiveColumn::PortFriendlyName, eventData.portFriendlyName);
+        AppendValue(record.source, &m_Columns[static_cast<size_t>(ArchiveColumn::Source)]);
+        AppendValue(record.destination, &m_Columns[static_cast<size_t>(ArchiveColumn::Destination)]);
+        AppendValue(record.protocol, &m_Columns[static_cast<size_t>(ArchiveColumn::Protocol)]);
+        AppendValue(record.sourcePort, &m_Columns[static_cast<size_t>(ArchiveColumn::SourcePort)]);
+        AppendValue(record.destinationPort, &m_Columns[static_cast<size_t>(ArchiveColumn::DestinationPort)]);
+        AppendValue(record.icmpType, &m_Columns[static_cast<size_t>(ArchiveColumn::IcmpType)]);
+        unsigned char flags =
+            (record.isIpv6 ? ArchiveFlagIpv6 : 0) |
+            (record.isTcpSyn ? ArchiveFlagTcpSyn : 0);
+        AppendValue(flags, &m_Columns[static_cast<size_t>(ArchiveColumn::Flags)]);
+        AppendValue(static_cast<uint32_t>(record.sampleRate), &m_Columns[static_cast<size_t>(ArchiveColumn::SampleRate)]);
+        AppendGuid(record.ruleId);
+        AppendString(ArchiveColumn::LayerId, eventData.layerId);
+        AppendString(ArchiveColumn::GroupId, eventData.groupId);
+        AppendString(ArchiveColumn::GftFlags, eventData.gftFlags);
+
+        ++m_Rows;
+        if (m_Rows == m_RowsPerBatch)
+        {
+            QueueBatch();
+        }
+    }
+
+    void EventArchiveWriter::Flush()
+    {
+        ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+        while (!m_Queue.empty() ||
+            m_Writing)
+        {
+            ::SleepConditionVariableCS(&m_BatchWritten, &m_CriticalSection, INFINITE);
+        }
+    }
+
+    void EventArchiveWriter::Close()
+    {
+        if (m_File == NULL)
+        {
+            return;
+        }
+
+        // The writer's thread writes what is queued before it exits.
+        if (m_Writer.joinable())
+        {
+            {
+                ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+                m_Stopping = true;
+            }
+            ::WakeAllConditionVariable(&m_BatchQueued);
+            m_Writer.join();
+        }
+
+        if (m_Rows > 0)
+        {
+            WriteBatch(*SealBatch());
+        }
+        WriteFooter();
+
+        fclose(m_File);
+        m_File = NULL;
+    }
+
+    unsigned long long EventArchiveWriter::GetRowsWritten() const
+    {
+        return m_RowsWritten.load(std::memory_order_relaxed);
+    }
+
+    unsigned long long EventArchiveWriter::GetRowsDropped() const
+    {
+        return m_RowsDropped.load(std::memory_order_relaxed);
+    }
+
+    unsigned long long EventArchiveWriter::GetBatchesWritten() const
+    {
+        return m_BatchesWritten.load(std::memory_order_relaxed);
+    }
+
+    unsigned long long EventArchiveWriter::GetBytesWritten() const
+    {
+        return m_Offset.load(std::memory_order_relaxed);
+    }
+
+    size_t EventArchiveWriter::GetDictionaryEntries() const
+    {
+        size_t entries = m_RuleIds.ids.size();
+        for (const auto& dictionary : m_StringDictionaries)
+        {
+            entries += dictionary.ids.size();
+        }
+        return entries;
+    }
+
+    void EventArchiveWriter::AppendString(
+        ArchiveColumn column,
+        const std::wstring& value)
+    {
+        StringDictionary& dictionary = m_StringDictionaries[static_cast<size_t>(column)];
+        auto found = dictionary.ids.find(value);
+        unsigned long id = 0;
+        if (found != dictionary.ids.end())
+        {
+            id = found->second;
+        }
+        else
+        {
+            id = static_cast<unsigned long>(dictionary.ids.size());
+            dictionary.ids.emplace(value, id);
+            std::string utf8;
+            AppendUtf8(value, &utf8);
+            dictionary.pending.push_back(std::move(utf8));
+        }
+        AppendValue(static_cast<uint32_t>(id), &m_Columns[static_cast<size_t>(column)]);
+    }
+
+    void EventArchiveWriter::AppendGuid(const GUID& value)
+    {
+        auto found = m_RuleIds.ids.find(value);
+        unsigned long id = 0;
+        if (found != m_RuleIds.ids.end())
+        {
+            id = found->second;
+        }
+        else
+        {
+            id = static_cast<unsigned long>(m_RuleIds.ids.size());
+            m_RuleIds.ids.emplace(value, id);
+            m_RuleIds.pending.push_back(value);
+        }
+        AppendValue(static_cast<uint32_t>(id), &m_Columns[static_cast<size_t>(ArchiveColumn::RuleId)]);
+    }
+
+    std::unique_ptr<EventArchiveWriter::SealedBatch> EventArchiveWriter::SealBatch()
+    {
+        auto batch = std::make_unique<SealedBatch>();
+        for (size_t column = 0; column < static_cast<size_t>(ArchiveColumn::Count); ++column)
+        {
+            batch->columns[column].swap(m_Columns[column]);
+            // The next batch is about as large as this one.
+            m_Columns[column].reserve(batch->columns[column].size());
+        }
+        batch->rows = m_Rows;
+
+        // Ids are assigned here, as values are first seen, so each batch carries its own first id.
+        batch->firstRuleId = static_cast<unsigned long>(m_RuleIds.ids.size() - m_RuleIds.pending.size());
+        batch->ruleIds.swap(m_RuleIds.pending);
+        batch->firstStringIds.resize(m_StringDictionaries.size());
+        batch->strings.resize(m_StringDictionaries.size());
+        for (size_t column = 0; column < m_StringDictionaries.size(); ++column)
+        {
+            StringDictionary& dictionary = m_StringDictionaries[column];
+            batch->firstStringIds[column] = static_cast<unsigned long>(dictionary.ids.size() - dictionary.pending.size());
+            batch->strings[column].swap(dictionary.pending);
+        }
+
+        m_Rows = 0;
+        // Each batch decodes on its own.
+        m_PreviousTimeStamp = 0;
+        return batch;
+    }
+
+    void EventArchiveWriter::QueueBatch()
+    {
+        bool queueFull = false;
+        {
+            ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+            queueFull = m_Queue.size() >= m_MaxQueuedBatches;
+        }
+
+        if (queueFull)
+        {
+            // Only the rows are lost: the new dictionary entries stay pending, so the ids
+            // already assigned to them are still written before the next batch that uses them.
+            m_RowsDropped.fetch_add(m_Rows, std::memory_order_relaxed);
+            for (std::string& column : m_Columns)
+            {
+                column.clear();
+            }
+            m_Rows = 0;
+            m_PreviousTimeStamp = 0;
+            return;
+        }
+
+        std::unique_ptr<SealedBatch> batch = SealBatch();
+        {
+            ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+            m_Queue.push_back(std::move(batch));
+        }
+        ::WakeConditionVariable(&m_BatchQueued);
+    }
+
+    void EventArchiveWriter::WriterThread()
+    {
+        for (;;)
+        {
+            std::unique_ptr<SealedBatch> batch;
+            {
+                ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+                while (m_Queue.empty() &&
+                    !m_Stopping)
+                {
+                    ::SleepConditionVariableCS(&m_BatchQueued, &m_CriticalSection, INFINITE);
+                }
+
+                if (m_Queue.empty())
+                {
+                    // Stopping, and everything queued has been written.
+                    return;
+                }
+                batch = std::move(m_Queue.front());
+                m_Queue.erase(m_Queue.begin());
+                m_Writing = true;
+            }
+
+            WriteBatch(*batch);
+
+            {
+                ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+                m_Writing = false;
+            }
+            ::WakeAllConditionVariable(&m_BatchWritten);
+        }
+    }
+
+    void EventArchiveWriter::WriteHeader()
+    {
+        m_Block.assign(ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC));
+        AppendValue(static_cast<uint32_t>(ARCHIVE_VERSION), &m_Block);
+        AppendValue(static_cast<uint32_t>(ArchiveColumn::Count), &m_Block);
+        for (const auto& column : ARCHIVE_COLUMNS)
+        {
+            AppendValue(static_cast<uint8_t>(column.type), &m_Block);
+            AppendValue(static_cast<uint8_t>(0), &m_Block);
+            AppendValue(static_cast<uint16_t>(strlen(column.name)), &m_Block);
+            m_Block.append(column.name);
+        }
+        AppendPadding(&m_Block);
+        Write(m_Block.data(), m_Block.size());
+    }
+
+    void EventArchiveWriter::WriteDictionaries(const SealedBatch& batch)
+    {
+        if (!batch.ruleIds.empty())
+        {
+            m_Block.clear();
+            AppendValue(static_cast<uint32_t>(ArchiveColumn::RuleId), &m_Block);
+            AppendValue(static_cast<uint32_t>(batch.firstRuleId), &m_Block);
+            AppendValue(static_cast<uint32_t>(batch.ruleIds.size()), &m_Block);
+            AppendValue(static_cast<uint32_t>(0), &m_Block);
+            for (const GUID& guid : batch.ruleIds)
+            {
+                AppendValue(guid, &m_Block);
+            }
+            WriteBlock(ArchiveBlockKind::Dictionary);
+        }
+
+        for (size_t column = 0; column < batch.strings.size(); ++column)
+        {
+            const std::vector<std::string>& values = batch.strings[column];
+            if (values.empty())
+            {
+                continue;
+            }
+
+            m_Block.clear();
+            AppendValue(static_cast<uint32_t>(column), &m_Block);
+            AppendValue(static_cast<uint32_t>(batch.firstStringIds[column]), &m_Block);
+            AppendValue(static_cast<uint32_t>(values.size()), &m_Block);
+            AppendValue(static_cast<uint32_t>(0), &m_Block);
+            uint32_t offset = 0;
+            for (const std::string& value : values)
+            {
+                AppendValue(offset, &m_Block);
+                offset += static_cast<uint32_t>(value.size());
+            }
+            AppendValue(offset, &m_Block);
+            for (const std::string& value : values)
+            {
+                m_Block.append(value);
+            }
+            WriteBlock(ArchiveBlockKind::Dictionary);
+        }
+    }
+
+    void EventArchiveWriter::WriteBatch(const SealedBatch& batch)
+    {
+        // The batch's new dictionary entries go first, so a reader has them before their ids.
+        WriteDictionaries(batch);
+
+        const size_t columnCount = static_cast<size_t>(ArchiveColumn::Count);
+        m_Block.clear();
+        AppendValue(static_cast<uint32_t>(batch.rows), &m_Block);
+        AppendValue(static_cast<uint32_t>(columnCount), &m_Block);
+        // Buffers start after the offset table, which is a multiple of 8 bytes.
+        unsigned long long bufferOffset = m_Block.size() + columnCount * 2 * sizeof(uint64_t);
+        for (const std::string& column : batch.columns)
+        {
+            AppendValue(static_cast<uint64_t>(bufferOffset), &m_Block);
+            AppendValue(static_cast<uint64_t>(column.size()), &m_Block);
+            bufferOffset += (column.size() + ARCHIVE_ALIGNMENT - 1) / ARCHIVE_ALIGNMENT * ARCHIVE_ALIGNMENT;
+        }
+        for (const std::string& column : batch.columns)
+        {
+            m_Block.append(column);
+            AppendPadding(&m_Block);
+        }
+
+        m_BatchOffsets.push_back(m_Offset.load(std::memory_order_relaxed));
+        WriteBlock(ArchiveBlockKind::RecordBatch);
+
+        m_RowsWritten.fetch_add(batch.rows, std::memory_order_relaxed);
+        m_BatchesWritten.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void EventArchiveWriter::WriteFooter()
+    {
+        m_Block.clear();
+        AppendValue(static_cast<uint64_t>(m_BatchOffsets.size()), &m_Block);
+        for (unsigned long long offset : m_BatchOffsets)
+        {
+            AppendValue(static_cast<uint64_t>(offset), &m_Block);
+        }
+        unsigned long long footerOffset = m_Offset.load(std::memory_order_relaxed);
+        WriteBlock(ArchiveBlockKind::Footer);
+
+        m_Block.clear();
+        AppendValue(static_cast<uint64_t>(footerOffset), &m_Block);
+        m_Block.append(ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC));
+        Write(m_Block.data(), m_Block.size());
+    }
+
+    void EventArchiveWriter::WriteBlock(ArchiveBlockKind kind)
+    {
+        char header[BLOCK_HEADER_BYTES] = {};
+        uint32_t blockKind = static_cast<uint32_t>(kind);
+        uint64_t payloadLength = m_Block.size();
+        memcpy(header, &blockKind, sizeof(blockKind));
+        memcpy(header + 8, &payloadLength, sizeof(payloadLength));
+        Write(header, sizeof(header));
+
+        AppendPadding(&m_Block);
+        Write(m_Block.data(), m_Block.size());
+    }
+
+    void EventArchiveWriter::Write(
+        const void* data,
+        size_t length)
+    {
+        if (fwrite(data, 1, length, m_File) != length &&
+            !m_WriteFailed)
+        {
+            m_WriteFailed = true;
+            wprintf(L"Warning: Unable to write to archive %ls; it will be incomplete.\n", m_Path.c_str());
+        }
+        m_Offset.fetch_add(length, std::memory_order_relaxed);
+    }
+
+    //
+    // EventArchiveReader
+    //
+
+    EventArchiveReader::EventArchiveReader(const std::wstring& path)
+    {
+        errno_t result = _wfopen_s(&m_File, path.c_str(), L"rb");
+        if (result != 0 ||
+            m_File == NULL)
+        {
+            m_File = NULL;
+            throw std::exception("Unable to open archive file.");
+        }
+
+        try
+        {
+            _fseeki64(m_File, 0, SEEK_END);
+            m_FileSize = static_cast<unsigned long long>(_ftelli64(m_File));
+
+            unsigned long long offset = 0;
+            ReadHeader(&offset);
+            ReadBlocks(offset);
+        }
+        catch (...)
+        {
+            fclose(m_File);
+            m_File = NULL;
+            throw;
+        }
+    }
+
+    EventArchiveReader::~EventArchiveReader()
+    {
+        if (m_File != NULL)
+        {
+            fclose(m_File);
+        }
+    }
+
+    bool EventArchiveReader::IsArchive(const std::wstring& path)
+    {
+        FILE* file = NULL;
+        if (_wfopen_s(&file, path.c_str(), L"rb") != 0 ||
+            file == NULL)
+        {
+            return false;
+        }
+
+        char magic[sizeof(ARCHIVE_MAGIC)];
+        bool isArchive =
+            fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+            memcmp(magic, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC)) == 0;
+        fclose(file);
+        return isArchive;
+    }
+
+    const std::vector<ArchiveColumnInfo>& EventArchiveReader::GetColumns() const
+    {
+        return m_Columns;
+    }
+
+    size_t EventArchiveReader::GetBatchCount() const
+    {
+        return m_Batches.size();
+    }
+
+    size_t EventArchiveReader::GetRowCount(size_t batch) const
+    {
+        return m_Batches.at(batch).rowCount;
+    }
+
+    size_t EventArchiveReader::ReadColumn(
+        size_t batch,
+        ArchiveColumn column,
+        std::string* data)
+    {
+        const Batch& entry = m_Batches.at(batch);
+        const auto& buffer = entry.buffers[FileColumn(column)];
+        ReadAt(entry.payloadOffset + buffer.first, static_cast<size_t>(buffer.second), data);
+        return entry.rowCount;
+    }
+
+    void EventArchiveReader::ReadEvents(
+        size_t batch,
+        std::vector<CompactEventRecord>* events)
+    {
+        size_t rowCount = GetRowCount(batch);
+        events->assign(rowCount, CompactEventRecord{});
+
+        std::string data;
+        std::vector<LONGLONG> timeStamps;
+        ReadColumn(batch, ArchiveColumn::TimeStamp, &data);
+        DecodeTimeStamps(data, rowCount, &timeStamps);
+
+        // Every fixed width column must hold rowCount values before any is read.
+        auto readFixed = [&](ArchiveColumn column, size_t width)
+        {
+            ReadColumn(batch, column, &data);
+            if (data.size() != rowCount * width)
+            {
+                throw std::exception("Archive column has the wrong length.");
+            }
+        };
+
+        for (size_t row = 0; row < rowCount; ++row)
+        {
+            (*events)[row].timeStamp = timeStamps[row];
+        }
+        readFixed(ArchiveColumn::Direction, sizeof(uint8_t));
+        for (size_t row = 0; row < rowCount; ++row)
+        {
+            (*events)[row].direction = static_cast<TrafficDirection>(ValueAt<uint8_t>(data, row));
+        }
+        readFixed(ArchiveColumn::Action, sizeof(uint8_t));
+        for (size_t row = 0; row < rowCount; ++row)
+        {
+            (*events)[row].action = static_cast<RuleAction>(ValueAt<uint8_t>(data, row));
+        }
+        readFixed(ArchiveColumn::Source, sizeof(IN6_ADDR));
+        for (size_t row = 0; row < rowCount; ++row)
+        {
+            (*events)[row].source = ValueAt<IN6_ADDR>(data, row);
+        }
+        readFixed(ArchiveColumn::Destination, sizeof(IN6_ADDR));
+        for (size_t row = 0; row < rowCount; ++row)
+        {
+            (*events)[row].destination = ValueAt<IN6_ADDR>(data, row);
+        }
+        readFixed(ArchiveColumn::Protocol, sizeof(uint16_t));
+        for (size_t row = 0; row < rowCount; ++row)
+        {
+            (*events)[row].protocol = ValueAt<uint16_t>(data, row);
+        }
+        readFixed(ArchiveColumn::SourcePort, sizeof(uint16_t));
+        for (size_t row = 0; row < rowCount; ++row)
+        {
+            (*events)[row].sourcePort = ValueAt<uint16_t>(data, row);
+        }
+        readFixed(ArchiveColumn::DestinationPort, sizeof(uint16_t));
+        for (size_t row = 0; row < rowCount; ++row)
+        {
+            (*events)[row].destinationPort = ValueAt<uint16_t>(data, row);
+        }
+        readFixed(ArchiveColumn::IcmpType, sizeof(uint8_t));
+        for (size_t row = 0; row < rowCount; ++row)
+        {
+            (*events)[row].icmpType = ValueAt<uint8_t>(data, row);
+        }
+        readFixed(ArchiveColumn::Flags, sizeof(uint8_t));
+        for (size_t row = 0; row < rowCount; ++row)
+        {
+            uint8_t flags = ValueAt<uint8_t>(data, row);
+            (*events)[row].isIpv6 = (flags & ArchiveFlagIpv6) != 0;
+            (*events)[row].isTcpSyn = (flags & ArchiveFlagTcpSyn) != 0;
+        }
+        readFixed(ArchiveColumn::SampleRate, sizeof(uint32_t));
+        for (size_t row = 0; row < rowCount; ++row)
+        {
+            (*events)[row].sampleRate = ValueAt<uint32_t>(data, row);
+        }
+        readFixed(ArchiveColumn::RuleId, sizeof(uint32_t));
+        for (size_t row = 0; row < rowCount; ++row)
+        {
+            (*events)[row].ruleId = GetGuid(ArchiveColumn::RuleId, ValueAt<uint32_t>(data, row));
+        }
+    }
+
+    const std::string& EventArchiveReader::GetString(
+        ArchiveColumn column,
+        unsigned long id) const
+    {
+        const auto& strings = m_Strings[FileColumn(column)];
+        if (id >= strings.size())
+        {
+            throw std::exception("Archive dictionary id is out of range.");
+        }
+        return strings[id];
+    }
+
+    const GUID& EventArchiveReader::GetGuid(
+        ArchiveColumn column,
+        unsigned long id) const
+    {
+        const auto& guids = m_Guids[FileColumn(column)];
+        if (id >= guids.size())
+        {
+            throw std::exception("Archive dictionary id is out of range.");
+        }
+        return guids[id];
+    }
+
+    void EventArchiveReader::DecodeTimeStamps(
+        const std::string& data,
+        size_t rowCount,
+        std::vector<LONGLONG>* timeStamps)
+    {
+        timeStamps->clear();
+        timeStamps->reserve(rowCount);
+
+        LONGLONG previous = 0;
+        size_t offset = 0;
+        while (timeStamps->size() < rowCount)
+        {
+            unsigned long long value = 0;
+            unsigned int shift = 0;
+            for (;;)
+            {
+                if (offset >= data.size() ||
+                    shift > 63)
+                {
+                    throw std::exception("Archive timestamp column is truncated.");
+                }
+                unsigned char byte = static_cast<unsigned char>(data[offset++]);
+                value |= static_cast<unsigned long long>(byte & 0x7F) << shift;
+                if ((byte & 0x80) == 0)
+                {
+                    break;
+                }
+                shift += 7;
+            }
+            previous += UnZigZag(value);
+            timeStamps->push_back(previous);
+        }
+    }
+
+    void EventArchiveReader::ReadHeader(unsigned long long* offset)
+    {
+        std::string header;
+        ReadAt(0, sizeof(ARCHIVE_MAGIC) + 2 * sizeof(uint32_t), &header);
+        if (memcmp(header.data(), ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC)) != 0)
+        {
+            throw std::exception("File is not an archive.");
+        }
+        if (ReadValue<uint32_t>(header, sizeof(ARCHIVE_MAGIC)) != ARCHIVE_VERSION)
+        {
+            throw std::exception("Archive version is not supported.");
+        }
+        uint32_t columnCount = ReadValue<uint32_t>(header, sizeof(ARCHIVE_MAGIC) + sizeof(uint32_t));
+
+        *offset = header.size();
+        std::string descriptor;
+        for (uint32_t i = 0; i < columnCount; ++i)
+        {
+            ReadAt(*offset, 4, &descriptor);
+            uint16_t nameLength = ReadValue<uint16_t>(descriptor, 2);
+            ArchiveColumnInfo column;
+            column.type = static_cast<ArchiveColumnType>(descriptor[0]);
+            ReadAt(*offset + 4, nameLength, &column.name);
+            m_Columns.push_back(column);
+            *offset += 4 + nameLength;
+        }
+        *offset = (*offset + ARCHIVE_ALIGNMENT - 1) / ARCHIVE_ALIGNMENT * ARCHIVE_ALIGNMENT;
+
+        for (size_t known = 0; known < static_cast<size_t>(ArchiveColumn::Count); ++known)
+        {
+            m_ColumnIndex[known] = SIZE_MAX;
+            for (size_t i = 0; i < m_Columns.size(); ++i)
+            {
+                if (m_Columns[i].name == ARCHIVE_COLUMNS[known].name &&
+                    m_Columns[i].type == ARCHIVE_COLUMNS[known].type)
+                {
+                    m_ColumnIndex[known] = i;
+                    break;
+                }
+            }
+        }
+
+        m_Strings.resize(m_Columns.size());
+        m_Guids.resize(m_Columns.size());
+    }
+
+    void EventArchiveReader::ReadBlocks(unsigned long long offset)
+    {
+        // Walks the blocks rather than trusting the footer, so an archive whose writer
+        // did not close it is read up to its last complete block.
+        std::string header;
+        std::string payload;
+        while (offset + BLOCK_HEADER_BYTES <= m_FileSize)
+        {
+            ReadAt(offset, BLOCK_HEADER_BYTES, &header);
+            auto kind = static_cast<ArchiveBlockKind>(ReadValue<uint32_t>(header, 0));
+            unsigned long long payloadLength = ReadValue<uint64_t>(header, 8);
+            unsigned long long payloadOffset = offset + BLOCK_HEADER_BYTES;
+            if (kind == ArchiveBlockKind::Footer ||
+                payloadLength > m_FileSize - payloadOffset)
+            {
+                break;
+            }
+
+            if (kind == ArchiveBlockKind::Dictionary)
+            {
+                ReadAt(payloadOffset, static_cast<size_t>(payloadLength), &payload);
+                ReadDictionary(payload);
+            }
+            else if (kind == ArchiveBlockKind::RecordBatch)
+            {
+                ReadAt(payloadOffset, 2 * sizeof(uint32_t), &payload);
+                Batch batch;
+                batch.payloadOffset = payloadOffset;
+                batch.rowCount = ReadValue<uint32_t>(payload, 0);
+                uint32_t columnCount = ReadValue<uint32_t>(payload, sizeof(uint32_t));
+                if (columnCount != m_Columns.size())
+                {
+                    throw std::exception("Archive batch does not match the header's columns.");
+                }
+
+                ReadAt(payloadOffset + payload.size(), columnCount * 2 * sizeof(uint64_t), &payload);
+                for (uint32_t i = 0; i < columnCount; ++i)
+                {
+                    unsigned long long bufferOffset = ReadValue<uint64_t>(payload, i * 2 * sizeof(uint64_t));
+                    unsigned long long bufferLength = ReadValue<uint64_t>(payload, (i * 2 + 1) * sizeof(uint64_t));
+                    if (bufferOffset > payloadLength ||
+                        bufferLength > payloadLength - bufferOffset)
+                    {
+                        throw std::exception("Archive column lies outside its batch.");
+                    }
+                    batch.buffers.emplace_back(bufferOffset, bufferLength);
+                }
+                m_Batches.push_back(std::move(batch));
+            }
+
+            offset = payloadOffset + (payloadLength + ARCHIVE_ALIGNMENT - 1) / ARCHIVE_ALIGNMENT * ARCHIVE_ALIGNMENT;
+        }
+    }
+
+    void EventArchiveReader::ReadDictionary(const std::string& payload)
+    {
+        uint32_t column = ReadValue<uint32_t>(payload, 0);
+        uint32_t firstId = ReadValue<uint32_t>(payload, 4);
+        uint32_t count = ReadValue<uint32_t>(payload, 8);
+        const size_t entries = DICTIONARY_HEADER_BYTES;
+        if (column >= m_Columns.size())
+        {
+            throw std::exception("Archive dictionary names an unknown column.");
+        }
+
+        if (m_Columns[column].type == ArchiveColumnType::GuidDictionary)
+        {
+            auto& guids = m_Guids[column];
+            if (firstId != guids.size())
+            {
+                throw std::exception("Archive dictionary ids are out of order.");
+            }
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                guids.push_back(ReadValue<GUID>(payload, entries + i * sizeof(GUID)));
+            }
+        }
+        else if (m_Columns[column].type == ArchiveColumnType::StringDictionary)
+        {
+            auto& strings = m_Strings[column];
+            if (firstId != strings.size())
+            {
+                throw std::exception("Archive dictionary ids are out of order.");
+            }
+            size_t bytes = entries + (static_cast<size_t>(count) + 1) * sizeof(uint32_t);
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                uint32_t begin = ReadValue<uint32_t>(payload, entries + i * sizeof(uint32_t));
+                uint32_t end = ReadValue<uint32_t>(payload, entries + (i + 1) * sizeof(uint32_t));
+                if (begin > end ||
+                    bytes + end > payload.size())
+                {
+                    throw std::exception("Archive dictionary is truncated.");
+                }
+                strings.emplace_back(payload, bytes + begin, end - begin);
+            }
+        }
+    }
+
+    void EventArchiveReader::ReadAt(
+        unsigned long long offset,
+        size_t length,
+        std::string* data)
+    {
+        data->resize(length);
+        if (length == 0)
+        {
+            return;
+        }
+        if (offset + length > m_FileSize ||
+            _fseeki64(m_File, static_cast<__int64>(offset), SEEK_SET) != 0 ||
+            fread(&(*data)[0], 1, length, m_File) != length)
+        {
+            throw std::exception("Archive is truncated.");
+        }
+    }
+
+    size_t EventArchiveReader::FileColumn(ArchiveColumn column) const
+    {
+        size_t index = m_ColumnIndex[static_cast<size_t>(column)];
+        if (index == SIZE_MAX)
+        {
+            throw std::exception("Archive does not have the requested column.");
+        }
+        return index;
+    }
+}
@@ -0,0 +1,311 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#pragma once
+
+// os headers
+#include <winsock2.h>
+// c++ headers
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "CompactEventRecord.h"
+#include "FirewallEtwTraceCallback.h"
+
+namespace FirewallEventMonitor
+{
+    //
+    // Columnar event archive (-Archive <path>), version 1.
+    //
+    // Events are stored in record batches of up to RowsPerBatch rows. Each column of a batch
+    // is one contiguous, 8 byte aligned buffer, so a reader can fetch a single column of a
+    // batch with one seek and read, and use it without parsing. All integers are little endian.
+    //
+    //   File        := Header Block* [Trailer]
+    //   Header      := magic "FEMARCH1" | version u32 | columnCount u32 | Column[columnCount] | pad to 8
+    //   Column      := type u8 | reserved u8 | nameLength u16 | name (UTF-8, not terminated)
+    //   Block       := kind u32 | reserved u32 | payloadLength u64 | payload | pad to 8
+    //   Trailer     := footerOffset u64 | magic "FEMARCH1"
+    //
+    // Block kinds:
+    //   Dictionary  := column u32 | firstId u32 | count u32 | reserved u32 | entries
+    //                  GuidDictionary entries are 16 byte GUIDs (in memory layout).
+    //                  StringDictionary entries are offsets u32[count + 1] into the UTF-8 bytes that follow.
+    //   RecordBatch := rowCount u32 | columnCount u32 | { offset u64, length u64 }[columnCount] | buffers
+    //                  Offsets are from the start of the payload.
+    //   Footer      := batchCount u64 | batchOffset u64[batchCount] (file offsets of the RecordBatch blocks)
+    //
+    // Dictionaries are shared by the whole file: a Dictionary block adds the entries first used
+    // by the RecordBatch that follows it, and ids never change once assigned.
+    //
+    // Column buffers by type:
+    //   TimeStamp         varint (LEB128) of the zigzag encoded difference from the previous row's
+    //                     timestamp; the first row of a batch is the difference from 0.
+    //   UInt8/16/32       fixed width values.
+    //   Address           16 byte addresses, IPv4 stored v4-mapped (see CompactEventRecord).
+    //   GuidDictionary,
+    //   StringDictionary  u32 dictionary ids.
+    //
+    // Columns are only ever added at the end; readers find columns by name and skip the rest.
+    // A file without its trailer (the writer did not close it) can still be read block by
+    // block up to its last complete block.
+    //
+    enum class ArchiveColumnType : unsigned char
+    {
+        TimeStamp = 1,
+        UInt8 = 2,
+        UInt16 = 3,
+        UInt32 = 4,
+        Address = 5,
+        GuidDictionary = 6,
+        StringDictionary = 7
+    };
+
+    // The columns written by this version, in file order.
+    enum class ArchiveColumn : unsigned long
+    {
+        TimeStamp,
+        Direction, // TrafficDirection
+        Action, // RuleAction
+        Status,
+        PortId,
+        PortName,
+        PortFriendlyName,
+        Source,
+        Destination,
+        Protocol,
+        SourcePort,
+        DestinationPort,
+        IcmpType,
+        Flags, // ArchiveFlagIpv6 | ArchiveFlagTcpSyn
+        SampleRate,
+        RuleId,
+        LayerId,
+        GroupId,
+        GftFlags,
+        Count
+    };
+
+    struct ArchiveColumnInfo
+    {
+        std::string name;
+        ArchiveColumnType type;
+    };
+
+    enum class ArchiveBlockKind : unsigned long { Dictionary = 1, RecordBatch = 2, Footer = 3 };
+
+    const unsigned char ArchiveFlagIpv6 = 0x01;
+    const unsigned char ArchiveFlagTcpSyn = 0x02;
+
+    // Name and type of a column written by this version.
+    ArchiveColumnInfo GetArchiveColumnInfo(ArchiveColumn column);
+
+    // Appends events to a new archive. Append() only copies the event into the column buffers;
+    // a full batch is handed to the writer's thread, which encodes and writes it, so the thread
+    // calling Append() (the ETW thread) never waits on the file.
+    // If the writer's thread falls maxQueuedBatches behind, further full batches are dropped;
+    // their new dictionary entries are kept for the next batch written.
+    class EventArchiveWriter
+    {
+    public:
+        // Creates (or replaces) the archive. Throws if it cannot be created.
+        EventArchiveWriter(
+            const std::wstring& path,
+            size_t rowsPerBatch = DefaultRowsPerBatch,
+            size_t maxQueuedBatches = DefaultMaxQueuedBatches);
+
+        // Closes the archive if Close() was not called.
+        ~EventArchiveWriter();
+
+        void Append(const VfpEventData& eventData);
+
+        // Waits until the full batches handed to the writer's thread have been written.
+        void Flush();
+
+        // Writes the batches still queued and the rows not yet written, then the footer.
+        // Later Appends are ignored.
+        void Close();
+
+        unsigned long long GetRowsWritten() const;
+
+        // Rows of the batches dropped while the writer's thread was behind.
+        unsigned long long GetRowsDropped() const;
+
+        unsigned long long GetBatchesWritten() const;
+
+        unsigned long long GetBytesWritten() const;
+
+        // Distinct values held by all the dictionaries. Only once the archive is closed.
+        size_t GetDictionaryEntries() const;
+
+        // Constants
+        static const size_t DefaultRowsPerBatch = 16384;
+        static const size_t DefaultMaxQueuedBatches = 4;
+        static const size_t WriteBufferSizeInBytes = 1024 * 1024;
+
+        EventArchiveWriter(EventArchiveWriter const&) = delete;
+        EventArchiveWriter& operator=(EventArchiveWriter const&) = delete;
+    private:
+        // Values added since the last Dictionary block are pending until the batch is written.
+        struct StringDictionary
+        {
+            std::unordered_map<std::wstring, unsigned long> ids;
+            std::vector<std::string> pending;
+        };
+
+        struct GuidDictionary
+        {
+            std::unordered_map<GUID, unsigned long, GuidHash> ids;
+            std::vector<GUID> pending;
+        };
+
+        // A full batch and the dictionary entries it is the first to use, as handed to the writer's thread.
+        struct SealedBatch
+        {
+            std::string columns[static_cast<size_t>(ArchiveColumn::Count)];
+            size_t rows = 0;
+            unsigned long firstRuleId = 0;
+            std::vector<GUID> ruleIds;
+            std::vector<unsigned long> firstStringIds; // Indexed by column.
+            std::vector<std::vector<std::string>> strings; // Indexed by column.
+        };
+
+        const std::wstring m_Path;
+        const size_t m_RowsPerBatch;
+        const size_t m_MaxQueuedBatches;
+        FILE* m_File = NULL;
+        // Only touched by the thread calling Append().
+        std::string m_Columns[static_cast<size_t>(ArchiveColumn::Count)];
+        std::vector<StringDictionary> m_StringDictionaries; // Indexed by column; unused for other types.
+        GuidDictionary m_RuleIds;
+        size_t m_Rows = 0; // Rows in the current batch.
+        LONGLONG m_PreviousTimeStamp = 0;
+        // Handing batches to the writer's thread.
+        CRITICAL_SECTION m_CriticalSection; // Guards m_Queue, m_Writing and m_Stopping.
+        CONDITION_VARIABLE m_BatchQueued;
+        CONDITION_VARIABLE m_BatchWritten;
+        std::vector<std::unique_ptr<SealedBatch>> m_Queue;
+        bool m_Writing = false;
+        bool m_Stopping = false;
+        std::thread m_Writer;
+        // Only touched by the writer's thread, and by the constructor and Close() around it.
+        bool m_WriteFailed = false; // Set on the first failed write, to warn only once.
+        std::string m_Block; // Reused to encode each block.
+        std::vector<unsigned long long> m_BatchOffsets;
+        std::atomic<unsigned long long> m_Offset{ 0 };
+        std::atomic<unsigned long long> m_RowsWritten{ 0 };
+        std::atomic<unsigned long long> m_BatchesWritten{ 0 };
+        std::atomic<unsigned long long> m_RowsDropped{ 0 };
+
+        void AppendString(ArchiveColumn column, const std::wstring& value);
+
+        void AppendGuid(const GUID& value);
+
+        // Moves the current batch's rows and new dictionary entries into a SealedBatch.
+        std::unique_ptr<SealedBatch> SealBatch();
+
+        // Hands the current batch to the writer's thread, or drops its rows if the queue is full.
+        void QueueBatch();
+
+        void WriterThread();
+
+        void WriteHeader();
+
+        void WriteDictionaries(const SealedBatch& batch);
+
+        void WriteBatch(const SealedBatch& batch);
+
+        void WriteFooter();
+
+        // Writes m_Block as a block of the given kind.
+        void WriteBlock(ArchiveBlockKind kind);
+
+        void Write(const void* data, size_t length);
+    };
+
+    // Reads an archive column by column. Opening reads the header, the dictionaries and the
+    // location of each batch; column data is only read when asked for.
+    class EventArchiveReader
+    {
+    public:
+        // Throws if the file is not an archive.
+        EventArchiveReader(const std::wstring& path);
+
+        ~EventArchiveReader();
+
+        // True if the file starts with the archive magic; false if it does not or cannot be opened.
+        static bool IsArchive(const std::wstring& path);
+
+        // The columns as found in the file.
+        const std::vector<ArchiveColumnInfo>& GetColumns() const;
+
+        size_t GetBatchCount() const;
+
+        size_t GetRowCount(size_t batch) const;
+
+        // Reads one column of a batch as stored (see the layout above); returns the row count.
+        // Throws if the file has no such column.
+        size_t ReadColumn(
+            size_t batch,
+            ArchiveColumn column,
+            _Out_ std::string* data);
+
+        // Reads the columns of a batch that make up a CompactEventRecord.
+        void ReadEvents(
+            size_t batch,
+            _Out_ std::vector<CompactEventRecord>* events);
+
+        // Resolves an id read from a dictionary column. Throws if it is out of range.
+        const std::string& GetString(ArchiveColumn column, unsigned long id) const;
+
+        const GUID& GetGuid(ArchiveColumn column, unsigned long id) const;
+
+        static void DecodeTimeStamps(
+            const std::string& data,
+            size_t rowCount,
+            _Out_ std::vector<LONGLONG>* timeStamps);
+
+        // Values read from a fixed width column.
+        template <typename T>
+        static T ValueAt(const std::string& data, size_t row)
+        {
+            T value;
+            memcpy(&value, data.data() + row * sizeof(T), sizeof(T));
+            return value;
+        }
+
+        EventArchiveReader(EventArchiveReader const&) = delete;
+        EventArchiveReader& operator=(EventArchiveReader const&) = delete;
+    private:
+        struct Batch
+        {
+            unsigned long long payloadOffset;
+            size_t rowCount;
+            std::vector<std::pair<unsigned long long, unsigned long long>> buffers; // offset, length
+        };
+
+        FILE* m_File = NULL;
+        unsigned long long m_FileSize = 0;
+        std::vector<ArchiveColumnInfo> m_Columns;
+        // File column index of each known column, or SIZE_MAX if the file does not have it.
+        size_t m_ColumnIndex[static_cast<size_t>(ArchiveColumn::Count)];
+        std::vector<Batch> m_Batches;
+        std::vector<std::vector<std::string>> m_Strings; // Indexed by file column.
+        std::vector<std::vector<GUID>> m_Guids; // Indexed by file column.
+
+        void ReadHeader(_Inout_ unsigned long long* offset);
+
+        void ReadBlocks(unsigned long long offset);
+
+        void ReadDictionary(const std::string& payload);
+
+        void ReadAt(unsigned long long offset, size_t length, _Out_ std::string* data);
+
+        size_t FileColumn(ArchiveColumn column) const;
+    };
+}
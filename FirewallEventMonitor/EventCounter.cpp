@@ -1,56 +1,65 @@
-// Copyright (c) Microsoft Corporation. All rights reserved.
-// Licensed under the MIT License. See License.txt in the project root for license information.
-
-#include "EventCounter.h"
-
-// ntl headers
-#include "ntlException.hpp"
-#include "ntlLocks.hpp"
-
-namespace FirewallEventMonitor
-{
-    EventCounter::EventCounter(unsigned long maxEventsPerEpoc)
-        : m_MaxEventsPerEpoc(maxEventsPerEpoc)
-    {
-        ::InitializeCriticalSectionEx(&m_CriticalSection, 4000, 0);
-    }
-
-    unsigned long EventCounter::GetEventCountThisEpoc() const
-    {
-        return m_EventCountThisEpoc;
-    }
-
-    unsigned long EventCounter::GetEventCountTotal() const
-    {
-        return m_EventCountTotal;
-    }
-
-    void EventCounter::IncrementEventCount()
-    {
-        ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
-
-        m_EventCountThisEpoc++;
-        m_EventCountTotal++;
-
-        ntl::FatalCondition(
-            (m_EventCountThisEpoc == 0),
-            L"m_EventCountThisEpoc overflow");
-
-        // TODO: If FirewallEventMonitor does not have a time limit set, this will get hit at some point.
-        ntl::FatalCondition(
-            (m_EventCountTotal == 0),
-            L"EventCountTotal overflow");
-    }
-
-    bool EventCounter::EpocEventCountLimitReached() const
-    {
-        return m_EventCountThisEpoc >= m_MaxEventsPerEpoc;
-    }
-
-    void EventCounter::ResetEpocEventCount()
-    {
-        ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
-
-        m_EventCountThisEpoc = 0;
-    }
-}
\ No newline at end of file
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include "EventCounter.h"
+
+// c++ headers
+#include <algorithm>
+
+namespace FirewallEventMonitor
+{
+    EventCounter::EventCounter(unsigned long maxEventsPerEpoc)
+        : m_MaxEventsPerEpoc(maxEventsPerEpoc),
+          m_PublishQuantum((std::max)(1ul, (std::min)(
+              static_cast<unsigned long>(MaxPublishQuantum),
+              static_cast<unsigned long>(maxEventsPerEpoc / (16 * m_Counters.shards())))))
+    {
+        m_EpocEventCountLimitReached = m_MaxEventsPerEpoc == 0;
+    }
+
+    unsigned long EventCounter::GetEventCountThisEpoc() const
+    {
+        return static_cast<unsigned long>(
+            m_EventCountThisEpocPublished.load(std::memory_order_relaxed) +
+            m_Counters.sum(EventsThisEpocUnpublished));
+    }
+
+    unsigned long EventCounter::GetEventCountTotal() const
+    {
+        return static_cast<unsigned long>(m_Counters.sum(EventsTotal));
+    }
+
+    void EventCounter::IncrementEventCount(size_t processor)
+    {
+        m_Counters.add(processor, EventsTotal);
+
+        if (m_Counters.add(processor, EventsThisEpocUnpublished) >= m_PublishQuantum)
+        {
+            unsigned long long taken = m_Counters.take(processor, EventsThisEpocUnpublished);
+            unsigned long long published =
+                m_EventCountThisEpocPublished.fetch_add(taken, std::memory_order_relaxed) + taken;
+            if (published >= m_MaxEventsPerEpoc)
+            {
+                m_EpocEventCountLimitReached.store(true, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void EventCounter::IncrementEventCount()
+    {
+        IncrementEventCount(::GetCurrentProcessorNumber());
+    }
+
+    bool EventCounter::EpocEventCountLimitReached() const
+    {
+        return m_EpocEventCountLimitReached.load(std::memory_order_relaxed);
+    }
+
+    void EventCounter::ResetEpocEventCount()
+    {
+        // Counts racing with the reset fall in either epoc.
+        m_Counters.take_all(EventsThisEpocUnpublished);
+        m_EventCountThisEpocPublished.store(0, std::memory_order_relaxed);
+        m_EpocEventCountLimitReached.store(m_MaxEventsPerEpoc == 0, std::memory_order_relaxed);
+    }
+}
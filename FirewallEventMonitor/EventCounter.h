@@ -1,34 +1,55 @@
-// Copyright (c) Microsoft Corporation. All rights reserved.
-// Licensed under the MIT License. See License.txt in the project root for license information.
-
-#pragma once
-
-// OS Headers
-#include <Windows.h>
-
-namespace FirewallEventMonitor
-{
-    class EventCounter
-    {
-    public:
-        EventCounter(unsigned long maxEventsPerEpoc);
-
-        unsigned long GetEventCountThisEpoc() const;
-
-        unsigned long GetEventCountTotal() const;
-
-        void IncrementEventCount();
-
-        bool EpocEventCountLimitReached() const;
-
-        void ResetEpocEventCount();
-
-        EventCounter(EventCounter const&) = delete;
-        EventCounter& operator=(EventCounter const&) = delete;
-    private:
-        CRITICAL_SECTION m_CriticalSection;
-        unsigned long m_MaxEventsPerEpoc = 0;
-        unsigned long m_EventCountThisEpoc = 0;
-        unsigned long m_EventCountTotal = 0;
-    };
-}
\ No newline at end of file
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#pragma once
+
+// OS Headers
+#include <Windows.h>
+// c++ headers
+#include <atomic>
+// ntl headers
+#include "ntlShardedCounters.hpp"
+
+namespace FirewallEventMonitor
+{
+    // Counts events in total and in the current epoc, in per-processor shards summed when read.
+    //
+    // The epoc limit is checked for every event, so it cannot sum the shards each time. Each
+    // shard instead moves its epoc count into a shared total once it reaches a quantum, and the
+    // limit is a flag set when that total reaches it. The limit may be passed by up to one
+    // quantum less one event per shard; the quantum is kept to a 16th of the limit across shards.
+    class EventCounter
+    {
+    public:
+        EventCounter(unsigned long maxEventsPerEpoc);
+
+        unsigned long GetEventCountThisEpoc() const;
+
+        unsigned long GetEventCountTotal() const;
+
+        // Counts an event in the shard of the processor that logged it (EtwRecord::getProcessorNumber()).
+        void IncrementEventCount(size_t processor);
+
+        // Counts an event in the shard of the processor the calling thread is running on.
+        void IncrementEventCount();
+
+        bool EpocEventCountLimitReached() const;
+
+        void ResetEpocEventCount();
+
+        // Constants
+        static const unsigned long MaxPublishQuantum = 64;
+
+        EventCounter(EventCounter const&) = delete;
+        EventCounter& operator=(EventCounter const&) = delete;
+    private:
+        enum Counter { EventsTotal, EventsThisEpocUnpublished, CounterCount };
+
+        ntl::ShardedCounters<CounterCount> m_Counters;
+        const unsigned long m_MaxEventsPerEpoc = 0;
+        const unsigned long m_PublishQuantum = 1;
+        // Written once per quantum; read for every event.
+        std::atomic<unsigned long long> m_EventCountThisEpocPublished{ 0 };
+        std::atomic<bool> m_EpocEventCountLimitReached{ false };
+    };
+}
@@ -0,0 +1,185 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include "EventSink.h"
+
+// c++ headers
+#include <cstdint>
+#include <iterator>
+// ntl headers
+#include "ntlLocks.hpp"
+
+namespace FirewallEventMonitor
+{
+    QueuedEventSink::QueuedEventSink(size_t maxQueuedEvents)
+        : m_MaxQueuedEvents(maxQueuedEvents == 0 ? 1 : maxQueuedEvents)
+    {
+        ::InitializeCriticalSectionEx(&m_CriticalSection, 4000, 0);
+        ::InitializeConditionVariable(&m_QueueNotEmpty);
+    }
+
+    QueuedEventSink::~QueuedEventSink()
+    {
+        // WriteBatch() is pure virtual by now; derived destructors have already stopped the worker.
+        ::DeleteCriticalSection(&m_CriticalSection);
+    }
+
+    void QueuedEventSink::Start()
+    {
+        if (m_Worker.joinable())
+        {
+            return;
+        }
+
+        {
+            ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+            m_Stopping = false;
+        }
+        m_Worker = std::thread(&QueuedEventSink::WorkerThread, this);
+    }
+
+    void QueuedEventSink::Stop()
+    {
+        StopBy(ULLONG_MAX);
+    }
+
+    void QueuedEventSink::StopBy(ULONGLONG deadline)
+    {
+        if (m_Worker.joinable())
+        {
+            {
+                ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+                m_Stopping = true;
+                m_Deadline = deadline;
+            }
+            ::WakeAllConditionVariable(&m_QueueNotEmpty);
+            m_Worker.join();
+        }
+
+        // Events queued without a worker (never started, or raced with the stop).
+        std::vector<EncodedEvent> batch;
+        for (;;)
+        {
+            {
+                ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+                if (::GetTickCount64() >= deadline)
+                {
+                    AbandonQueue();
+                    return;
+                }
+
+                if (!TakeBatch(DrainBatchEvents, &batch))
+                {
+                    return;
+                }
+            }
+
+            WriteBatch(batch);
+            m_EventsWritten.fetch_add(batch.size(), std::memory_order_relaxed);
+            batch.clear();
+        }
+    }
+
+    bool QueuedEventSink::Write(const EncodedEvent& event)
+    {
+        {
+            ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+            if (m_Queue.size() >= m_MaxQueuedEvents)
+            {
+                m_EventsDropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            m_Queue.push_back(event);
+            m_QueuedEvents.store(m_Queue.size(), std::memory_order_relaxed);
+        }
+
+        ::WakeConditionVariable(&m_QueueNotEmpty);
+        return true;
+    }
+
+    double QueuedEventSink::GetQueueUsage() const
+    {
+        return static_cast<double>(m_QueuedEvents.load(std::memory_order_relaxed)) / m_MaxQueuedEvents;
+    }
+
+    unsigned long long QueuedEventSink::GetEventsWritten() const
+    {
+        return m_EventsWritten.load(std::memory_order_relaxed);
+    }
+
+    unsigned long long QueuedEventSink::GetEventsDropped() const
+    {
+        return m_EventsDropped.load(std::memory_order_relaxed);
+    }
+
+    unsigned long long QueuedEventSink::GetEventsAbandoned() const
+    {
+        return m_EventsAbandoned.load(std::memory_order_relaxed);
+    }
+
+    void QueuedEventSink::WorkerThread()
+    {
+        std::vector<EncodedEvent> batch;
+        for (;;)
+        {
+            {
+                ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+                while (m_Queue.empty() &&
+                    !m_Stopping)
+                {
+                    ::SleepConditionVariableCS(&m_QueueNotEmpty, &m_CriticalSection, INFINITE);
+                }
+
+                if (m_Stopping &&
+                    ::GetTickCount64() >= m_Deadline)
+                {
+                    AbandonQueue();
+                    return;
+                }
+
+                // While stopping, smaller batches let the deadline be checked between them.
+                if (!TakeBatch(m_Stopping ? DrainBatchEvents : SIZE_MAX, &batch))
+                {
+                    // Stopping, and everything queued has been written.
+                    return;
+                }
+            }
+
+            WriteBatch(batch);
+            m_EventsWritten.fetch_add(batch.size(), std::memory_order_relaxed);
+            batch.clear();
+        }
+    }
+
+    bool QueuedEventSink::TakeBatch(
+        size_t maxEvents,
+        std::vector<EncodedEvent>* batch)
+    {
+        if (m_Queue.empty())
+        {
+            return false;
+        }
+
+        if (m_Queue.size() <= maxEvents)
+        {
+            // Swap rather than copy: the emptied batch keeps its capacity for the next events.
+            batch->swap(m_Queue);
+        }
+        else
+        {
+            batch->assign(
+                std::make_move_iterator(m_Queue.begin()),
+                std::make_move_iterator(m_Queue.begin() + maxEvents));
+            m_Queue.erase(m_Queue.begin(), m_Queue.begin() + maxEvents);
+        }
+        m_QueuedEvents.store(m_Queue.size(), std::memory_order_relaxed);
+        return true;
+    }
+
+    void QueuedEventSink::AbandonQueue()
+    {
+        m_EventsAbandoned.fetch_add(m_Queue.size(), std::memory_order_relaxed);
+        m_Queue.clear();
+        m_QueuedEvents.store(0, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,123 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#pragma once
+
+// OS Headers
+#include <Windows.h>
+// c++ headers
+#include <atomic>
+#include <climits>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace FirewallEventMonitor
+{
+    // Encodings an event can be written in. Each is produced at most once per event.
+    enum class EventFormat { Text, Json, Syslog, Count };
+
+    // One event in one format, shared by every sink that writes that format.
+    typedef std::shared_ptr<const std::wstring> EncodedEvent;
+
+    // Destination for encoded events. Write() is called on the ETW processing thread
+    // and must not block on the destination: sinks queue the event and write it from
+    // their own thread, dropping it if their bounded queue is full.
+    class EventSink
+    {
+    public:
+        virtual ~EventSink() = default;
+
+        // Short name for reports, e.g. "Console".
+        virtual LPCWSTR GetName() const = 0;
+
+        virtual EventFormat GetFormat() const = 0;
+
+        virtual void Start() = 0;
+
+        // Writes everything still queued, then stops the sink's thread.
+        virtual void Stop() = 0;
+
+        // As Stop(), but gives up at deadline (a GetTickCount64() value): events still
+        // queued then are abandoned rather than written.
+        virtual void StopBy(ULONGLONG deadline) = 0;
+
+        // Returns false if the event was dropped because the queue is full.
+        virtual bool Write(const EncodedEvent& event) = 0;
+
+        // How full the queue is, from 0 (empty) to 1 (full).
+        virtual double GetQueueUsage() const = 0;
+
+        virtual unsigned long long GetEventsWritten() const = 0;
+
+        virtual unsigned long long GetEventsDropped() const = 0;
+
+        // Events given up on by StopBy().
+        virtual unsigned long long GetEventsAbandoned() const = 0;
+    };
+
+    // Sink with a bounded queue of events, written in batches by a worker thread.
+    // Derived classes only implement WriteBatch().
+    class QueuedEventSink : public EventSink
+    {
+    public:
+        QueuedEventSink(size_t maxQueuedEvents);
+
+        // Derived classes must call Stop() in their destructor, while WriteBatch() can still run.
+        ~QueuedEventSink() override;
+
+        void Start() override;
+
+        void Stop() override;
+
+        // Once stopping, the worker writes at most DrainBatchEvents at a time, so it can
+        // give up close to the deadline.
+        void StopBy(ULONGLONG deadline) override;
+
+        bool Write(const EncodedEvent& event) override;
+
+        double GetQueueUsage() const override;
+
+        unsigned long long GetEventsWritten() const override;
+
+        unsigned long long GetEventsDropped() const override;
+
+        unsigned long long GetEventsAbandoned() const override;
+
+        // Constants
+        static const size_t DefaultMaxQueuedEvents = 65536;
+        static const size_t DrainBatchEvents = 1024;
+
+        QueuedEventSink(QueuedEventSink const&) = delete;
+        QueuedEventSink& operator=(QueuedEventSink const&) = delete;
+    protected:
+        // Called on the worker thread (or by Stop() once it has finished) with events in arrival order.
+        virtual void WriteBatch(const std::vector<EncodedEvent>& events) = 0;
+
+    private:
+        const size_t m_MaxQueuedEvents;
+        CRITICAL_SECTION m_CriticalSection; // Guards m_Queue, m_Stopping and m_Deadline.
+        CONDITION_VARIABLE m_QueueNotEmpty;
+        std::vector<EncodedEvent> m_Queue;
+        bool m_Stopping = false;
+        ULONGLONG m_Deadline = ULLONG_MAX; // When a stopping worker gives up on what is still queued.
+        std::atomic<size_t> m_QueuedEvents{ 0 };
+        std::atomic<unsigned long long> m_EventsWritten{ 0 };
+        std::atomic<unsigned long long> m_EventsDropped{ 0 };
+        std::atomic<unsigned long long> m_EventsAbandoned{ 0 };
+        std::thread m_Worker;
+
+        void WorkerThread();
+
+        // Takes up to maxEvents of the queued events, oldest first; returns false if there were none.
+        // Called with m_CriticalSection held.
+        bool TakeBatch(
+            size_t maxEvents,
+            _Inout_ std::vector<EncodedEvent>* batch);
+
+        // Counts the queued events as abandoned and empties the queue.
+        // Called with m_CriticalSection held.
+        void AbandonQueue();
+    };
+}
@@ -0,0 +1,735 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include "EventSketch.h"
+
+// c++ headers
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+// ntl headers
+#include "ntlLocks.hpp"
+
+#include "FlowSampler.h"
+#include "Timer.h"
+
+namespace FirewallEventMonitor
+{
+    namespace
+    {
+        const char SKETCH_MAGIC[8] = { 'F', 'E', 'M', 'S', 'K', 'C', 'H', '1' };
+        const unsigned long SKETCH_VERSION = 1;
+        const size_t SKETCH_ALIGNMENT = 8;
+        const size_t HEADER_BYTES = 16;
+        const size_t SECTION_HEADER_BYTES = 16;
+        const size_t TOP_ENTRY_BYTES = 32;
+        // Bounds on what a file may ask for, so a damaged one cannot exhaust memory.
+        const unsigned long MAX_TOP_CAPACITY = 65536;
+        const double MIN_COMPRESSION = 10.0;
+        const double MAX_COMPRESSION = 1000.0;
+
+        const unsigned long long SKETCH_HASH_SEED = 0x2d358dccaa6c78a5ull;
+        const double HUNDRED_NS_PER_MILLISECOND = 10000.0;
+        const LONGLONG HUNDRED_NS_PER_SECOND = 10000000LL;
+
+        // Final mix of MurmurHash3.
+        unsigned long long Fmix(unsigned long long value)
+        {
+            value ^= value >> 33;
+            value *= 0xff51afd7ed558ccdull;
+            value ^= value >> 33;
+            value *= 0xc4ceb9fe1a85ec53ull;
+            value ^= value >> 33;
+            return value;
+        }
+
+        // Fixed hashes, the same on every host, so sketches of different hosts merge.
+        unsigned long long HashAddress(const IN6_ADDR& address)
+        {
+            unsigned long long low = 0, high = 0;
+            memcpy(&low, &address, sizeof(low));
+            memcpy(&high, reinterpret_cast<const unsigned char*>(&address) + sizeof(low), sizeof(high));
+            return Fmix(low ^ Fmix(high ^ SKETCH_HASH_SEED));
+        }
+
+        unsigned long long HashFlow(const CompactEventRecord& record)
+        {
+            // FlowHash is small for every sampled flow; mixing again spreads it over all 64 bits.
+            return Fmix(FlowSampler::FlowHash(record) ^ SKETCH_HASH_SEED);
+        }
+
+        SketchKey AddressKey(const IN6_ADDR& address)
+        {
+            SketchKey key;
+            memcpy(key.bytes, &address, sizeof(key.bytes));
+            return key;
+        }
+
+        SketchKey PortKey(unsigned short protocol, unsigned short port)
+        {
+            SketchKey key = {};
+            uint32_t value = (static_cast<uint32_t>(protocol) << 16) | port;
+            memcpy(key.bytes, &value, sizeof(value));
+            return key;
+        }
+
+        SketchKey RuleKey(const GUID& ruleId)
+        {
+            SketchKey key;
+            memcpy(key.bytes, &ruleId, sizeof(key.bytes));
+            return key;
+        }
+
+        bool IsV4Mapped(const IN6_ADDR& address)
+        {
+            static const unsigned char prefix[12] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff };
+            return memcmp(address.u.Byte, prefix, sizeof(prefix)) == 0;
+        }
+
+        std::wstring FormatKey(SketchTopKeys topKeys, const SketchKey& key)
+        {
+            switch (topKeys)
+            {
+            case SketchTopKeys::Sources:
+            case SketchTopKeys::Destinations:
+            {
+                IN6_ADDR address;
+                memcpy(&address, key.bytes, sizeof(address));
+                return FormatAddress(address, !IsV4Mapped(address));
+            }
+            case SketchTopKeys::DestinationPorts:
+            {
+                uint32_t value = 0;
+                memcpy(&value, key.bytes, sizeof(value));
+                unsigned short protocol = static_cast<unsigned short>(value >> 16);
+                LPCWSTR protocolName = ProtocolName(protocol);
+                return std::to_wstring(value & 0xffff) + L"/" +
+                    (protocolName != NULL ? std::wstring(protocolName) : std::to_wstring(protocol));
+            }
+            default:
+            {
+                GUID ruleId;
+                memcpy(&ruleId, key.bytes, sizeof(ruleId));
+                return FormatGuid(ruleId);
+            }
+            }
+        }
+
+        template <typename T>
+        void AppendValue(T value, _Inout_ std::string* buffer)
+        {
+            buffer->append(reinterpret_cast<const char*>(&value), sizeof(value));
+        }
+
+        void AppendPadding(_Inout_ std::string* buffer)
+        {
+            buffer->append((SKETCH_ALIGNMENT - buffer->size() % SKETCH_ALIGNMENT) % SKETCH_ALIGNMENT, '\0');
+        }
+
+        // Appends the section header; the payload follows, then EndSection().
+        size_t BeginSection(SketchSectionKind kind, unsigned long key, _Inout_ std::string* buffer)
+        {
+            AppendValue(static_cast<uint32_t>(kind), buffer);
+            AppendValue(static_cast<uint32_t>(key), buffer);
+            AppendValue(static_cast<uint64_t>(0), buffer);
+            return buffer->size();
+        }
+
+        void EndSection(size_t payloadOffset, _Inout_ std::string* buffer)
+        {
+            uint64_t payloadLength = buffer->size() - payloadOffset;
+            memcpy(&(*buffer)[payloadOffset - sizeof(payloadLength)], &payloadLength, sizeof(payloadLength));
+            AppendPadding(buffer);
+        }
+
+        template <typename T>
+        T ReadValue(const std::string& data, size_t offset)
+        {
+            if (offset > data.size() ||
+                data.size() - offset < sizeof(T))
+            {
+                throw std::exception("Sketch is truncated.");
+            }
+            T value;
+            memcpy(&value, data.data() + offset, sizeof(T));
+            return value;
+        }
+
+        // Writes next to path first, so readers only ever see a whole file.
+        void WriteFileReplacing(const std::wstring& path, const std::string& data)
+        {
+            std::wstring temporaryPath = path + L".tmp";
+            FILE* file = NULL;
+            errno_t result = _wfopen_s(&file, temporaryPath.c_str(), L"wb");
+            if (result != 0 ||
+                file == NULL)
+            {
+                throw std::exception("Unable to create sketch file.");
+            }
+            bool written = fwrite(data.data(), 1, data.size(), file) == data.size();
+            written = fclose(file) == 0 && written;
+            if (!written ||
+                !::MoveFileExW(temporaryPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+            {
+                ::DeleteFileW(temporaryPath.c_str());
+                throw std::exception("Unable to write sketch file.");
+            }
+        }
+    }
+
+    size_t SketchKeyHash::operator()(const SketchKey& key) const
+    {
+        unsigned long long low = 0, high = 0;
+        memcpy(&low, key.bytes, sizeof(low));
+        memcpy(&high, key.bytes + sizeof(low), sizeof(high));
+        unsigned long long folded = (low ^ (high * 0x9E3779B97F4A7C15ull));
+        folded ^= folded >> 32;
+        return static_cast<size_t>(folded);
+    }
+
+    bool SketchKeyEqual::operator()(const SketchKey& left, const SketchKey& right) const
+    {
+        return memcmp(left.bytes, right.bytes, sizeof(left.bytes)) == 0;
+    }
+
+    //
+    // EventSketch
+    //
+
+    EventSketch::EventSketch(size_t topCapacity)
+        : m_Cardinalities(static_cast<size_t>(SketchCardinality::Count), ntl::HyperLogLog(CardinalityPrecision)),
+        m_TopLists(static_cast<size_t>(SketchTopKeys::Count), SketchTopList(topCapacity)),
+        m_Quantiles(static_cast<size_t>(SketchQuantiles::Count), ntl::TDigest(LagCompression))
+    {
+    }
+
+    void EventSketch::RecordEvent(const CompactEventRecord& record, LONGLONG now)
+    {
+        // Sampled events stand for sampleRate events, as in the other reports.
+        unsigned long events = record.sampleRate;
+        m_Events += events;
+        if (record.action == RuleAction::Allow)
+        {
+            m_AllowEvents += events;
+        }
+        else if (record.action == RuleAction::Deny)
+        {
+            m_DenyEvents += events;
+        }
+
+        m_Cardinalities[static_cast<size_t>(SketchCardinality::Sources)].add(HashAddress(record.source));
+        m_Cardinalities[static_cast<size_t>(SketchCardinality::Destinations)].add(HashAddress(record.destination));
+        m_Cardinalities[static_cast<size_t>(SketchCardinality::Flows)].add(HashFlow(record));
+
+        m_TopLists[static_cast<size_t>(SketchTopKeys::Sources)].add(AddressKey(record.source), events);
+        m_TopLists[static_cast<size_t>(SketchTopKeys::Destinations)].add(AddressKey(record.destination), events);
+        m_TopLists[static_cast<size_t>(SketchTopKeys::DestinationPorts)].add(PortKey(record.protocol, record.destinationPort), events);
+        m_TopLists[static_cast<size_t>(SketchTopKeys::Rules)].add(RuleKey(record.ruleId), events);
+
+        // Clock adjustments can make an event appear to come from the future.
+        m_Quantiles[static_cast<size_t>(SketchQuantiles::LagInMilliseconds)].add(now > record.timeStamp ?
+            static_cast<double>(now - record.timeStamp) / HUNDRED_NS_PER_MILLISECOND :
+            0.0);
+    }
+
+    void EventSketch::SetSnapshot(const std::wstring& host, LONGLONG startTime, LONGLONG endTime)
+    {
+        std::string name;
+        AppendUtf8(host, &name);
+        m_Hosts.assign(1, name);
+        m_StartTime = startTime;
+        m_EndTime = endTime;
+        m_Snapshots = 1;
+    }
+
+    void EventSketch::Merge(const EventSketch& other)
+    {
+        // Checked up front, so a sketch that cannot be merged leaves this one as it was.
+        for (size_t i = 0; i < m_Cardinalities.size(); ++i)
+        {
+            if (m_Cardinalities[i].precision() != other.m_Cardinalities[i].precision())
+            {
+                throw std::exception("Sketch distinct counts were kept at another precision.");
+            }
+        }
+
+        std::vector<std::string> hosts;
+        std::set_union(
+            m_Hosts.begin(), m_Hosts.end(),
+            other.m_Hosts.begin(), other.m_Hosts.end(),
+            std::back_inserter(hosts));
+        m_Hosts.swap(hosts);
+
+        if (other.m_StartTime != 0 &&
+            (m_StartTime == 0 || other.m_StartTime < m_StartTime))
+        {
+            m_StartTime = other.m_StartTime;
+        }
+        m_EndTime = (std::max)(m_EndTime, other.m_EndTime);
+        m_Events += other.m_Events;
+        m_AllowEvents += other.m_AllowEvents;
+        m_DenyEvents += other.m_DenyEvents;
+        m_Snapshots += other.m_Snapshots;
+
+        for (size_t i = 0; i < m_Cardinalities.size(); ++i)
+        {
+            m_Cardinalities[i].merge(other.m_Cardinalities[i]);
+        }
+        for (size_t i = 0; i < m_TopLists.size(); ++i)
+        {
+            m_TopLists[i].merge(other.m_TopLists[i]);
+        }
+        for (size_t i = 0; i < m_Quantiles.size(); ++i)
+        {
+            m_Quantiles[i].merge(other.m_Quantiles[i]);
+        }
+    }
+
+    std::string EventSketch::Serialize() const
+    {
+        const unsigned long sectionCount = static_cast<unsigned long>(
+            1 + m_Cardinalities.size() + m_TopLists.size() + m_Quantiles.size());
+
+        std::string data;
+        data.append(SKETCH_MAGIC, sizeof(SKETCH_MAGIC));
+        AppendValue(static_cast<uint32_t>(SKETCH_VERSION), &data);
+        AppendValue(static_cast<uint32_t>(sectionCount), &data);
+
+        size_t payload = BeginSection(SketchSectionKind::Summary, 0, &data);
+        AppendValue(static_cast<int64_t>(m_StartTime), &data);
+        AppendValue(static_cast<int64_t>(m_EndTime), &data);
+        AppendValue(static_cast<uint64_t>(m_Events), &data);
+        AppendValue(static_cast<uint64_t>(m_AllowEvents), &data);
+        AppendValue(static_cast<uint64_t>(m_DenyEvents), &data);
+        AppendValue(static_cast<uint64_t>(m_Snapshots), &data);
+        AppendValue(static_cast<uint32_t>(m_Hosts.size()), &data);
+        AppendValue(static_cast<uint32_t>(0), &data);
+        for (const auto& host : m_Hosts)
+        {
+            // DNS names are at most 255 bytes.
+            uint16_t length = static_cast<uint16_t>((std::min)(host.size(), static_cast<size_t>(UINT16_MAX)));
+            AppendValue(length, &data);
+            data.append(host.data(), length);
+        }
+        EndSection(payload, &data);
+
+        for (size_t i = 0; i < m_Cardinalities.size(); ++i)
+        {
+            const ntl::HyperLogLog& cardinality = m_Cardinalities[i];
+            payload = BeginSection(SketchSectionKind::Cardinality, static_cast<unsigned long>(i), &data);
+            AppendValue(static_cast<uint8_t>(cardinality.precision()), &data);
+            data.append(7, '\0');
+            const auto& registers = cardinality.register_values();
+            data.append(reinterpret_cast<const char*>(registers.data()), registers.size());
+            EndSection(payload, &data);
+        }
+
+        for (size_t i = 0; i < m_TopLists.size(); ++i)
+        {
+            const SketchTopList& topList = m_TopLists[i];
+            payload = BeginSection(SketchSectionKind::TopKeys, static_cast<unsigned long>(i), &data);
+            AppendValue(static_cast<uint32_t>(topList.capacity()), &data);
+            AppendValue(static_cast<uint32_t>(topList.size()), &data);
+            AppendValue(static_cast<uint64_t>(topList.total()), &data);
+            for (const auto& entry : topList.entry_values())
+            {
+                data.append(reinterpret_cast<const char*>(entry.key.bytes), sizeof(entry.key.bytes));
+                AppendValue(static_cast<uint64_t>(entry.count), &data);
+                AppendValue(static_cast<uint64_t>(entry.error), &data);
+            }
+            EndSection(payload, &data);
+        }
+
+        for (size_t i = 0; i < m_Quantiles.size(); ++i)
+        {
+            const ntl::TDigest& quantiles = m_Quantiles[i];
+            auto centroids = quantiles.centroid_values();
+            payload = BeginSection(SketchSectionKind::Quantiles, static_cast<unsigned long>(i), &data);
+            AppendValue(quantiles.compression_factor(), &data);
+            AppendValue(quantiles.minimum(), &data);
+            AppendValue(quantiles.maximum(), &data);
+            AppendValue(static_cast<uint64_t>(centroids.size()), &data);
+            for (const auto& centroid : centroids)
+            {
+                AppendValue(centroid.first, &data);
+                AppendValue(centroid.second, &data);
+            }
+            EndSection(payload, &data);
+        }
+
+        return data;
+    }
+
+    EventSketch EventSketch::Deserialize(const std::string& data)
+    {
+        if (data.size() < HEADER_BYTES ||
+            memcmp(data.data(), SKETCH_MAGIC, sizeof(SKETCH_MAGIC)) != 0)
+        {
+            throw std::exception("Not a sketch file.");
+        }
+        unsigned long version = ReadValue<uint32_t>(data, 8);
+        if (version == 0 ||
+            version > SKETCH_VERSION)
+        {
+            throw std::exception("Sketch file is of a later version.");
+        }
+        unsigned long sectionCount = ReadValue<uint32_t>(data, 12);
+
+        EventSketch sketch;
+        size_t offset = HEADER_BYTES;
+        for (unsigned long section = 0; section < sectionCount; ++section)
+        {
+            unsigned long kind = ReadValue<uint32_t>(data, offset);
+            unsigned long key = ReadValue<uint32_t>(data, offset + 4);
+            unsigned long long payloadLength = ReadValue<uint64_t>(data, offset + 8);
+            offset += SECTION_HEADER_BYTES;
+            if (payloadLength > data.size() - offset)
+            {
+                throw std::exception("Sketch is truncated.");
+            }
+            sketch.ReadSection(
+                static_cast<SketchSectionKind>(kind),
+                key,
+                data.substr(offset, static_cast<size_t>(payloadLength)));
+            offset += static_cast<size_t>(payloadLength);
+            offset += (SKETCH_ALIGNMENT - offset % SKETCH_ALIGNMENT) % SKETCH_ALIGNMENT;
+        }
+        return sketch;
+    }
+
+    void EventSketch::ReadSection(SketchSectionKind kind, unsigned long key, const std::string& payload)
+    {
+        switch (kind)
+        {
+        case SketchSectionKind::Summary:
+        {
+            m_StartTime = ReadValue<int64_t>(payload, 0);
+            m_EndTime = ReadValue<int64_t>(payload, 8);
+            m_Events = ReadValue<uint64_t>(payload, 16);
+            m_AllowEvents = ReadValue<uint64_t>(payload, 24);
+            m_DenyEvents = ReadValue<uint64_t>(payload, 32);
+            m_Snapshots = ReadValue<uint64_t>(payload, 40);
+            unsigned long hostCount = ReadValue<uint32_t>(payload, 48);
+            size_t offset = 56;
+            m_Hosts.clear();
+            for (unsigned long host = 0; host < hostCount; ++host)
+            {
+                uint16_t length = ReadValue<uint16_t>(payload, offset);
+                offset += sizeof(length);
+                if (length > payload.size() - offset)
+                {
+                    throw std::exception("Sketch is truncated.");
+                }
+                m_Hosts.push_back(payload.substr(offset, length));
+                offset += length;
+            }
+            // Kept sorted and distinct, whatever the writer did.
+            std::sort(m_Hosts.begin(), m_Hosts.end());
+            m_Hosts.erase(std::unique(m_Hosts.begin(), m_Hosts.end()), m_Hosts.end());
+            break;
+        }
+
+        case SketchSectionKind::Cardinality:
+        {
+            if (key >= m_Cardinalities.size())
+            {
+                break;
+            }
+            unsigned precision = ReadValue<uint8_t>(payload, 0);
+            if (precision < ntl::HyperLogLog::minimum_precision ||
+                precision > ntl::HyperLogLog::maximum_precision)
+            {
+                throw std::exception("Sketch distinct count precision is out of range.");
+            }
+            size_t registers = static_cast<size_t>(1) << precision;
+            if (payload.size() < 8 + registers)
+            {
+                throw std::exception("Sketch is truncated.");
+            }
+            ntl::HyperLogLog cardinality(precision);
+            cardinality.load_registers(reinterpret_cast<const unsigned char*>(payload.data()) + 8, registers);
+            m_Cardinalities[key] = cardinality;
+            break;
+        }
+
+        case SketchSectionKind::TopKeys:
+        {
+            if (key >= m_TopLists.size())
+            {
+                break;
+            }
+            unsigned long capacity = ReadValue<uint32_t>(payload, 0);
+            unsigned long entryCount = ReadValue<uint32_t>(payload, 4);
+            unsigned long long total = ReadValue<uint64_t>(payload, 8);
+            if (capacity == 0 ||
+                capacity > MAX_TOP_CAPACITY ||
+                entryCount > capacity)
+            {
+                throw std::exception("Sketch top list size is out of range.");
+            }
+            if (payload.size() < 16 + static_cast<size_t>(entryCount) * TOP_ENTRY_BYTES)
+            {
+                throw std::exception("Sketch is truncated.");
+            }
+            std::vector<SketchTopList::entry> entries(entryCount);
+            size_t offset = 16;
+            for (auto& entry : entries)
+            {
+                memcpy(entry.key.bytes, payload.data() + offset, sizeof(entry.key.bytes));
+                entry.count = ReadValue<uint64_t>(payload, offset + 16);
+                entry.error = ReadValue<uint64_t>(payload, offset + 24);
+                offset += TOP_ENTRY_BYTES;
+            }
+            SketchTopList topList(capacity);
+            topList.load(std::move(entries), total);
+            m_TopLists[key] = std::move(topList);
+            break;
+        }
+
+        case SketchSectionKind::Quantiles:
+        {
+            if (key >= m_Quantiles.size())
+            {
+                break;
+            }
+            double compression = ReadValue<double>(payload, 0);
+            double minimum = ReadValue<double>(payload, 8);
+            double maximum = ReadValue<double>(payload, 16);
+            unsigned long long centroidCount = ReadValue<uint64_t>(payload, 24);
+            if (!(compression >= MIN_COMPRESSION && compression <= MAX_COMPRESSION))
+            {
+                throw std::exception("Sketch quantile compression is out of range.");
+            }
+            if (centroidCount > (payload.size() - 32) / (2 * sizeof(double)))
+            {
+                throw std::exception("Sketch is truncated.");
+            }
+            std::vector<std::pair<double, double>> centroids(static_cast<size_t>(centroidCount));
+            size_t offset = 32;
+            for (auto& centroid : centroids)
+            {
+                centroid.first = ReadValue<double>(payload, offset);
+                centroid.second = ReadValue<double>(payload, offset + 8);
+                offset += 2 * sizeof(double);
+            }
+            ntl::TDigest quantiles(compression);
+            quantiles.merge_centroids(centroids, minimum, maximum);
+            m_Quantiles[key] = std::move(quantiles);
+            break;
+        }
+
+        default:
+            // Written by a later version; nothing this one can use.
+            break;
+        }
+    }
+
+    void EventSketch::WriteFile(const std::wstring& path) const
+    {
+        WriteFileReplacing(path, Serialize());
+    }
+
+    EventSketch EventSketch::ReadFile(const std::wstring& path)
+    {
+        FILE* file = NULL;
+        errno_t result = _wfopen_s(&file, path.c_str(), L"rb");
+        if (result != 0 ||
+            file == NULL)
+        {
+            throw std::exception("Unable to open sketch file.");
+        }
+
+        std::string data;
+        char buffer[64 * 1024];
+        size_t read = 0;
+        while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        {
+            data.append(buffer, read);
+        }
+        bool failed = ferror(file) != 0;
+        fclose(file);
+        if (failed)
+        {
+            throw std::exception("Unable to read sketch file.");
+        }
+        return Deserialize(data);
+    }
+
+    const std::vector<std::string>& EventSketch::GetHosts() const
+    {
+        return m_Hosts;
+    }
+
+    LONGLONG EventSketch::GetStartTime() const
+    {
+        return m_StartTime;
+    }
+
+    LONGLONG EventSketch::GetEndTime() const
+    {
+        return m_EndTime;
+    }
+
+    unsigned long long EventSketch::GetEventCount() const
+    {
+        return m_Events;
+    }
+
+    unsigned long long EventSketch::GetAllowEventCount() const
+    {
+        return m_AllowEvents;
+    }
+
+    unsigned long long EventSketch::GetDenyEventCount() const
+    {
+        return m_DenyEvents;
+    }
+
+    unsigned long long EventSketch::GetSnapshotCount() const
+    {
+        return m_Snapshots;
+    }
+
+    double EventSketch::EstimateDistinct(SketchCardinality cardinality) const
+    {
+        return GetCardinality(cardinality).estimate();
+    }
+
+    const ntl::HyperLogLog& EventSketch::GetCardinality(SketchCardinality cardinality) const
+    {
+        return m_Cardinalities[static_cast<size_t>(cardinality)];
+    }
+
+    const SketchTopList& EventSketch::GetTopList(SketchTopKeys topKeys) const
+    {
+        return m_TopLists[static_cast<size_t>(topKeys)];
+    }
+
+    std::vector<SketchTopEntry> EventSketch::GetTop(SketchTopKeys topKeys, size_t count) const
+    {
+        std::vector<SketchTopEntry> top;
+        for (const auto& entry : GetTopList(topKeys).top(count))
+        {
+            SketchTopEntry row;
+            row.name = FormatKey(topKeys, entry.key);
+            row.events = entry.count;
+            row.error = entry.error;
+            top.push_back(row);
+        }
+        return top;
+    }
+
+    const ntl::TDigest& EventSketch::GetQuantiles(SketchQuantiles quantiles) const
+    {
+        return m_Quantiles[static_cast<size_t>(quantiles)];
+    }
+
+    //
+    // SketchRecorder
+    //
+
+    SketchRecorder::SketchRecorder(
+        const std::wstring& directory,
+        const std::wstring& host,
+        unsigned long intervalInSeconds,
+        LONGLONG startTime)
+        : m_Directory(directory),
+        m_Host(host),
+        m_Interval(static_cast<LONGLONG>(intervalInSeconds) * HUNDRED_NS_PER_SECOND),
+        m_Sketch(std::make_unique<EventSketch>()),
+        m_IntervalStart(startTime)
+    {
+        ::InitializeCriticalSectionEx(&m_CriticalSection, 4000, 0);
+    }
+
+    SketchRecorder::~SketchRecorder()
+    {
+        ::DeleteCriticalSection(&m_CriticalSection);
+    }
+
+    void SketchRecorder::RecordEvent(const CompactEventRecord& record, LONGLONG now)
+    {
+        ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+        m_Sketch->RecordEvent(record, now);
+    }
+
+    bool SketchRecorder::WriteIfDue(LONGLONG now)
+    {
+        if (now - m_IntervalStart < m_Interval)
+        {
+            return false;
+        }
+        Write(now);
+        return true;
+    }
+
+    std::wstring SketchRecorder::Write(LONGLONG now)
+    {
+        // Allocated before taking the lock, so the ETW thread only waits for the swap.
+        auto sketch = std::make_unique<EventSketch>();
+        {
+            ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+            m_Sketch.swap(sketch);
+        }
+        LONGLONG startTime = m_IntervalStart;
+        m_IntervalStart = now;
+
+        // Written even without events, so the fleet report can tell a quiet host from a missing one.
+        sketch->SetSnapshot(m_Host, startTime, now);
+        std::wstring path = m_Directory + L"\\" + FileName(m_Host, startTime);
+        try
+        {
+            std::string data = sketch->Serialize();
+            WriteFileReplacing(path, data);
+            ++m_SnapshotsWritten;
+            m_BytesWritten += data.size();
+            return path;
+        }
+        catch (const std::exception& ex)
+        {
+            ++m_WriteFailures;
+            wprintf(L"Warning: Unable to write sketch %ls: %S.\n", path.c_str(), ex.what());
+            return std::wstring();
+        }
+    }
+
+    unsigned long long SketchRecorder::GetSnapshotsWritten() const
+    {
+        return m_SnapshotsWritten;
+    }
+
+    unsigned long long SketchRecorder::GetBytesWritten() const
+    {
+        return m_BytesWritten;
+    }
+
+    unsigned long long SketchRecorder::GetWriteFailures() const
+    {
+        return m_WriteFailures;
+    }
+
+    std::wstring SketchRecorder::FileName(const std::wstring& host, LONGLONG startTime)
+    {
+        LARGE_INTEGER timeStamp;
+        timeStamp.QuadPart = startTime;
+        std::wstring date, time;
+        Timer::GetDateAndTime(timeStamp, &date, &time);
+
+        // Milliseconds, so an interval cut short (e.g. by the session closing) gets its own name.
+        wchar_t milliseconds[8] = L"";
+        swprintf_s(milliseconds, L"%03lld", (startTime / 10000) % 1000);
+        return host + L"." + date + L"-" + time + L"." + milliseconds + FileExtension;
+    }
+
+    std::wstring SketchRecorder::LocalHostName()
+    {
+        WCHAR name[256] = L"";
+        DWORD length = ARRAYSIZE(name);
+        if (!::GetComputerNameExW(ComputerNameDnsHostname, name, &length) ||
+            length == 0)
+        {
+            return std::wstring(L"localhost");
+        }
+        return std::wstring(name, length);
+    }
+}
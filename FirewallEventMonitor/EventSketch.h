@@ -0,0 +1,220 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#pragma once
+
+// os headers
+#include <winsock2.h>
+// c++ headers
+#include <memory>
+#include <string>
+#include <vector>
+// ntl headers
+#include "ntlHeavyHitters.hpp"
+#include "ntlHyperLogLog.hpp"
+#include "ntlMath.hpp"
+
+#include "CompactEventRecord.h"
+
+namespace FirewallEventMonitor
+{
+    //
+    // Event sketch file (-Sketch <directory>), version 1.
+    //
+    // A sketch summarizes the events of one host over one interval in bounded space: event
+    // counts, the busiest keys, distinct counts and the delivery lag distribution. Sketches of
+    // any hosts and intervals merge into a sketch of the same form (-MergeSketches), so fleet
+    // reports never need the events themselves. All integers and doubles are little endian.
+    //
+    //   File        := Header Section*
+    //   Header      := magic "FEMSKCH1" | version u32 | sectionCount u32
+    //   Section     := kind u32 | key u32 | payloadLength u64 | payload | pad to 8
+    //
+    // Section kinds:
+    //   Summary     := startTime i64 | endTime i64 | events u64 | allowEvents u64 | denyEvents u64
+    //                  | snapshots u64 | hostCount u32 | reserved u32 | { length u16, name (UTF-8) }[hostCount]
+    //                  Times are FILETIMEs (UTC). Hosts are sorted and distinct.
+    //   Cardinality := precision u8 | reserved u8[7] | registers u8[2^precision]      (ntl::HyperLogLog)
+    //   TopKeys     := capacity u32 | entryCount u32 | total u64 | { key u8[16], count u64, error u64 }[entryCount]
+    //                  (ntl::HeavyHitters) Keys are addresses (IPv4 stored v4-mapped), rule ids
+    //                  (GUIDs in memory layout), or protocol << 16 | port as a u32 followed by zeros.
+    //   Quantiles   := compression f64 | minimum f64 | maximum f64 | centroidCount u64
+    //                  | { mean f64, weight f64 }[centroidCount]                      (ntl::TDigest)
+    //
+    // A section's key says which sketch of its kind it holds (SketchCardinality, SketchTopKeys
+    // or SketchQuantiles). Readers skip sections whose kind or key they do not know, so new
+    // sketches are added without changing the version. The version changes only if a section's
+    // layout changes, or the hashes feeding the cardinalities do: sketches built with different
+    // hashes cannot be merged.
+    //
+    // Event counts are scaled up by each event's sample rate, like the other reports; the
+    // distinct counts and the lag are of the events kept.
+    //
+    enum class SketchSectionKind : unsigned long { Summary = 1, Cardinality = 2, TopKeys = 3, Quantiles = 4 };
+
+    enum class SketchCardinality : unsigned long { Sources, Destinations, Flows, Count };
+
+    enum class SketchTopKeys : unsigned long { Sources, Destinations, DestinationPorts, Rules, Count };
+
+    enum class SketchQuantiles : unsigned long { LagInMilliseconds, Count };
+
+    // Key of a top list entry: an address, a rule id, or a port (see the layout above).
+    struct SketchKey
+    {
+    public:
+        unsigned char bytes[16];
+    };
+
+    struct SketchKeyHash
+    {
+        size_t operator()(const SketchKey& key) const;
+    };
+
+    struct SketchKeyEqual
+    {
+        bool operator()(const SketchKey& left, const SketchKey& right) const;
+    };
+
+    // One row of a top list, formatted.
+    struct SketchTopEntry
+    {
+    public:
+        std::wstring name;
+        unsigned long long events = 0; // Events counted for the key; at most error above the true count.
+        unsigned long long error = 0;
+    };
+
+    typedef ntl::HeavyHitters<SketchKey, SketchKeyHash, SketchKeyEqual> SketchTopList;
+
+    // Mergeable summary of events: see the file layout above.
+    class EventSketch
+    {
+    public:
+        EventSketch(size_t topCapacity = DefaultTopCapacity);
+
+        // now is the FILETIME at which the event was processed, for its delivery lag.
+        void RecordEvent(const CompactEventRecord& record, LONGLONG now);
+
+        // Counts the sketch as one snapshot of the host, covering startTime to endTime (FILETIMEs).
+        void SetSnapshot(const std::wstring& host, LONGLONG startTime, LONGLONG endTime);
+
+        // Adds the events summarized by another sketch: counts and hosts add up, the interval
+        // grows to cover both, and the busiest keys, distinct counts and lag merge.
+        // Throws if the other sketch's distinct counts were kept at another precision.
+        void Merge(const EventSketch& other);
+
+        // The sketch in the file layout above.
+        std::string Serialize() const;
+
+        // Throws if the data is not a sketch, is truncated, or is of a later version.
+        static EventSketch Deserialize(const std::string& data);
+
+        // Writes the sketch next to path and renames it into place, so a reader never sees
+        // part of a sketch. Throws if it cannot be written.
+        void WriteFile(const std::wstring& path) const;
+
+        // Throws if the file cannot be read or is not a sketch.
+        static EventSketch ReadFile(const std::wstring& path);
+
+        // Host names (UTF-8), sorted and distinct.
+        const std::vector<std::string>& GetHosts() const;
+
+        LONGLONG GetStartTime() const;
+
+        LONGLONG GetEndTime() const;
+
+        unsigned long long GetEventCount() const;
+
+        unsigned long long GetAllowEventCount() const;
+
+        unsigned long long GetDenyEventCount() const;
+
+        // Host intervals summarized: 1 for a host's sketch, the sum of them once merged.
+        unsigned long long GetSnapshotCount() const;
+
+        double EstimateDistinct(SketchCardinality cardinality) const;
+
+        const ntl::HyperLogLog& GetCardinality(SketchCardinality cardinality) const;
+
+        const SketchTopList& GetTopList(SketchTopKeys topKeys) const;
+
+        // The busiest keys of a top list, most events first.
+        std::vector<SketchTopEntry> GetTop(SketchTopKeys topKeys, size_t count) const;
+
+        const ntl::TDigest& GetQuantiles(SketchQuantiles quantiles) const;
+
+        // Constants
+        static const size_t DefaultTopCapacity = 256; // Entries per top list.
+        static const unsigned CardinalityPrecision = 14; // 16 KB per distinct count, ~0.8% error.
+        static constexpr double LagCompression = 100.0;
+
+    private:
+        std::vector<std::string> m_Hosts;
+        LONGLONG m_StartTime = 0;
+        LONGLONG m_EndTime = 0;
+        unsigned long long m_Events = 0;
+        unsigned long long m_AllowEvents = 0;
+        unsigned long long m_DenyEvents = 0;
+        unsigned long long m_Snapshots = 0;
+        std::vector<ntl::HyperLogLog> m_Cardinalities; // Indexed by SketchCardinality.
+        std::vector<SketchTopList> m_TopLists; // Indexed by SketchTopKeys.
+        std::vector<ntl::TDigest> m_Quantiles; // Indexed by SketchQuantiles.
+
+        void ReadSection(SketchSectionKind kind, unsigned long key, const std::string& payload);
+    };
+
+    // Writes a host's sketch of each interval to a new file in a directory (-Sketch).
+    // Events are recorded on the ETW thread; the files are written by the session's checks,
+    // which swap in a new sketch under the lock and write the old one after releasing it.
+    class SketchRecorder
+    {
+    public:
+        // startTime is the FILETIME the first interval starts at.
+        SketchRecorder(
+            const std::wstring& directory,
+            const std::wstring& host,
+            unsigned long intervalInSeconds,
+            LONGLONG startTime);
+
+        ~SketchRecorder();
+
+        void RecordEvent(const CompactEventRecord& record, LONGLONG now);
+
+        // Writes the interval's sketch if the interval has passed by now (a FILETIME).
+        // Returns true if it was due.
+        bool WriteIfDue(LONGLONG now);
+
+        // Writes the interval's sketch, ending it at now, and starts the next interval.
+        // Returns the path written, or an empty string (after a warning) if it could not be.
+        std::wstring Write(LONGLONG now);
+
+        unsigned long long GetSnapshotsWritten() const;
+
+        unsigned long long GetBytesWritten() const;
+
+        unsigned long long GetWriteFailures() const;
+
+        // <host>.<yyyyMMdd>-<HHmmss>.<milliseconds>.sketch, from the interval's start (UTC).
+        static std::wstring FileName(const std::wstring& host, LONGLONG startTime);
+
+        // DNS name of this host, or "localhost" if it has none.
+        static std::wstring LocalHostName();
+
+        // Constants
+        static constexpr const wchar_t* FileExtension = L".sketch";
+
+        SketchRecorder(SketchRecorder const&) = delete;
+        SketchRecorder& operator=(SketchRecorder const&) = delete;
+    private:
+        CRITICAL_SECTION m_CriticalSection; // Guards m_Sketch.
+        const std::wstring m_Directory;
+        const std::wstring m_Host;
+        const LONGLONG m_Interval; // 100ns units.
+        std::unique_ptr<EventSketch> m_Sketch;
+        // Only touched by the writing thread.
+        LONGLONG m_IntervalStart;
+        unsigned long long m_SnapshotsWritten = 0;
+        unsigned long long m_BytesWritten = 0;
+        unsigned long long m_WriteFailures = 0;
+    };
+}
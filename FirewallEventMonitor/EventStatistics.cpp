@@ -0,0 +1,131 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include "EventStatistics.h"
+
+// ntl headers
+#include "ntlLocks.hpp"
+
+namespace FirewallEventMonitor
+{
+    const LONGLONG HUNDRED_NS_PER_SECOND = 10000000LL;
+    const double HUNDRED_NS_PER_MILLISECOND = 10000.0;
+
+    EventStatistics::EventStatistics()
+        : m_RateAverage(RateSmoothingFactor)
+    {
+        ::InitializeCriticalSectionEx(&m_CriticalSection, 4000, 0);
+    }
+
+    EventStatistics::~EventStatistics()
+    {
+        ::DeleteCriticalSection(&m_CriticalSection);
+    }
+
+    void EventStatistics::RecordEvent(LONGLONG timeStamp, LONGLONG now)
+    {
+        ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+
+        // Clock adjustments can make an event appear to come from the future.
+        double lag = (now > timeStamp) ?
+            static_cast<double>(now - timeStamp) / HUNDRED_NS_PER_MILLISECOND :
+            0.0;
+        m_IntervalLag.add(lag);
+        m_IntervalLagMoments.add(lag);
+        if (lag > m_MaxLagSinceTaken)
+        {
+            m_MaxLagSinceTaken = lag;
+        }
+
+        LONGLONG second = timeStamp / HUNDRED_NS_PER_SECOND;
+        if (m_CurrentSecond == 0)
+        {
+            m_CurrentSecond = second;
+        }
+
+        if (second > m_CurrentSecond)
+        {
+            RecordSecond(m_CurrentSecondCount);
+
+            // Seconds with no events still count towards the rate.
+            LONGLONG idleSeconds = second - m_CurrentSecond - 1;
+            if (idleSeconds > MaxIdleSecondsRecorded)
+            {
+                idleSeconds = MaxIdleSecondsRecorded;
+            }
+            for (LONGLONG i = 0; i < idleSeconds; ++i)
+            {
+                RecordSecond(0.0);
+            }
+
+            m_CurrentSecond = second;
+            m_CurrentSecondCount = 0;
+        }
+
+        // Events delivered slightly out of order are counted in the current second.
+        m_CurrentSecondCount++;
+    }
+
+    void EventStatistics::RecordSecond(double count)
+    {
+        m_Rate.add(count);
+        m_RateAverage.add(count);
+    }
+
+    EventStatisticsSnapshot EventStatistics::TakeIntervalSnapshot()
+    {
+        ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+
+        EventStatisticsSnapshot snapshot = BuildSnapshot(m_IntervalLag, m_IntervalLagMoments);
+
+        m_LifetimeLag.merge(m_IntervalLag);
+        m_LifetimeLagMoments.merge(m_IntervalLagMoments);
+        m_IntervalLag.reset();
+        m_IntervalLagMoments.reset();
+
+        return snapshot;
+    }
+
+    EventStatisticsSnapshot EventStatistics::GetLifetimeSnapshot()
+    {
+        ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+
+        ntl::TDigest lag(m_LifetimeLag);
+        lag.merge(m_IntervalLag);
+        ntl::RunningStatistics lagMoments(m_LifetimeLagMoments);
+        lagMoments.merge(m_IntervalLagMoments);
+
+        return BuildSnapshot(lag, lagMoments);
+    }
+
+    double EventStatistics::TakeMaxLagInMilliseconds()
+    {
+        ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+
+        double maxLag = m_MaxLagSinceTaken;
+        m_MaxLagSinceTaken = 0.0;
+        return maxLag;
+    }
+
+    EventStatisticsSnapshot EventStatistics::BuildSnapshot(
+        const ntl::TDigest& lag,
+        const ntl::RunningStatistics& lagMoments) const
+    {
+        EventStatisticsSnapshot snapshot;
+
+        snapshot.lagSampleCount = lagMoments.count();
+        snapshot.lagMedianInMilliseconds = lag.quantile(0.50);
+        snapshot.lagP90InMilliseconds = lag.quantile(0.90);
+        snapshot.lagP99InMilliseconds = lag.quantile(0.99);
+        snapshot.lagMaxInMilliseconds = lagMoments.maximum();
+        snapshot.lagMeanInMilliseconds = lagMoments.mean();
+        snapshot.lagStandardDeviationInMilliseconds = lagMoments.standard_deviation();
+
+        snapshot.rateAverage = m_RateAverage.mean();
+        snapshot.rateMedian = m_Rate.quantile(0.50);
+        snapshot.rateP99 = m_Rate.quantile(0.99);
+        snapshot.ratePeak = m_Rate.maximum();
+
+        return snapshot;
+    }
+}
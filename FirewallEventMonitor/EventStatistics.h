@@ -0,0 +1,77 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#pragma once
+
+// OS Headers
+#include <Windows.h>
+// ntl headers
+#include "ntlMath.hpp"
+
+namespace FirewallEventMonitor
+{
+    // Summary of the lag and rate estimators at a point in time.
+    struct EventStatisticsSnapshot
+    {
+    public:
+        // Delivery lag: time between the ETW event timestamp and our processing of it.
+        unsigned long long lagSampleCount = 0;
+        double lagMedianInMilliseconds = 0.0;
+        double lagP90InMilliseconds = 0.0;
+        double lagP99InMilliseconds = 0.0;
+        double lagMaxInMilliseconds = 0.0;
+        double lagMeanInMilliseconds = 0.0;
+        double lagStandardDeviationInMilliseconds = 0.0;
+        // Events per second, bucketed by ETW timestamp.
+        double rateAverage = 0.0; // Exponentially weighted.
+        double rateMedian = 0.0;
+        double rateP99 = 0.0;
+        double ratePeak = 0.0;
+    };
+
+    // Constant-memory streaming statistics over accepted events.
+    class EventStatistics
+    {
+    public:
+        EventStatistics();
+
+        ~EventStatistics();
+
+        // timeStamp is the event's FILETIME; now is the FILETIME at which it was processed.
+        void RecordEvent(LONGLONG timeStamp, LONGLONG now);
+
+        // Lag statistics since the previous call (rates are cumulative),
+        // folding the interval into the lifetime totals.
+        EventStatisticsSnapshot TakeIntervalSnapshot();
+
+        EventStatisticsSnapshot GetLifetimeSnapshot();
+
+        // Largest lag recorded since the previous call, for the adaptive sampling control loop.
+        // Independent of TakeIntervalSnapshot().
+        double TakeMaxLagInMilliseconds();
+
+        // Constants
+        static constexpr double RateSmoothingFactor = 0.1; // EWMA weight of the newest second.
+        static const LONGLONG MaxIdleSecondsRecorded = 3600; // Bounds the zero-rate backfill after a gap.
+
+        EventStatistics(EventStatistics const&) = delete;
+        EventStatistics& operator=(EventStatistics const&) = delete;
+    private:
+        CRITICAL_SECTION m_CriticalSection;
+        ntl::TDigest m_IntervalLag;
+        ntl::TDigest m_LifetimeLag;
+        ntl::RunningStatistics m_IntervalLagMoments;
+        ntl::RunningStatistics m_LifetimeLagMoments;
+        ntl::TDigest m_Rate;
+        ntl::ExponentialMovingAverage m_RateAverage;
+        LONGLONG m_CurrentSecond = 0;
+        unsigned long m_CurrentSecondCount = 0;
+        double m_MaxLagSinceTaken = 0.0;
+
+        void RecordSecond(double count);
+
+        EventStatisticsSnapshot BuildSnapshot(
+            const ntl::TDigest& lag,
+            const ntl::RunningStatistics& lagMoments) const;
+    };
+}
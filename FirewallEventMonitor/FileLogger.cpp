@@ -1,114 +1,638 @@
-// Copyright (c) Microsoft Corporation. All rights reserved.
-// Licensed under the MIT License. See License.txt in the project root for license information.
-
-#include "FileLogger.h"
-#include "Timer.h"
-// ntl headers
-#include "ntlString.hpp"
-
-namespace FirewallEventMonitor
-{
-    const LPCWSTR LOG_FILE_PREFIX =
-        L"FirewallEventMonitor";
-
-    FileLogger::FileLogger(const std::wstring &directory)
-        : m_LogDirectory(directory)
-    {
-    }
-
-    FileLogger::~FileLogger()
-    {
-        CloseLogFile();
-    }
-
-    void FileLogger::CreateLogFile()
-    {
-        if (m_LogFile != NULL)
-        {
-            throw std::exception("Log file is in use. Cannot create a new file without closing existing file.");
-        }
-
-        GenerateLogFilePath();
-        auto filePath = GetLogFilePath();
-
-        errno_t result = _wfopen_s(&m_LogFile, filePath.c_str(), L"w");
-
-        if (result != 0 ||
-            m_LogFile == NULL)
-        {
-            std::string errorMessage = "Unable to open log file ";
-            errorMessage += ntl::String::convert_to_string(filePath);
-            throw std::exception(errorMessage.c_str());
-        }
-
-        wprintf(L"\tWriting events to log file: %ls\n", filePath.c_str());
-    }
-
-    void FileLogger::CloseLogFile()
-    {
-        if (m_LogFile == NULL)
-        {
-            return;
-        }
-
-        fclose(m_LogFile);
-        m_LogFile = NULL;
-
-        wprintf(L"\tClosed log file: %ls\n", GetLogFilePath().c_str());
-    }
-
-    const std::wstring& FileLogger::GetLogDirectory()
-    {
-        if (m_LogDirectory.empty())
-        {
-            const DWORD maxLen = MAX_PATH;
-            WCHAR path[MAX_PATH] = L"";
-
-            DWORD len = GetCurrentDirectoryW(maxLen, path);
-
-            if (len == 0)
-            {
-                throw std::exception("Unable to get current directory.");
-            }
-
-            m_LogDirectory.assign(path);
-        }
-
-        return m_LogDirectory;
-    }
-
-    void FileLogger::GenerateLogFilePath()
-    {
-        // Get directory
-        std::wstring filePath(GetLogDirectory());
-        filePath.push_back(L'\\');
-
-        // Add name
-        filePath.append(LOG_FILE_PREFIX);
-
-        // Add timestamp
-        std::wstring date, time;
-        SYSTEMTIME systemTime;
-        GetSystemTime(&systemTime);
-        Timer::GetDateAndTime(systemTime, &date, &time);
-        filePath.push_back(L'.');
-        filePath.append(date);
-        filePath.push_back(L'T'); // ISO 8601
-        filePath.append(time);
-
-        // Add file extension
-        filePath.append(L".log");
-
-        m_LogFilePath = filePath;
-    }
-
-    const std::wstring& FileLogger::GetLogFilePath() const
-    {
-        return m_LogFilePath;
-    }
-
-    FILE* FileLogger::GetLogFile() const
-    {
-        return m_LogFile;
-    }
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include "FileLogger.h"
+#include "Timer.h"
+#include "CompactEventRecord.h"
+// os headers
+#include <io.h>
+// c++ headers
+#include <algorithm>
+// ntl headers
+#include "ntlCrc32.hpp"
+#include "ntlLocks.hpp"
+#include "ntlString.hpp"
+
+namespace FirewallEventMonitor
+{
+    const LPCWSTR LOG_FILE_PREFIX =
+        L"FirewallEventMonitor";
+
+    const char COMMIT_RECORD_PREFIX[] = "#commit ";
+
+    namespace
+    {
+        // Appends text as UTF-8 with CRLF line ends, as a text mode file would write it.
+        void AppendLogText(const std::wstring& text, _Inout_ std::string* bytes)
+        {
+            size_t begin = bytes->size();
+            AppendUtf8(text, bytes);
+            size_t lineEnds = static_cast<size_t>(std::count(bytes->begin() + begin, bytes->end(), '\n'));
+            if (lineEnds == 0)
+            {
+                return;
+            }
+
+            size_t end = bytes->size() + lineEnds;
+            bytes->resize(end);
+            for (size_t from = end - lineEnds; from-- > begin;)
+            {
+                (*bytes)[--end] = (*bytes)[from];
+                if ((*bytes)[from] == '\n')
+                {
+                    (*bytes)[--end] = '\r';
+                }
+            }
+        }
+    }
+
+    FileLogger::FileLogger(const std::wstring &directory)
+        : m_LogDirectory(directory)
+    {
+        ::InitializeCriticalSectionEx(&m_CriticalSection, 4000, 0);
+    }
+
+    FileLogger::~FileLogger()
+    {
+        CloseLogFile();
+        ::DeleteCriticalSection(&m_CriticalSection);
+    }
+
+    void FileLogger::CreateLogFile()
+    {
+        ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+
+        if (m_LogFile != NULL ||
+            m_WriterFile)
+        {
+            throw std::exception("Log file is in use. Cannot create a new file without closing existing file.");
+        }
+
+        GenerateLogFilePath();
+        auto filePath = GetLogFilePath();
+
+        if (m_Mapped ||
+            m_Overlapped)
+        {
+            std::unique_ptr<LogFileWriter> writerFile;
+            try
+            {
+                writerFile = OpenWriterFile(filePath);
+            }
+            catch (const std::exception& ex)
+            {
+                if (!m_Overlapped)
+                {
+                    throw;
+                }
+
+                // Overlapped writes are an optimization; the events are still logged without them.
+                wprintf(L"Warning: Unable to open the log file for overlapped writes (%S); writing through a FILE instead.\n", ex.what());
+                m_Overlapped = false;
+            }
+
+            if (writerFile)
+            {
+                {
+                    ntl::AutoReleaseExclusiveSRWLock lockScoped(&m_WriterFileLock);
+                    m_WriterFile = std::move(writerFile);
+                }
+                return;
+            }
+        }
+
+        // Durable logs are written byte for byte, so the commit records can check them.
+        errno_t result = _wfopen_s(&m_LogFile, filePath.c_str(), m_Durable ? L"wb" : L"w");
+
+        if (result != 0 ||
+            m_LogFile == NULL)
+        {
+            std::string errorMessage = "Unable to open log file ";
+            errorMessage += ntl::String::convert_to_string(filePath);
+            throw std::exception(errorMessage.c_str());
+        }
+
+        // Sinks write many small events; a larger buffer turns them into fewer, larger writes.
+        setvbuf(m_LogFile, NULL, _IOFBF, WriteBufferSizeInBytes);
+
+        m_GroupCrc = 0;
+        m_GroupBytes = 0;
+        m_CommitSequence = 0;
+    }
+
+    void FileLogger::CloseLogFile()
+    {
+        ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+
+        if (m_WriterFile)
+        {
+            std::unique_ptr<LogFileWriter> writerFile;
+            {
+                ntl::AutoReleaseExclusiveSRWLock lockScoped(&m_WriterFileLock);
+                writerFile = std::move(m_WriterFile);
+            }
+            CloseWriterFile(std::move(writerFile));
+            return;
+        }
+
+        if (m_LogFile == NULL)
+        {
+            return;
+        }
+
+        if (m_Durable)
+        {
+            CommitGroup();
+        }
+
+        fclose(m_LogFile);
+        m_LogFile = NULL;
+    }
+
+    void FileLogger::RotateLogFile()
+    {
+        ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+
+        if (!m_WriterFile)
+        {
+            CloseLogFile();
+            CreateLogFile();
+            return;
+        }
+
+        // Writers do not hold the critical section, so the next file is opened before the
+        // current one is taken away from them.
+        GenerateLogFilePath();
+        std::unique_ptr<LogFileWriter> writerFile = OpenWriterFile(GetLogFilePath());
+        {
+            ntl::AutoReleaseExclusiveSRWLock lockScoped(&m_WriterFileLock);
+            m_WriterFile.swap(writerFile);
+        }
+        CloseWriterFile(std::move(writerFile));
+    }
+
+    void FileLogger::Write(const std::wstring& text)
+    {
+        if (m_Mapped ||
+            m_Overlapped)
+        {
+            std::string bytes;
+            AppendLogText(text, &bytes);
+
+            ntl::AutoReleaseSharedSRWLock lockScoped(&m_WriterFileLock);
+            if (m_WriterFile)
+            {
+                m_WriterFile->Append(bytes.data(), bytes.size());
+                return;
+            }
+        }
+
+        ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+
+        if (m_LogFile == NULL)
+        {
+            return;
+        }
+
+        if (!m_Durable)
+        {
+            fputws(text.c_str(), m_LogFile);
+            return;
+        }
+
+        m_Utf8Buffer.clear();
+        AppendLogText(text, &m_Utf8Buffer);
+
+        if (m_GroupBytes == 0)
+        {
+            m_GroupStarted = ::GetTickCount64();
+        }
+        fwrite(m_Utf8Buffer.data(), 1, m_Utf8Buffer.size(), m_LogFile);
+        m_GroupCrc = ntl::Crc32::update(m_GroupCrc, m_Utf8Buffer.data(), m_Utf8Buffer.size());
+        m_GroupBytes += m_Utf8Buffer.size();
+
+        if (m_GroupBytes >= m_CommitBytes ||
+            ::GetTickCount64() - m_GroupStarted >= m_CommitIntervalInMilliseconds)
+        {
+            CommitGroup();
+        }
+    }
+
+    bool FileLogger::IsLogFileOpen() const
+    {
+        ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+
+        return m_LogFile != NULL || m_WriterFile != nullptr;
+    }
+
+    void FileLogger::EnableDurableWrites(
+        DWORD commitIntervalInMilliseconds,
+        size_t commitBytes)
+    {
+        ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+
+        if (m_LogFile != NULL)
+        {
+            throw std::exception("Durable writes must be enabled before the log file is created.");
+        }
+
+        if (m_Mapped)
+        {
+            throw std::exception("Durable writes cannot be combined with mapped writes.");
+        }
+
+        if (m_Overlapped)
+        {
+            throw std::exception("Durable writes cannot be combined with overlapped writes.");
+        }
+
+        m_Durable = true;
+        m_CommitIntervalInMilliseconds = commitIntervalInMilliseconds;
+        m_CommitBytes = (std::max)(commitBytes, static_cast<size_t>(1));
+    }
+
+    bool FileLogger::IsDurable() const
+    {
+        return m_Durable;
+    }
+
+    void FileLogger::EnableMappedWrites(size_t segmentBytes)
+    {
+        ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+
+        if (m_LogFile != NULL ||
+            m_WriterFile)
+        {
+            throw std::exception("Mapped writes must be enabled before the log file is created.");
+        }
+
+        if (m_Durable)
+        {
+            throw std::exception("Mapped writes cannot be combined with durable writes.");
+        }
+
+        if (m_Overlapped)
+        {
+            throw std::exception("Mapped writes cannot be combined with overlapped writes.");
+        }
+
+        m_Mapped = true;
+        m_SegmentBytes = segmentBytes;
+    }
+
+    bool FileLogger::IsMapped() const
+    {
+        return m_Mapped;
+    }
+
+    void FileLogger::EnableOverlappedWrites(
+        size_t bufferBytes,
+        size_t bufferCount)
+    {
+        ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+
+        if (m_LogFile != NULL ||
+            m_WriterFile)
+        {
+            throw std::exception("Overlapped writes must be enabled before the log file is created.");
+        }
+
+        if (m_Durable ||
+            m_Mapped)
+        {
+            throw std::exception("Overlapped writes cannot be combined with durable or mapped writes.");
+        }
+
+        m_Overlapped = true;
+        m_BufferBytes = bufferBytes;
+        m_BufferCount = bufferCount;
+    }
+
+    bool FileLogger::IsOverlapped() const
+    {
+        return m_Overlapped;
+    }
+
+    OverlappedWriteReport FileLogger::GetOverlappedWriteReport() const
+    {
+        ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+
+        OverlappedWriteReport report = m_ClosedFilesReport;
+        if (m_Overlapped &&
+            m_WriterFile)
+        {
+            OverlappedWriteReport current = static_cast<const OverlappedLogFile*>(m_WriterFile.get())->GetReport();
+            report.writesIssued += current.writesIssued;
+            report.bytesCompleted += current.bytesCompleted;
+            report.writeErrors += current.writeErrors;
+            report.bufferWaits += current.bufferWaits;
+            report.writesInFlight = current.writesInFlight;
+        }
+        return report;
+    }
+
+    void FileLogger::CommitIfDue()
+    {
+        if (m_Overlapped)
+        {
+            // Submits a partly filled buffer, so a quiet log still reaches the disk.
+            ntl::AutoReleaseSharedSRWLock lockScoped(&m_WriterFileLock);
+            if (m_WriterFile)
+            {
+                m_WriterFile->Flush();
+            }
+            return;
+        }
+
+        ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+
+        if (m_LogFile != NULL &&
+            m_Durable &&
+            m_GroupBytes > 0 &&
+            ::GetTickCount64() - m_GroupStarted >= m_CommitIntervalInMilliseconds)
+        {
+            CommitGroup();
+        }
+    }
+
+    void FileLogger::Commit()
+    {
+        if (m_Mapped ||
+            m_Overlapped)
+        {
+            ntl::AutoReleaseSharedSRWLock lockScoped(&m_WriterFileLock);
+            if (m_WriterFile)
+            {
+                m_WriterFile->Flush();
+                return;
+            }
+        }
+
+        ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+
+        if (m_LogFile == NULL)
+        {
+            return;
+        }
+
+        if (m_Durable)
+        {
+            CommitGroup();
+        }
+        else
+        {
+            fflush(m_LogFile);
+        }
+    }
+
+    DurabilityReport FileLogger::GetDurabilityReport() const
+    {
+        ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+
+        DurabilityReport report = m_DurabilityReport;
+        report.pendingBytes = m_GroupBytes;
+        return report;
+    }
+
+    void FileLogger::CommitGroup()
+    {
+        if (m_GroupBytes == 0)
+        {
+            return;
+        }
+
+        char record[64];
+        int length = sprintf_s(record, "%s%llu %zu %08lx\r\n",
+            COMMIT_RECORD_PREFIX,
+            m_CommitSequence,
+            m_GroupBytes,
+            m_GroupCrc);
+        fwrite(record, 1, length, m_LogFile);
+
+        // fflush hands the group to the OS; _commit waits until it is on the disk.
+        if (fflush(m_LogFile) != 0 ||
+            _commit(_fileno(m_LogFile)) != 0)
+        {
+            wprintf(L"Warning: Unable to sync log file %ls; events since the last commit may be lost in a crash.\n",
+                m_LogFilePath.c_str());
+        }
+
+        ULONGLONG lag = ::GetTickCount64() - m_GroupStarted;
+        m_DurabilityReport.commits += 1;
+        m_DurabilityReport.bytesCommitted += m_GroupBytes;
+        m_DurabilityReport.lastLagInMilliseconds = lag;
+        m_DurabilityReport.maxLagInMilliseconds = (std::max)(m_DurabilityReport.maxLagInMilliseconds, lag);
+
+        ++m_CommitSequence;
+        m_GroupCrc = 0;
+        m_GroupBytes = 0;
+    }
+
+    void FileLogger::RecoverLastLogFile()
+    {
+        // The names sort by the time they were created.
+        std::wstring pattern = GetLogDirectory() + L"\\" + LOG_FILE_PREFIX + L".*.log";
+        WIN32_FIND_DATAW findData;
+        HANDLE find = ::FindFirstFileW(pattern.c_str(), &findData);
+        if (find == INVALID_HANDLE_VALUE)
+        {
+            return;
+        }
+
+        std::wstring newest;
+        do
+        {
+            if ((findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0 &&
+                newest < findData.cFileName)
+            {
+                newest = findData.cFileName;
+            }
+        } while (::FindNextFileW(find, &findData));
+        ::FindClose(find);
+
+        if (newest.empty())
+        {
+            return;
+        }
+
+        std::wstring path = GetLogDirectory() + L"\\" + newest;
+        unsigned long long removed = RecoverLogFile(path);
+        if (removed > 0)
+        {
+            wprintf(L"\tRecovered log file %ls: removed %llu bytes written after its last commit.\n",
+                path.c_str(),
+                removed);
+        }
+
+        ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+        m_DurabilityReport.tornBytesRemoved += removed;
+    }
+
+    unsigned long long FileLogger::RecoverLogFile(const std::wstring& path)
+    {
+        FILE* file = NULL;
+        if (_wfopen_s(&file, path.c_str(), L"r+b") != 0 ||
+            file == NULL)
+        {
+            wprintf(L"Warning: Unable to open log file %ls to recover it.\n", path.c_str());
+            return 0;
+        }
+
+        // Walks the file line by line, checking each group against the commit record after it.
+        // Recovery stops at the first group that is incomplete or does not match its record.
+        unsigned long long offset = 0;
+        unsigned long long committedEnd = 0;
+        bool foundCommit = false;
+        bool damaged = false;
+        unsigned long groupCrc = 0;
+        unsigned long long groupBytes = 0;
+        unsigned long long nextSequence = 0;
+        std::string chunk;
+        std::string line;
+        chunk.resize(RecoveryReadBytes);
+        size_t read = 0;
+        while (!damaged &&
+            (read = fread(&chunk[0], 1, chunk.size(), file)) > 0)
+        {
+            size_t begin = 0;
+            while (!damaged && begin < read)
+            {
+                const char* lineEnd = static_cast<const char*>(memchr(chunk.data() + begin, '\n', read - begin));
+                size_t end = lineEnd == nullptr ? read : static_cast<size_t>(lineEnd - chunk.data()) + 1;
+                line.append(chunk, begin, end - begin);
+                begin = end;
+                if (lineEnd == nullptr)
+                {
+                    break;
+                }
+
+                if (line.compare(0, sizeof(COMMIT_RECORD_PREFIX) - 1, COMMIT_RECORD_PREFIX) == 0)
+                {
+                    unsigned long long sequence = 0;
+                    unsigned long long bytes = 0;
+                    unsigned long crc = 0;
+                    if (sscanf_s(line.c_str() + sizeof(COMMIT_RECORD_PREFIX) - 1, "%llu %llu %lx", &sequence, &bytes, &crc) == 3 &&
+                        sequence == nextSequence &&
+                        bytes == groupBytes &&
+                        crc == groupCrc)
+                    {
+                        foundCommit = true;
+                        committedEnd = offset + line.size();
+                        ++nextSequence;
+                        groupCrc = 0;
+                        groupBytes = 0;
+                    }
+                    else
+                    {
+                        damaged = true;
+                    }
+                }
+                else
+                {
+                    groupCrc = ntl::Crc32::update(groupCrc, line.data(), line.size());
+                    groupBytes += line.size();
+                }
+                offset += line.size();
+                line.clear();
+            }
+        }
+
+        // A log without commit records was not written in durable mode.
+        _fseeki64(file, 0, SEEK_END);
+        unsigned long long fileSize = static_cast<unsigned long long>(_ftelli64(file));
+        unsigned long long removed = 0;
+        if (foundCommit &&
+            committedEnd < fileSize)
+        {
+            if (_chsize_s(_fileno(file), static_cast<__int64>(committedEnd)) == 0)
+            {
+                removed = fileSize - committedEnd;
+            }
+            else
+            {
+                wprintf(L"Warning: Unable to truncate log file %ls after its last commit.\n", path.c_str());
+            }
+        }
+
+        fclose(file);
+        return removed;
+    }
+
+    const std::wstring& FileLogger::GetLogDirectory()
+    {
+        if (m_LogDirectory.empty())
+        {
+            const DWORD maxLen = MAX_PATH;
+            WCHAR path[MAX_PATH] = L"";
+
+            DWORD len = GetCurrentDirectoryW(maxLen, path);
+
+            if (len == 0)
+            {
+                throw std::exception("Unable to get current directory.");
+            }
+
+            m_LogDirectory.assign(path);
+        }
+
+        return m_LogDirectory;
+    }
+
+    void FileLogger::GenerateLogFilePath()
+    {
+        // Get directory
+        std::wstring filePath(GetLogDirectory());
+        filePath.push_back(L'\\');
+
+        // Add name
+        filePath.append(LOG_FILE_PREFIX);
+
+        // Add timestamp
+        std::wstring date, time;
+        SYSTEMTIME systemTime;
+        GetSystemTime(&systemTime);
+        Timer::GetDateAndTime(systemTime, &date, &time);
+        filePath.push_back(L'.');
+        filePath.append(date);
+        filePath.push_back(L'T'); // ISO 8601
+        filePath.append(time);
+
+        // Add file extension
+        filePath.append(L".log");
+
+        m_LogFilePath = filePath;
+    }
+
+    const std::wstring& FileLogger::GetLogFilePath() const
+    {
+        return m_LogFilePath;
+    }
+
+    FILE* FileLogger::GetLogFile() const
+    {
+        return m_LogFile;
+    }
+
+    std::unique_ptr<LogFileWriter> FileLogger::OpenWriterFile(const std::wstring& path) const
+    {
+        if (m_Overlapped)
+        {
+            return std::make_unique<OverlappedLogFile>(path, m_BufferBytes, m_BufferCount);
+        }
+        return std::make_unique<MappedLogFile>(path, m_SegmentBytes);
+    }
+
+    void FileLogger::CloseWriterFile(std::unique_ptr<LogFileWriter> writerFile)
+    {
+        writerFile->Close();
+
+        if (m_Overlapped)
+        {
+            OverlappedWriteReport report = static_cast<OverlappedLogFile*>(writerFile.get())->GetReport();
+            m_ClosedFilesReport.writesIssued += report.writesIssued;
+            m_ClosedFilesReport.bytesCompleted += report.bytesCompleted;
+            m_ClosedFilesReport.writeErrors += report.writeErrors;
+            m_ClosedFilesReport.bufferWaits += report.bufferWaits;
+        }
+    }
 }
\ No newline at end of file
@@ -1,45 +1,155 @@
-// Copyright (c) Microsoft Corporation. All rights reserved.
-// Licensed under the MIT License. See License.txt in the project root for license information.
-
-#pragma once
-
-// os headers
-#include <winsock2.h>
-// c++ headers
-#include <utility>
-#include <string>
-
-namespace FirewallEventMonitor
-{
-    class FileLogger
-    {
-    public:
-        FileLogger(const std::wstring &directory);
-
-        ~FileLogger();
-
-        void CreateLogFile();
-
-        void CloseLogFile();
-
-        FILE* GetLogFile() const;
-
-        // Returns user-supplied directory or (if blank) the current directory.
-        const std::wstring& GetLogDirectory();
-
-        const std::wstring& GetLogFilePath() const;
-
-        // Constant
-        static const DWORD LogFileLimitInSeconds = 3600; // 1 hour.
-
-        FileLogger(FileLogger const&) = delete;
-        FileLogger& operator=(FileLogger const&) = delete;
-    private:
-        FILE *m_LogFile = NULL;
-        std::wstring m_LogDirectory;
-        std::wstring m_LogFilePath;
-
-        // Appends directory with time-stamped file name.
-        void GenerateLogFilePath();
-    };
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#pragma once
+
+// os headers
+#include <winsock2.h>
+// c++ headers
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <string>
+
+#include "MappedLogFile.h"
+#include "OverlappedLogFile.h"
+
+namespace FirewallEventMonitor
+{
+    // Durable log mode (-Durable) counters, for the statistics.
+    struct DurabilityReport
+    {
+        unsigned long long commits = 0;
+        unsigned long long bytesCommitted = 0;
+        size_t pendingBytes = 0; // Written but not yet committed.
+        ULONGLONG lastLagInMilliseconds = 0; // From the oldest write in the last commit to the end of its sync.
+        ULONGLONG maxLagInMilliseconds = 0;
+        unsigned long long tornBytesRemoved = 0; // Cut from the previous run's log by recovery.
+    };
+
+    class FileLogger
+    {
+    public:
+        FileLogger(const std::wstring &directory);
+
+        ~FileLogger();
+
+        void CreateLogFile();
+
+        void CloseLogFile();
+
+        // Closes the current file and creates the next one, without a gap in which
+        // Write() could find no file open.
+        void RotateLogFile();
+
+        // Writes text to the open file; safe to call while another thread rotates it.
+        // Text written while no file is open is discarded.
+        void Write(const std::wstring& text);
+
+        bool IsLogFileOpen() const;
+
+        // Durable mode: writes are grouped and each group is synced to disk once
+        // commitIntervalInMilliseconds has passed since its first write, or once it holds
+        // commitBytes, whichever comes first. The file is written as UTF-8, and each group is
+        // followed by a commit record line: "#commit <sequence> <bytes> <crc32>". A crash loses
+        // at most the groups not yet committed. Call before CreateLogFile().
+        void EnableDurableWrites(
+            DWORD commitIntervalInMilliseconds,
+            size_t commitBytes);
+
+        bool IsDurable() const;
+
+        // Commits the current group if its interval has passed. Called from the main loop,
+        // so a group is committed on time even when no more events arrive.
+        void CommitIfDue();
+
+        // Syncs everything written so far. In mapped mode, starts writing it to disk.
+        void Commit();
+
+        DurabilityReport GetDurabilityReport() const;
+
+        // Mapped mode: log files are written through a MappedLogFile of segmentBytes segments,
+        // as UTF-8. Writes from several threads go ahead at the same time; rotation only holds
+        // them up while the new file is swapped in. Not with durable mode. Call before CreateLogFile().
+        void EnableMappedWrites(size_t segmentBytes);
+
+        bool IsMapped() const;
+
+        // Overlapped mode: log files are written as UTF-8 through an OverlappedLogFile of
+        // bufferCount buffers of bufferBytes each, which CommitIfDue() submits even when not
+        // full. If the file cannot be opened for overlapped writes, the logger warns and
+        // writes through a FILE instead. Not with durable or mapped mode. Call before CreateLogFile().
+        void EnableOverlappedWrites(
+            size_t bufferBytes,
+            size_t bufferCount);
+
+        // False once the logger has fallen back to a FILE.
+        bool IsOverlapped() const;
+
+        // Totals over every log file written in overlapped mode.
+        OverlappedWriteReport GetOverlappedWriteReport() const;
+
+        // Truncates the newest log in the directory after its last intact commit record,
+        // removing a tail torn by a crash. Logs without commit records are left alone.
+        void RecoverLastLogFile();
+
+        // Returns the number of bytes removed from the end of path.
+        static unsigned long long RecoverLogFile(const std::wstring& path);
+
+        // Null in mapped and overlapped mode.
+        FILE* GetLogFile() const;
+
+        // Returns user-supplied directory or (if blank) the current directory.
+        const std::wstring& GetLogDirectory();
+
+        const std::wstring& GetLogFilePath() const;
+
+        // Constant
+        static const DWORD LogFileLimitInSeconds = 3600; // 1 hour.
+        static const size_t WriteBufferSizeInBytes = 64 * 1024;
+        static const DWORD DefaultCommitIntervalInMilliseconds = 200;
+        static const size_t DefaultCommitBytes = 1024 * 1024;
+        static const size_t RecoveryReadBytes = 1024 * 1024;
+
+        FileLogger(FileLogger const&) = delete;
+        FileLogger& operator=(FileLogger const&) = delete;
+    private:
+        mutable CRITICAL_SECTION m_CriticalSection; // Guards m_LogFile, m_LogFilePath and the durable mode state.
+        FILE *m_LogFile = NULL;
+        std::wstring m_LogDirectory;
+        std::wstring m_LogFilePath;
+        // Durable mode; guarded by m_CriticalSection.
+        bool m_Durable = false;
+        DWORD m_CommitIntervalInMilliseconds = DefaultCommitIntervalInMilliseconds;
+        size_t m_CommitBytes = DefaultCommitBytes;
+        std::string m_Utf8Buffer; // Reused to encode each write.
+        unsigned long m_GroupCrc = 0;
+        size_t m_GroupBytes = 0;
+        ULONGLONG m_GroupStarted = 0; // When the first write of the current group was made.
+        unsigned long long m_CommitSequence = 0; // Restarts with each file.
+        DurabilityReport m_DurabilityReport;
+        // Mapped and overlapped mode. m_WriterFile is replaced with both m_CriticalSection and
+        // m_WriterFileLock held exclusive; Write() only takes m_WriterFileLock shared.
+        bool m_Mapped = false;
+        size_t m_SegmentBytes = MappedLogFile::DefaultSegmentBytes;
+        std::atomic<bool> m_Overlapped{ false };
+        size_t m_BufferBytes = OverlappedLogFile::DefaultBufferBytes;
+        size_t m_BufferCount = OverlappedLogFile::DefaultBufferCount;
+        OverlappedWriteReport m_ClosedFilesReport; // Overlapped files already closed; guarded by m_CriticalSection.
+        SRWLOCK m_WriterFileLock = SRWLOCK_INIT;
+        std::unique_ptr<LogFileWriter> m_WriterFile;
+
+        // Writes the commit record for the current group and syncs the file.
+        // Called with m_CriticalSection held.
+        void CommitGroup();
+
+        // Opens path as a MappedLogFile or an OverlappedLogFile, per the mode.
+        std::unique_ptr<LogFileWriter> OpenWriterFile(const std::wstring& path) const;
+
+        // Closes a writer file taken out of m_WriterFile. Called with m_CriticalSection held.
+        void CloseWriterFile(std::unique_ptr<LogFileWriter> writerFile);
+
+        // Appends directory with time-stamped file name.
+        void GenerateLogFilePath();
+    };
 }
\ No newline at end of file
@@ -0,0 +1,40 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include "FileSink.h"
+
+namespace FirewallEventMonitor
+{
+    FileSink::FileSink(
+        std::shared_ptr<FileLogger> fileLogger,
+        EventFormat format,
+        size_t maxQueuedEvents)
+        : QueuedEventSink(maxQueuedEvents),
+        m_FileLogger(fileLogger),
+        m_Format(format)
+    {
+    }
+
+    FileSink::~FileSink()
+    {
+        Stop();
+    }
+
+    LPCWSTR FileSink::GetName() const
+    {
+        return L"File";
+    }
+
+    EventFormat FileSink::GetFormat() const
+    {
+        return m_Format;
+    }
+
+    void FileSink::WriteBatch(const std::vector<EncodedEvent>& events)
+    {
+        for (const auto& event : events)
+        {
+            m_FileLogger->Write(*event);
+        }
+    }
+}
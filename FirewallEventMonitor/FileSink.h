@@ -0,0 +1,41 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#pragma once
+
+// c++ headers
+#include <memory>
+#include <vector>
+
+#include "EventSink.h"
+#include "FileLogger.h"
+
+namespace FirewallEventMonitor
+{
+    // Writes encoded events to the log file from the sink's worker thread.
+    // The file logger serializes writes with rotation, so the log can be rotated
+    // on the main thread while events are being written.
+    class FileSink : public QueuedEventSink
+    {
+    public:
+        FileSink(
+            std::shared_ptr<FileLogger> fileLogger,
+            EventFormat format,
+            size_t maxQueuedEvents = DefaultMaxQueuedEvents);
+
+        ~FileSink() override;
+
+        LPCWSTR GetName() const override;
+
+        EventFormat GetFormat() const override;
+
+        FileSink(FileSink const&) = delete;
+        FileSink& operator=(FileSink const&) = delete;
+    protected:
+        void WriteBatch(const std::vector<EncodedEvent>& events) override;
+
+    private:
+        std::shared_ptr<FileLogger> m_FileLogger;
+        const EventFormat m_Format;
+    };
+}
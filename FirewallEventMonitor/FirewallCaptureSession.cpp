@@ -1,220 +1,973 @@
-// Copyright (c) Microsoft Corporation. All rights reserved.
-// Licensed under the MIT License. See License.txt in the project root for license information.
-
-#include "FirewallCaptureSession.h"
-
-namespace FirewallEventMonitor
-{
-    const GUID VFP_PROVIDER_GUID = {
-        0x9F2660EA,
-        0xCFE7,
-        0x428F,
-        { 0x98, 0x50, 0xAE, 0xCA, 0x61, 0x26, 0x19, 0xB0 } };
-
-    const LPCWSTR TRACE_SESSION_NAME_PREFIX =
-        L"FirewallEventCaptureSession";
-
-    FirewallCaptureSession::FirewallCaptureSession()
-        : FirewallCaptureSession(Parameters{})
-    {
-    }
-
-    FirewallCaptureSession::FirewallCaptureSession(const Parameters &params)
-        : FirewallCaptureSession(
-            params,
-            std::make_shared<FileLogger>(params.logDirectory),
-            std::make_shared<Timer>(params.maxRuntimeInSeconds, params.noTimeout),
-            std::make_shared<EventCounter>(params.maxEventsPerEpoc))
-    {
-    }
-
-    FirewallCaptureSession::FirewallCaptureSession(
-        const Parameters &params,
-        std::shared_ptr<FileLogger> fileLogger,
-        std::shared_ptr<Timer> timer,
-        std::shared_ptr<EventCounter> eventCounter)
-        : m_CaptureSessionRunning(false),
-        m_FileLogger(fileLogger),
-        m_Parameters(params),
-        m_Timer(timer),
-        m_EventCounter(eventCounter)
-    {
-        m_ProviderGuids.push_back(VFP_PROVIDER_GUID);
-
-        GenerateTraceSessionName();
-    }
-
-    FirewallCaptureSession::~FirewallCaptureSession()
-    {
-        CloseSession();
-    }
-
-    void FirewallCaptureSession::GenerateTraceSessionName()
-    {
-        m_TraceSessionName = TRACE_SESSION_NAME_PREFIX;
-
-        // Randomly generate a UUID for the TraceSession name and guid.
-        // This prevents collisions, allowing multiple instances of FirewallEventMontior to run simultaneously.
-        UUID uuid;
-        RPC_STATUS uuidcreate_status = UuidCreate(&uuid);
-        if (uuidcreate_status == RPC_S_OK)
-        {
-            m_TraceSessionGuid = uuid;
-
-            // convert UUID to wstring
-            WCHAR* wszUuid = NULL;
-            RPC_STATUS uuidtostring_status = UuidToStringW(&uuid, (RPC_WSTR*)&wszUuid);
-            // Make sure to free wszUuid
-            std::unique_ptr<WCHAR, ntl::WCharDeleter> free_string(wszUuid);
-
-            if (uuidtostring_status == RPC_S_OK &&
-                wszUuid != NULL)
-            {
-                m_TraceSessionName += L".";
-                m_TraceSessionName += wszUuid;
-            }
-            else
-            {
-                throw std::exception("Unable to convert UUID to wstring.");
-            }
-        }
-        else
-        {
-            throw std::exception("Unable to create UUID.");
-        }
-    }
-
-    void FirewallCaptureSession::OpenSession()
-    {
-        m_EtwReader = std::make_unique<ntl::EtwReader<FirewallEtwTraceCallback>>(
-            FirewallEtwTraceCallback(
-                shared_from_this(),
-                m_Parameters,
-                m_FileLogger,
-                m_Timer,
-                m_EventCounter));
-        // NULL szFileName to not create a file.
-        m_EtwReader->StartSession(m_TraceSessionName.c_str(), NULL, m_TraceSessionGuid);
-        m_EtwReader->EnableProviders(m_ProviderGuids);
-        m_CaptureSessionRunning = true;
-        // Timer
-        m_Timer->SetEpocStart();
-        // Log
-        if (m_Parameters.outputToFile)
-        {
-            m_FileLogger->CreateLogFile();
-            m_Timer->SetLogCreated();
-        }
-    }
-
-    void FirewallCaptureSession::CloseSession() try
-    {
-        if (!m_CaptureSessionRunning)
-        {
-            return;
-        }
-
-        // Log
-        if (m_Parameters.outputToFile)
-        {
-            m_FileLogger->CloseLogFile();
-        }
-
-        if (!m_EtwReader)
-        {
-            wprintf(L"Error: Event reader not defined.\n");
-            return;
-        }
-
-        m_EtwReader->DisableProviders(m_ProviderGuids);
-        m_EtwReader->StopSession();
-        m_CaptureSessionRunning = false;
-
-        wprintf(L"FirewallEventWatcher ran for %.2f seconds. Captured %d events.\n",
-            m_Timer->GetTimeElapsedSinceStartInSeconds(),
-            m_EventCounter->GetEventCountTotal());
-    }
-    catch (const std::exception &ex)
-    {
-        wprintf(L"Error: DisableProviders raised exception: %S.\n", ex.what());
-    }
-
-    bool FirewallCaptureSession::CaptureSessionRunning() const
-    {
-        return m_CaptureSessionRunning;
-    }
-
-    bool FirewallCaptureSession::TimeLimitReached() const
-    {
-        return m_Timer->TimeLimitReached();
-    }
-
-    double FirewallCaptureSession::GetTimeRemainingInEpoc() const
-    {
-        // Sleep for remainder of the epoc (1 second)
-        double timeSpentInSeconds = m_Timer->GetTimeElapsedThisEpocInSeconds();
-        double timeSpentInMilliseconds = (timeSpentInSeconds * 1000);
-        double remainingTime = FirewallCaptureSession::EpocTimeInMilliseconds - timeSpentInMilliseconds;
-        return remainingTime;
-    }
-
-    bool FirewallCaptureSession::EventCountLimitPerEpocReached() const
-    {
-        return m_EventCounter->EpocEventCountLimitReached();
-    }
-
-    void FirewallCaptureSession::ResetEpoc()
-    {
-        m_EventCounter->ResetEpocEventCount();
-        m_Timer->SetEpocStart();
-    }
-
-    void FirewallCaptureSession::LogFileIntervalCheck()
-    {
-        if (m_Parameters.outputToFile)
-        {
-            // If log file is sufficiently old, close it and open a new file.
-            double logFileLifetime = m_Timer->GetTimeElapsedLoggingInSeconds();
-            if (logFileLifetime >= FileLogger::LogFileLimitInSeconds)
-            {
-                wprintf(L"LogFile as been open for %.2f seconds. Closing old file and opening a new one.\n",
-                    logFileLifetime);
-                m_FileLogger->CloseLogFile();
-                m_FileLogger->CreateLogFile();
-                m_Timer->SetLogCreated();
-            }
-        }
-    }
-
-    bool FirewallCaptureSession::MatchIpAddressFilter(
-        const std::wstring& address) const
-    {
-        if (m_Parameters.ipAddressFilters.empty())
-        {
-            return true;
-        }
-
-        auto found = std::find(
-            m_Parameters.ipAddressFilters.begin(),
-            m_Parameters.ipAddressFilters.end(),
-            address);
-
-        return found != m_Parameters.ipAddressFilters.end();
-    }
-
-    bool FirewallCaptureSession::MatchRuleIdFilter(
-        const std::wstring& ruleId) const
-    {
-        if (m_Parameters.ruleIdFilters.empty())
-        {
-            return true;
-        }
-
-        auto found = std::find(
-            m_Parameters.ruleIdFilters.begin(),
-            m_Parameters.ruleIdFilters.end(),
-            ruleId);
-
-        return found != m_Parameters.ruleIdFilters.end();
-    }
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include "FirewallCaptureSession.h"
+
+// c++ headers
+#include <algorithm>
+// ntl headers
+#include "ntlString.hpp"
+#include "ntlTimer.hpp"
+#include "ntlUuid.hpp"
+
+namespace FirewallEventMonitor
+{
+    const LPCWSTR TRACE_SESSION_NAME_PREFIX =
+        L"FirewallEventCaptureSession";
+
+    FirewallCaptureSession::FirewallCaptureSession()
+        : FirewallCaptureSession(Parameters{})
+    {
+    }
+
+    FirewallCaptureSession::FirewallCaptureSession(const Parameters &params)
+        : FirewallCaptureSession(
+            params,
+            std::make_shared<FileLogger>(params.logDirectory),
+            std::make_shared<Timer>(params.maxRuntimeInSeconds, params.noTimeout),
+            std::make_shared<EventCounter>(params.maxEventsPerEpoc))
+    {
+    }
+
+    FirewallCaptureSession::FirewallCaptureSession(
+        const Parameters &params,
+        std::shared_ptr<FileLogger> fileLogger,
+        std::shared_ptr<Timer> timer,
+        std::shared_ptr<EventCounter> eventCounter)
+        : m_CaptureSessionRunning(false),
+        m_FileLogger(fileLogger),
+        m_Parameters(params),
+        m_Timer(timer),
+        m_EventCounter(eventCounter),
+        m_ResourceSampler(std::make_unique<ResourceSampler>()),
+        m_EventStatistics(std::make_unique<EventStatistics>()),
+        m_Filter(params.ipAddressFilters, params.ruleIdFilters)
+    {
+        if (m_Parameters.outputToConsole ||
+            m_Parameters.outputToFile ||
+            !m_Parameters.syslogHost.empty())
+        {
+            m_SinkGraph = std::make_shared<SinkGraph>();
+            if (m_Parameters.outputToConsole)
+            {
+                m_SinkGraph->AddSink(std::make_shared<ConsoleSink>(stdout));
+            }
+            if (m_Parameters.outputToFile)
+            {
+                m_SinkGraph->AddSink(std::make_shared<FileSink>(m_FileLogger, m_Parameters.logFormat));
+            }
+            if (!m_Parameters.syslogHost.empty())
+            {
+                // Kept next to the logs, so messages not yet sent survive a restart.
+                m_SyslogSink = std::make_shared<SyslogSink>(
+                    m_Parameters.syslogHost,
+                    m_Parameters.syslogPort,
+                    m_Parameters.syslogOverTcp ? SyslogTransport::Tcp : SyslogTransport::Udp,
+                    m_FileLogger->GetLogDirectory() + L"\\FirewallEventMonitor.syslog.spill");
+                m_SinkGraph->AddSink(m_SyslogSink);
+            }
+        }
+
+        if (m_Parameters.outputToDashboard)
+        {
+            m_Dashboard = std::make_unique<Dashboard>();
+        }
+
+        if (m_Parameters.durableLog)
+        {
+            m_FileLogger->EnableDurableWrites(
+                m_Parameters.durableIntervalInMilliseconds,
+                m_Parameters.durableBytes);
+        }
+
+        if (m_Parameters.mappedLog)
+        {
+            m_FileLogger->EnableMappedWrites(m_Parameters.segmentBytes);
+        }
+
+        if (m_Parameters.overlappedLog)
+        {
+            m_FileLogger->EnableOverlappedWrites(
+                m_Parameters.overlappedBufferBytes,
+                OverlappedLogFile::DefaultBufferCount);
+        }
+
+        if (!m_Parameters.archivePath.empty())
+        {
+            m_EventArchive = std::make_unique<EventArchiveWriter>(m_Parameters.archivePath);
+        }
+
+        if (!m_Parameters.sketchDirectory.empty())
+        {
+            m_SketchRecorder = std::make_unique<SketchRecorder>(
+                m_Parameters.sketchDirectory,
+                SketchRecorder::LocalHostName(),
+                m_Parameters.sketchIntervalInSeconds,
+                ntl::Timer::convert_filetime_hundredNs(ntl::Timer::snap_system_time_as_filetime()));
+        }
+
+        if (m_Parameters.detectAnomalies)
+        {
+            m_RuleAnomalyDetector = std::make_unique<RuleAnomalyDetector>(
+                m_Parameters.anomalyZScoreThreshold,
+                m_Parameters.anomalyRatioThreshold);
+        }
+
+        if (m_Parameters.pairFlows)
+        {
+            m_FlowPairing = std::make_unique<FlowPairing>(m_Parameters.flowPairingWindowInSeconds);
+        }
+
+        if (m_Parameters.trackRuleUsage)
+        {
+            m_RuleUsageTracker = std::make_unique<RuleUsageTracker>();
+            if (!m_Parameters.ruleCatalogPath.empty())
+            {
+                size_t loaded = m_RuleUsageTracker->LoadCatalog(m_Parameters.ruleCatalogPath);
+                wprintf(L"Loaded %zu rule ids from %ls.\n", loaded, m_Parameters.ruleCatalogPath.c_str());
+            }
+        }
+
+        if (m_Parameters.sampleRate > 1 ||
+            m_Parameters.adaptiveSampling)
+        {
+            m_FlowSampler = std::make_unique<FlowSampler>(m_Parameters.sampleRate);
+        }
+
+        if (m_Parameters.adaptiveSampling)
+        {
+            m_AdaptiveSampling = std::make_unique<AdaptiveSampling>(
+                static_cast<double>(m_Parameters.lagBudgetInMilliseconds),
+                m_Parameters.cpuBudgetPercent,
+                m_Parameters.sampleRate);
+            m_AdaptiveCpuSampler = std::make_unique<ResourceSampler>();
+        }
+
+        if (!m_Parameters.shedPolicy.empty())
+        {
+            m_LoadShedder = std::make_unique<LoadShedder>(m_Parameters.maxEventsPerEpoc, m_Parameters.shedPolicy);
+        }
+
+        // Every provider with a registered schema is enabled.
+        auto schemaRegistry = std::make_shared<SchemaRegistry>();
+        schemaRegistry->RegisterVfp();
+        if (!m_Parameters.schemaPath.empty())
+        {
+            size_t loaded = schemaRegistry->LoadSchemas(m_Parameters.schemaPath);
+            wprintf(L"Loaded %zu event schemas from %ls.\n", loaded, m_Parameters.schemaPath.c_str());
+        }
+        m_SchemaRegistry = schemaRegistry;
+        m_ProviderGuids = m_SchemaRegistry->GetProviders();
+
+        GenerateTraceSessionName();
+    }
+
+    FirewallCaptureSession::~FirewallCaptureSession()
+    {
+        CloseSession();
+    }
+
+    void FirewallCaptureSession::GenerateTraceSessionName()
+    {
+        m_TraceSessionName = TRACE_SESSION_NAME_PREFIX;
+
+        // Randomly generate a UUID for the TraceSession name and guid.
+        // This prevents collisions, allowing multiple instances of FirewallEventMontior to run simultaneously.
+        UUID uuid;
+        RPC_STATUS uuidcreate_status = UuidCreate(&uuid);
+        if (uuidcreate_status == RPC_S_OK)
+        {
+            m_TraceSessionGuid = uuid;
+
+            // convert UUID to wstring
+            WCHAR wszUuid[ntl::Uuid::UUID_STRING_LENGTH + 1];
+            if (ntl::Uuid::format_uuid(uuid, wszUuid, _countof(wszUuid)) != 0)
+            {
+                m_TraceSessionName += L".";
+                m_TraceSessionName += wszUuid;
+            }
+            else
+            {
+                throw std::exception("Unable to convert UUID to wstring.");
+            }
+        }
+        else
+        {
+            throw std::exception("Unable to create UUID.");
+        }
+    }
+
+    void FirewallCaptureSession::OpenSession()
+    {
+        m_EtwReader = std::make_unique<ntl::EtwReader<FirewallEtwTraceCallback>>(
+            FirewallEtwTraceCallback(
+                shared_from_this(),
+                m_Parameters,
+                m_FileLogger,
+                m_Timer,
+                m_EventCounter,
+                m_SinkGraph,
+                m_SchemaRegistry));
+        // Start the sink writers before events can arrive.
+        if (m_SinkGraph)
+        {
+            m_SinkGraph->Start();
+        }
+        // NULL szFileName to not create a file.
+        m_EtwReader->StartSession(m_TraceSessionName.c_str(), NULL, m_TraceSessionGuid);
+        m_EtwReader->EnableProviders(m_ProviderGuids);
+        m_CaptureSessionRunning = true;
+        // Timer
+        m_Timer->SetEpocStart();
+        m_Timer->SetStatisticsReported();
+        m_EventCountAtLastStatistics = 0;
+        m_ResourceSampler->Sample();
+        // Dashboard
+        if (m_Dashboard)
+        {
+            // The dashboard moves the cursor with VT escape sequences.
+            HANDLE console = ::GetStdHandle(STD_OUTPUT_HANDLE);
+            DWORD mode = 0;
+            if (::GetConsoleMode(console, &mode))
+            {
+                ::SetConsoleMode(console, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+            }
+            wprintf(L"\x1b[2J");
+            m_DashboardRefreshed = GetTickCount64();
+        }
+        // Log
+        if (m_Parameters.outputToFile)
+        {
+            // A previous run that crashed may have left a torn tail on its log.
+            if (m_FileLogger->IsDurable())
+            {
+                m_FileLogger->RecoverLastLogFile();
+            }
+            m_FileLogger->CreateLogFile();
+            m_Timer->SetLogCreated();
+            WriteAlert(ntl::String::format_string(L"\tWriting events to log file: %ls\n",
+                m_FileLogger->GetLogFilePath().c_str()));
+        }
+    }
+
+    void FirewallCaptureSession::CloseSession() try
+    {
+        if (!m_CaptureSessionRunning)
+        {
+            return;
+        }
+
+        // Shut down in order, so no event is written after its file is closed: stop intake, let
+        // ETW deliver the events it has buffered, drain the sinks, then close the files.
+        // The drain as a whole is bounded by -DrainTimeout.
+        wprintf(L"Stopping: finishing the events in flight (up to %lu ms).\n",
+            m_Parameters.drainTimeoutInMilliseconds);
+        ULONGLONG drainStarted = GetTickCount64();
+        ULONGLONG deadline = drainStarted + m_Parameters.drainTimeoutInMilliseconds;
+        unsigned long eventCountAtStop = m_EventCounter->GetEventCountTotal();
+        unsigned long long sinkEventsAtStop = m_SinkGraph ? m_SinkGraph->GetEventsWritten() : 0;
+        bool etwDrained = true;
+
+        if (m_EtwReader)
+        {
+            try
+            {
+                m_EtwReader->DisableProviders(m_ProviderGuids);
+            }
+            catch (const std::exception &ex)
+            {
+                wprintf(L"Error: DisableProviders raised exception: %S.\n", ex.what());
+            }
+            etwDrained = m_EtwReader->DrainSession(m_Parameters.drainTimeoutInMilliseconds);
+            m_EtwReader->StopSession();
+        }
+        else
+        {
+            wprintf(L"Error: Event reader not defined.\n");
+        }
+        m_CaptureSessionRunning = false;
+        unsigned long etwEventsDrained = m_EventCounter->GetEventCountTotal() - eventCountAtStop;
+
+        // Report alerts raised since the last check, including by the events just delivered.
+        AnomalyCheck();
+        FlowPairingCheck();
+
+        if (m_SinkGraph)
+        {
+            m_SinkGraph->StopBy(deadline);
+        }
+
+        // Log
+        if (m_Parameters.outputToFile)
+        {
+            m_FileLogger->CloseLogFile();
+            WriteAlert(ntl::String::format_string(L"\tClosed log file: %ls\n",
+                m_FileLogger->GetLogFilePath().c_str()));
+        }
+
+        // Events are appended on the ETW thread, so the archive is closed once it has stopped.
+        if (m_EventArchive)
+        {
+            m_EventArchive->Close();
+        }
+
+        // The last interval is cut short, so its events are in a sketch too.
+        if (m_SketchRecorder)
+        {
+            m_SketchRecorder->Write(ntl::Timer::convert_filetime_hundredNs(ntl::Timer::snap_system_time_as_filetime()));
+        }
+        ULONGLONG drainTime = GetTickCount64() - drainStarted;
+
+        wprintf(L"FirewallEventWatcher ran for %.2f seconds. Captured %d events.\n",
+            m_Timer->GetTimeElapsedSinceStartInSeconds(),
+            m_EventCounter->GetEventCountTotal());
+
+        fputws(FormatStatistics(
+            m_EventCounter->GetEventCountTotal(),
+            m_Timer->GetTimeElapsedSinceStartInSeconds(),
+            m_EventStatistics->GetLifetimeSnapshot(),
+            m_ResourceSampler->Sample()).c_str(), stdout);
+
+        if (m_RuleAnomalyDetector)
+        {
+            wprintf(L"  anomaly {rules = %zu, rulesNotTracked = %llu, alertsDropped = %llu} \n",
+                m_RuleAnomalyDetector->GetRuleCount(),
+                m_RuleAnomalyDetector->GetRulesRejected(),
+                m_RuleAnomalyDetector->GetAlertsDropped());
+        }
+
+        if (m_FlowPairing)
+        {
+            wprintf(L"  pairing {flows = %zu, flowsNotTracked = %llu, alertsDropped = %llu} \n",
+                m_FlowPairing->GetFlowCount(),
+                m_FlowPairing->GetFlowsRejected(),
+                m_FlowPairing->GetAlertsDropped());
+        }
+
+        if (m_SinkGraph)
+        {
+            for (const auto& sink : m_SinkGraph->GetSinks())
+            {
+                if (sink->GetEventsDropped() > 0)
+                {
+                    wprintf(L"  sink {name = %ls, eventsWritten = %llu, eventsDropped = %llu} \n",
+                        sink->GetName(),
+                        sink->GetEventsWritten(),
+                        sink->GetEventsDropped());
+                }
+            }
+        }
+
+        if (m_SyslogSink)
+        {
+            wprintf(L"  syslog {bytesSent = %llu, eventsSpilled = %llu, spillBytes = %llu, connectFailures = %llu} \n",
+                m_SyslogSink->GetBytesSent(),
+                m_SyslogSink->GetEventsSpilled(),
+                m_SyslogSink->GetSpillBytes(),
+                m_SyslogSink->GetConnectFailures());
+        }
+
+        if (m_EventArchive)
+        {
+            wprintf(L"  archive {rows = %llu, rowsDropped = %llu, batches = %llu, dictionaryEntries = %zu, bytes = %llu} \n",
+                m_EventArchive->GetRowsWritten(),
+                m_EventArchive->GetRowsDropped(),
+                m_EventArchive->GetBatchesWritten(),
+                m_EventArchive->GetDictionaryEntries(),
+                m_EventArchive->GetBytesWritten());
+        }
+
+        if (m_SketchRecorder)
+        {
+            wprintf(L"  sketch {snapshots = %llu, bytes = %llu, writeFailures = %llu} \n",
+                m_SketchRecorder->GetSnapshotsWritten(),
+                m_SketchRecorder->GetBytesWritten(),
+                m_SketchRecorder->GetWriteFailures());
+        }
+
+        // Events ETW delivered after intake stopped, and sink writes finished or given up at the deadline.
+        // A drain that ran out of time loses the events ETW still held.
+        wprintf(L"  shutdown {etwEventsDrained = %lu, etwDrainComplete = %ls, sinkEventsDrained = %llu, sinkEventsAbandoned = %llu, drainMs = %llu} \n",
+            etwEventsDrained,
+            etwDrained ? L"true" : L"false",
+            m_SinkGraph ? m_SinkGraph->GetEventsWritten() - sinkEventsAtStop : 0,
+            m_SinkGraph ? m_SinkGraph->GetEventsAbandoned() : 0,
+            drainTime);
+
+        std::wstring report;
+        ReportSampling(&report);
+        ReportLoadShedding(&report);
+        ReportDurability(&report);
+        ReportOverlappedWrites(&report);
+        ReportRuleUsage(&report);
+        fputws(report.c_str(), stdout);
+    }
+    catch (const std::exception &ex)
+    {
+        wprintf(L"Error: Closing the session raised exception: %S.\n", ex.what());
+    }
+
+    bool FirewallCaptureSession::CaptureSessionRunning() const
+    {
+        return m_CaptureSessionRunning;
+    }
+
+    bool FirewallCaptureSession::TimeLimitReached() const
+    {
+        return m_Timer->TimeLimitReached();
+    }
+
+    double FirewallCaptureSession::GetTimeRemainingInEpoc() const
+    {
+        // Sleep for remainder of the epoc (1 second)
+        double timeSpentInSeconds = m_Timer->GetTimeElapsedThisEpocInSeconds();
+        double timeSpentInMilliseconds = (timeSpentInSeconds * 1000);
+        double remainingTime = FirewallCaptureSession::EpocTimeInMilliseconds - timeSpentInMilliseconds;
+        return remainingTime;
+    }
+
+    bool FirewallCaptureSession::EventCountLimitPerEpocReached() const
+    {
+        return m_EventCounter->EpocEventCountLimitReached();
+    }
+
+    void FirewallCaptureSession::ReportEventLimitReached(double remainingTime)
+    {
+        ++m_EpocsThrottled;
+        if (!DashboardOnScreen())
+        {
+            wprintf(L"Event limit per epoc reached (%d). Sleeping for %f Milliseconds.\n",
+                m_Parameters.maxEventsPerEpoc,
+                remainingTime);
+        }
+    }
+
+    void FirewallCaptureSession::ResetEpoc()
+    {
+        m_EventCounter->ResetEpocEventCount();
+        m_Timer->SetEpocStart();
+    }
+
+    void FirewallCaptureSession::LogFileIntervalCheck()
+    {
+        if (m_Parameters.outputToFile)
+        {
+            // Sync a durable log's current group once it has waited its interval, or submit an
+            // overlapped log's partly filled buffer.
+            m_FileLogger->CommitIfDue();
+
+            // If log file is sufficiently old, close it and open a new file.
+            double logFileLifetime = m_Timer->GetTimeElapsedLoggingInSeconds();
+            if (logFileLifetime >= FileLogger::LogFileLimitInSeconds)
+            {
+                std::wstring previousPath = m_FileLogger->GetLogFilePath();
+                // The file sink keeps writing on its own thread; the logger swaps files under its lock.
+                m_FileLogger->RotateLogFile();
+                m_Timer->SetLogCreated();
+                WriteAlert(ntl::String::format_string(L"LogFile as been open for %.2f seconds. Closing old file and opening a new one.\n"
+                    L"\tClosed log file: %ls\n"
+                    L"\tWriting events to log file: %ls\n",
+                    logFileLifetime,
+                    previousPath.c_str(),
+                    m_FileLogger->GetLogFilePath().c_str()));
+            }
+        }
+    }
+
+    void FirewallCaptureSession::StatisticsIntervalCheck()
+    {
+        if (m_Parameters.statisticsIntervalInSeconds == 0)
+        {
+            return;
+        }
+
+        double elapsed = m_Timer->GetTimeElapsedSinceStatisticsInSeconds();
+        if (elapsed < m_Parameters.statisticsIntervalInSeconds)
+        {
+            return;
+        }
+
+        unsigned long eventCountTotal = m_EventCounter->GetEventCountTotal();
+        std::wstring report = FormatStatistics(
+            eventCountTotal - m_EventCountAtLastStatistics,
+            elapsed,
+            m_EventStatistics->TakeIntervalSnapshot(),
+            m_ResourceSampler->Sample());
+
+        ReportSampling(&report);
+        ReportLoadShedding(&report);
+        ReportDurability(&report);
+        ReportOverlappedWrites(&report);
+        ReportRuleUsage(&report);
+
+        if (DashboardOnScreen())
+        {
+            // The dashboard shows the rates and lag itself: its pane gets the headline,
+            // the log file the whole report.
+            m_Dashboard->RecordAlert(report.substr(0, report.find(L'\n') + 1));
+            if (m_Parameters.outputToFile)
+            {
+                m_FileLogger->Write(report);
+            }
+        }
+        else
+        {
+            fputws(report.c_str(), stdout);
+        }
+
+        m_EventCountAtLastStatistics = eventCountTotal;
+        m_Timer->SetStatisticsReported();
+    }
+
+    void FirewallCaptureSession::ReportSampling(std::wstring* report) const
+    {
+        if (!m_FlowSampler)
+        {
+            return;
+        }
+
+        // Totals since the session opened; with -Adaptive the rate has varied over that time.
+        unsigned long long kept = m_FlowSampler->GetEventsKept();
+        unsigned long long skipped = m_FlowSampler->GetEventsSkipped();
+        double effectivePercent = kept + skipped > 0 ? (100.0 * kept) / (kept + skipped) : 100.0;
+        report->append(ntl::String::format_string(L"  sampling {rate = 1/%lu, eventsKept = %llu, eventsSkipped = %llu, effective = %.2f%%} \n",
+            m_FlowSampler->GetSampleRate(),
+            kept,
+            skipped,
+            effectivePercent));
+    }
+
+    void FirewallCaptureSession::ReportDurability(std::wstring* report) const
+    {
+        if (!m_FileLogger->IsDurable())
+        {
+            return;
+        }
+
+        // Lag is from a group's first write until it is on disk.
+        DurabilityReport durability = m_FileLogger->GetDurabilityReport();
+        report->append(ntl::String::format_string(L"  durability {commits = %llu, bytesCommitted = %llu, pendingBytes = %zu, lagMs = %llu, maxLagMs = %llu, tornBytesRemoved = %llu} \n",
+            durability.commits,
+            durability.bytesCommitted,
+            durability.pendingBytes,
+            durability.lastLagInMilliseconds,
+            durability.maxLagInMilliseconds,
+            durability.tornBytesRemoved));
+    }
+
+    void FirewallCaptureSession::ReportOverlappedWrites(std::wstring* report) const
+    {
+        if (!m_FileLogger->IsOverlapped())
+        {
+            return;
+        }
+
+        // Buffer waits are appends held up because every buffer was being written.
+        OverlappedWriteReport writes = m_FileLogger->GetOverlappedWriteReport();
+        report->append(ntl::String::format_string(L"  overlappedWrites {writes = %llu, bytesWritten = %llu, inFlight = %zu, bufferWaits = %llu, errors = %llu} \n",
+            writes.writesIssued,
+            writes.bytesCompleted,
+            writes.writesInFlight,
+            writes.bufferWaits,
+            writes.writeErrors));
+    }
+
+    void FirewallCaptureSession::ReportLoadShedding(std::wstring* report) const
+    {
+        if (!m_LoadShedder)
+        {
+            return;
+        }
+
+        // Totals since the session opened, in priority order.
+        report->append(ntl::String::format_string(L"  shedding {budget = %lu/s} \n", m_Parameters.maxEventsPerEpoc));
+        for (const auto& entry : m_LoadShedder->GetPolicy())
+        {
+            ShedClassCounters counters = m_LoadShedder->GetCounters(entry.eventClass);
+            report->append(ntl::String::format_string(L"    %ls {reserved = %lu%%, kept = %llu, dropped = %llu} \n",
+                LoadShedder::EventClassName(entry.eventClass),
+                entry.reservedPercent,
+                counters.kept,
+                counters.dropped));
+        }
+    }
+
+    void FirewallCaptureSession::ReportRuleUsage(std::wstring* report)
+    {
+        if (!m_RuleUsageTracker)
+        {
+            return;
+        }
+
+        auto usageReport = m_RuleUsageTracker->GetReport();
+        size_t neverHit = m_RuleUsageTracker->GetNeverHitCount();
+
+        report->append(ntl::String::format_string(L"  rules {tracked = %zu, neverHit = %zu, notInCatalog = %zu, notTracked = %llu} \n",
+            usageReport.size(),
+            neverHit,
+            m_RuleUsageTracker->GetNotInCatalogCount(),
+            m_RuleUsageTracker->GetRulesRejected()));
+
+        // The report is sorted by hits, so the busiest rules come first and never-hit rules last.
+        for (size_t i = 0; i < usageReport.size() && i < RuleUsageRulesPrinted; ++i)
+        {
+            const RuleUsage& usage = usageReport[i].usage;
+            if (usage.TotalHits() == 0)
+            {
+                break;
+            }
+            report->append(ntl::String::format_string(L"    %ls hits = %llu {allowIn = %llu, allowOut = %llu, denyIn = %llu, denyOut = %llu} \n",
+                FormatGuid(usageReport[i].ruleId).c_str(),
+                usage.TotalHits(),
+                usage.allowInbound,
+                usage.allowOutbound,
+                usage.denyInbound,
+                usage.denyOutbound));
+        }
+
+        if (neverHit > 0)
+        {
+            size_t printed = 0;
+            for (auto entry = usageReport.rbegin(); entry != usageReport.rend() && printed < RuleUsageRulesPrinted; ++entry)
+            {
+                if (entry->usage.TotalHits() != 0)
+                {
+                    break;
+                }
+                if (entry->usage.inCatalog)
+                {
+                    report->append(ntl::String::format_string(L"    %ls never hit \n", FormatGuid(entry->ruleId).c_str()));
+                    printed++;
+                }
+            }
+            if (neverHit > printed)
+            {
+                report->append(ntl::String::format_string(L"    ... and %zu more never hit \n", neverHit - printed));
+            }
+        }
+
+        if (!m_Parameters.ruleUsageExportPath.empty())
+        {
+            m_RuleUsageTracker->ExportReport(m_Parameters.ruleUsageExportPath);
+        }
+    }
+
+    void FirewallCaptureSession::AnomalyCheck()
+    {
+        if (!m_RuleAnomalyDetector)
+        {
+            return;
+        }
+
+        for (const auto& alert : m_RuleAnomalyDetector->TakeAlerts())
+        {
+            WriteAlert(FormatAnomalyAlert(alert));
+        }
+    }
+
+    std::wstring FirewallCaptureSession::FormatAnomalyAlert(
+        const RuleAnomalyAlert& alert) const
+    {
+        LARGE_INTEGER timeStamp;
+        timeStamp.QuadPart = alert.timeStamp;
+        std::wstring date, time;
+        Timer::GetDateAndTime(timeStamp, &date, &time);
+
+        return ntl::String::format_string(L"[%ls %ls] Anomaly: %ls rule %ls hit %lu times this second "
+            L"{baseline = %.1f/s, z = %.1f, ratio = %.1fx} \n",
+            date.c_str(),
+            time.c_str(),
+            RuleActionName(alert.action),
+            FormatGuid(alert.ruleId).c_str(),
+            alert.count,
+            alert.baseline,
+            alert.zScore,
+            alert.ratio);
+    }
+
+    void FirewallCaptureSession::FlowPairingCheck()
+    {
+        if (!m_FlowPairing)
+        {
+            return;
+        }
+
+        for (const auto& alert : m_FlowPairing->TakeAlerts())
+        {
+            WriteAlert(FormatAsymmetricFlowAlert(alert));
+        }
+    }
+
+    bool FirewallCaptureSession::DashboardOnScreen() const
+    {
+        // Once the session closes, its last alerts and reports are printed below the final screen.
+        return m_Dashboard && m_CaptureSessionRunning;
+    }
+
+    void FirewallCaptureSession::WriteAlert(const std::wstring& text)
+    {
+        if (DashboardOnScreen())
+        {
+            m_Dashboard->RecordAlert(text);
+        }
+        else
+        {
+            fputws(text.c_str(), stdout);
+        }
+
+        // Through the logger, so a durable log's commit records cover the alert too.
+        if (m_Parameters.outputToFile)
+        {
+            m_FileLogger->Write(text);
+        }
+    }
+
+    void FirewallCaptureSession::AdaptiveSamplingCheck() try
+    {
+        if (!m_AdaptiveSampling ||
+            !m_EtwReader)
+        {
+            return;
+        }
+
+        ULONGLONG now = GetTickCount64();
+        if (now - m_AdaptiveSamplingChecked < AdaptiveSamplingIntervalInMilliseconds)
+        {
+            return;
+        }
+        m_AdaptiveSamplingChecked = now;
+
+        PipelinePressure pressure;
+        pressure.lagInMilliseconds = m_EventStatistics->TakeMaxLagInMilliseconds();
+        pressure.cpuPercent = m_AdaptiveCpuSampler->SampleCpuPercent();
+
+        // Buffers not on the free list hold events ETW has not delivered to us yet.
+        EVENT_TRACE_PROPERTIES session = m_EtwReader->QuerySession();
+        if (session.NumberOfBuffers > 0 &&
+            session.NumberOfBuffers > session.FreeBuffers)
+        {
+            pressure.queueUsage =
+                static_cast<double>(session.NumberOfBuffers - session.FreeBuffers) / session.NumberOfBuffers;
+        }
+        if (m_SinkGraph)
+        {
+            pressure.queueUsage = (std::max)(pressure.queueUsage, m_SinkGraph->GetQueueUsage());
+        }
+        ULONG etwEventsLost = session.EventsLost + session.RealTimeBuffersLost;
+        pressure.eventsLost = etwEventsLost > m_EtwEventsLost;
+        m_EtwEventsLost = etwEventsLost;
+
+        unsigned long previousRate = m_AdaptiveSampling->GetSampleRate();
+        unsigned long rate = m_AdaptiveSampling->Update(pressure);
+        if (rate != previousRate)
+        {
+            m_FlowSampler->SetSampleRate(rate);
+            std::wstring text = ntl::String::format_string(L"Adaptive: sample rate 1/%lu -> 1/%lu {load = %.2f, lag = %.1f ms, queue = %.0f%%, cpu = %.2f%%%ls} \n",
+                previousRate,
+                rate,
+                m_AdaptiveSampling->GetLoad(),
+                pressure.lagInMilliseconds,
+                pressure.queueUsage * 100.0,
+                pressure.cpuPercent,
+                pressure.eventsLost ? L", ETW lost events" : L"");
+            // On the console only, unless the dashboard has it.
+            if (DashboardOnScreen())
+            {
+                WriteAlert(text);
+            }
+            else
+            {
+                fputws(text.c_str(), stdout);
+            }
+        }
+    }
+    catch (const std::exception &ex)
+    {
+        wprintf(L"Warning: adaptive sampling check raised exception: %S.\n", ex.what());
+    }
+
+    void FirewallCaptureSession::DashboardCheck() try
+    {
+        if (!m_Dashboard)
+        {
+            return;
+        }
+
+        ULONGLONG now = GetTickCount64();
+        ULONGLONG elapsed = now - m_DashboardRefreshed;
+        if (elapsed < Dashboard::RefreshIntervalInMilliseconds)
+        {
+            return;
+        }
+        m_DashboardRefreshed = now;
+
+        DashboardSnapshot snapshot = m_Dashboard->TakeSnapshot(static_cast<double>(elapsed) / 1000.0);
+
+        // Drops since the session opened, from the stages that make them.
+        if (m_FlowSampler)
+        {
+            snapshot.sampleRate = m_FlowSampler->GetSampleRate();
+            snapshot.eventsSampledOut = m_FlowSampler->GetEventsSkipped();
+        }
+        if (m_LoadShedder)
+        {
+            for (const auto& entry : m_LoadShedder->GetPolicy())
+            {
+                snapshot.eventsShed += m_LoadShedder->GetCounters(entry.eventClass).dropped;
+            }
+        }
+        if (m_EtwReader)
+        {
+            EVENT_TRACE_PROPERTIES session = m_EtwReader->QuerySession();
+            snapshot.etwEventsLost = static_cast<unsigned long long>(session.EventsLost) + session.RealTimeBuffersLost;
+        }
+        snapshot.eventLimitPerEpoc = m_Parameters.maxEventsPerEpoc;
+        snapshot.epocsThrottled = m_EpocsThrottled;
+
+        // One write per refresh, however many events the interval held.
+        fputws(Dashboard::Render(snapshot).c_str(), stdout);
+        fflush(stdout);
+    }
+    catch (const std::exception &ex)
+    {
+        wprintf(L"Warning: dashboard refresh raised exception: %S.\n", ex.what());
+    }
+
+    void FirewallCaptureSession::SketchCheck()
+    {
+        if (!m_SketchRecorder)
+        {
+            return;
+        }
+
+        // Failures to write are counted and warned about by the recorder; the next interval tries again.
+        m_SketchRecorder->WriteIfDue(ntl::Timer::convert_filetime_hundredNs(ntl::Timer::snap_system_time_as_filetime()));
+    }
+
+    std::wstring FirewallCaptureSession::FormatAsymmetricFlowAlert(
+        const AsymmetricFlowAlert& alert) const
+    {
+        const CompactEventRecord& later =
+            alert.inbound.timeStamp > alert.outbound.timeStamp ? alert.inbound : alert.outbound;
+        LARGE_INTEGER timeStamp;
+        timeStamp.QuadPart = later.timeStamp;
+        std::wstring date, time;
+        Timer::GetDateAndTime(timeStamp, &date, &time);
+
+        // The flow is shown as seen by the inbound event.
+        std::wstring text = ntl::String::format_string(L"[%ls %ls] Asymmetric flow: %ls:%u -> %ls:%u protocol %u \n",
+            date.c_str(),
+            time.c_str(),
+            FormatAddress(alert.inbound.source, alert.inbound.isIpv6).c_str(),
+            alert.inbound.sourcePort,
+            FormatAddress(alert.inbound.destination, alert.inbound.isIpv6).c_str(),
+            alert.inbound.destinationPort,
+            alert.inbound.protocol);
+        text.append(ntl::String::format_string(L"  inbound {%ls, rule = %ls} outbound {%ls, rule = %ls} \n",
+            RuleActionName(alert.inbound.action),
+            FormatGuid(alert.inbound.ruleId).c_str(),
+            RuleActionName(alert.outbound.action),
+            FormatGuid(alert.outbound.ruleId).c_str()));
+        return text;
+    }
+
+    std::wstring FirewallCaptureSession::FormatStatistics(
+        unsigned long eventCount,
+        double elapsedSeconds,
+        const EventStatisticsSnapshot& eventStatistics,
+        const ResourceUsage& usage) const
+    {
+        const double bytesPerMegabyte = 1024.0 * 1024.0;
+        double eventsPerSecond = elapsedSeconds > 0.0 ? eventCount / elapsedSeconds : 0.0;
+
+        std::wstring statistics = ntl::String::format_string(L"Statistics: %lu events in %.2f seconds (%.1f events/sec).\n",
+            eventCount,
+            elapsedSeconds,
+            eventsPerSecond);
+        statistics.append(ntl::String::format_string(L"  rate {avg = %.1f/s, p50 = %.1f/s, p99 = %.1f/s, peak = %.0f/s} \n",
+            eventStatistics.rateAverage,
+            eventStatistics.rateMedian,
+            eventStatistics.rateP99,
+            eventStatistics.ratePeak));
+        statistics.append(ntl::String::format_string(L"  lag {p50 = %.1f ms, p90 = %.1f ms, p99 = %.1f ms, max = %.1f ms, mean = %.1f ms, stdev = %.1f ms} \n",
+            eventStatistics.lagMedianInMilliseconds,
+            eventStatistics.lagP90InMilliseconds,
+            eventStatistics.lagP99InMilliseconds,
+            eventStatistics.lagMaxInMilliseconds,
+            eventStatistics.lagMeanInMilliseconds,
+            eventStatistics.lagStandardDeviationInMilliseconds));
+        statistics.append(ntl::String::format_string(L"  monitor {cpu = %.2f%%, avgCpu = %.2f%%, rss = %.1f MB, handles = %lu, threads = %lu, written = %.1f MB} \n",
+            usage.cpuPercent,
+            usage.averageCpuPercent,
+            usage.residentBytes / bytesPerMegabyte,
+            usage.handleCount,
+            usage.threadCount,
+            usage.bytesWritten / bytesPerMegabyte));
+        return statistics;
+    }
+
+    void FirewallCaptureSession::AnalyzeEvent(
+        const VfpEventData& eventData)
+    {
+        LONGLONG now = ntl::Timer::convert_filetime_hundredNs(ntl::Timer::snap_system_time_as_filetime());
+        m_EventStatistics->RecordEvent(eventData.compact.timeStamp, now);
+
+        if (m_Dashboard)
+        {
+            m_Dashboard->RecordEvent(eventData.compact, now);
+        }
+
+        if (m_RuleAnomalyDetector)
+        {
+            m_RuleAnomalyDetector->RecordEvent(eventData.compact);
+        }
+
+        if (m_FlowPairing)
+        {
+            m_FlowPairing->RecordEvent(eventData.compact);
+        }
+
+        if (m_RuleUsageTracker)
+        {
+            m_RuleUsageTracker->RecordEvent(eventData.compact);
+        }
+
+        if (m_EventArchive)
+        {
+            m_EventArchive->Append(eventData);
+        }
+
+        if (m_SketchRecorder)
+        {
+            m_SketchRecorder->RecordEvent(eventData.compact, now);
+        }
+    }
+
+    bool FirewallCaptureSession::MatchFilters(
+        const CompactEventRecord& record) const
+    {
+        return m_Filter.Match(record);
+    }
+
+    bool FirewallCaptureSession::SampleEvent(
+        CompactEventRecord* record)
+    {
+        if (!m_FlowSampler)
+        {
+            return true;
+        }
+
+        return m_FlowSampler->Sample(record);
+    }
+
+    bool FirewallCaptureSession::AdmitEvent(
+        const CompactEventRecord& record)
+    {
+        if (!m_LoadShedder)
+        {
+            return true;
+        }
+
+        return m_LoadShedder->Admit(record);
+    }
 }
\ No newline at end of file
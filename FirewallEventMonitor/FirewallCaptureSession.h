@@ -1,81 +1,182 @@
-// Copyright (c) Microsoft Corporation. All rights reserved.
-// Licensed under the MIT License. See License.txt in the project root for license information.
-
-#pragma once
-
-// os headers
-#include <winsock2.h>
-// c++ headers
-#include <memory>
-#include <utility>
-// ntl headers
-#include "ntlEtwReader.hpp"
-#include "ntlEtwRecord.hpp"
-#include "ntlEtwRecordQuery.hpp"
-
-#include "FileLogger.h"
-#include "Timer.h"
-#include "EventCounter.h"
-#include "FirewallEtwTraceCallback.h"
-
-namespace FirewallEventMonitor
-{
-    class FirewallCaptureSession : public std::enable_shared_from_this<FirewallCaptureSession>
-    {
-    public:
-        FirewallCaptureSession();
-
-        FirewallCaptureSession(const Parameters &params);
-        
-        FirewallCaptureSession(
-            const Parameters &params,
-            std::shared_ptr<FileLogger> fileLogger,
-            std::shared_ptr<Timer> timer,
-            std::shared_ptr<EventCounter> eventCounter);
-
-        ~FirewallCaptureSession();
-
-        void OpenSession();
-
-        void CloseSession();
-
-        bool CaptureSessionRunning() const;
-
-        bool TimeLimitReached() const;
-
-        void LogFileIntervalCheck();
-
-        double GetTimeRemainingInEpoc() const;
-
-        bool EventCountLimitPerEpocReached() const;
-
-        void ResetEpoc();
-
-        // Returns true if the address matches one of the filters, or if there are no filters.
-        bool MatchIpAddressFilter(const std::wstring& address) const;
-
-        // Returns true if the rule matches one of the filters, or if there are no filters.
-        bool MatchRuleIdFilter(const std::wstring& ruleId) const;
-
-        // Constants
-        const double EpocTimeInMilliseconds = 1000.0; // 1 second.
-
-        FirewallCaptureSession(FirewallCaptureSession const&) = delete;
-        FirewallCaptureSession& operator=(FirewallCaptureSession const&) = delete;
-
-    private:
-        void GenerateTraceSessionName();
-
-        // Helpers
-        std::shared_ptr<FileLogger> m_FileLogger;
-        std::shared_ptr<Timer> m_Timer;
-        std::shared_ptr<EventCounter> m_EventCounter;
-        Parameters m_Parameters;
-        // Members
-        std::unique_ptr<ntl::EtwReader<FirewallEtwTraceCallback>> m_EtwReader;
-        std::vector<GUID> m_ProviderGuids;
-        std::wstring m_TraceSessionName;
-        GUID m_TraceSessionGuid;
-        bool m_CaptureSessionRunning;
-    };
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#pragma once
+
+// os headers
+#include <winsock2.h>
+// c++ headers
+#include <memory>
+#include <utility>
+// ntl headers
+#include "ntlEtwReader.hpp"
+#include "ntlEtwRecord.hpp"
+#include "ntlEtwRecordQuery.hpp"
+
+#include "FileLogger.h"
+#include "Timer.h"
+#include "EventCounter.h"
+#include "FirewallEtwTraceCallback.h"
+#include "ResourceSampler.h"
+#include "EventStatistics.h"
+#include "RuleAnomalyDetector.h"
+#include "FlowPairing.h"
+#include "RuleUsageTracker.h"
+#include "FlowSampler.h"
+#include "LoadShedder.h"
+#include "AdaptiveSampling.h"
+#include "Dashboard.h"
+#include "SinkGraph.h"
+#include "ConsoleSink.h"
+#include "FileSink.h"
+#include "SyslogSink.h"
+#include "EventArchive.h"
+#include "EventSketch.h"
+#include "BatchFilter.h"
+
+namespace FirewallEventMonitor
+{
+    class FirewallCaptureSession : public std::enable_shared_from_this<FirewallCaptureSession>
+    {
+    public:
+        FirewallCaptureSession();
+
+        FirewallCaptureSession(const Parameters &params);
+        
+        FirewallCaptureSession(
+            const Parameters &params,
+            std::shared_ptr<FileLogger> fileLogger,
+            std::shared_ptr<Timer> timer,
+            std::shared_ptr<EventCounter> eventCounter);
+
+        ~FirewallCaptureSession();
+
+        void OpenSession();
+
+        void CloseSession();
+
+        bool CaptureSessionRunning() const;
+
+        bool TimeLimitReached() const;
+
+        void LogFileIntervalCheck();
+
+        // Prints the event rate and the monitor's own resource usage on the statistics interval.
+        // With the dashboard on screen, the report goes to the log file and its headline to the alerts pane.
+        void StatisticsIntervalCheck();
+
+        // Shows rule hit-rate alerts raised since the previous check (if -Anomaly was specified).
+        void AnomalyCheck();
+
+        // Shows flows allowed in one direction and denied in the other (if -PairFlows was specified).
+        void FlowPairingCheck();
+
+        // Adjusts the flow sample rate to the measured lag, ETW buffer use and CPU (if -Adaptive was specified).
+        void AdaptiveSamplingCheck();
+
+        // Redraws the dashboard once its refresh interval has passed (if -Output included Dashboard).
+        void DashboardCheck();
+
+        // Writes the interval's sketch once the sketch interval has passed (if -Sketch was specified).
+        void SketchCheck();
+
+        double GetTimeRemainingInEpoc() const;
+
+        bool EventCountLimitPerEpocReached() const;
+
+        // Notes that the main loop sleeps out the epoc, having reached its event limit.
+        // Printed, unless the dashboard is on screen; it shows the seconds throttled instead.
+        void ReportEventLimitReached(double remainingTime);
+
+        void ResetEpoc();
+
+        // Feeds an event that passed the filters to the statistics stages and the archive.
+        void AnalyzeEvent(const VfpEventData& eventData);
+
+        // Returns true if the event passes the address and rule filters, compared in binary form.
+        bool MatchFilters(const CompactEventRecord& record) const;
+
+        // Returns true if the event's flow is in the sample, or if there is no sample rate.
+        bool SampleEvent(_Inout_ CompactEventRecord* record);
+
+        // Returns true if the event's class is within its budget, or if there is no shedding policy.
+        bool AdmitEvent(const CompactEventRecord& record);
+
+        // Constants
+        const double EpocTimeInMilliseconds = 1000.0; // 1 second.
+        const size_t RuleUsageRulesPrinted = 10;
+        const ULONGLONG AdaptiveSamplingIntervalInMilliseconds = 1000; // 1 second.
+        const DWORD PollIntervalInMilliseconds = 100; // Longest the main loop sleeps between checks.
+
+        FirewallCaptureSession(FirewallCaptureSession const&) = delete;
+        FirewallCaptureSession& operator=(FirewallCaptureSession const&) = delete;
+
+    private:
+        void GenerateTraceSessionName();
+
+        std::wstring FormatStatistics(
+            unsigned long eventCount,
+            double elapsedSeconds,
+            const EventStatisticsSnapshot& eventStatistics,
+            const ResourceUsage& usage) const;
+
+        // True while the session runs with -Output Dashboard, which then owns the console.
+        bool DashboardOnScreen() const;
+
+        // Shows an alert in the dashboard's recent alerts pane while it is on screen, on stdout
+        // otherwise, and writes it to the log file (if -Output included File).
+        void WriteAlert(const std::wstring& text);
+
+        std::wstring FormatAnomalyAlert(const RuleAnomalyAlert& alert) const;
+
+        std::wstring FormatAsymmetricFlowAlert(const AsymmetricFlowAlert& alert) const;
+
+        // Appends the busiest and never-hit rules, and rewrites the export file if requested.
+        void ReportRuleUsage(_Inout_ std::wstring* report);
+
+        // Appends events kept and dropped per shedding class.
+        void ReportLoadShedding(_Inout_ std::wstring* report) const;
+
+        // Appends the current sample rate and the share of events kept so far.
+        void ReportSampling(_Inout_ std::wstring* report) const;
+
+        // Appends group commits and the durability lag (if -Durable was specified).
+        void ReportDurability(_Inout_ std::wstring* report) const;
+
+        // Appends overlapped writes and waits for a free buffer (if -Overlapped was specified).
+        void ReportOverlappedWrites(_Inout_ std::wstring* report) const;
+
+        // Helpers
+        std::shared_ptr<FileLogger> m_FileLogger;
+        std::shared_ptr<Timer> m_Timer;
+        std::shared_ptr<EventCounter> m_EventCounter;
+        std::shared_ptr<SinkGraph> m_SinkGraph; // Null unless -Output included Console or File, or -Syslog was specified.
+        std::shared_ptr<SyslogSink> m_SyslogSink; // Null unless -Syslog was specified; also in m_SinkGraph.
+        std::unique_ptr<ResourceSampler> m_ResourceSampler;
+        std::unique_ptr<EventStatistics> m_EventStatistics;
+        std::unique_ptr<RuleAnomalyDetector> m_RuleAnomalyDetector; // Null unless -Anomaly was specified.
+        std::unique_ptr<FlowPairing> m_FlowPairing; // Null unless -PairFlows was specified.
+        std::unique_ptr<RuleUsageTracker> m_RuleUsageTracker; // Null unless -RuleUsage was specified.
+        std::unique_ptr<FlowSampler> m_FlowSampler; // Null unless -SampleRate was above 1 or -Adaptive was specified.
+        std::unique_ptr<AdaptiveSampling> m_AdaptiveSampling; // Null unless -Adaptive was specified.
+        std::unique_ptr<Dashboard> m_Dashboard; // Null unless -Output included Dashboard.
+        std::unique_ptr<EventArchiveWriter> m_EventArchive; // Null unless -Archive was specified.
+        std::unique_ptr<SketchRecorder> m_SketchRecorder; // Null unless -Sketch was specified.
+        std::unique_ptr<ResourceSampler> m_AdaptiveCpuSampler; // CPU for the control loop, apart from the statistics.
+        std::unique_ptr<LoadShedder> m_LoadShedder; // Null unless -ShedPriority was specified.
+        Parameters m_Parameters;
+        BatchFilter m_Filter; // The -Ip and -Rule filters, parsed once.
+        // Members
+        std::unique_ptr<ntl::EtwReader<FirewallEtwTraceCallback>> m_EtwReader;
+        std::shared_ptr<const SchemaRegistry> m_SchemaRegistry;
+        std::vector<GUID> m_ProviderGuids;
+        std::wstring m_TraceSessionName;
+        GUID m_TraceSessionGuid;
+        bool m_CaptureSessionRunning;
+        unsigned long m_EventCountAtLastStatistics = 0;
+        ULONGLONG m_AdaptiveSamplingChecked = 0;
+        ULONGLONG m_DashboardRefreshed = 0;
+        unsigned long long m_EpocsThrottled = 0;
+        ULONG m_EtwEventsLost = 0;
+    };
 }
\ No newline at end of file
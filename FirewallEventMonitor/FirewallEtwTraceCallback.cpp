@@ -1,318 +1,465 @@
-// Copyright (c) Microsoft Corporation. All rights reserved.
-// Licensed under the MIT License. See License.txt in the project root for license information.
-
-#include "FirewallEtwTraceCallback.h"
-#include "FirewallCaptureSession.h"
-
-namespace FirewallEventMonitor
-{
-    const INT IPV4_RULE_MATCH_EVENT_ID = 400;
-    const INT IPV6_RULE_MATCH_EVENT_ID = 401;
-    const INT IPV4_ICMP_RULE_MATCH_EVENT_ID = 402;
-
-    FirewallEtwTraceCallback::FirewallEtwTraceCallback(
-        const std::weak_ptr<FirewallCaptureSession> eventWatcher,
-        const Parameters &parameters,
-        const std::shared_ptr<FileLogger> fileLogger,
-        const std::shared_ptr<Timer> timer,
-        const std::shared_ptr<EventCounter> eventCounter)
-        : m_EventWatcher(eventWatcher),
-        m_Parameters(parameters),
-        m_FileLogger(fileLogger),
-        m_Timer(timer),
-        m_EventCounter(eventCounter)
-    {
-    }
-
-    bool FirewallEtwTraceCallback::operator()(
-        const PEVENT_RECORD pEventRecord) try
-    {
-        if (m_EventCounter->EpocEventCountLimitReached() ||
-            m_Timer->TimeLimitReached())
-        {
-            return false;
-        }
-
-        ntl::EtwRecord record(pEventRecord);
-
-        return ProcessEventRecord(record);
-    }
-    catch (const std::exception &ex)
-    {
-        wprintf(L"Exception: %S.\n", ex.what());
-        return false;
-    }
-
-    bool FirewallEtwTraceCallback::ProcessEventRecord(
-        const ntl::EtwRecord& record)
-    {
-        INT eventId = record.getEventId();
-        bool vfpEventIdMatch =
-            eventId == IPV4_RULE_MATCH_EVENT_ID ||
-            eventId == IPV6_RULE_MATCH_EVENT_ID ||
-            eventId == IPV4_ICMP_RULE_MATCH_EVENT_ID;
-        if (!vfpEventIdMatch)
-        {
-            return false;
-        }
-
-        auto captureSession = m_EventWatcher.lock();
-        if (!captureSession)
-        {
-            return false;
-        }
-
-        VfpEventData eventData = CollectEventData(record);
-
-        // If Ip Filters were specified, filter out events
-        //     where neither the Source nor Destination match.
-        bool sourceNotMatching =
-            !eventData.source.empty() &&
-            !captureSession->MatchIpAddressFilter(eventData.source);
-        bool destinationNotMatching =
-            !eventData.destination.empty() &&
-            !captureSession->MatchIpAddressFilter(eventData.destination);
-        if (sourceNotMatching && destinationNotMatching)
-        {
-            return false;
-        }
-
-        // If RuleId Filters were specified, filter out events
-        //     where the RuleId does not match.
-        if (!captureSession->MatchRuleIdFilter(eventData.ruleId))
-        {
-            return false;
-        }
-
-        if (m_Parameters.outputToConsole)
-        {
-            OutputToConsole(eventData);
-        }
-
-        if (m_Parameters.outputToFile)
-        {
-            OutputToFile(eventData);
-        }
-
-        m_EventCounter->IncrementEventCount();
-
-        return true;
-    }
-
-    VfpEventData FirewallEtwTraceCallback::CollectEventData(
-        const ntl::EtwRecord& record)
-    {
-        VfpEventData eventData;
-
-        record.queryEventProperty(L"SrcIpv4Addr", eventData.source);
-        record.queryEventProperty(L"DstIpv4Addr", eventData.destination);
-
-        if (eventData.source.empty() && eventData.destination.empty())
-        {
-            record.queryEventProperty(L"SrcIpv6Addr", eventData.source);
-            record.queryEventProperty(L"DstIpv6Addr", eventData.destination);
-        }
-
-        Timer::GetDateAndTime(record.getTimeStamp(), &eventData.date, &eventData.time);
-
-        {
-            std::wstring direction;
-            record.queryEventProperty(L"Direction", direction);
-            if (direction.empty())
-            {
-                wprintf(L"Warning: Direction empty.\n");
-            }
-            else
-            {
-                // Translate Direction for certain values.
-                int i = std::stoi(direction);
-                switch (i)
-                {
-                case 0: eventData.direction = L"Outbound"; break;
-                case 1: eventData.direction = L"Inbound"; break;
-                default: wprintf(L"Warning: Direction %i did not match expected values.\n", i);
-                }
-            }
-        }
-
-        {
-            std::wstring ruleType;
-            record.queryEventProperty(L"RuleType", ruleType);
-            if (ruleType.empty())
-            {
-                wprintf(L"Warning: RuleType empty.\n");
-            }
-            else
-            {
-                // Translate Rule Type for certain values.
-                int i = std::stoi(ruleType);
-                switch (i)
-                {
-                case 1: eventData.ruleType = L"Allow"; break;
-                case 2: eventData.ruleType = L"Deny"; break;
-                default: wprintf(L"Warning: RuleType %i did not match expected values.\n", i);
-                }
-            }
-        }
-
-        {
-            std::wstring protocol;
-            record.queryEventProperty(L"IpProtocol", protocol);
-            if (protocol.empty())
-            {
-                wprintf(L"Warning: IpProtocol empty.\n");
-            }
-            else
-            {
-                // Translate Protocol for certain values.
-                int i = std::stoi(protocol);
-                switch (i)
-                {
-                case 0: eventData.protocol = L"HOPOPT"; break;
-                case 1: eventData.protocol = L"ICMPv4"; break;
-                case 2: eventData.protocol = L"IGMP"; break;
-                case 6: eventData.protocol = L"TCP"; break;
-                case 17: eventData.protocol = L"UDP"; break;
-                case 41: eventData.protocol = L"IPv6"; break;
-                case 43: eventData.protocol = L"IPv6Route"; break;
-                case 44: eventData.protocol = L"IPv6Frag"; break;
-                case 47: eventData.protocol = L"GRE"; break;
-                case 58: eventData.protocol = L"ICMPv6"; break;
-                case 59: eventData.protocol = L"IPv6NoNxt"; break;
-                case 60: eventData.protocol = L"IPv6Opts"; break;
-                case 256: eventData.protocol = L"ANY"; break;
-                default: wprintf(L"Warning: IpProtocol %i did not match expected values.\n", i);
-                }
-            }
-        }
-
-        {
-            std::wstring icmpType;
-            record.queryEventProperty(L"IcmpType", icmpType);
-            // IcmpType not always present
-            if (!icmpType.empty())
-            {
-                // Translate ICMP Type for certain values.
-                int i = std::stoi(icmpType);
-                switch (i)
-                {
-                case 0: eventData.icmpType = L"V4EchoReply"; break;
-                case 5: eventData.icmpType = L"V4Redirect"; break;
-                case 8: eventData.icmpType = L"V4EchoRequest"; break;
-                case 9: eventData.icmpType = L"V4RouterAdvert"; break;
-                case 10: eventData.icmpType = L"V4RouterSolicit"; break;
-                case 13: eventData.icmpType = L"V4TimestampRequest"; break;
-                case 14: eventData.icmpType = L"V4TimestampReply"; break;
-                case 128: eventData.icmpType = L"V6EchoRequest"; break;
-                case 129: eventData.icmpType = L"V6EchoReply"; break;
-                case 133: eventData.icmpType = L"V6RouterSolicit"; break;
-                case 134: eventData.icmpType = L"V6RouterAdvert"; break;
-                case 135: eventData.icmpType = L"V6NeighborSolicit"; break;
-                case 136: eventData.icmpType = L"V6NeighborAdvert"; break;
-                default: wprintf(L"Warning: IcmpType %i did not match expected values.\n", i);
-                }
-            }
-        }
-
-        {
-            record.queryEventProperty(L"Status", eventData.status);
-            if (eventData.status.compare(L"0x0") == 0)
-            {
-                eventData.status = L"STATUS_SUCCESS";
-            }
-        }
-        // Port
-        record.queryEventProperty(L"PortId", eventData.portId);
-        record.queryEventProperty(L"PortName", eventData.portName);
-        record.queryEventProperty(L"PortFriendlyName", eventData.portFriendlyName);
-        // Flow
-        record.queryEventProperty(L"SrcPort", eventData.sourcePort);
-        record.queryEventProperty(L"DstPort", eventData.destinationPort);
-        record.queryEventProperty(L"IsTcpSyn", eventData.isTcpSyn);
-        // Rule
-        record.queryEventProperty(L"RuleId", eventData.ruleId);
-        record.queryEventProperty(L"LayerId", eventData.layerId);
-        record.queryEventProperty(L"GroupId", eventData.groupId);
-        record.queryEventProperty(L"GftFlags", eventData.gftFlags);
-
-        return eventData;
-    }
-
-    void FirewallEtwTraceCallback::OutputToConsole(
-        const VfpEventData& eventData)
-    {
-        OutputToStream(eventData, stdout);
-    }
-
-    void FirewallEtwTraceCallback::OutputToFile(
-        const VfpEventData& eventData)
-    {
-        FILE *logFile = m_FileLogger->GetLogFile();
-
-        if (logFile == NULL)
-        {
-            wprintf(L"Warning: Unable to log to null file.\n");
-            return;
-        }
-
-        OutputToStream(eventData, logFile);
-    }
-
-    void FirewallEtwTraceCallback::OutputToStream(
-        const VfpEventData& eventData,
-        _In_ FILE *stream)
-    {
-        // Header
-        fwprintf(stream, L"[%ls %ls] %ls %ls rule status = %ls \n",
-            eventData.date.c_str(),
-            eventData.time.c_str(),
-            eventData.direction.c_str(),
-            eventData.ruleType.c_str(),
-            eventData.status.c_str());
-
-        // Port
-        fwprintf(stream, L"  port {id = %ls, portName = %ls, portFriendlyName = %ls} \n",
-            eventData.portId.c_str(),
-            eventData.portName.c_str(),
-            eventData.portFriendlyName.c_str());
-
-        // Flow
-        fwprintf(stream, L"  flow {src = %ls, dst = %ls, protocol = %ls",
-            eventData.source.c_str(),
-            eventData.destination.c_str(),
-            eventData.protocol.c_str());
-
-        if (!eventData.sourcePort.empty())
-        {
-            fwprintf(stream, L", srcPort = %ls",
-                eventData.sourcePort.c_str());
-        }
-
-        if (!eventData.destinationPort.empty())
-        {
-            fwprintf(stream, L", dstPort = %ls",
-                eventData.destinationPort.c_str());
-        }
-
-        if (!eventData.icmpType.empty())
-        {
-            fwprintf(stream, L", icmp type = %ls",
-                eventData.icmpType.c_str());
-        }
-
-        if (!eventData.isTcpSyn.empty())
-        {
-            fwprintf(stream, L", isTcpSyn = %ls",
-                eventData.isTcpSyn.c_str());
-        }
-
-        fwprintf(stream, L"} \n");
-
-        // Rule
-        fwprintf(stream, L"  rule {id = %ls, layer = %ls, group = %ls, gftFlags = %ls} \n\n",
-            eventData.ruleId.c_str(),
-            eventData.layerId.c_str(),
-            eventData.groupId.c_str(),
-            eventData.gftFlags.c_str());
-    }
-}
\ No newline at end of file
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include "FirewallEtwTraceCallback.h"
+#include "FirewallCaptureSession.h"
+
+namespace FirewallEventMonitor
+{
+    // Enough for a typical event in any format, so encoding rarely reallocates.
+    const size_t EncodedEventReserveInCharacters = 512;
+
+    // Syslog facility local0 (RFC 5424 6.2.1); denied traffic is logged as a warning.
+    const unsigned int SYSLOG_FACILITY = 16;
+    const unsigned int SYSLOG_SEVERITY_WARNING = 4;
+    const unsigned int SYSLOG_SEVERITY_NOTICE = 5;
+    const unsigned int SYSLOG_SEVERITY_INFORMATIONAL = 6;
+    // Structured data id of the event fields. 32473 is the enterprise number reserved for
+    // documentation (RFC 5612); collectors match on the "vfp" name.
+    const LPCWSTR SYSLOG_SD_ID = L"vfp@32473";
+
+    namespace
+    {
+        // Appends "name":"value", escaping the value as a JSON string.
+        void AppendJsonField(
+            _Inout_ std::wstring* text,
+            LPCWSTR name,
+            const std::wstring& value)
+        {
+            if (text->back() != L'{')
+            {
+                text->push_back(L',');
+            }
+            text->push_back(L'"');
+            text->append(name);
+            text->append(L"\":\"");
+
+            for (wchar_t ch : value)
+            {
+                switch (ch)
+                {
+                case L'"': text->append(L"\\\""); break;
+                case L'\\': text->append(L"\\\\"); break;
+                case L'\n': text->append(L"\\n"); break;
+                case L'\r': text->append(L"\\r"); break;
+                case L'\t': text->append(L"\\t"); break;
+                default:
+                    if (ch < 0x20)
+                    {
+                        static const wchar_t hexDigits[] = L"0123456789abcdef";
+                        text->append(L"\\u00");
+                        text->push_back(hexDigits[ch >> 4]);
+                        text->push_back(hexDigits[ch & 0xF]);
+                    }
+                    else
+                    {
+                        text->push_back(ch);
+                    }
+                }
+            }
+
+            text->push_back(L'"');
+        }
+
+        // Appends  name="value" to a structured data element, escaping '"', '\\' and ']' (RFC 5424 6.3.3).
+        // Empty values are left out.
+        void AppendSyslogParameter(
+            _Inout_ std::wstring* text,
+            LPCWSTR name,
+            const std::wstring& value)
+        {
+            if (value.empty())
+            {
+                return;
+            }
+
+            text->push_back(L' ');
+            text->append(name);
+            text->append(L"=\"");
+            for (wchar_t ch : value)
+            {
+                if (ch == L'"' || ch == L'\\' || ch == L']')
+                {
+                    text->push_back(L'\\');
+                }
+                text->push_back(ch);
+            }
+            text->push_back(L'"');
+        }
+
+        // DNS host name for the syslog HOSTNAME field, looked up once.
+        const std::wstring& SyslogHostName()
+        {
+            static const std::wstring hostName = []()
+            {
+                WCHAR name[256] = L"";
+                DWORD length = ARRAYSIZE(name);
+                if (!::GetComputerNameExW(ComputerNameDnsHostname, name, &length) ||
+                    length == 0)
+                {
+                    return std::wstring(L"-");
+                }
+                return std::wstring(name, length);
+            }();
+            return hostName;
+        }
+
+        // Optional fields are left out rather than written empty, as in the text layout.
+        void AppendOptionalJsonField(
+            _Inout_ std::wstring* text,
+            LPCWSTR name,
+            const std::wstring& value)
+        {
+            if (!value.empty())
+            {
+                AppendJsonField(text, name, value);
+            }
+        }
+    }
+
+    FirewallEtwTraceCallback::FirewallEtwTraceCallback(
+        const std::weak_ptr<FirewallCaptureSession> eventWatcher,
+        const Parameters &parameters,
+        const std::shared_ptr<FileLogger> fileLogger,
+        const std::shared_ptr<Timer> timer,
+        const std::shared_ptr<EventCounter> eventCounter,
+        const std::shared_ptr<SinkGraph> sinkGraph,
+        const std::shared_ptr<const SchemaRegistry> schemaRegistry)
+        : m_EventWatcher(eventWatcher),
+        m_Parameters(parameters),
+        m_FileLogger(fileLogger),
+        m_Timer(timer),
+        m_EventCounter(eventCounter),
+        m_SinkGraph(sinkGraph),
+        m_SchemaRegistry(schemaRegistry)
+    {
+    }
+
+    bool FirewallEtwTraceCallback::operator()(
+        const PEVENT_RECORD pEventRecord) try
+    {
+        // With -ShedPriority the budget is enforced per class once the event is decoded.
+        bool throttled =
+            m_Parameters.shedPolicy.empty() &&
+            m_EventCounter->EpocEventCountLimitReached();
+        if (throttled ||
+            m_Timer->TimeLimitReached())
+        {
+            return false;
+        }
+
+        ntl::EtwRecord record(pEventRecord);
+
+        return ProcessEventRecord(record);
+    }
+    catch (const std::exception &ex)
+    {
+        wprintf(L"Exception: %S.\n", ex.what());
+        return false;
+    }
+
+    bool FirewallEtwTraceCallback::ProcessEventRecord(
+        const ntl::EtwRecord& record)
+    {
+        auto captureSession = m_EventWatcher.lock();
+        if (!captureSession)
+        {
+            return false;
+        }
+
+        // Events of providers or ids without a registered schema are not decoded.
+        const SchemaRegistry& schemas = m_SchemaRegistry ? *m_SchemaRegistry : SchemaRegistry::Vfp();
+        VfpEventData eventData;
+        if (!schemas.Decode(record, &eventData))
+        {
+            return false;
+        }
+
+        // If a SampleRate was specified, drop events from flows outside the sample.
+        // Runs before the filters: hashing the flow is cheaper than the string compares.
+        if (!captureSession->SampleEvent(&eventData.compact))
+        {
+            return false;
+        }
+
+        // If Ip Filters were specified, filter out events
+        //     where neither the Source nor Destination match.
+        // If RuleId Filters were specified, filter out events
+        //     where the RuleId does not match.
+        // Both compare the binary addresses and rule id rather than the strings.
+        if (!captureSession->MatchFilters(eventData.compact))
+        {
+            return false;
+        }
+
+        // If a ShedPriority was specified, drop events whose class is out of budget.
+        if (!captureSession->AdmitEvent(eventData.compact))
+        {
+            return false;
+        }
+
+        if (m_SinkGraph)
+        {
+            // Encode once per format; every sink of that format queues the same text.
+            for (EventFormat format : m_SinkGraph->GetFormatsInUse())
+            {
+                auto text = std::make_shared<std::wstring>();
+                text->reserve(EncodedEventReserveInCharacters);
+                EncodeEvent(format, eventData, text.get());
+                m_SinkGraph->Publish(format, text);
+            }
+        }
+        else
+        {
+            if (m_Parameters.outputToConsole)
+            {
+                OutputToConsole(eventData);
+            }
+
+            if (m_Parameters.outputToFile)
+            {
+                OutputToFile(eventData);
+            }
+        }
+
+        m_EventCounter->IncrementEventCount(eventData.compact.processor);
+
+        captureSession->AnalyzeEvent(eventData);
+
+        return true;
+    }
+
+    bool FirewallEtwTraceCallback::IsRuleMatchEvent(
+        const ntl::EtwRecord& record)
+    {
+        return SchemaRegistry::Vfp().IsRegistered(record);
+    }
+
+    VfpEventData FirewallEtwTraceCallback::CollectEventData(
+        const ntl::EtwRecord& record)
+    {
+        VfpEventData eventData;
+        SchemaRegistry::Vfp().Decode(record, &eventData);
+        return eventData;
+    }
+
+    void FirewallEtwTraceCallback::OutputToConsole(
+        const VfpEventData& eventData)
+    {
+        OutputToStream(eventData, stdout);
+    }
+
+    void FirewallEtwTraceCallback::OutputToFile(
+        const VfpEventData& eventData)
+    {
+        if (!m_FileLogger->IsLogFileOpen())
+        {
+            wprintf(L"Warning: Unable to log to null file.\n");
+            return;
+        }
+
+        // Through the logger, which may not be writing to a FILE (see FileLogger::EnableMappedWrites).
+        m_FormatBuffer.clear();
+        FormatEvent(eventData, &m_FormatBuffer);
+        m_FileLogger->Write(m_FormatBuffer);
+    }
+
+    void FirewallEtwTraceCallback::OutputToStream(
+        const VfpEventData& eventData,
+        _In_ FILE *stream)
+    {
+        m_FormatBuffer.clear();
+        FormatEvent(eventData, &m_FormatBuffer);
+        fputws(m_FormatBuffer.c_str(), stream);
+    }
+
+    void FirewallEtwTraceCallback::FormatEvent(
+        const VfpEventData& eventData,
+        std::wstring* text)
+    {
+        // Header
+        text->append(L"[").append(eventData.date);
+        text->append(L" ").append(eventData.time);
+        text->append(L"] ").append(eventData.direction);
+        text->append(L" ").append(eventData.ruleType);
+        text->append(L" rule status = ").append(eventData.status);
+        text->append(L" \n");
+
+        // Port
+        text->append(L"  port {id = ").append(eventData.portId);
+        text->append(L", portName = ").append(eventData.portName);
+        text->append(L", portFriendlyName = ").append(eventData.portFriendlyName);
+        text->append(L"} \n");
+
+        // Flow
+        text->append(L"  flow {src = ").append(eventData.source);
+        text->append(L", dst = ").append(eventData.destination);
+        text->append(L", protocol = ").append(eventData.protocol);
+
+        if (!eventData.sourcePort.empty())
+        {
+            text->append(L", srcPort = ").append(eventData.sourcePort);
+        }
+
+        if (!eventData.destinationPort.empty())
+        {
+            text->append(L", dstPort = ").append(eventData.destinationPort);
+        }
+
+        if (!eventData.icmpType.empty())
+        {
+            text->append(L", icmp type = ").append(eventData.icmpType);
+        }
+
+        if (!eventData.isTcpSyn.empty())
+        {
+            text->append(L", isTcpSyn = ").append(eventData.isTcpSyn);
+        }
+
+        if (eventData.compact.sampleRate > 1)
+        {
+            text->append(L", sampleRate = 1/").append(std::to_wstring(eventData.compact.sampleRate));
+        }
+
+        text->append(L"} \n");
+
+        // Rule
+        text->append(L"  rule {id = ").append(eventData.ruleId);
+        text->append(L", layer = ").append(eventData.layerId);
+        text->append(L", group = ").append(eventData.groupId);
+        text->append(L", gftFlags = ").append(eventData.gftFlags);
+        text->append(L"} \n\n");
+    }
+
+    void FirewallEtwTraceCallback::FormatEventJson(
+        const VfpEventData& eventData,
+        std::wstring* text)
+    {
+        text->push_back(L'{');
+        AppendJsonField(text, L"date", eventData.date);
+        AppendJsonField(text, L"time", eventData.time);
+        AppendJsonField(text, L"direction", eventData.direction);
+        AppendJsonField(text, L"ruleType", eventData.ruleType);
+        AppendJsonField(text, L"status", eventData.status);
+        // Port
+        AppendJsonField(text, L"portId", eventData.portId);
+        AppendJsonField(text, L"portName", eventData.portName);
+        AppendJsonField(text, L"portFriendlyName", eventData.portFriendlyName);
+        // Flow
+        AppendJsonField(text, L"src", eventData.source);
+        AppendJsonField(text, L"dst", eventData.destination);
+        AppendJsonField(text, L"protocol", eventData.protocol);
+        AppendOptionalJsonField(text, L"srcPort", eventData.sourcePort);
+        AppendOptionalJsonField(text, L"dstPort", eventData.destinationPort);
+        AppendOptionalJsonField(text, L"icmpType", eventData.icmpType);
+        AppendOptionalJsonField(text, L"isTcpSyn", eventData.isTcpSyn);
+        if (eventData.compact.sampleRate > 1)
+        {
+            text->append(L",\"sampleRate\":").append(std::to_wstring(eventData.compact.sampleRate));
+        }
+        // Rule
+        AppendJsonField(text, L"ruleId", eventData.ruleId);
+        AppendJsonField(text, L"layerId", eventData.layerId);
+        AppendJsonField(text, L"groupId", eventData.groupId);
+        AppendJsonField(text, L"gftFlags", eventData.gftFlags);
+        text->append(L"}\n");
+    }
+
+    void FirewallEtwTraceCallback::FormatEventSyslog(
+        const VfpEventData& eventData,
+        std::wstring* text)
+    {
+        unsigned int severity = SYSLOG_SEVERITY_NOTICE;
+        if (eventData.compact.action == RuleAction::Deny)
+        {
+            severity = SYSLOG_SEVERITY_WARNING;
+        }
+        else if (eventData.compact.action == RuleAction::Allow)
+        {
+            severity = SYSLOG_SEVERITY_INFORMATIONAL;
+        }
+
+        // HEADER: <PRI>VERSION TIMESTAMP HOSTNAME APP-NAME PROCID MSGID, with the event's own time.
+        FILETIME fileTime;
+        fileTime.dwLowDateTime = static_cast<DWORD>(eventData.compact.timeStamp);
+        fileTime.dwHighDateTime = static_cast<DWORD>(eventData.compact.timeStamp >> 32);
+        SYSTEMTIME systemTime = {};
+        ::FileTimeToSystemTime(&fileTime, &systemTime);
+
+        WCHAR header[64];
+        swprintf_s(header, L"<%u>1 %04u-%02u-%02uT%02u:%02u:%02u.%03uZ ",
+            SYSLOG_FACILITY * 8 + severity,
+            systemTime.wYear,
+            systemTime.wMonth,
+            systemTime.wDay,
+            systemTime.wHour,
+            systemTime.wMinute,
+            systemTime.wSecond,
+            systemTime.wMilliseconds);
+        text->append(header);
+        text->append(SyslogHostName());
+        text->append(L" FirewallEventMonitor ");
+        text->append(std::to_wstring(::GetCurrentProcessId()));
+        text->push_back(L' ');
+        text->append(eventData.ruleType.empty() ? L"-" : eventData.ruleType);
+
+        // STRUCTURED-DATA
+        text->append(L" [").append(SYSLOG_SD_ID);
+        AppendSyslogParameter(text, L"direction", eventData.direction);
+        AppendSyslogParameter(text, L"ruleType", eventData.ruleType);
+        AppendSyslogParameter(text, L"status", eventData.status);
+        AppendSyslogParameter(text, L"portId", eventData.portId);
+        AppendSyslogParameter(text, L"portName", eventData.portName);
+        AppendSyslogParameter(text, L"portFriendlyName", eventData.portFriendlyName);
+        AppendSyslogParameter(text, L"src", eventData.source);
+        AppendSyslogParameter(text, L"dst", eventData.destination);
+        AppendSyslogParameter(text, L"protocol", eventData.protocol);
+        AppendSyslogParameter(text, L"srcPort", eventData.sourcePort);
+        AppendSyslogParameter(text, L"dstPort", eventData.destinationPort);
+        AppendSyslogParameter(text, L"icmpType", eventData.icmpType);
+        AppendSyslogParameter(text, L"isTcpSyn", eventData.isTcpSyn);
+        if (eventData.compact.sampleRate > 1)
+        {
+            AppendSyslogParameter(text, L"sampleRate", std::to_wstring(eventData.compact.sampleRate));
+        }
+        AppendSyslogParameter(text, L"ruleId", eventData.ruleId);
+        AppendSyslogParameter(text, L"layerId", eventData.layerId);
+        AppendSyslogParameter(text, L"groupId", eventData.groupId);
+        AppendSyslogParameter(text, L"gftFlags", eventData.gftFlags);
+        text->push_back(L']');
+
+        // MSG: a one-line summary for collectors that only show the message.
+        text->push_back(L' ');
+        text->append(eventData.direction).push_back(L' ');
+        text->append(eventData.ruleType).push_back(L' ');
+        text->append(eventData.protocol).push_back(L' ');
+        text->append(eventData.source);
+        if (!eventData.sourcePort.empty())
+        {
+            text->append(L":").append(eventData.sourcePort);
+        }
+        text->append(L" -> ").append(eventData.destination);
+        if (!eventData.destinationPort.empty())
+        {
+            text->append(L":").append(eventData.destinationPort);
+        }
+    }
+
+    void FirewallEtwTraceCallback::EncodeEvent(
+        EventFormat format,
+        const VfpEventData& eventData,
+        std::wstring* text)
+    {
+        switch (format)
+        {
+        case EventFormat::Json:
+            FormatEventJson(eventData, text);
+            break;
+        case EventFormat::Syslog:
+            FormatEventSyslog(eventData, text);
+            break;
+        default:
+            FormatEvent(eventData, text);
+        }
+    }
+}
@@ -1,84 +1,122 @@
-// Copyright (c) Microsoft Corporation. All rights reserved.
-// Licensed under the MIT License. See License.txt in the project root for license information.
-
-#pragma once
-
-// os headers
-#include <winsock2.h>
-// c++ headers
-#include <fstream>
-// ntl headers
-#include "ntlEtwReader.hpp"
-#include "ntlEtwRecord.hpp"
-#include "ntlEtwRecordQuery.hpp"
-
-#include "Timer.h"
-#include "EventCounter.h"
-#include "UserInput.h"
-#include "FileLogger.h"
-
-namespace FirewallEventMonitor
-{
-    class FirewallCaptureSession;
-
-    // Collection of Firewall event data.
-    struct VfpEventData
-    {
-    public:
-        std::wstring date;
-        std::wstring time;
-        std::wstring direction;
-        std::wstring ruleType;
-        std::wstring status;
-        // Port
-        std::wstring portId;
-        std::wstring portName;
-        std::wstring portFriendlyName;
-        // Flow
-        std::wstring source;
-        std::wstring destination;
-        std::wstring protocol;
-        std::wstring sourcePort;
-        std::wstring destinationPort;
-        std::wstring icmpType;
-        std::wstring isTcpSyn;
-        // Rule
-        std::wstring ruleId;
-        std::wstring layerId;
-        std::wstring groupId;
-        std::wstring gftFlags;
-    };
-
-    // Callback function for capturing events.
-    struct FirewallEtwTraceCallback
-    {
-    public:
-        FirewallEtwTraceCallback(
-            const std::weak_ptr<FirewallCaptureSession> eventWatcher,
-            const Parameters &parameters,
-            const std::shared_ptr<FileLogger> fileLogger,
-            const std::shared_ptr<Timer> timer,
-            const std::shared_ptr<EventCounter> eventCounter);
-
-        bool operator()(const PEVENT_RECORD pEventRecord);
-
-        bool ProcessEventRecord(const ntl::EtwRecord& record);
-
-        VfpEventData CollectEventData(const ntl::EtwRecord& record);
-
-        void OutputToConsole(const VfpEventData& eventData);
-
-        void OutputToFile(const VfpEventData& eventData);
-
-    private:
-        std::weak_ptr<FirewallCaptureSession> m_EventWatcher;
-        Parameters m_Parameters;
-        std::shared_ptr<FileLogger> m_FileLogger;
-        std::shared_ptr<Timer> m_Timer;
-        std::shared_ptr<EventCounter> m_EventCounter;
-
-        void OutputToStream(
-            const VfpEventData& eventData,
-            _In_ FILE *stream);
-    };
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#pragma once
+
+// os headers
+#include <winsock2.h>
+// c++ headers
+#include <fstream>
+// ntl headers
+#include "ntlEtwReader.hpp"
+#include "ntlEtwRecord.hpp"
+#include "ntlEtwRecordQuery.hpp"
+
+#include "Timer.h"
+#include "EventCounter.h"
+#include "UserInput.h"
+#include "FileLogger.h"
+#include "SinkGraph.h"
+#include "CompactEventRecord.h"
+#include "SchemaRegistry.h"
+
+namespace FirewallEventMonitor
+{
+    class FirewallCaptureSession;
+
+    // Collection of Firewall event data.
+    struct VfpEventData
+    {
+    public:
+        // Binary form of the fields below, for the analysis stages.
+        CompactEventRecord compact;
+        std::wstring date;
+        std::wstring time;
+        std::wstring direction;
+        std::wstring ruleType;
+        std::wstring status;
+        // Port
+        std::wstring portId;
+        std::wstring portName;
+        std::wstring portFriendlyName;
+        // Flow
+        std::wstring source;
+        std::wstring destination;
+        std::wstring protocol;
+        std::wstring sourcePort;
+        std::wstring destinationPort;
+        std::wstring icmpType;
+        std::wstring isTcpSyn;
+        // Rule
+        std::wstring ruleId;
+        std::wstring layerId;
+        std::wstring groupId;
+        std::wstring gftFlags;
+    };
+
+    // Callback function for capturing events.
+    struct FirewallEtwTraceCallback
+    {
+    public:
+        FirewallEtwTraceCallback(
+            const std::weak_ptr<FirewallCaptureSession> eventWatcher,
+            const Parameters &parameters,
+            const std::shared_ptr<FileLogger> fileLogger,
+            const std::shared_ptr<Timer> timer,
+            const std::shared_ptr<EventCounter> eventCounter,
+            const std::shared_ptr<SinkGraph> sinkGraph = nullptr,
+            const std::shared_ptr<const SchemaRegistry> schemaRegistry = nullptr);
+
+        bool operator()(const PEVENT_RECORD pEventRecord);
+
+        bool ProcessEventRecord(const ntl::EtwRecord& record);
+
+        // True for the VFP rule match events (IPv4, IPv6 and ICMP).
+        static bool IsRuleMatchEvent(const ntl::EtwRecord& record);
+
+        // Decodes a VFP rule match event.
+        // Static so offline readers (e.g. CaptureDiff) can decode saved events.
+        static VfpEventData CollectEventData(const ntl::EtwRecord& record);
+
+        // Appends the event as it is written to the console and log file.
+        static void FormatEvent(
+            const VfpEventData& eventData,
+            _Inout_ std::wstring* text);
+
+        // Appends the event as one line of JSON (-LogFormat Json).
+        static void FormatEventJson(
+            const VfpEventData& eventData,
+            _Inout_ std::wstring* text);
+
+        // Appends the event as an RFC 5424 syslog message, with the event fields as structured data.
+        static void FormatEventSyslog(
+            const VfpEventData& eventData,
+            _Inout_ std::wstring* text);
+
+        static void EncodeEvent(
+            EventFormat format,
+            const VfpEventData& eventData,
+            _Inout_ std::wstring* text);
+
+        // Used when there is no sink graph: writes the event directly on the calling thread.
+        void OutputToConsole(const VfpEventData& eventData);
+
+        void OutputToFile(const VfpEventData& eventData);
+
+    private:
+        std::weak_ptr<FirewallCaptureSession> m_EventWatcher;
+        Parameters m_Parameters;
+        std::shared_ptr<FileLogger> m_FileLogger;
+        std::shared_ptr<Timer> m_Timer;
+        std::shared_ptr<EventCounter> m_EventCounter;
+        std::shared_ptr<SinkGraph> m_SinkGraph;
+        // Events of every provider the session enabled; the VFP events alone when not given.
+        std::shared_ptr<const SchemaRegistry> m_SchemaRegistry;
+        // Reused for each event, so formatting does not allocate once it has grown.
+        std::wstring m_FormatBuffer;
+
+        void OutputToStream(
+            const VfpEventData& eventData,
+            _In_ FILE *stream);
+    };
 }
\ No newline at end of file
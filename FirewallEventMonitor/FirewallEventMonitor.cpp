@@ -1,81 +1,147 @@
-// Copyright (c) Microsoft Corporation. All rights reserved.
-// Licensed under the MIT License. See License.txt in the project root for license information.
-
-// c++ headers
-#include <atomic>
-#include <memory>
-
-#include "FirewallCaptureSession.h"
-
-using namespace FirewallEventMonitor;
-
-// Variable to track forced termination.
-std::atomic<bool> programTerminated = false;
-
-// CTRL+C handler to signal termination.
-BOOL WINAPI CtrlCHandler(DWORD fdwCtrlType)
-{
-    UNREFERENCED_PARAMETER(fdwCtrlType);
-    programTerminated = true;
-    return TRUE;
-}
-
-INT __cdecl wmain(
-    INT argc,
-    __in_ecount(argc) const wchar_t** argv
-) try
-{
-    UserInput input;
-    ArgumentParsingResults result =
-        input.ParseArguments(argc, argv);
-
-    if (result == ArgumentParsingResults::Fail) {
-        return ERROR_INVALID_DATA;
-    }
-    if (result == ArgumentParsingResults::Help) {
-        return ERROR_SUCCESS;
-    }
-
-    auto parameters = input.GetParameters();
-    auto captureSession = std::make_shared<FirewallCaptureSession>(parameters);
-    captureSession->OpenSession();
-
-    // CTRL+C handler to signal termination.
-    SetConsoleCtrlHandler(CtrlCHandler, TRUE);
-
-    wprintf(L"Events will appear below. Press Ctrl + C to end the session...\n");
-
-    while (captureSession->CaptureSessionRunning())
-    {
-        if (programTerminated ||
-            captureSession->TimeLimitReached())
-        {
-            break;
-        }
-
-        // If logging to file, close log file an open a new one on an interval (1 hour).
-        captureSession->LogFileIntervalCheck();
-
-        // Throttle the number of events recorded to prevent performance degredation during DDOS.
-        if (captureSession->EventCountLimitPerEpocReached())
-        {
-            double remainingTime = captureSession->GetTimeRemainingInEpoc();
-            if (remainingTime > 0.0)
-            {
-                wprintf(L"Event limit per epoc reached (%d). Sleeping for %f Milliseconds.\n",
-                    parameters.maxEventsPerEpoc,
-                    remainingTime);
-                DWORD sleep = static_cast<DWORD>(remainingTime);
-                Sleep(sleep);
-            }
-        }
-        captureSession->ResetEpoc();
-    }
-
-    return ERROR_SUCCESS;
-}
-catch (const std::exception &ex)
-{
-    wprintf(L"Exception: %S.\n", ex.what());
-    return ERROR_INVALID_DATA;
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+// c++ headers
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+#include "CaptureDiff.h"
+#include "FirewallCaptureSession.h"
+#include "SketchMerge.h"
+
+using namespace FirewallEventMonitor;
+
+// Variable to track forced termination.
+std::atomic<bool> programTerminated = false;
+
+// CTRL+C handler to signal termination.
+BOOL WINAPI CtrlCHandler(DWORD fdwCtrlType)
+{
+    UNREFERENCED_PARAMETER(fdwCtrlType);
+    programTerminated = true;
+    return TRUE;
+}
+
+INT __cdecl wmain(
+    INT argc,
+    __in_ecount(argc) const wchar_t** argv
+) try
+{
+    UserInput input;
+    ArgumentParsingResults result =
+        input.ParseArguments(argc, argv);
+
+    if (result == ArgumentParsingResults::Fail) {
+        return ERROR_INVALID_DATA;
+    }
+    if (result == ArgumentParsingResults::Help) {
+        return ERROR_SUCCESS;
+    }
+
+    auto parameters = input.GetParameters();
+
+    // Compare two existing captures; no session is started.
+    if (!parameters.diffCaptures.empty())
+    {
+        CaptureDiff captureDiff(
+            CaptureDiff::DefaultMaxEntriesInMemory,
+            CaptureDiff::DefaultReportLimit,
+            BatchFilter(parameters.ipAddressFilters, parameters.ruleIdFilters));
+        CaptureDiffReport report = captureDiff.Compare(
+            parameters.diffCaptures[0],
+            parameters.diffCaptures[1]);
+        CaptureDiff::PrintReport(report, stdout);
+        return ERROR_SUCCESS;
+    }
+
+    // Merge sketches written by -Sketch into fleet-wide reports; no session is started.
+    if (!parameters.mergeSketchesPath.empty())
+    {
+        std::vector<std::wstring> paths = SketchMerge::FindSketchFiles(parameters.mergeSketchesPath);
+        if (paths.empty())
+        {
+            wprintf(L"Error: No sketches found in %ls.\n", parameters.mergeSketchesPath.c_str());
+            return ERROR_FILE_NOT_FOUND;
+        }
+
+        SketchMerge sketchMerge;
+        SketchMergeResult mergeResult;
+        EventSketch sketch = sketchMerge.Merge(paths, &mergeResult);
+        SketchMerge::PrintReport(sketch, mergeResult, SketchMerge::DefaultReportLimit, stdout);
+        if (!parameters.mergeOutputPath.empty())
+        {
+            sketch.WriteFile(parameters.mergeOutputPath);
+        }
+        return ERROR_SUCCESS;
+    }
+
+    auto captureSession = std::make_shared<FirewallCaptureSession>(parameters);
+    captureSession->OpenSession();
+
+    // CTRL+C handler to signal termination.
+    SetConsoleCtrlHandler(CtrlCHandler, TRUE);
+
+    wprintf(L"Events will appear below. Press Ctrl + C to end the session...\n");
+
+    while (captureSession->CaptureSessionRunning())
+    {
+        if (programTerminated ||
+            captureSession->TimeLimitReached())
+        {
+            break;
+        }
+
+        // If logging to file, sync a durable log's pending writes, and close log file an open a new one on an interval (1 hour).
+        captureSession->LogFileIntervalCheck();
+
+        // Report event rate and the monitor's own cost on an interval.
+        captureSession->StatisticsIntervalCheck();
+
+        // Report rules whose hit rate departed from their baseline.
+        captureSession->AnomalyCheck();
+
+        // Report flows allowed one way and denied the other.
+        captureSession->FlowPairingCheck();
+
+        // Raise or lower the flow sample rate to stay within the lag and CPU budgets.
+        captureSession->AdaptiveSamplingCheck();
+
+        // Redraw the dashboard from the aggregates of the last interval.
+        captureSession->DashboardCheck();
+
+        // Write a sketch of the interval's events for the fleet merge.
+        captureSession->SketchCheck();
+
+        // Throttle the number of events recorded to prevent performance degredation during DDOS.
+        // The epoc (and its event count) only resets once the epoc has run its full second.
+        // With -ShedPriority the callback keeps admitting events by class, so the loop does not
+        // sleep out the epoc; the load shedder's counters report the drops instead.
+        double remainingTime = captureSession->GetTimeRemainingInEpoc();
+        if (remainingTime <= 0.0)
+        {
+            captureSession->ResetEpoc();
+            remainingTime = captureSession->EpocTimeInMilliseconds;
+        }
+        else if (parameters.shedPolicy.empty() &&
+            captureSession->EventCountLimitPerEpocReached())
+        {
+            captureSession->ReportEventLimitReached(remainingTime);
+            Sleep(static_cast<DWORD>(remainingTime));
+            continue;
+        }
+
+        // Events are delivered on the ETW processing thread; this loop only runs the periodic checks.
+        Sleep((std::min)(static_cast<DWORD>(remainingTime), captureSession->PollIntervalInMilliseconds));
+    }
+
+    // Stop intake and write the events in flight (within -DrainTimeout) before the files are closed.
+    captureSession->CloseSession();
+
+    return ERROR_SUCCESS;
+}
+catch (const std::exception &ex)
+{
+    wprintf(L"Exception: %S.\n", ex.what());
+    return ERROR_INVALID_DATA;
 }
\ No newline at end of file
@@ -0,0 +1,184 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include "FlowPairing.h"
+
+// ntl headers
+#include "ntlLocks.hpp"
+
+namespace FirewallEventMonitor
+{
+    const LONGLONG HUNDRED_NS_PER_SECOND = 10000000LL;
+
+    FlowKey FlowKey::FromRecord(const CompactEventRecord& record)
+    {
+        FlowKey key;
+        key.protocol = record.protocol;
+
+        int order = memcmp(&record.source, &record.destination, sizeof(IN6_ADDR));
+        if (order < 0 || (order == 0 && record.sourcePort <= record.destinationPort))
+        {
+            key.lowAddress = record.source;
+            key.lowPort = record.sourcePort;
+            key.highAddress = record.destination;
+            key.highPort = record.destinationPort;
+        }
+        else
+        {
+            key.lowAddress = record.destination;
+            key.lowPort = record.destinationPort;
+            key.highAddress = record.source;
+            key.highPort = record.sourcePort;
+        }
+        return key;
+    }
+
+    bool FlowKey::operator==(const FlowKey& other) const
+    {
+        return
+            lowPort == other.lowPort &&
+            highPort == other.highPort &&
+            protocol == other.protocol &&
+            memcmp(&lowAddress, &other.lowAddress, sizeof(IN6_ADDR)) == 0 &&
+            memcmp(&highAddress, &other.highAddress, sizeof(IN6_ADDR)) == 0;
+    }
+
+    size_t FlowKeyHash::operator()(const FlowKey& key) const
+    {
+        // FNV-1a over the key fields (not the struct, to stay clear of padding).
+        unsigned long long hash = 0xcbf29ce484222325ull;
+        auto mix = [&hash](const void* data, size_t size)
+        {
+            const unsigned char* bytes = static_cast<const unsigned char*>(data);
+            for (size_t i = 0; i < size; ++i)
+            {
+                hash ^= bytes[i];
+                hash *= 0x100000001b3ull;
+            }
+        };
+        mix(&key.lowAddress, sizeof(key.lowAddress));
+        mix(&key.highAddress, sizeof(key.highAddress));
+        mix(&key.lowPort, sizeof(key.lowPort));
+        mix(&key.highPort, sizeof(key.highPort));
+        mix(&key.protocol, sizeof(key.protocol));
+        return static_cast<size_t>(hash);
+    }
+
+    FlowPairing::FlowPairing(
+        unsigned long pairingWindowInSeconds,
+        size_t maxFlows)
+        : m_PairingWindowInSeconds(pairingWindowInSeconds),
+        m_MaxFlows(maxFlows)
+    {
+        ::InitializeCriticalSectionEx(&m_CriticalSection, 4000, 0);
+        // Reserve up front so the table never rehashes on the event path.
+        m_Flows.reserve(m_MaxFlows);
+        m_PendingAlerts.reserve(MaxPendingAlerts);
+    }
+
+    FlowPairing::~FlowPairing()
+    {
+        ::DeleteCriticalSection(&m_CriticalSection);
+    }
+
+    void FlowPairing::RecordEvent(const CompactEventRecord& record)
+    {
+        if (record.direction == TrafficDirection::Unknown ||
+            record.action == RuleAction::Unknown)
+        {
+            return;
+        }
+
+        LONGLONG second = record.timeStamp / HUNDRED_NS_PER_SECOND;
+        FlowKey key = FlowKey::FromRecord(record);
+
+        ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+
+        ExpireFlows(second);
+
+        auto found = m_Flows.find(key);
+        if (found != m_Flows.end() &&
+            found->second.expirySecond <= second)
+        {
+            // Expired, but the wheel has not reached it yet.
+            m_Expiry.cancel(found->second.expiry);
+            m_Flows.erase(found);
+            found = m_Flows.end();
+        }
+
+        if (found == m_Flows.end())
+        {
+            if (m_Flows.size() >= m_MaxFlows)
+            {
+                m_FlowsRejected++;
+                return;
+            }
+
+            FlowState state;
+            state.first = record;
+            state.expirySecond = second + m_PairingWindowInSeconds;
+            state.expiry = m_Expiry.schedule(state.expirySecond, key);
+            m_Flows.emplace(key, state);
+            return;
+        }
+
+        FlowState& state = found->second;
+        if (state.reported ||
+            state.first.direction == record.direction ||
+            state.first.action == record.action)
+        {
+            return;
+        }
+
+        // Report each asymmetric flow once per window.
+        state.reported = true;
+        if (m_PendingAlerts.size() >= MaxPendingAlerts)
+        {
+            m_AlertsDropped++;
+            return;
+        }
+
+        AsymmetricFlowAlert alert;
+        bool firstIsInbound = state.first.direction == TrafficDirection::Inbound;
+        alert.inbound = firstIsInbound ? state.first : record;
+        alert.outbound = firstIsInbound ? record : state.first;
+        m_PendingAlerts.push_back(alert);
+    }
+
+    std::vector<AsymmetricFlowAlert> FlowPairing::TakeAlerts()
+    {
+        std::vector<AsymmetricFlowAlert> alerts;
+        alerts.reserve(MaxPendingAlerts);
+
+        ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+        alerts.swap(m_PendingAlerts);
+        return alerts;
+    }
+
+    size_t FlowPairing::GetFlowCount()
+    {
+        ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+        return m_Flows.size();
+    }
+
+    unsigned long long FlowPairing::GetFlowsRejected()
+    {
+        ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+        return m_FlowsRejected;
+    }
+
+    unsigned long long FlowPairing::GetAlertsDropped()
+    {
+        ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+        return m_AlertsDropped;
+    }
+
+    void FlowPairing::ExpireFlows(LONGLONG second)
+    {
+        // A flow's timer is cancelled whenever the flow is replaced, so every expiry is current.
+        m_Expiry.advance(second, [this](const FlowKey& key)
+        {
+            m_Flows.erase(key);
+        }, ExpiryBudgetPerEvent);
+    }
+}
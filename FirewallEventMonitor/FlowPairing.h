@@ -0,0 +1,102 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#pragma once
+
+// OS Headers
+#include <Windows.h>
+// c++ headers
+#include <unordered_map>
+#include <vector>
+// ntl headers
+#include "ntlTimerWheel.hpp"
+
+#include "CompactEventRecord.h"
+
+namespace FirewallEventMonitor
+{
+    // Direction-independent flow identity: the endpoints are ordered so that an
+    // event and its reply (source and destination swapped) produce the same key.
+    struct FlowKey
+    {
+    public:
+        IN6_ADDR lowAddress = {};
+        IN6_ADDR highAddress = {};
+        unsigned short lowPort = 0;
+        unsigned short highPort = 0;
+        unsigned short protocol = 0;
+
+        static FlowKey FromRecord(const CompactEventRecord& record);
+
+        bool operator==(const FlowKey& other) const;
+    };
+
+    struct FlowKeyHash
+    {
+        size_t operator()(const FlowKey& key) const;
+    };
+
+    // Both directions of a flow were seen within the window, with different outcomes.
+    struct AsymmetricFlowAlert
+    {
+    public:
+        CompactEventRecord inbound;
+        CompactEventRecord outbound;
+    };
+
+    // Pairs events from opposite directions of the same flow and reports flows
+    // allowed one way and denied the other (e.g. inbound allowed, reply denied).
+    // Flows are forgotten pairingWindowInSeconds after their first event, measured
+    // in event time through a timer wheel, and the table is capped at maxFlows.
+    // Each event does at most ExpiryBudgetPerEvent units of expiry work, so a burst of
+    // flows expiring together is spread over the events that follow.
+    class FlowPairing
+    {
+    public:
+        FlowPairing(
+            unsigned long pairingWindowInSeconds,
+            size_t maxFlows = DefaultMaxFlows);
+
+        ~FlowPairing();
+
+        void RecordEvent(const CompactEventRecord& record);
+
+        // Returns the alerts raised since the previous call.
+        std::vector<AsymmetricFlowAlert> TakeAlerts();
+
+        size_t GetFlowCount();
+
+        // Flows not tracked because the table was full.
+        unsigned long long GetFlowsRejected();
+
+        // Alerts discarded because nobody collected them in time.
+        unsigned long long GetAlertsDropped();
+
+        // Constants
+        static const size_t DefaultMaxFlows = 65536;
+        static const size_t MaxPendingAlerts = 1024;
+        static const size_t ExpiryBudgetPerEvent = 64;
+
+        FlowPairing(FlowPairing const&) = delete;
+        FlowPairing& operator=(FlowPairing const&) = delete;
+    private:
+        struct FlowState
+        {
+            CompactEventRecord first; // First event seen for the flow.
+            LONGLONG expirySecond = 0; // Expired from this second, even if the wheel is behind.
+            ntl::TimerWheel<FlowKey>::timer_id expiry = ntl::TimerWheel<FlowKey>::invalid_timer;
+            bool reported = false;
+        };
+
+        CRITICAL_SECTION m_CriticalSection;
+        std::unordered_map<FlowKey, FlowState, FlowKeyHash> m_Flows;
+        ntl::TimerWheel<FlowKey> m_Expiry;
+        std::vector<AsymmetricFlowAlert> m_PendingAlerts;
+        const LONGLONG m_PairingWindowInSeconds;
+        const size_t m_MaxFlows;
+        unsigned long long m_FlowsRejected = 0;
+        unsigned long long m_AlertsDropped = 0;
+
+        void ExpireFlows(LONGLONG second);
+    };
+}
@@ -0,0 +1,158 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include "FlowSampler.h"
+
+// c++ headers
+#include <limits>
+#if defined(_M_X64)
+#include <intrin.h>
+#endif
+
+#include "FlowPairing.h"
+
+namespace FirewallEventMonitor
+{
+    namespace
+    {
+        // Seed and multipliers from wyhash. Fixed, so every host hashes a flow the same way.
+        const unsigned long long FLOW_HASH_SEED = 0xa0761d6478bd642full;
+        const unsigned long long FLOW_HASH_PRIME1 = 0xe7037ed1a0b428dbull;
+        const unsigned long long FLOW_HASH_PRIME2 = 0x8ebc6af09c88c6e3ull;
+
+        // 64x64 -> 128 bit multiply, folded back to 64 bits.
+        unsigned long long Mix(unsigned long long a, unsigned long long b)
+        {
+#if defined(_M_X64)
+            unsigned long long high = 0;
+            unsigned long long low = _umul128(a, b, &high);
+            return low ^ high;
+#else
+            unsigned long long aLow = a & 0xffffffffull, aHigh = a >> 32;
+            unsigned long long bLow = b & 0xffffffffull, bHigh = b >> 32;
+            unsigned long long lowLow = aLow * bLow;
+            unsigned long long lowHigh = aLow * bHigh;
+            unsigned long long highLow = aHigh * bLow;
+            unsigned long long highHigh = aHigh * bHigh;
+            unsigned long long middle = (lowLow >> 32) + (lowHigh & 0xffffffffull) + (highLow & 0xffffffffull);
+            unsigned long long low = (middle << 32) | (lowLow & 0xffffffffull);
+            unsigned long long high = highHigh + (lowHigh >> 32) + (highLow >> 32) + (middle >> 32);
+            return low ^ high;
+#endif
+        }
+
+        unsigned long long ReadAddressWord(const IN6_ADDR& address, size_t index)
+        {
+            unsigned long long word = 0;
+            memcpy(&word, reinterpret_cast<const unsigned char*>(&address) + index * sizeof(word), sizeof(word));
+            return word;
+        }
+
+        bool ParseDecimal(const wchar_t* text, _Out_ unsigned long* value)
+        {
+            *value = 0;
+            if (*text == L'\0')
+            {
+                return false;
+            }
+            const unsigned long maximum = (std::numeric_limits<unsigned long>::max)();
+            unsigned long parsed = 0;
+            for (; *text != L'\0'; ++text)
+            {
+                if (*text < L'0' || *text > L'9')
+                {
+                    return false;
+                }
+                unsigned long digit = static_cast<unsigned long>(*text - L'0');
+                if (parsed > (maximum - digit) / 10)
+                {
+                    return false;
+                }
+                parsed = parsed * 10 + digit;
+            }
+            *value = parsed;
+            return true;
+        }
+    }
+
+    FlowSampler::FlowSampler(unsigned long sampleRate)
+    {
+        SetSampleRate(sampleRate);
+    }
+
+    bool FlowSampler::Sample(CompactEventRecord* record)
+    {
+        if (FlowHash(*record) > m_Threshold.load(std::memory_order_relaxed))
+        {
+            m_Counters.add(record->processor, EventsSkipped);
+            return false;
+        }
+
+        record->sampleRate = m_SampleRate.load(std::memory_order_relaxed);
+        m_Counters.add(record->processor, EventsKept);
+        return true;
+    }
+
+    unsigned long long FlowSampler::FlowHash(const CompactEventRecord& record)
+    {
+        // Hash the ordered endpoints so an event and its reply land on the same value.
+        // Words are read in host (little-endian) order, the same on every Windows host.
+        FlowKey key = FlowKey::FromRecord(record);
+        unsigned long long ports =
+            static_cast<unsigned long long>(key.lowPort) |
+            (static_cast<unsigned long long>(key.highPort) << 16) |
+            (static_cast<unsigned long long>(key.protocol) << 32);
+
+        unsigned long long hash = Mix(
+            ReadAddressWord(key.lowAddress, 0) ^ FLOW_HASH_PRIME1,
+            ReadAddressWord(key.lowAddress, 1) ^ FLOW_HASH_SEED);
+        hash = Mix(
+            ReadAddressWord(key.highAddress, 0) ^ FLOW_HASH_PRIME1,
+            ReadAddressWord(key.highAddress, 1) ^ hash);
+        hash = Mix(ports ^ FLOW_HASH_PRIME1, hash ^ FLOW_HASH_SEED);
+        return Mix(hash ^ FLOW_HASH_PRIME2, FLOW_HASH_PRIME1);
+    }
+
+    bool FlowSampler::ParseSampleRate(const std::wstring& text, unsigned long* sampleRate)
+    {
+        *sampleRate = 0;
+        const wchar_t* denominator = text.c_str();
+        if (text.size() > 2 && text[0] == L'1' && text[1] == L'/')
+        {
+            denominator += 2;
+        }
+
+        unsigned long rate = 0;
+        if (!ParseDecimal(denominator, &rate) || rate == 0)
+        {
+            return false;
+        }
+        *sampleRate = rate;
+        return true;
+    }
+
+    unsigned long FlowSampler::GetSampleRate() const
+    {
+        return m_SampleRate.load(std::memory_order_relaxed);
+    }
+
+    void FlowSampler::SetSampleRate(unsigned long sampleRate)
+    {
+        if (sampleRate == 0)
+        {
+            sampleRate = 1;
+        }
+        m_Threshold.store((std::numeric_limits<unsigned long long>::max)() / sampleRate, std::memory_order_relaxed);
+        m_SampleRate.store(sampleRate, std::memory_order_relaxed);
+    }
+
+    unsigned long long FlowSampler::GetEventsKept() const
+    {
+        return m_Counters.sum(EventsKept);
+    }
+
+    unsigned long long FlowSampler::GetEventsSkipped() const
+    {
+        return m_Counters.sum(EventsSkipped);
+    }
+}
@@ -0,0 +1,58 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#pragma once
+
+// OS Headers
+#include <Windows.h>
+// c++ headers
+#include <atomic>
+#include <string>
+// ntl headers
+#include "ntlShardedCounters.hpp"
+
+#include "CompactEventRecord.h"
+
+namespace FirewallEventMonitor
+{
+    // Keeps every event of 1 in sampleRate flows and drops the rest.
+    // The decision is a fixed-seed hash of the direction-independent 5-tuple, so both
+    // directions of a flow, every host, and every restart make the same choice, and a
+    // flow kept at 1/N is also kept at any higher rate (1/M with M < N).
+    // Kept records are stamped with the rate so counts can be scaled back up.
+    class FlowSampler
+    {
+    public:
+        explicit FlowSampler(unsigned long sampleRate);
+
+        // Returns true if the record's flow is in the sample, and sets record->sampleRate.
+        bool Sample(_Inout_ CompactEventRecord* record);
+
+        // Same value on every host for the same flow, in either direction.
+        static unsigned long long FlowHash(const CompactEventRecord& record);
+
+        // Parses "1/N" or "N". N must be at least 1.
+        static bool ParseSampleRate(const std::wstring& text, _Out_ unsigned long* sampleRate);
+
+        unsigned long GetSampleRate() const;
+
+        // Takes effect from the next event. Raising the rate only drops flows, and
+        // lowering it only adds flows back, so kept flows stay complete.
+        void SetSampleRate(unsigned long sampleRate);
+
+        unsigned long long GetEventsKept() const;
+
+        unsigned long long GetEventsSkipped() const;
+
+        FlowSampler(FlowSampler const&) = delete;
+        FlowSampler& operator=(FlowSampler const&) = delete;
+    private:
+        // Changed by the main thread (adaptive sampling) while the ETW callback reads them.
+        std::atomic<unsigned long> m_SampleRate{ 1 };
+        // Flows whose hash is at or below this are kept.
+        std::atomic<unsigned long long> m_Threshold{ 0 };
+        // Sharded by the processor that logged the event; summed for reporting.
+        enum Counter { EventsKept, EventsSkipped, CounterCount };
+        ntl::ShardedCounters<CounterCount> m_Counters;
+    };
+}
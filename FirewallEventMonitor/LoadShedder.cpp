@@ -0,0 +1,223 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include "LoadShedder.h"
+
+// c++ headers
+#include <sstream>
+// ntl headers
+#include "ntlString.hpp"
+
+namespace FirewallEventMonitor
+{
+    namespace
+    {
+        const LONGLONG HUNDRED_NS_PER_SECOND = 10000000LL;
+        const unsigned short ICMPV4_PROTOCOL = 1;
+        const unsigned short TCP_PROTOCOL = 6;
+        const unsigned short ICMPV6_PROTOCOL = 58;
+
+        bool ParseEventClass(const std::wstring& name, _Out_ EventClass* eventClass)
+        {
+            for (size_t i = 0; i < static_cast<size_t>(EventClass::Count); ++i)
+            {
+                EventClass candidate = static_cast<EventClass>(i);
+                if (ntl::String::iordinal_equals(name, LoadShedder::EventClassName(candidate)))
+                {
+                    *eventClass = candidate;
+                    return true;
+                }
+            }
+            return false;
+        }
+    }
+
+    LoadShedder::LoadShedder(
+        unsigned long eventsPerSecond,
+        const std::vector<ShedClassPolicy>& priorityOrder)
+        : m_EventsPerSecond(eventsPerSecond),
+        m_Policy(priorityOrder)
+    {
+        // Complete the policy so every event has a class.
+        bool listed[ClassCount] = {};
+        for (const auto& entry : m_Policy)
+        {
+            listed[static_cast<size_t>(entry.eventClass)] = true;
+        }
+        for (const auto& entry : DefaultPolicy())
+        {
+            if (!listed[static_cast<size_t>(entry.eventClass)])
+            {
+                ShedClassPolicy missing;
+                missing.eventClass = entry.eventClass;
+                m_Policy.push_back(missing);
+            }
+        }
+
+        unsigned long reservedTotal = 0;
+        for (const auto& entry : m_Policy)
+        {
+            unsigned long reserved = static_cast<unsigned long>(
+                static_cast<unsigned long long>(m_EventsPerSecond) * entry.reservedPercent / 100);
+            m_Reserved[static_cast<size_t>(entry.eventClass)] = reserved;
+            reservedTotal += reserved;
+        }
+        m_SharedPerSecond = reservedTotal < m_EventsPerSecond ? m_EventsPerSecond - reservedTotal : 0;
+
+    }
+
+    bool LoadShedder::Admit(const CompactEventRecord& record)
+    {
+        // Budgets follow event time, so a backlog delivered late is judged by when it happened.
+        // Events from an earlier second (ETW buffers flush out of order) charge the current one.
+        LONGLONG second = record.timeStamp / HUNDRED_NS_PER_SECOND;
+        if (second > m_Second)
+        {
+            Refill(second);
+        }
+
+        size_t index = static_cast<size_t>(Classify(record));
+        if (m_ReserveRemaining[index] > 0)
+        {
+            m_ReserveRemaining[index]--;
+        }
+        else if (m_SharedRemaining > 0)
+        {
+            m_SharedRemaining--;
+        }
+        else
+        {
+            m_Counters.add(record.processor, ClassCount + index);
+            return false;
+        }
+
+        m_Counters.add(record.processor, index);
+        return true;
+    }
+
+    EventClass LoadShedder::Classify(const CompactEventRecord& record) const
+    {
+        for (const auto& entry : m_Policy)
+        {
+            if (Matches(entry.eventClass, record))
+            {
+                return entry.eventClass;
+            }
+        }
+        return EventClass::Allow;
+    }
+
+    bool LoadShedder::Matches(EventClass eventClass, const CompactEventRecord& record) const
+    {
+        switch (eventClass)
+        {
+        case EventClass::Deny:
+            return record.action == RuleAction::Deny;
+        case EventClass::Icmp:
+            return record.protocol == ICMPV4_PROTOCOL || record.protocol == ICMPV6_PROTOCOL;
+        case EventClass::TcpSyn:
+            return record.protocol == TCP_PROTOCOL && record.isTcpSyn;
+        default:
+            // Every event that was not denied, including those whose RuleType was missing.
+            return record.action != RuleAction::Deny;
+        }
+    }
+
+    void LoadShedder::Refill(LONGLONG second)
+    {
+        m_Second = second;
+        for (size_t i = 0; i < ClassCount; ++i)
+        {
+            m_ReserveRemaining[i] = m_Reserved[i];
+        }
+        m_SharedRemaining = m_SharedPerSecond;
+    }
+
+    ShedClassCounters LoadShedder::GetCounters(EventClass eventClass) const
+    {
+        size_t index = static_cast<size_t>(eventClass);
+        ShedClassCounters counters;
+        counters.kept = m_Counters.sum(index);
+        counters.dropped = m_Counters.sum(ClassCount + index);
+        return counters;
+    }
+
+    const std::vector<ShedClassPolicy>& LoadShedder::GetPolicy() const
+    {
+        return m_Policy;
+    }
+
+    std::vector<ShedClassPolicy> LoadShedder::DefaultPolicy()
+    {
+        std::vector<ShedClassPolicy> policy(4);
+        policy[0].eventClass = EventClass::Deny;
+        policy[0].reservedPercent = 25;
+        policy[1].eventClass = EventClass::Icmp;
+        policy[1].reservedPercent = 10;
+        policy[2].eventClass = EventClass::TcpSyn;
+        policy[2].reservedPercent = 15;
+        policy[3].eventClass = EventClass::Allow;
+        policy[3].reservedPercent = 0;
+        return policy;
+    }
+
+    bool LoadShedder::ParsePolicy(const std::wstring& text, std::vector<ShedClassPolicy>* policy)
+    {
+        policy->clear();
+        if (ntl::String::iordinal_equals(text, L"Default"))
+        {
+            *policy = DefaultPolicy();
+            return true;
+        }
+
+        bool listed[ClassCount] = {};
+        unsigned long reservedTotal = 0;
+        std::wistringstream entries(text);
+        std::wstring entry;
+        while (std::getline(entries, entry, L','))
+        {
+            ShedClassPolicy parsed;
+            size_t colon = entry.find(L':');
+            if (!ParseEventClass(entry.substr(0, colon), &parsed.eventClass) ||
+                listed[static_cast<size_t>(parsed.eventClass)])
+            {
+                return false;
+            }
+
+            if (colon != std::wstring::npos)
+            {
+                std::wstring percent = entry.substr(colon + 1);
+                if (percent.empty() ||
+                    percent.size() > 3 ||
+                    percent.find_first_not_of(L"0123456789") != std::wstring::npos)
+                {
+                    return false;
+                }
+                parsed.reservedPercent = std::stoul(percent);
+            }
+
+            reservedTotal += parsed.reservedPercent;
+            if (reservedTotal > 100)
+            {
+                return false;
+            }
+
+            listed[static_cast<size_t>(parsed.eventClass)] = true;
+            policy->push_back(parsed);
+        }
+
+        return !policy->empty();
+    }
+
+    LPCWSTR LoadShedder::EventClassName(EventClass eventClass)
+    {
+        switch (eventClass)
+        {
+        case EventClass::Deny: return L"Deny";
+        case EventClass::Icmp: return L"Icmp";
+        case EventClass::TcpSyn: return L"TcpSyn";
+        case EventClass::Allow: return L"Allow";
+        default: return L"Unknown";
+        }
+    }
+}
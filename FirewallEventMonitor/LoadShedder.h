@@ -0,0 +1,91 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#pragma once
+
+// OS Headers
+#include <Windows.h>
+// c++ headers
+#include <string>
+#include <vector>
+// ntl headers
+#include "ntlShardedCounters.hpp"
+
+#include "CompactEventRecord.h"
+
+namespace FirewallEventMonitor
+{
+    // Classes of events, from which a shedding policy picks a priority order.
+    enum class EventClass : unsigned char { Deny = 0, Icmp = 1, TcpSyn = 2, Allow = 3, Count = 4 };
+
+    // One class in a shedding policy: the share of the per-second budget held for it.
+    struct ShedClassPolicy
+    {
+    public:
+        EventClass eventClass = EventClass::Allow;
+        unsigned long reservedPercent = 0;
+    };
+
+    struct ShedClassCounters
+    {
+    public:
+        unsigned long long kept = 0;
+        unsigned long long dropped = 0;
+    };
+
+    // Replaces the arrival-order throttle with per-class token budgets, so a flood of
+    // one kind of event (typically allows) cannot starve rarer, more important ones.
+    // Each second of event time, every class gets its reserved share of the budget and
+    // the rest forms a shared pool. An event spends its class's reserve first, then the
+    // pool; once both are gone it is dropped. Classes without a reserve are therefore
+    // shed first, and higher classes keep their reserved share however busy the rest is.
+    // An event belongs to the first class in the policy's priority order that it matches.
+    class LoadShedder
+    {
+    public:
+        LoadShedder(
+            unsigned long eventsPerSecond,
+            const std::vector<ShedClassPolicy>& priorityOrder);
+
+        // Returns true if the event fits the budget for its second and class.
+        bool Admit(const CompactEventRecord& record);
+
+        EventClass Classify(const CompactEventRecord& record) const;
+
+        ShedClassCounters GetCounters(EventClass eventClass) const;
+
+        // The policy in priority order, completed with any classes it left out.
+        const std::vector<ShedClassPolicy>& GetPolicy() const;
+
+        // Deny:25,Icmp:10,TcpSyn:15,Allow:0
+        static std::vector<ShedClassPolicy> DefaultPolicy();
+
+        // Parses "Class[:percent],..." in priority order, or "Default".
+        // Classes left out follow at the lowest priority with no reserve.
+        static bool ParsePolicy(const std::wstring& text, _Out_ std::vector<ShedClassPolicy>* policy);
+
+        static LPCWSTR EventClassName(EventClass eventClass);
+
+        LoadShedder(LoadShedder const&) = delete;
+        LoadShedder& operator=(LoadShedder const&) = delete;
+    private:
+        static const size_t ClassCount = static_cast<size_t>(EventClass::Count);
+
+        bool Matches(EventClass eventClass, const CompactEventRecord& record) const;
+
+        void Refill(LONGLONG second);
+
+        unsigned long m_EventsPerSecond;
+        std::vector<ShedClassPolicy> m_Policy;
+        // Indexed by EventClass.
+        unsigned long m_Reserved[ClassCount] = {};
+        unsigned long m_SharedPerSecond = 0;
+        // Tokens left in the current second. Only touched by the ETW callback thread.
+        LONGLONG m_Second = -1;
+        unsigned long m_ReserveRemaining[ClassCount] = {};
+        unsigned long m_SharedRemaining = 0;
+        // Kept events of each class, then dropped events of each class, sharded by the
+        // processor that logged the event; summed for reporting from the main thread.
+        ntl::ShardedCounters<2 * ClassCount> m_Counters;
+    };
+}
@@ -0,0 +1,30 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#pragma once
+
+// os headers
+#include <Windows.h>
+
+namespace FirewallEventMonitor
+{
+    // Log file that does its own I/O and takes bytes from several threads at once
+    // (MappedLogFile, OverlappedLogFile). FileLogger swaps in a new one at each rotation.
+    class LogFileWriter
+    {
+    public:
+        virtual ~LogFileWriter() = default;
+
+        // Returns false if the bytes were not written.
+        virtual bool Append(_In_reads_bytes_(length) const void* data, size_t length) = 0;
+
+        // Starts writing what was appended so far to disk, without waiting for it.
+        virtual void Flush() = 0;
+
+        // No Append() may be in progress or made afterwards.
+        virtual void Close() = 0;
+
+        // Bytes appended so far.
+        virtual unsigned long long GetLength() const = 0;
+    };
+}
@@ -0,0 +1,280 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include "MappedLogFile.h"
+// c++ headers
+#include <algorithm>
+// ntl headers
+#include "ntlLocks.hpp"
+#include "ntlString.hpp"
+
+namespace FirewallEventMonitor
+{
+    MappedLogFile::MappedLogFile(
+        const std::wstring& path,
+        size_t segmentBytes)
+        : m_Path(path)
+    {
+        // Views must start on an allocation granularity boundary.
+        SYSTEM_INFO systemInfo;
+        ::GetSystemInfo(&systemInfo);
+        m_Granularity = systemInfo.dwAllocationGranularity;
+        size_t units = (segmentBytes + m_Granularity - 1) / m_Granularity;
+        m_SegmentBytes = (std::max)(units, static_cast<size_t>(2)) * m_Granularity;
+
+        // Others may read the log while it is written.
+        m_File = ::CreateFileW(
+            path.c_str(),
+            GENERIC_READ | GENERIC_WRITE,
+            FILE_SHARE_READ,
+            NULL,
+            CREATE_ALWAYS,
+            FILE_ATTRIBUTE_NORMAL,
+            NULL);
+        if (m_File == INVALID_HANDLE_VALUE)
+        {
+            std::string errorMessage = "Unable to open log file ";
+            errorMessage += ntl::String::convert_to_string(path);
+            throw std::exception(errorMessage.c_str());
+        }
+
+        ::InitializeCriticalSectionEx(&m_CriticalSection, 4000, 0);
+
+        std::unique_ptr<Segment> first = MapSegment(0);
+        if (!first)
+        {
+            DWORD error = ::GetLastError();
+            ::CloseHandle(m_File);
+            ::DeleteCriticalSection(&m_CriticalSection);
+            std::string errorMessage = "Unable to map log file ";
+            errorMessage += ntl::String::convert_to_string(path);
+            errorMessage += " (error " + std::to_string(error) + ")";
+            throw std::exception(errorMessage.c_str());
+        }
+        m_Current = first.get();
+        m_Segments.push_back(std::move(first));
+    }
+
+    MappedLogFile::~MappedLogFile()
+    {
+        Close();
+        ::DeleteCriticalSection(&m_CriticalSection);
+    }
+
+    bool MappedLogFile::Append(const void* data, size_t length)
+    {
+        if (length == 0)
+        {
+            return true;
+        }
+
+        if (length > GetMaxAppendBytes())
+        {
+            return false;
+        }
+
+        for (;;)
+        {
+            Segment* segment = m_Current.load();
+            if (segment == nullptr)
+            {
+                return false;
+            }
+
+            size_t offset = segment->reserved.fetch_add(length);
+            if (offset + length <= m_SegmentBytes)
+            {
+                memcpy(segment->view + offset, data, length);
+                FinishWrite(segment, length);
+                return true;
+            }
+
+            if (offset <= m_SegmentBytes)
+            {
+                // Reservations are handed out end to end, so exactly one crosses the end of the
+                // segment. Its writer seals the segment there and maps the next one.
+                MapNextSegment(segment, offset);
+            }
+            else
+            {
+                // Another writer sealed the segment and is mapping the next one.
+                while (m_Current.load() == segment)
+                {
+                    ::SwitchToThread();
+                }
+            }
+        }
+    }
+
+    void MappedLogFile::Flush()
+    {
+        ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+
+        Segment* segment = m_Current.load();
+        if (segment != nullptr &&
+            !segment->unmapped)
+        {
+            ::FlushViewOfFile(segment->view, 0);
+        }
+    }
+
+    void MappedLogFile::Close()
+    {
+        ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+
+        if (m_File == INVALID_HANDLE_VALUE)
+        {
+            return;
+        }
+
+        Segment* current = m_Current.exchange(nullptr);
+        if (current != nullptr)
+        {
+            m_FinalLength = current->fileOffset + (std::min)(current->reserved.load(), m_SegmentBytes);
+        }
+
+        // The file cannot be cut while any of it is mapped.
+        for (auto& segment : m_Segments)
+        {
+            if (!segment->unmapped)
+            {
+                ::UnmapViewOfFile(segment->view);
+                segment->unmapped = true;
+            }
+        }
+
+        LARGE_INTEGER end;
+        end.QuadPart = static_cast<LONGLONG>(m_FinalLength);
+        if (!::SetFilePointerEx(m_File, end, NULL, FILE_BEGIN) ||
+            !::SetEndOfFile(m_File))
+        {
+            wprintf(L"Warning: Unable to trim log file %ls to %llu bytes [%lu]; it ends in zeros.\n",
+                m_Path.c_str(),
+                m_FinalLength,
+                ::GetLastError());
+        }
+
+        ::CloseHandle(m_File);
+        m_File = INVALID_HANDLE_VALUE;
+    }
+
+    unsigned long long MappedLogFile::GetLength() const
+    {
+        Segment* segment = m_Current.load();
+        if (segment == nullptr)
+        {
+            return m_FinalLength;
+        }
+        return segment->fileOffset + (std::min)(segment->reserved.load(), m_SegmentBytes);
+    }
+
+    unsigned long long MappedLogFile::GetSegmentsMapped() const
+    {
+        ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+
+        return m_Segments.size();
+    }
+
+    size_t MappedLogFile::GetSegmentBytes() const
+    {
+        return m_SegmentBytes;
+    }
+
+    size_t MappedLogFile::GetMaxAppendBytes() const
+    {
+        // A new segment can start up to a granularity unit before the data it continues.
+        return m_SegmentBytes - m_Granularity;
+    }
+
+    std::unique_ptr<MappedLogFile::Segment> MappedLogFile::MapSegment(unsigned long long fileOffset)
+    {
+        unsigned long long viewOffset = fileOffset - fileOffset % m_Granularity;
+
+        // A mapping larger than the file extends the file, which is what preallocates the segment.
+        ULARGE_INTEGER mappingSize;
+        mappingSize.QuadPart = viewOffset + m_SegmentBytes;
+        HANDLE mapping = ::CreateFileMappingW(
+            m_File,
+            NULL,
+            PAGE_READWRITE,
+            mappingSize.HighPart,
+            mappingSize.LowPart,
+            NULL);
+        if (mapping == NULL)
+        {
+            return nullptr;
+        }
+
+        ULARGE_INTEGER viewStart;
+        viewStart.QuadPart = viewOffset;
+        void* view = ::MapViewOfFile(
+            mapping,
+            FILE_MAP_WRITE,
+            viewStart.HighPart,
+            viewStart.LowPart,
+            m_SegmentBytes);
+        // The view keeps the mapping open.
+        DWORD error = ::GetLastError();
+        ::CloseHandle(mapping);
+        if (view == NULL)
+        {
+            ::SetLastError(error);
+            return nullptr;
+        }
+
+        auto segment = std::make_unique<Segment>();
+        segment->fileOffset = viewOffset;
+        segment->view = static_cast<char*>(view);
+        size_t previousBytes = static_cast<size_t>(fileOffset - viewOffset);
+        segment->reserved = previousBytes;
+        segment->written = previousBytes;
+        return segment;
+    }
+
+    void MappedLogFile::MapNextSegment(Segment* segment, size_t sealedAt)
+    {
+        {
+            ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+
+            unsigned long long end = segment->fileOffset + sealedAt;
+            std::unique_ptr<Segment> next = MapSegment(end);
+            if (next)
+            {
+                m_Segments.push_back(std::move(next));
+                m_Current = m_Segments.back().get();
+            }
+            else
+            {
+                wprintf(L"Warning: Unable to map more of log file %ls [%lu]; events are no longer written to it.\n",
+                    m_Path.c_str(),
+                    ::GetLastError());
+                m_FinalLength = end;
+                m_Current = nullptr;
+            }
+        }
+
+        segment->sealedAt = sealedAt;
+        FinishWrite(segment, 0);
+    }
+
+    void MappedLogFile::FinishWrite(Segment* segment, size_t length)
+    {
+        // Either the last writer or the sealing writer sees the segment complete, or both do.
+        size_t written = segment->written.fetch_add(length) + length;
+        if (written == segment->sealedAt.load())
+        {
+            Unmap(segment);
+        }
+    }
+
+    void MappedLogFile::Unmap(Segment* segment)
+    {
+        ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+
+        if (!segment->unmapped)
+        {
+            ::UnmapViewOfFile(segment->view);
+            segment->unmapped = true;
+        }
+    }
+}
@@ -0,0 +1,105 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#pragma once
+
+// os headers
+#include <Windows.h>
+// c++ headers
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "LogFileWriter.h"
+
+namespace FirewallEventMonitor
+{
+    // Log file written through memory mapped segments (-Mapped).
+    //
+    // The file is grown a whole segment at a time and each segment is mapped into memory, so
+    // appending is a copy into the mapped view: no write call, and no change to the file's size
+    // or allocation for every event. Writers reserve space with an atomic add on the segment's
+    // offset, so any number of threads can append at once without a lock. The writer whose
+    // reservation crosses the end of a segment seals it at its offset and maps the next segment
+    // to start exactly there; a segment is unmapped once every write into it has finished.
+    //
+    // Until it is closed the file is longer than its contents, with zeros after the last record.
+    // Close() trims it to the bytes appended.
+    class MappedLogFile : public LogFileWriter
+    {
+    public:
+        // Creates (or replaces) the file and maps its first segment. Throws if either fails.
+        // segmentBytes is rounded up to whole allocation granularity units (64 KB), at least two.
+        MappedLogFile(
+            const std::wstring& path,
+            size_t segmentBytes = DefaultSegmentBytes);
+
+        // Closes the file if Close() was not called.
+        ~MappedLogFile() override;
+
+        // Copies data to the end of the file; safe to call from any number of threads at once.
+        // Returns false if it was not written: it is larger than GetMaxAppendBytes(), the file is
+        // closed, or the next segment could not be mapped (after which every append fails).
+        bool Append(_In_reads_bytes_(length) const void* data, size_t length) override;
+
+        // Starts writing the current segment's changes to disk, without waiting for them.
+        void Flush() override;
+
+        // Unmaps the segments and trims the file to its contents.
+        // No Append() may be in progress or made afterwards.
+        void Close() override;
+
+        // Bytes appended so far.
+        unsigned long long GetLength() const override;
+
+        unsigned long long GetSegmentsMapped() const;
+
+        size_t GetSegmentBytes() const;
+
+        size_t GetMaxAppendBytes() const;
+
+        // Constants
+        static const size_t DefaultSegmentBytes = 64 * 1024 * 1024;
+
+        MappedLogFile(MappedLogFile const&) = delete;
+        MappedLogFile& operator=(MappedLogFile const&) = delete;
+    private:
+        // One mapped view of m_SegmentBytes. The view starts on an allocation granularity boundary
+        // at or before the end of the previous segment; the bytes before that end belong to the
+        // previous segment, so reserved and written both start past them.
+        struct Segment
+        {
+            unsigned long long fileOffset = 0; // Of the first byte of the view.
+            char* view = nullptr;
+            std::atomic<size_t> reserved{ 0 };
+            std::atomic<size_t> written{ 0 };
+            std::atomic<size_t> sealedAt{ SIZE_MAX }; // Offset of the end of its data once sealed.
+            bool unmapped = false; // Guarded by m_CriticalSection.
+        };
+
+        const std::wstring m_Path;
+        size_t m_Granularity = 0;
+        size_t m_SegmentBytes = 0;
+        HANDLE m_File = INVALID_HANDLE_VALUE;
+        mutable CRITICAL_SECTION m_CriticalSection; // Guards mapping and unmapping, and m_Segments.
+        // Every segment mapped, kept until Close() because a writer may still be looking at one
+        // it loaded as current just before it was sealed.
+        std::vector<std::unique_ptr<Segment>> m_Segments;
+        std::atomic<Segment*> m_Current{ nullptr }; // Null once closed, or if mapping failed.
+        unsigned long long m_FinalLength = 0; // Set once closed, or once mapping the next segment failed.
+
+        // Maps the segment whose data starts at fileOffset. Returns null if it could not.
+        // Called with m_CriticalSection held.
+        std::unique_ptr<Segment> MapSegment(unsigned long long fileOffset);
+
+        // Called by the writer whose reservation sealed segment at sealedAt.
+        void MapNextSegment(Segment* segment, size_t sealedAt);
+
+        // Counts bytes copied into segment and unmaps it if it is sealed and complete.
+        void FinishWrite(Segment* segment, size_t length);
+
+        void Unmap(Segment* segment);
+    };
+}
@@ -0,0 +1,266 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include "OverlappedLogFile.h"
+// c++ headers
+#include <algorithm>
+// ntl headers
+#include "ntlLocks.hpp"
+#include "ntlString.hpp"
+
+namespace FirewallEventMonitor
+{
+    OverlappedLogFile::OverlappedLogFile(
+        const std::wstring& path,
+        size_t bufferBytes,
+        size_t bufferCount)
+        : m_Path(path),
+          m_BufferBytes((std::max)(bufferBytes, static_cast<size_t>(4096)))
+    {
+        // At least two buffers, so one can be filled while the other is written.
+        bufferCount = (std::max)(bufferCount, static_cast<size_t>(2));
+
+        m_File = ::CreateFileW(
+            path.c_str(),
+            GENERIC_WRITE,
+            FILE_SHARE_READ,
+            NULL,
+            CREATE_ALWAYS,
+            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED,
+            NULL);
+        if (m_File == INVALID_HANDLE_VALUE)
+        {
+            std::string errorMessage = "Unable to open log file ";
+            errorMessage += ntl::String::convert_to_string(path);
+            throw std::exception(errorMessage.c_str());
+        }
+
+        m_Pool = static_cast<char*>(::VirtualAlloc(
+            NULL,
+            m_BufferBytes * bufferCount,
+            MEM_COMMIT | MEM_RESERVE,
+            PAGE_READWRITE));
+        if (m_Pool == nullptr)
+        {
+            DWORD error = ::GetLastError();
+            ::CloseHandle(m_File);
+            std::string errorMessage = "Unable to allocate write buffers for log file ";
+            errorMessage += ntl::String::convert_to_string(path);
+            errorMessage += " (error " + std::to_string(error) + ")";
+            throw std::exception(errorMessage.c_str());
+        }
+
+        try
+        {
+            m_Iocp = std::make_unique<ntl::ThreadIocp>(m_File);
+        }
+        catch (const std::exception&)
+        {
+            ::VirtualFree(m_Pool, 0, MEM_RELEASE);
+            ::CloseHandle(m_File);
+            throw;
+        }
+
+        ::InitializeCriticalSectionEx(&m_AppendCriticalSection, 4000, 0);
+        ::InitializeCriticalSectionEx(&m_CriticalSection, 4000, 0);
+        ::InitializeConditionVariable(&m_BufferReturned);
+
+        m_Buffers.resize(bufferCount);
+        m_FreeBuffers.reserve(bufferCount);
+        for (size_t buffer = 0; buffer < bufferCount; ++buffer)
+        {
+            m_Buffers[buffer].data = m_Pool + buffer * m_BufferBytes;
+            m_FreeBuffers.push_back(bufferCount - 1 - buffer);
+        }
+    }
+
+    OverlappedLogFile::~OverlappedLogFile()
+    {
+        Close();
+        ::DeleteCriticalSection(&m_CriticalSection);
+        ::DeleteCriticalSection(&m_AppendCriticalSection);
+    }
+
+    bool OverlappedLogFile::Append(const void* data, size_t length)
+    {
+        ntl::AutoReleaseCriticalSection appendScoped(&m_AppendCriticalSection);
+
+        if (m_Closed)
+        {
+            return false;
+        }
+
+        const char* next = static_cast<const char*>(data);
+        while (length > 0)
+        {
+            if (m_Current == SIZE_MAX)
+            {
+                TakeFreeBuffer();
+            }
+
+            Buffer& buffer = m_Buffers[m_Current];
+            size_t copied = (std::min)(length, m_BufferBytes - buffer.used);
+            memcpy(buffer.data + buffer.used, next, copied);
+            buffer.used += copied;
+            m_Length += copied;
+            next += copied;
+            length -= copied;
+
+            if (buffer.used == m_BufferBytes)
+            {
+                SubmitCurrent();
+            }
+        }
+        return true;
+    }
+
+    void OverlappedLogFile::Flush()
+    {
+        ntl::AutoReleaseCriticalSection appendScoped(&m_AppendCriticalSection);
+
+        if (!m_Closed &&
+            m_Current != SIZE_MAX &&
+            m_Buffers[m_Current].used > 0)
+        {
+            SubmitCurrent();
+        }
+    }
+
+    void OverlappedLogFile::Close()
+    {
+        {
+            ntl::AutoReleaseCriticalSection appendScoped(&m_AppendCriticalSection);
+
+            if (m_Closed)
+            {
+                return;
+            }
+            m_Closed = true;
+
+            if (m_Current != SIZE_MAX &&
+                m_Buffers[m_Current].used > 0)
+            {
+                SubmitCurrent();
+            }
+        }
+
+        {
+            ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+
+            while (m_Report.writesInFlight > 0)
+            {
+                ::SleepConditionVariableCS(&m_BufferReturned, &m_CriticalSection, INFINITE);
+            }
+        }
+
+        // Waits for the completion callbacks to return before the handle and buffers go away.
+        m_Iocp.reset();
+        ::CloseHandle(m_File);
+        m_File = INVALID_HANDLE_VALUE;
+        ::VirtualFree(m_Pool, 0, MEM_RELEASE);
+        m_Pool = nullptr;
+    }
+
+    unsigned long long OverlappedLogFile::GetLength() const
+    {
+        return m_Length.load();
+    }
+
+    OverlappedWriteReport OverlappedLogFile::GetReport() const
+    {
+        ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+
+        return m_Report;
+    }
+
+    size_t OverlappedLogFile::GetBufferBytes() const
+    {
+        return m_BufferBytes;
+    }
+
+    void OverlappedLogFile::TakeFreeBuffer()
+    {
+        ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+
+        if (m_FreeBuffers.empty())
+        {
+            // Every buffer is being written: the disk is behind the events.
+            ++m_Report.bufferWaits;
+            while (m_FreeBuffers.empty())
+            {
+                ::SleepConditionVariableCS(&m_BufferReturned, &m_CriticalSection, INFINITE);
+            }
+        }
+        m_Current = m_FreeBuffers.back();
+        m_FreeBuffers.pop_back();
+    }
+
+    void OverlappedLogFile::SubmitCurrent()
+    {
+        size_t buffer = m_Current;
+        unsigned long long offset = m_SubmittedLength;
+        DWORD length = static_cast<DWORD>(m_Buffers[buffer].used);
+        m_SubmittedLength += length;
+        m_Current = SIZE_MAX;
+        {
+            ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+
+            ++m_Report.writesIssued;
+            ++m_Report.writesInFlight;
+        }
+
+        OVERLAPPED* overlapped = m_Iocp->new_request([this, buffer](OVERLAPPED* completed) {
+            WriteCompleted(buffer, completed);
+        });
+        overlapped->Offset = static_cast<DWORD>(offset);
+        overlapped->OffsetHigh = static_cast<DWORD>(offset >> 32);
+
+        // The completion is queued to the thread pool even when the write completes at once.
+        if (!::WriteFile(m_File, m_Buffers[buffer].data, length, NULL, overlapped))
+        {
+            DWORD error = ::GetLastError();
+            if (error != ERROR_IO_PENDING)
+            {
+                m_Iocp->cancel_request(overlapped);
+                wprintf(L"Warning: Unable to write %lu bytes to log file %ls [%lu].\n",
+                    length,
+                    m_Path.c_str(),
+                    error);
+
+                ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+                ++m_Report.writeErrors;
+                ReturnBuffer(buffer);
+            }
+        }
+    }
+
+    void OverlappedLogFile::WriteCompleted(size_t buffer, OVERLAPPED* overlapped)
+    {
+        DWORD transferred = 0;
+        BOOL succeeded = ::GetOverlappedResult(m_File, overlapped, &transferred, FALSE);
+        DWORD error = succeeded ? NO_ERROR : ::GetLastError();
+
+        ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+
+        m_Report.bytesCompleted += transferred;
+        if (!succeeded ||
+            transferred != m_Buffers[buffer].used)
+        {
+            ++m_Report.writeErrors;
+            wprintf(L"Warning: A write of %lu bytes to log file %ls completed with %lu bytes [%lu].\n",
+                static_cast<unsigned long>(m_Buffers[buffer].used),
+                m_Path.c_str(),
+                transferred,
+                error);
+        }
+        ReturnBuffer(buffer);
+    }
+
+    void OverlappedLogFile::ReturnBuffer(size_t buffer)
+    {
+        m_Buffers[buffer].used = 0;
+        m_FreeBuffers.push_back(buffer);
+        --m_Report.writesInFlight;
+        ::WakeAllConditionVariable(&m_BufferReturned);
+    }
+}
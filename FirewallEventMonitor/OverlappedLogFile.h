@@ -0,0 +1,118 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#pragma once
+
+// os headers
+#include <Windows.h>
+// c++ headers
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+// ntl headers
+#include "ntlThreadIocp.hpp"
+
+#include "LogFileWriter.h"
+
+namespace FirewallEventMonitor
+{
+    // Overlapped mode counters, for the statistics.
+    struct OverlappedWriteReport
+    {
+        unsigned long long writesIssued = 0;
+        unsigned long long bytesCompleted = 0;
+        unsigned long long writeErrors = 0;
+        unsigned long long bufferWaits = 0; // Appends that waited for a write to complete and free a buffer.
+        size_t writesInFlight = 0;
+    };
+
+    // Log file written with overlapped I/O (-Overlapped).
+    //
+    // Appends are copied into a fixed pool of buffers allocated once when the file is opened.
+    // A full buffer is written with one overlapped WriteFile at its offset in the file, and the
+    // thread pool completion returns it to the pool, so appending never waits for the disk while
+    // a buffer is free. Flush() submits a partly filled buffer; FileLogger calls it from the main
+    // loop, so writes are batched by size or by time, whichever comes first.
+    //
+    // Writes may complete out of order; each has its own offset, so the file has no gaps once
+    // every write has completed. Close() waits for that.
+    class OverlappedLogFile : public LogFileWriter
+    {
+    public:
+        // Creates (or replaces) the file and allocates the buffers. Throws if either fails, or if
+        // the file cannot be bound to the thread pool.
+        OverlappedLogFile(
+            const std::wstring& path,
+            size_t bufferBytes = DefaultBufferBytes,
+            size_t bufferCount = DefaultBufferCount);
+
+        // Closes the file if Close() was not called.
+        ~OverlappedLogFile() override;
+
+        // Copies data to the end of the file, submitting each buffer it fills; safe to call from
+        // several threads. Waits only if every buffer is being written. Returns false once closed.
+        bool Append(_In_reads_bytes_(length) const void* data, size_t length) override;
+
+        // Submits the partly filled buffer, if any.
+        void Flush() override;
+
+        // Submits the last buffer, waits for every write to complete and closes the file.
+        void Close() override;
+
+        unsigned long long GetLength() const override;
+
+        OverlappedWriteReport GetReport() const;
+
+        size_t GetBufferBytes() const;
+
+        // Constants
+        static const size_t DefaultBufferBytes = 1024 * 1024;
+        static const size_t DefaultBufferCount = 8;
+
+        OverlappedLogFile(OverlappedLogFile const&) = delete;
+        OverlappedLogFile& operator=(OverlappedLogFile const&) = delete;
+    private:
+        struct Buffer
+        {
+            char* data = nullptr;
+            size_t used = 0;
+        };
+
+        const std::wstring m_Path;
+        const size_t m_BufferBytes;
+        HANDLE m_File = INVALID_HANDLE_VALUE;
+        std::unique_ptr<ntl::ThreadIocp> m_Iocp;
+        // One allocation for every buffer, page aligned.
+        char* m_Pool = nullptr;
+
+        std::vector<Buffer> m_Buffers;
+        std::atomic<unsigned long long> m_Length{ 0 }; // Bytes appended, including the current buffer.
+
+        // Held for a whole Append, so a record split across buffers is never interleaved with
+        // another. Guards the members below.
+        CRITICAL_SECTION m_AppendCriticalSection;
+        size_t m_Current = SIZE_MAX; // Buffer being filled, or SIZE_MAX.
+        unsigned long long m_SubmittedLength = 0; // Offset of the current buffer in the file.
+        bool m_Closed = false;
+
+        // Shared with the completions. Guards the members below.
+        mutable CRITICAL_SECTION m_CriticalSection;
+        CONDITION_VARIABLE m_BufferReturned;
+        std::vector<size_t> m_FreeBuffers;
+        OverlappedWriteReport m_Report;
+
+        // Takes a free buffer as the current one, waiting for a write to complete if none is.
+        // Called with m_AppendCriticalSection held.
+        void TakeFreeBuffer();
+
+        // Writes the current buffer at its offset in the file. Called with m_AppendCriticalSection held.
+        void SubmitCurrent();
+
+        void WriteCompleted(size_t buffer, _In_ OVERLAPPED* overlapped);
+
+        // Returns a buffer to the pool. Called with m_CriticalSection held.
+        void ReturnBuffer(size_t buffer);
+    };
+}
@@ -0,0 +1,285 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include "ResourceSampler.h"
+
+#ifdef _WIN32
+// os headers
+#include <Windows.h>
+#include <Psapi.h>
+#include <winternl.h>
+// ntl headers
+#include "ntlTimer.hpp"
+#else
+// os headers
+#include <dirent.h>
+#include <time.h>
+#include <unistd.h>
+// c++ headers
+#include <fstream>
+#include <sstream>
+#include <string>
+#endif
+
+namespace FirewallEventMonitor
+{
+#ifdef _WIN32
+    namespace
+    {
+        const NTSTATUS STATUS_INFO_LENGTH_MISMATCH_VALUE = static_cast<NTSTATUS>(0xC0000004L);
+        const ULONG INITIAL_PROCESS_INFORMATION_BYTES = 256 * 1024;
+    }
+#endif
+
+    ResourceSampler::ResourceSampler()
+    {
+#ifdef _WIN32
+        SYSTEM_INFO systemInfo;
+        GetSystemInfo(&systemInfo);
+        m_ProcessorCount = systemInfo.dwNumberOfProcessors;
+#else
+        long processors = sysconf(_SC_NPROCESSORS_ONLN);
+        m_ProcessorCount = processors > 0 ? static_cast<unsigned long>(processors) : 1;
+#endif
+        if (m_ProcessorCount == 0)
+        {
+            m_ProcessorCount = 1;
+        }
+
+        // Baseline so the first Sample() reports usage since construction.
+        QueryTimes(&m_StartCpuTime, &m_StartWallTime);
+        m_LastCpuTime = m_StartCpuTime;
+        m_LastWallTime = m_StartWallTime;
+    }
+
+    ResourceUsage ResourceSampler::Sample()
+    {
+        unsigned long long cpuTime = 0;
+        unsigned long long wallTime = 0;
+        QueryTimes(&cpuTime, &wallTime);
+
+        ResourceUsage usage;
+        usage.cpuPercent = CpuPercent(cpuTime - m_LastCpuTime, wallTime - m_LastWallTime);
+        usage.averageCpuPercent = CpuPercent(cpuTime - m_StartCpuTime, wallTime - m_StartWallTime);
+        m_LastCpuTime = cpuTime;
+        m_LastWallTime = wallTime;
+
+        QueryCounters(&usage);
+
+        m_LastSample = usage;
+        return usage;
+    }
+
+    const ResourceUsage& ResourceSampler::GetLastSample() const
+    {
+        return m_LastSample;
+    }
+
+    double ResourceSampler::SampleCpuPercent()
+    {
+        unsigned long long cpuTime = 0;
+        unsigned long long wallTime = 0;
+        QueryTimes(&cpuTime, &wallTime);
+
+        double cpuPercent = CpuPercent(cpuTime - m_LastCpuTime, wallTime - m_LastWallTime);
+        m_LastCpuTime = cpuTime;
+        m_LastWallTime = wallTime;
+        return cpuPercent;
+    }
+
+    double ResourceSampler::CpuPercent(
+        unsigned long long cpuDelta,
+        unsigned long long wallDelta) const
+    {
+        // Deltas are unsigned: a clock that went backwards shows up as a huge value.
+        if (wallDelta == 0 ||
+            cpuDelta > wallDelta * m_ProcessorCount)
+        {
+            return 0.0;
+        }
+        return (static_cast<double>(cpuDelta) * 100.0) /
+            (static_cast<double>(wallDelta) * m_ProcessorCount);
+    }
+
+#ifdef _WIN32
+    void ResourceSampler::QueryTimes(
+        unsigned long long* cpuTime,
+        unsigned long long* wallTime) const
+    {
+        FILETIME creationTime, exitTime, kernelTime, userTime;
+        if (GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime))
+        {
+            *cpuTime =
+                ntl::Timer::convert_filetime_hundredNs(kernelTime) +
+                ntl::Timer::convert_filetime_hundredNs(userTime);
+        }
+        else
+        {
+            *cpuTime = 0;
+        }
+
+        *wallTime = ntl::Timer::convert_filetime_hundredNs(ntl::Timer::snap_system_time_as_filetime());
+    }
+
+    void ResourceSampler::QueryCounters(ResourceUsage* usage) const
+    {
+        HANDLE process = GetCurrentProcess();
+
+        PROCESS_MEMORY_COUNTERS memoryCounters = {};
+        if (GetProcessMemoryInfo(process, &memoryCounters, sizeof(memoryCounters)))
+        {
+            usage->residentBytes = memoryCounters.WorkingSetSize;
+        }
+
+        DWORD handleCount = 0;
+        if (GetProcessHandleCount(process, &handleCount))
+        {
+            usage->handleCount = handleCount;
+        }
+
+        IO_COUNTERS ioCounters = {};
+        if (GetProcessIoCounters(process, &ioCounters))
+        {
+            usage->bytesWritten = ioCounters.WriteTransferCount;
+        }
+
+        // The process list carries each process's thread count, so one call into a reused
+        // buffer replaces a toolhelp snapshot, which copies out every thread in the system.
+        if (m_ProcessInformation.empty())
+        {
+            m_ProcessInformation.resize(INITIAL_PROCESS_INFORMATION_BYTES);
+        }
+        NTSTATUS status = STATUS_INFO_LENGTH_MISMATCH_VALUE;
+        for (int attempt = 0; attempt < 4 && status == STATUS_INFO_LENGTH_MISMATCH_VALUE; ++attempt)
+        {
+            ULONG needed = 0;
+            status = NtQuerySystemInformation(
+                SystemProcessInformation,
+                m_ProcessInformation.data(),
+                static_cast<ULONG>(m_ProcessInformation.size()),
+                &needed);
+            if (status == STATUS_INFO_LENGTH_MISMATCH_VALUE)
+            {
+                // Processes can start before the next call: leave some room.
+                m_ProcessInformation.resize(needed + needed / 8);
+            }
+        }
+
+        if (status >= 0)
+        {
+            HANDLE processId = ULongToHandle(GetCurrentProcessId());
+            size_t offset = 0;
+            for (;;)
+            {
+                const SYSTEM_PROCESS_INFORMATION* process =
+                    reinterpret_cast<const SYSTEM_PROCESS_INFORMATION*>(m_ProcessInformation.data() + offset);
+                if (process->UniqueProcessId == processId)
+                {
+                    usage->threadCount = process->NumberOfThreads;
+                    break;
+                }
+                if (process->NextEntryOffset == 0)
+                {
+                    break;
+                }
+                offset += process->NextEntryOffset;
+            }
+        }
+    }
+#else
+    void ResourceSampler::QueryTimes(
+        unsigned long long* cpuTime,
+        unsigned long long* wallTime) const
+    {
+        *cpuTime = 0;
+
+        // utime and stime are fields 14 and 15 of /proc/self/stat, in clock ticks.
+        // The command name (field 2) can contain spaces, so skip past its closing ')'.
+        std::ifstream statFile("/proc/self/stat");
+        std::string stat;
+        std::getline(statFile, stat);
+        std::size_t commandEnd = stat.rfind(')');
+        if (commandEnd != std::string::npos)
+        {
+            std::istringstream fields(stat.substr(commandEnd + 2));
+            std::string skipped;
+            // fields 3 through 13
+            for (int i = 3; i <= 13; ++i)
+            {
+                fields >> skipped;
+            }
+            unsigned long long userTicks = 0, kernelTicks = 0;
+            fields >> userTicks >> kernelTicks;
+
+            long ticksPerSecond = sysconf(_SC_CLK_TCK);
+            if (ticksPerSecond > 0)
+            {
+                *cpuTime = (userTicks + kernelTicks) * (10000000ull / static_cast<unsigned long long>(ticksPerSecond));
+            }
+        }
+
+        timespec now = {};
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        *wallTime =
+            static_cast<unsigned long long>(now.tv_sec) * 10000000ull +
+            static_cast<unsigned long long>(now.tv_nsec) / 100ull;
+    }
+
+    void ResourceSampler::QueryCounters(ResourceUsage* usage) const
+    {
+        // Field 2 of /proc/self/statm is resident pages.
+        {
+            std::ifstream statmFile("/proc/self/statm");
+            unsigned long long sizePages = 0, residentPages = 0;
+            if (statmFile >> sizePages >> residentPages)
+            {
+                usage->residentBytes = residentPages * static_cast<unsigned long long>(sysconf(_SC_PAGESIZE));
+            }
+        }
+
+        {
+            std::ifstream statusFile("/proc/self/status");
+            std::string line;
+            while (std::getline(statusFile, line))
+            {
+                if (line.compare(0, 8, "Threads:") == 0)
+                {
+                    usage->threadCount = std::stoul(line.substr(8));
+                    break;
+                }
+            }
+        }
+
+        // wchar counts every byte passed to write(), matching WriteTransferCount on Windows.
+        {
+            std::ifstream ioFile("/proc/self/io");
+            std::string line;
+            while (std::getline(ioFile, line))
+            {
+                if (line.compare(0, 6, "wchar:") == 0)
+                {
+                    usage->bytesWritten = std::stoull(line.substr(6));
+                    break;
+                }
+            }
+        }
+
+        // Open file descriptors are the closest equivalent to a handle count.
+        DIR* fdDirectory = opendir("/proc/self/fd");
+        if (fdDirectory != nullptr)
+        {
+            unsigned long entries = 0;
+            while (dirent* entry = readdir(fdDirectory))
+            {
+                if (entry->d_name[0] != '.')
+                {
+                    entries++;
+                }
+            }
+            closedir(fdDirectory);
+            // Exclude the descriptor held by opendir itself.
+            usage->handleCount = entries > 0 ? entries - 1 : 0;
+        }
+    }
+#endif
+}
\ No newline at end of file
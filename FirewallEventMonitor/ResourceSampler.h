@@ -0,0 +1,67 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#pragma once
+
+// c++ headers
+#include <vector>
+
+namespace FirewallEventMonitor
+{
+    // Snapshot of the resources consumed by this process.
+    struct ResourceUsage
+    {
+    public:
+        // Share of total machine CPU (all processors) used since the previous sample.
+        double cpuPercent = 0.0;
+        // Share of total machine CPU used since the sampler was created.
+        double averageCpuPercent = 0.0;
+        unsigned long long residentBytes = 0;
+        unsigned long handleCount = 0;
+        unsigned long threadCount = 0;
+        // Cumulative bytes written by the process (files, console, sockets).
+        unsigned long long bytesWritten = 0;
+    };
+
+    // Samples the monitor's own resource usage.
+    // Windows builds query the process object; other builds read /proc/self.
+    class ResourceSampler
+    {
+    public:
+        ResourceSampler();
+
+        // Takes a new sample. cpuPercent covers the time since the previous call.
+        ResourceUsage Sample();
+
+        const ResourceUsage& GetLastSample() const;
+
+        // CPU share since the previous call, without the other counters.
+        // Cheap enough to call every second; shares its baseline with Sample(),
+        // so use a separate sampler for each caller.
+        double SampleCpuPercent();
+
+        ResourceSampler(ResourceSampler const&) = delete;
+        ResourceSampler& operator=(ResourceSampler const&) = delete;
+    private:
+        // Process CPU time and wall clock time, in 100ns units, at the previous sample.
+        unsigned long long m_LastCpuTime = 0;
+        unsigned long long m_LastWallTime = 0;
+        unsigned long long m_StartCpuTime = 0;
+        unsigned long long m_StartWallTime = 0;
+        unsigned long m_ProcessorCount = 1;
+        ResourceUsage m_LastSample;
+        // Reused by QueryCounters() for the system's process list, which holds our thread count (Windows builds).
+        mutable std::vector<unsigned char> m_ProcessInformation;
+
+        // Kept free of SAL and OS headers so the Linux core build can include this header.
+        void QueryTimes(
+            unsigned long long* cpuTime,
+            unsigned long long* wallTime) const;
+
+        void QueryCounters(ResourceUsage* usage) const;
+
+        double CpuPercent(
+            unsigned long long cpuDelta,
+            unsigned long long wallDelta) const;
+    };
+}
\ No newline at end of file
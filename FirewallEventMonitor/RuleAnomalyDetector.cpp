@@ -0,0 +1,213 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include "RuleAnomalyDetector.h"
+
+// c++ headers
+#include <algorithm>
+#include <cmath>
+// ntl headers
+#include "ntlLocks.hpp"
+
+namespace FirewallEventMonitor
+{
+    const LONGLONG HUNDRED_NS_PER_SECOND = 10000000LL;
+    const LONGLONG SECONDS_PER_HOUR = 3600;
+
+    RuleAnomalyDetector::RuleAnomalyDetector(
+        double zScoreThreshold,
+        double ratioThreshold,
+        size_t maxRules)
+        : m_ZScoreThreshold(zScoreThreshold),
+        m_RatioThreshold(ratioThreshold),
+        m_MaxRules(maxRules)
+    {
+        ::InitializeCriticalSectionEx(&m_CriticalSection, 4000, 0);
+        // Reserve up front so the table never rehashes on the event path.
+        m_Rules.reserve(m_MaxRules);
+        m_PendingAlerts.reserve(MaxPendingAlerts);
+    }
+
+    RuleAnomalyDetector::~RuleAnomalyDetector()
+    {
+        ::DeleteCriticalSection(&m_CriticalSection);
+    }
+
+    void RuleAnomalyDetector::RecordEvent(const CompactEventRecord& record)
+    {
+        LONGLONG second = record.timeStamp / HUNDRED_NS_PER_SECOND;
+
+        ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+
+        m_LatestSecond = (std::max)(m_LatestSecond, second);
+        m_Expiry.advance(m_LatestSecond, [this](const GUID& ruleId)
+        {
+            m_Rules.erase(ruleId);
+        }, ExpiryBudgetPerEvent);
+
+        auto found = m_Rules.find(record.ruleId);
+        if (found == m_Rules.end())
+        {
+            if (m_Rules.size() >= m_MaxRules)
+            {
+                m_RulesRejected++;
+                return;
+            }
+            found = m_Rules.emplace(record.ruleId, RuleState{}).first;
+            found->second.currentSecond = second;
+            found->second.expiry = m_Expiry.schedule(second + IdleRuleExpirySeconds + 1, record.ruleId);
+        }
+
+        RuleState& state = found->second;
+        state.action = record.action;
+
+        // Events can arrive slightly out of order across processors;
+        // late events are counted in the current second.
+        if (second > state.currentSecond)
+        {
+            AdvanceSecond(state, second);
+            // Once per second per rule, not per event.
+            m_Expiry.reschedule(state.expiry, second + IdleRuleExpirySeconds + 1);
+        }
+
+        state.currentCount++;
+        CheckForAnomaly(record.ruleId, state, record.timeStamp);
+    }
+
+    std::vector<RuleAnomalyAlert> RuleAnomalyDetector::TakeAlerts()
+    {
+        std::vector<RuleAnomalyAlert> alerts;
+        alerts.reserve(MaxPendingAlerts);
+
+        ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+        alerts.swap(m_PendingAlerts);
+        return alerts;
+    }
+
+    size_t RuleAnomalyDetector::GetRuleCount()
+    {
+        ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+        return m_Rules.size();
+    }
+
+    unsigned long long RuleAnomalyDetector::GetRulesRejected()
+    {
+        ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+        return m_RulesRejected;
+    }
+
+    unsigned long long RuleAnomalyDetector::GetAlertsDropped()
+    {
+        ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+        return m_AlertsDropped;
+    }
+
+    void RuleAnomalyDetector::AdvanceSecond(RuleState& state, LONGLONG newSecond) const
+    {
+        FoldSecond(state, state.currentSecond, static_cast<float>(state.currentCount));
+
+        // Seconds without hits pull the baseline towards zero.
+        LONGLONG idleSeconds = newSecond - state.currentSecond - 1;
+        LONGLONG folded = (std::min)(idleSeconds, static_cast<LONGLONG>(MaxIdleSecondsFolded));
+        for (LONGLONG i = 1; i <= folded; ++i)
+        {
+            FoldSecond(state, state.currentSecond + i, 0.0f);
+        }
+        if (idleSeconds > folded)
+        {
+            // With zero samples both moments decay geometrically.
+            float decay = std::pow(1.0f - BaselineSmoothingFactor, static_cast<float>(idleSeconds - folded));
+            state.mean *= decay;
+            state.variance *= decay;
+            state.secondsObserved += static_cast<unsigned long>(
+                (std::min)(idleSeconds - folded, static_cast<LONGLONG>(ULONG_MAX - state.secondsObserved)));
+        }
+
+        state.currentSecond = newSecond;
+        state.currentCount = 0;
+        state.alerted = false;
+    }
+
+    void RuleAnomalyDetector::FoldSecond(RuleState& state, LONGLONG second, float count) const
+    {
+        if (state.secondsObserved == 0)
+        {
+            state.mean = count;
+            state.variance = 0.0f;
+        }
+        else
+        {
+            // Incremental EWMA mean and variance (West, 1979).
+            float delta = count - state.mean;
+            float increment = BaselineSmoothingFactor * delta;
+            state.mean += increment;
+            state.variance = (1.0f - BaselineSmoothingFactor) * (state.variance + delta * increment);
+        }
+        if (state.secondsObserved < ULONG_MAX)
+        {
+            state.secondsObserved++;
+        }
+
+        unsigned long hour = static_cast<unsigned long>((second / SECONDS_PER_HOUR) % HoursPerDay);
+        if (state.seasonalSamples[hour] == 0)
+        {
+            state.seasonalMean[hour] = count;
+        }
+        else
+        {
+            state.seasonalMean[hour] += SeasonalSmoothingFactor * (count - state.seasonalMean[hour]);
+        }
+        if (state.seasonalSamples[hour] < USHRT_MAX)
+        {
+            state.seasonalSamples[hour]++;
+        }
+    }
+
+    void RuleAnomalyDetector::CheckForAnomaly(
+        const GUID& ruleId,
+        RuleState& state,
+        LONGLONG timeStamp)
+    {
+        if (state.alerted ||
+            state.secondsObserved < WarmupSeconds ||
+            state.currentCount < MinimumHitsForAlert)
+        {
+            return;
+        }
+
+        // Prefer the seasonal baseline for this hour once it has enough history.
+        unsigned long hour = static_cast<unsigned long>((state.currentSecond / SECONDS_PER_HOUR) % HoursPerDay);
+        double baseline = state.seasonalSamples[hour] >= SeasonalWarmupSeconds ?
+            state.seasonalMean[hour] :
+            state.mean;
+
+        // Quiet rules have near-zero variance; floor it at one hit per second
+        // so a handful of hits does not produce an enormous z-score.
+        double count = static_cast<double>(state.currentCount);
+        double standardDeviation = (std::max)(std::sqrt(static_cast<double>(state.variance)), 1.0);
+        double zScore = (count - baseline) / standardDeviation;
+        double ratio = count / (std::max)(baseline, 1.0);
+
+        if (zScore < m_ZScoreThreshold && ratio < m_RatioThreshold)
+        {
+            return;
+        }
+
+        state.alerted = true;
+        if (m_PendingAlerts.size() >= MaxPendingAlerts)
+        {
+            m_AlertsDropped++;
+            return;
+        }
+
+        RuleAnomalyAlert alert;
+        alert.ruleId = ruleId;
+        alert.action = state.action;
+        alert.timeStamp = timeStamp;
+        alert.count = state.currentCount;
+        alert.baseline = baseline;
+        alert.zScore = zScore;
+        alert.ratio = ratio;
+        m_PendingAlerts.push_back(alert);
+    }
+}
@@ -0,0 +1,108 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#pragma once
+
+// OS Headers
+#include <Windows.h>
+// c++ headers
+#include <unordered_map>
+#include <vector>
+// ntl headers
+#include "ntlTimerWheel.hpp"
+
+#include "CompactEventRecord.h"
+
+namespace FirewallEventMonitor
+{
+    // A rule whose hits in one second departed from its baseline.
+    struct RuleAnomalyAlert
+    {
+    public:
+        GUID ruleId = {};
+        RuleAction action = RuleAction::Unknown;
+        LONGLONG timeStamp = 0; // FILETIME of the hit that crossed the threshold.
+        unsigned long count = 0; // Hits so far in that second.
+        double baseline = 0.0; // Expected hits per second.
+        double zScore = 0.0;
+        double ratio = 0.0;
+    };
+
+    // Per-rule hit-rate anomaly detection.
+    // Each rule keeps an EWMA mean and variance of its hits per second, plus an
+    // hour-of-day seasonal mean so daily peaks are not reported as anomalies.
+    // Seconds are taken from the event timestamps, so the cost per event is O(1)
+    // and memory is bounded by the number of rules tracked. Rules with no hits for
+    // IdleRuleExpirySeconds of event time are forgotten through a timer wheel.
+    class RuleAnomalyDetector
+    {
+    public:
+        RuleAnomalyDetector(
+            double zScoreThreshold,
+            double ratioThreshold,
+            size_t maxRules = DefaultMaxRules);
+
+        ~RuleAnomalyDetector();
+
+        void RecordEvent(const CompactEventRecord& record);
+
+        // Returns the alerts raised since the previous call.
+        std::vector<RuleAnomalyAlert> TakeAlerts();
+
+        size_t GetRuleCount();
+
+        // Rules not tracked because the table was full.
+        unsigned long long GetRulesRejected();
+
+        // Alerts discarded because nobody collected them in time.
+        unsigned long long GetAlertsDropped();
+
+        // Constants
+        static const size_t DefaultMaxRules = 65536;
+        static const size_t MaxPendingAlerts = 1024;
+        static const unsigned long HoursPerDay = 24;
+        static const LONGLONG IdleRuleExpirySeconds = 86400; // Keep a full day of seasonal history.
+        static constexpr float BaselineSmoothingFactor = 0.01f; // ~100 second horizon.
+        static constexpr float SeasonalSmoothingFactor = 0.002f; // ~10 minutes of each hour.
+        static const unsigned long WarmupSeconds = 60; // Seconds observed before a rule can alert.
+        static const unsigned short SeasonalWarmupSeconds = 600; // Seconds observed before an hour slot is trusted.
+        static const unsigned long MinimumHitsForAlert = 10; // Ignore spikes too small to matter.
+        static const LONGLONG MaxIdleSecondsFolded = 64; // Longer gaps decay in closed form.
+        static const size_t ExpiryBudgetPerEvent = 64; // Spreads a burst of idle rules over the following events.
+
+        RuleAnomalyDetector(RuleAnomalyDetector const&) = delete;
+        RuleAnomalyDetector& operator=(RuleAnomalyDetector const&) = delete;
+    private:
+        struct RuleState
+        {
+            LONGLONG currentSecond = 0;
+            unsigned long currentCount = 0;
+            unsigned long secondsObserved = 0;
+            float mean = 0.0f;
+            float variance = 0.0f;
+            float seasonalMean[HoursPerDay] = {};
+            unsigned short seasonalSamples[HoursPerDay] = {};
+            RuleAction action = RuleAction::Unknown;
+            ntl::TimerWheel<GUID>::timer_id expiry = ntl::TimerWheel<GUID>::invalid_timer;
+            bool alerted = false; // At most one alert per rule per second.
+        };
+
+        CRITICAL_SECTION m_CriticalSection;
+        std::unordered_map<GUID, RuleState, GuidHash> m_Rules;
+        ntl::TimerWheel<GUID> m_Expiry;
+        std::vector<RuleAnomalyAlert> m_PendingAlerts;
+        const double m_ZScoreThreshold;
+        const double m_RatioThreshold;
+        const size_t m_MaxRules;
+        LONGLONG m_LatestSecond = 0;
+        unsigned long long m_RulesRejected = 0;
+        unsigned long long m_AlertsDropped = 0;
+
+        // Folds a completed second into the baselines and advances to newSecond.
+        void AdvanceSecond(RuleState& state, LONGLONG newSecond) const;
+
+        void FoldSecond(RuleState& state, LONGLONG second, float count) const;
+
+        void CheckForAnomaly(const GUID& ruleId, RuleState& state, LONGLONG timeStamp);
+    };
+}
@@ -0,0 +1,294 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include "RuleUsageTracker.h"
+
+// c++ headers
+#include <algorithm>
+#include <fstream>
+// ntl headers
+#include "ntlLocks.hpp"
+#include "ntlString.hpp"
+
+#include "Timer.h"
+
+namespace FirewallEventMonitor
+{
+    namespace
+    {
+        // ISO 8601 basic format, UTC: 20170907T224228Z. Empty if never hit.
+        std::wstring FormatHitTime(LONGLONG timeStamp)
+        {
+            if (timeStamp == 0)
+            {
+                return std::wstring();
+            }
+
+            LARGE_INTEGER hitTime;
+            hitTime.QuadPart = timeStamp;
+            std::wstring date, time;
+            Timer::GetDateAndTime(hitTime, &date, &time);
+            return date + L"T" + time + L"Z";
+        }
+    }
+
+    unsigned long long RuleUsage::TotalHits() const
+    {
+        return allowInbound + allowOutbound + denyInbound + denyOutbound;
+    }
+
+    RuleUsageTracker::RuleUsageTracker(size_t maxRules)
+        : m_Rules(1024),
+        m_MaxRules(maxRules)
+    {
+        ::InitializeCriticalSectionEx(&m_CriticalSection, 4000, 0);
+    }
+
+    RuleUsageTracker::~RuleUsageTracker()
+    {
+        ::DeleteCriticalSection(&m_CriticalSection);
+    }
+
+    void RuleUsageTracker::RecordEvent(const CompactEventRecord& record)
+    {
+        ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+
+        RuleUsage* usage = m_Rules.find(record.ruleId);
+        if (usage == nullptr)
+        {
+            if (m_Rules.size() >= m_MaxRules)
+            {
+                m_RulesRejected++;
+                return;
+            }
+            usage = m_Rules.try_emplace(record.ruleId).first;
+        }
+
+        // A sampled event stands for sampleRate events.
+        bool inbound = record.direction == TrafficDirection::Inbound;
+        if (record.action == RuleAction::Deny)
+        {
+            (inbound ? usage->denyInbound : usage->denyOutbound) += record.sampleRate;
+        }
+        else
+        {
+            (inbound ? usage->allowInbound : usage->allowOutbound) += record.sampleRate;
+        }
+
+        if (usage->firstHit == 0 || record.timeStamp < usage->firstHit)
+        {
+            usage->firstHit = record.timeStamp;
+        }
+        if (record.timeStamp > usage->lastHit)
+        {
+            usage->lastHit = record.timeStamp;
+        }
+    }
+
+    size_t RuleUsageTracker::LoadCatalog(const std::wstring& path)
+    {
+        std::wifstream catalog(path);
+        if (!catalog.is_open())
+        {
+            throw std::exception("Unable to open rule catalog.");
+        }
+        return LoadCatalog(catalog);
+    }
+
+    size_t RuleUsageTracker::LoadCatalog(std::wistream& catalog)
+    {
+        size_t loaded = 0;
+        unsigned long lineNumber = 0;
+        std::wstring line;
+
+        ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+        m_HasCatalog = true;
+
+        while (std::getline(catalog, line))
+        {
+            lineNumber++;
+
+            // Keep the first column, without surrounding whitespace.
+            line = line.substr(0, line.find(L','));
+            size_t begin = line.find_first_not_of(L" \t\r");
+            size_t end = line.find_last_not_of(L" \t\r");
+            line = begin == std::wstring::npos ? std::wstring() : line.substr(begin, end - begin + 1);
+            if (line.empty() || line.front() == L'#')
+            {
+                continue;
+            }
+
+            GUID ruleId;
+            if (!ParseGuid(line, &ruleId))
+            {
+                wprintf(L"Warning: rule catalog line %lu is not a valid rule id: %ls.\n", lineNumber, line.c_str());
+                continue;
+            }
+
+            if (m_Rules.find(ruleId) == nullptr &&
+                m_Rules.size() >= m_MaxRules)
+            {
+                m_RulesRejected++;
+                continue;
+            }
+            RuleUsage* usage = m_Rules.try_emplace(ruleId).first;
+            if (!usage->inCatalog)
+            {
+                usage->inCatalog = true;
+                loaded++;
+            }
+        }
+        return loaded;
+    }
+
+    std::vector<RuleUsageEntry> RuleUsageTracker::GetReport()
+    {
+        std::vector<RuleUsageEntry> report;
+        {
+            ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+            report.reserve(m_Rules.size());
+            m_Rules.for_each([&report](const GUID& ruleId, const RuleUsage& usage)
+            {
+                RuleUsageEntry entry;
+                entry.ruleId = ruleId;
+                entry.usage = usage;
+                report.push_back(entry);
+            });
+        }
+
+        // Sorting happens outside the lock so the event path is not held up.
+        std::sort(report.begin(), report.end(), [](const RuleUsageEntry& lhs, const RuleUsageEntry& rhs)
+        {
+            unsigned long long lhsHits = lhs.usage.TotalHits();
+            unsigned long long rhsHits = rhs.usage.TotalHits();
+            if (lhsHits != rhsHits)
+            {
+                return lhsHits > rhsHits;
+            }
+            return memcmp(&lhs.ruleId, &rhs.ruleId, sizeof(GUID)) < 0;
+        });
+        return report;
+    }
+
+    size_t RuleUsageTracker::GetRuleCount()
+    {
+        ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+        return m_Rules.size();
+    }
+
+    size_t RuleUsageTracker::GetNeverHitCount()
+    {
+        ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+        size_t neverHit = 0;
+        m_Rules.for_each([&neverHit](const GUID&, const RuleUsage& usage)
+        {
+            if (usage.inCatalog && usage.TotalHits() == 0)
+            {
+                neverHit++;
+            }
+        });
+        return neverHit;
+    }
+
+    size_t RuleUsageTracker::GetNotInCatalogCount()
+    {
+        ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+        if (!m_HasCatalog)
+        {
+            return 0;
+        }
+        size_t notInCatalog = 0;
+        m_Rules.for_each([&notInCatalog](const GUID&, const RuleUsage& usage)
+        {
+            if (!usage.inCatalog)
+            {
+                notInCatalog++;
+            }
+        });
+        return notInCatalog;
+    }
+
+    bool RuleUsageTracker::HasCatalog()
+    {
+        ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+        return m_HasCatalog;
+    }
+
+    unsigned long long RuleUsageTracker::GetRulesRejected()
+    {
+        ntl::AutoReleaseCriticalSection csScoped(&m_CriticalSection);
+        return m_RulesRejected;
+    }
+
+    void RuleUsageTracker::ExportReport(const std::wstring& path)
+    {
+        auto report = GetReport();
+
+        const std::wstring jsonExtension = L".json";
+        bool json =
+            path.size() >= jsonExtension.size() &&
+            ntl::String::iordinal_equals(path.substr(path.size() - jsonExtension.size()), jsonExtension);
+        std::wstring contents = json ? FormatJson(report) : FormatCsv(report);
+
+        FILE* exportFile = NULL;
+        errno_t result = _wfopen_s(&exportFile, path.c_str(), L"w");
+        if (result != 0 || exportFile == NULL)
+        {
+            wprintf(L"Warning: Unable to write rule usage report to %ls.\n", path.c_str());
+            return;
+        }
+        fputws(contents.c_str(), exportFile);
+        fclose(exportFile);
+    }
+
+    std::wstring RuleUsageTracker::FormatCsv(const std::vector<RuleUsageEntry>& report)
+    {
+        std::wstring csv = L"ruleId,inCatalog,totalHits,allowInbound,allowOutbound,denyInbound,denyOutbound,firstHit,lastHit\n";
+        for (const auto& entry : report)
+        {
+            const RuleUsage& usage = entry.usage;
+            csv += FormatGuid(entry.ruleId);
+            csv += usage.inCatalog ? L",true," : L",false,";
+            csv += std::to_wstring(usage.TotalHits()) + L",";
+            csv += std::to_wstring(usage.allowInbound) + L",";
+            csv += std::to_wstring(usage.allowOutbound) + L",";
+            csv += std::to_wstring(usage.denyInbound) + L",";
+            csv += std::to_wstring(usage.denyOutbound) + L",";
+            csv += FormatHitTime(usage.firstHit) + L",";
+            csv += FormatHitTime(usage.lastHit) + L"\n";
+        }
+        return csv;
+    }
+
+    std::wstring RuleUsageTracker::FormatJson(const std::vector<RuleUsageEntry>& report)
+    {
+        // Every value is a GUID, a number, a boolean or a timestamp, so nothing needs escaping.
+        std::wstring json = L"{\n  \"rules\": [";
+        bool first = true;
+        for (const auto& entry : report)
+        {
+            const RuleUsage& usage = entry.usage;
+            json += first ? L"\n" : L",\n";
+            first = false;
+            json += L"    {\"ruleId\": \"" + FormatGuid(entry.ruleId) + L"\"";
+            json += usage.inCatalog ? L", \"inCatalog\": true" : L", \"inCatalog\": false";
+            json += L", \"totalHits\": " + std::to_wstring(usage.TotalHits());
+            json += L", \"allowInbound\": " + std::to_wstring(usage.allowInbound);
+            json += L", \"allowOutbound\": " + std::to_wstring(usage.allowOutbound);
+            json += L", \"denyInbound\": " + std::to_wstring(usage.denyInbound);
+            json += L", \"denyOutbound\": " + std::to_wstring(usage.denyOutbound);
+            if (usage.firstHit != 0)
+            {
+                json += L", \"firstHit\": \"" + FormatHitTime(usage.firstHit) + L"\"";
+                json += L", \"lastHit\": \"" + FormatHitTime(usage.lastHit) + L"\"";
+            }
+            else
+            {
+                json += L", \"firstHit\": null, \"lastHit\": null";
+            }
+            json += L"}";
+        }
+        json += first ? L"]\n}\n" : L"\n  ]\n}\n";
+        return json;
+    }
+}
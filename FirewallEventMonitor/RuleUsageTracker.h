@@ -0,0 +1,95 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#pragma once
+
+// OS Headers
+#include <Windows.h>
+// c++ headers
+#include <istream>
+#include <string>
+#include <vector>
+// ntl headers
+#include "ntlFlatHashMap.hpp"
+
+#include "CompactEventRecord.h"
+
+namespace FirewallEventMonitor
+{
+    // Hits for one rule, split by outcome and direction.
+    struct RuleUsage
+    {
+    public:
+        unsigned long long allowInbound = 0;
+        unsigned long long allowOutbound = 0;
+        unsigned long long denyInbound = 0;
+        unsigned long long denyOutbound = 0;
+        LONGLONG firstHit = 0; // FILETIME; 0 if never hit.
+        LONGLONG lastHit = 0;
+        bool inCatalog = false; // Listed in the rule catalog.
+
+        unsigned long long TotalHits() const;
+    };
+
+    struct RuleUsageEntry
+    {
+    public:
+        GUID ruleId = {};
+        RuleUsage usage;
+    };
+
+    // Counts hits per rule, so rules that never fire can be pruned from the policy.
+    // Rules listed in an optional catalog are tracked from the start, so those
+    // without hits are reported as never hit.
+    class RuleUsageTracker
+    {
+    public:
+        RuleUsageTracker(size_t maxRules = DefaultMaxRules);
+
+        ~RuleUsageTracker();
+
+        void RecordEvent(const CompactEventRecord& record);
+
+        // Loads rule ids, one per line. Blank lines and lines starting with '#' are
+        // skipped, and anything after a comma is ignored so CSV exports can be used.
+        // Returns the number of rule ids loaded.
+        size_t LoadCatalog(const std::wstring& path);
+
+        size_t LoadCatalog(std::wistream& catalog);
+
+        // All tracked rules, most hits first.
+        std::vector<RuleUsageEntry> GetReport();
+
+        size_t GetRuleCount();
+
+        // Catalog rules with no hits.
+        size_t GetNeverHitCount();
+
+        // Rules hit but missing from the catalog (0 without a catalog).
+        size_t GetNotInCatalogCount();
+
+        bool HasCatalog();
+
+        // Rules not tracked because the table was full.
+        unsigned long long GetRulesRejected();
+
+        // Writes the report as JSON if the path ends in ".json", otherwise as CSV.
+        void ExportReport(const std::wstring& path);
+
+        static std::wstring FormatCsv(const std::vector<RuleUsageEntry>& report);
+
+        static std::wstring FormatJson(const std::vector<RuleUsageEntry>& report);
+
+        // Constants
+        static const size_t DefaultMaxRules = 262144;
+
+        RuleUsageTracker(RuleUsageTracker const&) = delete;
+        RuleUsageTracker& operator=(RuleUsageTracker const&) = delete;
+    private:
+        CRITICAL_SECTION m_CriticalSection;
+        ntl::FlatHashMap<GUID, RuleUsage, GuidHash> m_Rules;
+        const size_t m_MaxRules;
+        bool m_HasCatalog = false;
+        unsigned long long m_RulesRejected = 0;
+    };
+}
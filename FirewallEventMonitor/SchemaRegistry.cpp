@@ -0,0 +1,738 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include "SchemaRegistry.h"
+
+// c++ headers
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <sstream>
+// ntl headers
+#include "ntlString.hpp"
+
+#include "FirewallEtwTraceCallback.h"
+#include "Timer.h"
+
+namespace FirewallEventMonitor
+{
+    const GUID VFP_PROVIDER_GUID = {
+        0x9F2660EA,
+        0xCFE7,
+        0x428F,
+        { 0x98, 0x50, 0xAE, 0xCA, 0x61, 0x26, 0x19, 0xB0 } };
+
+    const USHORT IPV4_RULE_MATCH_EVENT_ID = 400;
+    const USHORT IPV6_RULE_MATCH_EVENT_ID = 401;
+    const USHORT IPV4_ICMP_RULE_MATCH_EVENT_ID = 402;
+
+    namespace
+    {
+        const struct
+        {
+            LPCWSTR name;
+            EventField field;
+        } FieldNames[] = {
+            { L"Source", EventField::Source },
+            { L"Destination", EventField::Destination },
+            { L"Direction", EventField::Direction },
+            { L"RuleType", EventField::RuleType },
+            { L"Protocol", EventField::Protocol },
+            { L"IcmpType", EventField::IcmpType },
+            { L"Status", EventField::Status },
+            { L"PortId", EventField::PortId },
+            { L"PortName", EventField::PortName },
+            { L"PortFriendlyName", EventField::PortFriendlyName },
+            { L"SourcePort", EventField::SourcePort },
+            { L"DestinationPort", EventField::DestinationPort },
+            { L"IsTcpSyn", EventField::IsTcpSyn },
+            { L"RuleId", EventField::RuleId },
+            { L"LayerId", EventField::LayerId },
+            { L"GroupId", EventField::GroupId },
+            { L"GftFlags", EventField::GftFlags } };
+
+        // Final mix of MurmurHash3.
+        unsigned long long Fmix(unsigned long long value)
+        {
+            value ^= value >> 33;
+            value *= 0xff51afd7ed558ccdull;
+            value ^= value >> 33;
+            value *= 0xc4ceb9fe1a85ec53ull;
+            value ^= value >> 33;
+            return value;
+        }
+
+        size_t SlotOf(unsigned long long keyHash, unsigned long seed, size_t slotCount)
+        {
+            // slotCount is a power of two.
+            return static_cast<size_t>(Fmix(keyHash ^ (seed * 0x9E3779B97F4A7C15ull)) & (slotCount - 1));
+        }
+
+        size_t BucketOf(unsigned long long keyHash, size_t bucketCount)
+        {
+            return static_cast<size_t>((keyHash >> 32) % bucketCount);
+        }
+
+        // Setters fill one field from the property value (empty if the event has no such property).
+
+        void SetSource(_Inout_ std::wstring* value, _Inout_ VfpEventData* eventData)
+        {
+            // A schema may list both address families; the first one present wins.
+            if (value->empty() || !eventData->source.empty())
+            {
+                return;
+            }
+            eventData->source.swap(*value);
+            bool isIpv6 = false;
+            ParseAddress(eventData->source, &eventData->compact.source, &isIpv6);
+            eventData->compact.isIpv6 = eventData->compact.isIpv6 || isIpv6;
+        }
+
+        void SetDestination(_Inout_ std::wstring* value, _Inout_ VfpEventData* eventData)
+        {
+            if (value->empty() || !eventData->destination.empty())
+            {
+                return;
+            }
+            eventData->destination.swap(*value);
+            bool isIpv6 = false;
+            ParseAddress(eventData->destination, &eventData->compact.destination, &isIpv6);
+            eventData->compact.isIpv6 = eventData->compact.isIpv6 || isIpv6;
+        }
+
+        void SetDirection(_Inout_ std::wstring* value, _Inout_ VfpEventData* eventData)
+        {
+            if (value->empty())
+            {
+                wprintf(L"Warning: Direction empty.\n");
+                return;
+            }
+
+            // Translate Direction for certain values.
+            int i = std::stoi(*value);
+            eventData->compact.direction = static_cast<TrafficDirection>(i == 0 || i == 1 ? i : 2);
+            switch (i)
+            {
+            case 0: eventData->direction = L"Outbound"; break;
+            case 1: eventData->direction = L"Inbound"; break;
+            default: wprintf(L"Warning: Direction %i did not match expected values.\n", i);
+            }
+        }
+
+        void SetRuleType(_Inout_ std::wstring* value, _Inout_ VfpEventData* eventData)
+        {
+            if (value->empty())
+            {
+                wprintf(L"Warning: RuleType empty.\n");
+                return;
+            }
+
+            // Translate Rule Type for certain values.
+            int i = std::stoi(*value);
+            eventData->compact.action = static_cast<RuleAction>(i == 1 || i == 2 ? i : 0);
+            switch (i)
+            {
+            case 1: eventData->ruleType = L"Allow"; break;
+            case 2: eventData->ruleType = L"Deny"; break;
+            default: wprintf(L"Warning: RuleType %i did not match expected values.\n", i);
+            }
+        }
+
+        void SetProtocol(_Inout_ std::wstring* value, _Inout_ VfpEventData* eventData)
+        {
+            if (value->empty())
+            {
+                wprintf(L"Warning: IpProtocol empty.\n");
+                return;
+            }
+
+            // Translate Protocol for certain values.
+            int i = std::stoi(*value);
+            eventData->compact.protocol = static_cast<unsigned short>(i);
+            LPCWSTR protocolName = ProtocolName(eventData->compact.protocol);
+            if (protocolName != NULL)
+            {
+                eventData->protocol = protocolName;
+            }
+            else
+            {
+                wprintf(L"Warning: IpProtocol %i did not match expected values.\n", i);
+            }
+        }
+
+        void SetIcmpType(_Inout_ std::wstring* value, _Inout_ VfpEventData* eventData)
+        {
+            // IcmpType not always present
+            if (value->empty())
+            {
+                return;
+            }
+
+            // Translate ICMP Type for certain values.
+            int i = std::stoi(*value);
+            eventData->compact.icmpType = static_cast<unsigned char>(i);
+            switch (i)
+            {
+            case 0: eventData->icmpType = L"V4EchoReply"; break;
+            case 5: eventData->icmpType = L"V4Redirect"; break;
+            case 8: eventData->icmpType = L"V4EchoRequest"; break;
+            case 9: eventData->icmpType = L"V4RouterAdvert"; break;
+            case 10: eventData->icmpType = L"V4RouterSolicit"; break;
+            case 13: eventData->icmpType = L"V4TimestampRequest"; break;
+            case 14: eventData->icmpType = L"V4TimestampReply"; break;
+            case 128: eventData->icmpType = L"V6EchoRequest"; break;
+            case 129: eventData->icmpType = L"V6EchoReply"; break;
+            case 133: eventData->icmpType = L"V6RouterSolicit"; break;
+            case 134: eventData->icmpType = L"V6RouterAdvert"; break;
+            case 135: eventData->icmpType = L"V6NeighborSolicit"; break;
+            case 136: eventData->icmpType = L"V6NeighborAdvert"; break;
+            default: wprintf(L"Warning: IcmpType %i did not match expected values.\n", i);
+            }
+        }
+
+        void SetStatus(_Inout_ std::wstring* value, _Inout_ VfpEventData* eventData)
+        {
+            if (value->compare(L"0x0") == 0)
+            {
+                eventData->status = L"STATUS_SUCCESS";
+                return;
+            }
+            eventData->status.swap(*value);
+        }
+
+        void SetPortId(_Inout_ std::wstring* value, _Inout_ VfpEventData* eventData)
+        {
+            eventData->portId.swap(*value);
+        }
+
+        void SetPortName(_Inout_ std::wstring* value, _Inout_ VfpEventData* eventData)
+        {
+            eventData->portName.swap(*value);
+        }
+
+        void SetPortFriendlyName(_Inout_ std::wstring* value, _Inout_ VfpEventData* eventData)
+        {
+            eventData->portFriendlyName.swap(*value);
+        }
+
+        void SetSourcePort(_Inout_ std::wstring* value, _Inout_ VfpEventData* eventData)
+        {
+            eventData->sourcePort.swap(*value);
+            if (!eventData->sourcePort.empty())
+            {
+                eventData->compact.sourcePort = static_cast<unsigned short>(std::stoul(eventData->sourcePort));
+            }
+        }
+
+        void SetDestinationPort(_Inout_ std::wstring* value, _Inout_ VfpEventData* eventData)
+        {
+            eventData->destinationPort.swap(*value);
+            if (!eventData->destinationPort.empty())
+            {
+                eventData->compact.destinationPort = static_cast<unsigned short>(std::stoul(eventData->destinationPort));
+            }
+        }
+
+        void SetIsTcpSyn(_Inout_ std::wstring* value, _Inout_ VfpEventData* eventData)
+        {
+            eventData->isTcpSyn.swap(*value);
+            eventData->compact.isTcpSyn =
+                !eventData->isTcpSyn.empty() &&
+                eventData->isTcpSyn.compare(L"0") != 0 &&
+                !ntl::String::iordinal_equals(eventData->isTcpSyn, L"false");
+        }
+
+        void SetRuleId(_Inout_ std::wstring* value, _Inout_ VfpEventData* eventData)
+        {
+            eventData->ruleId.swap(*value);
+            ParseGuid(eventData->ruleId, &eventData->compact.ruleId);
+        }
+
+        void SetLayerId(_Inout_ std::wstring* value, _Inout_ VfpEventData* eventData)
+        {
+            eventData->layerId.swap(*value);
+        }
+
+        void SetGroupId(_Inout_ std::wstring* value, _Inout_ VfpEventData* eventData)
+        {
+            eventData->groupId.swap(*value);
+        }
+
+        void SetGftFlags(_Inout_ std::wstring* value, _Inout_ VfpEventData* eventData)
+        {
+            eventData->gftFlags.swap(*value);
+        }
+
+        // The VFP properties, after the addresses, in the order they were always read.
+        std::vector<SchemaField> VfpFields(const std::vector<SchemaField>& addresses)
+        {
+            std::vector<SchemaField> fields = addresses;
+            fields.insert(fields.end(), {
+                { L"Direction", EventField::Direction },
+                { L"RuleType", EventField::RuleType },
+                { L"IpProtocol", EventField::Protocol },
+                { L"IcmpType", EventField::IcmpType },
+                { L"Status", EventField::Status },
+                // Port
+                { L"PortId", EventField::PortId },
+                { L"PortName", EventField::PortName },
+                { L"PortFriendlyName", EventField::PortFriendlyName },
+                // Flow
+                { L"SrcPort", EventField::SourcePort },
+                { L"DstPort", EventField::DestinationPort },
+                { L"IsTcpSyn", EventField::IsTcpSyn },
+                // Rule
+                { L"RuleId", EventField::RuleId },
+                { L"LayerId", EventField::LayerId },
+                { L"GroupId", EventField::GroupId },
+                { L"GftFlags", EventField::GftFlags } });
+            return fields;
+        }
+
+        bool SameKey(const EventSchema& schema, const GUID& provider, USHORT eventId, USHORT version)
+        {
+            return
+                schema.eventId == eventId &&
+                schema.version == version &&
+                memcmp(&schema.provider, &provider, sizeof(GUID)) == 0;
+        }
+    }
+
+    void SchemaRegistry::RegisterVfp()
+    {
+        const std::vector<SchemaField> ipv4Addresses = {
+            { L"SrcIpv4Addr", EventField::Source },
+            { L"DstIpv4Addr", EventField::Destination } };
+        const std::vector<SchemaField> ipv6Addresses = {
+            { L"SrcIpv6Addr", EventField::Source },
+            { L"DstIpv6Addr", EventField::Destination } };
+        std::vector<SchemaField> bothAddresses = ipv4Addresses;
+        bothAddresses.insert(bothAddresses.end(), ipv6Addresses.begin(), ipv6Addresses.end());
+
+        // Every version of the events, as before the registry; an IPv4 or IPv6 event
+        // only reads its own addresses. ICMP events read either family.
+        EventSchema schema;
+        schema.provider = VFP_PROVIDER_GUID;
+        schema.version = AnyVersion;
+
+        schema.eventId = IPV4_RULE_MATCH_EVENT_ID;
+        schema.name = L"VfpIpv4RuleMatch";
+        schema.fields = VfpFields(ipv4Addresses);
+        Register(schema);
+
+        schema.eventId = IPV6_RULE_MATCH_EVENT_ID;
+        schema.name = L"VfpIpv6RuleMatch";
+        schema.fields = VfpFields(ipv6Addresses);
+        Register(schema);
+
+        schema.eventId = IPV4_ICMP_RULE_MATCH_EVENT_ID;
+        schema.name = L"VfpIcmpRuleMatch";
+        schema.fields = VfpFields(bothAddresses);
+        Register(schema);
+    }
+
+    void SchemaRegistry::Register(const EventSchema& schema)
+    {
+        if (schema.fields.empty())
+        {
+            throw std::exception("Event schema has no fields.");
+        }
+
+        if (FindEntry(schema.provider, schema.eventId, schema.version) != nullptr)
+        {
+            throw std::exception("Event schema is already registered.");
+        }
+
+        auto entry = std::make_unique<Entry>();
+        entry->schema = schema;
+        for (const SchemaField& field : schema.fields)
+        {
+            if (field.property.empty())
+            {
+                throw std::exception("Event schema field has no property name.");
+            }
+            entry->setters.push_back(GetSetter(field.field));
+        }
+
+        m_Entries.push_back(std::move(entry));
+        BuildTable();
+    }
+
+    size_t SchemaRegistry::LoadSchemas(const std::wstring& path)
+    {
+        std::wifstream schemas(path);
+        if (!schemas.is_open())
+        {
+            throw std::exception("Unable to open schema file.");
+        }
+        return LoadSchemas(schemas);
+    }
+
+    size_t SchemaRegistry::LoadSchemas(std::wistream& schemas)
+    {
+        size_t loaded = 0;
+        unsigned long lineNumber = 0;
+        std::wstring line;
+
+        while (std::getline(schemas, line))
+        {
+            lineNumber++;
+
+            std::wistringstream columns(line);
+            std::wstring provider, eventId, version, name, fieldList;
+            columns >> provider;
+            if (provider.empty() || provider.front() == L'#')
+            {
+                continue;
+            }
+            columns >> eventId >> version >> name >> fieldList;
+
+            EventSchema schema;
+            schema.name = name;
+            if (!ParseGuid(provider, &schema.provider))
+            {
+                wprintf(L"Warning: schema line %lu has an invalid provider: %ls.\n", lineNumber, provider.c_str());
+                continue;
+            }
+
+            wchar_t* end = nullptr;
+            unsigned long id = wcstoul(eventId.c_str(), &end, 10);
+            if (eventId.empty() || *end != L'\0' || id > 0xFFFF)
+            {
+                wprintf(L"Warning: schema line %lu has an invalid event id: %ls.\n", lineNumber, eventId.c_str());
+                continue;
+            }
+            schema.eventId = static_cast<USHORT>(id);
+
+            if (version == L"*")
+            {
+                schema.version = AnyVersion;
+            }
+            else
+            {
+                unsigned long parsedVersion = wcstoul(version.c_str(), &end, 10);
+                if (version.empty() || *end != L'\0' || parsedVersion > 0xFF)
+                {
+                    wprintf(L"Warning: schema line %lu has an invalid version: %ls.\n", lineNumber, version.c_str());
+                    continue;
+                }
+                schema.version = static_cast<USHORT>(parsedVersion);
+            }
+
+            if (fieldList.empty())
+            {
+                wprintf(L"Warning: schema line %lu has no fields.\n", lineNumber);
+                continue;
+            }
+
+            bool fieldsValid = true;
+            std::wistringstream fields(fieldList);
+            std::wstring mapping;
+            while (std::getline(fields, mapping, L','))
+            {
+                size_t equals = mapping.find(L'=');
+                SchemaField field;
+                if (equals == 0 ||
+                    equals == std::wstring::npos ||
+                    !ParseField(mapping.substr(equals + 1), &field.field))
+                {
+                    wprintf(L"Warning: schema line %lu has an invalid field: %ls.\n", lineNumber, mapping.c_str());
+                    fieldsValid = false;
+                    break;
+                }
+                field.property = mapping.substr(0, equals);
+                schema.fields.push_back(field);
+            }
+            if (!fieldsValid)
+            {
+                continue;
+            }
+
+            if (FindEntry(schema.provider, schema.eventId, schema.version) != nullptr)
+            {
+                wprintf(L"Warning: schema line %lu repeats a registered event (%ls %u).\n",
+                    lineNumber,
+                    provider.c_str(),
+                    schema.eventId);
+                continue;
+            }
+
+            Register(schema);
+            loaded++;
+        }
+        return loaded;
+    }
+
+    const EventSchema* SchemaRegistry::Find(const GUID& provider, USHORT eventId, UCHAR version) const
+    {
+        const Entry* entry = FindEntry(provider, eventId, version);
+        if (entry == nullptr)
+        {
+            entry = FindEntry(provider, eventId, AnyVersion);
+        }
+        return entry == nullptr ? nullptr : &entry->schema;
+    }
+
+    bool SchemaRegistry::IsRegistered(const ntl::EtwRecord& record) const
+    {
+        return Find(record.getProviderId(), record.getEventId(), record.getVersion()) != nullptr;
+    }
+
+    bool SchemaRegistry::Decode(
+        const ntl::EtwRecord& record,
+        _Out_ VfpEventData* eventData) const
+    {
+        GUID provider = record.getProviderId();
+        USHORT eventId = record.getEventId();
+        UCHAR version = record.getVersion();
+        const Entry* entry = FindEntry(provider, eventId, version);
+        if (entry == nullptr)
+        {
+            entry = FindEntry(provider, eventId, AnyVersion);
+            if (entry == nullptr)
+            {
+                return false;
+            }
+        }
+
+        std::shared_ptr<const PropertyLayout> layout = std::atomic_load(&entry->layout);
+        if (!layout ||
+            layout->version != version)
+        {
+            layout = ResolveLayout(*entry, record);
+            std::atomic_store(&entry->layout, layout);
+        }
+
+        eventData->compact.timeStamp = record.getTimeStamp().QuadPart;
+        eventData->compact.processor = record.getProcessorNumber();
+        Timer::GetDateAndTime(record.getTimeStamp(), &eventData->date, &eventData->time);
+
+        std::wstring value;
+        for (size_t i = 0; i < entry->setters.size(); ++i)
+        {
+            unsigned long position = layout->positions[i];
+            if (position == 0 ||
+                !record.queryEventProperty(position, value))
+            {
+                value.clear();
+            }
+            entry->setters[i](&value, eventData);
+        }
+        return true;
+    }
+
+    std::vector<GUID> SchemaRegistry::GetProviders() const
+    {
+        std::vector<GUID> providers;
+        for (const auto& entry : m_Entries)
+        {
+            const GUID& provider = entry->schema.provider;
+            bool seen = std::any_of(providers.begin(), providers.end(), [&provider](const GUID& other)
+            {
+                return memcmp(&provider, &other, sizeof(GUID)) == 0;
+            });
+            if (!seen)
+            {
+                providers.push_back(provider);
+            }
+        }
+        return providers;
+    }
+
+    size_t SchemaRegistry::GetSchemaCount() const
+    {
+        return m_Entries.size();
+    }
+
+    size_t SchemaRegistry::GetTableSize() const
+    {
+        return m_Slots.size();
+    }
+
+    const SchemaRegistry& SchemaRegistry::Vfp()
+    {
+        static const std::unique_ptr<SchemaRegistry> registry = []()
+        {
+            auto vfp = std::make_unique<SchemaRegistry>();
+            vfp->RegisterVfp();
+            return vfp;
+        }();
+        return *registry;
+    }
+
+    bool SchemaRegistry::ParseField(
+        const std::wstring& name,
+        _Out_ EventField* field)
+    {
+        for (const auto& fieldName : FieldNames)
+        {
+            if (ntl::String::iordinal_equals(name, fieldName.name))
+            {
+                *field = fieldName.field;
+                return true;
+            }
+        }
+        *field = EventField::Source;
+        return false;
+    }
+
+    const SchemaRegistry::Entry* SchemaRegistry::FindEntry(const GUID& provider, USHORT eventId, USHORT version) const
+    {
+        if (m_Slots.empty())
+        {
+            return nullptr;
+        }
+
+        unsigned long long keyHash = KeyHash(provider, eventId, version);
+        unsigned long seed = m_BucketSeeds[BucketOf(keyHash, m_BucketSeeds.size())];
+        unsigned long slot = m_Slots[SlotOf(keyHash, seed, m_Slots.size())];
+        if (slot == 0)
+        {
+            return nullptr;
+        }
+
+        // Keys that were never registered still land on some slot.
+        const Entry* entry = m_Entries[slot - 1].get();
+        return SameKey(entry->schema, provider, eventId, version) ? entry : nullptr;
+    }
+
+    std::shared_ptr<const SchemaRegistry::PropertyLayout> SchemaRegistry::ResolveLayout(
+        const Entry& entry,
+        const ntl::EtwRecord& record) const
+    {
+        auto layout = std::make_shared<PropertyLayout>();
+        layout->version = record.getVersion();
+        layout->positions.assign(entry.schema.fields.size(), 0);
+
+        std::wstring name;
+        for (unsigned long index = 0; record.queryEventPropertyName(index, name); ++index)
+        {
+            for (size_t i = 0; i < entry.schema.fields.size(); ++i)
+            {
+                if (layout->positions[i] == 0 &&
+                    ntl::String::iordinal_equals(name, entry.schema.fields[i].property))
+                {
+                    layout->positions[i] = index + 1;
+                }
+            }
+        }
+        return layout;
+    }
+
+    void SchemaRegistry::BuildTable()
+    {
+        // At most half the slots are used, so most buckets are placed by their first seeds.
+        size_t slotCount = 2;
+        while (slotCount < m_Entries.size() * 2)
+        {
+            slotCount *= 2;
+        }
+        size_t bucketCount = m_Entries.size() / 2 + 1;
+
+        while (!TryBuildTable(slotCount, bucketCount))
+        {
+            slotCount *= 2;
+        }
+    }
+
+    bool SchemaRegistry::TryBuildTable(size_t slotCount, size_t bucketCount)
+    {
+        std::vector<unsigned long long> keyHashes;
+        std::vector<std::vector<unsigned long>> buckets(bucketCount);
+        for (size_t i = 0; i < m_Entries.size(); ++i)
+        {
+            const EventSchema& schema = m_Entries[i]->schema;
+            keyHashes.push_back(KeyHash(schema.provider, schema.eventId, schema.version));
+            buckets[BucketOf(keyHashes.back(), bucketCount)].push_back(static_cast<unsigned long>(i));
+        }
+
+        // Hash and displace: the fullest buckets pick their seeds while the table is emptiest.
+        std::vector<size_t> order(bucketCount);
+        for (size_t i = 0; i < bucketCount; ++i)
+        {
+            order[i] = i;
+        }
+        std::stable_sort(order.begin(), order.end(), [&buckets](size_t left, size_t right)
+        {
+            return buckets[left].size() > buckets[right].size();
+        });
+
+        m_Slots.assign(slotCount, 0);
+        m_BucketSeeds.assign(bucketCount, 0);
+        std::vector<size_t> placed;
+        for (size_t bucket : order)
+        {
+            if (buckets[bucket].empty())
+            {
+                break;
+            }
+
+            bool found = false;
+            for (unsigned long seed = 0; seed < MaxSeedAttempts && !found; ++seed)
+            {
+                placed.clear();
+                found = true;
+                for (unsigned long entryIndex : buckets[bucket])
+                {
+                    size_t slot = SlotOf(keyHashes[entryIndex], seed, slotCount);
+                    if (m_Slots[slot] != 0 ||
+                        std::find(placed.begin(), placed.end(), slot) != placed.end())
+                    {
+                        found = false;
+                        break;
+                    }
+                    placed.push_back(slot);
+                }
+
+                if (found)
+                {
+                    m_BucketSeeds[bucket] = seed;
+                    for (size_t i = 0; i < placed.size(); ++i)
+                    {
+                        m_Slots[placed[i]] = buckets[bucket][i] + 1;
+                    }
+                }
+            }
+
+            if (!found)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    unsigned long long SchemaRegistry::KeyHash(const GUID& provider, USHORT eventId, USHORT version)
+    {
+        unsigned long long low = 0, high = 0;
+        memcpy(&low, &provider, sizeof(low));
+        memcpy(&high, reinterpret_cast<const unsigned char*>(&provider) + sizeof(low), sizeof(high));
+        unsigned long long descriptor = (static_cast<unsigned long long>(eventId) << 16) | version;
+        return Fmix(low ^ Fmix(high ^ Fmix(descriptor)));
+    }
+
+    SchemaRegistry::FieldSetter SchemaRegistry::GetSetter(EventField field)
+    {
+        switch (field)
+        {
+        case EventField::Source: return SetSource;
+        case EventField::Destination: return SetDestination;
+        case EventField::Direction: return SetDirection;
+        case EventField::RuleType: return SetRuleType;
+        case EventField::Protocol: return SetProtocol;
+        case EventField::IcmpType: return SetIcmpType;
+        case EventField::Status: return SetStatus;
+        case EventField::PortId: return SetPortId;
+        case EventField::PortName: return SetPortName;
+        case EventField::PortFriendlyName: return SetPortFriendlyName;
+        case EventField::SourcePort: return SetSourcePort;
+        case EventField::DestinationPort: return SetDestinationPort;
+        case EventField::IsTcpSyn: return SetIsTcpSyn;
+        case EventField::RuleId: return SetRuleId;
+        case EventField::LayerId: return SetLayerId;
+        case EventField::GroupId: return SetGroupId;
+        case EventField::GftFlags: return SetGftFlags;
+        }
+        throw std::exception("Unknown event field.");
+    }
+}
@@ -0,0 +1,157 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#pragma once
+
+// os headers
+#include <Windows.h>
+// c++ headers
+#include <istream>
+#include <memory>
+#include <string>
+#include <vector>
+// ntl headers
+#include "ntlEtwRecord.hpp"
+
+namespace FirewallEventMonitor
+{
+    struct VfpEventData;
+
+    // Event fields a schema can fill. Values are translated as for the VFP events
+    // (e.g. Direction 0 is Outbound, RuleType 2 is Deny).
+    enum class EventField : unsigned char
+    {
+        Source,
+        Destination,
+        Direction,
+        RuleType,
+        Protocol,
+        IcmpType,
+        Status,
+        PortId,
+        PortName,
+        PortFriendlyName,
+        SourcePort,
+        DestinationPort,
+        IsTcpSyn,
+        RuleId,
+        LayerId,
+        GroupId,
+        GftFlags
+    };
+
+    // One event property and the field it fills.
+    struct SchemaField
+    {
+    public:
+        std::wstring property;
+        EventField field = EventField::Source;
+    };
+
+    // Layout of one event: (provider, event id, version) and the fields decoded from it.
+    struct EventSchema
+    {
+    public:
+        GUID provider = {};
+        USHORT eventId = 0;
+        USHORT version = 0; // Event version, or SchemaRegistry::AnyVersion.
+        std::wstring name;
+        std::vector<SchemaField> fields;
+    };
+
+    // Decodes the events of every registered provider into the event data of the pipeline.
+    // Schemas are registered before the session starts and laid out in a perfect hash table,
+    // so finding the schema of an event costs two hashes and one key compare.
+    // Property positions are resolved by name once per event version, not once per event.
+    class SchemaRegistry
+    {
+    public:
+        SchemaRegistry() = default;
+        ~SchemaRegistry() = default;
+
+        SchemaRegistry(const SchemaRegistry&) = delete;
+        SchemaRegistry& operator=(const SchemaRegistry&) = delete;
+
+        // Registers the VFP rule match events (400, 401 and 402).
+        void RegisterVfp();
+
+        // Throws if the schema is already registered or has no fields.
+        void Register(const EventSchema& schema);
+
+        // Lines of "<provider guid> <event id> <version|*> <name> <property>=<field>[,...]";
+        // '#' starts a comment. Malformed lines are skipped with a warning.
+        // Returns the number of schemas registered.
+        size_t LoadSchemas(const std::wstring& path);
+        size_t LoadSchemas(std::wistream& schemas);
+
+        // Schema of the event, preferring an exact version over AnyVersion; nullptr if not registered.
+        const EventSchema* Find(const GUID& provider, USHORT eventId, UCHAR version) const;
+
+        bool IsRegistered(const ntl::EtwRecord& record) const;
+
+        // Fills eventData from the event; false if its schema is not registered.
+        bool Decode(
+            const ntl::EtwRecord& record,
+            _Out_ VfpEventData* eventData) const;
+
+        // Each provider once, in registration order, to enable on the session.
+        std::vector<GUID> GetProviders() const;
+
+        size_t GetSchemaCount() const;
+
+        // Slots in the hash table; at least twice the schema count.
+        size_t GetTableSize() const;
+
+        // Registry of the VFP events alone, for offline readers (e.g. CaptureDiff).
+        static const SchemaRegistry& Vfp();
+
+        static bool ParseField(
+            const std::wstring& name,
+            _Out_ EventField* field);
+
+        // Constants
+        static const USHORT AnyVersion = 0xFFFF;
+
+    private:
+        typedef void(*FieldSetter)(_Inout_ std::wstring* value, _Inout_ VfpEventData* eventData);
+
+        // 1-based property positions of one event version (queryEventProperty's indexing); 0 if absent.
+        struct PropertyLayout
+        {
+            UCHAR version = 0;
+            std::vector<unsigned long> positions;
+        };
+
+        struct Entry
+        {
+            EventSchema schema;
+            std::vector<FieldSetter> setters;
+            // Replaced whole when an event of another version arrives, so readers never see it torn.
+            mutable std::shared_ptr<const PropertyLayout> layout;
+        };
+
+        std::vector<std::unique_ptr<Entry>> m_Entries;
+        // Perfect hash: a key's bucket selects the seed that places it in its own slot.
+        std::vector<unsigned long> m_BucketSeeds;
+        // Index into m_Entries plus one; 0 for an empty slot.
+        std::vector<unsigned long> m_Slots;
+
+        // Constants
+        static const unsigned long MaxSeedAttempts = 1ul << 16;
+
+        const Entry* FindEntry(const GUID& provider, USHORT eventId, USHORT version) const;
+
+        std::shared_ptr<const PropertyLayout> ResolveLayout(
+            const Entry& entry,
+            const ntl::EtwRecord& record) const;
+
+        // Rebuilds the hash table over every entry; called after each registration.
+        void BuildTable();
+
+        bool TryBuildTable(size_t slotCount, size_t bucketCount);
+
+        static unsigned long long KeyHash(const GUID& provider, USHORT eventId, USHORT version);
+
+        static FieldSetter GetSetter(EventField field);
+    };
+}
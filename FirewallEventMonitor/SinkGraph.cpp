@@ -0,0 +1,94 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include "SinkGraph.h"
+
+// c++ headers
+#include <algorithm>
+
+namespace FirewallEventMonitor
+{
+    void SinkGraph::AddSink(std::shared_ptr<EventSink> sink)
+    {
+        auto& sinksOfFormat = m_SinksByFormat[static_cast<size_t>(sink->GetFormat())];
+        if (sinksOfFormat.empty())
+        {
+            m_FormatsInUse.push_back(sink->GetFormat());
+        }
+
+        sinksOfFormat.push_back(sink);
+        m_Sinks.push_back(std::move(sink));
+    }
+
+    void SinkGraph::Start()
+    {
+        for (const auto& sink : m_Sinks)
+        {
+            sink->Start();
+        }
+    }
+
+    void SinkGraph::Stop()
+    {
+        for (const auto& sink : m_Sinks)
+        {
+            sink->Stop();
+        }
+    }
+
+    void SinkGraph::StopBy(ULONGLONG deadline)
+    {
+        for (const auto& sink : m_Sinks)
+        {
+            sink->StopBy(deadline);
+        }
+    }
+
+    unsigned long long SinkGraph::GetEventsWritten() const
+    {
+        unsigned long long written = 0;
+        for (const auto& sink : m_Sinks)
+        {
+            written += sink->GetEventsWritten();
+        }
+        return written;
+    }
+
+    unsigned long long SinkGraph::GetEventsAbandoned() const
+    {
+        unsigned long long abandoned = 0;
+        for (const auto& sink : m_Sinks)
+        {
+            abandoned += sink->GetEventsAbandoned();
+        }
+        return abandoned;
+    }
+
+    const std::vector<EventFormat>& SinkGraph::GetFormatsInUse() const
+    {
+        return m_FormatsInUse;
+    }
+
+    void SinkGraph::Publish(EventFormat format, const EncodedEvent& event)
+    {
+        for (const auto& sink : m_SinksByFormat[static_cast<size_t>(format)])
+        {
+            sink->Write(event);
+        }
+    }
+
+    double SinkGraph::GetQueueUsage() const
+    {
+        double usage = 0.0;
+        for (const auto& sink : m_Sinks)
+        {
+            usage = (std::max)(usage, sink->GetQueueUsage());
+        }
+        return usage;
+    }
+
+    const std::vector<std::shared_ptr<EventSink>>& SinkGraph::GetSinks() const
+    {
+        return m_Sinks;
+    }
+}
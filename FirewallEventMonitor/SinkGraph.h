@@ -0,0 +1,58 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#pragma once
+
+// c++ headers
+#include <memory>
+#include <vector>
+
+#include "EventSink.h"
+
+namespace FirewallEventMonitor
+{
+    // The sinks of a capture, grouped by the format they write.
+    // The callback encodes each event once per format in GetFormatsInUse() and publishes
+    // it; every sink of that format queues the same shared text, so adding a sink adds a
+    // queue push per event rather than another formatting pass.
+    // Sinks are added before Start(); the graph is not changed while events flow.
+    class SinkGraph
+    {
+    public:
+        SinkGraph() = default;
+
+        void AddSink(std::shared_ptr<EventSink> sink);
+
+        void Start();
+
+        // Stops every sink, each writing what it still has queued.
+        void Stop();
+
+        // Stops every sink, giving up on what is still queued at deadline (a GetTickCount64() value).
+        // Sinks keep writing on their own threads until stopped, so they drain side by side.
+        void StopBy(ULONGLONG deadline);
+
+        // Events written by all the sinks, and given up on by StopBy().
+        unsigned long long GetEventsWritten() const;
+
+        unsigned long long GetEventsAbandoned() const;
+
+        // Formats with at least one sink, in the order their first sink was added.
+        const std::vector<EventFormat>& GetFormatsInUse() const;
+
+        // Queues the event on each sink of its format.
+        void Publish(EventFormat format, const EncodedEvent& event);
+
+        // The fullest sink's queue usage, from 0 to 1.
+        double GetQueueUsage() const;
+
+        const std::vector<std::shared_ptr<EventSink>>& GetSinks() const;
+
+        SinkGraph(SinkGraph const&) = delete;
+        SinkGraph& operator=(SinkGraph const&) = delete;
+    private:
+        std::vector<std::shared_ptr<EventSink>> m_Sinks;
+        std::vector<EventFormat> m_FormatsInUse;
+        std::vector<std::shared_ptr<EventSink>> m_SinksByFormat[static_cast<size_t>(EventFormat::Count)];
+    };
+}
@@ -0,0 +1,190 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include "SketchMerge.h"
+
+// c++ headers
+#include <algorithm>
+#include <atomic>
+#include <future>
+
+#include "Timer.h"
+
+namespace FirewallEventMonitor
+{
+    namespace
+    {
+        // ISO 8601 basic format, UTC: 20170907T224228Z.
+        std::wstring FormatSketchTime(LONGLONG timeStamp)
+        {
+            if (timeStamp == 0)
+            {
+                return std::wstring(L"-");
+            }
+
+            LARGE_INTEGER sketchTime;
+            sketchTime.QuadPart = timeStamp;
+            std::wstring date, time;
+            Timer::GetDateAndTime(sketchTime, &date, &time);
+            return date + L"T" + time + L"Z";
+        }
+
+        void PrintTopList(
+            const EventSketch& sketch,
+            SketchTopKeys topKeys,
+            LPCWSTR title,
+            size_t topCount,
+            _In_ FILE* stream)
+        {
+            const SketchTopList& topList = sketch.GetTopList(topKeys);
+            // Keys left out of the list had at most this many events each.
+            fwprintf(stream, L"  %ls {keys = %zu, events = %llu, notListedAtMost = %llu} \n",
+                title,
+                topList.size(),
+                topList.total(),
+                topList.absent_bound());
+            for (const auto& entry : sketch.GetTop(topKeys, topCount))
+            {
+                fwprintf(stream, L"    %ls: events = %llu {overcountAtMost = %llu} \n",
+                    entry.name.c_str(),
+                    entry.events,
+                    entry.error);
+            }
+        }
+    }
+
+    SketchMerge::SketchMerge(size_t threadCount)
+        : m_ThreadCount(threadCount != 0 ? threadCount : (std::max)(static_cast<size_t>(::GetActiveProcessorCount(ALL_PROCESSOR_GROUPS)), static_cast<size_t>(1)))
+    {
+    }
+
+    std::vector<std::wstring> SketchMerge::FindSketchFiles(const std::wstring& path)
+    {
+        std::wstring directory;
+        std::wstring pattern;
+        DWORD attributes = ::GetFileAttributesW(path.c_str());
+        if (attributes != INVALID_FILE_ATTRIBUTES &&
+            (attributes & FILE_ATTRIBUTE_DIRECTORY) != 0)
+        {
+            directory = path;
+            pattern = path + L"\\*" + SketchRecorder::FileExtension;
+        }
+        else if (path.find_first_of(L"*?") != std::wstring::npos)
+        {
+            size_t separator = path.find_last_of(L"\\/");
+            directory = separator != std::wstring::npos ? path.substr(0, separator) : L".";
+            pattern = path;
+        }
+        else
+        {
+            // A single file; if it cannot be read, the merge says so.
+            return std::vector<std::wstring>(1, path);
+        }
+
+        std::vector<std::wstring> paths;
+        WIN32_FIND_DATAW findData;
+        HANDLE find = ::FindFirstFileW(pattern.c_str(), &findData);
+        if (find == INVALID_HANDLE_VALUE)
+        {
+            return paths;
+        }
+        do
+        {
+            if ((findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0)
+            {
+                paths.push_back(directory + L"\\" + findData.cFileName);
+            }
+        } while (::FindNextFileW(find, &findData));
+        ::FindClose(find);
+
+        std::sort(paths.begin(), paths.end());
+        return paths;
+    }
+
+    EventSketch SketchMerge::Merge(
+        const std::vector<std::wstring>& paths,
+        _Out_ SketchMergeResult* result) const
+    {
+        *result = SketchMergeResult();
+        std::atomic<size_t> next{ 0 };
+        std::atomic<size_t> filesMerged{ 0 };
+        std::atomic<size_t> filesSkipped{ 0 };
+
+        // Each thread takes the next file not yet taken, so a slow file does not hold up a fixed share.
+        auto mergeShare = [&]()
+        {
+            EventSketch share;
+            for (size_t index = next++; index < paths.size(); index = next++)
+            {
+                try
+                {
+                    share.Merge(EventSketch::ReadFile(paths[index]));
+                    ++filesMerged;
+                }
+                catch (const std::exception& ex)
+                {
+                    wprintf(L"Warning: Skipping sketch %ls: %S.\n", paths[index].c_str(), ex.what());
+                    ++filesSkipped;
+                }
+            }
+            return share;
+        };
+
+        size_t threadCount = (std::min)(m_ThreadCount, paths.size());
+        std::vector<std::future<EventSketch>> shares;
+        for (size_t thread = 1; thread < threadCount; ++thread)
+        {
+            shares.push_back(std::async(std::launch::async, mergeShare));
+        }
+        // This thread merges a share too, then the others' shares into its own.
+        EventSketch fleet = mergeShare();
+        for (auto& share : shares)
+        {
+            fleet.Merge(share.get());
+        }
+
+        result->filesMerged = filesMerged;
+        result->filesSkipped = filesSkipped;
+        return fleet;
+    }
+
+    void SketchMerge::PrintReport(
+        const EventSketch& sketch,
+        const SketchMergeResult& result,
+        size_t topCount,
+        _In_ FILE* stream)
+    {
+        fwprintf(stream, L"Sketch merge {files = %zu, skipped = %zu, hosts = %zu, snapshots = %llu} \n",
+            result.filesMerged,
+            result.filesSkipped,
+            sketch.GetHosts().size(),
+            sketch.GetSnapshotCount());
+
+        fwprintf(stream, L"  interval {start = %ls, end = %ls} \n",
+            FormatSketchTime(sketch.GetStartTime()).c_str(),
+            FormatSketchTime(sketch.GetEndTime()).c_str());
+
+        fwprintf(stream, L"  events {total = %llu, allow = %llu, deny = %llu} \n",
+            sketch.GetEventCount(),
+            sketch.GetAllowEventCount(),
+            sketch.GetDenyEventCount());
+
+        // HyperLogLog estimates: within about 1% of the true counts.
+        fwprintf(stream, L"  distinct {sources = %.0f, destinations = %.0f, flows = %.0f} \n",
+            sketch.EstimateDistinct(SketchCardinality::Sources),
+            sketch.EstimateDistinct(SketchCardinality::Destinations),
+            sketch.EstimateDistinct(SketchCardinality::Flows));
+
+        const ntl::TDigest& lag = sketch.GetQuantiles(SketchQuantiles::LagInMilliseconds);
+        fwprintf(stream, L"  lag {p50 = %.1f ms, p90 = %.1f ms, p99 = %.1f ms, max = %.1f ms} \n",
+            lag.quantile(0.50),
+            lag.quantile(0.90),
+            lag.quantile(0.99),
+            lag.maximum());
+
+        PrintTopList(sketch, SketchTopKeys::Sources, L"topSources", topCount, stream);
+        PrintTopList(sketch, SketchTopKeys::Destinations, L"topDestinations", topCount, stream);
+        PrintTopList(sketch, SketchTopKeys::DestinationPorts, L"topPorts", topCount, stream);
+        PrintTopList(sketch, SketchTopKeys::Rules, L"topRules", topCount, stream);
+    }
+}
@@ -0,0 +1,55 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#pragma once
+
+// OS Headers
+#include <Windows.h>
+// c++ headers
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "EventSketch.h"
+
+namespace FirewallEventMonitor
+{
+    // Files merged into a fleet sketch, and those that could not be.
+    struct SketchMergeResult
+    {
+    public:
+        size_t filesMerged = 0;
+        size_t filesSkipped = 0; // Unreadable, damaged, or of a later version; each is named in a warning.
+    };
+
+    // Merges the sketches written by many hosts (-MergeSketches) into one, for fleet-wide
+    // top lists, distinct counts and lag quantiles. The files are split across threads, each
+    // merging its share into a sketch of its own; the threads' sketches are merged last. Merging
+    // only reads the sketches, so its cost depends on the number of files, not of events.
+    class SketchMerge
+    {
+    public:
+        // 0 threads uses one per active processor.
+        SketchMerge(size_t threadCount = 0);
+
+        // The sketch files a path names: a file, every sketch file in a directory, or the files
+        // matching a wildcard pattern (e.g. C:\sketches\web*.sketch). Sorted by name.
+        static std::vector<std::wstring> FindSketchFiles(const std::wstring& path);
+
+        EventSketch Merge(
+            const std::vector<std::wstring>& paths,
+            _Out_ SketchMergeResult* result) const;
+
+        static void PrintReport(
+            const EventSketch& sketch,
+            const SketchMergeResult& result,
+            size_t topCount,
+            _In_ FILE* stream);
+
+        // Constants
+        static const size_t DefaultReportLimit = 20; // Entries printed per top list.
+
+    private:
+        const size_t m_ThreadCount;
+    };
+}
@@ -0,0 +1,208 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#pragma once
+
+// c++ headers
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+// ntl headers
+#include "ntlFlatHashMap.hpp"
+
+namespace FirewallEventMonitor
+{
+    // Aggregates values by key in bounded memory.
+    // Entries are combined in a hash map that starts small and grows with the keys seen;
+    // once it holds maxEntriesInMemory keys it is sorted and spilled to a temporary file
+    // as a sorted run. Finish() then merges the runs and the in-memory remainder into a single stream in ascending key order,
+    // combining entries for the same key.
+    //
+    // Key and Value must be trivially copyable (runs are written as raw bytes), and
+    // Value must provide Merge(const Value&).
+    template <typename Key, typename Value, typename Hash, typename Less, typename KeyEqual = std::equal_to<Key>>
+    class SortedRunAggregator
+    {
+    public:
+        typedef std::pair<Key, Value> Entry;
+
+        explicit SortedRunAggregator(size_t maxEntriesInMemory)
+            : m_MaxEntriesInMemory(maxEntriesInMemory == 0 ? 1 : maxEntriesInMemory)
+        {
+        }
+
+        ~SortedRunAggregator()
+        {
+            for (auto& run : m_Runs)
+            {
+                fclose(run.file);
+            }
+        }
+
+        void Add(const Key& key, const Value& value)
+        {
+            auto inserted = m_Entries.try_emplace(key);
+            if (inserted.second)
+            {
+                *inserted.first = value;
+            }
+            else
+            {
+                inserted.first->Merge(value);
+            }
+
+            if (m_Entries.size() >= m_MaxEntriesInMemory)
+            {
+                Spill();
+            }
+        }
+
+        size_t GetRunCount() const
+        {
+            return m_Runs.size();
+        }
+
+        // Prepares the merged stream; call once after the last Add().
+        void Finish()
+        {
+            m_Remainder = SortedEntries();
+            // Release the map's slots; the remainder holds its entries from here on.
+            m_Entries = ntl::FlatHashMap<Key, Value, Hash, KeyEqual>();
+            m_RemainderPosition = 0;
+
+            for (auto& run : m_Runs)
+            {
+                rewind(run.file);
+                run.hasEntry = ReadEntry(run);
+            }
+        }
+
+        // Returns the next key in ascending order with all of its values merged.
+        bool Next(_Out_ Entry* entry)
+        {
+            // Find the smallest key across the runs and the in-memory remainder.
+            const Key* smallest = nullptr;
+            if (m_RemainderPosition < m_Remainder.size())
+            {
+                smallest = &m_Remainder[m_RemainderPosition].first;
+            }
+            for (const auto& run : m_Runs)
+            {
+                if (run.hasEntry && (smallest == nullptr || m_Less(run.entry.first, *smallest)))
+                {
+                    smallest = &run.entry.first;
+                }
+            }
+            if (smallest == nullptr)
+            {
+                return false;
+            }
+
+            Key key = *smallest;
+            bool found = false;
+            auto take = [&](const Entry& source)
+            {
+                if (!found)
+                {
+                    *entry = source;
+                    found = true;
+                }
+                else
+                {
+                    entry->second.Merge(source.second);
+                }
+            };
+
+            if (m_RemainderPosition < m_Remainder.size() &&
+                !m_Less(key, m_Remainder[m_RemainderPosition].first))
+            {
+                take(m_Remainder[m_RemainderPosition]);
+                m_RemainderPosition++;
+            }
+            for (auto& run : m_Runs)
+            {
+                // Each run holds a key at most once.
+                if (run.hasEntry && !m_Less(key, run.entry.first))
+                {
+                    take(run.entry);
+                    run.hasEntry = ReadEntry(run);
+                }
+            }
+            return true;
+        }
+
+        SortedRunAggregator(SortedRunAggregator const&) = delete;
+        SortedRunAggregator& operator=(SortedRunAggregator const&) = delete;
+    private:
+        struct Run
+        {
+            FILE* file = nullptr;
+            std::vector<Entry> buffer;
+            size_t position = 0;
+            Entry entry;
+            bool hasEntry = false;
+        };
+
+        static const size_t RunReadBufferEntries = 4096;
+
+        const size_t m_MaxEntriesInMemory;
+        ntl::FlatHashMap<Key, Value, Hash, KeyEqual> m_Entries;
+        std::vector<Run> m_Runs;
+        std::vector<Entry> m_Remainder;
+        size_t m_RemainderPosition = 0;
+        Less m_Less;
+
+        std::vector<Entry> SortedEntries() const
+        {
+            std::vector<Entry> sorted;
+            sorted.reserve(m_Entries.size());
+            m_Entries.for_each([&sorted](const Key& key, const Value& value)
+            {
+                sorted.emplace_back(key, value);
+            });
+            std::sort(sorted.begin(), sorted.end(), [this](const Entry& lhs, const Entry& rhs)
+            {
+                return m_Less(lhs.first, rhs.first);
+            });
+            return sorted;
+        }
+
+        void Spill()
+        {
+            std::vector<Entry> sorted = SortedEntries();
+            m_Entries.clear();
+
+            Run run;
+            if (tmpfile_s(&run.file) != 0 || run.file == nullptr)
+            {
+                throw std::exception("Unable to create a temporary file for a sorted run.");
+            }
+            m_Runs.push_back(std::move(run));
+
+            if (fwrite(sorted.data(), sizeof(Entry), sorted.size(), m_Runs.back().file) != sorted.size())
+            {
+                throw std::exception("Unable to write a sorted run.");
+            }
+        }
+
+        bool ReadEntry(Run& run)
+        {
+            if (run.position == run.buffer.size())
+            {
+                run.buffer.resize(RunReadBufferEntries);
+                size_t read = fread(run.buffer.data(), sizeof(Entry), run.buffer.size(), run.file);
+                run.buffer.resize(read);
+                run.position = 0;
+                if (read == 0)
+                {
+                    return false;
+                }
+            }
+            run.entry = run.buffer[run.position++];
+            return true;
+        }
+    };
+}
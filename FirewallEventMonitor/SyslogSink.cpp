@@ -0,0 +1,521 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include "SyslogSink.h"
+
+// os headers
+#include <ws2tcpip.h>
+// c++ headers
+#include <algorithm>
+// ntl headers
+#include "ntlScopeGuard.hpp"
+
+namespace FirewallEventMonitor
+{
+    SyslogSink::SyslogSink(
+        const std::wstring& host,
+        unsigned short port,
+        SyslogTransport transport,
+        const std::wstring& spillPath,
+        unsigned long long maxSpillBytes,
+        size_t maxQueuedEvents)
+        : QueuedEventSink(maxQueuedEvents),
+        m_Host(host),
+        m_Port(port),
+        m_Transport(transport),
+        m_SpillPath(spillPath),
+        m_MaxSpillBytes(maxSpillBytes)
+    {
+        WSADATA wsaData;
+        int error = ::WSAStartup(MAKEWORD(2, 2), &wsaData);
+        if (error != 0)
+        {
+            throw std::exception("Unable to initialize Winsock for the syslog sink.");
+        }
+
+        // Events a previous run could not send go out before this run's.
+        if (::GetFileAttributesW(m_SpillPath.c_str()) != INVALID_FILE_ATTRIBUTES)
+        {
+            OpenSpillFile();
+            if (m_SpillBytes > 0)
+            {
+                wprintf(L"\tSyslog: %llu bytes left in %ls by a previous run will be sent first.\n",
+                    m_SpillBytes.load(),
+                    m_SpillPath.c_str());
+            }
+        }
+    }
+
+    SyslogSink::~SyslogSink()
+    {
+        Stop();
+        ::WSACleanup();
+    }
+
+    LPCWSTR SyslogSink::GetName() const
+    {
+        return L"Syslog";
+    }
+
+    EventFormat SyslogSink::GetFormat() const
+    {
+        return EventFormat::Syslog;
+    }
+
+    void SyslogSink::StopBy(ULONGLONG deadline)
+    {
+        QueuedEventSink::StopBy(deadline);
+        Disconnect();
+
+        if (m_SpillFile != NULL)
+        {
+            unsigned long long unsent = m_SpillBytes - m_SpillReplayed;
+            if (unsent > 0)
+            {
+                wprintf(L"Warning: %llu bytes of syslog messages could not be sent and remain in %ls.\n",
+                    unsent,
+                    m_SpillPath.c_str());
+            }
+            fclose(m_SpillFile);
+            m_SpillFile = NULL;
+        }
+    }
+
+    unsigned long long SyslogSink::GetEventsDropped() const
+    {
+        return QueuedEventSink::GetEventsDropped() + m_EventsLost.load(std::memory_order_relaxed);
+    }
+
+    unsigned long long SyslogSink::GetBytesSent() const
+    {
+        return m_BytesSent.load(std::memory_order_relaxed);
+    }
+
+    unsigned long long SyslogSink::GetEventsSpilled() const
+    {
+        return m_EventsSpilled.load(std::memory_order_relaxed);
+    }
+
+    unsigned long long SyslogSink::GetConnectFailures() const
+    {
+        return m_ConnectFailures.load(std::memory_order_relaxed);
+    }
+
+    unsigned long long SyslogSink::GetSpillBytes() const
+    {
+        return m_SpillBytes.load(std::memory_order_relaxed);
+    }
+
+    void SyslogSink::AppendFrame(const std::wstring& text, std::string* buffer)
+    {
+        // The length prefix is only known once the text is encoded, so it is inserted
+        // in front of it; the move is of bytes already in cache.
+        size_t begin = buffer->size();
+        AppendUtf8(text, buffer);
+        char prefix[24];
+        int prefixLength = sprintf_s(prefix, "%zu ", buffer->size() - begin);
+        buffer->insert(begin, prefix, prefixLength);
+    }
+
+    void SyslogSink::WriteBatch(const std::vector<EncodedEvent>& events)
+    {
+        m_SendBuffer.clear();
+        m_Frames.clear();
+        for (const auto& event : events)
+        {
+            Frame frame;
+            frame.begin = m_SendBuffer.size();
+            AppendFrame(*event, &m_SendBuffer);
+            frame.message = m_SendBuffer.find(' ', frame.begin) + 1;
+            frame.end = m_SendBuffer.size();
+            m_Frames.push_back(frame);
+        }
+
+        // Anything already spilled goes first, so the collector sees events in order.
+        size_t firstUnsent = 0;
+        if (EnsureConnected() &&
+            ReplaySpill())
+        {
+            firstUnsent = SendFrames(m_SendBuffer, m_Frames, 0);
+        }
+
+        Spill(m_SendBuffer, m_Frames, firstUnsent);
+    }
+
+    bool SyslogSink::EnsureConnected()
+    {
+        if (m_Socket != INVALID_SOCKET)
+        {
+            return true;
+        }
+
+        ULONGLONG now = ::GetTickCount64();
+        if (now < m_NextConnectAttempt)
+        {
+            return false;
+        }
+
+        if (Connect())
+        {
+            m_Backoff = InitialBackoffInMilliseconds;
+            return true;
+        }
+
+        m_ConnectFailures.fetch_add(1, std::memory_order_relaxed);
+        wprintf(L"Warning: Unable to reach syslog collector %ls port %u; retrying in %lu ms.\n",
+            m_Host.c_str(),
+            m_Port,
+            m_Backoff);
+        m_NextConnectAttempt = now + m_Backoff;
+        m_Backoff = (std::min)(m_Backoff * 2, MaxBackoffInMilliseconds);
+        return false;
+    }
+
+    bool SyslogSink::Connect()
+    {
+        bool udp = m_Transport == SyslogTransport::Udp;
+
+        ADDRINFOW hints = {};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = udp ? SOCK_DGRAM : SOCK_STREAM;
+        hints.ai_protocol = udp ? IPPROTO_UDP : IPPROTO_TCP;
+        ADDRINFOW* addresses = nullptr;
+        // Resolved on every attempt, so a collector that moves is found again.
+        if (::GetAddrInfoW(m_Host.c_str(), std::to_wstring(m_Port).c_str(), &hints, &addresses) != 0)
+        {
+            return false;
+        }
+        ScopeGuard(freeAddressesOnExit, { ::FreeAddrInfoW(addresses); });
+
+        for (ADDRINFOW* address = addresses; address != nullptr; address = address->ai_next)
+        {
+            SOCKET connection = ::socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+            if (connection == INVALID_SOCKET)
+            {
+                continue;
+            }
+
+            // A connected UDP socket also reports ICMP port unreachable as a send error.
+            if (ConnectWithTimeout(connection, address->ai_addr, static_cast<int>(address->ai_addrlen)))
+            {
+                // A collector that stops reading must not hold up the worker indefinitely.
+                DWORD sendTimeout = SendTimeoutInMilliseconds;
+                ::setsockopt(connection, SOL_SOCKET, SO_SNDTIMEO, reinterpret_cast<const char*>(&sendTimeout), sizeof(sendTimeout));
+                m_Socket = connection;
+                return true;
+            }
+
+            ::closesocket(connection);
+        }
+
+        return false;
+    }
+
+    bool SyslogSink::ConnectWithTimeout(
+        SOCKET connection,
+        const SOCKADDR* address,
+        int length) const
+    {
+        // Non-blocking, so an unreachable host costs ConnectTimeoutInMilliseconds rather than
+        // the system's much longer SYN retry time.
+        u_long nonBlocking = 1;
+        ::ioctlsocket(connection, FIONBIO, &nonBlocking);
+
+        if (::connect(connection, address, length) == SOCKET_ERROR)
+        {
+            if (::WSAGetLastError() != WSAEWOULDBLOCK)
+            {
+                return false;
+            }
+
+            fd_set writable;
+            FD_ZERO(&writable);
+            FD_SET(connection, &writable);
+            fd_set failed;
+            FD_ZERO(&failed);
+            FD_SET(connection, &failed);
+            timeval timeout = {
+                static_cast<long>(ConnectTimeoutInMilliseconds / 1000),
+                static_cast<long>((ConnectTimeoutInMilliseconds % 1000) * 1000) };
+            if (::select(0, NULL, &writable, &failed, &timeout) <= 0 ||
+                !FD_ISSET(connection, &writable))
+            {
+                return false;
+            }
+
+            int error = 0;
+            int errorLength = sizeof(error);
+            if (::getsockopt(connection, SOL_SOCKET, SO_ERROR, reinterpret_cast<char*>(&error), &errorLength) != 0 ||
+                error != 0)
+            {
+                return false;
+            }
+        }
+
+        nonBlocking = 0;
+        ::ioctlsocket(connection, FIONBIO, &nonBlocking);
+        return true;
+    }
+
+    void SyslogSink::Disconnect()
+    {
+        if (m_Socket != INVALID_SOCKET)
+        {
+            ::closesocket(m_Socket);
+            m_Socket = INVALID_SOCKET;
+        }
+    }
+
+    size_t SyslogSink::SendFrames(
+        const std::string& buffer,
+        const std::vector<Frame>& frames,
+        size_t first)
+    {
+        if (m_Transport == SyslogTransport::Udp)
+        {
+            for (size_t i = first; i < frames.size(); ++i)
+            {
+                size_t length = (std::min)(frames[i].end - frames[i].message, MaxUdpMessageBytes);
+                // A cut message ends on a whole UTF-8 sequence: back off over continuation bytes.
+                while (length > 0 &&
+                    frames[i].message + length < frames[i].end &&
+                    (static_cast<unsigned char>(buffer[frames[i].message + length]) & 0xC0) == 0x80)
+                {
+                    --length;
+                }
+                int sent = ::send(m_Socket, buffer.data() + frames[i].message, static_cast<int>(length), 0);
+                if (sent == SOCKET_ERROR)
+                {
+                    Disconnect();
+                    m_NextConnectAttempt = ::GetTickCount64() + m_Backoff;
+                    return i;
+                }
+                m_BytesSent.fetch_add(sent, std::memory_order_relaxed);
+            }
+            return frames.size();
+        }
+
+        size_t offset = first < frames.size() ? frames[first].begin : 0;
+        size_t end = frames.empty() ? 0 : frames.back().end;
+        while (offset < end)
+        {
+            int sent = ::send(m_Socket, buffer.data() + offset, static_cast<int>((std::min)(end - offset, MaxSendBytes)), 0);
+            if (sent == SOCKET_ERROR)
+            {
+                Disconnect();
+                m_NextConnectAttempt = ::GetTickCount64() + m_Backoff;
+                // A frame cut short on the broken connection is sent again in full.
+                return static_cast<size_t>(std::find_if(
+                    frames.begin() + first,
+                    frames.end(),
+                    [&](const Frame& frame) { return frame.end > offset; }) - frames.begin());
+            }
+            offset += sent;
+            m_BytesSent.fetch_add(sent, std::memory_order_relaxed);
+        }
+        return frames.size();
+    }
+
+    bool SyslogSink::ReplaySpill()
+    {
+        if (m_SpillFile == NULL ||
+            m_SpillReplayed >= m_SpillBytes)
+        {
+            return true;
+        }
+
+        fflush(m_SpillFile);
+        for (;;)
+        {
+            _fseeki64(m_SpillFile, static_cast<__int64>(m_SpillReplayed), SEEK_SET);
+            m_ReplayBuffer.resize(ReplayChunkBytes);
+            size_t read = fread(&m_ReplayBuffer[0], 1, m_ReplayBuffer.size(), m_SpillFile);
+            m_ReplayBuffer.resize(read);
+            if (read == 0)
+            {
+                break;
+            }
+
+            m_ReplayFrames.clear();
+            size_t covered = ParseFrames(m_ReplayBuffer, &m_ReplayFrames);
+            if (covered == 0)
+            {
+                wprintf(L"Warning: %ls is not a syslog spill file or is damaged; discarding its remaining %llu bytes.\n",
+                    m_SpillPath.c_str(),
+                    m_SpillBytes - m_SpillReplayed);
+                break;
+            }
+
+            size_t firstUnsent = SendFrames(m_ReplayBuffer, m_ReplayFrames, 0);
+            if (firstUnsent < m_ReplayFrames.size())
+            {
+                m_SpillReplayed += m_ReplayFrames[firstUnsent].begin;
+                return false;
+            }
+            m_SpillReplayed += covered;
+        }
+
+        // Everything was sent: start the next outage with an empty file.
+        fclose(m_SpillFile);
+        m_SpillFile = NULL;
+        _wremove(m_SpillPath.c_str());
+        m_SpillBytes = 0;
+        m_SpillReplayed = 0;
+        return true;
+    }
+
+    void SyslogSink::Spill(
+        const std::string& buffer,
+        const std::vector<Frame>& frames,
+        size_t first)
+    {
+        if (first >= frames.size())
+        {
+            return;
+        }
+
+        if (m_SpillFile == NULL)
+        {
+            OpenSpillFile();
+        }
+
+        // The limit is on the bytes not yet sent. Once the replayed part of the file would
+        // take it past the limit, the file is rewritten without it.
+        if (m_SpillFile != NULL &&
+            m_SpillReplayed > 0 &&
+            m_SpillBytes + (frames.back().end - frames[first].begin) > m_MaxSpillBytes)
+        {
+            CompactSpillFile();
+        }
+
+        // Whole frames only, oldest first, up to the limit; the rest are lost.
+        size_t spilled = 0;
+        if (m_SpillFile != NULL)
+        {
+            const unsigned long long unsent = m_SpillBytes - m_SpillReplayed;
+            size_t begin = frames[first].begin;
+            size_t end = begin;
+            for (size_t i = first; i < frames.size(); ++i)
+            {
+                if (unsent + (frames[i].end - begin) > m_MaxSpillBytes)
+                {
+                    break;
+                }
+                end = frames[i].end;
+                ++spilled;
+            }
+
+            if (spilled > 0)
+            {
+                fwrite(buffer.data() + begin, 1, end - begin, m_SpillFile);
+                fflush(m_SpillFile);
+                m_SpillBytes += end - begin;
+                m_EventsSpilled.fetch_add(spilled, std::memory_order_relaxed);
+            }
+        }
+
+        m_EventsLost.fetch_add(frames.size() - first - spilled, std::memory_order_relaxed);
+    }
+
+    void SyslogSink::CompactSpillFile()
+    {
+        // The frames not yet sent are copied to a new file, which then replaces the spill file.
+        std::wstring compactPath = m_SpillPath + L".compact";
+        FILE* compactFile = NULL;
+        if (_wfopen_s(&compactFile, compactPath.c_str(), L"wb") != 0 ||
+            compactFile == NULL)
+        {
+            return;
+        }
+
+        fflush(m_SpillFile);
+        _fseeki64(m_SpillFile, static_cast<__int64>(m_SpillReplayed), SEEK_SET);
+        bool copied = true;
+        m_ReplayBuffer.resize(ReplayChunkBytes);
+        size_t read = 0;
+        while ((read = fread(&m_ReplayBuffer[0], 1, m_ReplayBuffer.size(), m_SpillFile)) > 0)
+        {
+            if (fwrite(m_ReplayBuffer.data(), 1, read, compactFile) != read)
+            {
+                copied = false;
+                break;
+            }
+        }
+        if (fclose(compactFile) != 0)
+        {
+            copied = false;
+        }
+
+        fclose(m_SpillFile);
+        m_SpillFile = NULL;
+        if (copied &&
+            ::MoveFileExW(compactPath.c_str(), m_SpillPath.c_str(), MOVEFILE_REPLACE_EXISTING))
+        {
+            m_SpillReplayed = 0;
+        }
+        else
+        {
+            // Keep appending to the file as it is.
+            _wremove(compactPath.c_str());
+        }
+        OpenSpillFile();
+    }
+
+    void SyslogSink::OpenSpillFile()
+    {
+        if (m_SpillFileFailed)
+        {
+            return;
+        }
+
+        // Appends always go to the end; reads seek to what has not been replayed.
+        if (_wfopen_s(&m_SpillFile, m_SpillPath.c_str(), L"a+b") != 0 ||
+            m_SpillFile == NULL)
+        {
+            m_SpillFile = NULL;
+            m_SpillFileFailed = true;
+            wprintf(L"Warning: Unable to open syslog spill file %ls; events are lost while the collector is unreachable.\n",
+                m_SpillPath.c_str());
+            return;
+        }
+
+        _fseeki64(m_SpillFile, 0, SEEK_END);
+        m_SpillBytes = static_cast<unsigned long long>(_ftelli64(m_SpillFile));
+    }
+
+    size_t SyslogSink::ParseFrames(
+        const std::string& buffer,
+        std::vector<Frame>* frames)
+    {
+        size_t offset = 0;
+        while (offset < buffer.size())
+        {
+            size_t length = 0;
+            size_t cursor = offset;
+            while (cursor < buffer.size() &&
+                buffer[cursor] >= '0' &&
+                buffer[cursor] <= '9')
+            {
+                length = length * 10 + (buffer[cursor] - '0');
+                ++cursor;
+            }
+
+            if (cursor >= buffer.size() ||
+                cursor == offset ||
+                buffer[cursor] != ' ' ||
+                buffer.size() - (cursor + 1) < length)
+            {
+                // Malformed, or cut off at the end of the buffer.
+                break;
+            }
+
+            Frame frame;
+            frame.begin = offset;
+            frame.message = cursor + 1;
+            frame.end = frame.message + length;
+            frames->push_back(frame);
+            offset = frame.end;
+        }
+        return offset;
+    }
+}
@@ -0,0 +1,150 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#pragma once
+
+// os headers
+#include <winsock2.h>
+#include <Windows.h>
+// c++ headers
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "EventSink.h"
+#include "CompactEventRecord.h"
+
+namespace FirewallEventMonitor
+{
+    enum class SyslogTransport { Udp, Tcp };
+
+    // Forwards events to a syslog collector as RFC 5424 messages (-Syslog).
+    // Each batch from the queue is framed into one reused buffer: over TCP the frames are
+    // octet counted (RFC 6587) and sent with as few send() calls as the buffer allows; over
+    // UDP each message is its own datagram (RFC 5426), sent back to back from the same buffer.
+    // While the collector cannot be reached, batches are appended to a spill file of bounded
+    // size and sent, oldest first, once it can; connection attempts back off exponentially.
+    // The spill file outlives the process, so a restarted monitor sends what it left behind.
+    class SyslogSink : public QueuedEventSink
+    {
+    public:
+        SyslogSink(
+            const std::wstring& host,
+            unsigned short port,
+            SyslogTransport transport,
+            const std::wstring& spillPath,
+            unsigned long long maxSpillBytes = DefaultMaxSpillBytes,
+            size_t maxQueuedEvents = DefaultMaxQueuedEvents);
+
+        // Stops the worker; events that could not be sent stay in the spill file.
+        ~SyslogSink() override;
+
+        LPCWSTR GetName() const override;
+
+        EventFormat GetFormat() const override;
+
+        // Stop() also ends here.
+        void StopBy(ULONGLONG deadline) override;
+
+        // Events dropped from the queue, plus events lost because the spill file was full.
+        unsigned long long GetEventsDropped() const override;
+
+        unsigned long long GetBytesSent() const;
+
+        // Events written to the spill file since the sink was created.
+        unsigned long long GetEventsSpilled() const;
+
+        unsigned long long GetConnectFailures() const;
+
+        // Bytes waiting in the spill file.
+        unsigned long long GetSpillBytes() const;
+
+        // Appends one octet-counted frame ("<length> <message>") holding text as UTF-8.
+        // Over UDP only the message is sent; the length is kept for the spill file.
+        static void AppendFrame(const std::wstring& text, _Inout_ std::string* buffer);
+
+        // Constants
+        static const unsigned short DefaultPort = 514;
+        static const unsigned long long DefaultMaxSpillBytes = 64ull * 1024 * 1024; // 64 MB.
+        static const size_t MaxUdpMessageBytes = 2048; // Longer messages are truncated (RFC 5426), at a UTF-8 character boundary.
+        static const size_t MaxSendBytes = 64 * 1024; // Largest single TCP send().
+        static const DWORD InitialBackoffInMilliseconds = 1000;
+        static const DWORD MaxBackoffInMilliseconds = 60000;
+        static const DWORD ConnectTimeoutInMilliseconds = 2000;
+        static const DWORD SendTimeoutInMilliseconds = 5000;
+        static const size_t ReplayChunkBytes = 256 * 1024;
+
+        SyslogSink(SyslogSink const&) = delete;
+        SyslogSink& operator=(SyslogSink const&) = delete;
+    protected:
+        void WriteBatch(const std::vector<EncodedEvent>& events) override;
+
+    private:
+        // Offsets of one frame within a buffer: its length prefix, its message, and its end.
+        struct Frame
+        {
+            size_t begin;
+            size_t message;
+            size_t end;
+        };
+
+        const std::wstring m_Host;
+        const unsigned short m_Port;
+        const SyslogTransport m_Transport;
+        const std::wstring m_SpillPath;
+        const unsigned long long m_MaxSpillBytes;
+
+        // Only touched by the worker thread (or by Stop() once it has finished).
+        SOCKET m_Socket = INVALID_SOCKET;
+        ULONGLONG m_NextConnectAttempt = 0;
+        DWORD m_Backoff = InitialBackoffInMilliseconds;
+        std::string m_SendBuffer; // Reused for every batch.
+        std::vector<Frame> m_Frames;
+        std::string m_ReplayBuffer;
+        std::vector<Frame> m_ReplayFrames;
+        FILE* m_SpillFile = NULL;
+        bool m_SpillFileFailed = false; // Set once the spill file cannot be opened, to warn only once.
+        unsigned long long m_SpillReplayed = 0; // Bytes of the spill file already sent.
+
+        std::atomic<unsigned long long> m_SpillBytes{ 0 };
+        std::atomic<unsigned long long> m_BytesSent{ 0 };
+        std::atomic<unsigned long long> m_EventsSpilled{ 0 };
+        std::atomic<unsigned long long> m_EventsLost{ 0 };
+        std::atomic<unsigned long long> m_ConnectFailures{ 0 };
+
+        // Returns true if the socket is connected, trying to connect if the backoff allows.
+        bool EnsureConnected();
+
+        bool Connect();
+
+        void Disconnect();
+
+        bool ConnectWithTimeout(SOCKET connection, _In_reads_bytes_(length) const SOCKADDR* address, int length) const;
+
+        // Sends frames[first, end) of buffer. Returns the index of the first frame not fully sent.
+        size_t SendFrames(
+            const std::string& buffer,
+            const std::vector<Frame>& frames,
+            size_t first);
+
+        // Sends what is in the spill file, oldest first. Returns false if it could not all be sent.
+        bool ReplaySpill();
+
+        // Appends frames[first, end) of buffer to the spill file, as far as its limit on unsent bytes allows.
+        void Spill(
+            const std::string& buffer,
+            const std::vector<Frame>& frames,
+            size_t first);
+
+        // Rewrites the spill file without the frames already replayed from it.
+        void CompactSpillFile();
+
+        void OpenSpillFile();
+
+        // Splits buffer into complete frames; returns the number of bytes they cover.
+        static size_t ParseFrames(
+            const std::string& buffer,
+            _Inout_ std::vector<Frame>* frames);
+    };
+}
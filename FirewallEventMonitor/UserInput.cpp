@@ -1,372 +1,1123 @@
-// Copyright (c) Microsoft Corporation. All rights reserved.
-// Licensed under the MIT License. See License.txt in the project root for license information.
-
-#include "UserInput.h"
-
-// CLSIDFromString
-#include "Objbase.h"
-
-using namespace FirewallEventMonitor;
-
-void UserInput::PrintUsage() const
-{
-    wprintf(
-        L"FirewallEventMonitor.exe \n"
-        "  -TimeLimit <seconds> : Stop after running for the specified time. Default: %d seconds. \n"
-        "  -NoTimeout : Run until forcibly  stopped.\n"
-        "  -EventThrottle <count> : Throttle events captured per second. Default: %d. \n"
-        "  -Output <output1,output2,...> : Comma-delimited list of desired output.\n"
-        "    Console : Print to console.\n"
-        "    File : Write to file on disk.\n"
-        "  -Directory <path> : Location of log file (if -Output generates one). Default: current directory.\n"
-        "  -IP <address1,address2,...> : Fitler for the comma-delimited list of addresses.\n"
-        "    Note: Events without the specified IP address(es) in either source or destination are ignored.\n"
-        "  -Rule <guid1,guid2,...> : Fitler for the comma-delimited list of Rule Ids.\n"
-        "    Note: Events without the specified Rule Ids are ignored. \n"
-        "    Note: Must be valid Guids. XXXXXXXX-XXXX-XXXX-XXXX-XXXXXXXXXXXX or \"{XXXXXXXX-XXXX-XXXX-XXXX-XXXXXXXXXXXX}\" \n"
-        "\n",
-        Parameters::DefaultTimeLimitInSeconds,
-        Parameters::DefaultEventCountMaxPerSecond);
-}
-
-ArgumentParsingResults UserInput::ParseArguments(
-    const int argc,
-    _In_reads_(argc) const wchar_t** argv
-)
-try
-{
-    bool success = true;
-
-    // ignore the first argv (the exe itself)
-    const wchar_t** arg_begin = argv + 1;
-    const wchar_t** arg_end = argv + argc;
-    std::vector<const wchar_t*> args(arg_begin, arg_end);
-
-    // if '-help' was parsed, exit
-    if (ParseHelp(args))
-    {
-        return ArgumentParsingResults::Help;
-    }
-
-    if (!ParseEventThrottle(args))
-    {
-        success = false;
-    }
-
-    if (!ParseTimeLimit(args))
-    {
-        success = false;
-    }
-
-    if (!ParseNoTimeout(args))
-    {
-        success = false;
-    }
-
-    if (!ParseOutput(args))
-    {
-        success = false;
-    }
-
-    if (!ParseDirectory(args))
-    {
-        success = false;
-    }
-
-    if (!ParseIpAddressFilters(args))
-    {
-        success = false;
-    }
-
-    if (!ParseRuleIdFilters(args))
-    {
-        success = false;
-    }
-
-    if (!success)
-    {
-        wprintf(L"Parsing arguments failed.\n");
-        PrintUsage();
-        return ArgumentParsingResults::Fail;
-    }
-
-    return  ArgumentParsingResults::Success;
-}
-catch (const std::exception &ex)
-{
-    wprintf(L"Attempting to parse arguments raised exception: %S.\n", ex.what());
-    return ArgumentParsingResults::Fail;
-}
-
-bool UserInput::ParseHelp(
-    const std::vector<const wchar_t*>& _args)
-{
-    // Example: -Help, -?
-    bool helpFound = ArgumentProcessing::FindParameter(_args, L"-Help");
-    bool questionmarkFound = ArgumentProcessing::FindParameter(_args, L"-?");
-    if (helpFound ||
-        questionmarkFound)
-    {
-        PrintUsage();
-        return true;
-    }
-    return false;
-}
-
-bool UserInput::ParseEventThrottle(
-    const std::vector<const wchar_t*>& _args)
-{
-    // Example: -MaxEvents 5
-    std::wstring numEvents;
-    bool foundEvents = ArgumentProcessing::FindParameter(_args, L"-EventThrottle", true, &numEvents);
-    if (!foundEvents)
-    {
-        return true;
-    }
-
-    m_Parameters.maxEventsPerEpoc = std::stoul(numEvents);
-    wprintf(L"\tEventThrottle: limiting collection to %d events per second.\n", m_Parameters.maxEventsPerEpoc);
-
-    return true;
-}
-
-bool UserInput::ParseTimeLimit(
-    const std::vector<const wchar_t*>& _args)
-{
-    // Example: -TimeLimit 60
-    std::wstring seconds;
-    bool foundTimeLimit = ArgumentProcessing::FindParameter(_args, L"-TimeLimit", true, &seconds);
-    if (!foundTimeLimit)
-    {
-        return true;
-    }
-
-    m_Parameters.maxRuntimeInSeconds = std::stoul(seconds);
-    wprintf(L"\tTimeLimit: limiting runtime to %d seconds.\n", m_Parameters.maxRuntimeInSeconds);
-
-    return true;
-}
-
-bool UserInput::ParseNoTimeout(
-    const std::vector<const wchar_t*>& _args)
-{
-    // Example: -NoTimeout
-    bool noTimeoutFound = ArgumentProcessing::FindParameter(_args, L"-NoTimeout");
-    if (noTimeoutFound)
-    {
-        m_Parameters.noTimeout = true;
-        wprintf(L"\tNoTimeout: program will run until forcibly stopped.\n");
-    }
-    return true;
-}
-
-bool UserInput::ParseOutput(
-    const std::vector<const wchar_t*>& _args)
-{
-    // Example: -Output Console
-    // Example: -Output Console,File
-    std::wstring outputs;
-    bool foundOutput = ArgumentProcessing::FindParameter(_args, L"-Output", true, &outputs);
-    if (!foundOutput)
-    {
-        return true;
-    }
-
-    // Undo console default if Output is specified.
-    m_Parameters.outputToConsole = false;
-
-    ValidationFunction func = [&](const std::wstring& input)->bool 
-    { return ValidateOutputType(input); };
-
-    bool valid = ValidateCommaDelimitedInput(
-        outputs,
-        func);
-
-    return valid;
-}
-
-bool UserInput::ParseDirectory(
-    const std::vector<const wchar_t*>& _args)
-{
-    // Example: -Directory C:\temp
-    std::wstring directory;
-    bool foundDirecotry = ArgumentProcessing::FindParameter(_args, L"-Directory", true, &directory);
-    if (!foundDirecotry)
-    {
-        return true;
-    }
-
-    // No validation at the moment.
-    m_Parameters.logDirectory.assign(directory);
-    return true;
-}
-
-bool UserInput::ParseIpAddressFilters(
-    const std::vector<const wchar_t*>& _args)
-{
-    // Example: -IP <addr>
-    // Example: -IP <addr>,<addr2> ...
-    std::wstring addresses;
-    bool foundIp = ArgumentProcessing::FindParameter(_args, L"-IP", true, &addresses);
-    if (!foundIp)
-    {
-        return true;
-    }
-
-    ValidationFunction func = [&](const std::wstring& input)->bool
-    { return ValidateIpAddress(input); };
-
-    bool valid = ValidateCommaDelimitedInput(
-        addresses,
-        func);
-
-    if (!valid)
-    {
-        return false;
-    }
-
-    wprintf(L"\tIP: filtering by the following IP addresses [");
-    for (const auto& ip : m_Parameters.ipAddressFilters)
-    {
-        wprintf(L"%ls ", ip.c_str());
-    }
-    wprintf(L"]\n");
-    return true;
-}
-
-bool UserInput::ParseRuleIdFilters(
-    const std::vector<const wchar_t*>& _args)
-{
-    // Example: -Rule <id>
-    // Example: -Rule <id>,<id2> ...
-    std::wstring rules;
-    bool foundRule = ArgumentProcessing::FindParameter(_args, L"-Rule", true, &rules);
-    if (!foundRule)
-    {
-        return true;
-    }
-
-    ValidationFunction func = [&](const std::wstring& input)->bool
-    { return ValidateRuleId(input); };
-
-    bool valid = ValidateCommaDelimitedInput(
-        rules,
-        func);
-
-    if (!valid)
-    {
-        return false;
-    }
-
-    wprintf(L"\tRule: filtering by the following Rule Ids [");
-    for (const auto& ruleFilter : m_Parameters.ruleIdFilters)
-    {
-        wprintf(L"%ls ", ruleFilter.c_str());
-    }
-    wprintf(L"]\n");
-    return true;
-}
-
-bool UserInput::ValidateOutputType(
-    const std::wstring& value)
-{
-    if (ntl::String::iordinal_equals(value, L"Console"))
-    {
-        wprintf(L"\tOutput: printing to Console.\n");
-        m_Parameters.outputToConsole = true;
-    }
-    else if (ntl::String::iordinal_equals(value, L"File"))
-    {
-        wprintf(L"\tOutput: writing to File.\n");
-        m_Parameters.outputToFile = true;
-    }
-    else
-    {
-        wprintf(L"Unrecognized output type specified: %ls.\n", value.c_str());
-        return false;
-    }
-    return true;
-}
-
-bool UserInput::ValidateIpAddress(
-    const std::wstring& ipAddress)
-{
-    // No validation at the moment.
-    m_Parameters.ipAddressFilters.push_back(ipAddress);
-    return true;
-}
-
-bool UserInput::ValidateRuleId(
-    const std::wstring& rule)
-{
-    // Test for Guid in the form: {XXXXXXXX-XXXX-XXXX-XXXX-XXXXXXXXXXXX}
-    GUID guid;
-    HRESULT hr = CLSIDFromString(rule.c_str(), &guid);
-    if (SUCCEEDED(hr))
-    {
-        std::wstring trimmed = rule;
-        // Trim '{'
-        trimmed.erase(trimmed.begin());
-        // Trim '}'
-        trimmed.pop_back();
-        m_Parameters.ruleIdFilters.push_back(trimmed);
-        return true;
-    }
-
-    // Test for Guid in the form: XXXXXXXX-XXXX-XXXX-XXXX-XXXXXXXXXXXX
-    std::wstring ruleWithBraces = L"{" + rule + L"}";
-    hr = CLSIDFromString(ruleWithBraces.c_str(), &guid);
-    if (SUCCEEDED(hr))
-    {
-        m_Parameters.ruleIdFilters.push_back(rule);
-        return true;
-    }
-
-    wprintf(L"Invalid Guid for RuleId: %ls.\n", rule.c_str());
-    return false;
-}
-
-bool UserInput::ValidateCommaDelimitedInput(
-    const std::wstring& input,
-    _In_ ValidationFunction matchFunction)
-{
-    auto commas = ntl::String::all_indices_of(
-        input.begin(), input.end(),
-        [](wchar_t _ch) -> bool { return _ch == L','; });
-
-    // Only one input was specified
-    if (commas.size() == 0)
-    {
-        return matchFunction(input);
-    }
-
-    // Multiple comma-delimited inputs were specified
-    bool success = true;
-    std::wstring::const_iterator beginningOfWord = std::cbegin(input);
-    for (const auto& comma : commas)
-    {
-        std::wstring inputElement(beginningOfWord, comma);
-        auto result = matchFunction(inputElement);
-
-        if (!result)
-        {
-            success = false;
-        }
-
-        // move beginningOfWord to the first character of the next word
-        beginningOfWord = comma;
-        ++beginningOfWord;
-    }
-
-    // beginningOfWord now points to the first character of the very last word
-    std::wstring::const_iterator endOfWord = std::end(input);
-    std::wstring lastInput(beginningOfWord, endOfWord);
-    auto result = matchFunction(lastInput);
-
-    if (!result)
-    {
-        success = false;
-    }
-
-    return success;
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#include "UserInput.h"
+
+// ntl headers
+#include "ntlUuid.hpp"
+
+#include "FlowSampler.h"
+
+using namespace FirewallEventMonitor;
+
+void UserInput::PrintUsage() const
+{
+    wprintf(
+        L"FirewallEventMonitor.exe \n"
+        "  -TimeLimit <seconds> : Stop after running for the specified time. Default: %d seconds. \n"
+        "  -NoTimeout : Run until forcibly  stopped.\n"
+        "  -DrainTimeout <milliseconds> : Time allowed at shutdown to write the events in flight. Default: %d milliseconds. \n"
+        "  -EventThrottle <count> : Throttle events captured per second. Default: %d. \n"
+        "  -Output <output1,output2,...> : Comma-delimited list of desired output.\n"
+        "    Console : Print to console.\n"
+        "    File : Write to file on disk.\n"
+        "    Dashboard : Full-screen view of event rates, top talkers and drops, refreshed every second. Not with Console.\n"
+        "  -Directory <path> : Location of log file (if -Output generates one). Default: current directory.\n"
+        "  -LogFormat <Text|Json> : Layout of the log file. Json writes one object per line. Default: Text.\n"
+        "  -Durable : Sync the log file to disk in groups, each checked by a commit record, so a crash loses at most the last group.\n"
+        "  -DurableInterval <milliseconds> : Longest a write waits to be synced. Implies -Durable. Default: %d ms.\n"
+        "  -DurableBytes <bytes> : Sync once a group holds this many bytes. Implies -Durable. Default: %d bytes.\n"
+        "  -Mapped : Write the log file through preallocated, memory mapped segments. Not with -Durable.\n"
+        "  -SegmentSize <megabytes> : Size the log file grows by at a time. Implies -Mapped. Default: %d MB.\n"
+        "  -Overlapped : Write the log file with overlapped I/O from a pool of %d buffers, completed on the thread pool. Not with -Durable or -Mapped.\n"
+        "  -OverlappedBufferSize <kilobytes> : Size of each buffer, and of each write. Implies -Overlapped. Default: %d KB.\n"
+        "  -Syslog <host> : Forward events to a syslog collector as RFC 5424 messages.\n"
+        "  -SyslogPort <port> : Collector port. Default: %d.\n"
+        "  -SyslogProtocol <Udp|Tcp> : Default: Udp. Over Tcp, messages the collector cannot take are kept on disk and sent later.\n"
+        "  -Archive <path> : Also write every event to a columnar archive for analytics tools. Replaces an existing file.\n"
+        "  -Sketch <directory> : Write a sketch of each interval's events (busiest keys, distinct counts, lag) to a new file in the directory.\n"
+        "    Note: Sketches of any hosts and intervals merge with -MergeSketches. Files are named <host>.<start time>.sketch.\n"
+        "  -SketchInterval <seconds> : Interval each sketch covers. Requires -Sketch. Default: %d seconds.\n"
+        "  -Schema <path> : Also watch the providers and events described in the file, decoded into the same fields as VFP events.\n"
+        "    Note: One event per line: <provider guid> <event id> <version|*> <name> <property>=<field>[,...]\n"
+        "  -IP <address1,address2,...> : Fitler for the comma-delimited list of addresses.\n"
+        "    Note: Events without the specified IP address(es) in either source or destination are ignored.\n"
+        "  -Rule <guid1,guid2,...> : Fitler for the comma-delimited list of Rule Ids.\n"
+        "    Note: Events without the specified Rule Ids are ignored. \n"
+        "    Note: Must be valid Guids. XXXXXXXX-XXXX-XXXX-XXXX-XXXXXXXXXXXX or \"{XXXXXXXX-XXXX-XXXX-XXXX-XXXXXXXXXXXX}\" \n"
+        "  -StatsInterval <seconds> : Print event rate and monitor resource usage on an interval. 0 disables. Default: %d seconds.\n"
+        "  -Anomaly : Alert when a rule's hits per second depart from its baseline.\n"
+        "  -AnomalyZScore <value> : Standard deviations above the baseline that raise an alert. Implies -Anomaly. Default: %.1f.\n"
+        "  -AnomalyRatio <value> : Multiple of the baseline rate that raises an alert. Implies -Anomaly. Default: %.1f.\n"
+        "  -PairFlows : Report flows allowed in one direction and denied in the other.\n"
+        "  -PairWindow <seconds> : Time allowed between a flow's events in each direction. Implies -PairFlows. Default: %d seconds.\n"
+        "  -RuleUsage : Count hits per rule. Printed with the statistics and when the session closes.\n"
+        "  -RuleCatalog <path> : File listing every configured rule id, one per line, to report rules never hit. Implies -RuleUsage.\n"
+        "  -RuleUsageExport <path> : Write the full rule usage report to a file, as JSON if it ends in .json, otherwise CSV. Implies -RuleUsage.\n"
+        "  -SampleRate 1/<N> : Keep every event of 1 in N flows, chosen by a hash of the addresses, ports and protocol.\n"
+        "    Note: Every host makes the same choice for a flow. Logged flows show their sampleRate.\n"
+        "  -Adaptive : Raise the sample rate (starting from -SampleRate) while the monitor is over its lag or CPU budget.\n"
+        "  -LagBudget <milliseconds> : Largest event delivery lag allowed. Implies -Adaptive. Default: %d ms.\n"
+        "  -CpuBudget <percent> : Largest share of all processors allowed. Implies -Adaptive. Default: %.1f%%.\n"
+        "  -ShedPriority <class:percent,...> : When -EventThrottle is reached, drop low priority events first.\n"
+        "    Note: Classes Deny, Icmp, TcpSyn and Allow, highest priority first; each keeps percent of the throttle. \"Default\" is Deny:25,Icmp:10,TcpSyn:15,Allow:0\n"
+        "  -Diff <before>,<after> : Compare two captures instead of starting a session, then exit.\n"
+        "    Note: .etl files are read as saved ETW sessions; other files as logs written by -Output File.\n"
+        "  -MergeSketches <path> : Merge sketches written by -Sketch into fleet-wide reports instead of starting a session, then exit.\n"
+        "    Note: A sketch file, a directory of them, or a pattern such as C:\\sketches\\web*.sketch. Files are merged in parallel.\n"
+        "  -MergeOutput <path> : Also write the merged sketch, which merges like any other. Requires -MergeSketches.\n"
+        "\n",
+        Parameters::DefaultTimeLimitInSeconds,
+        Parameters::DefaultDrainTimeoutInMilliseconds,
+        Parameters::DefaultEventCountMaxPerSecond,
+        FileLogger::DefaultCommitIntervalInMilliseconds,
+        static_cast<int>(FileLogger::DefaultCommitBytes),
+        static_cast<int>(MappedLogFile::DefaultSegmentBytes / (1024 * 1024)),
+        static_cast<int>(OverlappedLogFile::DefaultBufferCount),
+        static_cast<int>(OverlappedLogFile::DefaultBufferBytes / 1024),
+        Parameters::DefaultSyslogPort,
+        Parameters::DefaultSketchIntervalInSeconds,
+        Parameters::DefaultStatisticsIntervalInSeconds,
+        Parameters::DefaultAnomalyZScoreThreshold,
+        Parameters::DefaultAnomalyRatioThreshold,
+        Parameters::DefaultFlowPairingWindowInSeconds,
+        Parameters::DefaultLagBudgetInMilliseconds,
+        Parameters::DefaultCpuBudgetPercent);
+}
+
+ArgumentParsingResults UserInput::ParseArguments(
+    const int argc,
+    _In_reads_(argc) const wchar_t** argv
+)
+try
+{
+    bool success = true;
+
+    // ignore the first argv (the exe itself)
+    const wchar_t** arg_begin = argv + 1;
+    const wchar_t** arg_end = argv + argc;
+    std::vector<const wchar_t*> args(arg_begin, arg_end);
+
+    // if '-help' was parsed, exit
+    if (ParseHelp(args))
+    {
+        return ArgumentParsingResults::Help;
+    }
+
+    if (!ParseEventThrottle(args))
+    {
+        success = false;
+    }
+
+    if (!ParseTimeLimit(args))
+    {
+        success = false;
+    }
+
+    if (!ParseNoTimeout(args))
+    {
+        success = false;
+    }
+
+    if (!ParseDrainTimeout(args))
+    {
+        success = false;
+    }
+
+    if (!ParseOutput(args))
+    {
+        success = false;
+    }
+
+    if (!ParseDirectory(args))
+    {
+        success = false;
+    }
+
+    if (!ParseLogFormat(args))
+    {
+        success = false;
+    }
+
+    if (!ParseDurable(args))
+    {
+        success = false;
+    }
+
+    if (!ParseMapped(args))
+    {
+        success = false;
+    }
+
+    if (!ParseOverlapped(args))
+    {
+        success = false;
+    }
+
+    if (!ParseSyslog(args))
+    {
+        success = false;
+    }
+
+    if (!ParseArchive(args))
+    {
+        success = false;
+    }
+
+    if (!ParseSketch(args))
+    {
+        success = false;
+    }
+
+    if (!ParseSchema(args))
+    {
+        success = false;
+    }
+
+    if (!ParseIpAddressFilters(args))
+    {
+        success = false;
+    }
+
+    if (!ParseRuleIdFilters(args))
+    {
+        success = false;
+    }
+
+    if (!ParseStatisticsInterval(args))
+    {
+        success = false;
+    }
+
+    if (!ParseAnomalyDetection(args))
+    {
+        success = false;
+    }
+
+    if (!ParseFlowPairing(args))
+    {
+        success = false;
+    }
+
+    if (!ParseRuleUsage(args))
+    {
+        success = false;
+    }
+
+    if (!ParseSampleRate(args))
+    {
+        success = false;
+    }
+
+    if (!ParseAdaptiveSampling(args))
+    {
+        success = false;
+    }
+
+    if (!ParseShedPriority(args))
+    {
+        success = false;
+    }
+
+    if (!ParseDiff(args))
+    {
+        success = false;
+    }
+
+    if (!ParseMergeSketches(args))
+    {
+        success = false;
+    }
+
+    if (!success)
+    {
+        wprintf(L"Parsing arguments failed.\n");
+        PrintUsage();
+        return ArgumentParsingResults::Fail;
+    }
+
+    return  ArgumentParsingResults::Success;
+}
+catch (const std::exception &ex)
+{
+    wprintf(L"Attempting to parse arguments raised exception: %S.\n", ex.what());
+    return ArgumentParsingResults::Fail;
+}
+
+bool UserInput::ParseHelp(
+    const std::vector<const wchar_t*>& _args)
+{
+    // Example: -Help, -?
+    bool helpFound = ArgumentProcessing::FindParameter(_args, L"-Help");
+    bool questionmarkFound = ArgumentProcessing::FindParameter(_args, L"-?");
+    if (helpFound ||
+        questionmarkFound)
+    {
+        PrintUsage();
+        return true;
+    }
+    return false;
+}
+
+bool UserInput::ParseEventThrottle(
+    const std::vector<const wchar_t*>& _args)
+{
+    // Example: -MaxEvents 5
+    std::wstring numEvents;
+    bool foundEvents = ArgumentProcessing::FindParameter(_args, L"-EventThrottle", true, &numEvents);
+    if (!foundEvents)
+    {
+        return true;
+    }
+
+    m_Parameters.maxEventsPerEpoc = std::stoul(numEvents);
+    wprintf(L"\tEventThrottle: limiting collection to %d events per second.\n", m_Parameters.maxEventsPerEpoc);
+
+    return true;
+}
+
+bool UserInput::ParseTimeLimit(
+    const std::vector<const wchar_t*>& _args)
+{
+    // Example: -TimeLimit 60
+    std::wstring seconds;
+    bool foundTimeLimit = ArgumentProcessing::FindParameter(_args, L"-TimeLimit", true, &seconds);
+    if (!foundTimeLimit)
+    {
+        return true;
+    }
+
+    m_Parameters.maxRuntimeInSeconds = std::stoul(seconds);
+    wprintf(L"\tTimeLimit: limiting runtime to %d seconds.\n", m_Parameters.maxRuntimeInSeconds);
+
+    return true;
+}
+
+bool UserInput::ParseNoTimeout(
+    const std::vector<const wchar_t*>& _args)
+{
+    // Example: -NoTimeout
+    bool noTimeoutFound = ArgumentProcessing::FindParameter(_args, L"-NoTimeout");
+    if (noTimeoutFound)
+    {
+        m_Parameters.noTimeout = true;
+        wprintf(L"\tNoTimeout: program will run until forcibly stopped.\n");
+    }
+    return true;
+}
+
+bool UserInput::ParseDrainTimeout(
+    const std::vector<const wchar_t*>& _args)
+{
+    // Example: -DrainTimeout 10000
+    std::wstring milliseconds;
+    bool foundDrainTimeout = ArgumentProcessing::FindParameter(_args, L"-DrainTimeout", true, &milliseconds);
+    if (!foundDrainTimeout)
+    {
+        return true;
+    }
+
+    m_Parameters.drainTimeoutInMilliseconds = std::stoul(milliseconds);
+    wprintf(L"\tDrainTimeout: allowing %d milliseconds at shutdown to write the events in flight.\n", m_Parameters.drainTimeoutInMilliseconds);
+
+    return true;
+}
+
+bool UserInput::ParseOutput(
+    const std::vector<const wchar_t*>& _args)
+{
+    // Example: -Output Console
+    // Example: -Output Console,File
+    // Example: -Output Dashboard,File
+    std::wstring outputs;
+    bool foundOutput = ArgumentProcessing::FindParameter(_args, L"-Output", true, &outputs);
+    if (!foundOutput)
+    {
+        return true;
+    }
+
+    // Undo console default if Output is specified.
+    m_Parameters.outputToConsole = false;
+
+    ValidationFunction func = [&](const std::wstring& input)->bool 
+    { return ValidateOutputType(input); };
+
+    bool valid = ValidateCommaDelimitedInput(
+        outputs,
+        func);
+
+    // Both draw on the console; scrolling events would tear the dashboard.
+    if (valid &&
+        m_Parameters.outputToConsole &&
+        m_Parameters.outputToDashboard)
+    {
+        wprintf(L"Output Console cannot be combined with Dashboard.\n");
+        return false;
+    }
+
+    return valid;
+}
+
+bool UserInput::ParseDirectory(
+    const std::vector<const wchar_t*>& _args)
+{
+    // Example: -Directory C:\temp
+    std::wstring directory;
+    bool foundDirecotry = ArgumentProcessing::FindParameter(_args, L"-Directory", true, &directory);
+    if (!foundDirecotry)
+    {
+        return true;
+    }
+
+    // No validation at the moment.
+    m_Parameters.logDirectory.assign(directory);
+    return true;
+}
+
+bool UserInput::ParseLogFormat(
+    const std::vector<const wchar_t*>& _args)
+{
+    // Example: -LogFormat Json
+    std::wstring format;
+    bool foundFormat = ArgumentProcessing::FindParameter(_args, L"-LogFormat", true, &format);
+    if (!foundFormat)
+    {
+        return true;
+    }
+
+    if (ntl::String::iordinal_equals(format, L"Text"))
+    {
+        m_Parameters.logFormat = EventFormat::Text;
+    }
+    else if (ntl::String::iordinal_equals(format, L"Json"))
+    {
+        m_Parameters.logFormat = EventFormat::Json;
+    }
+    else
+    {
+        wprintf(L"Error: -LogFormat expects Text or Json, got %ls.\n", format.c_str());
+        return false;
+    }
+
+    wprintf(L"\tLogFormat: writing the log file as %ls.\n", format.c_str());
+    return true;
+}
+
+bool UserInput::ParseDurable(
+    const std::vector<const wchar_t*>& _args)
+{
+    // Example: -Durable
+    // Example: -DurableInterval 50 -DurableBytes 262144
+    if (ArgumentProcessing::FindParameter(_args, L"-Durable"))
+    {
+        m_Parameters.durableLog = true;
+    }
+
+    std::wstring interval;
+    if (ArgumentProcessing::FindParameter(_args, L"-DurableInterval", true, &interval))
+    {
+        m_Parameters.durableLog = true;
+        m_Parameters.durableIntervalInMilliseconds = std::stoul(interval);
+    }
+
+    std::wstring bytes;
+    if (ArgumentProcessing::FindParameter(_args, L"-DurableBytes", true, &bytes))
+    {
+        m_Parameters.durableLog = true;
+        m_Parameters.durableBytes = static_cast<size_t>(std::stoull(bytes));
+        if (m_Parameters.durableBytes == 0)
+        {
+            wprintf(L"Error: -DurableBytes must be above 0.\n");
+            return false;
+        }
+    }
+
+    if (!m_Parameters.durableLog)
+    {
+        return true;
+    }
+
+    if (!m_Parameters.outputToFile)
+    {
+        wprintf(L"Error: -Durable needs -Output File.\n");
+        return false;
+    }
+
+    wprintf(L"\tDurable: syncing the log file to disk every %lu ms or %zu bytes.\n",
+        m_Parameters.durableIntervalInMilliseconds,
+        m_Parameters.durableBytes);
+    return true;
+}
+
+bool UserInput::ParseMapped(
+    const std::vector<const wchar_t*>& _args)
+{
+    // Example: -Mapped
+    // Example: -SegmentSize 256
+    if (ArgumentProcessing::FindParameter(_args, L"-Mapped"))
+    {
+        m_Parameters.mappedLog = true;
+    }
+
+    std::wstring segmentSize;
+    if (ArgumentProcessing::FindParameter(_args, L"-SegmentSize", true, &segmentSize))
+    {
+        m_Parameters.mappedLog = true;
+        unsigned long megabytes = std::stoul(segmentSize);
+        if (megabytes == 0 ||
+            megabytes > Parameters::MaxSegmentSizeInMegabytes)
+        {
+            wprintf(L"Error: -SegmentSize must be from 1 to %lu MB.\n", Parameters::MaxSegmentSizeInMegabytes);
+            return false;
+        }
+        m_Parameters.segmentBytes = static_cast<size_t>(megabytes) * 1024 * 1024;
+    }
+
+    if (!m_Parameters.mappedLog)
+    {
+        return true;
+    }
+
+    if (!m_Parameters.outputToFile)
+    {
+        wprintf(L"Error: -Mapped needs -Output File.\n");
+        return false;
+    }
+
+    if (m_Parameters.durableLog)
+    {
+        wprintf(L"Error: -Mapped cannot be combined with -Durable.\n");
+        return false;
+    }
+
+    wprintf(L"\tMapped: growing the log file %zu MB at a time.\n",
+        m_Parameters.segmentBytes / (1024 * 1024));
+    return true;
+}
+
+bool UserInput::ParseOverlapped(
+    const std::vector<const wchar_t*>& _args)
+{
+    // Example: -Overlapped
+    // Example: -OverlappedBufferSize 4096
+    if (ArgumentProcessing::FindParameter(_args, L"-Overlapped"))
+    {
+        m_Parameters.overlappedLog = true;
+    }
+
+    std::wstring bufferSize;
+    if (ArgumentProcessing::FindParameter(_args, L"-OverlappedBufferSize", true, &bufferSize))
+    {
+        m_Parameters.overlappedLog = true;
+        unsigned long kilobytes = std::stoul(bufferSize);
+        if (kilobytes < 4 ||
+            kilobytes > Parameters::MaxOverlappedBufferSizeInKilobytes)
+        {
+            wprintf(L"Error: -OverlappedBufferSize must be from 4 to %lu KB.\n", Parameters::MaxOverlappedBufferSizeInKilobytes);
+            return false;
+        }
+        m_Parameters.overlappedBufferBytes = static_cast<size_t>(kilobytes) * 1024;
+    }
+
+    if (!m_Parameters.overlappedLog)
+    {
+        return true;
+    }
+
+    if (!m_Parameters.outputToFile)
+    {
+        wprintf(L"Error: -Overlapped needs -Output File.\n");
+        return false;
+    }
+
+    if (m_Parameters.durableLog ||
+        m_Parameters.mappedLog)
+    {
+        wprintf(L"Error: -Overlapped cannot be combined with -Durable or -Mapped.\n");
+        return false;
+    }
+
+    wprintf(L"\tOverlapped: writing the log file from %zu buffers of %zu KB.\n",
+        OverlappedLogFile::DefaultBufferCount,
+        m_Parameters.overlappedBufferBytes / 1024);
+    return true;
+}
+
+bool UserInput::ParseSyslog(
+    const std::vector<const wchar_t*>& _args)
+{
+    // Example: -Syslog collector.contoso.com
+    // Example: -Syslog 10.0.0.5 -SyslogPort 6514 -SyslogProtocol Tcp
+    std::wstring host;
+    bool foundHost = ArgumentProcessing::FindParameter(_args, L"-Syslog", true, &host);
+
+    std::wstring port;
+    if (ArgumentProcessing::FindParameter(_args, L"-SyslogPort", true, &port))
+    {
+        unsigned long value = std::stoul(port);
+        if (value == 0 ||
+            value > 65535)
+        {
+            wprintf(L"Error: -SyslogPort expects a port from 1 to 65535, got %ls.\n", port.c_str());
+            return false;
+        }
+        m_Parameters.syslogPort = static_cast<unsigned short>(value);
+    }
+
+    std::wstring protocol;
+    if (ArgumentProcessing::FindParameter(_args, L"-SyslogProtocol", true, &protocol))
+    {
+        if (ntl::String::iordinal_equals(protocol, L"Tcp"))
+        {
+            m_Parameters.syslogOverTcp = true;
+        }
+        else if (!ntl::String::iordinal_equals(protocol, L"Udp"))
+        {
+            wprintf(L"Error: -SyslogProtocol expects Udp or Tcp, got %ls.\n", protocol.c_str());
+            return false;
+        }
+    }
+
+    if (!foundHost)
+    {
+        if (!port.empty() ||
+            !protocol.empty())
+        {
+            wprintf(L"Error: -SyslogPort and -SyslogProtocol need -Syslog <host>.\n");
+            return false;
+        }
+        return true;
+    }
+
+    m_Parameters.syslogHost = host;
+    wprintf(L"\tSyslog: forwarding events to %ls port %u over %ls.\n",
+        m_Parameters.syslogHost.c_str(),
+        m_Parameters.syslogPort,
+        m_Parameters.syslogOverTcp ? L"TCP" : L"UDP");
+    return true;
+}
+
+bool UserInput::ParseArchive(
+    const std::vector<const wchar_t*>& _args)
+{
+    // Example: -Archive C:\temp\events.fea
+    std::wstring path;
+    if (!ArgumentProcessing::FindParameter(_args, L"-Archive", true, &path))
+    {
+        return true;
+    }
+
+    m_Parameters.archivePath = path;
+    wprintf(L"\tArchive: writing events to the columnar archive %ls.\n", path.c_str());
+    return true;
+}
+
+bool UserInput::ParseSketch(
+    const std::vector<const wchar_t*>& _args)
+{
+    // Example: -Sketch \\share\sketches
+    // Example: -Sketch C:\temp\sketches -SketchInterval 60
+    std::wstring directory;
+    bool foundSketch = ArgumentProcessing::FindParameter(_args, L"-Sketch", true, &directory);
+
+    std::wstring seconds;
+    if (ArgumentProcessing::FindParameter(_args, L"-SketchInterval", true, &seconds))
+    {
+        if (!foundSketch)
+        {
+            wprintf(L"Error: -SketchInterval requires -Sketch.\n");
+            return false;
+        }
+        m_Parameters.sketchIntervalInSeconds = std::stoul(seconds);
+        if (m_Parameters.sketchIntervalInSeconds == 0)
+        {
+            wprintf(L"SketchInterval must be at least 1 second.\n");
+            return false;
+        }
+    }
+
+    if (!foundSketch)
+    {
+        return true;
+    }
+
+    m_Parameters.sketchDirectory = directory;
+    wprintf(L"\tSketch: writing a sketch of every %lu seconds of events to %ls.\n",
+        m_Parameters.sketchIntervalInSeconds,
+        directory.c_str());
+    return true;
+}
+
+bool UserInput::ParseSchema(
+    const std::vector<const wchar_t*>& _args)
+{
+    // Example: -Schema C:\temp\schemas.txt
+    std::wstring path;
+    if (!ArgumentProcessing::FindParameter(_args, L"-Schema", true, &path))
+    {
+        return true;
+    }
+
+    m_Parameters.schemaPath = path;
+    wprintf(L"\tSchema: also watching the events described in %ls.\n", path.c_str());
+    return true;
+}
+
+bool UserInput::ParseIpAddressFilters(
+    const std::vector<const wchar_t*>& _args)
+{
+    // Example: -IP <addr>
+    // Example: -IP <addr>,<addr2> ...
+    std::wstring addresses;
+    bool foundIp = ArgumentProcessing::FindParameter(_args, L"-IP", true, &addresses);
+    if (!foundIp)
+    {
+        return true;
+    }
+
+    ValidationFunction func = [&](const std::wstring& input)->bool
+    { return ValidateIpAddress(input); };
+
+    bool valid = ValidateCommaDelimitedInput(
+        addresses,
+        func);
+
+    if (!valid)
+    {
+        return false;
+    }
+
+    wprintf(L"\tIP: filtering by the following IP addresses [");
+    for (const auto& ip : m_Parameters.ipAddressFilters)
+    {
+        wprintf(L"%ls ", ip.c_str());
+    }
+    wprintf(L"]\n");
+    return true;
+}
+
+bool UserInput::ParseRuleIdFilters(
+    const std::vector<const wchar_t*>& _args)
+{
+    // Example: -Rule <id>
+    // Example: -Rule <id>,<id2> ...
+    std::wstring rules;
+    bool foundRule = ArgumentProcessing::FindParameter(_args, L"-Rule", true, &rules);
+    if (!foundRule)
+    {
+        return true;
+    }
+
+    ValidationFunction func = [&](const std::wstring& input)->bool
+    { return ValidateRuleId(input); };
+
+    bool valid = ValidateCommaDelimitedInput(
+        rules,
+        func);
+
+    if (!valid)
+    {
+        return false;
+    }
+
+    wprintf(L"\tRule: filtering by the following Rule Ids [");
+    for (const auto& ruleFilter : m_Parameters.ruleIdFilters)
+    {
+        wprintf(L"%ls ", ruleFilter.c_str());
+    }
+    wprintf(L"]\n");
+    return true;
+}
+
+bool UserInput::ParseStatisticsInterval(
+    const std::vector<const wchar_t*>& _args)
+{
+    // Example: -StatsInterval 10
+    std::wstring seconds;
+    bool foundInterval = ArgumentProcessing::FindParameter(_args, L"-StatsInterval", true, &seconds);
+    if (!foundInterval)
+    {
+        return true;
+    }
+
+    m_Parameters.statisticsIntervalInSeconds = std::stoul(seconds);
+    if (m_Parameters.statisticsIntervalInSeconds == 0)
+    {
+        wprintf(L"\tStatsInterval: periodic statistics disabled.\n");
+    }
+    else
+    {
+        wprintf(L"\tStatsInterval: printing statistics every %d seconds.\n", m_Parameters.statisticsIntervalInSeconds);
+    }
+
+    return true;
+}
+
+bool UserInput::ParseAnomalyDetection(
+    const std::vector<const wchar_t*>& _args)
+{
+    // Example: -Anomaly
+    // Example: -AnomalyZScore 4 -AnomalyRatio 20
+    if (ArgumentProcessing::FindParameter(_args, L"-Anomaly"))
+    {
+        m_Parameters.detectAnomalies = true;
+    }
+
+    std::wstring zScore;
+    if (ArgumentProcessing::FindParameter(_args, L"-AnomalyZScore", true, &zScore))
+    {
+        m_Parameters.detectAnomalies = true;
+        m_Parameters.anomalyZScoreThreshold = std::stod(zScore);
+    }
+
+    std::wstring ratio;
+    if (ArgumentProcessing::FindParameter(_args, L"-AnomalyRatio", true, &ratio))
+    {
+        m_Parameters.detectAnomalies = true;
+        m_Parameters.anomalyRatioThreshold = std::stod(ratio);
+    }
+
+    if (m_Parameters.anomalyZScoreThreshold <= 0.0 ||
+        m_Parameters.anomalyRatioThreshold <= 1.0)
+    {
+        wprintf(L"Anomaly thresholds must be positive, and the ratio greater than 1.\n");
+        return false;
+    }
+
+    if (m_Parameters.detectAnomalies)
+    {
+        wprintf(L"\tAnomaly: alerting on rule hit rates above %.1f standard deviations or %.1fx the baseline.\n",
+            m_Parameters.anomalyZScoreThreshold,
+            m_Parameters.anomalyRatioThreshold);
+    }
+
+    return true;
+}
+
+bool UserInput::ParseFlowPairing(
+    const std::vector<const wchar_t*>& _args)
+{
+    // Example: -PairFlows
+    // Example: -PairWindow 60
+    if (ArgumentProcessing::FindParameter(_args, L"-PairFlows"))
+    {
+        m_Parameters.pairFlows = true;
+    }
+
+    std::wstring seconds;
+    if (ArgumentProcessing::FindParameter(_args, L"-PairWindow", true, &seconds))
+    {
+        m_Parameters.pairFlows = true;
+        m_Parameters.flowPairingWindowInSeconds = std::stoul(seconds);
+        if (m_Parameters.flowPairingWindowInSeconds == 0)
+        {
+            wprintf(L"PairWindow must be at least 1 second.\n");
+            return false;
+        }
+    }
+
+    if (m_Parameters.pairFlows)
+    {
+        wprintf(L"\tPairFlows: reporting flows with different outcomes in each direction within %d seconds.\n",
+            m_Parameters.flowPairingWindowInSeconds);
+    }
+
+    return true;
+}
+
+bool UserInput::ParseRuleUsage(
+    const std::vector<const wchar_t*>& _args)
+{
+    // Example: -RuleUsage
+    // Example: -RuleCatalog C:\policy\rules.txt -RuleUsageExport C:\temp\usage.csv
+    if (ArgumentProcessing::FindParameter(_args, L"-RuleUsage"))
+    {
+        m_Parameters.trackRuleUsage = true;
+    }
+
+    std::wstring catalog;
+    if (ArgumentProcessing::FindParameter(_args, L"-RuleCatalog", true, &catalog))
+    {
+        m_Parameters.trackRuleUsage = true;
+        m_Parameters.ruleCatalogPath = catalog;
+        wprintf(L"\tRuleCatalog: reporting rules listed in %ls that are never hit.\n", catalog.c_str());
+    }
+
+    std::wstring exportPath;
+    if (ArgumentProcessing::FindParameter(_args, L"-RuleUsageExport", true, &exportPath))
+    {
+        m_Parameters.trackRuleUsage = true;
+        m_Parameters.ruleUsageExportPath = exportPath;
+        wprintf(L"\tRuleUsageExport: writing the rule usage report to %ls.\n", exportPath.c_str());
+    }
+
+    if (m_Parameters.trackRuleUsage)
+    {
+        wprintf(L"\tRuleUsage: counting hits per rule.\n");
+    }
+
+    return true;
+}
+
+bool UserInput::ParseSampleRate(
+    const std::vector<const wchar_t*>& _args)
+{
+    // Example: -SampleRate 1/16
+    std::wstring rate;
+    bool foundRate = ArgumentProcessing::FindParameter(_args, L"-SampleRate", true, &rate);
+    if (!foundRate)
+    {
+        return true;
+    }
+
+    unsigned long sampleRate = 0;
+    if (!FlowSampler::ParseSampleRate(rate, &sampleRate))
+    {
+        wprintf(L"Error: -SampleRate expects 1/N with N at least 1, got %ls.\n", rate.c_str());
+        return false;
+    }
+
+    m_Parameters.sampleRate = sampleRate;
+    wprintf(L"\tSampleRate: keeping every event of 1 in %lu flows.\n", m_Parameters.sampleRate);
+    return true;
+}
+
+bool UserInput::ParseAdaptiveSampling(
+    const std::vector<const wchar_t*>& _args)
+{
+    // Example: -Adaptive
+    // Example: -LagBudget 500 -CpuBudget 5
+    if (ArgumentProcessing::FindParameter(_args, L"-Adaptive"))
+    {
+        m_Parameters.adaptiveSampling = true;
+    }
+
+    std::wstring lag;
+    if (ArgumentProcessing::FindParameter(_args, L"-LagBudget", true, &lag))
+    {
+        m_Parameters.adaptiveSampling = true;
+        m_Parameters.lagBudgetInMilliseconds = std::stoul(lag);
+    }
+
+    std::wstring cpu;
+    if (ArgumentProcessing::FindParameter(_args, L"-CpuBudget", true, &cpu))
+    {
+        m_Parameters.adaptiveSampling = true;
+        m_Parameters.cpuBudgetPercent = std::stod(cpu);
+    }
+
+    if (m_Parameters.lagBudgetInMilliseconds == 0 ||
+        m_Parameters.cpuBudgetPercent <= 0.0 ||
+        m_Parameters.cpuBudgetPercent > 100.0)
+    {
+        wprintf(L"LagBudget must be positive, and CpuBudget between 0 and 100.\n");
+        return false;
+    }
+
+    if (m_Parameters.adaptiveSampling)
+    {
+        wprintf(L"\tAdaptive: sampling flows to stay within %d ms of lag and %.1f%% CPU.\n",
+            m_Parameters.lagBudgetInMilliseconds,
+            m_Parameters.cpuBudgetPercent);
+    }
+
+    return true;
+}
+
+bool UserInput::ParseShedPriority(
+    const std::vector<const wchar_t*>& _args)
+{
+    // Example: -ShedPriority Default
+    // Example: -ShedPriority Deny:40,TcpSyn:20,Icmp:5,Allow
+    std::wstring policy;
+    bool foundPolicy = ArgumentProcessing::FindParameter(_args, L"-ShedPriority", true, &policy);
+    if (!foundPolicy)
+    {
+        return true;
+    }
+
+    if (!LoadShedder::ParsePolicy(policy, &m_Parameters.shedPolicy))
+    {
+        wprintf(L"Error: -ShedPriority expects Class:percent entries (Deny, Icmp, TcpSyn, Allow) reserving at most 100%% in total, got %ls.\n",
+            policy.c_str());
+        return false;
+    }
+
+    wprintf(L"\tShedPriority: sharing %d events per second by class [", m_Parameters.maxEventsPerEpoc);
+    for (const auto& entry : m_Parameters.shedPolicy)
+    {
+        wprintf(L"%ls:%lu%% ", LoadShedder::EventClassName(entry.eventClass), entry.reservedPercent);
+    }
+    wprintf(L"]\n");
+    return true;
+}
+
+bool UserInput::ParseDiff(
+    const std::vector<const wchar_t*>& _args)
+{
+    // Example: -Diff C:\temp\before.etl,C:\temp\after.etl
+    std::wstring captures;
+    bool foundDiff = ArgumentProcessing::FindParameter(_args, L"-Diff", true, &captures);
+    if (!foundDiff)
+    {
+        return true;
+    }
+
+    std::vector<std::wstring> paths;
+    ValidationFunction func = [&](const std::wstring& input)->bool
+    {
+        paths.push_back(input);
+        return true;
+    };
+    ValidateCommaDelimitedInput(captures, func);
+
+    if (paths.size() != 2)
+    {
+        wprintf(L"Error: -Diff expects two captures, <before>,<after>.\n");
+        return false;
+    }
+
+    m_Parameters.diffCaptures = paths;
+    wprintf(L"\tDiff: comparing %ls with %ls.\n", paths[0].c_str(), paths[1].c_str());
+    return true;
+}
+
+bool UserInput::ParseMergeSketches(
+    const std::vector<const wchar_t*>& _args)
+{
+    // Example: -MergeSketches \\share\sketches
+    // Example: -MergeSketches C:\temp\sketches\web*.sketch -MergeOutput C:\temp\web.sketch
+    std::wstring path;
+    bool foundMerge = ArgumentProcessing::FindParameter(_args, L"-MergeSketches", true, &path);
+
+    std::wstring outputPath;
+    bool foundOutput = ArgumentProcessing::FindParameter(_args, L"-MergeOutput", true, &outputPath);
+    if (foundOutput && !foundMerge)
+    {
+        wprintf(L"Error: -MergeOutput requires -MergeSketches.\n");
+        return false;
+    }
+
+    if (!foundMerge)
+    {
+        return true;
+    }
+
+    m_Parameters.mergeSketchesPath = path;
+    wprintf(L"\tMergeSketches: merging the sketches in %ls.\n", path.c_str());
+    if (foundOutput)
+    {
+        m_Parameters.mergeOutputPath = outputPath;
+        wprintf(L"\tMergeOutput: writing the merged sketch to %ls.\n", outputPath.c_str());
+    }
+    return true;
+}
+
+bool UserInput::ValidateOutputType(
+    const std::wstring& value)
+{
+    if (ntl::String::iordinal_equals(value, L"Console"))
+    {
+        wprintf(L"\tOutput: printing to Console.\n");
+        m_Parameters.outputToConsole = true;
+    }
+    else if (ntl::String::iordinal_equals(value, L"File"))
+    {
+        wprintf(L"\tOutput: writing to File.\n");
+        m_Parameters.outputToFile = true;
+    }
+    else if (ntl::String::iordinal_equals(value, L"Dashboard"))
+    {
+        wprintf(L"\tOutput: showing the Dashboard.\n");
+        m_Parameters.outputToDashboard = true;
+    }
+    else
+    {
+        wprintf(L"Unrecognized output type specified: %ls.\n", value.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool UserInput::ValidateIpAddress(
+    const std::wstring& ipAddress)
+{
+    // Filters are compared in binary form, so each must be an address.
+    IN6_ADDR address;
+    bool isIpv6 = false;
+    if (!ParseAddress(ipAddress, &address, &isIpv6))
+    {
+        wprintf(L"Invalid IP address: %ls.\n", ipAddress.c_str());
+        return false;
+    }
+    m_Parameters.ipAddressFilters.push_back(ipAddress);
+    return true;
+}
+
+bool UserInput::ValidateRuleId(
+    const std::wstring& rule)
+{
+    // Test for Guid in the form: {XXXXXXXX-XXXX-XXXX-XXXX-XXXXXXXXXXXX} or XXXXXXXX-XXXX-XXXX-XXXX-XXXXXXXXXXXX
+    GUID guid;
+    if (ntl::Uuid::parse_uuid(rule.c_str(), rule.size(), &guid))
+    {
+        if (rule.front() == L'{')
+        {
+            // Trim '{' and '}'
+            m_Parameters.ruleIdFilters.push_back(rule.substr(1, rule.size() - 2));
+        }
+        else
+        {
+            m_Parameters.ruleIdFilters.push_back(rule);
+        }
+        return true;
+    }
+
+    wprintf(L"Invalid Guid for RuleId: %ls.\n", rule.c_str());
+    return false;
+}
+
+bool UserInput::ValidateCommaDelimitedInput(
+    const std::wstring& input,
+    _In_ ValidationFunction matchFunction)
+{
+    auto commas = ntl::String::all_indices_of(
+        input.begin(), input.end(),
+        [](wchar_t _ch) -> bool { return _ch == L','; });
+
+    // Only one input was specified
+    if (commas.size() == 0)
+    {
+        return matchFunction(input);
+    }
+
+    // Multiple comma-delimited inputs were specified
+    bool success = true;
+    std::wstring::const_iterator beginningOfWord = std::cbegin(input);
+    for (const auto& comma : commas)
+    {
+        std::wstring inputElement(beginningOfWord, comma);
+        auto result = matchFunction(inputElement);
+
+        if (!result)
+        {
+            success = false;
+        }
+
+        // move beginningOfWord to the first character of the next word
+        beginningOfWord = comma;
+        ++beginningOfWord;
+    }
+
+    // beginningOfWord now points to the first character of the very last word
+    std::wstring::const_iterator endOfWord = std::end(input);
+    std::wstring lastInput(beginningOfWord, endOfWord);
+    auto result = matchFunction(lastInput);
+
+    if (!result)
+    {
+        success = false;
+    }
+
+    return success;
 }
\ No newline at end of file
@@ -1,96 +1,191 @@
-// Copyright (c) Microsoft Corporation. All rights reserved.
-// Licensed under the MIT License. See License.txt in the project root for license information.
-
-#pragma once
-
-// c++ headers
-#include <functional>
-#include <vector>
-#include <string>
-
-#include "Timer.h"
-#include "ArgumentProcessing.h"
-
-namespace FirewallEventMonitor
-{
-    // Collection of constructor parameters.
-    struct Parameters
-    {
-    public:
-        // Event Filtering
-        std::vector<std::wstring> ipAddressFilters;
-        std::vector<std::wstring> ruleIdFilters;
-        // Event Counter
-        unsigned long maxEventsPerEpoc = DefaultEventCountMaxPerSecond;
-        // Timer
-        unsigned long maxRuntimeInSeconds = DefaultTimeLimitInSeconds;
-        bool noTimeout = false; // Indefinite runtime.
-        // FileLogger
-        std::wstring logDirectory = L""; // Defaults to current directory
-        bool outputToConsole = true;
-        bool outputToFile = false;
-
-        // Constants
-        static const unsigned long DefaultTimeLimitInSeconds = 300ul; // 5 Minutes (ignored if noTimeout is true).
-        static const unsigned long DefaultEventCountMaxPerSecond = 10000ul; // 10,000 Events.
-    };
-
-    enum class ArgumentParsingResults { Success, Fail, Help };
-
-    class UserInput
-    {
-    public:
-        FirewallEventMonitor::Parameters GetParameters() const
-        {
-            return m_Parameters;
-        }
-
-        //
-        // User Input Parsing
-        //
-
-        void PrintUsage() const;
-
-        ArgumentParsingResults ParseArguments(
-            const int argc,
-            _In_reads_(argc) const wchar_t** argv);
-
-        bool ParseHelp(const std::vector<const wchar_t*>& _args);
-
-        bool ParseEventThrottle(const std::vector<const wchar_t*>& _args);
-
-        bool ParseTimeLimit(const std::vector<const wchar_t*>& _args);
-
-        bool ParseNoTimeout(const std::vector<const wchar_t*>& _args);
-
-        bool ParseOutput(const std::vector<const wchar_t*>& _args);
-
-        bool ParseDirectory(const std::vector<const wchar_t*>& _args);
-
-        bool ParseIpAddressFilters(const std::vector<const wchar_t*>& _args);
-
-        bool ParseRuleIdFilters(const std::vector<const wchar_t*>& _args);
-
-        //
-        // User Input Validation
-        //
-        typedef std::function<bool(const std::wstring& value)> ValidationFunction;
-
-        // Match text to an OutputFlag, set reader parameters.
-        bool ValidateOutputType(const std::wstring& outputType);
-
-        // Add Ip Addresses to reader parameters.
-        bool ValidateIpAddress(const std::wstring& ipAddress);
-
-        // Checks RuleId is a valid Guid, adds it to reader parameters.
-        bool ValidateRuleId(const std::wstring& ruleId);
-
-        // Validates Comma-Delimited Input using the provided ValidationFunction.
-        bool ValidateCommaDelimitedInput(
-            const std::wstring& input,
-            _In_ ValidationFunction matchFunction);
-
-    private:
-        Parameters m_Parameters;
-    };
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#pragma once
+
+// c++ headers
+#include <functional>
+#include <vector>
+#include <string>
+
+#include "Timer.h"
+#include "FileLogger.h"
+#include "ArgumentProcessing.h"
+#include "EventSink.h"
+#include "LoadShedder.h"
+
+namespace FirewallEventMonitor
+{
+    // Collection of constructor parameters.
+    struct Parameters
+    {
+    public:
+        // Event Filtering
+        std::vector<std::wstring> ipAddressFilters;
+        std::vector<std::wstring> ruleIdFilters;
+        // Event Counter
+        unsigned long maxEventsPerEpoc = DefaultEventCountMaxPerSecond;
+        std::vector<ShedClassPolicy> shedPolicy; // Empty unless -ShedPriority was specified; then maxEventsPerEpoc is shared by class.
+        // Timer
+        unsigned long maxRuntimeInSeconds = DefaultTimeLimitInSeconds;
+        bool noTimeout = false; // Indefinite runtime.
+        unsigned long drainTimeoutInMilliseconds = DefaultDrainTimeoutInMilliseconds; // Shutdown time for the events in flight.
+        // FileLogger
+        std::wstring logDirectory = L""; // Defaults to current directory
+        bool outputToConsole = true;
+        bool outputToFile = false;
+        bool outputToDashboard = false; // Full-screen view in place of the scrolling console.
+        EventFormat logFormat = EventFormat::Text;
+        bool durableLog = false; // Group commit the log file to disk (-Durable).
+        unsigned long durableIntervalInMilliseconds = FileLogger::DefaultCommitIntervalInMilliseconds;
+        size_t durableBytes = FileLogger::DefaultCommitBytes;
+        bool mappedLog = false; // Write the log file through memory mapped segments (-Mapped).
+        size_t segmentBytes = MappedLogFile::DefaultSegmentBytes;
+        bool overlappedLog = false; // Write the log file with overlapped I/O (-Overlapped).
+        size_t overlappedBufferBytes = OverlappedLogFile::DefaultBufferBytes;
+        // Syslog
+        std::wstring syslogHost = L""; // Collector to forward events to; empty disables syslog.
+        unsigned short syslogPort = DefaultSyslogPort;
+        bool syslogOverTcp = false; // UDP unless -SyslogProtocol Tcp.
+        // Archive
+        std::wstring archivePath = L""; // Columnar archive of every event written; empty disables it.
+        // Sketches
+        std::wstring sketchDirectory = L""; // A sketch of each interval is written here; empty disables sketches.
+        unsigned long sketchIntervalInSeconds = DefaultSketchIntervalInSeconds;
+        // Schemas
+        std::wstring schemaPath = L""; // Schemas of providers to watch besides VFP; empty watches VFP alone.
+        // Statistics
+        unsigned long statisticsIntervalInSeconds = DefaultStatisticsIntervalInSeconds; // 0 disables periodic statistics.
+        // Anomaly Detection
+        bool detectAnomalies = false;
+        double anomalyZScoreThreshold = DefaultAnomalyZScoreThreshold;
+        double anomalyRatioThreshold = DefaultAnomalyRatioThreshold;
+        // Flow Pairing
+        bool pairFlows = false;
+        unsigned long flowPairingWindowInSeconds = DefaultFlowPairingWindowInSeconds;
+        // Rule Usage
+        bool trackRuleUsage = false;
+        std::wstring ruleCatalogPath = L""; // Optional list of every configured rule id.
+        std::wstring ruleUsageExportPath = L""; // .json for JSON, otherwise CSV.
+        // Flow Sampling
+        unsigned long sampleRate = 1; // Keep every event of 1 in sampleRate flows; 1 keeps everything.
+        bool adaptiveSampling = false; // Raise the sample rate above sampleRate when over the budgets below.
+        unsigned long lagBudgetInMilliseconds = DefaultLagBudgetInMilliseconds;
+        double cpuBudgetPercent = DefaultCpuBudgetPercent; // Share of all processors.
+        // Capture Diff
+        std::vector<std::wstring> diffCaptures; // Before and after captures; compared instead of starting a session.
+        // Sketch Merge
+        std::wstring mergeSketchesPath = L""; // Sketch file, directory or pattern; merged instead of starting a session.
+        std::wstring mergeOutputPath = L""; // The merged sketch is written here; empty writes none.
+
+        // Constants
+        static const unsigned long DefaultTimeLimitInSeconds = 300ul; // 5 Minutes (ignored if noTimeout is true).
+        static const unsigned long DefaultDrainTimeoutInMilliseconds = 5000ul;
+        static const unsigned long DefaultEventCountMaxPerSecond = 10000ul; // 10,000 Events.
+        static const unsigned long DefaultStatisticsIntervalInSeconds = 60ul; // 1 Minute.
+        static constexpr double DefaultAnomalyZScoreThreshold = 6.0; // Standard deviations above the baseline.
+        static constexpr double DefaultAnomalyRatioThreshold = 10.0; // Multiples of the baseline rate.
+        static const unsigned long DefaultFlowPairingWindowInSeconds = 30ul;
+        static const unsigned long DefaultLagBudgetInMilliseconds = 2000ul;
+        static constexpr double DefaultCpuBudgetPercent = 10.0;
+        static const unsigned short DefaultSyslogPort = 514;
+        static const unsigned long DefaultSketchIntervalInSeconds = 300ul; // 5 Minutes.
+        static const unsigned long MaxSegmentSizeInMegabytes = 1024ul; // Each segment is mapped whole.
+        static const unsigned long MaxOverlappedBufferSizeInKilobytes = 64ul * 1024ul; // Each of the buffers is allocated up front.
+    };
+
+    enum class ArgumentParsingResults { Success, Fail, Help };
+
+    class UserInput
+    {
+    public:
+        FirewallEventMonitor::Parameters GetParameters() const
+        {
+            return m_Parameters;
+        }
+
+        //
+        // User Input Parsing
+        //
+
+        void PrintUsage() const;
+
+        ArgumentParsingResults ParseArguments(
+            const int argc,
+            _In_reads_(argc) const wchar_t** argv);
+
+        bool ParseHelp(const std::vector<const wchar_t*>& _args);
+
+        bool ParseEventThrottle(const std::vector<const wchar_t*>& _args);
+
+        bool ParseTimeLimit(const std::vector<const wchar_t*>& _args);
+
+        bool ParseNoTimeout(const std::vector<const wchar_t*>& _args);
+
+        bool ParseDrainTimeout(const std::vector<const wchar_t*>& _args);
+
+        bool ParseOutput(const std::vector<const wchar_t*>& _args);
+
+        bool ParseDirectory(const std::vector<const wchar_t*>& _args);
+
+        bool ParseLogFormat(const std::vector<const wchar_t*>& _args);
+
+        bool ParseDurable(const std::vector<const wchar_t*>& _args);
+
+        bool ParseMapped(const std::vector<const wchar_t*>& _args);
+
+        bool ParseOverlapped(const std::vector<const wchar_t*>& _args);
+
+        bool ParseSyslog(const std::vector<const wchar_t*>& _args);
+
+        bool ParseArchive(const std::vector<const wchar_t*>& _args);
+
+        bool ParseSketch(const std::vector<const wchar_t*>& _args);
+
+        bool ParseSchema(const std::vector<const wchar_t*>& _args);
+
+        bool ParseIpAddressFilters(const std::vector<const wchar_t*>& _args);
+
+        bool ParseRuleIdFilters(const std::vector<const wchar_t*>& _args);
+
+        bool ParseStatisticsInterval(const std::vector<const wchar_t*>& _args);
+
+        bool ParseAnomalyDetection(const std::vector<const wchar_t*>& _args);
+
+        bool ParseFlowPairing(const std::vector<const wchar_t*>& _args);
+
+        bool ParseRuleUsage(const std::vector<const wchar_t*>& _args);
+
+        bool ParseSampleRate(const std::vector<const wchar_t*>& _args);
+
+        bool ParseAdaptiveSampling(const std::vector<const wchar_t*>& _args);
+
+        bool ParseShedPriority(const std::vector<const wchar_t*>& _args);
+
+        bool ParseDiff(const std::vector<const wchar_t*>& _args);
+
+        bool ParseMergeSketches(const std::vector<const wchar_t*>& _args);
+
+        //
+        // User Input Validation
+        //
+        typedef std::function<bool(const std::wstring& value)> ValidationFunction;
+
+        // Match text to an OutputFlag, set reader parameters.
+        bool ValidateOutputType(const std::wstring& outputType);
+
+        // Checks the Ip Address parses, adds it to reader parameters.
+        bool ValidateIpAddress(const std::wstring& ipAddress);
+
+        // Checks RuleId is a valid Guid, adds it to reader parameters.
+        bool ValidateRuleId(const std::wstring& ruleId);
+
+        // Validates Comma-Delimited Input using the provided ValidationFunction.
+        bool ValidateCommaDelimitedInput(
+            const std::wstring& input,
+            _In_ ValidationFunction matchFunction);
+
+    private:
+        Parameters m_Parameters;
+    };
 }
\ No newline at end of file
@@ -0,0 +1,49 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#pragma once
+
+#include <ntlException.hpp>
+
+namespace ntl {
+namespace Crc32 {
+
+    ///
+    /// CRC-32 as used by zip, gzip and Ethernet (reflected polynomial 0xEDB88320),
+    /// so values can be checked with standard tools
+    ///
+    inline const unsigned long* table() NOEXCEPT
+    {
+        static const struct Crc32Table {
+            unsigned long values[256];
+            Crc32Table() NOEXCEPT
+            {
+                for (unsigned long index = 0; index < 256; ++index) {
+                    unsigned long value = index;
+                    for (int bit = 0; bit < 8; ++bit) {
+                        value = (value & 1) ? (value >> 1) ^ 0xEDB88320ul : value >> 1;
+                    }
+                    values[index] = value;
+                }
+            }
+        } crcTable;
+        return crcTable.values;
+    }
+
+    ///
+    /// Continues a CRC over more bytes; start with 0
+    /// - update(update(0, a), b) == update(0, a + b)
+    ///
+    inline unsigned long update(unsigned long _crc, _In_reads_bytes_(_length) const void* _data, size_t _length) NOEXCEPT
+    {
+        const unsigned long* crcTable = table();
+        const unsigned char* bytes = static_cast<const unsigned char*>(_data);
+        unsigned long crc = ~_crc & 0xFFFFFFFFul;
+        for (size_t index = 0; index < _length; ++index) {
+            crc = crcTable[(crc ^ bytes[index]) & 0xFF] ^ (crc >> 8);
+        }
+        return ~crc & 0xFFFFFFFFul;
+    }
+
+} // namespace Crc32
+} // namespace ntl
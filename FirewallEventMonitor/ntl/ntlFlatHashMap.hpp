@@ -0,0 +1,224 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#pragma once
+
+#include <vector>
+#include <utility>
+#include <functional>
+
+#include <ntlException.hpp>
+
+namespace ntl {
+    ///
+    /// FlatHashMap
+    ///
+    /// Open-addressing hash map with linear probing over a single contiguous array
+    /// - no per-entry allocation, and a lookup touches one or two cache lines
+    /// - capacity is a power of two and grows when more than 3/4 full, so reserve()
+    ///   up front keeps inserts from rehashing on a hot path
+    /// - erase uses backward-shift deletion, so there are no tombstones to clean up
+    /// - pointers returned by find() and try_emplace() are invalidated by any insert or erase
+    ///
+    /// Key and Value must be default constructible and copy or move assignable
+    ///
+    template <typename Key, typename Value, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+    class FlatHashMap {
+    public:
+        explicit FlatHashMap(size_t _expected_size = 0)
+        {
+            reserve(_expected_size);
+        }
+
+        Value* find(const Key& _key)
+        {
+            size_t index = 0;
+            return locate(_key, &index) ? &slots[index].value : nullptr;
+        }
+
+        const Value* find(const Key& _key) const
+        {
+            size_t index = 0;
+            return locate(_key, &index) ? &slots[index].value : nullptr;
+        }
+
+        ///
+        /// Returns the value for _key, inserting a default-constructed value if absent
+        /// - the bool is true if the value was inserted
+        ///
+        std::pair<Value*, bool> try_emplace(const Key& _key)
+        {
+            if ((entries + 1) * 4 > slots.size() * 3) {
+                rehash(slots.empty() ? MinimumCapacity : slots.size() * 2);
+            }
+
+            size_t index = 0;
+            if (locate(_key, &index)) {
+                return std::make_pair(&slots[index].value, false);
+            }
+            // locate() leaves index at the first empty slot of the probe sequence
+            slots[index].key = _key;
+            slots[index].value = Value();
+            occupied[index] = true;
+            ++entries;
+            return std::make_pair(&slots[index].value, true);
+        }
+
+        bool erase(const Key& _key)
+        {
+            size_t index = 0;
+            if (!locate(_key, &index)) {
+                return false;
+            }
+
+            // Shift later members of the probe chain back so lookups never cross a hole.
+            const size_t mask = slots.size() - 1;
+            size_t hole = index;
+            size_t next = (hole + 1) & mask;
+            while (occupied[next]) {
+                size_t home = home_slot(slots[next].key);
+                // move next into the hole if its home is not between the hole and next (cyclically)
+                if (((next - home) & mask) >= ((next - hole) & mask)) {
+                    slots[hole] = std::move(slots[next]);
+                    hole = next;
+                }
+                next = (next + 1) & mask;
+            }
+            occupied[hole] = false;
+            slots[hole] = Slot();
+            --entries;
+            return true;
+        }
+
+        ///
+        /// Removes every entry for which _predicate(key, value) returns true
+        /// - returns the number of entries removed
+        ///
+        template <typename Predicate>
+        size_t erase_if(Predicate _predicate)
+        {
+            std::vector<Key> doomed;
+            for_each([&](const Key& _key, const Value& _value) {
+                if (_predicate(_key, _value)) {
+                    doomed.push_back(_key);
+                }
+            });
+            for (const auto& key : doomed) {
+                erase(key);
+            }
+            return doomed.size();
+        }
+
+        template <typename Function>
+        void for_each(Function _function) const
+        {
+            for (size_t i = 0; i < slots.size(); ++i) {
+                if (occupied[i]) {
+                    _function(slots[i].key, slots[i].value);
+                }
+            }
+        }
+
+        template <typename Function>
+        void for_each(Function _function)
+        {
+            for (size_t i = 0; i < slots.size(); ++i) {
+                if (occupied[i]) {
+                    _function(slots[i].key, slots[i].value);
+                }
+            }
+        }
+
+        void reserve(size_t _expected_size)
+        {
+            size_t capacity = MinimumCapacity;
+            while (capacity * 3 < _expected_size * 4) {
+                capacity *= 2;
+            }
+            if (capacity > slots.size()) {
+                rehash(capacity);
+            }
+        }
+
+        void clear()
+        {
+            std::vector<Slot>(slots.size()).swap(slots);
+            std::vector<bool>(occupied.size(), false).swap(occupied);
+            entries = 0;
+        }
+
+        size_t size() const NOEXCEPT
+        {
+            return entries;
+        }
+
+        bool empty() const NOEXCEPT
+        {
+            return entries == 0;
+        }
+
+        size_t capacity() const NOEXCEPT
+        {
+            return slots.size();
+        }
+
+        static const size_t MinimumCapacity = 16;
+
+    private:
+        struct Slot {
+            Key key;
+            Value value;
+        };
+
+        std::vector<Slot> slots;
+        std::vector<bool> occupied;
+        size_t entries = 0;
+        Hash hasher;
+        KeyEqual equals;
+
+        size_t home_slot(const Key& _key) const
+        {
+            // Fibonacci hashing spreads weak hashes (e.g. identity) across the table.
+            unsigned long long hash = static_cast<unsigned long long>(hasher(_key)) * 0x9E3779B97F4A7C15ull;
+            return static_cast<size_t>(hash >> 32) & (slots.size() - 1);
+        }
+
+        // Returns true and the slot of _key if present; otherwise false and the first empty slot.
+        bool locate(const Key& _key, size_t* _index) const
+        {
+            if (slots.empty()) {
+                return false;
+            }
+            const size_t mask = slots.size() - 1;
+            size_t index = home_slot(_key);
+            while (occupied[index]) {
+                if (equals(slots[index].key, _key)) {
+                    *_index = index;
+                    return true;
+                }
+                index = (index + 1) & mask;
+            }
+            *_index = index;
+            return false;
+        }
+
+        void rehash(size_t _capacity)
+        {
+            std::vector<Slot> old_slots(_capacity);
+            std::vector<bool> old_occupied(_capacity, false);
+            old_slots.swap(slots);
+            old_occupied.swap(occupied);
+            entries = 0;
+
+            for (size_t i = 0; i < old_slots.size(); ++i) {
+                if (old_occupied[i]) {
+                    size_t index = 0;
+                    locate(old_slots[i].key, &index);
+                    slots[index] = std::move(old_slots[i]);
+                    occupied[index] = true;
+                    ++entries;
+                }
+            }
+        }
+    };
+} // namespace ntl
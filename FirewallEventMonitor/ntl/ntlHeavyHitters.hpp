@@ -0,0 +1,243 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include <ntlException.hpp>
+#include <ntlFlatHashMap.hpp>
+
+namespace ntl {
+    ///
+    /// HeavyHitters
+    ///
+    /// Space-Saving summary (Metwally et al.) of the most frequent keys of a weighted stream,
+    /// in at most capacity entries
+    /// - each entry holds an overestimate of the key's weight and the most it can be over by:
+    ///   the key's true weight is within [count - error, count]
+    /// - a key not in the summary has a weight of at most absent_bound(), which for a summary
+    ///   built by add() is at most total() / capacity: any key above that is always in it
+    /// - add() is O(log capacity): the entries are a min-heap on count, so the smallest entry,
+    ///   which a new key replaces once the summary is full, is always at the front
+    /// - merge() combines summaries of different streams (Agarwal et al.): a key missing from
+    ///   one of them is charged that summary's absent_bound(), so the bounds still hold
+    ///
+    /// Key must be default constructible and copy assignable
+    ///
+    template <typename Key, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+    class HeavyHitters {
+    public:
+        struct entry {
+            Key key;
+            unsigned long long count;
+            unsigned long long error;
+        };
+
+        ///
+        /// Throws ntl::Exception if _capacity is 0
+        ///
+        explicit HeavyHitters(size_t _capacity = 256) :
+            entry_capacity(_capacity),
+            positions(_capacity)
+        {
+            if (_capacity == 0) {
+                throw Exception(ERROR_INVALID_PARAMETER, L"HeavyHitters - capacity must be at least 1", L"ntl::HeavyHitters", false);
+            }
+            entries.reserve(_capacity);
+        }
+
+        void add(const Key& _key, unsigned long long _weight = 1)
+        {
+            total_weight += _weight;
+            size_t* position = positions.find(_key);
+            if (position != nullptr) {
+                entries[*position].count += _weight;
+                sift_down(*position);
+                return;
+            }
+
+            if (entries.size() < entry_capacity) {
+                entries.push_back(entry{ _key, _weight, 0 });
+                *positions.try_emplace(_key).first = entries.size() - 1;
+                sift_up(entries.size() - 1);
+                return;
+            }
+
+            // the new key takes the place of the smallest, whose count it may already have had
+            entry& smallest = entries.front();
+            positions.erase(smallest.key);
+            smallest.key = _key;
+            smallest.error = smallest.count;
+            smallest.count += _weight;
+            *positions.try_emplace(_key).first = 0;
+            sift_down(0);
+        }
+
+        ///
+        /// Adds the stream summarized by _other; the result keeps this summary's capacity
+        ///
+        void merge(const HeavyHitters& _other)
+        {
+            const unsigned long long bound = absent_bound();
+            const unsigned long long other_bound = _other.absent_bound();
+
+            std::vector<entry> combined;
+            combined.reserve(entries.size() + _other.entries.size());
+            for (const auto& mine : entries) {
+                const size_t* position = _other.positions.find(mine.key);
+                if (position != nullptr) {
+                    const entry& theirs = _other.entries[*position];
+                    combined.push_back(entry{ mine.key, mine.count + theirs.count, mine.error + theirs.error });
+                } else {
+                    combined.push_back(entry{ mine.key, mine.count + other_bound, mine.error + other_bound });
+                }
+            }
+            for (const auto& theirs : _other.entries) {
+                if (positions.find(theirs.key) == nullptr) {
+                    combined.push_back(entry{ theirs.key, theirs.count + bound, theirs.error + bound });
+                }
+            }
+
+            total_weight += _other.total_weight;
+            rebuild(std::move(combined));
+        }
+
+        ///
+        /// Replaces the summary with entries saved from another one, and the total weight it summarized
+        /// - only the largest capacity() entries are kept
+        /// - throws ntl::Exception (leaving the summary empty) if a key appears more than once
+        ///
+        void load(std::vector<entry> _entries, unsigned long long _total)
+        {
+            total_weight = _total;
+            rebuild(std::move(_entries));
+        }
+
+        ///
+        /// The _count entries with the largest counts, largest first
+        ///
+        std::vector<entry> top(size_t _count) const
+        {
+            std::vector<entry> ranked(entries);
+            const size_t kept = (std::min)(_count, ranked.size());
+            std::partial_sort(ranked.begin(), ranked.begin() + kept, ranked.end(), [](const entry& _lhs, const entry& _rhs) {
+                // of equal counts, the one known most precisely first
+                return _lhs.count != _rhs.count ? _lhs.count > _rhs.count : _lhs.error < _rhs.error;
+            });
+            ranked.resize(kept);
+            return ranked;
+        }
+
+        ///
+        /// The entries in no particular order
+        ///
+        const std::vector<entry>& entry_values() const NOEXCEPT
+        {
+            return entries;
+        }
+
+        ///
+        /// The largest weight a key not in the summary can have had
+        ///
+        unsigned long long absent_bound() const NOEXCEPT
+        {
+            return entries.size() < entry_capacity ? 0 : entries.front().count;
+        }
+
+        ///
+        /// Sum of the weights added, including those of keys no longer in the summary
+        ///
+        unsigned long long total() const NOEXCEPT
+        {
+            return total_weight;
+        }
+
+        size_t size() const NOEXCEPT
+        {
+            return entries.size();
+        }
+
+        size_t capacity() const NOEXCEPT
+        {
+            return entry_capacity;
+        }
+
+        void reset()
+        {
+            entries.clear();
+            positions.clear();
+            total_weight = 0;
+        }
+
+    private:
+        size_t entry_capacity;
+        std::vector<entry> entries; // min-heap on count
+        FlatHashMap<Key, size_t, Hash, KeyEqual> positions; // index of each key in entries
+        unsigned long long total_weight = 0;
+
+        void swap_entries(size_t _lhs, size_t _rhs)
+        {
+            std::swap(entries[_lhs], entries[_rhs]);
+            *positions.find(entries[_lhs].key) = _lhs;
+            *positions.find(entries[_rhs].key) = _rhs;
+        }
+
+        void sift_up(size_t _index)
+        {
+            while (_index > 0) {
+                const size_t parent = (_index - 1) / 2;
+                if (entries[parent].count <= entries[_index].count) {
+                    return;
+                }
+                swap_entries(parent, _index);
+                _index = parent;
+            }
+        }
+
+        void sift_down(size_t _index)
+        {
+            for (;;) {
+                const size_t left = 2 * _index + 1;
+                if (left >= entries.size()) {
+                    return;
+                }
+                const size_t right = left + 1;
+                const size_t smaller = right < entries.size() && entries[right].count < entries[left].count ? right : left;
+                if (entries[_index].count <= entries[smaller].count) {
+                    return;
+                }
+                swap_entries(_index, smaller);
+                _index = smaller;
+            }
+        }
+
+        // keeps the largest capacity entries of _entries, and rebuilds the heap and the positions from them
+        void rebuild(std::vector<entry> _entries)
+        {
+            if (_entries.size() > entry_capacity) {
+                std::nth_element(_entries.begin(), _entries.begin() + entry_capacity, _entries.end(), [](const entry& _lhs, const entry& _rhs) {
+                    return _lhs.count > _rhs.count;
+                });
+                _entries.resize(entry_capacity);
+            }
+            std::make_heap(_entries.begin(), _entries.end(), [](const entry& _lhs, const entry& _rhs) {
+                return _lhs.count > _rhs.count;
+            });
+
+            entries = std::move(_entries);
+            positions.clear();
+            for (size_t i = 0; i < entries.size(); ++i) {
+                auto inserted = positions.try_emplace(entries[i].key);
+                if (!inserted.second) {
+                    reset();
+                    throw Exception(ERROR_INVALID_DATA, L"HeavyHitters - a key appears more than once", L"ntl::HeavyHitters", false);
+                }
+                *inserted.first = i;
+            }
+        }
+    };
+}
@@ -0,0 +1,86 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#pragma once
+
+#include <algorithm>
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define NTL_HEX_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#include <ntlException.hpp>
+
+namespace ntl {
+namespace Hex {
+
+    ///
+    /// Value returned by digit_value for characters that are not hex digits
+    ///
+    static const unsigned INVALID_DIGIT = 0xff;
+
+    ///
+    /// Table of hex digit values indexed by ASCII code; INVALID_DIGIT for anything else
+    ///
+    inline const unsigned char* digit_values() NOEXCEPT
+    {
+        static const struct DigitValueTable {
+            unsigned char values[128];
+            DigitValueTable() NOEXCEPT
+            {
+                for (unsigned character = 0; character < 128; ++character) {
+                    values[character] = static_cast<unsigned char>(
+                        (character >= '0' && character <= '9') ? character - '0' :
+                        (character >= 'a' && character <= 'f') ? character - 'a' + 10 :
+                        (character >= 'A' && character <= 'F') ? character - 'A' + 10 :
+                        INVALID_DIGIT);
+                }
+            }
+        } table;
+        return table.values;
+    }
+
+    ///
+    /// Value of a hex digit (either case), or INVALID_DIGIT
+    /// - characters outside ASCII index the (invalid) entry for '\0', so there is no branch
+    ///
+    template <typename CharT>
+    unsigned digit_value(CharT _character) NOEXCEPT
+    {
+        const unsigned code = static_cast<unsigned>(_character);
+        return digit_values()[code < 128 ? code : 0];
+    }
+
+    ///
+    /// Expands 16 bytes to 32 lower-case hex digits, high nibble first, without a terminator
+    /// - uses SSE2 where the compiler targets it (always on x64)
+    ///
+    inline void expand_16(_In_reads_(16) const unsigned char* _bytes, _Out_writes_(32) char* _hex) NOEXCEPT
+    {
+#ifdef NTL_HEX_SSE2
+        const __m128i input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_bytes));
+        const __m128i low_mask = _mm_set1_epi8(0x0f);
+        const __m128i high = _mm_and_si128(_mm_srli_epi16(input, 4), low_mask);
+        const __m128i low = _mm_and_si128(input, low_mask);
+        // nibble + '0', plus ('a' - '0' - 10) for nibbles above 9
+        const __m128i nine = _mm_set1_epi8(9);
+        const __m128i zero_char = _mm_set1_epi8('0');
+        const __m128i letter_offset = _mm_set1_epi8('a' - '0' - 10);
+        __m128i first = _mm_unpacklo_epi8(high, low);
+        __m128i second = _mm_unpackhi_epi8(high, low);
+        first = _mm_add_epi8(_mm_add_epi8(first, zero_char), _mm_and_si128(_mm_cmpgt_epi8(first, nine), letter_offset));
+        second = _mm_add_epi8(_mm_add_epi8(second, zero_char), _mm_and_si128(_mm_cmpgt_epi8(second, nine), letter_offset));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(_hex), first);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(_hex + 16), second);
+#else
+        static const char digits[] = "0123456789abcdef";
+        for (unsigned index = 0; index < 16; ++index) {
+            _hex[index * 2] = digits[_bytes[index] >> 4];
+            _hex[index * 2 + 1] = digits[_bytes[index] & 0x0f];
+        }
+#endif
+    }
+
+} // namespace Hex
+} // namespace ntl
@@ -0,0 +1,136 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#pragma once
+
+#include <algorithm>
+#include <vector>
+#include <math.h>
+
+#include <ntlException.hpp>
+
+namespace ntl {
+    ///
+    /// HyperLogLog
+    ///
+    /// Estimates the number of distinct values added, in 2^precision one byte registers
+    /// (Flajolet et al., with linear counting for small cardinalities)
+    /// - add() takes a 64 bit hash of the value, not the value: the hash must be well mixed,
+    ///   and must be the same function wherever sketches that will be merged are built
+    /// - the standard error is about 1.04 / sqrt(2^precision): 0.8% at precision 14 (16 KB)
+    /// - merge() takes the register-wise maximum, so merging sketches of overlapping sets
+    ///   counts each value once, in any order and any grouping
+    ///
+    class HyperLogLog {
+    public:
+        static const unsigned minimum_precision = 4;
+        static const unsigned maximum_precision = 18;
+
+        ///
+        /// Throws ntl::Exception if _precision is outside [minimum_precision, maximum_precision]
+        ///
+        explicit HyperLogLog(unsigned _precision = 14) :
+            register_precision(_precision)
+        {
+            if (_precision < minimum_precision || _precision > maximum_precision) {
+                throw Exception(ERROR_INVALID_PARAMETER, L"HyperLogLog - precision must be from 4 to 18", L"ntl::HyperLogLog", false);
+            }
+            registers.resize(static_cast<size_t>(1) << _precision);
+        }
+
+        void add(unsigned long long _hash) NOEXCEPT
+        {
+            // the top bits pick the register; the rank is the position of the first set bit in the rest
+            const size_t index = static_cast<size_t>(_hash >> (64 - register_precision));
+            unsigned long long remaining = _hash << register_precision;
+            const unsigned char maximum_rank = static_cast<unsigned char>(64 - register_precision + 1);
+            unsigned char rank = 1;
+            while (rank < maximum_rank && (remaining & 0x8000000000000000ull) == 0) {
+                remaining <<= 1;
+                ++rank;
+            }
+            if (rank > registers[index]) {
+                registers[index] = rank;
+            }
+        }
+
+        ///
+        /// Adds every value counted by _other
+        /// - throws ntl::Exception if the precisions differ
+        ///
+        void merge(const HyperLogLog& _other)
+        {
+            if (_other.register_precision != register_precision) {
+                throw Exception(ERROR_INVALID_PARAMETER, L"HyperLogLog::merge - precisions differ", L"ntl::HyperLogLog", false);
+            }
+            for (size_t i = 0; i < registers.size(); ++i) {
+                if (_other.registers[i] > registers[i]) {
+                    registers[i] = _other.registers[i];
+                }
+            }
+        }
+
+        ///
+        /// Estimated number of distinct values added; 0 if none were
+        ///
+        double estimate() const NOEXCEPT
+        {
+            const double m = static_cast<double>(registers.size());
+            double sum = 0.0;
+            size_t zeros = 0;
+            for (unsigned char rank : registers) {
+                sum += ::ldexp(1.0, -static_cast<int>(rank));
+                if (rank == 0) {
+                    ++zeros;
+                }
+            }
+            const double alpha = 0.7213 / (1.0 + 1.079 / m);
+            const double raw = alpha * m * m / sum;
+            // with 64 bit hashes there are no collisions to correct for at the top of the range
+            if (raw <= 2.5 * m && zeros > 0) {
+                return m * ::log(m / static_cast<double>(zeros));
+            }
+            return raw;
+        }
+
+        void reset() NOEXCEPT
+        {
+            std::fill(registers.begin(), registers.end(), static_cast<unsigned char>(0));
+        }
+
+        unsigned precision() const NOEXCEPT
+        {
+            return register_precision;
+        }
+
+        ///
+        /// The registers, to serialize the sketch: 2^precision ranks from 0 to 65 - precision
+        ///
+        const std::vector<unsigned char>& register_values() const NOEXCEPT
+        {
+            return registers;
+        }
+
+        ///
+        /// Replaces the registers with ones saved from a sketch of the same precision
+        /// - throws ntl::Exception if the count or a rank is out of range
+        ///
+        void load_registers(_In_reads_(_count) const unsigned char* _registers, size_t _count)
+        {
+            if (_count != registers.size()) {
+                throw Exception(ERROR_INVALID_PARAMETER, L"HyperLogLog::load_registers - register count does not match the precision", L"ntl::HyperLogLog", false);
+            }
+            const unsigned char maximum_rank = static_cast<unsigned char>(64 - register_precision + 1);
+            for (size_t i = 0; i < _count; ++i) {
+                if (_registers[i] > maximum_rank) {
+                    throw Exception(ERROR_INVALID_DATA, L"HyperLogLog::load_registers - rank out of range", L"ntl::HyperLogLog", false);
+                }
+            }
+            registers.assign(_registers, _registers + _count);
+        }
+
+    private:
+        unsigned register_precision;
+        std::vector<unsigned char> registers;
+    };
+}
@@ -143,6 +143,59 @@ namespace ntl {
         PrioritizedCriticalSection& prioritized_cs;
     };
 
+    ///
+    /// RAII for an SRW lock held shared (AutoReleaseSharedSRWLock) or exclusive (AutoReleaseExclusiveSRWLock)
+    /// - SRW locks are not recursive: a thread must not take one it already holds
+    ///
+    class AutoReleaseSharedSRWLock {
+    public:
+        _Acquires_shared_lock_(*this->srwlock)
+        explicit AutoReleaseSharedSRWLock(_In_ SRWLOCK* _srwlock) NOEXCEPT :
+            srwlock(_srwlock)
+        {
+            ::AcquireSRWLockShared(this->srwlock);
+        }
+
+        _Releases_shared_lock_(*this->srwlock)
+        ~AutoReleaseSharedSRWLock() NOEXCEPT
+        {
+            ::ReleaseSRWLockShared(this->srwlock);
+        }
+
+        /// no default c'tor
+        AutoReleaseSharedSRWLock() = delete;
+        /// non-copyable
+        AutoReleaseSharedSRWLock(const AutoReleaseSharedSRWLock&) = delete;
+        AutoReleaseSharedSRWLock operator=(const AutoReleaseSharedSRWLock&) = delete;
+
+    private:
+        SRWLOCK* srwlock = nullptr;
+    };
+    class AutoReleaseExclusiveSRWLock {
+    public:
+        _Acquires_exclusive_lock_(*this->srwlock)
+        explicit AutoReleaseExclusiveSRWLock(_In_ SRWLOCK* _srwlock) NOEXCEPT :
+            srwlock(_srwlock)
+        {
+            ::AcquireSRWLockExclusive(this->srwlock);
+        }
+
+        _Releases_exclusive_lock_(*this->srwlock)
+        ~AutoReleaseExclusiveSRWLock() NOEXCEPT
+        {
+            ::ReleaseSRWLockExclusive(this->srwlock);
+        }
+
+        /// no default c'tor
+        AutoReleaseExclusiveSRWLock() = delete;
+        /// non-copyable
+        AutoReleaseExclusiveSRWLock(const AutoReleaseExclusiveSRWLock&) = delete;
+        AutoReleaseExclusiveSRWLock operator=(const AutoReleaseExclusiveSRWLock&) = delete;
+
+    private:
+        SRWLOCK* srwlock = nullptr;
+    };
+
     //////////////////////////////////////////////////////////////////////////////////////////
     ///
     /// Can concurrent-safely read from both const and non-const
@@ -1,9 +1,13 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // Licensed under the MIT License. See License.txt in the project root for license information.
 
+#pragma once
+
 #include <tuple>
+#include <utility>
 #include <vector>
 #include <numeric>
+#include <algorithm>
 #include <math.h>
 
 #include <ntlException.hpp>
@@ -146,4 +150,405 @@ namespace ntl {
             median,
             higher_quartile);
     }
+
+    ///
+    /// RunningStatistics
+    ///
+    /// Welford's online algorithm for the mean and sampled variance of an unbounded stream
+    /// - constant memory, numerically stable, and mergeable (Chan et al.) so per-thread
+    ///   or per-interval instances can be combined without revisiting the samples
+    ///
+    /// standard_deviation_range() returns the same tuple as SampledStandardDeviation:
+    ///   get<0> : the mean minus one standard deviation
+    ///   get<1> : the mean value
+    ///   get<2> : the mean plus one standard deviation
+    ///
+    class RunningStatistics {
+    public:
+        void add(double _value) NOEXCEPT
+        {
+            ++sample_count;
+            double delta = _value - running_mean;
+            running_mean += delta / static_cast<double>(sample_count);
+            sum_of_squares += delta * (_value - running_mean);
+            if (sample_count == 1 || _value < min_value) {
+                min_value = _value;
+            }
+            if (sample_count == 1 || _value > max_value) {
+                max_value = _value;
+            }
+        }
+
+        void merge(const RunningStatistics& _other) NOEXCEPT
+        {
+            if (_other.sample_count == 0) {
+                return;
+            }
+            if (sample_count == 0) {
+                *this = _other;
+                return;
+            }
+
+            double total = static_cast<double>(sample_count + _other.sample_count);
+            double delta = _other.running_mean - running_mean;
+            running_mean += delta * static_cast<double>(_other.sample_count) / total;
+            sum_of_squares += _other.sum_of_squares +
+                delta * delta * static_cast<double>(sample_count) * static_cast<double>(_other.sample_count) / total;
+            sample_count += _other.sample_count;
+            min_value = (std::min)(min_value, _other.min_value);
+            max_value = (std::max)(max_value, _other.max_value);
+        }
+
+        void reset() NOEXCEPT
+        {
+            *this = RunningStatistics();
+        }
+
+        unsigned long long count() const NOEXCEPT
+        {
+            return sample_count;
+        }
+        double mean() const NOEXCEPT
+        {
+            return running_mean;
+        }
+        double minimum() const NOEXCEPT
+        {
+            return min_value;
+        }
+        double maximum() const NOEXCEPT
+        {
+            return max_value;
+        }
+        // sampled (n - 1) variance, matching SampledStandardDeviation
+        double variance() const NOEXCEPT
+        {
+            return (sample_count < 2) ? 0.0 : sum_of_squares / static_cast<double>(sample_count - 1);
+        }
+        double standard_deviation() const NOEXCEPT
+        {
+            return std::sqrt(variance());
+        }
+
+        std::tuple<double, double, double> standard_deviation_range() const NOEXCEPT
+        {
+            if (sample_count < 2) {
+                return std::make_tuple(0.0, 0.0, 0.0);
+            }
+            double stdev = standard_deviation();
+            return std::make_tuple(
+                running_mean - stdev,
+                running_mean,
+                running_mean + stdev);
+        }
+
+    private:
+        unsigned long long sample_count = 0;
+        double running_mean = 0.0;
+        double sum_of_squares = 0.0;
+        double min_value = 0.0;
+        double max_value = 0.0;
+    };
+
+    ///
+    /// ExponentialMovingAverage
+    ///
+    /// Exponentially weighted mean and variance of a stream
+    /// - _alpha is the weight of the newest sample (0 < alpha <= 1)
+    /// - the first sample seeds the mean with a variance of zero
+    ///
+    class ExponentialMovingAverage {
+    public:
+        explicit ExponentialMovingAverage(double _alpha) NOEXCEPT :
+            alpha(_alpha)
+        {
+        }
+
+        void add(double _value) NOEXCEPT
+        {
+            if (!initialized) {
+                ewma_mean = _value;
+                ewma_variance = 0.0;
+                initialized = true;
+                return;
+            }
+            double delta = _value - ewma_mean;
+            double increment = alpha * delta;
+            ewma_mean += increment;
+            ewma_variance = (1.0 - alpha) * (ewma_variance + delta * increment);
+        }
+
+        void reset() NOEXCEPT
+        {
+            ewma_mean = 0.0;
+            ewma_variance = 0.0;
+            initialized = false;
+        }
+
+        bool has_value() const NOEXCEPT
+        {
+            return initialized;
+        }
+        double mean() const NOEXCEPT
+        {
+            return ewma_mean;
+        }
+        double variance() const NOEXCEPT
+        {
+            return ewma_variance;
+        }
+        double standard_deviation() const NOEXCEPT
+        {
+            return std::sqrt(ewma_variance);
+        }
+
+    private:
+        double alpha;
+        double ewma_mean = 0.0;
+        double ewma_variance = 0.0;
+        bool initialized = false;
+    };
+
+    ///
+    /// TDigest
+    ///
+    /// Merging t-digest (Dunning & Ertl) for streaming quantile estimates
+    /// - memory is bounded by the compression factor: at most ~2 * compression centroids
+    ///   plus a fixed-size buffer of unmerged samples
+    /// - accuracy is highest in the tails (p1, p99) where the k1 scale function keeps centroids small
+    /// - digests are mergeable, so per-interval digests can be rolled into a lifetime digest
+    ///
+    /// interquartile_range() returns the same tuple as InterquartileRange:
+    ///   get<0> : quartile 1 (the 25% mark)
+    ///   get<1> : quartile 2 (the median value)
+    ///   get<2> : quartile 3 (the 75% mark)
+    ///
+    class TDigest {
+    public:
+        explicit TDigest(double _compression = 100.0) :
+            compression(_compression),
+            buffer_limit(static_cast<size_t>(_compression) * 5)
+        {
+            centroids.reserve(static_cast<size_t>(_compression) * 2);
+            buffer.reserve(buffer_limit);
+        }
+
+        void add(double _value, double _weight = 1.0)
+        {
+            if (_weight <= 0.0) {
+                return;
+            }
+            if (total_weight + unmerged_weight == 0.0 || _value < min_value) {
+                min_value = _value;
+            }
+            if (total_weight + unmerged_weight == 0.0 || _value > max_value) {
+                max_value = _value;
+            }
+            buffer.push_back(Centroid{ _value, _weight });
+            unmerged_weight += _weight;
+            if (buffer.size() >= buffer_limit) {
+                compress();
+            }
+        }
+
+        ///
+        /// Adds the samples of _other; merging a digest into itself doubles its weight
+        ///
+        void merge(const TDigest& _other)
+        {
+            if (_other.count() == 0.0) {
+                return;
+            }
+            _other.compress();
+            // copied first: add() can compress this digest, which is _other in a self-merge
+            const std::vector<Centroid> other_centroids(_other.centroids);
+            for (const auto& centroid : other_centroids) {
+                add(centroid.mean, centroid.weight);
+            }
+            // the other digest's extremes may be hidden inside its centroids
+            min_value = (std::min)(min_value, _other.min_value);
+            max_value = (std::max)(max_value, _other.max_value);
+        }
+
+        ///
+        /// The compressed centroids as { mean, weight } pairs, in order of mean
+        /// - with minimum() and maximum(), all merge_centroids() needs to rebuild the digest
+        ///   elsewhere, e.g. to write it to a file
+        ///
+        std::vector<std::pair<double, double>> centroid_values() const
+        {
+            compress();
+            std::vector<std::pair<double, double>> values;
+            values.reserve(centroids.size());
+            for (const auto& centroid : centroids) {
+                values.emplace_back(centroid.mean, centroid.weight);
+            }
+            return values;
+        }
+
+        ///
+        /// Merges a digest saved by centroid_values(), whose smallest and largest values were _minimum and _maximum
+        ///
+        void merge_centroids(const std::vector<std::pair<double, double>>& _centroids, double _minimum, double _maximum)
+        {
+            const double previous_count = count();
+            for (const auto& centroid : _centroids) {
+                add(centroid.first, centroid.second);
+            }
+            if (count() == previous_count) {
+                return;
+            }
+            min_value = (std::min)(min_value, _minimum);
+            max_value = (std::max)(max_value, _maximum);
+        }
+
+        void reset() NOEXCEPT
+        {
+            centroids.clear();
+            buffer.clear();
+            total_weight = 0.0;
+            unmerged_weight = 0.0;
+            min_value = 0.0;
+            max_value = 0.0;
+        }
+
+        double count() const NOEXCEPT
+        {
+            return total_weight + unmerged_weight;
+        }
+        double minimum() const NOEXCEPT
+        {
+            return min_value;
+        }
+        double maximum() const NOEXCEPT
+        {
+            return max_value;
+        }
+        double compression_factor() const NOEXCEPT
+        {
+            return compression;
+        }
+        size_t centroid_count() const
+        {
+            compress();
+            return centroids.size();
+        }
+
+        ///
+        /// Returns the estimated value at quantile _q [0.0, 1.0]
+        /// - returns 0 if no values have been added
+        ///
+        double quantile(double _q) const
+        {
+            compress();
+            if (centroids.empty()) {
+                return 0.0;
+            }
+            if (_q <= 0.0) {
+                return min_value;
+            }
+            if (_q >= 1.0) {
+                return max_value;
+            }
+            if (centroids.size() == 1) {
+                return centroids[0].mean;
+            }
+
+            // each centroid's mass is centered on its mean: interpolate between adjacent centers,
+            // and between the extreme centroids and the observed min/max at the edges
+            const double index = _q * total_weight;
+            const Centroid& first = centroids.front();
+            if (index < first.weight / 2.0) {
+                return min_value + (first.mean - min_value) * (index / (first.weight / 2.0));
+            }
+            const Centroid& last = centroids.back();
+            if (index > total_weight - last.weight / 2.0) {
+                double offset = total_weight - index;
+                return max_value - (max_value - last.mean) * (offset / (last.weight / 2.0));
+            }
+
+            double cumulative = first.weight / 2.0;
+            for (size_t i = 0; i + 1 < centroids.size(); ++i) {
+                double span = (centroids[i].weight + centroids[i + 1].weight) / 2.0;
+                if (cumulative + span > index) {
+                    double fraction = (index - cumulative) / span;
+                    return centroids[i].mean + fraction * (centroids[i + 1].mean - centroids[i].mean);
+                }
+                cumulative += span;
+            }
+            return last.mean;
+        }
+
+        std::tuple<double, double, double> interquartile_range() const
+        {
+            return std::make_tuple(
+                quantile(0.25),
+                quantile(0.50),
+                quantile(0.75));
+        }
+
+    private:
+        struct Centroid {
+            double mean;
+            double weight;
+        };
+
+        // k1 scale function and its inverse: maps a quantile to the 'centroid index' space
+        // where every centroid may span at most 1.0
+        double scale(double _q) const NOEXCEPT
+        {
+            return compression / (2.0 * Pi) * std::asin(2.0 * _q - 1.0);
+        }
+        double scale_inverse(double _k) const NOEXCEPT
+        {
+            return (std::sin(_k * (2.0 * Pi) / compression) + 1.0) / 2.0;
+        }
+
+        // merges the unmerged buffer into the centroids in one sorted pass
+        void compress() const
+        {
+            if (buffer.empty()) {
+                return;
+            }
+
+            buffer.insert(buffer.end(), centroids.begin(), centroids.end());
+            std::sort(buffer.begin(), buffer.end(),
+                [](const Centroid& _lhs, const Centroid& _rhs) { return _lhs.mean < _rhs.mean; });
+
+            total_weight += unmerged_weight;
+            unmerged_weight = 0.0;
+            centroids.clear();
+
+            double weight_so_far = 0.0;
+            double limit = total_weight * scale_inverse(scale(0.0) + 1.0);
+            Centroid current = buffer[0];
+            for (size_t i = 1; i < buffer.size(); ++i) {
+                const Centroid& next = buffer[i];
+                if (weight_so_far + current.weight + next.weight <= limit) {
+                    // fold into the current centroid: weighted mean
+                    current.weight += next.weight;
+                    current.mean += (next.mean - current.mean) * next.weight / current.weight;
+                } else {
+                    weight_so_far += current.weight;
+                    centroids.push_back(current);
+                    limit = total_weight * scale_inverse(scale(weight_so_far / total_weight) + 1.0);
+                    current = next;
+                }
+            }
+            centroids.push_back(current);
+            buffer.clear();
+        }
+
+        static constexpr double Pi = 3.14159265358979323846;
+
+        double compression;
+        size_t buffer_limit;
+        // compress() is logically const: it only changes the representation, not the distribution
+        mutable std::vector<Centroid> centroids;
+        mutable std::vector<Centroid> buffer;
+        mutable double total_weight = 0.0;
+        mutable double unmerged_weight = 0.0;
+        double min_value = 0.0;
+        double max_value = 0.0;
+    };
 }
\ No newline at end of file
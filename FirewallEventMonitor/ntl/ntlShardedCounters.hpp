@@ -0,0 +1,150 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#pragma once
+
+#include <Windows.h>
+#include <malloc.h>
+
+#include <atomic>
+#include <new>
+
+#include <ntlException.hpp>
+
+namespace ntl {
+    ///
+    /// ShardedCounters
+    ///
+    /// A fixed set of Count counters kept once per processor, each processor's set in its own
+    /// cache lines, so counting from several threads never bounces a line between processors
+    /// - add() touches only the shard it is given: typically the processor that produced the
+    ///   work (e.g. EtwRecord::getProcessorNumber()), or add_current() for the processor the
+    ///   calling thread runs on. Shards are atomic, so a shard shared by two threads (more
+    ///   processors than shards, or a thread moved between processors) still counts exactly
+    /// - sum() adds up every shard when read, so reads cost one pass over the shards and are
+    ///   meant for reports rather than for every event. A sum is not a snapshot: counts added
+    ///   while it is being read may or may not be included
+    ///
+    template <size_t Count>
+    class ShardedCounters {
+    public:
+        static const size_t cache_line_bytes = 64;
+
+        ///
+        /// One shard per active processor by default, rounded up to a power of two
+        ///
+        explicit ShardedCounters(size_t _shards = default_shards())
+        : shard_count(round_up_power_of_two(_shards))
+        {
+            storage = static_cast<char*>(::_aligned_malloc(shard_count * shard_bytes, cache_line_bytes));
+            if (storage == nullptr) {
+                throw std::bad_alloc();
+            }
+            for (size_t shard = 0; shard < shard_count; ++shard) {
+                for (size_t counter = 0; counter < Count; ++counter) {
+                    new (&values(shard)[counter]) std::atomic<unsigned long long>(0);
+                }
+            }
+        }
+
+        ~ShardedCounters() NOEXCEPT
+        {
+            // std::atomic of an integer is trivially destructible.
+            ::_aligned_free(storage);
+        }
+
+        ///
+        /// Adds _value to _counter in the shard of _shard (any value; it is reduced to a shard)
+        /// - returns the shard's new value of the counter
+        ///
+        unsigned long long add(size_t _shard, size_t _counter, unsigned long long _value = 1) NOEXCEPT
+        {
+            return values(_shard & (shard_count - 1))[_counter].fetch_add(_value, std::memory_order_relaxed) + _value;
+        }
+
+        ///
+        /// Adds _value to _counter in the shard of the processor the calling thread is running on
+        ///
+        unsigned long long add_current(size_t _counter, unsigned long long _value = 1) NOEXCEPT
+        {
+            return add(::GetCurrentProcessorNumber(), _counter, _value);
+        }
+
+        ///
+        /// Sum of _counter across every shard
+        ///
+        unsigned long long sum(size_t _counter) const NOEXCEPT
+        {
+            unsigned long long total = 0;
+            for (size_t shard = 0; shard < shard_count; ++shard) {
+                total += values(shard)[_counter].load(std::memory_order_relaxed);
+            }
+            return total;
+        }
+
+        ///
+        /// Sets _counter to zero in the shard of _shard, returning what it held
+        ///
+        unsigned long long take(size_t _shard, size_t _counter) NOEXCEPT
+        {
+            return values(_shard & (shard_count - 1))[_counter].exchange(0, std::memory_order_relaxed);
+        }
+
+        ///
+        /// Sets _counter to zero in every shard, returning the sum it held
+        /// - counts added meanwhile land either in the sum returned or after the reset, never both
+        ///
+        unsigned long long take_all(size_t _counter) NOEXCEPT
+        {
+            unsigned long long total = 0;
+            for (size_t shard = 0; shard < shard_count; ++shard) {
+                total += take(shard, _counter);
+            }
+            return total;
+        }
+
+        size_t shards() const NOEXCEPT
+        {
+            return shard_count;
+        }
+
+        ///
+        /// Active processors in every processor group, at most max_default_shards
+        ///
+        static size_t default_shards() NOEXCEPT
+        {
+            DWORD processors = ::GetActiveProcessorCount(ALL_PROCESSOR_GROUPS);
+            if (processors == 0) {
+                processors = 1;
+            }
+            return processors < max_default_shards ? processors : max_default_shards;
+        }
+
+        ShardedCounters(ShardedCounters const&) = delete;
+        ShardedCounters& operator=(ShardedCounters const&) = delete;
+
+    private:
+        // ETW numbers processors with a UCHAR; more shards would never be picked by it.
+        static const size_t max_default_shards = 256;
+        // Each shard's counters, padded to whole cache lines.
+        static const size_t shard_bytes =
+            (sizeof(std::atomic<unsigned long long>) * Count + cache_line_bytes - 1) / cache_line_bytes * cache_line_bytes;
+
+        const size_t shard_count;
+        char* storage = nullptr;
+
+        std::atomic<unsigned long long>* values(size_t _shard) const NOEXCEPT
+        {
+            return reinterpret_cast<std::atomic<unsigned long long>*>(storage + _shard * shard_bytes);
+        }
+
+        static size_t round_up_power_of_two(size_t _value) NOEXCEPT
+        {
+            size_t rounded = 1;
+            while (rounded < _value) {
+                rounded <<= 1;
+            }
+            return rounded;
+        }
+    };
+}
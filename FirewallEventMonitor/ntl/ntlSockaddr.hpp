@@ -14,6 +14,7 @@
 // ntl headers
 #include "ntlVersionConversion.hpp"
 #include "ntlException.hpp"
+#include "ntlHex.hpp"
 #include "ntlScopeGuard.hpp"
 
 #pragma prefast(push)
@@ -601,6 +602,295 @@ namespace ntl {
         return const_cast<IN6_ADDR*>(&(addr_in6->sin6_addr));
     }
 
+    ////////////////////////////////////////////////////////////////////////////////
+    ///
+    /// Allocation-free address text conversion
+    ///
+    /// format_ipv4 / format_ipv6 write the text form of an address into the caller's
+    ///   buffer and return the number of characters written, not counting the null
+    ///   terminator, or 0 if the buffer is too small.
+    ///   IPv6 follows RFC 5952: lower-case hex, no leading zeros, the longest run of two
+    ///   or more zero groups (the first, on a tie) compressed to "::", and v4-mapped
+    ///   addresses written as ::ffff:a.b.c.d.
+    ///
+    /// parse_ipv4 / parse_ipv6 accept the same text as inet_pton: dotted decimal without
+    ///   leading zeros, and RFC 4291 IPv6 text, optionally ending in dotted decimal.
+    ///   The address is only written on success.
+    ///
+    /// Octets are converted through a lookup table; IPv6 hex digits are expanded 16
+    ///   bytes at a time (ntl::Hex::expand_16).
+    ///
+    ////////////////////////////////////////////////////////////////////////////////
+    static const size_t IPV4_STRING_MAX_LENGTH = 16; // "255.255.255.255" + null
+    static const size_t IPV6_STRING_MAX_LENGTH = 46; // INET6_ADDRSTRLEN
+
+    namespace details {
+        struct DecimalOctet {
+            char digits[3];
+            unsigned char length;
+        };
+
+        inline const DecimalOctet* decimal_octets() NOEXCEPT
+        {
+            static const struct DecimalOctetTable {
+                DecimalOctet octets[256];
+                DecimalOctetTable() NOEXCEPT
+                {
+                    for (unsigned value = 0; value < 256; ++value) {
+                        DecimalOctet& octet = octets[value];
+                        if (value >= 100) {
+                            octet.digits[0] = static_cast<char>('0' + value / 100);
+                            octet.digits[1] = static_cast<char>('0' + (value / 10) % 10);
+                            octet.digits[2] = static_cast<char>('0' + value % 10);
+                            octet.length = 3;
+                        } else if (value >= 10) {
+                            octet.digits[0] = static_cast<char>('0' + value / 10);
+                            octet.digits[1] = static_cast<char>('0' + value % 10);
+                            octet.length = 2;
+                        } else {
+                            octet.digits[0] = static_cast<char>('0' + value);
+                            octet.length = 1;
+                        }
+                    }
+                }
+            } table;
+            return table.octets;
+        }
+
+        // writes "a.b.c.d" without a null terminator; returns the characters written (at most 15)
+        template <typename CharT>
+        size_t write_dotted_decimal(_In_reads_(4) const unsigned char* bytes, _Out_writes_(15) CharT* buffer) NOEXCEPT
+        {
+            const DecimalOctet* octets = decimal_octets();
+            CharT* position = buffer;
+            for (unsigned index = 0; index < 4; ++index) {
+                if (index != 0) {
+                    *position++ = static_cast<CharT>('.');
+                }
+                const DecimalOctet& octet = octets[bytes[index]];
+                for (unsigned digit = 0; digit < octet.length; ++digit) {
+                    *position++ = static_cast<CharT>(octet.digits[digit]);
+                }
+            }
+            return static_cast<size_t>(position - buffer);
+        }
+
+        template <typename CharT>
+        size_t copy_terminated(_In_reads_(length) const CharT* source, size_t length, _Out_writes_(buffer_length) CharT* buffer, size_t buffer_length) NOEXCEPT
+        {
+            if (buffer_length <= length) {
+                return 0;
+            }
+            for (size_t index = 0; index < length; ++index) {
+                buffer[index] = source[index];
+            }
+            buffer[length] = static_cast<CharT>('\0');
+            return length;
+        }
+    }
+
+    template <typename CharT>
+    size_t format_ipv4(const IN_ADDR& address, _Out_writes_(buffer_length) CharT* buffer, size_t buffer_length) NOEXCEPT
+    {
+        CharT text[IPV4_STRING_MAX_LENGTH];
+        const size_t length = details::write_dotted_decimal(reinterpret_cast<const unsigned char*>(&address), text);
+        return details::copy_terminated(text, length, buffer, buffer_length);
+    }
+
+    template <typename CharT>
+    size_t format_ipv6(const IN6_ADDR& address, _Out_writes_(buffer_length) CharT* buffer, size_t buffer_length) NOEXCEPT
+    {
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&address);
+        unsigned words[8];
+        for (unsigned index = 0; index < 8; ++index) {
+            words[index] = (static_cast<unsigned>(bytes[index * 2]) << 8) | bytes[index * 2 + 1];
+        }
+
+        CharT text[IPV6_STRING_MAX_LENGTH];
+        CharT* position = text;
+
+        // v4-mapped: ::ffff:a.b.c.d
+        if (words[0] == 0 && words[1] == 0 && words[2] == 0 && words[3] == 0 && words[4] == 0 && words[5] == 0xffff) {
+            static const char prefix[] = "::ffff:";
+            for (unsigned index = 0; index < sizeof(prefix) - 1; ++index) {
+                *position++ = static_cast<CharT>(prefix[index]);
+            }
+            position += details::write_dotted_decimal(bytes + 12, position);
+            return details::copy_terminated(text, static_cast<size_t>(position - text), buffer, buffer_length);
+        }
+
+        // the longest run of at least two zero groups; the first one wins a tie
+        unsigned run_start = 8;
+        unsigned run_length = 1;
+        for (unsigned index = 0; index < 8;) {
+            if (words[index] != 0) {
+                ++index;
+                continue;
+            }
+            unsigned end = index;
+            while (end < 8 && words[end] == 0) {
+                ++end;
+            }
+            if (end - index > run_length) {
+                run_start = index;
+                run_length = end - index;
+            }
+            index = end;
+        }
+
+        char hex[32];
+        Hex::expand_16(bytes, hex);
+
+        for (unsigned index = 0; index < 8; ++index) {
+            if (index == run_start) {
+                *position++ = static_cast<CharT>(':');
+                *position++ = static_cast<CharT>(':');
+                index += run_length - 1;
+                continue;
+            }
+            if (index != 0 && index != run_start + run_length) {
+                *position++ = static_cast<CharT>(':');
+            }
+            const unsigned digits =
+                (words[index] >= 0x1000) ? 4 :
+                (words[index] >= 0x100) ? 3 :
+                (words[index] >= 0x10) ? 2 : 1;
+            const char* word_hex = hex + index * 4 + (4 - digits);
+            for (unsigned digit = 0; digit < digits; ++digit) {
+                *position++ = static_cast<CharT>(word_hex[digit]);
+            }
+        }
+        return details::copy_terminated(text, static_cast<size_t>(position - text), buffer, buffer_length);
+    }
+
+    template <typename CharT>
+    bool parse_ipv4(_In_reads_(length) const CharT* text, size_t length, _Out_ IN_ADDR* address) NOEXCEPT
+    {
+        unsigned char bytes[4];
+        unsigned octet_count = 0;
+        size_t position = 0;
+        while (octet_count < 4) {
+            const size_t start = position;
+            unsigned value = 0;
+            while (position < length && position - start < 3 && text[position] >= '0' && text[position] <= '9') {
+                value = value * 10 + static_cast<unsigned>(text[position] - '0');
+                ++position;
+            }
+            const size_t digits = position - start;
+            // no digits, a leading zero, or out of range
+            if (digits == 0 || (digits > 1 && text[start] == '0') || value > 255) {
+                return false;
+            }
+            bytes[octet_count++] = static_cast<unsigned char>(value);
+
+            if (octet_count < 4) {
+                if (position >= length || text[position] != '.') {
+                    return false;
+                }
+                ++position;
+            }
+        }
+        if (position != length) {
+            return false;
+        }
+        memcpy(address, bytes, sizeof(bytes));
+        return true;
+    }
+
+    template <typename CharT>
+    bool parse_ipv6(_In_reads_(length) const CharT* text, size_t length, _Out_ IN6_ADDR* address) NOEXCEPT
+    {
+        unsigned short words[8] = {};
+        unsigned count = 0;
+        int compress_at = -1;
+        size_t position = 0;
+
+        if (length >= 1 && text[0] == ':') {
+            if (length < 2 || text[1] != ':') {
+                return false;
+            }
+            compress_at = 0;
+            position = 2;
+        }
+
+        while (position < length) {
+            if (count == 8) {
+                return false;
+            }
+
+            const size_t start = position;
+            unsigned value = 0;
+            unsigned digit = 0;
+            while (position < length && position - start < 4 && (digit = Hex::digit_value(text[position])) != Hex::INVALID_DIGIT) {
+                value = (value << 4) | digit;
+                ++position;
+            }
+            if (position == start) {
+                return false;
+            }
+
+            if (position < length && text[position] == '.') {
+                // trailing dotted decimal fills the last two groups
+                IN_ADDR v4;
+                if (count > 6 || !parse_ipv4(text + start, length - start, &v4)) {
+                    return false;
+                }
+                const unsigned char* v4_bytes = reinterpret_cast<const unsigned char*>(&v4);
+                words[count++] = static_cast<unsigned short>((v4_bytes[0] << 8) | v4_bytes[1]);
+                words[count++] = static_cast<unsigned short>((v4_bytes[2] << 8) | v4_bytes[3]);
+                position = length;
+                break;
+            }
+            if (position < length && Hex::digit_value(text[position]) != Hex::INVALID_DIGIT) {
+                // more than four hex digits
+                return false;
+            }
+            words[count++] = static_cast<unsigned short>(value);
+
+            if (position == length) {
+                break;
+            }
+            if (text[position] != ':') {
+                return false;
+            }
+            ++position;
+            if (position < length && text[position] == ':') {
+                if (compress_at >= 0) {
+                    return false;
+                }
+                compress_at = static_cast<int>(count);
+                ++position;
+            } else if (position == length) {
+                // a single trailing ':'
+                return false;
+            }
+        }
+
+        unsigned short expanded[8] = {};
+        if (compress_at < 0) {
+            if (count != 8) {
+                return false;
+            }
+            std::copy(words, words + 8, expanded);
+        } else {
+            // "::" stands for at least one zero group
+            if (count > 7) {
+                return false;
+            }
+            const unsigned head = static_cast<unsigned>(compress_at);
+            std::copy(words, words + head, expanded);
+            std::copy(words + head, words + count, expanded + 8 - (count - head));
+        }
+
+        unsigned char bytes[16];
+        for (unsigned index = 0; index < 8; ++index) {
+            bytes[index * 2] = static_cast<unsigned char>(expanded[index] >> 8);
+            bytes[index * 2 + 1] = static_cast<unsigned char>(expanded[index] & 0xff);
+        }
+        memcpy(address, bytes, sizeof(bytes));
+        return true;
+    }
+
 }; // namespace ntl
 
 #pragma prefast(pop)
@@ -0,0 +1,418 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+#include <utility>
+
+#include <ntlException.hpp>
+
+namespace ntl {
+    ///
+    /// TimerWheel
+    ///
+    /// Hierarchical timer wheel over an externally supplied clock of integer ticks
+    /// (e.g. seconds of event time rather than wall clock time)
+    /// - four levels of 64 slots cover 2^24 ticks ahead of the current tick; timers further
+    ///   out wait in an overflow list. A timer is placed by how far ahead it is, and moved
+    ///   down a level (cascaded) when the wheel reaches the start of its slot
+    /// - schedule(), cancel() and reschedule() are O(1): timers are nodes of intrusive lists
+    ///   in one pool, addressed by a timer_id that goes stale once the timer has expired
+    ///   or been cancelled (so owners can keep it and cancel blindly)
+    /// - advance() takes a budget of work (expirations, cascaded timers and ticks visited).
+    ///   Once it is spent, the wheel stops where it is and the next advance() resumes, so
+    ///   expiring a million timers at once is spread over many calls instead of one pause.
+    ///   Timers are never expired early, only late by the lag (see lag())
+    /// - runs of ticks with no timers due are skipped a level at a time, so a jump in the
+    ///   clock costs little
+    /// - the expiry callback may schedule, cancel or reschedule timers on the same wheel
+    /// - T must be default constructible and copyable
+    ///
+    template <typename T>
+    class TimerWheel {
+    public:
+        typedef unsigned long long timer_id;
+
+        static const timer_id invalid_timer = 0;
+        static const size_t unlimited = static_cast<size_t>(-1);
+
+        TimerWheel()
+        {
+            // Each list starts as an empty circle through its sentinel node.
+            nodes.resize(list_count);
+            for (unsigned long list = 0; list < list_count; ++list) {
+                nodes[list].next = list;
+                nodes[list].prev = list;
+                nodes[list].list = list;
+            }
+        }
+
+        ///
+        /// Schedules _value to expire once the wheel advances to _tick
+        /// - ticks at or before the current tick expire on the next advance
+        ///
+        timer_id schedule(long long _tick, const T& _value)
+        {
+            if (!started) {
+                current_tick = _tick - 1;
+                target_tick = current_tick;
+                started = true;
+            }
+
+            unsigned long index;
+            if (free_head != no_node) {
+                index = free_head;
+                free_head = nodes[index].next;
+            } else {
+                index = static_cast<unsigned long>(nodes.size());
+                nodes.emplace_back();
+                nodes[index].generation = 1;
+            }
+
+            node& timer = nodes[index];
+            timer.tick = _tick;
+            timer.value = _value;
+            place(index);
+            ++scheduled;
+            return make_id(index, timer.generation);
+        }
+
+        ///
+        /// Removes the timer; false if it has already expired or been cancelled
+        ///
+        bool cancel(timer_id _id) NOEXCEPT
+        {
+            unsigned long index;
+            if (!find(_id, &index)) {
+                return false;
+            }
+            unlink(index);
+            release(index);
+            --scheduled;
+            return true;
+        }
+
+        ///
+        /// Moves the timer to expire at _tick instead; false if it has already expired
+        /// or been cancelled. Keeps its timer_id.
+        ///
+        bool reschedule(timer_id _id, long long _tick) NOEXCEPT
+        {
+            unsigned long index;
+            if (!find(_id, &index)) {
+                return false;
+            }
+            unlink(index);
+            nodes[index].tick = _tick;
+            place(index);
+            return true;
+        }
+
+        ///
+        /// Moves the wheel forward to _tick, invoking _expired(value) for every value due,
+        /// until _budget units of work are spent
+        /// - ticks behind the target already given are ignored
+        /// - returns the number of values expired
+        ///
+        template <typename Function>
+        size_t advance(long long _tick, Function _expired, size_t _budget = unlimited)
+        {
+            if (!started) {
+                current_tick = _tick;
+                target_tick = _tick;
+                started = true;
+                return 0;
+            }
+            if (_tick > target_tick) {
+                target_tick = _tick;
+            }
+
+            size_t expired = 0;
+            for (;;) {
+                // Timers already due, then the slots reached by the last step.
+                unsigned long index = no_node;
+                bool expire = true;
+                if (!empty(due_list)) {
+                    index = nodes[due_list].next;
+                } else if (next_pending < pending_count) {
+                    pending_slot& pending = pending_slots[next_pending];
+                    if (pending.remaining == 0 || empty(pending.list)) {
+                        ++next_pending;
+                        continue;
+                    }
+                    index = nodes[pending.list].next;
+                    // Level 0 slots hold timers due now; the others, timers to cascade.
+                    expire = pending.list < slots_per_level;
+                } else if (current_tick >= target_tick) {
+                    break;
+                }
+
+                if (!spend(&_budget)) {
+                    break;
+                }
+                if (index != no_node && nodes[index].list != due_list) {
+                    --pending_slots[next_pending].remaining;
+                }
+
+                if (index == no_node) {
+                    step();
+                } else if (expire) {
+                    unlink(index);
+                    // The node can be reused (and the pool moved) by the callback.
+                    T value = std::move(nodes[index].value);
+                    release(index);
+                    --scheduled;
+                    ++expired;
+                    _expired(value);
+                } else {
+                    // Within reach of a lower level now.
+                    unlink(index);
+                    place(index);
+                }
+            }
+            return expired;
+        }
+
+        ///
+        /// Ticks the wheel is behind the latest advance() because its budget ran out
+        ///
+        long long lag() const NOEXCEPT
+        {
+            return target_tick - current_tick;
+        }
+
+        long long current() const NOEXCEPT
+        {
+            return current_tick;
+        }
+
+        size_t size() const NOEXCEPT
+        {
+            return scheduled;
+        }
+
+        ///
+        /// Cancels every timer. The nodes are kept for reuse, so generations keep increasing
+        /// and the ids of the cleared timers stay stale.
+        ///
+        void clear() NOEXCEPT
+        {
+            for (unsigned long list = 0; list < list_count; ++list) {
+                nodes[list].next = list;
+                nodes[list].prev = list;
+            }
+            list_counts.assign(list_count, 0);
+            for (auto& count : level_counts) {
+                count = 0;
+            }
+            free_head = no_node;
+            for (unsigned long index = static_cast<unsigned long>(nodes.size()); index-- > list_count;) {
+                node& timer = nodes[index];
+                if (timer.list != no_node) {
+                    timer.list = no_node;
+                    timer.value = T{};
+                    ++timer.generation;
+                }
+                timer.next = free_head;
+                free_head = index;
+            }
+            overflow_floor = (std::numeric_limits<long long>::max)();
+            pending_count = 0;
+            next_pending = 0;
+            scheduled = 0;
+            started = false;
+        }
+
+        TimerWheel(const TimerWheel&) = delete;
+        TimerWheel& operator=(const TimerWheel&) = delete;
+
+    private:
+        static const unsigned long slot_bits = 6;
+        static const unsigned long slots_per_level = 1ul << slot_bits;
+        static const unsigned long level_count = 4;
+        // Lists: the slots of each level, then the overflow and due lists.
+        static const unsigned long overflow_list = level_count * slots_per_level;
+        static const unsigned long due_list = overflow_list + 1;
+        static const unsigned long list_count = overflow_list + 2;
+        static const unsigned long no_node = static_cast<unsigned long>(-1);
+
+        struct node {
+            long long tick = 0;
+            T value{};
+            unsigned long next = no_node;
+            unsigned long prev = no_node;
+            unsigned long list = no_node; // List the timer is in; no_node while free.
+            unsigned long generation = 0; // Bumped when the node is freed, so old ids go stale.
+        };
+
+        // A slot reached by the last step, and how many of its timers are still to be
+        // expired or cascaded. Timers added to it meanwhile belong to a later revolution.
+        struct pending_slot {
+            unsigned long list = 0;
+            size_t remaining = 0;
+        };
+
+        // Sentinels of every list, then the timers.
+        std::vector<node> nodes;
+        unsigned long free_head = no_node;
+        // Timers in each slot and list.
+        std::vector<size_t> list_counts = std::vector<size_t>(list_count, 0);
+        // Timers in each level, and in the overflow list; a level with none is skipped.
+        size_t level_counts[level_count + 1] = {};
+        // The level 0 slot of the current tick, plus any slots cascading at it.
+        pending_slot pending_slots[level_count + 1];
+        unsigned long pending_count = 0;
+        unsigned long next_pending = 0;
+        // No timer in the overflow list is due before this tick.
+        long long overflow_floor = (std::numeric_limits<long long>::max)();
+        long long current_tick = 0;
+        long long target_tick = 0;
+        size_t scheduled = 0;
+        bool started = false;
+
+        static timer_id make_id(unsigned long _index, unsigned long _generation) NOEXCEPT
+        {
+            return (static_cast<timer_id>(_generation) << 32) | _index;
+        }
+
+        bool find(timer_id _id, _Out_ unsigned long* _index) const NOEXCEPT
+        {
+            *_index = static_cast<unsigned long>(_id & 0xFFFFFFFFull);
+            return
+                *_index >= list_count &&
+                *_index < nodes.size() &&
+                nodes[*_index].list != no_node &&
+                nodes[*_index].generation == static_cast<unsigned long>(_id >> 32);
+        }
+
+        bool empty(unsigned long _list) const NOEXCEPT
+        {
+            return nodes[_list].next == _list;
+        }
+
+        static bool spend(_Inout_ size_t* _budget) NOEXCEPT
+        {
+            if (*_budget == 0) {
+                return false;
+            }
+            if (*_budget != unlimited) {
+                --*_budget;
+            }
+            return true;
+        }
+
+        static unsigned long level_of(unsigned long _list) NOEXCEPT
+        {
+            return _list < overflow_list ? _list / slots_per_level : level_count;
+        }
+
+        static unsigned long slot_list(unsigned long _level, unsigned long long _tick) NOEXCEPT
+        {
+            return _level * slots_per_level +
+                static_cast<unsigned long>((_tick >> (slot_bits * _level)) & (slots_per_level - 1));
+        }
+
+        // Puts the timer in the list for how far ahead of the current tick it is.
+        void place(unsigned long _index) NOEXCEPT
+        {
+            long long ahead = nodes[_index].tick - current_tick;
+            unsigned long list = overflow_list;
+            if (ahead >= (1ll << (slot_bits * level_count))) {
+                overflow_floor = (std::min)(overflow_floor, nodes[_index].tick);
+            } else if (ahead <= 0) {
+                list = due_list;
+            } else {
+                for (unsigned long level = 0; level < level_count; ++level) {
+                    if (ahead < (1ll << (slot_bits * (level + 1)))) {
+                        list = slot_list(level, static_cast<unsigned long long>(nodes[_index].tick));
+                        break;
+                    }
+                }
+            }
+
+            node& timer = nodes[_index];
+            timer.list = list;
+            timer.prev = nodes[list].prev;
+            timer.next = list;
+            nodes[timer.prev].next = _index;
+            nodes[list].prev = _index;
+            ++list_counts[list];
+            if (list != due_list) {
+                ++level_counts[level_of(list)];
+            }
+        }
+
+        void unlink(unsigned long _index) NOEXCEPT
+        {
+            node& timer = nodes[_index];
+            nodes[timer.prev].next = timer.next;
+            nodes[timer.next].prev = timer.prev;
+            --list_counts[timer.list];
+            if (timer.list != due_list) {
+                --level_counts[level_of(timer.list)];
+            }
+            timer.list = no_node;
+        }
+
+        void release(unsigned long _index) NOEXCEPT
+        {
+            node& timer = nodes[_index];
+            timer.value = T{};
+            ++timer.generation;
+            timer.next = free_head;
+            free_head = _index;
+        }
+
+        // Moves the wheel one tick forward, or past a run of ticks with nothing due,
+        // and queues the slots reached.
+        void step() NOEXCEPT
+        {
+            // Below the lowest level holding timers, no slot is due and nothing cascades
+            // until that level's next slot boundary.
+            unsigned long long skip_mask = 0;
+            for (unsigned long level = 0; level <= level_count && level_counts[level] == 0; ++level) {
+                skip_mask = level < level_count ? (1ull << (slot_bits * (level + 1))) - 1 : ~0ull >> 1;
+            }
+            if (skip_mask != 0) {
+                long long skip_to = static_cast<long long>(static_cast<unsigned long long>(current_tick) | skip_mask);
+                const unsigned long long wrap_mask = (1ull << (slot_bits * level_count)) - 1;
+                if (skip_mask == wrap_mask) {
+                    // Only the overflow list holds timers: skip to the last boundary before the first of them.
+                    long long floor_to = static_cast<long long>(static_cast<unsigned long long>(overflow_floor) & ~wrap_mask) - 1;
+                    if (floor_to > skip_to) {
+                        skip_to = floor_to;
+                    }
+                }
+                if (skip_to > current_tick) {
+                    current_tick = skip_to < target_tick ? skip_to : target_tick;
+                    return;
+                }
+            }
+
+            ++current_tick;
+            unsigned long long tick = static_cast<unsigned long long>(current_tick);
+            pending_count = 0;
+            next_pending = 0;
+            // Slots whose start is this tick cascade first, highest level first, so their
+            // timers due now reach the due list before the level 0 slot is expired.
+            unsigned long cascading = 0;
+            while (cascading < level_count &&
+                ((tick >> (slot_bits * cascading)) & (slots_per_level - 1)) == 0) {
+                ++cascading;
+            }
+            for (unsigned long level = cascading; level > 0; --level) {
+                unsigned long list = level < level_count ? slot_list(level, tick) : overflow_list;
+                pending_slots[pending_count++] = { list, list_counts[list] };
+            }
+            if (cascading == level_count) {
+                // Found again as the overflow timers are placed.
+                overflow_floor = (std::numeric_limits<long long>::max)();
+            }
+            unsigned long list = slot_list(0, tick);
+            pending_slots[pending_count++] = { list, list_counts[list] };
+        }
+    };
+} // namespace ntl
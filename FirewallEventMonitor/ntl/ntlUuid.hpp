@@ -1,102 +1,209 @@
-// Copyright (c) Microsoft Corporation. All rights reserved.
-// Licensed under the MIT License. See License.txt in the project root for license information.
-
-#pragma once
-
-// CPP Headers
-#include <wchar.h>
-#include <string>
-#include <memory>
-
-// OS Headers
-#include <Windows.h>
-#include <Rpc.h>
-
-// ntl headers
-#include "ntlException.hpp"
-
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-////////////////////////////////////////////////////////////////////////////////////////////////////
-///
-/// UUID manipulation functions
-///
-/// Notice all functions are in the ntl::Uuid namespace
-///
-/// *** USE OF THESE FUNCTIONS REQUIRES LINKING TO $(SDK_LIB_PATH)\Rpcrt4.lib ***
-///
-////////////////////////////////////////////////////////////////////////////////////////////////////
-////////////////////////////////////////////////////////////////////////////////////////////////////
-
-
-namespace ntl {
-namespace Uuid {
-
-struct wszUuidDeleter {
-    void operator()(RPC_WSTR* wstrptr) const {
-        if (wstrptr)
-        {
-            ::RpcStringFreeW(wstrptr);
-        }
-    }
-};
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-///
-/// generate_uuid
-///
-/// Generates a new UUID in the form of a std::wstring in format "01234567-89ab-cdef-0123-456789abcdef"
-///
-/// Can throw ntl::Exception on failure from the underlying win32 generation function
-/// Can throw std::bad_alloc
-///
-////////////////////////////////////////////////////////////////////////////////////////////////////
-inline
-std::wstring generate_uuid()
-{
-    UUID tempUuid;
-    RPC_STATUS rpcStatus = ::UuidCreate(&tempUuid);
-    if (rpcStatus != RPC_S_OK) {
-        throw ntl::Exception(rpcStatus, L"::UuidCreate", L"ntl::Uuid::generate_uuid", false);
-    }
-
-    RPC_WSTR wszUuid = nullptr;
-    rpcStatus = ::UuidToStringW(&tempUuid, &wszUuid);
-    if (rpcStatus != RPC_S_OK) {
-        throw ntl::Exception(rpcStatus, L"::UuidToString", L"ntl::Uuid::generate_uuid", false);
-    }
-    // Make sure we free the UUID string (even if the wstring construction throws)
-    std::unique_ptr<RPC_WSTR, wszUuidDeleter> handle(&wszUuid);
-
-    return std::wstring(reinterpret_cast<wchar_t*>(wszUuid));
-}
-
-inline
-std::wstring uuid_to_string(_In_ UUID _guid)
-{
-    RPC_WSTR wszUuid = nullptr;
-    RPC_STATUS rpcStatus = ::UuidToStringW(&_guid, &wszUuid);
-    if (rpcStatus != RPC_S_OK) {
-        throw ntl::Exception(rpcStatus, L"::UuidToString", L"ntl::Uuid::uuid_to_string", false);
-    }
-    // Make sure we free the UUID string (even if the wstring construction throws)
-    std::unique_ptr<RPC_WSTR, wszUuidDeleter> handle(&wszUuid);
-
-    return std::wstring(reinterpret_cast<wchar_t*>(wszUuid));
-}
-inline
-UUID string_to_uuid(_In_ LPCWSTR _guid)
-{
-    // must be a non-const string for the first argument
-    UUID returned_uuid;
-    std::wstring string_uuid(_guid);
-    RPC_STATUS rpcStatus = ::UuidFromStringW(reinterpret_cast<RPC_WSTR>(&string_uuid[0]), &returned_uuid);
-    if (rpcStatus != RPC_S_OK) {
-        throw ntl::Exception(rpcStatus, L"::UuidFromStringW", L"ntl::Uuid::string_to_uuid", false);
-    }
-
-    return returned_uuid;
-}
-
-} // namespace Uuid
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See License.txt in the project root for license information.
+
+#pragma once
+
+// CPP Headers
+#include <wchar.h>
+#include <string>
+#include <memory>
+
+// OS Headers
+#include <Windows.h>
+#include <Rpc.h>
+
+// ntl headers
+#include "ntlException.hpp"
+#include "ntlHex.hpp"
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+///
+/// UUID manipulation functions
+///
+/// Notice all functions are in the ntl::Uuid namespace
+///
+/// *** USE OF THESE FUNCTIONS REQUIRES LINKING TO $(SDK_LIB_PATH)\Rpcrt4.lib ***
+///
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+
+namespace ntl {
+namespace Uuid {
+
+struct wszUuidDeleter {
+    void operator()(RPC_WSTR* wstrptr) const {
+        if (wstrptr)
+        {
+            ::RpcStringFreeW(wstrptr);
+        }
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+///
+/// generate_uuid
+///
+/// Generates a new UUID in the form of a std::wstring in format "01234567-89ab-cdef-0123-456789abcdef"
+///
+/// Can throw ntl::Exception on failure from the underlying win32 generation function
+/// Can throw std::bad_alloc
+///
+////////////////////////////////////////////////////////////////////////////////////////////////////
+inline
+std::wstring generate_uuid()
+{
+    UUID tempUuid;
+    RPC_STATUS rpcStatus = ::UuidCreate(&tempUuid);
+    if (rpcStatus != RPC_S_OK) {
+        throw ntl::Exception(rpcStatus, L"::UuidCreate", L"ntl::Uuid::generate_uuid", false);
+    }
+
+    RPC_WSTR wszUuid = nullptr;
+    rpcStatus = ::UuidToStringW(&tempUuid, &wszUuid);
+    if (rpcStatus != RPC_S_OK) {
+        throw ntl::Exception(rpcStatus, L"::UuidToString", L"ntl::Uuid::generate_uuid", false);
+    }
+    // Make sure we free the UUID string (even if the wstring construction throws)
+    std::unique_ptr<RPC_WSTR, wszUuidDeleter> handle(&wszUuid);
+
+    return std::wstring(reinterpret_cast<wchar_t*>(wszUuid));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+///
+/// format_uuid
+///
+/// Writes a UUID as "01234567-89ab-cdef-0123-456789abcdef" (the UuidToString form) plus a null
+///   terminator into the caller's buffer, which must hold UUID_STRING_LENGTH + 1 characters
+///
+/// Returns UUID_STRING_LENGTH, or 0 if the buffer is too small
+/// - all 16 bytes are expanded to hex at once (ntl::Hex::expand_16); no allocations
+///
+////////////////////////////////////////////////////////////////////////////////////////////////////
+static const size_t UUID_STRING_LENGTH = 36;
+
+template <typename CharT>
+size_t format_uuid(const UUID& _uuid, _Out_writes_(_buffer_length) CharT* _buffer, size_t _buffer_length) NOEXCEPT
+{
+    if (_buffer_length < UUID_STRING_LENGTH + 1) {
+        return 0;
+    }
+
+    // the text form is big-endian for the first three fields
+    const unsigned char bytes[16] = {
+        static_cast<unsigned char>(_uuid.Data1 >> 24),
+        static_cast<unsigned char>(_uuid.Data1 >> 16),
+        static_cast<unsigned char>(_uuid.Data1 >> 8),
+        static_cast<unsigned char>(_uuid.Data1),
+        static_cast<unsigned char>(_uuid.Data2 >> 8),
+        static_cast<unsigned char>(_uuid.Data2),
+        static_cast<unsigned char>(_uuid.Data3 >> 8),
+        static_cast<unsigned char>(_uuid.Data3),
+        _uuid.Data4[0], _uuid.Data4[1], _uuid.Data4[2], _uuid.Data4[3],
+        _uuid.Data4[4], _uuid.Data4[5], _uuid.Data4[6], _uuid.Data4[7]
+    };
+    char hex[32];
+    Hex::expand_16(bytes, hex);
+
+    // position in the text of each hex digit
+    static const unsigned char text_positions[32] = {
+        0, 1, 2, 3, 4, 5, 6, 7,
+        9, 10, 11, 12,
+        14, 15, 16, 17,
+        19, 20, 21, 22,
+        24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35
+    };
+    for (unsigned index = 0; index < 32; ++index) {
+        _buffer[text_positions[index]] = static_cast<CharT>(hex[index]);
+    }
+    _buffer[8] = _buffer[13] = _buffer[18] = _buffer[23] = static_cast<CharT>('-');
+    _buffer[UUID_STRING_LENGTH] = static_cast<CharT>('\0');
+    return UUID_STRING_LENGTH;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+///
+/// parse_uuid
+///
+/// Parses "01234567-89ab-cdef-0123-456789abcdef" or "{01234567-89ab-cdef-0123-456789abcdef}",
+///   in either case, covering both the UuidFromString and CLSIDFromString forms
+///
+/// Returns false, leaving _uuid untouched, if the text is anything else
+/// - every digit is looked up and validated without branching; the result is checked once
+///
+////////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename CharT>
+bool parse_uuid(_In_reads_(_length) const CharT* _text, size_t _length, _Out_ UUID* _uuid) NOEXCEPT
+{
+    if (_length == UUID_STRING_LENGTH + 2) {
+        if (_text[0] != '{' || _text[UUID_STRING_LENGTH + 1] != '}') {
+            return false;
+        }
+        ++_text;
+    } else if (_length != UUID_STRING_LENGTH) {
+        return false;
+    }
+
+    // pairs of text positions making up each byte, in text (big-endian) order
+    static const unsigned char byte_positions[16] = {
+        0, 2, 4, 6,
+        9, 11,
+        14, 16,
+        19, 21,
+        24, 26, 28, 30, 32, 34
+    };
+    unsigned char bytes[16];
+    unsigned invalid = 0;
+    for (unsigned index = 0; index < 16; ++index) {
+        const unsigned high = Hex::digit_value(_text[byte_positions[index]]);
+        const unsigned low = Hex::digit_value(_text[byte_positions[index] + 1]);
+        // INVALID_DIGIT has bits above the low nibble set
+        invalid |= high | low;
+        bytes[index] = static_cast<unsigned char>((high << 4) | (low & 0x0f));
+    }
+    invalid &= ~0x0fu;
+    invalid |=
+        static_cast<unsigned>(_text[8] != '-') |
+        static_cast<unsigned>(_text[13] != '-') |
+        static_cast<unsigned>(_text[18] != '-') |
+        static_cast<unsigned>(_text[23] != '-');
+    if (invalid != 0) {
+        return false;
+    }
+
+    _uuid->Data1 =
+        (static_cast<unsigned long>(bytes[0]) << 24) |
+        (static_cast<unsigned long>(bytes[1]) << 16) |
+        (static_cast<unsigned long>(bytes[2]) << 8) |
+        static_cast<unsigned long>(bytes[3]);
+    _uuid->Data2 = static_cast<unsigned short>((bytes[4] << 8) | bytes[5]);
+    _uuid->Data3 = static_cast<unsigned short>((bytes[6] << 8) | bytes[7]);
+    for (unsigned index = 0; index < 8; ++index) {
+        _uuid->Data4[index] = bytes[8 + index];
+    }
+    return true;
+}
+
+inline
+std::wstring uuid_to_string(_In_ UUID _guid)
+{
+    wchar_t wszUuid[UUID_STRING_LENGTH + 1];
+    format_uuid(_guid, wszUuid, UUID_STRING_LENGTH + 1);
+    return std::wstring(wszUuid, UUID_STRING_LENGTH);
+}
+inline
+UUID string_to_uuid(_In_ LPCWSTR _guid)
+{
+    UUID returned_uuid;
+    if (!parse_uuid(_guid, ::wcslen(_guid), &returned_uuid)) {
+        throw ntl::Exception(RPC_S_INVALID_STRING_UUID, L"ntl::Uuid::parse_uuid", L"ntl::Uuid::string_to_uuid", false);
+    }
+
+    return returned_uuid;
+}
+
+} // namespace Uuid
 } // namespace ntl
\ No newline at end of file